@@ -42,6 +42,41 @@ kernel void im2col(
   }
 }
 
+// batched version of im2col: unrolls numImages images side by side, so
+// each row of data_col is [image][h_out][w_out], ie the columns matrix
+// is (channels * filterSize * filterSize) rows by (numImages * colSize * colSize)
+// cols, and one gemm covers all numImages images
+kernel void im2col_batched(
+    const int n, const int numImages,
+    global float const * im_data, int im_offset,
+    global float* data_col) {
+  const int rowLength = numImages * {{colSize}} * {{colSize}};
+  CL_KERNEL_LOOP(index, n) {
+    int w_out = index % {{colSize}};
+    int remainder = index / {{colSize}};
+    int h_out = remainder % {{colSize}};
+    remainder /= {{colSize}};
+    int channel_in = remainder % {{channels}};
+    int image = remainder / {{channels}};
+    int channel_out = channel_in * {{filterSize}} * {{filterSize}};
+    int h_in = h_out * {{stride}} - {{padding}};
+    int w_in = w_out * {{stride}} - {{padding}};
+    global float *col = data_col + channel_out * rowLength
+      + (image * {{colSize}} + h_out) * {{colSize}} + w_out;
+    global float const *im = im_data + im_offset
+      + ((image * {{channels}} + channel_in) * {{size}} + h_in) * {{size}} + w_in;
+    for (int i = 0; i < {{filterSize}}; ++i) {
+      for (int j = 0; j < {{filterSize}}; ++j) {
+        int h = h_in + i;
+        int w = w_in + j;
+        *col = (h >= 0 && w >= 0 && h < {{size}} && w < {{size}}) ?
+          im[i * {{size}} + j] : 0;
+        col += rowLength;
+      }
+    }
+  }
+}
+
 kernel void col2im(
     const int n,
     global float const *data_col,
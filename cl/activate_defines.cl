@@ -0,0 +1,39 @@
+// Copyright Hugh Perkins 2015 hughperkins at gmail
+//
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file, You can
+// obtain one at http://mozilla.org/MPL/2.0/.
+
+// ACTIVATION_FUNCTION, for kernels that fuse an activation into their output,
+// and ACTIVATION_DERIV, its derivative, written in terms of that output, for
+// kernels that fuse it into reading gradOutput;
+// both left undefined if none of the activation defines is given
+// one of: [ TANH | RELU | LINEAR | SIGMOID | SCALEDTANH | ELU ] (optional)
+
+#ifdef TANH
+    #define ACTIVATION_FUNCTION(output) (tanh(output))
+#elif defined SCALEDTANH
+    #define ACTIVATION_FUNCTION(output) (1.7159f * tanh(0.66667f * output))
+#elif defined SIGMOID
+    #define ACTIVATION_FUNCTION(output) (1.0f / (1 + exp(-output)))
+#elif defined RELU
+    #define ACTIVATION_FUNCTION(output) (output> 0 ? output : 0)
+#elif defined ELU
+    #define ACTIVATION_FUNCTION(output) (output> 0 ? output : exp(output) - 1)
+#elif defined LINEAR
+    #define ACTIVATION_FUNCTION(output) (output)
+#endif
+
+#ifdef TANH
+    #define ACTIVATION_DERIV(output) (1 - output * output)
+#elif defined SCALEDTANH
+    #define ACTIVATION_DERIV(output) (0.66667f * (1.7159f - 1 / 1.7159f * output * output) )
+#elif defined SIGMOID
+    #define ACTIVATION_DERIV(output) (output * (1 - output) )
+#elif defined RELU
+    #define ACTIVATION_DERIV(output) (output > 0 ? 1 : 0)
+#elif defined ELU
+    #define ACTIVATION_DERIV(output) (output > 0 ? 1 : output + 1)
+#elif defined LINEAR
+    #define ACTIVATION_DERIV(output) (1.0f)
+#endif
@@ -7,19 +7,7 @@
 // expected defines:
 // one of: [ TANH | RELU | LINEAR | SIGMOID | SCALEDTANH | ELU]
 
-#ifdef TANH
-    #define ACTIVATION_DERIV(output) (1 - output * output)
-#elif defined SCALEDTANH
-    #define ACTIVATION_DERIV(output) (0.66667f * (1.7159f - 1 / 1.7159f * output * output) )
-#elif defined SIGMOID
-    #define ACTIVATION_DERIV(output) (output * (1 - output) )
-#elif defined RELU
-    #define ACTIVATION_DERIV(output) (output > 0 ? 1 : 0)
-#elif defined ELU
-    #define ACTIVATION_DERIV(output) (output > 0 ? 1 : output + 1)
-#elif defined LINEAR
-    #define ACTIVATION_DERIV(output) (1.0f)
-#endif
+#include "cl/activate_defines.cl"
 
 //#ifdef ACTIVATION_DERIV
 //void kernel applyActivationDeriv( 
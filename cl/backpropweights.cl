@@ -6,12 +6,20 @@
 
 // expected defines:
 // BIASED (or not)
+// one of: [ TANH | RELU | LINEAR | SIGMOID | SCALEDTANH | ELU ] (optional)
+//   for a layer with a fused activation, see backward.cl
+
+#include "cl/activate_defines.cl"
 
 // globalId: [outPlane][inputPlane][filterRow][filterCol]
 // per-thread iteration: [n][outputRow][outputCol]
 void kernel backprop_floats(const float learningRateMultiplier,
         const int batchSize, 
-         global const float *gradOutput, global const float *images, 
+         global const float *gradOutput,
+#ifdef ACTIVATION_DERIV
+         global const float *output,
+#endif
+         global const float *images, 
         global float *gradWeights
         #ifdef BIASED
             , global float *gradBiasWeights
@@ -49,6 +57,9 @@ void kernel backprop_floats(const float learningRateMultiplier,
                               + outRow) * gOutputSize
                               + outCol;
                     float error = gradOutput[resultIndex];
+#ifdef ACTIVATION_DERIV
+                    error *= ACTIVATION_DERIV(output[resultIndex]);
+#endif
                     int upstreamDataIndex = (( n * gInputPlanes 
                                      + upstreamPlane) * gInputSize
                                      + upstreamRow) * gInputSize
@@ -5,7 +5,11 @@
 // obtain one at http://mozilla.org/MPL/2.0/.
 
 // expected defines:
-//  - none
+//  - one of: [ TANH | RELU | LINEAR | SIGMOID | SCALEDTANH | ELU ] (optional)
+//    for a layer with a fused activation: gradOutput is then the gradient of the
+//    post-activation output, and the derivative is applied as we read it
+
+#include "cl/activate_defines.cl"
 
 // globalid as: [n][upstreamPlane][upstreamrow][upstreamcol]
 // inputdata: [n][upstreamPlane][upstreamrow][upstreamcol] 128 * 32 * 19 * 19 * 4 = 6MB
@@ -13,7 +17,11 @@
 // weights: [filterId][inputPlane][filterRow][filterCol] 32 * 32 * 5 * 5 * 4 = 409KB
 void kernel calcGradInput( 
         const int batchSize,
-        global const float *gradOutput, global float *weights, global float *gradInput) {
+        global const float *gradOutput,
+#ifdef ACTIVATION_DERIV
+        global const float *output,
+#endif
+        global float *weights, global float *gradInput) {
     int globalId = get_global_id(0);
 
     const int upstreamImage2dId = globalId / gInputSizeSquared;
@@ -46,6 +54,9 @@ void kernel calcGradInput(
                           + outRow) * gOutputSize
                           + outCol;
                 float thisError = gradOutput[resultIndex];
+#ifdef ACTIVATION_DERIV
+                thisError *= ACTIVATION_DERIV(output[resultIndex]);
+#endif
                 int thisWeightIndex = (( outPlane * gInputPlanes
                                     + upstreamPlane) * gFilterSize
                                     + filterRow) * gFilterSize
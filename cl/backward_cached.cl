@@ -4,6 +4,12 @@
 // v. 2.0. If a copy of the MPL was not distributed with this file, You can 
 // obtain one at http://mozilla.org/MPL/2.0/.
 
+// expected defines:
+//  - one of: [ TANH | RELU | LINEAR | SIGMOID | SCALEDTANH | ELU ] (optional)
+//    for a layer with a fused activation, see backward.cl
+
+#include "cl/activate_defines.cl"
+
 void copyLocal(local float *target, global float const *source, int N) {
     int numLoops = (N + get_local_size(0) - 1) / get_local_size(0);
     for (int loop = 0; loop < numLoops; loop++) {
@@ -14,6 +20,19 @@ void copyLocal(local float *target, global float const *source, int N) {
     }
 }
 
+#ifdef ACTIVATION_DERIV
+// as copyLocal, applying the derivative of the fused activation on the way
+void copyLocalTimesDeriv(local float *target, global float const *source, global float const *output, int N) {
+    int numLoops = (N + get_local_size(0) - 1) / get_local_size(0);
+    for (int loop = 0; loop < numLoops; loop++) {
+        int offset = loop * get_local_size(0) + get_local_id(0);
+        if (offset < N) {
+            target[offset] = source[offset] * ACTIVATION_DERIV(output[offset]);
+        }
+    }
+}
+#endif
+
 // as calcGradInput, but with local cache
 // convolve weights with gradOutput to produce gradInput
 // workgroupid: [n][inputPlane]
@@ -35,6 +54,9 @@ void copyLocal(local float *target, global float const *source, int N) {
 void kernel calcGradInputCached( 
         const int batchSize,
         global const float *gradOutputGlobal,
+#ifdef ACTIVATION_DERIV
+        global const float *outputGlobal,
+#endif
         global const float *filtersGlobal, 
         global float *gradInput,
         local float *_gradOutputPlane, 
@@ -55,7 +77,12 @@ void kernel calcGradInputCached(
     for (int outPlane = 0; outPlane < gNumFilters; outPlane++) {
         barrier(CLK_LOCAL_MEM_FENCE);
         copyLocal(_filterPlane, filtersGlobal + (outPlane * gInputPlanes + upstreamPlane) * gFilterSizeSquared, gFilterSizeSquared);
+#ifdef ACTIVATION_DERIV
+        copyLocalTimesDeriv(_gradOutputPlane, gradOutputGlobal + (n * gNumFilters + outPlane) * gOutputSizeSquared,
+            outputGlobal + (n * gNumFilters + outPlane) * gOutputSizeSquared, gOutputSizeSquared);
+#else
         copyLocal(_gradOutputPlane, gradOutputGlobal + (n * gNumFilters + outPlane) * gOutputSizeSquared, gOutputSizeSquared);
+#endif
         barrier(CLK_LOCAL_MEM_FENCE);
         for (int filterRow = 0; filterRow < gFilterSize; filterRow++) {
             int outRow = upstreamRow + gMargin - filterRow;
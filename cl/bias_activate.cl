@@ -0,0 +1,29 @@
+// Copyright Hugh Perkins 2015 hughperkins at gmail
+//
+// This Source Code Form is subject to the terms of the Mozilla Public License, 
+// v. 2.0. If a copy of the MPL was not distributed with this file, You can 
+// obtain one at http://mozilla.org/MPL/2.0/.
+
+// expected defines:
+// one of: [ TANH | RELU | LINEAR | SIGMOID | SCALEDTANH | ELU ]
+// BIASED (optional)
+
+#include "cl/activate_defines.cl"
+
+// the convolution's epilogue: adds the bias, if BIASED, then applies the
+// activation, in one pass over the output, instead of one pass each
+// same arguments as repeated_add, in per_element_add.cl
+#ifdef ACTIVATION_FUNCTION // protect against not defined
+kernel void bias_activate(const int N, const int numFilters, const int outputSizeSquared, global float *output, global const float *bias) {
+    const int globalId = get_global_id(0);
+    if (globalId >= N) {
+        return;
+    }
+    float value = output[globalId];
+    #ifdef BIASED
+    value += bias[(globalId / outputSizeSquared) % numFilters];
+    #endif
+    output[globalId] = ACTIVATION_FUNCTION(value);
+}
+#endif
+
@@ -28,3 +28,35 @@ kernel void backpropNaive(
     output[globalId] = mask[globalId] == 1 ? gradOutput[globalId] : 0.0f;
 }
 
+// each element gets counter (globalId, 0, 0, 0), and the key is the per-batch seed,
+// so forward and backward regenerate the same mask, without storing it
+#include "cl/philox.cl"
+
+// same as forwardNaive, but makes the mask as it goes: keeps an element if its uniform
+// is above gDropRatio
+kernel void forwardPhilox(
+        const int N,
+        const unsigned int seed0,
+        const unsigned int seed1,
+        global const float *input,
+        global float *output) {
+    const int globalId = get_global_id(0);
+    if (globalId >= N) {
+        return;
+    }
+    output[globalId] = philoxUniform(globalId, seed0, seed1) > gDropRatio ? input[globalId] : 0.0f;
+}
+
+kernel void backpropPhilox(
+        const int N,
+        const unsigned int seed0,
+        const unsigned int seed1,
+        global const float *gradOutput,
+        global float *output) {
+    const int globalId = get_global_id(0);
+    if (globalId >= N) {
+        return;
+    }
+    output[globalId] = philoxUniform(globalId, seed0, seed1) > gDropRatio ? gradOutput[globalId] : 0.0f;
+}
+
@@ -0,0 +1,212 @@
+// Copyright Hugh Perkins 2015 hughperkins at gmail
+//
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file, You can
+// obtain one at http://mozilla.org/MPL/2.0/.
+
+// fft convolution, see FftConvolution.h
+// planes are zero-padded into a gP x gP grid of complex values, [plane][row][col]
+// spectra of real planes only keep columns [0, gH), gH = gP / 2 + 1, and are
+// stored compact, as [plane][row][gH]
+// complex values are float2, .x real, .y imaginary
+
+// expected defines:
+// gP: grid size, a power of 2
+// gH: gP / 2 + 1
+// gInputPlanes, gNumFilters (multiply kernels)
+// BIASED (optional, fft_store)
+// one of: [ TANH | RELU | LINEAR | SIGMOID | SCALEDTANH | ELU ] (optional, fft_store)
+
+#include "cl/activate_defines.cl"
+
+#define gBins (gP * gH)
+
+// a * b, or a * conj(b)
+inline float2 complexMul(float2 a, float2 b) {
+    float2 result;
+    result.x = a.x * b.x - a.y * b.y;
+    result.y = a.x * b.y + a.y * b.x;
+    return result;
+}
+inline float2 complexMulConj(float2 a, float2 b) {
+    float2 result;
+    result.x = a.x * b.x + a.y * b.y;
+    result.y = a.y * b.x - a.x * b.y;
+    return result;
+}
+
+// numPlanes real planes of size x size, from images + imagesOffset, placed
+// at (pad, pad) in the grid, zeros elsewhere
+kernel void fft_load(const int numPlanes, const int size, const int pad,
+        global const float *images, const int imagesOffset, global float2 *grid) {
+    const int globalId = get_global_id(0);
+    if(globalId >= numPlanes * gP * gP) {
+        return;
+    }
+    const int col = globalId % gP - pad;
+    const int row = (globalId / gP) % gP - pad;
+    const int plane = globalId / gP / gP;
+    float2 value;
+    value.x = 0;
+    value.y = 0;
+    if(row >= 0 && row < size && col >= 0 && col < size) {
+        value.x = images[imagesOffset + (plane * size + row) * size + col];
+    }
+    grid[globalId] = value;
+}
+
+// one radix-2 pass of a Stockham fft of length gP, over numTransforms
+// transforms, each writing its own output, so no bit reversal pass is needed
+// p is 1, 2, 4, ..., gP / 2 over the passes; direction is 1 forward, -1 inverse
+// transform t, of transformsPerPlane per plane, starts at
+// offset + (t / transformsPerPlane) * planeStride + (t % transformsPerPlane) * transformStride
+// and its elements are elemStride apart.  Rows and columns of the grid, and
+// columns of compact spectra, are all just different strides
+kernel void fft_pass(const int numTransforms, const int transformsPerPlane, const int p, const float direction,
+        global const float2 *in, const int inOffset, const int inPlaneStride, const int inTransformStride, const int inElemStride,
+        global float2 *out, const int outOffset, const int outPlaneStride, const int outTransformStride, const int outElemStride) {
+    const int globalId = get_global_id(0);
+    const int halfP = gP >> 1;
+    if(globalId >= numTransforms * halfP) {
+        return;
+    }
+    // neighbouring threads should read neighbouring elements
+    int transform;
+    int i;
+    if(inElemStride == 1) {
+        i = globalId % halfP;
+        transform = globalId / halfP;
+    } else {
+        transform = globalId % numTransforms;
+        i = globalId / numTransforms;
+    }
+    const int plane = transform / transformsPerPlane;
+    const int planeTransform = transform % transformsPerPlane;
+    global const float2 *src = in + inOffset + plane * inPlaneStride + planeTransform * inTransformStride;
+    global float2 *dst = out + outOffset + plane * outPlaneStride + planeTransform * outTransformStride;
+
+    const int k = i & (p - 1);
+    float2 a0 = src[i * inElemStride];
+    float2 a1 = src[(i + halfP) * inElemStride];
+    const float angle = -direction * 3.14159265358979f * k / p;
+    float2 twiddle;
+    twiddle.x = cos(angle);
+    twiddle.y = sin(angle);
+    a1 = complexMul(a1, twiddle);
+    const int j = (i << 1) - k;
+    float2 sum;
+    sum.x = a0.x + a1.x;
+    sum.y = a0.y + a1.y;
+    float2 diff;
+    diff.x = a0.x - a1.x;
+    diff.y = a0.y - a1.y;
+    dst[j * outElemStride] = sum;
+    dst[(j + p) * outElemStride] = diff;
+}
+
+// rows of a real plane's spectrum are conjugate symmetric, so fill columns
+// (gP / 2, gP) of each grid row from columns [1, gP / 2)
+kernel void fft_hermitian(const int numRows, global float2 *grid) {
+    const int globalId = get_global_id(0);
+    const int numFill = gP - gH;
+    if(globalId >= numRows * numFill) {
+        return;
+    }
+    const int col = gH + globalId % numFill;
+    const int row = globalId / numFill;
+    float2 value = grid[row * gP + gP - col];
+    value.y = -value.y;
+    grid[row * gP + col] = value;
+}
+
+// output[n][f] = sum over c of input[n][c] * conj(filters[f][c])
+kernel void fft_multiply_forward(const int numImages,
+        global const float2 *inputSpectra, global const float2 *filterSpectra, global float2 *outputSpectra) {
+    const int globalId = get_global_id(0);
+    if(globalId >= numImages * gNumFilters * gBins) {
+        return;
+    }
+    const int bin = globalId % gBins;
+    const int filter = (globalId / gBins) % gNumFilters;
+    const int n = globalId / gBins / gNumFilters;
+    float2 sum;
+    sum.x = 0;
+    sum.y = 0;
+    for(int c = 0; c < gInputPlanes; c++) {
+        float2 product = complexMulConj(inputSpectra[(n * gInputPlanes + c) * gBins + bin],
+            filterSpectra[(filter * gInputPlanes + c) * gBins + bin]);
+        sum.x += product.x;
+        sum.y += product.y;
+    }
+    outputSpectra[globalId] = sum;
+}
+
+// gradInput[n][c] = sum over f of gradOutput[n][f] * filters[f][c]
+kernel void fft_multiply_backward(const int numImages,
+        global const float2 *gradOutputSpectra, global const float2 *filterSpectra, global float2 *gradInputSpectra) {
+    const int globalId = get_global_id(0);
+    if(globalId >= numImages * gInputPlanes * gBins) {
+        return;
+    }
+    const int bin = globalId % gBins;
+    const int c = (globalId / gBins) % gInputPlanes;
+    const int n = globalId / gBins / gInputPlanes;
+    float2 sum;
+    sum.x = 0;
+    sum.y = 0;
+    for(int filter = 0; filter < gNumFilters; filter++) {
+        float2 product = complexMul(gradOutputSpectra[(n * gNumFilters + filter) * gBins + bin],
+            filterSpectra[(filter * gInputPlanes + c) * gBins + bin]);
+        sum.x += product.x;
+        sum.y += product.y;
+    }
+    gradInputSpectra[globalId] = sum;
+}
+
+// gradWeights[f][c] (+)= sum over n of input[n][c] * conj(gradOutput[n][f])
+kernel void fft_multiply_weights(const int numImages, const int accumulate,
+        global const float2 *inputSpectra, global const float2 *gradOutputSpectra, global float2 *gradWeightsSpectra) {
+    const int globalId = get_global_id(0);
+    if(globalId >= gNumFilters * gInputPlanes * gBins) {
+        return;
+    }
+    const int bin = globalId % gBins;
+    const int c = (globalId / gBins) % gInputPlanes;
+    const int filter = globalId / gBins / gInputPlanes;
+    float2 sum;
+    sum.x = 0;
+    sum.y = 0;
+    if(accumulate) {
+        sum = gradWeightsSpectra[globalId];
+    }
+    for(int n = 0; n < numImages; n++) {
+        float2 product = complexMulConj(inputSpectra[(n * gInputPlanes + c) * gBins + bin],
+            gradOutputSpectra[(n * gNumFilters + filter) * gBins + bin]);
+        sum.x += product.x;
+        sum.y += product.y;
+    }
+    gradWeightsSpectra[globalId] = sum;
+}
+
+// real parts of grid[plane][crop + row][crop + col], for row, col in [0, size),
+// scaled by 1 / (gP * gP), for the inverse fft, into output + outputOffset
+// plane is [n][filter] when BIASED
+kernel void fft_store(const int numPlanes, const int size, const int crop,
+        global const float2 *grid, global const float *bias, global float *output, const int outputOffset) {
+    const int globalId = get_global_id(0);
+    if(globalId >= numPlanes * size * size) {
+        return;
+    }
+    const int col = globalId % size;
+    const int row = (globalId / size) % size;
+    const int plane = globalId / size / size;
+    float value = grid[(plane * gP + crop + row) * gP + crop + col].x * (1.0f / (gP * gP));
+    #ifdef BIASED
+    value += bias[plane % gNumFilters];
+    #endif
+    #ifdef ACTIVATION_FUNCTION
+    value = ACTIVATION_FUNCTION(value);
+    #endif
+    output[outputOffset + globalId] = value;
+}
+
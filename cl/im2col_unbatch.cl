@@ -0,0 +1,38 @@
+// Copyright Hugh Perkins 2015 hughperkins at gmail
+//
+// This Source Code Form is subject to the terms of the Mozilla Public License, 
+// v. 2.0. If a copy of the MPL was not distributed with this file, You can 
+// obtain one at http://mozilla.org/MPL/2.0/.
+
+// expected defines:
+// BIASED (optional)
+// one of: [ TANH | RELU | LINEAR | SIGMOID | SCALEDTANH | ELU ] (optional, fuses the activation)
+
+#include "cl/activate_defines.cl"
+
+// the batched im2col gemm gives [filter][n][outputPlane], we want [n][filter][outputPlane]
+// also adds the bias, if BIASED, and applies the activation, if there is one,
+// so we dont need separate passes for those
+// one thread per output element, indexed by destination
+kernel void im2col_unbatch(
+        const int numImages, const int numFilters, const int outputSizeSquared,
+        global const float *gemmOutput,
+        global const float *bias,
+        global float *output, const int outputOffset) {
+    const int globalId = get_global_id(0);
+    if (globalId >= numImages * numFilters * outputSizeSquared) {
+        return;
+    }
+    const int pixel = globalId % outputSizeSquared;
+    const int filter = (globalId / outputSizeSquared) % numFilters;
+    const int n = globalId / outputSizeSquared / numFilters;
+    float value = gemmOutput[(filter * numImages + n) * outputSizeSquared + pixel];
+    #ifdef BIASED
+    value += bias[filter];
+    #endif
+    #ifdef ACTIVATION_FUNCTION
+    value = ACTIVATION_FUNCTION(value);
+    #endif
+    output[outputOffset + globalId] = value;
+}
+
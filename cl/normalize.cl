@@ -0,0 +1,22 @@
+// Copyright Hugh Perkins 2015 hughperkins at gmail
+//
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file, You can
+// obtain one at http://mozilla.org/MPL/2.0/.
+
+// reads the uint8 input batch, as uploaded by InputLayer, and writes the
+// normalized floats, (input + translate) * scale, in one pass
+// one thread per element
+kernel void normalize_bytes(
+        const int N,
+        const float translate,
+        const float scale,
+        global const unsigned char *input,
+        global float *output) {
+    const int globalId = get_global_id(0);
+    if (globalId >= N) {
+        return;
+    }
+    output[globalId] = ((float)input[globalId] + translate) * scale;
+}
+
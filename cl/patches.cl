@@ -0,0 +1,76 @@
+// Copyright Hugh Perkins 2015 hughperkins at gmail
+//
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file, You can
+// obtain one at http://mozilla.org/MPL/2.0/.
+
+// random patches and translations, for data augmentation
+// the offsets for image n come from philox counters 2n and 2n+1, so each thread can
+// work out its own image's offsets, and the host version in patches/ gets the same ones
+//
+// expected defines:
+// gNumPlanes
+// gInputSize
+// gOutputSize (random_patches only)
+// gTranslateSize (random_translations only)
+
+#include "cl/philox.cl"
+
+// one thread per output element
+// when not training, the patch comes from the centre
+#ifdef gOutputSize
+kernel void random_patches(
+        const int N, const int training,
+        const unsigned int seed0, const unsigned int seed1,
+        global const float *input,
+        global float *output) {
+    const int globalId = get_global_id(0);
+    if (globalId >= N) {
+        return;
+    }
+    const int col = globalId % gOutputSize;
+    const int row = (globalId / gOutputSize) % gOutputSize;
+    const int imagePlane = globalId / gOutputSize / gOutputSize;
+    const int n = imagePlane / gNumPlanes;
+    const int margin = gInputSize - gOutputSize;
+    int patchRow = margin / 2;
+    int patchCol = margin / 2;
+    if (training) {
+        patchRow = philoxUniformInt(2 * n, 0, margin, seed0, seed1);
+        patchCol = philoxUniformInt(2 * n + 1, 0, margin, seed0, seed1);
+    }
+    output[globalId] = input[(imagePlane * gInputSize + row + patchRow) * gInputSize + col + patchCol];
+}
+#endif
+
+// one thread per output element; output is same size as input
+// pixels shifted in from outside the image are zero
+// when not training, just copies
+#ifdef gTranslateSize
+kernel void random_translations(
+        const int N, const int training,
+        const unsigned int seed0, const unsigned int seed1,
+        global const float *input,
+        global float *output) {
+    const int globalId = get_global_id(0);
+    if (globalId >= N) {
+        return;
+    }
+    if (!training) {
+        output[globalId] = input[globalId];
+        return;
+    }
+    const int col = globalId % gInputSize;
+    const int row = (globalId / gInputSize) % gInputSize;
+    const int imagePlane = globalId / gInputSize / gInputSize;
+    const int n = imagePlane / gNumPlanes;
+    const int inRow = row - philoxUniformInt(2 * n, - gTranslateSize, gTranslateSize, seed0, seed1);
+    const int inCol = col - philoxUniformInt(2 * n + 1, - gTranslateSize, gTranslateSize, seed0, seed1);
+    float value = 0.0f;
+    if (inRow >= 0 && inRow < gInputSize && inCol >= 0 && inCol < gInputSize) {
+        value = input[(imagePlane * gInputSize + inRow) * gInputSize + inCol];
+    }
+    output[globalId] = value;
+}
+#endif
+
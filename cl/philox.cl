@@ -0,0 +1,36 @@
+// Copyright Hugh Perkins 2015 hughperkins at gmail
+//
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file, You can
+// obtain one at http://mozilla.org/MPL/2.0/.
+
+// philox4x32-10 counter-based generator, see Salmon et al, 'Parallel random numbers: as
+// easy as 1, 2, 3'.  Counter is (index, 0, 0, 0), and the key is the caller's seed, so
+// any thread can recompute any index's number, with no state.
+// must match util/Philox.cpp
+float philoxUniform(const unsigned int index, unsigned int key0, unsigned int key1) {
+    unsigned int c0 = index;
+    unsigned int c1 = 0;
+    unsigned int c2 = 0;
+    unsigned int c3 = 0;
+    for(int round = 0; round < 10; round++) {
+        const unsigned int hi0 = mul_hi(0xD2511F53u, c0);
+        const unsigned int lo0 = 0xD2511F53u * c0;
+        const unsigned int hi1 = mul_hi(0xCD9E8D57u, c2);
+        const unsigned int lo1 = 0xCD9E8D57u * c2;
+        c0 = hi1 ^ c1 ^ key0;
+        c1 = lo1;
+        c2 = hi0 ^ c3 ^ key1;
+        c3 = lo0;
+        key0 += 0x9E3779B9u;
+        key1 += 0xBB67AE85u;
+    }
+    return (c0 >> 8) * (1.0f / 16777216.0f);
+}
+
+// uniform int in [minValue, maxValue], inclusive
+int philoxUniformInt(const unsigned int index, const int minValue, const int maxValue, unsigned int key0, unsigned int key1) {
+    const int range = maxValue - minValue + 1;
+    const int offset = (int)(philoxUniform(index, key0, key1) * range);
+    return minValue + min(offset, range - 1);
+}
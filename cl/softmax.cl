@@ -0,0 +1,127 @@
+// Copyright Hugh Perkins 2015 hughperkins at gmail
+//
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file, You can
+// obtain one at http://mozilla.org/MPL/2.0/.
+
+// softmax, cross-entropy loss and argmax, for SoftMaxLayer
+// each softmax is over one 'group' of gGroupSize values, spaced gInner apart:
+// - per-plane: a group is one plane of one example, so gGroupSize is imageSizeSquared, gInner 1
+// - per-column: a group is all the planes at one pixel of one example, so gGroupSize is
+//   numPlanes, and gInner is imageSizeSquared
+// there is one label per group, in group order, in both cases
+// one thread per group, except for softmax_sum
+
+// expected defines:
+// gGroupSize: number of values in each softmax
+// gInner: distance between consecutive values of one group
+
+int groupBase(const int group) {
+    return (group / gInner) * gGroupSize * gInner + group % gInner;
+}
+
+kernel void softmax_forward(
+        const int numGroups,
+        global const float *input,
+        global float *output) {
+    const int group = get_global_id(0);
+    if(group >= numGroups) {
+        return;
+    }
+    const int base = groupBase(group);
+    float maxValue = input[base];
+    for(int i = 1; i < gGroupSize; i++) {
+        maxValue = max(maxValue, input[base + i * gInner]);
+    }
+    float denominator = 0;
+    for(int i = 0; i < gGroupSize; i++) {
+        denominator += exp(input[base + i * gInner] - maxValue);
+    }
+    for(int i = 0; i < gGroupSize; i++) {
+        output[base + i * gInner] = exp(input[base + i * gInner] - maxValue) / denominator;
+    }
+}
+
+// gradInput is output minus one-hot label; also writes each group's loss, and 1.0f if
+// the argmax matches the label, else 0.0f, for softmax_sum to add up
+kernel void softmax_labels(
+        const int numGroups,
+        global const float *output,
+        global const int *labels,
+        global float *gradInput,
+        global float *groupLoss,
+        global float *groupRight) {
+    const int group = get_global_id(0);
+    if(group >= numGroups) {
+        return;
+    }
+    const int base = groupBase(group);
+    const int label = labels[group];
+    float thisMax = output[base];
+    int iMax = 0;
+    for(int i = 0; i < gGroupSize; i++) {
+        const float value = output[base + i * gInner];
+        gradInput[base + i * gInner] = i == label ? value - 1.0f : value;
+        if(value > thisMax) {
+            thisMax = value;
+            iMax = i;
+        }
+    }
+    groupLoss[group] = - log(output[base + label * gInner]);
+    groupRight[group] = iMax == label ? 1.0f : 0.0f;
+}
+
+kernel void softmax_argmax(
+        const int numGroups,
+        global const float *output,
+        global int *labels) {
+    const int group = get_global_id(0);
+    if(group >= numGroups) {
+        return;
+    }
+    const int base = groupBase(group);
+    float thisMax = output[base];
+    int iMax = 0;
+    for(int i = 1; i < gGroupSize; i++) {
+        const float value = output[base + i * gInner];
+        if(value > thisMax) {
+            thisMax = value;
+            iMax = i;
+        }
+    }
+    labels[group] = iMax;
+}
+
+// results[0] = sum of groupLoss, results[1] = sum of groupRight
+// run as a single workgroup, whose size is a power of two
+kernel void softmax_sum(
+        const int numGroups,
+        global const float *groupLoss,
+        global const float *groupRight,
+        global float *results,
+        local float *lossScratch,
+        local float *rightScratch) {
+    const int localId = get_local_id(0);
+    const int workgroupSize = get_local_size(0);
+    float loss = 0;
+    float right = 0;
+    for(int group = localId; group < numGroups; group += workgroupSize) {
+        loss += groupLoss[group];
+        right += groupRight[group];
+    }
+    lossScratch[localId] = loss;
+    rightScratch[localId] = right;
+    barrier(CLK_LOCAL_MEM_FENCE);
+    for(int offset = workgroupSize >> 1; offset > 0; offset >>= 1) {
+        if(localId < offset) {
+            lossScratch[localId] += lossScratch[localId + offset];
+            rightScratch[localId] += rightScratch[localId + offset];
+        }
+        barrier(CLK_LOCAL_MEM_FENCE);
+    }
+    if(localId == 0) {
+        results[0] = lossScratch[0];
+        results[1] = rightScratch[0];
+    }
+}
+
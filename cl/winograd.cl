@@ -0,0 +1,153 @@
+// Copyright Hugh Perkins 2015 hughperkins at gmail
+//
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file, You can
+// obtain one at http://mozilla.org/MPL/2.0/.
+
+// Winograd F(2x2,3x3), see Winograd.h
+// the 16 transformed filters times transformed inputs are 16 gemms, done with
+// clblas between winograd_input and winograd_output
+
+// expected defines:
+// gInPlanes, gInSize, gOutPlanes, gOutSize, gFilterSize, gMargin
+// gNumSubFilters, gChannels, gTilesPerRow, gTilesPerImage
+// BACKWARD (optional): filters are [gInPlanes][gOutPlanes], and flipped
+// BIASED (optional)
+// one of: [ TANH | RELU | LINEAR | SIGMOID | SCALEDTANH | ELU ] (optional, fuses the activation)
+
+#include "cl/activate_defines.cl"
+
+// G g G^T, for each [outPlane][channel]
+// transformed is [16][gOutPlanes][gChannels]
+kernel void winograd_filters(global const float *filters, global float *transformed) {
+    const int globalId = get_global_id(0);
+    if(globalId >= gOutPlanes * gChannels) {
+        return;
+    }
+    const int channel = globalId % gChannels;
+    const int outPlane = globalId / gChannels;
+    const int inPlane = channel % gInPlanes;
+    const int sub = channel / gInPlanes;
+    const int subRow = sub / gNumSubFilters;
+    const int subCol = sub % gNumSubFilters;
+    float g[3][3];
+    for(int i = 0; i < 3; i++) {
+        for(int j = 0; j < 3; j++) {
+            const int row = subRow * 3 + i;
+            const int col = subCol * 3 + j;
+            float value = 0;
+            if(row < gFilterSize && col < gFilterSize) {
+                #ifdef BACKWARD
+                value = filters[((inPlane * gOutPlanes + outPlane) * gFilterSize + gFilterSize - 1 - row)
+                    * gFilterSize + gFilterSize - 1 - col];
+                #else
+                value = filters[((outPlane * gInPlanes + inPlane) * gFilterSize + row) * gFilterSize + col];
+                #endif
+            }
+            g[i][j] = value;
+        }
+    }
+    float t[4][3];
+    for(int j = 0; j < 3; j++) {
+        t[0][j] = g[0][j];
+        t[1][j] = 0.5f * (g[0][j] + g[1][j] + g[2][j]);
+        t[2][j] = 0.5f * (g[0][j] - g[1][j] + g[2][j]);
+        t[3][j] = g[2][j];
+    }
+    global float *out = transformed + outPlane * gChannels + channel;
+    const int stride = gOutPlanes * gChannels;
+    for(int i = 0; i < 4; i++) {
+        out[(i * 4 + 0) * stride] = t[i][0];
+        out[(i * 4 + 1) * stride] = 0.5f * (t[i][0] + t[i][1] + t[i][2]);
+        out[(i * 4 + 2) * stride] = 0.5f * (t[i][0] - t[i][1] + t[i][2]);
+        out[(i * 4 + 3) * stride] = t[i][2];
+    }
+}
+
+// B^T d B, for each [channel][tile] of numImages images, from input + inputOffset
+// V is [16][gChannels][numImages * gTilesPerImage]
+kernel void winograd_input(const int numImages, global const float *input, const int inputOffset,
+        global float *V) {
+    const int globalId = get_global_id(0);
+    const int numTiles = numImages * gTilesPerImage;
+    if(globalId >= gChannels * numTiles) {
+        return;
+    }
+    const int tile = globalId % numTiles;
+    const int channel = globalId / numTiles;
+    const int n = tile / gTilesPerImage;
+    const int tileRow = (tile % gTilesPerImage) / gTilesPerRow;
+    const int tileCol = tile % gTilesPerRow;
+    const int inPlane = channel % gInPlanes;
+    const int sub = channel / gInPlanes;
+    const int row0 = tileRow * 2 - gMargin + (sub / gNumSubFilters) * 3;
+    const int col0 = tileCol * 2 - gMargin + (sub % gNumSubFilters) * 3;
+    global const float *plane = input + inputOffset + (n * gInPlanes + inPlane) * gInSize * gInSize;
+    float d[4][4];
+    for(int i = 0; i < 4; i++) {
+        const int row = row0 + i;
+        for(int j = 0; j < 4; j++) {
+            const int col = col0 + j;
+            d[i][j] = (row >= 0 && row < gInSize && col >= 0 && col < gInSize) ? plane[row * gInSize + col] : 0;
+        }
+    }
+    float b[4][4];
+    for(int j = 0; j < 4; j++) {
+        b[0][j] = d[0][j] - d[2][j];
+        b[1][j] = d[1][j] + d[2][j];
+        b[2][j] = d[2][j] - d[1][j];
+        b[3][j] = d[1][j] - d[3][j];
+    }
+    global float *out = V + channel * numTiles + tile;
+    const int stride = gChannels * numTiles;
+    for(int i = 0; i < 4; i++) {
+        out[(i * 4 + 0) * stride] = b[i][0] - b[i][2];
+        out[(i * 4 + 1) * stride] = b[i][1] + b[i][2];
+        out[(i * 4 + 2) * stride] = b[i][2] - b[i][1];
+        out[(i * 4 + 3) * stride] = b[i][1] - b[i][3];
+    }
+}
+
+// A^T m A, for each [outPlane][tile], then bias and activation
+// M is [16][gOutPlanes][numImages * gTilesPerImage]
+kernel void winograd_output(const int numImages, global const float *M, global const float *bias,
+        global float *output, const int outputOffset) {
+    const int globalId = get_global_id(0);
+    const int numTiles = numImages * gTilesPerImage;
+    if(globalId >= gOutPlanes * numTiles) {
+        return;
+    }
+    const int tile = globalId % numTiles;
+    const int outPlane = globalId / numTiles;
+    const int n = tile / gTilesPerImage;
+    const int tileRow = (tile % gTilesPerImage) / gTilesPerRow;
+    const int tileCol = tile % gTilesPerRow;
+    float m[16];
+    for(int k = 0; k < 16; k++) {
+        m[k] = M[(k * gOutPlanes + outPlane) * numTiles + tile];
+    }
+    float a[2][4];
+    for(int j = 0; j < 4; j++) {
+        a[0][j] = m[j] + m[4 + j] + m[8 + j];
+        a[1][j] = m[4 + j] - m[8 + j] - m[12 + j];
+    }
+    global float *plane = output + outputOffset + (n * gOutPlanes + outPlane) * gOutSize * gOutSize;
+    for(int i = 0; i < 2; i++) {
+        const int row = tileRow * 2 + i;
+        for(int j = 0; j < 2; j++) {
+            const int col = tileCol * 2 + j;
+            if(row >= gOutSize || col >= gOutSize) {
+                continue;
+            }
+            float value = j == 0 ? a[i][0] + a[i][1] + a[i][2] : a[i][1] - a[i][2] - a[i][3];
+            #ifdef BIASED
+            value += bias[outPlane];
+            #endif
+            #ifdef ACTIVATION_FUNCTION
+            value = ACTIVATION_FUNCTION(value);
+            #endif
+            plane[row * gOutSize + col] = value;
+        }
+    }
+}
+
@@ -35,12 +35,13 @@ def process_includes(line):
     return line
 
 def write_kernel2(kernelVarName, kernel_filename, kernelName, options):
+    # builds through KernelCache, so the including file needs util/KernelCache.h
     # cog.outl('string kernelFilename = "'  + kernel_filename + '";')
     cog.outl('// generated using cog, from ' + kernel_filename + ':')
     cog.outl('const char * ' + kernelVarName + 'Source =  ')
     write_file2(kernel_filename)
     cog.outl('"";')
-    cog.outl(kernelVarName + ' = cl->buildKernelFromString(' + kernelVarName + 'Source, "' + kernelName + '", ' + options + ', "' + kernel_filename + '");')
+    cog.outl(kernelVarName + ' = KernelCache::buildKernelFromString(cl, ' + kernelVarName + 'Source, "' + kernelName + '", ' + options + ', "' + kernel_filename + '");')
 
 def write_kernel3(kernelVarName, kernel_filename, kernelName, options):
     # cog.outl('string kernelFilename = "'  + kernel_filename + '";')
@@ -53,5 +54,5 @@ def write_kernel3(kernelVarName, kernel_filename, kernelName, options):
         line = f.readline()
     cog.outl(')DELIM";')
     f.close()
-    cog.outl(kernelVarName + ' = cl->buildKernelFromString(' + kernelVarName + 'Source, "' + kernelName + '", ' + options + ', "' + kernel_filename + '");')
+    cog.outl(kernelVarName + ' = KernelCache::buildKernelFromString(cl, ' + kernelVarName + 'Source, "' + kernelName + '", ' + options + ', "' + kernel_filename + '");')
 
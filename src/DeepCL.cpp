@@ -1,5 +1,6 @@
 #include "DeepCL.h"
 #include "DevicesInfo.h"
+#include "util/Workspace.h"
 
 #undef STATIC
 #define STATIC
@@ -17,6 +18,7 @@ PUBLIC DeepCL::DeepCL(cl_platform_id platformId, cl_device_id deviceId) :
     EasyCL(platformId, deviceId) {
 }
 PUBLIC DeepCL::~DeepCL() {
+    Workspace::deleteFor(this);
 }
 PUBLIC void DeepCL::deleteMe() {
     delete this;
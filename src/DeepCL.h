@@ -17,11 +17,13 @@
 #include "trainers/Adagrad.h"
 #include "trainers/Rmsprop.h"
 #include "trainers/Adadelta.h"
+#include "trainers/DataParallelTrainer.h"
 
 #include "weights/UniformInitializer.h"
 #include "weights/OriginalInitializer.h"
 
 #include "normalize/NormalizationHelper.h"
+#include "normalize/NormalizationStats.h"
 #include "layer/Layer.h"
 #include "conv/ConvolutionalLayer.h"
 #include "input/InputLayer.h"
@@ -31,9 +33,13 @@
 #include "batch/NetLearner.h"
 #include "batch/NetLearnerOnDemand.h"
 #include "batch/NetLearnerOnDemandv2.h"
+#include "batch/BlockShuffler.h"
 
 #include "weights/WeightsPersister.h"
+#include "weights/WeightsWriter.h"
+#include "weights/WeightsFile.h"
 #include "util/FileHelper.h"
+#include "util/Profiler.h"
 #include "loaders/GenericLoader.h"
 #include "loaders/GenericLoaderv2.h"
 
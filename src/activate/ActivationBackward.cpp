@@ -9,7 +9,6 @@
 
 #include "EasyCL.h"
 #include "util/stringhelper.h"
-#include "util/StatefulTimer.h"
 
 #include "activate/ActivationBackwardCpu.h"
 #include "activate/ActivationBackwardGpuNaive.h"
@@ -53,7 +52,6 @@ VIRTUAL int ActivationBackward::getOutputNumElements(int batchSize) {
 }
 VIRTUAL void ActivationBackward::backward(int batchSize, float *inputs, float *gradOutput, float *gradInput) {
 //    cout << "ActivationBackward::backward(float *)" << endl;
-    StatefulTimer::instance()->timeCheck("ActivationBackward::backward float->wrapper start");
 
     CLWrapper *inputsWrapper = cl->wrap(getInputNumElements(batchSize), inputs);
     CLWrapper *gradOutputWrapper = cl->wrap(getOutputNumElements(batchSize), gradOutput);
@@ -69,7 +67,6 @@ VIRTUAL void ActivationBackward::backward(int batchSize, float *inputs, float *g
     delete inputsWrapper;
     delete gradOutputWrapper;
     delete gradInputWrapper;
-    StatefulTimer::instance()->timeCheck("ActivationBackward::backward float->wrapper end");
 }
 VIRTUAL void ActivationBackward::backward(int batchSize, CLWrapper *inputsWrapper, CLWrapper *gradOutputWrapper, CLWrapper *gradInputWrapper) {
     throw runtime_error("ActivationBackward::backward wrappers not implemented");
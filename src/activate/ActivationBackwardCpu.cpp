@@ -10,7 +10,6 @@
 
 #include "EasyCL.h"
 #include "activate/ActivationBackward.h"
-#include "util/StatefulTimer.h"
 #include "activate/ActivationFunction.h"
 
 #include "activate/ActivationBackwardCpu.h"
@@ -38,7 +37,6 @@ VIRTUAL void ActivationBackwardCpu::backward(int batchSize,
         CLWrapper *outputWrapper,
          CLWrapper *gradOutputWrapper, 
         CLWrapper *gradInputWrapper) {
-    StatefulTimer::instance()->timeCheck("ActivationBackwardCpu::backward start");
 
     outputWrapper->copyToHost();
     gradOutputWrapper->copyToHost();
@@ -62,6 +60,5 @@ VIRTUAL void ActivationBackwardCpu::backward(int batchSize,
 
     delete[] gradInput;
     
-    StatefulTimer::instance()->timeCheck("ActivationBackwardCpu::backward end");
 }
 
@@ -10,11 +10,11 @@
 
 #include "EasyCL.h"
 #include "activate/ActivationBackward.h"
-#include "util/StatefulTimer.h"
 #include "util/stringhelper.h"
 #include "activate/ActivationFunction.h"
 
 #include "activate/ActivationBackwardGpuNaive.h"
+#include "util/KernelCache.h"
 
 using namespace std;
 
@@ -31,7 +31,6 @@ VIRTUAL void ActivationBackwardGpuNaive::backward(int batchSize, CLWrapper *inpu
          CLWrapper *gradOutputWrapper, 
         CLWrapper *gradInputWrapper) {
 
-    StatefulTimer::instance()->timeCheck("ActivationBackwardGpuNaive::backward start");
 
     int globalSize = batchSize * numPlanes * inputSize * inputSize;
     int workgroupSize = 64;
@@ -46,7 +45,6 @@ VIRTUAL void ActivationBackwardGpuNaive::backward(int batchSize, CLWrapper *inpu
     kernel->run_1d(numWorkgroups * workgroupSize, workgroupSize);
     cl->finish();
 
-    StatefulTimer::instance()->timeCheck("ActivationBackwardGpuNaive::backward end");
 }
 ActivationBackwardGpuNaive::ActivationBackwardGpuNaive(EasyCL *cl, int numPlanes, int inputSize, ActivationFunction const*fn) :
         ActivationBackward(cl, numPlanes, inputSize, fn) {
@@ -74,6 +72,33 @@ ActivationBackwardGpuNaive::ActivationBackwardGpuNaive(EasyCL *cl, int numPlanes
     "// expected defines:\n"
     "// one of: [ TANH | RELU | LINEAR | SIGMOID | SCALEDTANH | ELU]\n"
     "\n"
+    "// including cl/activate_defines.cl:\n"
+    "// Copyright Hugh Perkins 2015 hughperkins at gmail\n"
+    "//\n"
+    "// This Source Code Form is subject to the terms of the Mozilla Public License,\n"
+    "// v. 2.0. If a copy of the MPL was not distributed with this file, You can\n"
+    "// obtain one at http://mozilla.org/MPL/2.0/.\n"
+    "\n"
+    "// ACTIVATION_FUNCTION, for kernels that fuse an activation into their output,\n"
+    "// and ACTIVATION_DERIV, its derivative, written in terms of that output, for\n"
+    "// kernels that fuse it into reading gradOutput;\n"
+    "// both left undefined if none of the activation defines is given\n"
+    "// one of: [ TANH | RELU | LINEAR | SIGMOID | SCALEDTANH | ELU ] (optional)\n"
+    "\n"
+    "#ifdef TANH\n"
+    "    #define ACTIVATION_FUNCTION(output) (tanh(output))\n"
+    "#elif defined SCALEDTANH\n"
+    "    #define ACTIVATION_FUNCTION(output) (1.7159f * tanh(0.66667f * output))\n"
+    "#elif defined SIGMOID\n"
+    "    #define ACTIVATION_FUNCTION(output) (1.0f / (1 + exp(-output)))\n"
+    "#elif defined RELU\n"
+    "    #define ACTIVATION_FUNCTION(output) (output> 0 ? output : 0)\n"
+    "#elif defined ELU\n"
+    "    #define ACTIVATION_FUNCTION(output) (output> 0 ? output : exp(output) - 1)\n"
+    "#elif defined LINEAR\n"
+    "    #define ACTIVATION_FUNCTION(output) (output)\n"
+    "#endif\n"
+    "\n"
     "#ifdef TANH\n"
     "    #define ACTIVATION_DERIV(output) (1 - output * output)\n"
     "#elif defined SCALEDTANH\n"
@@ -88,6 +113,7 @@ ActivationBackwardGpuNaive::ActivationBackwardGpuNaive(EasyCL *cl, int numPlanes
     "    #define ACTIVATION_DERIV(output) (1.0f)\n"
     "#endif\n"
     "\n"
+    "\n"
     "//#ifdef ACTIVATION_DERIV\n"
     "//void kernel applyActivationDeriv(\n"
     "//        const int N,\n"
@@ -125,7 +151,7 @@ ActivationBackwardGpuNaive::ActivationBackwardGpuNaive(EasyCL *cl, int numPlanes
     "#endif\n"
     "\n"
     "";
-    kernel = cl->buildKernelFromString(kernelSource, "backward", options, "cl/applyActivationDeriv.cl");
+    kernel = KernelCache::buildKernelFromString(cl, kernelSource, "backward", options, "cl/applyActivationDeriv.cl");
     // [[[end]]]
 }
 
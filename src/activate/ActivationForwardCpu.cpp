@@ -8,7 +8,6 @@
 #include <cstring>
 
 #include "EasyCL.h"
-#include "util/StatefulTimer.h"
 #include "activate/ActivationFunction.h"
 
 #include "activate/ActivationForwardCpu.h"
@@ -43,12 +42,10 @@ VIRTUAL void ActivationForwardCpu::forward(int batchSize, CLWrapper *inputWrappe
 VIRTUAL void ActivationForwardCpu::forward(int batchSize, float *input, float *output) {
 //    float *output = new float[ getOutputNumElements(batchSize) ];
 //    cout << "ActivationForwardCpu::forward(float *)" << endl;
-    StatefulTimer::instance()->timeCheck("ActivationForwardCpu::forward start");
     int totalLinearSize = batchSize * numPlanes * inputSize * inputSize;
     for(int i = 0; i < totalLinearSize; i++) {
         output[i] = fn->calc(input[i]);
     }
-    StatefulTimer::instance()->timeCheck("ActivationForwardCpu::forward end");
 //    return output;
 }
 
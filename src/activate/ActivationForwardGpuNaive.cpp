@@ -9,11 +9,11 @@
 
 #include "EasyCL.h"
 
-#include "util/StatefulTimer.h"
 #include "util/stringhelper.h"
 #include "activate/ActivationFunction.h"
 
 #include "activate/ActivationForwardGpuNaive.h"
+#include "util/KernelCache.h"
 
 //#include "test/PrintBuffer.h"
 
@@ -29,7 +29,6 @@ VIRTUAL ActivationForwardGpuNaive::~ActivationForwardGpuNaive() {
 }
 VIRTUAL void ActivationForwardGpuNaive::forward(int batchSize, CLWrapper *inputWrapper, CLWrapper *outputWrapper) {
 //    cout << StatefulTimer::instance()->prefix << "ActivationForwardGpuNaive::forward(CLWrapper *)" << endl;
-    StatefulTimer::instance()->timeCheck("ActivationForwardGpuNaive::forward start");
 
     kernel->input(batchSize * numPlanes * outputSize * outputSize);
     kernel->output(outputWrapper)->input(inputWrapper);
@@ -45,7 +44,6 @@ VIRTUAL void ActivationForwardGpuNaive::forward(int batchSize, CLWrapper *inputW
 //    cout << "ActivationForwardGpuNaive::forward selectorswrapper:" << endl;
 //    PrintBuffer::printInts(cl, selectorsWrapper, outputSize, outputSize);
 
-    StatefulTimer::instance()->timeCheck("ActivationForwardGpuNaive::forward end");
 }
 ActivationForwardGpuNaive::ActivationForwardGpuNaive(EasyCL *cl, int numPlanes, int inputSize, ActivationFunction const*fn) :
         ActivationForward(cl, numPlanes, inputSize, fn) {
@@ -108,7 +106,7 @@ ActivationForwardGpuNaive::ActivationForwardGpuNaive(EasyCL *cl, int numPlanes,
     "#endif\n"
     "\n"
     "";
-    kernel = cl->buildKernelFromString(kernelSource, "forwardNaive", options, "cl/activate.cl");
+    kernel = KernelCache::buildKernelFromString(cl, kernelSource, "forwardNaive", options, "cl/activate.cl");
     // [[[end]]]
 }
 
@@ -34,7 +34,8 @@ ActivationLayer::ActivationLayer(EasyCL *cl, Layer *previousLayer, ActivationMak
 //        outputCopiedToHost(false),
 //        gradInputCopiedToHost(false),
         batchSize(0),
-        allocatedSize(0) {
+        allocatedSize(0),
+        fused(false) {
     if(inputSize == 0){
 //        maker->net->print();
         throw runtime_error("Error: Activation layer " + toString(layerIndex) + ": input image size is 0");
@@ -49,10 +50,8 @@ ActivationLayer::ActivationLayer(EasyCL *cl, Layer *previousLayer, ActivationMak
 VIRTUAL ActivationLayer::~ActivationLayer() {
     delete activationForwardImpl;
     delete activationBackpropImpl;
-    if(outputWrapper != 0) {
+    if(!sharedOutput) {
         delete outputWrapper;
-    }
-    if(output != 0) {
         delete[] output;
     }
     if(gradInputWrapper != 0) {
@@ -70,7 +69,7 @@ VIRTUAL float ActivationLayer::getOutput(int n, int plane, int row, int col) {
         * numPlanes + plane)
         * outputSize + row)
         * outputSize + col;
-    return output[ index ];
+    return getOutput()[ index ];
 }
 VIRTUAL void ActivationLayer::printOutput() {
 //    float const*output = getOutput();
@@ -107,31 +106,61 @@ VIRTUAL void ActivationLayer::setBatchSize(int batchSize) {
         this->batchSize = batchSize;
         return;
     }
-    if(outputWrapper != 0) {
+    if(!sharedOutput) {
         delete outputWrapper;
-    }
-    if(output != 0) {
         delete[] output;
     }
-    if(gradInputWrapper != 0) {
-        delete gradInputWrapper;
-    }
-    if(gradInput != 0) {
-        delete[] gradInput;
-    }
+    delete gradInputWrapper;
+    delete[] gradInput;
+    gradInputWrapper = 0;
+    gradInput = 0;
     this->batchSize = batchSize;
     this->allocatedSize = batchSize;
-    output = new float[ getOutputNumElements() ];
-    outputWrapper = cl->wrap(getOutputNumElements(), output);
-    outputWrapper->createOnDevice();
-    gradInput = new float[ previousLayer->getOutputNumElements() ];
-    gradInputWrapper = cl->wrap(previousLayer->getOutputNumElements(), gradInput);
-    gradInputWrapper->createOnDevice();
+    // a shared output belongs to the net, and means inference only, so no gradients either
+    // fused, our output is the previous layer's, and our gradInput the next layer's
+    if(!sharedOutput && !fused) {
+        output = new float[ getOutputNumElements() ];
+        outputWrapper = cl->wrap(getOutputNumElements(), output);
+        outputWrapper->createOnDevice();
+        gradInput = new float[ previousLayer->getOutputNumElements() ];
+        gradInputWrapper = cl->wrap(previousLayer->getOutputNumElements(), gradInput);
+        gradInputWrapper->createOnDevice();
+    }
+}
+VIRTUAL bool ActivationLayer::canShareOutput() const {
+    return !fused;
+}
+VIRTUAL void ActivationLayer::setSharedOutput(float *output, CLWrapper *outputWrapper) {
+    adoptSharedOutput(output, outputWrapper, &this->output, &this->outputWrapper, &gradInput, &gradInputWrapper, &allocatedSize);
+}
+VIRTUAL bool ActivationLayer::passesThroughOutput() const {
+    return fused;
+}
+/// \brief the previous layer applies our activation now, in its forward, so we just hand on its output
+///
+/// see NeuralNet::fuseActivations.  It applies the derivative too, in its backward,
+/// so our backward just hands on the gradient we get from the next layer
+VIRTUAL void ActivationLayer::setFused() {
+    if(sharedOutput) {
+        throw runtime_error("ActivationLayer::setFused: output is shared, call NeuralNet::clearInferencePlan first");
+    }
+    delete outputWrapper;
+    delete[] output;
+    delete gradInputWrapper;
+    delete[] gradInput;
+    outputWrapper = 0;
+    output = 0;
+    gradInputWrapper = 0;
+    gradInput = 0;
+    fused = true;
 }
 VIRTUAL int ActivationLayer::getOutputNumElements() {
     return batchSize * numPlanes * outputSize * outputSize;
 }
 VIRTUAL float *ActivationLayer::getOutput() {
+    if(fused) {
+        return previousLayer->getOutput();
+    }
     if(outputWrapper->isDeviceDirty()) {
         outputWrapper->copyToHost();
 //        outputCopiedToHost = true;
@@ -159,15 +188,24 @@ VIRTUAL int ActivationLayer::getOutputPlanes() const {
     return numPlanes;
 }
 VIRTUAL bool ActivationLayer::providesGradInputWrapper() const {
+    if(fused) {
+        return nextLayer->providesGradInputWrapper();
+    }
     return true;
 }
 VIRTUAL CLWrapper *ActivationLayer::getGradInputWrapper() {
+    if(fused) {
+        return nextLayer->getGradInputWrapper();
+    }
     return gradInputWrapper;
 }
 VIRTUAL bool ActivationLayer::hasOutputWrapper() const {
     return true;
 }
 VIRTUAL CLWrapper *ActivationLayer::getOutputWrapper() {
+    if(fused) {
+        return previousLayer->getOutputWrapper();
+    }
     return outputWrapper;
 }
 VIRTUAL int ActivationLayer::getWeightsSize() const {
@@ -177,6 +215,9 @@ VIRTUAL int ActivationLayer::getBiasSize() const {
     return 0;
 }
 VIRTUAL float *ActivationLayer::getGradInput() {
+    if(fused) {
+        return nextLayer->getGradInput();
+    }
     if(gradInputWrapper->isDeviceDirty()) {
         gradInputWrapper->copyToHost();
 //        gradInputCopiedToHost = true;
@@ -187,6 +228,10 @@ VIRTUAL ActivationFunction const *ActivationLayer::getActivationFunction() const
     return fn;
 }
 VIRTUAL void ActivationLayer::forward() {
+    if(fused) {
+        // already applied, by the previous layer
+        return;
+    }
     CLWrapper *inputWrapper = 0;
     if(previousLayer->hasOutputWrapper()) {
         inputWrapper = previousLayer->getOutputWrapper();
@@ -203,6 +248,10 @@ VIRTUAL void ActivationLayer::forward() {
 }
 VIRTUAL void ActivationLayer::backward() {
     // have no weights to backprop to, just need to backprop the errors
+    if(fused) {
+        // the previous layer applies the derivative, see getGradInputWrapper
+        return;
+    }
 
 //    CLWrapper *imagesWrapper = 0;
 //    if(previousLayer->hasOutputWrapper()) {
@@ -222,7 +271,7 @@ VIRTUAL void ActivationLayer::backward() {
         weOwnGradOutputWrapper = true;
     }
 
-    activationBackpropImpl->backward(batchSize, outputWrapper, gradOutputWrapper, gradInputWrapper);
+    activationBackpropImpl->backward(batchSize, getOutputWrapper(), gradOutputWrapper, gradInputWrapper);
 //    gradInputCopiedToHost = false;
 
 //    if(!previousLayer->hasOutputWrapper()) {
@@ -233,7 +282,7 @@ VIRTUAL void ActivationLayer::backward() {
     }
 }
 VIRTUAL std::string ActivationLayer::asString() const {
-    return std::string("ActivationLayer{ ") + fn->getDefineName() + " }";
+    return std::string("ActivationLayer{ ") + fn->getDefineName() + (fused ? " fused" : "") + " }";
 }
 VIRTUAL int ActivationLayer::getPersistSize(int version) const {
     // no weights, so:
@@ -47,6 +47,8 @@ public:
     int batchSize;
     int allocatedSize;
 
+    bool fused; // the previous layer applies our activation, see setFused
+
     // [[[cog
     // import cog_addheaders
     // cog_addheaders.add()
@@ -58,6 +60,10 @@ public:
     VIRTUAL float getOutput(int n, int plane, int row, int col);
     VIRTUAL void printOutput();
     VIRTUAL void setBatchSize(int batchSize);
+    VIRTUAL bool canShareOutput() const;
+    VIRTUAL void setSharedOutput(float *output, CLWrapper *outputWrapper);
+    VIRTUAL bool passesThroughOutput() const;
+    VIRTUAL void setFused();
     VIRTUAL int getOutputNumElements();
     VIRTUAL float *getOutput();
     VIRTUAL bool needsBackProp();
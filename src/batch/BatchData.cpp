@@ -13,6 +13,23 @@ InputData *InputData::instance(Trainable *net, float const*inputs) {
     int inputCubeSize = net->getInputCubeSize();
     return new InputData(inputCubeSize, inputs);
 }
+InputData::InputData(Trainable *net, float const*inputs) {
+    this->inputCubeSize = net->getInputCubeSize();
+    this->inputs = inputs;
+    this->bytes = 0;
+}
+InputData::InputData(Trainable *net, unsigned char const*bytes) {
+    this->inputCubeSize = net->getInputCubeSize();
+    this->inputs = 0;
+    this->bytes = bytes;
+}
+void InputData::forward(Trainable *net) {
+    if(bytes != 0) {
+        net->forward(bytes);
+    } else {
+        net->forward(inputs);
+    }
+}
 
 ExpectedData *ExpectedData::instance(Trainable *net, float const*expectedOutputs) {
     int outputCubeSize = net->getOutputCubeSize();
@@ -51,17 +51,31 @@ public:
         return child;
     }
 };
+// either float inputs, or uint8 bytes, which the net normalizes on the device
 class InputData {
 public:
     int inputCubeSize;
     float const*inputs; // NOT owned by us, dont delete
+    unsigned char const*bytes; // NOT owned by us, dont delete
     InputData(int inputCubeSize, float const*inputs) {
         this->inputCubeSize = inputCubeSize;
         this->inputs = inputs;
+        this->bytes = 0;
     }
+    InputData(int inputCubeSize, unsigned char const*bytes) {
+        this->inputCubeSize = inputCubeSize;
+        this->inputs = 0;
+        this->bytes = bytes;
+    }
+    InputData(Trainable *net, float const*inputs);
+    InputData(Trainable *net, unsigned char const*bytes);
     static InputData *instance(Trainable *net, float const*inputs);
     InputData *slice(int start) {
+        if(bytes != 0) {
+            return new InputData(inputCubeSize, bytes + start * inputCubeSize);
+        }
         InputData *child = new InputData(inputCubeSize, inputs + start * inputCubeSize);
         return child;
     }
+    void forward(Trainable *net);
 };
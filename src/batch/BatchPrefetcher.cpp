@@ -0,0 +1,221 @@
+// Copyright Hugh Perkins 2015 hughperkins at gmail
+//
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file, You can
+// obtain one at http://mozilla.org/MPL/2.0/.
+
+#include <iostream>
+#include <stdexcept>
+
+#include "util/Timer.h"
+
+#include "batch/BatchPrefetcher.h"
+
+using namespace std;
+
+#undef STATIC
+#define STATIC
+#undef VIRTUAL
+#define VIRTUAL
+
+#define SLOT_FREE 0
+#define SLOT_LOADING 1
+#define SLOT_READY 2
+#define SLOT_INUSE 3
+
+PUBLIC BatchPrefetcher::BatchPrefetcher(PrefetchLoadFunction loadFunction, int N, int fileBatchSize, int inputCubeSize, int queueDepth) :
+        BatchPrefetcher(PrefetchEpochLoadFunction([loadFunction](unsigned char *data, int *labels, int epoch, int start, int count) {
+            loadFunction(data, labels, start, count);
+        }), N, fileBatchSize, inputCubeSize, queueDepth) {
+}
+PUBLIC BatchPrefetcher::BatchPrefetcher(PrefetchEpochLoadFunction loadFunction, int N, int fileBatchSize, int inputCubeSize, int queueDepth) :
+        loadFunction(loadFunction),
+        N(N),
+        fileBatchSize(fileBatchSize),
+        inputCubeSize(inputCubeSize),
+        queueDepth(queueDepth < 1 ? 1 : queueDepth),
+        nextToLoad(0),
+        nextEpochToLoad(0),
+        generation(0),
+        inUseSlot(-1),
+        stopping(false),
+        stallMilliseconds(0) {
+    numFileBatches = (N + fileBatchSize - 1) / fileBatchSize;
+    for(int i = 0; i < this->queueDepth; i++) {
+        slotData.push_back(new unsigned char[(long)fileBatchSize * inputCubeSize]);
+        slotLabels.push_back(new int[fileBatchSize]);
+        slotState.push_back(SLOT_FREE);
+        slotFileBatch.push_back(-1);
+        slotEpoch.push_back(-1);
+        slotGeneration.push_back(-1);
+        slotException.push_back(exception_ptr());
+    }
+    if(this->queueDepth > 1 && numFileBatches > 0) {
+        producer = thread(&BatchPrefetcher::producerLoop, this);
+    }
+}
+PUBLIC BatchPrefetcher::~BatchPrefetcher() {
+    {
+        unique_lock<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    changed.notify_all();
+    if(producer.joinable()) {
+        producer.join();
+    }
+    for(int i = 0; i < queueDepth; i++) {
+        delete[] slotData[i];
+        delete[] slotLabels[i];
+    }
+}
+PUBLIC int BatchPrefetcher::getQueueDepth() {
+    return queueDepth;
+}
+PUBLIC int BatchPrefetcher::getFileBatchN(int fileBatch) {
+    if(fileBatch == numFileBatches - 1) {
+        return N - fileBatch * fileBatchSize;
+    }
+    return fileBatchSize;
+}
+/// \brief time acquire spent waiting for data, since the last resetStallMilliseconds
+///
+/// If this is a large fraction of the epoch time, training is I/O bound
+PUBLIC double BatchPrefetcher::getStallMilliseconds() {
+    unique_lock<std::mutex> lock(mutex);
+    return stallMilliseconds;
+}
+PUBLIC void BatchPrefetcher::resetStallMilliseconds() {
+    unique_lock<std::mutex> lock(mutex);
+    stallMilliseconds = 0;
+}
+/// \brief blocks until fileBatch is loaded, and returns its buffers
+///
+/// The buffers stay valid until the next acquire, or release.  If loading
+/// fileBatch threw, the exception is rethrown here
+PUBLIC void BatchPrefetcher::acquire(int fileBatch, unsigned char **p_data, int **p_labels) {
+    acquire(-1, fileBatch, p_data, p_labels);
+}
+/// \brief blocks until fileBatch of epoch is loaded, and returns its buffers
+///
+/// epoch -1 takes fileBatch from whichever epoch is coming next
+PUBLIC void BatchPrefetcher::acquire(int epoch, int fileBatch, unsigned char **p_data, int **p_labels) {
+    release();
+    Timer timer;
+    if(queueDepth == 1) {
+        try {
+            loadFunction(slotData[0], slotLabels[0], epoch == -1 ? 0 : epoch, fileBatch * fileBatchSize, getFileBatchN(fileBatch));
+        } catch(...) {
+            unique_lock<std::mutex> lock(mutex);
+            stallMilliseconds += timer.lap();
+            throw;
+        }
+        unique_lock<std::mutex> lock(mutex);
+        stallMilliseconds += timer.lap();
+        *p_data = slotData[0];
+        *p_labels = slotLabels[0];
+        return;
+    }
+    unique_lock<std::mutex> lock(mutex);
+    int slot = findSlot(epoch, fileBatch);
+    if(slot == -1) {
+        // not coming, eg we jumped; drop the rest, and start loading from here
+        generation++;
+        for(int i = 0; i < queueDepth; i++) {
+            if(slotState[i] == SLOT_READY) {
+                slotState[i] = SLOT_FREE;
+            }
+        }
+        nextToLoad = fileBatch;
+        if(epoch != -1) {
+            nextEpochToLoad = epoch;
+        }
+        changed.notify_all();
+    }
+    while((slot = findSlot(epoch, fileBatch)) == -1 || slotState[slot] != SLOT_READY) {
+        changed.wait(lock);
+    }
+    stallMilliseconds += timer.lap();
+    if(slotException[slot]) {
+        exception_ptr exception = slotException[slot];
+        slotException[slot] = exception_ptr();
+        slotState[slot] = SLOT_FREE;
+        changed.notify_all();
+        rethrow_exception(exception);
+    }
+    slotState[slot] = SLOT_INUSE;
+    inUseSlot = slot;
+    *p_data = slotData[slot];
+    *p_labels = slotLabels[slot];
+}
+/// \brief hands the buffers from the last acquire back, so they can be refilled
+PUBLIC void BatchPrefetcher::release() {
+    unique_lock<std::mutex> lock(mutex);
+    if(inUseSlot != -1) {
+        slotState[inUseSlot] = SLOT_FREE;
+        inUseSlot = -1;
+        changed.notify_all();
+    }
+}
+// slot holding, or about to hold, fileBatch, of epoch, unless that is -1, or -1.  Caller holds mutex
+PRIVATE int BatchPrefetcher::findSlot(int epoch, int fileBatch) {
+    for(int i = 0; i < queueDepth; i++) {
+        if(slotFileBatch[i] == fileBatch && (epoch == -1 || slotEpoch[i] == epoch) && slotGeneration[i] == generation
+                && (slotState[i] == SLOT_LOADING || slotState[i] == SLOT_READY)) {
+            return i;
+        }
+    }
+    return -1;
+}
+PRIVATE void BatchPrefetcher::producerLoop() {
+    while(true) {
+        int slot = -1;
+        int fileBatch = 0;
+        int epoch = 0;
+        long thisGeneration = 0;
+        {
+            unique_lock<std::mutex> lock(mutex);
+            while(!stopping) {
+                for(int i = 0; i < queueDepth && slot == -1; i++) {
+                    if(slotState[i] == SLOT_FREE) {
+                        slot = i;
+                    }
+                }
+                if(slot != -1) {
+                    break;
+                }
+                changed.wait(lock);
+            }
+            if(stopping) {
+                return;
+            }
+            fileBatch = nextToLoad;
+            epoch = nextEpochToLoad;
+            thisGeneration = generation;
+            nextToLoad = (nextToLoad + 1) % numFileBatches;
+            if(nextToLoad == 0) {
+                nextEpochToLoad++;
+            }
+            slotState[slot] = SLOT_LOADING;
+            slotFileBatch[slot] = fileBatch;
+            slotEpoch[slot] = epoch;
+            slotGeneration[slot] = thisGeneration;
+            slotException[slot] = exception_ptr();
+        }
+        exception_ptr exception;
+        try {
+            loadFunction(slotData[slot], slotLabels[slot], epoch, fileBatch * fileBatchSize, getFileBatchN(fileBatch));
+        } catch(...) {
+            exception = current_exception();
+        }
+        {
+            unique_lock<std::mutex> lock(mutex);
+            if(thisGeneration != generation) {
+                slotState[slot] = SLOT_FREE;
+            } else {
+                slotState[slot] = SLOT_READY;
+                slotException[slot] = exception;
+            }
+        }
+        changed.notify_all();
+    }
+}
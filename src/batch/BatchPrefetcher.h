@@ -0,0 +1,97 @@
+// Copyright Hugh Perkins 2015 hughperkins at gmail
+//
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file, You can
+// obtain one at http://mozilla.org/MPL/2.0/.
+
+#pragma once
+
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <exception>
+
+#include "DeepCLDllExport.h"
+
+#define VIRTUAL virtual
+#define STATIC static
+
+// loads count examples, starting at example start, into data and labels
+// data stays uint8, as the loaders give it, and is normalized on the device; for
+// float packed files it holds floats, and inputCubeSize is passed in bytes
+typedef std::function<void(unsigned char *data, int *labels, int start, int count)> PrefetchLoadFunction;
+// the same, for loads whose contents depend on the epoch too, eg shuffled ones
+typedef std::function<void(unsigned char *data, int *labels, int epoch, int start, int count)> PrefetchEpochLoadFunction;
+
+/// \brief Loads file batches on a background thread, ahead of when they are needed
+///
+/// Used by OnDemandBatcher and OnDemandBatcherv2, so the next file batch is read
+/// and decoded while the current one is being trained on.  Holds queueDepth
+/// buffers of one file batch each, including the one the caller is using, so
+/// queueDepth 2 is double-buffering, 3 triple-buffering, and memory is bounded
+/// by queueDepth * fileBatchSize examples.  queueDepth 1 loads synchronously,
+/// in acquire, like before.
+/// File batches are loaded in order, wrapping around at the end of the epoch.
+/// Asking for a file batch other than the next one (eg after setBatchState)
+/// throws away whatever was prefetched, and restarts from there.
+/// With a PrefetchEpochLoadFunction, the epoch is counted too, going up by one
+/// at each wrap, so the next epoch can be prefetched before this one ends;
+/// acquire with an epoch then matches on both.
+class DeepCL_EXPORT BatchPrefetcher {
+    private:
+    #ifdef _WIN32
+    #pragma warning(disable: 4251)
+    #endif
+    PrefetchEpochLoadFunction loadFunction;
+    std::vector<unsigned char *> slotData;
+    std::vector<int *> slotLabels;
+    std::vector<int> slotState;
+    std::vector<int> slotFileBatch;
+    std::vector<int> slotEpoch;
+    std::vector<long> slotGeneration;
+    std::vector<std::exception_ptr> slotException;
+    std::thread producer;
+    std::mutex mutex;
+    std::condition_variable changed;
+    #ifdef _WIN32
+    #pragma warning(default: 4251)
+    #endif
+    const int N;
+    const int fileBatchSize;
+    const int inputCubeSize;
+    const int queueDepth;
+    int numFileBatches;
+    int nextToLoad;
+    int nextEpochToLoad;
+    long generation;
+    int inUseSlot;
+    bool stopping;
+    double stallMilliseconds;
+
+    // [[[cog
+    // import cog_addheaders
+    // cog_addheaders.addv2()
+    // ]]]
+    // generated, using cog:
+
+    public:
+    BatchPrefetcher(PrefetchLoadFunction loadFunction, int N, int fileBatchSize, int inputCubeSize, int queueDepth);
+    BatchPrefetcher(PrefetchEpochLoadFunction loadFunction, int N, int fileBatchSize, int inputCubeSize, int queueDepth);
+    ~BatchPrefetcher();
+    int getQueueDepth();
+    int getFileBatchN(int fileBatch);
+    double getStallMilliseconds();
+    void resetStallMilliseconds();
+    void acquire(int fileBatch, unsigned char **p_data, int **p_labels);
+    void acquire(int epoch, int fileBatch, unsigned char **p_data, int **p_labels);
+    void release();
+
+    private:
+    int findSlot(int epoch, int fileBatch);
+    void producerLoop();
+
+    // [[[end]]]
+};
+
@@ -27,6 +27,21 @@ PUBLICAPI Batcher::Batcher(Trainable *net, int batchSize, int N, float *data, in
         batchSize(batchSize),
         N(N),
         data(data),
+        byteData(0),
+        labels(labels)
+            {
+    inputCubeSize = net->getInputCubeSize();
+    numBatches = (N + batchSize - 1) / batchSize;
+    reset();
+}
+/// \brief constructor, for uint8 data; the net should have a NormalizationLayer after
+/// the input layer, which normalizes the bytes on the device
+PUBLICAPI Batcher::Batcher(Trainable *net, int batchSize, int N, unsigned char *data, int const*labels) :
+        net(net),
+        batchSize(batchSize),
+        N(N),
+        data(0),
+        byteData(data),
         labels(labels)
             {
     inputCubeSize = net->getInputCubeSize();
@@ -71,6 +86,19 @@ VIRTUAL void Batcher::setBatchState(int nextBatch, int numRight, float loss) {
     this->numRight = numRight;
     this->loss = loss;
 }
+/// \brief point at a different set of already-loaded data, eg the next chunk
+///
+/// N is unchanged; use setN if the size changed too
+VIRTUAL void Batcher::setData(float const*data, int const*labels) {
+    this->data = data;
+    this->byteData = 0;
+    this->labels = labels;
+}
+VIRTUAL void Batcher::setData(unsigned char const*data, int const*labels) {
+    this->data = 0;
+    this->byteData = data;
+    this->labels = labels;
+}
 VIRTUAL void Batcher::setN(int N) {
     this->N = N;
     this->numBatches = (N + batchSize - 1) / batchSize;
@@ -98,13 +126,16 @@ PUBLICAPI bool Batcher::tick(int epoch) {
 //            " batchStart=" << batchStart << " data=" << (void *)data << " labels=" << labels << 
 //            std::endl;
     net->setBatchSize(thisBatchSize);
-    internalTick(epoch, &(data[ batchStart * inputCubeSize ]), &(labels[batchStart]));
-//        netAction->run(net, &(data[ batchStart * inputCubeSize ]), &(labels[batchStart]));
-    float thisLoss = net->calcLossFromLabels(&(labels[batchStart]));
-    int thisNumRight = net->calcNumRight(&(labels[batchStart]));
-//        std::cout << "thisloss " << thisLoss << " thisnumright " << thisNumRight << std::endl; 
-    loss += thisLoss;
-    numRight += thisNumRight;
+    // the loss and numRight come back from the batch itself, rather than from
+    // net afterwards: with DataParallelTrainer, net only ran its own shard
+    BatchResult result;
+    if(byteData != 0) {
+        result = internalTick(epoch, &(byteData[ (long)batchStart * inputCubeSize ]), &(labels[batchStart]));
+    } else {
+        result = internalTick(epoch, &(data[ (long)batchStart * inputCubeSize ]), &(labels[batchStart]));
+    }
+    loss += result.loss;
+    numRight += result.numRight;
     nextBatch++;
     if(nextBatch == numBatches) {
         epochDone = true;
@@ -116,7 +147,7 @@ PUBLICAPI bool Batcher::tick(int epoch) {
 /// could be one batch of learning, or one batch of forward propagation
 /// (for test/prediction), for example
 PUBLICAPI EpochResult Batcher::run(int epoch) {
-    if(data == 0) {
+    if(data == 0 && byteData == 0) {
         throw runtime_error("Batcher: no data set");
     }
     if(labels == 0) {
@@ -131,29 +162,52 @@ PUBLICAPI EpochResult Batcher::run(int epoch) {
     EpochResult epochResult(loss, numRight);
     return epochResult;
 }
+VIRTUAL BatchResult Batcher::internalTick(int epoch, unsigned char const*batchData, int const*batchLabels) {
+    throw runtime_error("Batcher: uint8 data not implemented for this batcher");
+}
 LearnBatcher::LearnBatcher(Trainer *trainer, Trainable *net,
         int batchSize, int N, float *data, int const*labels) :
     Batcher(net, batchSize, N, data, labels),
     trainer(trainer) {
 }
-VIRTUAL void LearnBatcher::internalTick(int epoch, float const*batchData, int const*batchLabels) {
+VIRTUAL BatchResult LearnBatcher::internalTick(int epoch, float const*batchData, int const*batchLabels) {
 //    cout << "LearnBatcher learningRate=" << learningRate << " batchdata=" << (void *)batchData << 
 //        " batchLabels=" << batchLabels << endl;
     TrainingContext context(epoch, nextBatch);
-    trainer->trainFromLabels(net, &context, batchData, batchLabels);
+    return trainer->trainFromLabels(net, &context, batchData, batchLabels);
+}
+LearnBatcher::LearnBatcher(Trainer *trainer, Trainable *net,
+        int batchSize, int N, unsigned char *data, int const*labels) :
+    Batcher(net, batchSize, N, data, labels),
+    trainer(trainer) {
+}
+VIRTUAL BatchResult LearnBatcher::internalTick(int epoch, unsigned char const*batchData, int const*batchLabels) {
+    TrainingContext context(epoch, nextBatch);
+    return trainer->trainFromLabels(net, &context, batchData, batchLabels);
 }
 
 NetActionBatcher::NetActionBatcher(Trainable *net, int batchSize, int N, float *data, int const*labels, NetAction *netAction) :
     Batcher(net, batchSize, N, data, labels),
     netAction(netAction) {
 }
-void NetActionBatcher::internalTick(int epoch, float const*batchData, int const*batchLabels) {
-    netAction->run(this->net, epoch, nextBatch, batchData, batchLabels);
+BatchResult NetActionBatcher::internalTick(int epoch, float const*batchData, int const*batchLabels) {
+    return netAction->run(this->net, epoch, nextBatch, batchData, batchLabels);
+}
+BatchResult NetActionBatcher::internalTick(int epoch, unsigned char const*batchData, int const*batchLabels) {
+    return netAction->run(this->net, epoch, nextBatch, batchData, batchLabels);
 }
 ForwardBatcher::ForwardBatcher(Trainable *net, int batchSize, int N, float *data, int const*labels) :
     Batcher(net, batchSize, N, data, labels) {
 }
-void ForwardBatcher::internalTick(int epoch, float const*batchData, int const*batchLabels) {
+BatchResult ForwardBatcher::internalTick(int epoch, float const*batchData, int const*batchLabels) {
+    this->net->forward(batchData);
+    return BatchResult(net->calcLossFromLabels(batchLabels), net->calcNumRight(batchLabels));
+}
+ForwardBatcher::ForwardBatcher(Trainable *net, int batchSize, int N, unsigned char *data, int const*labels) :
+    Batcher(net, batchSize, N, data, labels) {
+}
+BatchResult ForwardBatcher::internalTick(int epoch, unsigned char const*batchData, int const*batchLabels) {
     this->net->forward(batchData);
+    return BatchResult(net->calcLossFromLabels(batchLabels), net->calcNumRight(batchLabels));
 }
 
@@ -11,6 +11,7 @@
 #include "DeepCLDllExport.h"
 
 class EpochResult;
+class BatchResult;
 class NetAction;
 class Trainer;
 #include "trainers/TrainingContext.h"
@@ -33,6 +34,7 @@ protected:
     int batchSize;
     int N;
     float const* data;
+    unsigned char const* byteData; // if set, data is 0, and we feed the net uint8
     int const* labels;
 
     int numBatches;
@@ -44,7 +46,8 @@ protected:
     float loss;
 
 public:
-    virtual void internalTick(int epoch, float const*batchData, int const*batchLabels) = 0;
+    // runs the batch, and returns its loss and numRight
+    virtual BatchResult internalTick(int epoch, float const*batchData, int const*batchLabels) = 0;
 
     // [[[cog
     // import cog_addheaders
@@ -52,6 +55,7 @@ public:
     // ]]]
     // generated, using cog:
     PUBLICAPI Batcher(Trainable *net, int batchSize, int N, float *data, int const*labels);
+    PUBLICAPI Batcher(Trainable *net, int batchSize, int N, unsigned char *data, int const*labels);
     VIRTUAL ~Batcher();
     PUBLICAPI void reset();
     PUBLICAPI int getNextBatch();
@@ -60,9 +64,12 @@ public:
     PUBLICAPI VIRTUAL int getN();
     PUBLICAPI VIRTUAL bool getEpochDone();
     VIRTUAL void setBatchState(int nextBatch, int numRight, float loss);
+    VIRTUAL void setData(float const*data, int const*labels);
+    VIRTUAL void setData(unsigned char const*data, int const*labels);
     VIRTUAL void setN(int N);
     PUBLICAPI bool tick(int epoch);
     PUBLICAPI EpochResult run(int epoch);
+    VIRTUAL BatchResult internalTick(int epoch, unsigned char const*batchData, int const*batchLabels);
 
     // [[[end]]]
 };
@@ -74,7 +81,10 @@ public:
 
     LearnBatcher(Trainer *trainer, 
         Trainable *net, int batchSize, int N, float *data, int const*labels);
-    virtual void internalTick(int epoch, float const*batchData, int const*batchLabels);
+    LearnBatcher(Trainer *trainer, 
+        Trainable *net, int batchSize, int N, unsigned char *data, int const*labels);
+    virtual BatchResult internalTick(int epoch, float const*batchData, int const*batchLabels);
+    virtual BatchResult internalTick(int epoch, unsigned char const*batchData, int const*batchLabels);
 };
 
 //class DeepCL_EXPORT LearnFromExpectedBatcher : public Batcher {
@@ -91,14 +101,17 @@ class DeepCL_EXPORT NetActionBatcher : public Batcher {
 public:
     NetAction * netAction;
     NetActionBatcher(Trainable *net, int batchSize, int N, float *data, int const*labels, NetAction * netAction);
-    virtual void internalTick(int epoch, float const*batchData, int const*batchLabels);
+    virtual BatchResult internalTick(int epoch, float const*batchData, int const*batchLabels);
+    virtual BatchResult internalTick(int epoch, unsigned char const*batchData, int const*batchLabels);
 };
 
 
 class DeepCL_EXPORT ForwardBatcher : public Batcher {
 public:
     ForwardBatcher(Trainable *net, int batchSize, int N, float *data, int const*labels);
-    virtual void internalTick(int epoch, float const*batchData, int const*batchLabels);
+    ForwardBatcher(Trainable *net, int batchSize, int N, unsigned char *data, int const*labels);
+    virtual BatchResult internalTick(int epoch, float const*batchData, int const*batchLabels);
+    virtual BatchResult internalTick(int epoch, unsigned char const*batchData, int const*batchLabels);
 };
 
 
@@ -0,0 +1,125 @@
+// Copyright Hugh Perkins 2015 hughperkins at gmail
+//
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file, You can
+// obtain one at http://mozilla.org/MPL/2.0/.
+
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+
+#include "util/Philox.h"
+#include "util/stringhelper.h"
+
+#include "batch/BlockShuffler.h"
+
+using namespace std;
+
+#undef STATIC
+#define STATIC
+#undef VIRTUAL
+#define VIRTUAL
+
+// index in [0, i], for step i of the fisher-yates shuffle of stream, which is 0
+// for the block order, and pool + 1 for the examples in a pool
+static int getSwapIndex(unsigned int seed, int epoch, unsigned int stream, int i) {
+    unsigned int counter[4] = { (unsigned int)i, stream, 0, 0 };
+    unsigned int key[2] = { seed, (unsigned int)epoch };
+    unsigned int result[4];
+    Philox::philox4x32_10(counter, key, result);
+    return (int)(((unsigned long long)result[0] * (unsigned int)(i + 1)) >> 32);
+}
+
+PUBLIC BlockShuffler::BlockShuffler(int N, int blockSize, int blocksPerPool, unsigned int seed) :
+        N(N),
+        blockSize(blockSize),
+        blocksPerPool(blocksPerPool),
+        seed(seed) {
+    if(blockSize < 1 || blocksPerPool < 1) {
+        throw runtime_error("BlockShuffler: blockSize and blocksPerPool must be at least 1, got " +
+            toString(blockSize) + " and " + toString(blocksPerPool));
+    }
+    numBlocks = (N + blockSize - 1) / blockSize;
+    numPools = (numBlocks + blocksPerPool - 1) / blocksPerPool;
+}
+PUBLIC int BlockShuffler::getNumBlocks() {
+    return numBlocks;
+}
+PUBLIC int BlockShuffler::getNumPools() {
+    return numPools;
+}
+/// \brief most examples a pool can hold, ie the buffer size it needs
+PUBLIC int BlockShuffler::getPoolCapacity() {
+    return blockSize * blocksPerPool;
+}
+PUBLIC int BlockShuffler::getBlockStart(int block) {
+    return block * blockSize;
+}
+/// \brief blockSize, except for the last block, which has whatever is left over
+PUBLIC int BlockShuffler::getBlockN(int block) {
+    return std::min(blockSize, N - block * blockSize);
+}
+PUBLIC void BlockShuffler::getBlockOrder(int epoch, std::vector<int> *p_order) {
+    p_order->resize(numBlocks);
+    for(int block = 0; block < numBlocks; block++) {
+        (*p_order)[block] = block;
+    }
+    permute(0, epoch, p_order);
+}
+/// \brief the blocks making up pool, in the order they are read
+///
+/// Sorted, so the reads for one pool go forwards through the file
+PUBLIC void BlockShuffler::getPoolBlocks(int epoch, int pool, std::vector<int> *p_blocks) {
+    vector<int> order;
+    getBlockOrder(epoch, &order);
+    int begin = pool * blocksPerPool;
+    int end = std::min(begin + blocksPerPool, numBlocks);
+    p_blocks->assign(order.begin() + begin, order.begin() + end);
+    sort(p_blocks->begin(), p_blocks->end());
+}
+PUBLIC int BlockShuffler::getPoolN(int epoch, int pool) {
+    vector<int> blocks;
+    getPoolBlocks(epoch, pool, &blocks);
+    int poolN = 0;
+    for(int i = 0; i < (int)blocks.size(); i++) {
+        poolN += getBlockN(blocks[i]);
+    }
+    return poolN;
+}
+/// \brief which example ends up at each position of pool, after shufflePool
+PUBLIC void BlockShuffler::getPoolExamples(int epoch, int pool, std::vector<int> *p_examples) {
+    vector<int> blocks;
+    getPoolBlocks(epoch, pool, &blocks);
+    p_examples->clear();
+    for(int i = 0; i < (int)blocks.size(); i++) {
+        int start = getBlockStart(blocks[i]);
+        for(int n = 0; n < getBlockN(blocks[i]); n++) {
+            p_examples->push_back(start + n);
+        }
+    }
+    permute(pool + 1, epoch, p_examples);
+}
+/// \brief shuffles the poolN examples of pool in place, once its blocks are loaded, in getPoolBlocks order
+PUBLIC void BlockShuffler::shufflePool(int epoch, int pool, unsigned char *data, int *labels, int poolN, int cubeSize) {
+    vector<unsigned char> temp(cubeSize);
+    for(int i = poolN - 1; i > 0; i--) {
+        int j = getSwapIndex(seed, epoch, pool + 1, i);
+        if(j == i) {
+            continue;
+        }
+        unsigned char *a = data + (long)i * cubeSize;
+        unsigned char *b = data + (long)j * cubeSize;
+        memcpy(&temp[0], a, cubeSize);
+        memcpy(a, b, cubeSize);
+        memcpy(b, &temp[0], cubeSize);
+        std::swap(labels[i], labels[j]);
+    }
+}
+// fisher-yates, the same swaps as shufflePool makes for the same stream
+PRIVATE void BlockShuffler::permute(unsigned int stream, int epoch, std::vector<int> *p_values) {
+    vector<int> &values = *p_values;
+    for(int i = (int)values.size() - 1; i > 0; i--) {
+        std::swap(values[i], values[getSwapIndex(seed, epoch, stream, i)]);
+    }
+}
+
@@ -0,0 +1,62 @@
+// Copyright Hugh Perkins 2015 hughperkins at gmail
+//
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file, You can
+// obtain one at http://mozilla.org/MPL/2.0/.
+
+#pragma once
+
+#include <vector>
+
+#include "DeepCLDllExport.h"
+
+#define VIRTUAL virtual
+#define STATIC static
+
+/// \brief which examples go in each file batch of a shuffled epoch, for OnDemandBatcherv2
+///
+/// The N examples are cut into blocks of blockSize consecutive examples, so
+/// each read from the file stays large and sequential.  Each epoch, the blocks
+/// are put in a random order, and taken, in that order, blocksPerPool at a time,
+/// to make a pool, ie one file batch, which is then shuffled in memory.  So
+/// memory stays bounded by the prefetcher's buffers, and an example can end up
+/// next to any other example in the file.
+///
+/// Everything is a function of seed, epoch and pool, using Philox, with no
+/// state carried along, so a run resumed part way through an epoch, with
+/// setBatchState, gets the same pools, in the same order, as one that wasnt
+/// stopped
+class DeepCL_EXPORT BlockShuffler {
+    private:
+    const int N;
+    const int blockSize;
+    const int blocksPerPool;
+    const unsigned int seed;
+    int numBlocks;
+    int numPools;
+
+    // [[[cog
+    // import cog_addheaders
+    // cog_addheaders.addv2()
+    // ]]]
+    // generated, using cog:
+
+    public:
+    BlockShuffler(int N, int blockSize, int blocksPerPool, unsigned int seed);
+    int getNumBlocks();
+    int getNumPools();
+    int getPoolCapacity();
+    int getBlockStart(int block);
+    int getBlockN(int block);
+    void getBlockOrder(int epoch, std::vector<int> *p_order);
+    void getPoolBlocks(int epoch, int pool, std::vector<int> *p_blocks);
+    int getPoolN(int epoch, int pool);
+    void getPoolExamples(int epoch, int pool, std::vector<int> *p_examples);
+    void shufflePool(int epoch, int pool, unsigned char *data, int *labels, int poolN, int cubeSize);
+
+    private:
+    void permute(unsigned int stream, int epoch, std::vector<int> *p_values);
+
+    // [[[end]]]
+};
+
@@ -0,0 +1,170 @@
+// Copyright Hugh Perkins 2015 hughperkins at gmail
+//
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file, You can
+// obtain one at http://mozilla.org/MPL/2.0/.
+
+#include <stdexcept>
+#include <sstream>
+#include <cstring>
+#include <chrono>
+
+#include "batch/InferenceQueue.h"
+
+using namespace std;
+
+#undef STATIC
+#define STATIC
+#undef VIRTUAL
+#define VIRTUAL
+
+class InferenceRequest {
+public:
+    float const*input;
+    float *output;
+    double submittedSeconds;
+    bool done;
+    string error;
+};
+
+PUBLIC InferenceQueue::InferenceQueue(int inputCubeSize, int outputCubeSize, int maxBatchSize, float maxLatencyMilliseconds) :
+        inputCubeSize(inputCubeSize),
+        outputCubeSize(outputCubeSize),
+        maxBatchSize(maxBatchSize < 1 ? 1 : maxBatchSize),
+        maxLatencyMilliseconds(maxLatencyMilliseconds < 0 ? 0 : maxLatencyMilliseconds),
+        stopping(false),
+        numBatches(0),
+        latencyStats(100000) {
+    batchInputs = new float[(long)this->maxBatchSize * inputCubeSize];
+    batchOutputs = new float[(long)this->maxBatchSize * outputCubeSize];
+}
+PUBLIC InferenceQueue::~InferenceQueue() {
+    stop();
+    delete[] batchInputs;
+    delete[] batchOutputs;
+}
+PUBLIC int InferenceQueue::getInputCubeSize() {
+    return inputCubeSize;
+}
+PUBLIC int InferenceQueue::getOutputCubeSize() {
+    return outputCubeSize;
+}
+PUBLIC int InferenceQueue::getMaxBatchSize() {
+    return maxBatchSize;
+}
+// runs one example, blocking until its batch has been run.  input is inputCubeSize
+// floats, output receives outputCubeSize floats.  Thread-safe.  Throws if the batch
+// function threw, or once the queue is stopped
+PUBLIC void InferenceQueue::submit(float const*input, float *output) {
+    InferenceRequest request;
+    request.input = input;
+    request.output = output;
+    request.submittedSeconds = LatencyStats::nowSeconds();
+    request.done = false;
+    unique_lock<std::mutex> lock(mutex);
+    if(stopping) {
+        throw runtime_error("InferenceQueue: stopped");
+    }
+    pending.push_back(&request);
+    requestAvailable.notify_one();
+    while(!request.done) {
+        requestDone.wait(lock);
+    }
+    if(request.error != "") {
+        throw runtime_error(request.error);
+    }
+}
+// waits up to idleTimeoutMilliseconds for a first request, then gathers and runs one batch
+// returns the number of requests run, 0 if none turned up, or the queue is stopped
+// only one thread should call this
+PUBLIC int InferenceQueue::runOnce(InferenceBatchFunction batchFunction, int idleTimeoutMilliseconds) {
+    unique_lock<std::mutex> lock(mutex);
+    chrono::steady_clock::time_point idleDeadline = chrono::steady_clock::now() + chrono::milliseconds(idleTimeoutMilliseconds);
+    while(pending.size() == 0 && !stopping) {
+        if(requestAvailable.wait_until(lock, idleDeadline) == cv_status::timeout) {
+            break;
+        }
+    }
+    if(pending.size() == 0 || stopping) {
+        return 0;
+    }
+    // the deadline runs from when the oldest request arrived, not from now
+    double waitedMilliseconds = (LatencyStats::nowSeconds() - pending.front()->submittedSeconds) * 1000.0;
+    chrono::steady_clock::time_point batchDeadline = chrono::steady_clock::now() +
+        chrono::microseconds((long)((maxLatencyMilliseconds - waitedMilliseconds) * 1000.0));
+    while((int)pending.size() < maxBatchSize && !stopping) {
+        if(requestAvailable.wait_until(lock, batchDeadline) == cv_status::timeout) {
+            break;
+        }
+    }
+    running.clear();
+    while((int)running.size() < maxBatchSize && pending.size() > 0) {
+        running.push_back(pending.front());
+        pending.pop_front();
+    }
+    int batchSize = (int)running.size();
+    // the requests stay alive until we mark them done, so we can read them unlocked
+    lock.unlock();
+    for(int i = 0; i < batchSize; i++) {
+        memcpy(batchInputs + (long)i * inputCubeSize, running[i]->input, sizeof(float) * inputCubeSize);
+    }
+    string error = "";
+    try {
+        batchFunction(batchSize, batchInputs, batchOutputs);
+        for(int i = 0; i < batchSize; i++) {
+            memcpy(running[i]->output, batchOutputs + (long)i * outputCubeSize, sizeof(float) * outputCubeSize);
+        }
+    } catch(exception &e) {
+        error = string("InferenceQueue: batch failed: ") + e.what();
+    } catch(...) {
+        // whatever it was, the waiting requests must still be failed, not left blocked
+        error = "InferenceQueue: batch failed";
+    }
+    lock.lock();
+    double nowSeconds = LatencyStats::nowSeconds();
+    for(int i = 0; i < batchSize; i++) {
+        running[i]->error = error;
+        running[i]->done = true;
+        if(error == "") {
+            latencyStats.add((float)((nowSeconds - running[i]->submittedSeconds) * 1000.0));
+        }
+    }
+    running.clear();
+    numBatches++;
+    requestDone.notify_all();
+    return batchSize;
+}
+// fails any pending requests, and any later submits; returns once no request is waiting
+PUBLIC void InferenceQueue::stop() {
+    unique_lock<std::mutex> lock(mutex);
+    stopping = true;
+    while(pending.size() > 0) {
+        pending.front()->error = "InferenceQueue: stopped";
+        pending.front()->done = true;
+        pending.pop_front();
+    }
+    requestAvailable.notify_all();
+    requestDone.notify_all();
+}
+PUBLIC long InferenceQueue::getNumBatches() {
+    unique_lock<std::mutex> lock(mutex);
+    return numBatches;
+}
+PUBLIC long InferenceQueue::getNumRequests() {
+    unique_lock<std::mutex> lock(mutex);
+    return latencyStats.getCount();
+}
+PUBLIC float InferenceQueue::getLatencyPercentile(float percentile) {
+    unique_lock<std::mutex> lock(mutex);
+    return latencyStats.getPercentile(percentile);
+}
+PUBLIC std::string InferenceQueue::getStatsString() {
+    unique_lock<std::mutex> lock(mutex);
+    ostringstream oss;
+    oss << "requests: " << latencyStats.toString() << " batches=" << numBatches;
+    if(numBatches > 0) {
+        oss << " mean batch size=" << (float)latencyStats.getCount() / numBatches;
+    }
+    return oss.str();
+}
+
@@ -0,0 +1,81 @@
+// Copyright Hugh Perkins 2015 hughperkins at gmail
+//
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file, You can
+// obtain one at http://mozilla.org/MPL/2.0/.
+
+#pragma once
+
+#include <deque>
+#include <vector>
+#include <string>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+
+#include "util/LatencyStats.h"
+#include "DeepCLDllExport.h"
+
+#define VIRTUAL virtual
+#define STATIC static
+
+// runs the net on batchSize examples, from inputs, writing outputCubeSize floats per example to outputs
+typedef std::function<void(int batchSize, float const*inputs, float *outputs)> InferenceBatchFunction;
+
+class InferenceRequest;
+
+/// \brief Coalesces single-example requests, from many threads, into batches for one net
+///
+/// Used by deepcl_predict server mode.  Each connection thread calls submit, which
+/// blocks until its example has been run.  The thread that owns the net calls runOnce
+/// in a loop: it waits for the first request, then keeps collecting until it has
+/// maxBatchSize requests, or the first one has waited maxLatencyMilliseconds, whichever
+/// comes first, and runs them as one batch.
+/// So under load batches are full, and a lone request waits at most maxLatencyMilliseconds
+/// for company.
+class DeepCL_EXPORT InferenceQueue {
+    private:
+    #ifdef _WIN32
+    #pragma warning(disable: 4251)
+    #endif
+    std::deque<InferenceRequest *> pending;
+    std::vector<InferenceRequest *> running;
+    std::mutex mutex;
+    std::condition_variable requestAvailable;
+    std::condition_variable requestDone;
+    #ifdef _WIN32
+    #pragma warning(default: 4251)
+    #endif
+    const int inputCubeSize;
+    const int outputCubeSize;
+    const int maxBatchSize;
+    const float maxLatencyMilliseconds;
+    float *batchInputs;
+    float *batchOutputs;
+    bool stopping;
+    long numBatches;
+    LatencyStats latencyStats;
+
+    // [[[cog
+    // import cog_addheaders
+    // cog_addheaders.addv2()
+    // ]]]
+    // generated, using cog:
+
+    public:
+    InferenceQueue(int inputCubeSize, int outputCubeSize, int maxBatchSize, float maxLatencyMilliseconds);
+    ~InferenceQueue();
+    int getInputCubeSize();
+    int getOutputCubeSize();
+    int getMaxBatchSize();
+    void submit(float const*input, float *output);
+    int runOnce(InferenceBatchFunction batchFunction, int idleTimeoutMilliseconds);
+    void stop();
+    long getNumBatches();
+    long getNumRequests();
+    float getLatencyPercentile(float percentile);
+    std::string getStatsString();
+
+    // [[[end]]]
+};
+
@@ -4,6 +4,8 @@
 // v. 2.0. If a copy of the MPL was not distributed with this file, You can 
 // obtain one at http://mozilla.org/MPL/2.0/.
 
+#include <stdexcept>
+
 #include "net/Trainable.h"
 #include "NetAction.h"
 #include "trainers/Trainer.h"
@@ -16,16 +18,29 @@ using namespace std;
 #define STATIC
 #define VIRTUAL
 
-void NetLearnLabeledAction::run(Trainable *net, int epoch, int batch, float const*const batchData, int const*const batchLabels) {
+BatchResult NetAction::run(Trainable *net, int epoch, int batch, unsigned char const*const batchData, int const*const batchLabels) {
+    throw runtime_error("NetAction: uint8 data not implemented for this action");
+}
+BatchResult NetLearnLabeledAction::run(Trainable *net, int epoch, int batch, float const*const batchData, int const*const batchLabels) {
 //    cout << "NetLearnLabeledBatch learningrate=" << learningRate << endl;
     TrainingContext context(epoch, batch);
-    trainer->trainFromLabels(net, &context, batchData, batchLabels);
+    return trainer->trainFromLabels(net, &context, batchData, batchLabels);
 }
 
-void NetForwardAction::run(Trainable *net, int epoch, int batch, float const*const batchData, int const*const batchLabels) {
+BatchResult NetLearnLabeledAction::run(Trainable *net, int epoch, int batch, unsigned char const*const batchData, int const*const batchLabels) {
+    TrainingContext context(epoch, batch);
+    return trainer->trainFromLabels(net, &context, batchData, batchLabels);
+}
+BatchResult NetForwardAction::run(Trainable *net, int epoch, int batch, float const*const batchData, int const*const batchLabels) {
 //    cout << "NetForwardBatch" << endl;
     net->forward(batchData);
 //    trainer->train(net, batchData, batchLabels);
+    return BatchResult(net->calcLossFromLabels(batchLabels), net->calcNumRight(batchLabels));
+}
+
+BatchResult NetForwardAction::run(Trainable *net, int epoch, int batch, unsigned char const*const batchData, int const*const batchLabels) {
+    net->forward(batchData);
+    return BatchResult(net->calcLossFromLabels(batchLabels), net->calcNumRight(batchLabels));
 }
 
 //void NetBackpropAction::run(Trainable *net, float const*const batchData, int const*const batchLabels) {
@@ -10,6 +10,7 @@
 
 class Trainable;
 class Trainer;
+class BatchResult;
 #include "trainers/TrainingContext.h"
 
 #define VIRTUAL virtual
@@ -25,10 +26,12 @@ public:
     }
 };
 
+// run returns the batch's loss and numRight
 class DeepCL_EXPORT NetAction {
 public:
     virtual ~NetAction() {}
-    virtual void run(Trainable *net, int epoch, int batch, float const*const batchData, int const*const batchLabels) = 0;
+    virtual BatchResult run(Trainable *net, int epoch, int batch, float const*const batchData, int const*const batchLabels) = 0;
+    virtual BatchResult run(Trainable *net, int epoch, int batch, unsigned char const*const batchData, int const*const batchLabels);
 };
 
 
@@ -42,7 +45,8 @@ public:
     NetLearnLabeledAction(Trainer *trainer) :
         trainer(trainer) {
     }   
-    virtual void run(Trainable *net, int epoch, int batch, float const*const batchData, int const*const batchLabels);
+    virtual BatchResult run(Trainable *net, int epoch, int batch, float const*const batchData, int const*const batchLabels);
+    virtual BatchResult run(Trainable *net, int epoch, int batch, unsigned char const*const batchData, int const*const batchLabels);
 };
 
 
@@ -50,7 +54,8 @@ class DeepCL_EXPORT NetForwardAction : public NetAction {
 public:
     NetForwardAction() {
     }
-    virtual void run(Trainable *net, int epoch, int batch, float const*const batchData, int const*const batchLabels);
+    virtual BatchResult run(Trainable *net, int epoch, int batch, float const*const batchData, int const*const batchLabels);
+    virtual BatchResult run(Trainable *net, int epoch, int batch, unsigned char const*const batchData, int const*const batchLabels);
 };
 
 
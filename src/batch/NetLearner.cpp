@@ -7,7 +7,7 @@
 #include <iostream>
 #include <string>
 
-#include "util/StatefulTimer.h"
+#include "util/Profiler.h"
 #include "util/Timer.h"
 #include "net/NeuralNet.h"
 #include "net/Trainable.h"
@@ -37,6 +37,24 @@ PUBLICAPI NetLearner::NetLearner(Trainer *trainer, Trainable *net,
     trainBatcher = new LearnBatcher(trainer, net, batchSize, Ntrain, trainData, trainLabels);
     testBatcher = new ForwardBatcher(net, batchSize, Ntest, testData, testLabels);   
 }
+/// \brief constructor, for uint8 data, 4 times smaller than float in memory, and to upload
+///
+/// the net should have a NormalizationLayer straight after the input layer; it normalizes
+/// the bytes on the device
+PUBLICAPI NetLearner::NetLearner(Trainer *trainer, Trainable *net,
+        int Ntrain, unsigned char *trainData, int *trainLabels,
+        int Ntest, unsigned char *testData, int *testLabels,
+        int batchSize) :
+        net(net)
+        {
+    numEpochs = 12;
+    nextEpoch = 0;
+    dumpTimings = false;
+    learningDone = false;
+
+    trainBatcher = new LearnBatcher(trainer, net, batchSize, Ntrain, trainData, trainLabels);
+    testBatcher = new ForwardBatcher(net, batchSize, Ntest, testData, testLabels);
+}
 VIRTUAL NetLearner::~NetLearner() {
     delete trainBatcher;
     delete testBatcher;
@@ -62,7 +80,7 @@ PUBLICAPI VIRTUAL void NetLearner::reset() {
 }
 VIRTUAL void NetLearner::postEpochTesting() {
     if(dumpTimings) {
-        StatefulTimer::dump(true);
+        cout << Profiler::getSummary(true);
     }
 //        cout << "-----------------------" << endl;
     cout << endl;
@@ -61,6 +61,10 @@ public:
     int Ntrain, float *trainData, int *trainLabels,
     int Ntest, float *testData, int *testLabels,
     int batchSize);
+    PUBLICAPI NetLearner(Trainer *trainer, Trainable *net,
+    int Ntrain, unsigned char *trainData, int *trainLabels,
+    int Ntest, unsigned char *testData, int *testLabels,
+    int batchSize);
     VIRTUAL ~NetLearner();
     VIRTUAL void setSchedule(int numEpochs);
     VIRTUAL void setDumpTimings(bool dumpTimings);
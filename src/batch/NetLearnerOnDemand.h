@@ -66,6 +66,7 @@ public:
     std::string testFilepath, int Ntest,
     int fileReadBatches, int batchSize);
     VIRTUAL ~NetLearnerOnDemand();
+    PUBLICAPI void setQueueDepth(int queueDepth);
     VIRTUAL void setSchedule(int numEpochs);
     VIRTUAL void setDumpTimings(bool dumpTimings);
     VIRTUAL void setSchedule(int numEpochs, int nextEpoch);
@@ -4,7 +4,9 @@
 // v. 2.0. If a copy of the MPL was not distributed with this file, You can 
 // obtain one at http://mozilla.org/MPL/2.0/.
 
-#include "util/StatefulTimer.h"
+#include <iostream>
+
+#include "util/Profiler.h"
 #include "util/Timer.h"
 #include "batch/BatchLearnerOnDemand.h"
 #include "net/NeuralNet.h"
@@ -51,6 +53,19 @@ VIRTUAL NetLearnerOnDemandv2::~NetLearnerOnDemandv2() {
     delete testAction;
     delete learnAction;
 }
+/// \brief how many file batches each of the train and test batchers hold in memory
+///
+/// see OnDemandBatcherv2::setQueueDepth
+PUBLICAPI void NetLearnerOnDemandv2::setQueueDepth(int queueDepth) {
+    learnBatcher->setQueueDepth(queueDepth);
+    testBatcher->setQueueDepth(queueDepth);
+}
+/// \brief shuffle the training examples each epoch; testing stays in file order
+///
+/// see OnDemandBatcherv2::setShuffle
+PUBLICAPI void NetLearnerOnDemandv2::setShuffle(int blocksPerPool, unsigned int seed) {
+    learnBatcher->setShuffle(blocksPerPool, seed);
+}
 VIRTUAL void NetLearnerOnDemandv2::setSchedule(int numEpochs) {
     setSchedule(numEpochs, 1);
 }
@@ -99,7 +114,7 @@ PUBLICAPI VIRTUAL void NetLearnerOnDemandv2::reset() {
 VIRTUAL void NetLearnerOnDemandv2::postEpochTesting() {
     cout << "dumpTimings " << dumpTimings << endl;
     if(dumpTimings) {
-        StatefulTimer::dump(true);
+        cout << Profiler::getSummary(true);
     }
 //        cout << "-----------------------" << endl;
     cout << endl;
@@ -107,9 +122,11 @@ VIRTUAL void NetLearnerOnDemandv2::postEpochTesting() {
 //    cout << "annealed learning rate: " << learnAction->getLearningRate()
     cout << " training loss: " << learnBatcher->getLoss() << endl;
     cout << " train accuracy: " << learnBatcher->getNumRight() << "/" << learnBatcher->getN() << " " << (learnBatcher->getNumRight() * 100.0f/ learnBatcher->getN()) << "%" << std::endl;
+    cout << " train waiting for data: " << learnBatcher->getStallMilliseconds() << "ms" << endl;
     testBatcher->run(nextEpoch);
 //    int testNumRight = batchLearnerOnDemand.test(testFilepath, fileReadBatches, batchSize, Ntest);
     cout << "test accuracy: " << testBatcher->getNumRight() << "/" << testBatcher->getN() << " " << (testBatcher->getNumRight() * 100.0f / testBatcher->getN()) << "%" << endl;
+    cout << " test waiting for data: " << testBatcher->getStallMilliseconds() << "ms" << endl;
     timer.timeCheck("after tests");
 }
 PUBLICAPI VIRTUAL bool NetLearnerOnDemandv2::tickBatch() { // means: filebatch, not low-level batch
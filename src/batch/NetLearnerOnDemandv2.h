@@ -69,6 +69,8 @@ public:
     GenericLoaderv2 *validateLoader, int Ntest,
     int fileReadBatches, int batchSize);
     VIRTUAL ~NetLearnerOnDemandv2();
+    PUBLICAPI void setQueueDepth(int queueDepth);
+    PUBLICAPI void setShuffle(int blocksPerPool, unsigned int seed);
     VIRTUAL void setSchedule(int numEpochs);
     VIRTUAL void setDumpTimings(bool dumpTimings);
     VIRTUAL void setSchedule(int numEpochs, int nextEpoch);
@@ -10,6 +10,7 @@
 #include "Batcher.h"
 
 #include "OnDemandBatcher.h"
+#include "batch/BatchPrefetcher.h"
 
 using namespace std;
 
@@ -28,18 +29,33 @@ PUBLICAPI OnDemandBatcher::OnDemandBatcher(Trainable *net, NetAction *netAction,
             fileReadBatches(fileReadBatches),
             batchSize(batchSize),
             fileBatchSize(batchSize * fileReadBatches),
-            inputCubeSize(net->getInputCubeSize())
+            inputCubeSize(net->getInputCubeSize()),
+            queueDepth(2),
+            prefetcher(0)
         {
     numFileBatches = (N + fileBatchSize - 1) / fileBatchSize;
-    dataBuffer = new float[ fileBatchSize * inputCubeSize ];
-    labelsBuffer = new int[ fileBatchSize ];
-    netActionBatcher = new NetActionBatcher(net, batchSize, fileBatchSize, dataBuffer, labelsBuffer, netAction);
+    netActionBatcher = new NetActionBatcher(net, batchSize, fileBatchSize, 0, 0, netAction);
     reset();
 }
 VIRTUAL OnDemandBatcher::~OnDemandBatcher() {
+    delete prefetcher;
     delete netActionBatcher;
-    delete[] dataBuffer;
-    delete[] labelsBuffer;
+}
+/// \brief how many file batches to hold in memory, including the one being processed
+///
+/// 2 means the next one is loaded while the current one is processed, 1 means
+/// load synchronously.  Memory used is queueDepth * fileReadBatches * batchSize examples
+PUBLICAPI void OnDemandBatcher::setQueueDepth(int queueDepth) {
+    this->queueDepth = queueDepth;
+    delete prefetcher;
+    prefetcher = 0;
+}
+PUBLICAPI int OnDemandBatcher::getQueueDepth() {
+    return queueDepth;
+}
+/// \brief milliseconds spent this epoch waiting for data to be loaded
+PUBLICAPI double OnDemandBatcher::getStallMilliseconds() {
+    return prefetcher == 0 ? 0 : prefetcher->getStallMilliseconds();
 }
 VIRTUAL void OnDemandBatcher::setBatchState(int nextBatch, int numRight, float loss) {
     this->nextFileBatch = nextBatch / fileReadBatches;
@@ -83,6 +99,9 @@ PUBLICAPI void OnDemandBatcher::reset() {
     loss = 0;
     nextFileBatch = 0;
     epochDone = false;
+    if(prefetcher != 0) {
+        prefetcher->resetStallMilliseconds();
+    }
 }
 PUBLICAPI bool OnDemandBatcher::tick(int epoch) {
 //    cout << "OnDemandBatcher::tick nextFileBatch=" << nextFileBatch << " numRight=" << numRight << 
@@ -99,7 +118,16 @@ PUBLICAPI bool OnDemandBatcher::tick(int epoch) {
     }
     netActionBatcher->setN(thisFileBatchSize);
 //    cout << "batchlearnerondemand, read data... filebatchstart=" << fileBatchStart << " filebatchsize=" << thisFileBatchSize << endl;
-    GenericLoader::load(filepath.c_str(), dataBuffer, labelsBuffer, fileBatchStart, thisFileBatchSize);
+    if(prefetcher == 0) {
+        string filepath = this->filepath;
+        prefetcher = new BatchPrefetcher([filepath](unsigned char *data, int *labels, int start, int count) {
+            GenericLoader::load(filepath.c_str(), data, labels, start, count);
+        }, N, fileBatchSize, inputCubeSize, queueDepth);
+    }
+    unsigned char *dataBuffer = 0;
+    int *labelsBuffer = 0;
+    prefetcher->acquire(fileBatch, &dataBuffer, &labelsBuffer);
+    netActionBatcher->setData(dataBuffer, labelsBuffer);
     EpochResult epochResult = netActionBatcher->run(epoch);
     loss += epochResult.loss;
     numRight += epochResult.numRight;
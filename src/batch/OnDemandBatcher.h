@@ -12,6 +12,7 @@
 class NetActionBatcher;
 class Trainable;
 class NetAction;
+class BatchPrefetcher;
 
 #include "batch/NetAction.h"
 
@@ -27,6 +28,9 @@ class NetAction;
 ///
 /// If you want to run multiple epochs, you can use a 'NetLearnerOnDemand'
 /// class
+///
+/// The next chunk is loaded on a background thread, while the current one
+/// is being processed, see BatchPrefetcher, and setQueueDepth
 PUBLICAPI
 class OnDemandBatcher {
 protected:
@@ -44,8 +48,8 @@ protected:
     const int inputCubeSize;
     int numFileBatches;
 
-    float *dataBuffer;
-    int *labelsBuffer;
+    int queueDepth;
+    BatchPrefetcher *prefetcher;
 
     bool epochDone;
     int numRight;
@@ -62,6 +66,9 @@ public:
     PUBLICAPI OnDemandBatcher(Trainable *net, NetAction *netAction,
     std::string filepath, int N, int fileReadBatches, int batchSize);
     VIRTUAL ~OnDemandBatcher();
+    PUBLICAPI void setQueueDepth(int queueDepth);
+    PUBLICAPI int getQueueDepth();
+    PUBLICAPI double getStallMilliseconds();
     VIRTUAL void setBatchState(int nextBatch, int numRight, float loss);
     VIRTUAL int getBatchSize();
     PUBLICAPI VIRTUAL int getNextFileBatch();
@@ -4,12 +4,17 @@
 // v. 2.0. If a copy of the MPL was not distributed with this file, You can 
 // obtain one at http://mozilla.org/MPL/2.0/.
 
+#include <vector>
+#include <algorithm>
+
 #include "batch/NetAction.h"
 #include "net/Trainable.h"
 #include "loaders/GenericLoaderv2.h"
 #include "batch/Batcher.h"
 
 #include "batch/OnDemandBatcherv2.h"
+#include "batch/BatchPrefetcher.h"
+#include "batch/BlockShuffler.h"
 
 using namespace std;
 
@@ -18,6 +23,15 @@ using namespace std;
 #define STATIC
 #define VIRTUAL
 
+// data is floats, cast to bytes, for a float packed file
+static void loadExamples(GenericLoaderv2 *loader, bool floatData, unsigned char *data, int *labels, int start, int count) {
+    if(floatData) {
+        loader->load(reinterpret_cast<float *>(data), labels, start, count);
+    } else {
+        loader->load(data, labels, start, count);
+    }
+}
+
 PUBLICAPI OnDemandBatcherv2::OnDemandBatcherv2(Trainable *net, NetAction *netAction, 
             GenericLoaderv2 *loader, int N, int fileReadBatches, int batchSize) :
             net(net),
@@ -28,18 +42,60 @@ PUBLICAPI OnDemandBatcherv2::OnDemandBatcherv2(Trainable *net, NetAction *netAct
             fileReadBatches(fileReadBatches),
             batchSize(batchSize),
             fileBatchSize(batchSize * fileReadBatches),
-            inputCubeSize(net->getInputCubeSize())
+            inputCubeSize(net->getInputCubeSize()),
+            floatData(loader->getIsFloat()),
+            queueDepth(2),
+            prefetcher(0),
+            shuffler(0)
         {
     numFileBatches = (N + fileBatchSize - 1) / fileBatchSize;
-    dataBuffer = new float[ fileBatchSize * inputCubeSize ];
-    labelsBuffer = new int[ fileBatchSize ];
-    netActionBatcher = new NetActionBatcher(net, batchSize, fileBatchSize, dataBuffer, labelsBuffer, netAction);
+    netActionBatcher = new NetActionBatcher(net, batchSize, fileBatchSize, 0, 0, netAction);
     reset();
 }
 VIRTUAL OnDemandBatcherv2::~OnDemandBatcherv2() {
+    delete prefetcher;
+    delete shuffler;
     delete netActionBatcher;
-    delete[] dataBuffer;
-    delete[] labelsBuffer;
+}
+/// \brief how many file batches to hold in memory, including the one being processed
+///
+/// 2 means the next one is loaded while the current one is processed, 1 means
+/// load synchronously.  Memory used is queueDepth * fileReadBatches * batchSize examples
+PUBLICAPI void OnDemandBatcherv2::setQueueDepth(int queueDepth) {
+    this->queueDepth = queueDepth;
+    delete prefetcher;
+    prefetcher = 0;
+}
+PUBLICAPI int OnDemandBatcherv2::getQueueDepth() {
+    return queueDepth;
+}
+/// \brief shuffle the examples differently each epoch, see BlockShuffler
+///
+/// Each file batch is then put together from blocksPerPool blocks of consecutive
+/// examples, from random places in the file, and shuffled in memory.  More blocks
+/// mixes better, but makes the reads smaller.  The order only depends on seed
+/// and the epoch, so resuming with setBatchState carries on where it stopped.
+/// blocksPerPool 0 reads in file order again
+PUBLICAPI void OnDemandBatcherv2::setShuffle(int blocksPerPool, unsigned int seed) {
+    delete prefetcher;
+    prefetcher = 0;
+    delete shuffler;
+    shuffler = 0;
+    if(blocksPerPool > 0) {
+        blocksPerPool = std::min(blocksPerPool, fileBatchSize);
+        shuffler = new BlockShuffler(N, fileBatchSize / blocksPerPool, blocksPerPool, seed);
+        numFileBatches = shuffler->getNumPools();
+    } else {
+        numFileBatches = (N + fileBatchSize - 1) / fileBatchSize;
+    }
+}
+/// \brief size of one example in the prefetch buffers, which are bytes, holding floats for a float packed file
+PUBLICAPI int OnDemandBatcherv2::getExampleBytes() {
+    return inputCubeSize * (floatData ? (int)sizeof(float) : 1);
+}
+/// \brief milliseconds spent this epoch waiting for data to be loaded
+PUBLICAPI double OnDemandBatcherv2::getStallMilliseconds() {
+    return prefetcher == 0 ? 0 : prefetcher->getStallMilliseconds();
 }
 VIRTUAL void OnDemandBatcherv2::setBatchState(int nextBatch, int numRight, float loss) {
     this->nextFileBatch = nextBatch / fileReadBatches;
@@ -83,6 +139,9 @@ PUBLICAPI void OnDemandBatcherv2::reset() {
     loss = 0;
     nextFileBatch = 0;
     epochDone = false;
+    if(prefetcher != 0) {
+        prefetcher->resetStallMilliseconds();
+    }
 }
 PUBLICAPI bool OnDemandBatcherv2::tick(int epoch) {
 //    cout << "OnDemandBatcherv2::tick nextFileBatch=" << nextFileBatch << " numRight=" << numRight << 
@@ -94,12 +153,60 @@ PUBLICAPI bool OnDemandBatcherv2::tick(int epoch) {
     int fileBatch = nextFileBatch;
     int fileBatchStart = fileBatch * fileBatchSize;
     int thisFileBatchSize = fileBatchSize;
-    if(fileBatch == numFileBatches - 1) {
+    if(shuffler != 0) {
+        thisFileBatchSize = shuffler->getPoolN(epoch, fileBatch);
+    } else if(fileBatch == numFileBatches - 1) {
         thisFileBatchSize = N - fileBatchStart;
     }
     netActionBatcher->setN(thisFileBatchSize);
 //    cout << "batchlearnerondemand, read data... filebatchstart=" << fileBatchStart << " filebatchsize=" << thisFileBatchSize << endl;
-    loader->load(dataBuffer, labelsBuffer, fileBatchStart, thisFileBatchSize);
+    if(prefetcher == 0 && shuffler != 0) {
+        // file batch is a pool; its blocks are read in file order, merging
+        // neighbours into one read, then shuffled in the prefetch buffer
+        GenericLoaderv2 *loader = this->loader;
+        BlockShuffler *shuffler = this->shuffler;
+        int fileBatchSize = this->fileBatchSize;
+        bool floatData = this->floatData;
+        int exampleBytes = getExampleBytes();
+        PrefetchEpochLoadFunction loadFunction = [loader, shuffler, fileBatchSize, floatData, exampleBytes](unsigned char *data, int *labels, int epoch, int start, int count) {
+            int pool = start / fileBatchSize;
+            vector<int> blocks;
+            shuffler->getPoolBlocks(epoch, pool, &blocks);
+            int poolN = 0;
+            for(int i = 0; i < (int)blocks.size();) {
+                int readStart = shuffler->getBlockStart(blocks[i]);
+                int readN = 0;
+                int j = i;
+                while(j < (int)blocks.size() && (j == i || blocks[j] == blocks[j - 1] + 1)) {
+                    readN += shuffler->getBlockN(blocks[j]);
+                    j++;
+                }
+                loadExamples(loader, floatData, data + (long)poolN * exampleBytes, labels + poolN, readStart, readN);
+                poolN += readN;
+                i = j;
+            }
+            shuffler->shufflePool(epoch, pool, data, labels, poolN, exampleBytes);
+        };
+        prefetcher = new BatchPrefetcher(loadFunction, numFileBatches * fileBatchSize, fileBatchSize, getExampleBytes(), queueDepth);
+    } else if(prefetcher == 0) {
+        GenericLoaderv2 *loader = this->loader;
+        bool floatData = this->floatData;
+        prefetcher = new BatchPrefetcher([loader, floatData](unsigned char *data, int *labels, int start, int count) {
+            loadExamples(loader, floatData, data, labels, start, count);
+        }, N, fileBatchSize, getExampleBytes(), queueDepth);
+    }
+    unsigned char *dataBuffer = 0;
+    int *labelsBuffer = 0;
+    if(shuffler != 0) {
+        prefetcher->acquire(epoch, fileBatch, &dataBuffer, &labelsBuffer);
+    } else {
+        prefetcher->acquire(fileBatch, &dataBuffer, &labelsBuffer);
+    }
+    if(floatData) {
+        netActionBatcher->setData(reinterpret_cast<float const*>(dataBuffer), labelsBuffer);
+    } else {
+        netActionBatcher->setData(dataBuffer, labelsBuffer);
+    }
     EpochResult epochResult = netActionBatcher->run(epoch);
     loss += epochResult.loss;
     numRight += epochResult.numRight;
@@ -12,6 +12,8 @@
 class NetActionBatcher;
 class Trainable;
 class NetAction;
+class BatchPrefetcher;
+class BlockShuffler;
 class GenericLoaderv2;
 
 #include "batch/NetAction.h"
@@ -29,6 +31,9 @@ class GenericLoaderv2;
 /// If you want to run multiple epochs, you can use a 'NetLearnerOnDemand'
 /// class
 ///
+/// The next chunk is loaded on a background thread, while the current one
+/// is being processed, see BatchPrefetcher, and setQueueDepth
+///
 /// compared to v1, v2 recevies a GenericLoaderv2 loader object, instead of a filepath
 /// so we can handle imagenet manifests etc
 PUBLICAPI
@@ -47,10 +52,12 @@ protected:
     const int batchSize;
     const int fileBatchSize;
     const int inputCubeSize;
+    const bool floatData; // a normalized float packed file; the prefetch buffers hold floats
     int numFileBatches;
 
-    float *dataBuffer;
-    int *labelsBuffer;
+    int queueDepth;
+    BatchPrefetcher *prefetcher;
+    BlockShuffler *shuffler; // 0 means read in file order
 
     bool epochDone;
     int numRight;
@@ -67,6 +74,11 @@ public:
     PUBLICAPI OnDemandBatcherv2(Trainable *net, NetAction *netAction,
     GenericLoaderv2 *loader, int N, int fileReadBatches, int batchSize);
     VIRTUAL ~OnDemandBatcherv2();
+    PUBLICAPI void setQueueDepth(int queueDepth);
+    PUBLICAPI int getQueueDepth();
+    PUBLICAPI void setShuffle(int blocksPerPool, unsigned int seed);
+    PUBLICAPI int getExampleBytes();
+    PUBLICAPI double getStallMilliseconds();
     VIRTUAL void setBatchState(int nextBatch, int numRight, float loss);
     VIRTUAL int getBatchSize();
     PUBLICAPI VIRTUAL int getNextFileBatch();
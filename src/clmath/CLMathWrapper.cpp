@@ -10,6 +10,7 @@
 #include "CLFloatWrapper.h"
 #include "util/stringhelper.h"
 #include "clmath/GpuOp.h"
+#include "clmath/FusedOp.h"
 #include "clmath/CLMathWrapper.h"
 
 using namespace std;
@@ -25,18 +26,30 @@ VIRTUAL CLMathWrapper::~CLMathWrapper() {
 VIRTUAL CLMathWrapper &CLMathWrapper::operator=(const float scalar) {
 //    cout << "CLMathWrapper.operator*=(scalar)" << endl;
     Op2Equal op;
+    if(fused != 0) {
+        fused->applyScalar(fusedIndex, scalar, &op);
+        return *this;
+    }
     gpuOp->apply2_inplace(N, wrapper, scalar, &op);
     return *this;    
 }
 VIRTUAL CLMathWrapper &CLMathWrapper::operator*=(const float scalar) {
 //    cout << "CLMathWrapper.operator*=(scalar)" << endl;
     Op2Mul op;
+    if(fused != 0) {
+        fused->applyScalar(fusedIndex, scalar, &op);
+        return *this;
+    }
     gpuOp->apply2_inplace(N, wrapper, scalar, &op);
     return *this;    
 }
 VIRTUAL CLMathWrapper &CLMathWrapper::operator+=(const float scalar) {
 //    cout << "CLMathWrapper.operator*=(scalar)" << endl;
     Op2Add op;
+    if(fused != 0) {
+        fused->applyScalar(fusedIndex, scalar, &op);
+        return *this;
+    }
     gpuOp->apply2_inplace(N, wrapper, scalar, &op);
     return *this;    
 }
@@ -47,6 +60,10 @@ VIRTUAL CLMathWrapper &CLMathWrapper::operator*=(const CLMathWrapper &two) {
             " vs " + toString(N) );
     }
     Op2Mul op;
+    if(checkFused(two)) {
+        fused->apply(fusedIndex, two.fusedIndex, &op);
+        return *this;
+    }
     gpuOp->apply2_inplace(N, wrapper, ((CLMathWrapper &)two).wrapper, &op);
     return *this;    
 }
@@ -57,6 +74,10 @@ VIRTUAL CLMathWrapper &CLMathWrapper::operator+=(const CLMathWrapper &two) {
             " vs " + toString(N) );
     }
     Op2Add op;
+    if(checkFused(two)) {
+        fused->apply(fusedIndex, two.fusedIndex, &op);
+        return *this;
+    }
     gpuOp->apply2_inplace(N, wrapper, ((CLMathWrapper &)two).wrapper, &op);
     return *this;    
 }
@@ -67,21 +88,37 @@ VIRTUAL CLMathWrapper &CLMathWrapper::operator=(const CLMathWrapper &rhs) {
             " vs " + toString(N) );
     }
     Op2Equal op;
+    if(checkFused(rhs)) {
+        fused->apply(fusedIndex, rhs.fusedIndex, &op);
+        return *this;
+    }
     gpuOp->apply2_inplace(N, wrapper, ((CLMathWrapper &)rhs).wrapper, &op);
     return *this;
 }
 VIRTUAL CLMathWrapper &CLMathWrapper::sqrt() {
     Op1Sqrt op;
+    if(fused != 0) {
+        fused->apply(fusedIndex, &op);
+        return *this;
+    }
     gpuOp->apply1_inplace(N, wrapper, &op);
     return *this;
 }
 VIRTUAL CLMathWrapper &CLMathWrapper::inv() {
     Op1Inv op;
+    if(fused != 0) {
+        fused->apply(fusedIndex, &op);
+        return *this;
+    }
     gpuOp->apply1_inplace(N, wrapper, &op);
     return *this;
 }
 VIRTUAL CLMathWrapper &CLMathWrapper::squared() {
     Op1Squared op;
+    if(fused != 0) {
+        fused->apply(fusedIndex, &op);
+        return *this;
+    }
     gpuOp->apply1_inplace(N, wrapper, &op);
     return *this;
 }
@@ -101,5 +138,56 @@ CLMathWrapper::CLMathWrapper(CLWrapper *wrapper) {
     this->wrapper = floatWrapper;
     this->N = floatWrapper->size();
     this->gpuOp = new GpuOp(cl);
+    this->fused = 0;
+    this->fusedIndex = -1;
+}
+// only works on the first N elements of wrapper, eg for Workspace buffers,
+// which may be bigger than asked for
+CLMathWrapper::CLMathWrapper(CLWrapper *wrapper, int N) {
+    CLFloatWrapper *floatWrapper = dynamic_cast< CLFloatWrapper * >(wrapper);
+    if(floatWrapper == 0) {
+        throw runtime_error("CLMathWrapper only works on CLFloatWrapper objects");
+    }
+    if(N > floatWrapper->size()) {
+        throw runtime_error("CLMathWrapper: N " + toString(N) + " bigger than wrapper size " + toString(floatWrapper->size()));
+    }
+    this->cl = floatWrapper->getCl();
+    this->wrapper = floatWrapper;
+    this->N = N;
+    this->gpuOp = new GpuOp(cl);
+    this->fused = 0;
+    this->fusedIndex = -1;
+}
+// operations on this are recorded into fused, and only run when fused->run()
+// is called.  Works on the first fused->getN() elements of wrapper
+CLMathWrapper::CLMathWrapper(CLWrapper *wrapper, FusedOp *fused) {
+    CLFloatWrapper *floatWrapper = dynamic_cast< CLFloatWrapper * >(wrapper);
+    if(floatWrapper == 0) {
+        throw runtime_error("CLMathWrapper only works on CLFloatWrapper objects");
+    }
+    this->cl = fused->getCl();
+    this->wrapper = floatWrapper;
+    this->N = fused->getN();
+    this->gpuOp = 0;
+    this->fused = fused;
+    this->fusedIndex = fused->addArray(wrapper);
+}
+// a temporary, inside fused, which only ever lives in registers, so needs no
+// buffer; assign it before using it
+CLMathWrapper::CLMathWrapper(FusedOp *fused) {
+    this->cl = fused->getCl();
+    this->wrapper = 0;
+    this->N = fused->getN();
+    this->gpuOp = 0;
+    this->fused = fused;
+    this->fusedIndex = fused->addTemporary();
+}
+// true if this and two are both recorded into the same FusedOp, false if
+// both run immediately; mixing the two is an error
+bool CLMathWrapper::checkFused(const CLMathWrapper &two) {
+    if(fused != two.fused) {
+        throw runtime_error("CLMathWrapper: cannot mix wrappers from different FusedOps, or fused with unfused");
+    }
+    return fused != 0;
 }
 
@@ -15,6 +15,7 @@
 #define STATIC static
 
 class GpuOp;
+class FusedOp;
 class CLFloatBuffer;
 class EasyCL;
 class CLKernel;
@@ -31,6 +32,8 @@ class DeepCL_EXPORT CLMathWrapper {
 
     int N;
     CLFloatWrapper *wrapper; // dont delete
+    FusedOp *fused; // dont delete.  0 unless operations are being recorded, see FusedOp
+    int fusedIndex; // our variable in fused
 
 public:
     
@@ -51,6 +54,10 @@ public:
     VIRTUAL CLMathWrapper &squared();
     VIRTUAL void runKernel(CLKernel *kernel);
     CLMathWrapper(CLWrapper *wrapper);
+    CLMathWrapper(CLWrapper *wrapper, int N);
+    CLMathWrapper(CLWrapper *wrapper, FusedOp *fused);
+    CLMathWrapper(FusedOp *fused);
+    bool checkFused(const CLMathWrapper &two);
 
     // [[[end]]]
 };
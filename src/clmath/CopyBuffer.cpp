@@ -7,8 +7,8 @@
 #include <iostream>
 
 #include "EasyCL.h"
-#include "util/StatefulTimer.h"
 #include "clmath/CopyBuffer.h"
+#include "util/KernelCache.h"
 
 using namespace std;
 
@@ -30,7 +30,6 @@ VIRTUAL void CopyBuffer::copy(int N, CLWrapper *in, CLWrapper *out) {
     kernel->run_1d(numWorkgroups * workgroupSize, workgroupSize);
     cl->finish();
 
-    StatefulTimer::instance()->timeCheck("CopyBuffer::copy end");
 }
 
 VIRTUAL CopyBuffer::~CopyBuffer() {
@@ -113,7 +112,7 @@ CopyBuffer::CopyBuffer(EasyCL *cl) :
     "}\n"
     "\n"
     "";
-    kernel = cl->buildKernelFromString(kernelSource, "copy", options, "cl/copy.cl");
+    kernel = KernelCache::buildKernelFromString(cl, kernelSource, "copy", options, "cl/copy.cl");
     // [[[end]]]
     cl->storeKernel(kernelName, kernel, true);
     this->kernel = kernel;
@@ -0,0 +1,177 @@
+// Copyright Hugh Perkins 2015 hughperkins at gmail
+//
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file, You can
+// obtain one at http://mozilla.org/MPL/2.0/.
+
+#include <iostream>
+#include <sstream>
+#include <stdexcept>
+
+#include "EasyCL.h"
+#include "util/stringhelper.h"
+#include "util/KernelCache.h"
+#include "clmath/GpuOp.h"
+#include "clmath/FusedOp.h"
+
+using namespace std;
+
+#undef STATIC
+#undef VIRTUAL
+#define STATIC
+#define VIRTUAL
+
+// per-variable flags
+#define FUSED_LOAD 1 // read before first written, so load it at the start
+#define FUSED_STORE 2 // written, and has a buffer, so store it at the end
+#define FUSED_WRITTEN 4 // has been written so far
+
+PUBLIC FusedOp::FusedOp(EasyCL *cl, int N) :
+        cl(cl),
+        N(N) {
+}
+PUBLIC FusedOp::~FusedOp() {
+}
+PUBLIC int FusedOp::getN() {
+    return N;
+}
+PUBLIC EasyCL *FusedOp::getCl() {
+    return cl;
+}
+// returns the index of a new variable, backed by wrapper, which must have
+// at least N floats
+PUBLIC int FusedOp::addArray(CLWrapper *wrapper) {
+    if(wrapper->size() < N) {
+        throw runtime_error("FusedOp::addArray: wrapper has " + toString(wrapper->size()) + " floats, need " + toString(N));
+    }
+    wrappers.push_back(wrapper);
+    flags.push_back(0);
+    return (int)wrappers.size() - 1;
+}
+// a variable that only lives in registers; must be assigned before use
+PUBLIC int FusedOp::addTemporary() {
+    wrappers.push_back(0);
+    flags.push_back(0);
+    return (int)wrappers.size() - 1;
+}
+// target = op(target)
+PUBLIC void FusedOp::apply(int target, Op1 *op) {
+    read(target);
+    string expression = replaceGlobal(op->getOperationString(), "val_one", var(target));
+    statements += "    " + var(target) + " = " + expression + ";\n";
+    write(target);
+}
+// target = op(target, source)
+PUBLIC void FusedOp::apply(int target, int source, Op2 *op) {
+    read(source);
+    string expression = op->getOperationString();
+    if(expression.find("val_one") != string::npos) {
+        read(target);
+    }
+    expression = replaceGlobal(expression, "val_one", var(target));
+    expression = replaceGlobal(expression, "val_two", var(source));
+    statements += "    " + var(target) + " = " + expression + ";\n";
+    write(target);
+}
+// target = op(target, scalar)
+PUBLIC void FusedOp::applyScalar(int target, float scalar, Op2 *op) {
+    string expression = op->getOperationString();
+    if(expression.find("val_one") != string::npos) {
+        read(target);
+    }
+    string scalarName = "s" + toString((int)scalars.size());
+    scalars.push_back(scalar);
+    expression = replaceGlobal(expression, "val_one", var(target));
+    expression = replaceGlobal(expression, "val_two", scalarName);
+    statements += "    " + var(target) + " = " + expression + ";\n";
+    write(target);
+}
+PRIVATE std::string FusedOp::var(int index) {
+    return "v" + toString(index);
+}
+PRIVATE void FusedOp::read(int index) {
+    if(flags[index] & FUSED_WRITTEN) {
+        return;
+    }
+    if(wrappers[index] == 0) {
+        throw runtime_error("FusedOp: temporary " + var(index) + " read before it was assigned");
+    }
+    flags[index] |= FUSED_LOAD;
+}
+PRIVATE void FusedOp::write(int index) {
+    flags[index] |= FUSED_WRITTEN;
+    if(wrappers[index] != 0) {
+        flags[index] |= FUSED_STORE;
+    }
+}
+// the generated OpenCL, for whatever has been recorded so far
+PUBLIC std::string FusedOp::getKernelSource() {
+    ostringstream source;
+    source << "kernel void fused_op(const int N";
+    for(int i = 0; i < (int)wrappers.size(); i++) {
+        if(wrappers[i] != 0) {
+            source << ", global " << ((flags[i] & FUSED_STORE) ? "" : "const ") << "float *a" << i;
+        }
+    }
+    for(int i = 0; i < (int)scalars.size(); i++) {
+        source << ", const float s" << i;
+    }
+    source << ") {\n";
+    source << "    const int globalId = get_global_id(0);\n";
+    source << "    if (globalId >= N) {\n";
+    source << "        return;\n";
+    source << "    }\n";
+    for(int i = 0; i < (int)wrappers.size(); i++) {
+        source << "    float " << var(i);
+        if(flags[i] & FUSED_LOAD) {
+            source << " = a" << i << "[globalId]";
+        }
+        source << ";\n";
+    }
+    source << statements;
+    for(int i = 0; i < (int)wrappers.size(); i++) {
+        if(flags[i] & FUSED_STORE) {
+            source << "    a" << i << "[globalId] = " << var(i) << ";\n";
+        }
+    }
+    source << "}\n";
+    return source.str();
+}
+// runs everything recorded, as one kernel, then starts a new, empty, recording
+// the variables stay, so the same FusedOp can be reused for the next update
+PUBLIC void FusedOp::run() {
+    if(statements == "") {
+        return;
+    }
+    string source = getKernelSource();
+    string kernelName = "FusedOp:" + source;
+    if(!cl->kernelExists(kernelName)) {
+        CLKernel *kernel = KernelCache::buildKernelFromString(cl, source, "fused_op", "", "FusedOp.cpp");
+        cl->storeKernel(kernelName, kernel, true);
+    }
+    CLKernel *kernel = cl->getKernel(kernelName);
+    kernel->in(N);
+    for(int i = 0; i < (int)wrappers.size(); i++) {
+        if(wrappers[i] == 0) {
+            continue;
+        }
+        if(flags[i] & FUSED_STORE) {
+            kernel->inout(wrappers[i]);
+        } else {
+            kernel->in(wrappers[i]);
+        }
+    }
+    for(int i = 0; i < (int)scalars.size(); i++) {
+        kernel->in(scalars[i]);
+    }
+    int workgroupSize = 64;
+    int numWorkgroups = (N + workgroupSize - 1) / workgroupSize;
+    kernel->run_1d(numWorkgroups * workgroupSize, workgroupSize);
+    cl->finish();
+
+    statements = "";
+    scalars.clear();
+    for(int i = 0; i < (int)flags.size(); i++) {
+        flags[i] = 0;
+    }
+}
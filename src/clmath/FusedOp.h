@@ -0,0 +1,77 @@
+// Copyright Hugh Perkins 2015 hughperkins at gmail
+//
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file, You can
+// obtain one at http://mozilla.org/MPL/2.0/.
+
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include "DeepCLDllExport.h"
+
+class EasyCL;
+class CLWrapper;
+class CLKernel;
+class Op1;
+class Op2;
+
+#define VIRTUAL virtual
+#define STATIC static
+
+// records CLMathWrapper operations, instead of running them one kernel at a
+// time, and then runs them all as one generated kernel, where each array is
+// read once, everything happens in registers, and each array written is
+// written once.  eg:
+//     FusedOp fused(cl, numWeights);
+//     CLMathWrapper clWeights(weightsWrapper, &fused);
+//     CLMathWrapper clWorking(&fused); // register only, no buffer
+//     clWorking = clGradWeights;
+//     ...
+//     fused.run();
+// The kernel depends only on the sequence of operations, not on N or on the
+// scalar values, which are kernel arguments, so each trainer builds it once,
+// and it is kept by the EasyCL, and on disk by KernelCache
+class DeepCL_EXPORT FusedOp {
+    private:
+    EasyCL *cl;
+    int N;
+    #ifdef _WIN32
+    #pragma warning(disable: 4251)
+    #endif
+    std::vector<CLWrapper *> wrappers; // one per variable, 0 for temporaries
+    std::vector<int> flags; // one per variable, see FusedOp.cpp
+    std::vector<float> scalars;
+    std::string statements;
+    #ifdef _WIN32
+    #pragma warning(default: 4251)
+    #endif
+
+    // [[[cog
+    // import cog_addheaders
+    // cog_addheaders.addv2()
+    // ]]]
+    // generated, using cog:
+
+    public:
+    FusedOp(EasyCL *cl, int N);
+    ~FusedOp();
+    int getN();
+    EasyCL *getCl();
+    int addArray(CLWrapper *wrapper);
+    int addTemporary();
+    void apply(int target, Op1 *op);
+    void apply(int target, int source, Op2 *op);
+    void applyScalar(int target, float scalar, Op2 *op);
+    std::string getKernelSource();
+    void run();
+
+    private:
+    std::string var(int index);
+    void read(int index);
+    void write(int index);
+
+    // [[[end]]]
+};
+
@@ -6,9 +6,9 @@
 
 #include <iostream>
 
-#include "util/StatefulTimer.h"
 #include "EasyCL.h"
 #include "clmath/GpuAdd.h"
+#include "util/KernelCache.h"
 
 using namespace std;
 
@@ -19,7 +19,6 @@ using namespace std;
 
 /// \brief calculates destinationWrapper += deltaWrapper
 VIRTUAL void GpuAdd::add(int N, CLWrapper*destinationWrapper, CLWrapper *deltaWrapper) {
-    StatefulTimer::instance()->timeCheck("GpuAdd::add start");
 
     kernel->in(N);
     kernel->inout(destinationWrapper);
@@ -30,7 +29,6 @@ VIRTUAL void GpuAdd::add(int N, CLWrapper*destinationWrapper, CLWrapper *deltaWr
     kernel->run_1d(numWorkgroups * workgroupSize, workgroupSize);
     cl->finish();
 
-    StatefulTimer::instance()->timeCheck("GpuAdd::add end");
 }
 VIRTUAL GpuAdd::~GpuAdd() {
 }
@@ -85,7 +83,7 @@ GpuAdd::GpuAdd(EasyCL *cl) :
     "}\n"
     "\n"
     "";
-    kernel = cl->buildKernelFromString(kernelSource, "per_element_add", options, "cl/per_element_add.cl");
+    kernel = KernelCache::buildKernelFromString(cl, kernelSource, "per_element_add", options, "cl/per_element_add.cl");
     // [[[end]]]
     cl->storeKernel(kernelName, kernel, true);
     this->kernel = kernel;
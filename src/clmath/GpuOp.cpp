@@ -6,10 +6,10 @@
 
 #include <iostream>
 
-#include "util/StatefulTimer.h"
 #include "EasyCL.h"
 #include "clmath/GpuOp.h"
 #include "templates/LuaTemplater.h"
+#include "util/KernelCache.h"
 
 using namespace std;
 
@@ -20,7 +20,6 @@ using namespace std;
 
 /// \brief calculates destinationWrapper += deltaWrapper
 VIRTUAL void GpuOp::apply2_inplace(int N, CLWrapper*destinationWrapper, float scalar, Op2 *op) {
-    StatefulTimer::instance()->timeCheck("GpuOp::apply inplace start");
 
     string kernelName = "GpuOp::" + op->getName() + "_inplace_scalar";
     if(!cl->kernelExists(kernelName) ) {
@@ -37,10 +36,8 @@ VIRTUAL void GpuOp::apply2_inplace(int N, CLWrapper*destinationWrapper, float sc
     kernel->run_1d(numWorkgroups * workgroupSize, workgroupSize);
     cl->finish();
 
-    StatefulTimer::instance()->timeCheck("GpuOp::apply inplace end");
 }
 VIRTUAL void GpuOp::apply2_inplace(int N, CLWrapper*destinationWrapper, CLWrapper *deltaWrapper, Op2 *op) {
-    StatefulTimer::instance()->timeCheck("GpuOp::apply inplace start");
 
     string kernelName = "GpuOp::" + op->getName() + "_inplace";
     if(!cl->kernelExists(kernelName) ) {
@@ -57,10 +54,8 @@ VIRTUAL void GpuOp::apply2_inplace(int N, CLWrapper*destinationWrapper, CLWrappe
     kernel->run_1d(numWorkgroups * workgroupSize, workgroupSize);
     cl->finish();
 
-    StatefulTimer::instance()->timeCheck("GpuOp::apply inplace end");
 }
 VIRTUAL void GpuOp::apply2_outofplace(int N, CLWrapper*destinationWrapper, CLWrapper*one, CLWrapper *two, Op2 *op) {
-    StatefulTimer::instance()->timeCheck("GpuOp::apply inplace start");
 
     string kernelName = "GpuOp::" + op->getName() + "_outofplace";
     if(!cl->kernelExists(kernelName) ) {
@@ -78,10 +73,8 @@ VIRTUAL void GpuOp::apply2_outofplace(int N, CLWrapper*destinationWrapper, CLWra
     kernel->run_1d(numWorkgroups * workgroupSize, workgroupSize);
     cl->finish();
 
-    StatefulTimer::instance()->timeCheck("GpuOp::apply inplace end");
 }
 VIRTUAL void GpuOp::apply1_inplace(int N, CLWrapper*destinationWrapper, Op1 *op) {
-    StatefulTimer::instance()->timeCheck("GpuOp::apply inplace start");
 
     string kernelName = "GpuOp::" + op->getName() + "_inplace";
     if(!cl->kernelExists(kernelName) ) {
@@ -97,10 +90,8 @@ VIRTUAL void GpuOp::apply1_inplace(int N, CLWrapper*destinationWrapper, Op1 *op)
     kernel->run_1d(numWorkgroups * workgroupSize, workgroupSize);
     cl->finish();
 
-    StatefulTimer::instance()->timeCheck("GpuOp::apply inplace end");
 }
 VIRTUAL void GpuOp::apply1_outofplace(int N, CLWrapper*destinationWrapper, CLWrapper*one, Op1 *op) {
-    StatefulTimer::instance()->timeCheck("GpuOp::apply inplace start");
 
     string kernelName = "GpuOp::" + op->getName() + "_outofplace";
     if(!cl->kernelExists(kernelName) ) {
@@ -117,7 +108,6 @@ VIRTUAL void GpuOp::apply1_outofplace(int N, CLWrapper*destinationWrapper, CLWra
     kernel->run_1d(numWorkgroups * workgroupSize, workgroupSize);
     cl->finish();
 
-    StatefulTimer::instance()->timeCheck("GpuOp::apply inplace end");
 }
 VIRTUAL GpuOp::~GpuOp() {
 }
@@ -170,7 +160,7 @@ void GpuOp::buildKernel(std::string name, Op2 *op, bool inPlace) {
     if(inPlace) {
         clKernelName = "per_element_op2_inplace";
     }
-    kernel = cl->buildKernelFromString(renderedKernel, clKernelName, "", "cl/per_element_op2.cl");
+    kernel = KernelCache::buildKernelFromString(cl, renderedKernel, clKernelName, "", "cl/per_element_op2.cl");
     cl->storeKernel(name, kernel, true);
 }
 void GpuOp::buildKernel(std::string name, Op1 *op, bool inPlace) {
@@ -219,7 +209,7 @@ void GpuOp::buildKernel(std::string name, Op1 *op, bool inPlace) {
     if(inPlace) {
         clKernelName = "per_element_op1_inplace";
     }
-    kernel = cl->buildKernelFromString(renderedKernel, clKernelName, "", "cl/per_element_op1.cl");
+    kernel = KernelCache::buildKernelFromString(cl, renderedKernel, clKernelName, "", "cl/per_element_op1.cl");
     cl->storeKernel(name, kernel, true);
 }
 void GpuOp::buildKernelScalar(std::string name, Op2 *op, bool inPlace) {
@@ -268,7 +258,7 @@ void GpuOp::buildKernelScalar(std::string name, Op2 *op, bool inPlace) {
     if(inPlace) {
         clKernelName = "per_element_op2_inplace";
     }
-    kernel = cl->buildKernelFromString(renderedKernel, clKernelName, "", "cl/per_element_op2_scalar.cl");
+    kernel = KernelCache::buildKernelFromString(cl, renderedKernel, clKernelName, "", "cl/per_element_op2_scalar.cl");
     cl->storeKernel(name, kernel, true);
 }
 
@@ -7,9 +7,9 @@
 #include <iostream>
 
 #include "EasyCL.h"
-#include "util/StatefulTimer.h"
 #include "MultiplyBuffer.h"
 #include "util/stringhelper.h"
+#include "util/KernelCache.h"
 
 using namespace std;
 
@@ -19,7 +19,6 @@ using namespace std;
 #define VIRTUAL
 
 VIRTUAL void MultiplyBuffer::multiply(int N, float multiplier, CLWrapper *in, CLWrapper *out) {
-        StatefulTimer::instance()->timeCheck("MultiplyBuffer::multiply start");
 
     kernel  ->in(N)
             ->in(multiplier)
@@ -32,7 +31,6 @@ VIRTUAL void MultiplyBuffer::multiply(int N, float multiplier, CLWrapper *in, CL
     kernel->run_1d(numWorkgroups * workgroupSize, workgroupSize);
     cl->finish();
 
-    StatefulTimer::instance()->timeCheck("MultiplyBuffer::multiply end");
 }
 
 VIRTUAL MultiplyBuffer::~MultiplyBuffer() {
@@ -124,7 +122,7 @@ MultiplyBuffer::MultiplyBuffer(EasyCL *cl) :
     "}\n"
     "\n"
     "";
-    kernel = cl->buildKernelFromString(kernelSource, "multiplyConstant", options, "cl/copy.cl");
+    kernel = KernelCache::buildKernelFromString(cl, kernelSource, "multiplyConstant", options, "cl/copy.cl");
     // [[[end]]]
     cl->storeKernel(kernelName, kernel, true);
     this->kernel = kernel;
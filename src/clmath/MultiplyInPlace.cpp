@@ -7,9 +7,9 @@
 #include <iostream>
 
 #include "EasyCL.h"
-#include "util/StatefulTimer.h"
 #include "MultiplyInPlace.h"
 #include "util/stringhelper.h"
+#include "util/KernelCache.h"
 
 using namespace std;
 
@@ -20,7 +20,6 @@ using namespace std;
 
 /// \brief calculates data *= multiplier
 VIRTUAL void MultiplyInPlace::multiply(int N, float multiplier, CLWrapper *data) {
-        StatefulTimer::instance()->timeCheck("MultiplyInPlace::multiply start");
 
     kernel  ->in(N)
             ->in(multiplier)
@@ -32,7 +31,6 @@ VIRTUAL void MultiplyInPlace::multiply(int N, float multiplier, CLWrapper *data)
     kernel->run_1d(numWorkgroups * workgroupSize, workgroupSize);
     cl->finish();
 
-    StatefulTimer::instance()->timeCheck("MultiplyInPlace::multiply end");
 }
 VIRTUAL MultiplyInPlace::~MultiplyInPlace() {
 //    delete kernel;
@@ -112,7 +110,7 @@ MultiplyInPlace::MultiplyInPlace(EasyCL *cl) :
     "}\n"
     "\n"
     "";
-    kernel = cl->buildKernelFromString(kernelSource, "multiplyInplace", options, "cl/copy.cl");
+    kernel = KernelCache::buildKernelFromString(cl, kernelSource, "multiplyInplace", options, "cl/copy.cl");
     // [[[end]]]
     cl->storeKernel(kernelName, kernel, true);
     this->kernel = kernel;
@@ -6,8 +6,9 @@
 
 #include <iostream>
 
-#include "util/StatefulTimer.h"
 #include "conv/AddBias.h"
+#include "activate/ActivationFunction.h"
+#include "util/KernelCache.h"
 
 using namespace std;
 
@@ -18,28 +19,32 @@ using namespace std;
 
 VIRTUAL AddBias::~AddBias() {
 }
+// biasWrapper can be 0, if not biased
 VIRTUAL void AddBias::forward(
         int batchSize, int numFilters, int outputSize,
         CLWrapper *outputWrapper,
         CLWrapper *biasWrapper
             ) {
-    StatefulTimer::timeCheck("AddBias::forward begin");
 
     kernel->in(batchSize * numFilters * outputSize * outputSize)
         ->in(numFilters)
         ->in(outputSize * outputSize)
-        ->inout(outputWrapper)->in(biasWrapper);
+        ->inout(outputWrapper)->in(biasWrapper != 0 ? biasWrapper : outputWrapper); // not read, if not biased
     int globalSize = batchSize * numFilters * outputSize * outputSize;
     int workgroupSize = 64;
     int numWorkgroups = (globalSize + workgroupSize - 1) / workgroupSize;
     kernel->run_1d(numWorkgroups * workgroupSize, workgroupSize);
     cl->finish();
 
-    StatefulTimer::timeCheck("AddBias::forward after repeatedAdd");
 }
-AddBias::AddBias(EasyCL *cl) :
+// if dim.activation is set, the kernel applies it too, after the bias, if dim.biased
+AddBias::AddBias(EasyCL *cl, LayerDimensions dim) :
         cl(cl)
             {
+    if(dim.activation != 0) {
+        buildBiasActivate(dim);
+        return;
+    }
     string kernelName = "AddBias.per_element_add";
     if(cl->kernelExists(kernelName) ) {
         this->kernel = cl->getKernel(kernelName);
@@ -87,7 +92,99 @@ AddBias::AddBias(EasyCL *cl) :
     "}\n"
     "\n"
     "";
-    kernel = cl->buildKernelFromString(kernelSource, "repeated_add", options, "cl/per_element_add.cl");
+    kernel = KernelCache::buildKernelFromString(cl, kernelSource, "repeated_add", options, "cl/per_element_add.cl");
+    // [[[end]]]
+
+    cl->storeKernel(kernelName, kernel, true);
+}
+void AddBias::buildBiasActivate(LayerDimensions dim) {
+    std::string options = " -D " + std::string(dim.activation->getDefineName());
+    if(dim.biased) {
+        options += " -D BIASED";
+    }
+    string kernelName = "AddBias.bias_activate" + options;
+    if(cl->kernelExists(kernelName) ) {
+        this->kernel = cl->getKernel(kernelName);
+        return;
+    }
+
+    // [[[cog
+    // import stringify
+    // stringify.write_kernel2("kernel", "cl/bias_activate.cl", "bias_activate", 'options')
+    // ]]]
+    // generated using cog, from cl/bias_activate.cl:
+    const char * kernelSource =  
+    "// Copyright Hugh Perkins 2015 hughperkins at gmail\n"
+    "//\n"
+    "// This Source Code Form is subject to the terms of the Mozilla Public License,\n"
+    "// v. 2.0. If a copy of the MPL was not distributed with this file, You can\n"
+    "// obtain one at http://mozilla.org/MPL/2.0/.\n"
+    "\n"
+    "// expected defines:\n"
+    "// one of: [ TANH | RELU | LINEAR | SIGMOID | SCALEDTANH | ELU ]\n"
+    "// BIASED (optional)\n"
+    "\n"
+    "// including cl/activate_defines.cl:\n"
+    "// Copyright Hugh Perkins 2015 hughperkins at gmail\n"
+    "//\n"
+    "// This Source Code Form is subject to the terms of the Mozilla Public License,\n"
+    "// v. 2.0. If a copy of the MPL was not distributed with this file, You can\n"
+    "// obtain one at http://mozilla.org/MPL/2.0/.\n"
+    "\n"
+    "// ACTIVATION_FUNCTION, for kernels that fuse an activation into their output,\n"
+    "// and ACTIVATION_DERIV, its derivative, written in terms of that output, for\n"
+    "// kernels that fuse it into reading gradOutput;\n"
+    "// both left undefined if none of the activation defines is given\n"
+    "// one of: [ TANH | RELU | LINEAR | SIGMOID | SCALEDTANH | ELU ] (optional)\n"
+    "\n"
+    "#ifdef TANH\n"
+    "    #define ACTIVATION_FUNCTION(output) (tanh(output))\n"
+    "#elif defined SCALEDTANH\n"
+    "    #define ACTIVATION_FUNCTION(output) (1.7159f * tanh(0.66667f * output))\n"
+    "#elif defined SIGMOID\n"
+    "    #define ACTIVATION_FUNCTION(output) (1.0f / (1 + exp(-output)))\n"
+    "#elif defined RELU\n"
+    "    #define ACTIVATION_FUNCTION(output) (output> 0 ? output : 0)\n"
+    "#elif defined ELU\n"
+    "    #define ACTIVATION_FUNCTION(output) (output> 0 ? output : exp(output) - 1)\n"
+    "#elif defined LINEAR\n"
+    "    #define ACTIVATION_FUNCTION(output) (output)\n"
+    "#endif\n"
+    "\n"
+    "#ifdef TANH\n"
+    "    #define ACTIVATION_DERIV(output) (1 - output * output)\n"
+    "#elif defined SCALEDTANH\n"
+    "    #define ACTIVATION_DERIV(output) (0.66667f * (1.7159f - 1 / 1.7159f * output * output) )\n"
+    "#elif defined SIGMOID\n"
+    "    #define ACTIVATION_DERIV(output) (output * (1 - output) )\n"
+    "#elif defined RELU\n"
+    "    #define ACTIVATION_DERIV(output) (output > 0 ? 1 : 0)\n"
+    "#elif defined ELU\n"
+    "    #define ACTIVATION_DERIV(output) (output > 0 ? 1 : output + 1)\n"
+    "#elif defined LINEAR\n"
+    "    #define ACTIVATION_DERIV(output) (1.0f)\n"
+    "#endif\n"
+    "\n"
+    "\n"
+    "// the convolution's epilogue: adds the bias, if BIASED, then applies the\n"
+    "// activation, in one pass over the output, instead of one pass each\n"
+    "// same arguments as repeated_add, in per_element_add.cl\n"
+    "#ifdef ACTIVATION_FUNCTION // protect against not defined\n"
+    "kernel void bias_activate(const int N, const int numFilters, const int outputSizeSquared, global float *output, global const float *bias) {\n"
+    "    const int globalId = get_global_id(0);\n"
+    "    if (globalId >= N) {\n"
+    "        return;\n"
+    "    }\n"
+    "    float value = output[globalId];\n"
+    "    #ifdef BIASED\n"
+    "    value += bias[(globalId / outputSizeSquared) % numFilters];\n"
+    "    #endif\n"
+    "    output[globalId] = ACTIVATION_FUNCTION(value);\n"
+    "}\n"
+    "#endif\n"
+    "\n"
+    "";
+    kernel = KernelCache::buildKernelFromString(cl, kernelSource, "bias_activate", options, "cl/bias_activate.cl");
     // [[[end]]]
 
     cl->storeKernel(kernelName, kernel, true);
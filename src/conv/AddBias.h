@@ -12,12 +12,13 @@
 #include <algorithm>
 
 #include "EasyCL.h"
+#include "conv/LayerDimensions.h"
 
 #define VIRTUAL virtual
 #define STATIC static
 
 // adds bias, during forward propagation, after convolutional kernel has run
-// but before activation etc
+// if the layer's activation is fused, applies that too, in the same pass
 class AddBias {
 public:
     EasyCL *cl; // NOT delete
@@ -34,7 +35,8 @@ public:
     CLWrapper *outputWrapper,
     CLWrapper *biasWrapper
     );
-    AddBias(EasyCL *cl);
+    AddBias(EasyCL *cl, LayerDimensions dim);
+    void buildBiasActivate(LayerDimensions dim);
 
     // [[[end]]]
 };
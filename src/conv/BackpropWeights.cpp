@@ -6,7 +6,6 @@
 
 #include <algorithm>
 
-#include "util/StatefulTimer.h"
 
 #include "util/stringhelper.h"
 
@@ -17,6 +16,10 @@
 #include "BackpropWeightsScratchLarge.h"
 #include "BackpropWeightsIm2Col.h"
 #include "BackpropWeightsAuto.h"
+#include "BackpropWeightsFft.h"
+#include "FftConvolution.h"
+#include "activate/ActivationBackward.h"
+#include "util/WorkspaceScope.h"
 
 using namespace std;
 
@@ -29,7 +32,11 @@ using namespace std;
 BackpropWeights::BackpropWeights(EasyCL *cl, LayerDimensions layerDimensions) :
         cl(cl),
         dim(layerDimensions),
-        debug(false) {
+        debug(false),
+        activationDeriv(0) {
+}
+VIRTUAL BackpropWeights::~BackpropWeights() {
+    delete activationDeriv;
 }
 STATIC BackpropWeights *BackpropWeights::instance(EasyCL *cl, LayerDimensions dim) {
     return new BackpropWeightsAuto(cl, dim);
@@ -46,15 +53,19 @@ STATIC BackpropWeights *BackpropWeights::instance(EasyCL *cl, LayerDimensions di
 //    }
 }
 STATIC int BackpropWeights::getNumImplementations() {
-    return 5;
+    return 6;
 }
 STATIC bool BackpropWeights::plausiblyOptimal(int index, int batchSize, LayerDimensions dim) {
     if(index == 0) { 
         return false;
     }
-    if(index >= 5) {
+    if(index >= 6) {
         return false;
     }
+    if(index == 5) {
+        // fft only pays for its transforms with large filters
+        return FftConvolution::worthwhile(dim);
+    }
     return true;
 }
 STATIC BackpropWeights *BackpropWeights::instanceForTest(EasyCL *cl, LayerDimensions layerDimensions) {
@@ -79,11 +90,32 @@ STATIC BackpropWeights *BackpropWeights::instanceSpecific(int idx, EasyCL *cl, L
     if(idx == 4) {
         return new BackpropWeightsIm2Col(cl, layerDimensions);
     }
+    if(idx == 5) {
+        return new BackpropWeightsFft(cl, layerDimensions);
+    }
     throw std::runtime_error("BackpropWeights::instanceSpecific doesnt handle idx " + toString(idx));
 }
-
+/// \brief does calcGradWeightsThroughActivation apply the derivative as it reads gradOutput?
+///
+/// if not, ConvolutionalLayer applies it in a pass of its own, shared with
+/// Backward, and calls plain calcGradWeights
+VIRTUAL bool BackpropWeights::appliesActivationDeriv() {
+    return false;
+}
+/// \brief calcGradWeights, for a layer with a fused activation, ie dim.activation set
+///
+/// as Backward::backwardThroughActivation: gradOutput is the gradient of the
+/// post-activation output, which is in outputWrapper
+VIRTUAL void BackpropWeights::calcGradWeightsThroughActivation(int batchSize, CLWrapper *gradOutputWrapper, CLWrapper *outputWrapper, CLWrapper *inputsWrapper, CLWrapper *gradWeightsWrapper, CLWrapper *gradBiasWrapper) {
+    if(activationDeriv == 0) {
+        activationDeriv = ActivationBackward::instance(cl, dim.numFilters, dim.outputSize, dim.activation);
+    }
+    WorkspaceScope workspace(cl);
+    CLWrapper *gradPreActivationWrapper = workspace.acquire(batchSize * dim.outputCubeSize);
+    activationDeriv->backward(batchSize, outputWrapper, gradOutputWrapper, gradPreActivationWrapper);
+    calcGradWeights(batchSize, gradPreActivationWrapper, inputsWrapper, gradWeightsWrapper, gradBiasWrapper);
+}
 VIRTUAL void BackpropWeights::calcGradWeights(int batchSize, float *gradOutput, float *inputs, float *gradWeights, float *gradBias) {
-    StatefulTimer::timeCheck("BackpropWeights::backprop begin");
 
 //    const float learningMultiplier = learningRate / batchSize / sqrt(dim.outputSize * dim.outputSize);
 
@@ -106,14 +138,11 @@ VIRTUAL void BackpropWeights::calcGradWeights(int batchSize, float *gradOutput,
         gradBiasWrapper->copyToDevice();
     }
 
-    StatefulTimer::timeCheck("BackpropWeights::backprop after copied to device");
     calcGradWeights(batchSize, gradOutputWrapper, inputDataWrapper, gradWeightsWrapper, gradBiasWrapper);
-    StatefulTimer::timeCheck("BackpropWeights::backprop after call backprop");
     gradWeightsWrapper->copyToHost();
     if(dim.biased) {
         gradBiasWrapper->copyToHost();
     }
-    StatefulTimer::timeCheck("BackpropWeights::backprop after copytohost");
 
     delete gradOutputWrapper;
     delete inputDataWrapper;
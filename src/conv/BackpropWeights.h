@@ -17,13 +17,15 @@
 #define STATIC static
 #define VIRTUAL virtual
 
+class ActivationBackward;
+
 class DeepCL_EXPORT BackpropWeights {
 public:
     EasyCL *cl;
     LayerDimensions dim;
     bool debug; // = false;
+    ActivationBackward *activationDeriv; // for calcGradWeightsThroughActivation, made on first use
 
-    virtual ~BackpropWeights() {}
     virtual void calcGradWeights(int batchSize, CLWrapper *gradOutputWrapper, CLWrapper *inputsWrapper, CLWrapper *gradWeightsWrapper, CLWrapper *gradBiasWrapper) = 0;
 
     // [[[cog
@@ -32,11 +34,14 @@ public:
     // ]]]
     // generated, using cog:
     BackpropWeights(EasyCL *cl, LayerDimensions layerDimensions);
+    VIRTUAL ~BackpropWeights();
     STATIC BackpropWeights *instance(EasyCL *cl, LayerDimensions dim);
     STATIC int getNumImplementations();
     STATIC bool plausiblyOptimal(int index, int batchSize, LayerDimensions dim);
     STATIC BackpropWeights *instanceForTest(EasyCL *cl, LayerDimensions layerDimensions);
     STATIC BackpropWeights *instanceSpecific(int idx, EasyCL *cl, LayerDimensions layerDimensions);
+    VIRTUAL bool appliesActivationDeriv();
+    VIRTUAL void calcGradWeightsThroughActivation(int batchSize, CLWrapper *gradOutputWrapper, CLWrapper *outputWrapper, CLWrapper *inputsWrapper, CLWrapper *gradWeightsWrapper, CLWrapper *gradBiasWrapper);
     VIRTUAL void calcGradWeights(int batchSize, float *gradOutput, float *inputs, float *gradWeights, float *gradBias);
     float learningRateToMultiplier(int batchSize);
 
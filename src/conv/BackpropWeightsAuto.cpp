@@ -10,8 +10,9 @@
 
 #include "conv/BackpropWeightsAuto.h"
 #include "util/stringhelper.h"
-#include "util/StatefulTimer.h"
+#include "util/Profiler.h"
 #include "util/Timer.h"
+#include "conv/TuningCache.h"
 
 using namespace std;
 
@@ -46,9 +47,54 @@ VIRTUAL BackpropWeightsAuto::~BackpropWeightsAuto() {
         }
     }
 }
+// if a previous run already tuned this layer, on this device, go straight
+// to the kernel it picked.  Returns false if we need to tune
+bool BackpropWeightsAuto::useCachedChoice(int batchSize) {
+    cacheKey = TuningCache::makeKey("backpropweights", num, cl, dim, batchSize);
+    int index = -1;
+    int cachedMilliseconds = -1;
+    if(!TuningCache::instance()->lookup(cacheKey, &index, &cachedMilliseconds) || index < 0 || index >= num) {
+        return false;
+    }
+    try {
+        instances[index] = BackpropWeights::instanceSpecific(index, cl, dim);
+    } catch(runtime_error &e) {
+        cout << Profiler::layerPrefix() << "BackpropWeightsAuto: cached kernel " << index << " cant be used: " << e.what() << ", retuning" << endl;
+        return false;
+    }
+    valid[index] = true;
+    milliseconds[index] = cachedMilliseconds;
+    nextIndex = num;
+    this->chosenIndex = index;
+    cout << Profiler::layerPrefix() << "   backpropweights layer using cached kernel " << index << endl;
+    return true;
+}
+void BackpropWeightsAuto::choose(int index) {
+    this->chosenIndex = index;
+    if(cacheKey != "") {
+        TuningCache::instance()->store(cacheKey, index, milliseconds[index]);
+    }
+}
+/// till we've chosen, each tuning run goes to the candidate's own calcGradWeightsThroughActivation
+VIRTUAL bool BackpropWeightsAuto::appliesActivationDeriv() {
+    if(chosenIndex == -1) {
+        return true;
+    }
+    return instances[chosenIndex]->appliesActivationDeriv();
+}
 VIRTUAL void BackpropWeightsAuto::calcGradWeights(
         int batchSize, CLWrapper *inputDataWrapper, CLWrapper *gradOutput, CLWrapper *weightsWrapper,
         CLWrapper *gradInput) {
+    run(batchSize, inputDataWrapper, 0, gradOutput, weightsWrapper, gradInput);
+}
+VIRTUAL void BackpropWeightsAuto::calcGradWeightsThroughActivation(int batchSize, CLWrapper *gradOutputWrapper, CLWrapper *outputWrapper, CLWrapper *inputsWrapper, CLWrapper *gradWeightsWrapper, CLWrapper *gradBiasWrapper) {
+    run(batchSize, gradOutputWrapper, outputWrapper, inputsWrapper, gradWeightsWrapper, gradBiasWrapper);
+}
+// tunes, or uses the chosen instance; outputWrapper is 0 for plain calcGradWeights
+void BackpropWeightsAuto::run(int batchSize, CLWrapper *gradOutputWrapper, CLWrapper *outputWrapper, CLWrapper *inputsWrapper, CLWrapper *gradWeightsWrapper, CLWrapper *gradBiasWrapper) {
+    if(chosenIndex == -1 && nextIndex == 0) {
+        useCachedChoice(batchSize);
+    }
     while(chosenIndex == -1 && nextIndex < num) {
         int thisIndex = nextIndex;
         nextIndex++;
@@ -61,22 +107,22 @@ VIRTUAL void BackpropWeightsAuto::calcGradWeights(
                 valid[thisIndex] = true;
                 cout << "   ... seems valid" << endl;
             } catch(runtime_error &e) {
-                cout << StatefulTimer::instance()->prefix << "BackpropWeightsAuto: kernel " << thisIndex << ": this instance cant be used: " << e.what() << endl;
+                cout << Profiler::layerPrefix() << "BackpropWeightsAuto: kernel " << thisIndex << ": this instance cant be used: " << e.what() << endl;
                 valid[thisIndex] = false;
             }
             if(valid[thisIndex]) {
                 Timer timer;
                 try {
-                    candidate->calcGradWeights(batchSize, inputDataWrapper, gradOutput, weightsWrapper, gradInput);
+                    runInstance(candidate, batchSize, gradOutputWrapper, outputWrapper, inputsWrapper, gradWeightsWrapper, gradBiasWrapper);
                     milliseconds[thisIndex] = (int)timer.lap();
-                    cout << StatefulTimer::instance()->prefix << "BackpropWeightsAuto: kernel " << thisIndex << " " << milliseconds[thisIndex] << "ms" << endl;
+                    cout << Profiler::layerPrefix() << "BackpropWeightsAuto: kernel " << thisIndex << " " << milliseconds[thisIndex] << "ms" << endl;
                     if (milliseconds[thisIndex] == 0) { //we can't get better time, use this instance
                         cout << "   calcGradWeights layer selected kernel with zero time" << thisIndex << endl;
-                        this->chosenIndex = thisIndex;
+                        choose(thisIndex);
                     }
                     return;
                 } catch(runtime_error &e) {
-                    cout << StatefulTimer::instance()->prefix << "BackpropWeightsAuto: kernel " << thisIndex << " this instance cant be used: " << e.what() << endl;
+                    cout << Profiler::layerPrefix() << "BackpropWeightsAuto: kernel " << thisIndex << " this instance cant be used: " << e.what() << endl;
                     valid[thisIndex] = false;
                     delete instances[thisIndex];
                     instances[thisIndex] = 0;
@@ -89,7 +135,7 @@ VIRTUAL void BackpropWeightsAuto::calcGradWeights(
         }
     }
     if(chosenIndex == -1) {
-//        cout << StatefulTimer::instance()->prefix + "BackpropWeightsAuto::calcGradWeights choosing best instance:" << endl;
+//        cout << Profiler::layerPrefix() + "BackpropWeightsAuto::calcGradWeights choosing best instance:" << endl;
         int bestIndex = -1;
         int bestTime = 0;
         for(int i = 0; i < num; i++) {
@@ -110,12 +156,19 @@ VIRTUAL void BackpropWeightsAuto::calcGradWeights(
         }
         if(bestIndex != -1) {
             cout << "   calcGradWeights layer selected kernel " << bestIndex << endl;
-            this->chosenIndex = bestIndex;
+            choose(bestIndex);
         } else {
-            throw runtime_error(StatefulTimer::instance()->prefix + "No valid calcGradWeights implementations found");
+            throw runtime_error(Profiler::layerPrefix() + "No valid calcGradWeights implementations found");
         }
     }
 //    cout << "BackpropWeightsAuto::calcGradWeights using instance index: " << chosenIndex << endl;
-    instances[chosenIndex]->calcGradWeights(batchSize, inputDataWrapper, gradOutput, weightsWrapper, gradInput);
+    runInstance(instances[chosenIndex], batchSize, gradOutputWrapper, outputWrapper, inputsWrapper, gradWeightsWrapper, gradBiasWrapper);
+}
+void BackpropWeightsAuto::runInstance(BackpropWeights *instance, int batchSize, CLWrapper *gradOutputWrapper, CLWrapper *outputWrapper, CLWrapper *inputsWrapper, CLWrapper *gradWeightsWrapper, CLWrapper *gradBiasWrapper) {
+    if(outputWrapper == 0) {
+        instance->calcGradWeights(batchSize, gradOutputWrapper, inputsWrapper, gradWeightsWrapper, gradBiasWrapper);
+    } else {
+        instance->calcGradWeightsThroughActivation(batchSize, gradOutputWrapper, outputWrapper, inputsWrapper, gradWeightsWrapper, gradBiasWrapper);
+    }
 }
 
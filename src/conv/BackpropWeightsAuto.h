@@ -37,6 +37,7 @@ public:
     int chosenIndex;
     BackpropWeights **instances;
     int nextIndex;
+    std::string cacheKey;
 
     // [[[cog
     // import cog_addheaders
@@ -45,9 +46,15 @@ public:
     // generated, using cog:
     BackpropWeightsAuto(EasyCL *cl, LayerDimensions dim);
     VIRTUAL ~BackpropWeightsAuto();
+    bool useCachedChoice(int batchSize);
+    void choose(int index);
+    VIRTUAL bool appliesActivationDeriv();
     VIRTUAL void calcGradWeights(
     int batchSize, CLWrapper *inputDataWrapper, CLWrapper *gradOutput, CLWrapper *weightsWrapper,
     CLWrapper *gradInput);
+    VIRTUAL void calcGradWeightsThroughActivation(int batchSize, CLWrapper *gradOutputWrapper, CLWrapper *outputWrapper, CLWrapper *inputsWrapper, CLWrapper *gradWeightsWrapper, CLWrapper *gradBiasWrapper);
+    void run(int batchSize, CLWrapper *gradOutputWrapper, CLWrapper *outputWrapper, CLWrapper *inputsWrapper, CLWrapper *gradWeightsWrapper, CLWrapper *gradBiasWrapper);
+    void runInstance(BackpropWeights *instance, int batchSize, CLWrapper *gradOutputWrapper, CLWrapper *outputWrapper, CLWrapper *inputsWrapper, CLWrapper *gradWeightsWrapper, CLWrapper *gradBiasWrapper);
 
     // [[[end]]]
 
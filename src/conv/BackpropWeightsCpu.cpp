@@ -5,7 +5,6 @@
 // obtain one at http://mozilla.org/MPL/2.0/.
 
 #include "BackpropWeightsCpu.h"
-#include "util/StatefulTimer.h"
 #include "util/stringhelper.h"
 
 using namespace std;
@@ -40,7 +39,6 @@ VIRTUAL void BackpropWeightsCpu::calcGradWeights(int batchSize, CLWrapper *gradO
 VIRTUAL void BackpropWeightsCpu::calcGradWeights(int batchSize, float *gradOutput,
     float *inputs, float *gradWeights, float *gradBias) {
 
-    StatefulTimer::instance()->timeCheck(" calcGradWeightsCpu start");
 
     const float learningMultiplier = learningRateToMultiplier(batchSize);
 
@@ -95,6 +93,5 @@ VIRTUAL void BackpropWeightsCpu::calcGradWeights(int batchSize, float *gradOutpu
             }
         }
     }
-    StatefulTimer::instance()->timeCheck(" calcGradWeightsCpu end");
 }
 
@@ -0,0 +1,56 @@
+// Copyright Hugh Perkins 2015 hughperkins at gmail
+//
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file, You can
+// obtain one at http://mozilla.org/MPL/2.0/.
+
+#include "EasyCL.h"
+#include "clblas/ClBlasHelper.h"
+#include "clmath/CLMathWrapper.h"
+#include "util/WorkspaceScope.h"
+#include "conv/FftConvolution.h"
+
+#include "conv/BackpropWeightsFft.h"
+
+using namespace std;
+
+#undef VIRTUAL
+#undef STATIC
+#define VIRTUAL
+#define STATIC
+#define PUBLIC
+
+PUBLIC BackpropWeightsFft::BackpropWeightsFft(EasyCL *cl, LayerDimensions dim) :
+        BackpropWeights(cl, dim) {
+    fft = new FftConvolution(cl, dim);
+}
+PUBLIC VIRTUAL BackpropWeightsFft::~BackpropWeightsFft() {
+    delete fft;
+}
+PUBLIC VIRTUAL void BackpropWeightsFft::calcGradWeights(int batchSize, CLWrapper *gradOutputWrapper, CLWrapper *inputWrapper, CLWrapper *gradWeightsWrapper, CLWrapper *gradBiasWrapper) {
+    fft->calcGradWeights(batchSize, gradOutputWrapper, inputWrapper, gradWeightsWrapper);
+    if(!dim.biased) {
+        return;
+    }
+    // gradBias is the sum of each gradOutput plane, as for im2col
+    WorkspaceScope workspace(cl);
+    int onesSize = dim.outputSizeSquared;
+    CLWrapper *onesWrapper = workspace.acquire(onesSize);
+    CLMathWrapper ones_(onesWrapper, onesSize);
+    ones_ = 1.0f;
+    CLMathWrapper gradBias_(gradBiasWrapper);
+    gradBias_ = 0.0f;
+    for(int b = 0; b < batchSize; b++) {
+        ClBlasHelper::Gemv(
+            cl,
+            clblasColumnMajor,
+            clblasTrans,
+            dim.outputSizeSquared, dim.numFilters,
+            1,
+            gradOutputWrapper, b * dim.outputCubeSize,
+            onesWrapper, 0,
+            1,
+            gradBiasWrapper, 0
+        );
+    }
+}
@@ -0,0 +1,38 @@
+// Copyright Hugh Perkins 2015 hughperkins at gmail
+//
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file, You can
+// obtain one at http://mozilla.org/MPL/2.0/.
+
+#pragma once
+
+#include "BackpropWeights.h"
+
+class FftConvolution;
+
+#include "DeepCLDllExport.h"
+
+#define VIRTUAL virtual
+#define STATIC static
+
+// fft convolution on the gpu, see FftConvolution.h
+// the spectra of each image are summed before the single inverse fft per
+// [filter][inputPlane]
+class DeepCL_EXPORT BackpropWeightsFft : public BackpropWeights {
+    private:
+    FftConvolution *fft;
+
+    // [[[cog
+    // import cog_addheaders
+    // cog_addheaders.addv2()
+    // ]]]
+    // generated, using cog:
+
+    public:
+    BackpropWeightsFft(EasyCL *cl, LayerDimensions dim);
+    VIRTUAL ~BackpropWeightsFft();
+    VIRTUAL void calcGradWeights(int batchSize, CLWrapper *gradOutputWrapper, CLWrapper *inputWrapper, CLWrapper *gradWeightsWrapper, CLWrapper *gradBiasWrapper);
+
+    // [[[end]]]
+};
+
@@ -1,6 +1,5 @@
 #include "EasyCL.h"
 #include "util/stringhelper.h"
-#include "util/StatefulTimer.h"
 
 #include <sstream>
 #include <iostream>
@@ -10,6 +9,7 @@
 #include "clblas/ClBlasHelper.h"
 #include "BackpropWeightsIm2Col.h"
 #include "conv/Im2Col.h"
+#include "util/WorkspaceScope.h"
 #include "clmath/CLMathWrapper.h"
 
 using namespace std;
@@ -37,24 +37,19 @@ PUBLIC VIRTUAL BackpropWeightsIm2Col::~BackpropWeightsIm2Col() {
 }
 //int batchSize, CLWrapper *gradOutputWrapper, CLWrapper *imagesWrapper, CLWrapper *gradWeightsWrapper, CLWrapper *gradBiasWrapper
 PUBLIC VIRTUAL void BackpropWeightsIm2Col::calcGradWeights(int batchSize, CLWrapper *gradOutputWrapper, CLWrapper *inputWrapper, CLWrapper *gradWeightsWrapper, CLWrapper *gradBiasWrapper) {
-    StatefulTimer::timeCheck("BackpropWeightsIm2Col::calcGradWeights START");
 
     int columnsSize = dim.inputPlanes * dim.filterSizeSquared * dim.outputSizeSquared;
-    float *columns = new float[columnsSize];
-    CLWrapper *columnsWrapper = cl->wrap(columnsSize, columns);
-    columnsWrapper->createOnDevice();
+    WorkspaceScope workspace(cl);
+    CLWrapper *columnsWrapper = workspace.acquire(columnsSize);
 
     int onesSize = dim.outputSizeSquared;
-    float *ones = new float[onesSize];
-    CLWrapper *onesWrapper = cl->wrap(onesSize, ones);
-    onesWrapper->createOnDevice();
-    CLMathWrapper ones_(onesWrapper);
+    CLWrapper *onesWrapper = workspace.acquire(onesSize);
+    CLMathWrapper ones_(onesWrapper, onesSize);
     ones_ = 1.0f;
 
 //    cout << "gradColumnsSize: " << gradColumnsSize << endl;
 //    cout << "weightsize: " << weightsWrapper->size() << endl;
 
-    StatefulTimer::timeCheck("BackpropWeightsIm2Col::calcGradWeights after alloc");
 
     CLMathWrapper gradWeights_(gradWeightsWrapper);
     gradWeights_ = 0.0f;
@@ -102,14 +97,6 @@ PUBLIC VIRTUAL void BackpropWeightsIm2Col::calcGradWeights(int batchSize, CLWrap
         }
     }
 
-    delete onesWrapper;
-    delete[] ones;
 
-    delete columnsWrapper;
-    delete[] columns;
-
-    StatefulTimer::timeCheck("BackpropWeightsIm2Col::calcGradWeights after call calcGradWeights");
-
-    StatefulTimer::timeCheck("BackpropWeightsIm2Col::calcGradWeights END");
 }
 
@@ -4,9 +4,11 @@
 // v. 2.0. If a copy of the MPL was not distributed with this file, You can 
 // obtain one at http://mozilla.org/MPL/2.0/.
 
+#include <stdexcept>
+
 #include "BackpropWeightsNaive.h"
-#include "util/StatefulTimer.h"
 #include "util/stringhelper.h"
+#include "util/KernelCache.h"
 
 using namespace std;
 
@@ -21,14 +23,27 @@ VIRTUAL BackpropWeightsNaive::~BackpropWeightsNaive() {
     delete kernel;
 }
 VIRTUAL void BackpropWeightsNaive::calcGradWeights(int batchSize, CLWrapper *gradOutputWrapper, CLWrapper *imagesWrapper, CLWrapper *gradWeightsWrapper, CLWrapper *gradBiasWrapper) {
-    StatefulTimer::instance()->timeCheck("BackpropWeightsNaive start");
+    if(dim.activation != 0) {
+        throw runtime_error("BackpropWeightsNaive: built for a fused activation, so needs calcGradWeightsThroughActivation");
+    }
+    calcGradWeightsThroughActivation(batchSize, gradOutputWrapper, 0, imagesWrapper, gradWeightsWrapper, gradBiasWrapper);
+}
+VIRTUAL bool BackpropWeightsNaive::appliesActivationDeriv() {
+    return true;
+}
+/// the derivative is applied as backprop_floats reads gradOutput
+VIRTUAL void BackpropWeightsNaive::calcGradWeightsThroughActivation(int batchSize, CLWrapper *gradOutputWrapper, CLWrapper *outputWrapper, CLWrapper *imagesWrapper, CLWrapper *gradWeightsWrapper, CLWrapper *gradBiasWrapper) {
 
     const float learningMultiplier = learningRateToMultiplier(batchSize);
 
     kernel
        ->in(learningMultiplier)
        ->in(batchSize)
-       ->in(gradOutputWrapper)
+       ->in(gradOutputWrapper);
+    if(dim.activation != 0) {
+        kernel->in(outputWrapper);
+    }
+    kernel
         ->in(imagesWrapper)
        ->inout(gradWeightsWrapper);
     if(dim.biased) {
@@ -42,12 +57,14 @@ VIRTUAL void BackpropWeightsNaive::calcGradWeights(int batchSize, CLWrapper *gra
 
     cl->finish();
 
-    StatefulTimer::instance()->timeCheck("BackpropWeightsNaive end");
 }
 BackpropWeightsNaive::BackpropWeightsNaive(EasyCL *cl, LayerDimensions dim) :
         BackpropWeights(cl, dim)
             {
     std::string options = dim.buildOptionsString();
+    if(dim.activation != 0) {
+        options += " -D " + string(dim.activation->getDefineName());
+    }
 
     // [[[cog
     // import stringify
@@ -63,12 +80,60 @@ BackpropWeightsNaive::BackpropWeightsNaive(EasyCL *cl, LayerDimensions dim) :
     "\n"
     "// expected defines:\n"
     "// BIASED (or not)\n"
+    "// one of: [ TANH | RELU | LINEAR | SIGMOID | SCALEDTANH | ELU ] (optional)\n"
+    "//   for a layer with a fused activation, see backward.cl\n"
+    "\n"
+    "// including cl/activate_defines.cl:\n"
+    "// Copyright Hugh Perkins 2015 hughperkins at gmail\n"
+    "//\n"
+    "// This Source Code Form is subject to the terms of the Mozilla Public License,\n"
+    "// v. 2.0. If a copy of the MPL was not distributed with this file, You can\n"
+    "// obtain one at http://mozilla.org/MPL/2.0/.\n"
+    "\n"
+    "// ACTIVATION_FUNCTION, for kernels that fuse an activation into their output,\n"
+    "// and ACTIVATION_DERIV, its derivative, written in terms of that output, for\n"
+    "// kernels that fuse it into reading gradOutput;\n"
+    "// both left undefined if none of the activation defines is given\n"
+    "// one of: [ TANH | RELU | LINEAR | SIGMOID | SCALEDTANH | ELU ] (optional)\n"
+    "\n"
+    "#ifdef TANH\n"
+    "    #define ACTIVATION_FUNCTION(output) (tanh(output))\n"
+    "#elif defined SCALEDTANH\n"
+    "    #define ACTIVATION_FUNCTION(output) (1.7159f * tanh(0.66667f * output))\n"
+    "#elif defined SIGMOID\n"
+    "    #define ACTIVATION_FUNCTION(output) (1.0f / (1 + exp(-output)))\n"
+    "#elif defined RELU\n"
+    "    #define ACTIVATION_FUNCTION(output) (output> 0 ? output : 0)\n"
+    "#elif defined ELU\n"
+    "    #define ACTIVATION_FUNCTION(output) (output> 0 ? output : exp(output) - 1)\n"
+    "#elif defined LINEAR\n"
+    "    #define ACTIVATION_FUNCTION(output) (output)\n"
+    "#endif\n"
+    "\n"
+    "#ifdef TANH\n"
+    "    #define ACTIVATION_DERIV(output) (1 - output * output)\n"
+    "#elif defined SCALEDTANH\n"
+    "    #define ACTIVATION_DERIV(output) (0.66667f * (1.7159f - 1 / 1.7159f * output * output) )\n"
+    "#elif defined SIGMOID\n"
+    "    #define ACTIVATION_DERIV(output) (output * (1 - output) )\n"
+    "#elif defined RELU\n"
+    "    #define ACTIVATION_DERIV(output) (output > 0 ? 1 : 0)\n"
+    "#elif defined ELU\n"
+    "    #define ACTIVATION_DERIV(output) (output > 0 ? 1 : output + 1)\n"
+    "#elif defined LINEAR\n"
+    "    #define ACTIVATION_DERIV(output) (1.0f)\n"
+    "#endif\n"
+    "\n"
     "\n"
     "// globalId: [outPlane][inputPlane][filterRow][filterCol]\n"
     "// per-thread iteration: [n][outputRow][outputCol]\n"
     "void kernel backprop_floats(const float learningRateMultiplier,\n"
     "        const int batchSize,\n"
-    "         global const float *gradOutput, global const float *images,\n"
+    "         global const float *gradOutput,\n"
+    "#ifdef ACTIVATION_DERIV\n"
+    "         global const float *output,\n"
+    "#endif\n"
+    "         global const float *images,\n"
     "        global float *gradWeights\n"
     "        #ifdef BIASED\n"
     "            , global float *gradBiasWeights\n"
@@ -106,6 +171,9 @@ BackpropWeightsNaive::BackpropWeightsNaive(EasyCL *cl, LayerDimensions dim) :
     "                              + outRow) * gOutputSize\n"
     "                              + outCol;\n"
     "                    float error = gradOutput[resultIndex];\n"
+    "#ifdef ACTIVATION_DERIV\n"
+    "                    error *= ACTIVATION_DERIV(output[resultIndex]);\n"
+    "#endif\n"
     "                    int upstreamDataIndex = (( n * gInputPlanes\n"
     "                                     + upstreamPlane) * gInputSize\n"
     "                                     + upstreamRow) * gInputSize\n"
@@ -134,7 +202,7 @@ BackpropWeightsNaive::BackpropWeightsNaive(EasyCL *cl, LayerDimensions dim) :
     "\n"
     "\n"
     "";
-    kernel = cl->buildKernelFromString(kernelSource, "backprop_floats", options, "cl/backpropweights.cl");
+    kernel = KernelCache::buildKernelFromString(cl, kernelSource, "backprop_floats", options, "cl/backpropweights.cl");
     // [[[end]]]
 }
 
@@ -22,6 +22,8 @@ public:
     // generated, using cog:
     VIRTUAL ~BackpropWeightsNaive();
     VIRTUAL void calcGradWeights(int batchSize, CLWrapper *gradOutputWrapper, CLWrapper *imagesWrapper, CLWrapper *gradWeightsWrapper, CLWrapper *gradBiasWrapper);
+    VIRTUAL bool appliesActivationDeriv();
+    VIRTUAL void calcGradWeightsThroughActivation(int batchSize, CLWrapper *gradOutputWrapper, CLWrapper *outputWrapper, CLWrapper *imagesWrapper, CLWrapper *gradWeightsWrapper, CLWrapper *gradBiasWrapper);
     BackpropWeightsNaive(EasyCL *cl, LayerDimensions dim);
 
     // [[[end]]]
@@ -7,8 +7,8 @@
 #include <algorithm>
 
 #include "BackpropWeightsScratch.h"
-#include "util/StatefulTimer.h"
 #include "util/stringhelper.h"
+#include "util/KernelCache.h"
 
 using namespace std;
 
@@ -22,7 +22,6 @@ VIRTUAL BackpropWeightsScratch::~BackpropWeightsScratch() {
     delete kernel;
 }
 VIRTUAL void BackpropWeightsScratch::calcGradWeights(int batchSize, CLWrapper *gradOutputWrapper, CLWrapper *imagesWrapper, CLWrapper *gradWeightsWrapper, CLWrapper *gradBiasWrapper) {
-    StatefulTimer::instance()->timeCheck("BackpropWeightsScratch start");
 
     int workgroupsize = std::max(32, square(dim.filterSize) ); // no point in wasting cores...
     int numWorkgroups = dim.inputPlanes * dim.numFilters;
@@ -55,7 +54,6 @@ VIRTUAL void BackpropWeightsScratch::calcGradWeights(int batchSize, CLWrapper *g
 
     cl->finish();
 
-    StatefulTimer::instance()->timeCheck("BackpropWeightsScratch end");
 }
 BackpropWeightsScratch::BackpropWeightsScratch(EasyCL *cl, LayerDimensions dim) :
         BackpropWeights(cl, dim)
@@ -191,7 +189,7 @@ BackpropWeightsScratch::BackpropWeightsScratch(EasyCL *cl, LayerDimensions dim)
     "}\n"
     "\n"
     "";
-    kernel = cl->buildKernelFromString(kernelSource, "backprop_floats_withscratch_dobias", options, "cl/BackpropWeightsScratch.cl");
+    kernel = KernelCache::buildKernelFromString(cl, kernelSource, "backprop_floats_withscratch_dobias", options, "cl/BackpropWeightsScratch.cl");
     // [[[end]]]
 //    kernel = cl->buildKernel("backpropgradWeights2.cl", "backprop_floats_withscratch_dobias", options);
 //    kernel = cl->buildKernelFromString(kernelSource, "calcGradInput", options);
@@ -7,8 +7,8 @@
 #include <algorithm>
 
 #include "BackpropWeightsScratchLarge.h"
-#include "util/StatefulTimer.h"
 #include "util/stringhelper.h"
+#include "util/KernelCache.h"
 
 using namespace std;
 
@@ -22,7 +22,6 @@ VIRTUAL BackpropWeightsScratchLarge::~BackpropWeightsScratchLarge() {
     delete kernel;
 }
 VIRTUAL void BackpropWeightsScratchLarge::calcGradWeights(int batchSize, CLWrapper *gradOutputWrapper, CLWrapper *imagesWrapper, CLWrapper *gradWeightsWrapper, CLWrapper *gradBiasWrapper) {
-    StatefulTimer::instance()->timeCheck("BackpropWeightsScratchLarge start");
 
     int workgroupSize = 32 * (( square(dim.filterSize) + 32 - 1) / 32); // quantize to nearest 32
 //    int workgroupsize = std::max(32, square(dim.filterSize) ); // no point in wasting cores...
@@ -50,7 +49,6 @@ VIRTUAL void BackpropWeightsScratchLarge::calcGradWeights(int batchSize, CLWrapp
 
     cl->finish();
 
-    StatefulTimer::instance()->timeCheck("BackpropWeightsScratchLarge end");
 }
 BackpropWeightsScratchLarge::BackpropWeightsScratchLarge(EasyCL *cl, LayerDimensions dim) :
         BackpropWeights(cl, dim)
@@ -263,7 +261,7 @@ BackpropWeightsScratchLarge::BackpropWeightsScratchLarge(EasyCL *cl, LayerDimens
     "}\n"
     "\n"
     "";
-    kernel = cl->buildKernelFromString(kernelSource, "backprop_floats_withscratch_dobias_striped", options, "cl/BackpropWeightsScratchLarge.cl");
+    kernel = KernelCache::buildKernelFromString(cl, kernelSource, "backprop_floats_withscratch_dobias_striped", options, "cl/BackpropWeightsScratchLarge.cl");
     // [[[end]]]
 }
 
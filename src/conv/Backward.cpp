@@ -6,7 +6,6 @@
 
 #include <algorithm>
 
-#include "util/StatefulTimer.h"
 #include "util/stringhelper.h"
 
 #include "BackwardAuto.h"
@@ -14,6 +13,13 @@
 #include "BackwardGpuNaive.h"
 #include "BackwardGpuCached.h"
 #include "BackwardIm2Col.h"
+#include "BackwardWinograd.h"
+#include "BackwardWinogradCpu.h"
+#include "Winograd.h"
+#include "BackwardFft.h"
+#include "FftConvolution.h"
+#include "activate/ActivationBackward.h"
+#include "util/WorkspaceScope.h"
 
 #include "Backward.h"
 
@@ -52,26 +58,72 @@ STATIC Backward *Backward::instanceSpecific(int idx, EasyCL *cl, LayerDimensions
     if(idx == 3) {
         return new BackwardIm2Col(cl, layerDimensions);
     }
+    if(idx == 4) {
+        return new BackwardWinograd(cl, layerDimensions);
+    }
+    if(idx == 5) {
+        return new BackwardWinogradCpu(cl, layerDimensions);
+    }
+    if(idx == 6) {
+        return new BackwardFft(cl, layerDimensions);
+    }
     throw std::runtime_error("backproperrorsv2::isntancespecifc, index not known: " + toString(idx));
 }
 Backward::Backward(EasyCL *cl, LayerDimensions layerDimensions) :
         cl(cl),
-        dim(layerDimensions) {
+        dim(layerDimensions),
+        filterCache(0),
+        activationDeriv(0) {
+}
+VIRTUAL Backward::~Backward() {
+    delete activationDeriv;
 }
 STATIC int Backward::getNumImplementations() {
-    return 4;
+    return 7;
 }
 STATIC bool Backward::plausiblyOptimal(int index, int batchSize, LayerDimensions dim) {
     if(index == 0) { 
         return false;
     }
-    if(index >= 4) {
+    if(index >= 7) {
         return false;
     }
+    if(index == 4 || index == 5) {
+        // winograd only saves multiplies for small filters
+        return Winograd::supports(dim) && (dim.filterSize == 3 || dim.filterSize == 5);
+    }
+    if(index == 6) {
+        // fft only pays for its transforms with large filters
+        return FftConvolution::worthwhile(dim);
+    }
     return true;
 }
+/// the layer's cache of fft'd filters, only used by BackwardFft
+VIRTUAL void Backward::setFilterCache(FftFilterCache *filterCache) {
+    this->filterCache = filterCache;
+}
+/// \brief does backwardThroughActivation apply the derivative as it reads gradOutput?
+///
+/// if not, ConvolutionalLayer applies it in a pass of its own, shared with
+/// BackpropWeights, and calls plain backward
+VIRTUAL bool Backward::appliesActivationDeriv() {
+    return false;
+}
+/// \brief backward, for a layer with a fused activation, ie dim.activation set
+///
+/// gradOutput is then the gradient of the layer's post-activation output, which
+/// is in outputWrapper.  Implementations that read gradOutput in their own kernels
+/// apply the derivative there; by default, it is a pass of its own, into workspace
+VIRTUAL void Backward::backwardThroughActivation(int batchSize, CLWrapper *inputDataWrapper, CLWrapper *gradOutputWrapper, CLWrapper *outputWrapper, CLWrapper *weightsWrapper, CLWrapper *gradInputWrapper) {
+    if(activationDeriv == 0) {
+        activationDeriv = ActivationBackward::instance(cl, dim.numFilters, dim.outputSize, dim.activation);
+    }
+    WorkspaceScope workspace(cl);
+    CLWrapper *gradPreActivationWrapper = workspace.acquire(batchSize * dim.outputCubeSize);
+    activationDeriv->backward(batchSize, outputWrapper, gradOutputWrapper, gradPreActivationWrapper);
+    backward(batchSize, inputDataWrapper, gradPreActivationWrapper, weightsWrapper, gradInputWrapper);
+}
 VIRTUAL float * Backward::backward(int batchSize, float *input, float *gradOutput, float *filters) {
-    StatefulTimer::timeCheck("Backward::backprop begin");
 
     CLWrapper *inputWrapper = cl->wrap(batchSize * dim.inputCubeSize, input);
     inputWrapper->copyToDevice();
@@ -89,11 +141,8 @@ VIRTUAL float * Backward::backward(int batchSize, float *input, float *gradOutpu
     float *gradInput = new float[allocatedOutputNumElements];
     CLWrapper *gradInputWrapper = cl->wrap(allocatedOutputNumElements, gradInput);
 
-    StatefulTimer::timeCheck("Backward::backprop after copied to device");
     backward(batchSize, inputWrapper, gradOutputWrapper, weightsWrapper, gradInputWrapper);
-    StatefulTimer::timeCheck("Backward::backprop after call backprop");
     gradInputWrapper->copyToHost();
-    StatefulTimer::timeCheck("Backward::backprop after copytohost");
 
     delete gradInputWrapper;
     delete gradOutputWrapper;
@@ -15,6 +15,9 @@
 
 #include "DeepCLDllExport.h"
 
+class FftFilterCache;
+class ActivationBackward;
+
 #define STATIC static
 #define VIRTUAL virtual
 
@@ -22,9 +25,10 @@ class DeepCL_EXPORT Backward {
 public:
     EasyCL *cl;
     LayerDimensions dim;
+    FftFilterCache *filterCache; // set by ConvolutionalLayer, only FftConvolution uses it
+    ActivationBackward *activationDeriv; // for backwardThroughActivation, made on first use
 //    ActivationFunction const *upstreamFn;
 
-    virtual ~Backward() {}
     virtual void backward(int batchSize, 
         CLWrapper *inputDataWrapper, CLWrapper *gradOutput, CLWrapper *weightsWrapper,
         CLWrapper *gradInput) = 0;
@@ -38,8 +42,12 @@ public:
     STATIC Backward *instanceForTest(EasyCL *cl, LayerDimensions layerDimensions);
     STATIC Backward *instanceSpecific(int idx, EasyCL *cl, LayerDimensions layerDimensions);
     Backward(EasyCL *cl, LayerDimensions layerDimensions);
+    VIRTUAL ~Backward();
     STATIC int getNumImplementations();
     STATIC bool plausiblyOptimal(int index, int batchSize, LayerDimensions dim);
+    VIRTUAL void setFilterCache(FftFilterCache *filterCache);
+    VIRTUAL bool appliesActivationDeriv();
+    VIRTUAL void backwardThroughActivation(int batchSize, CLWrapper *inputDataWrapper, CLWrapper *gradOutputWrapper, CLWrapper *outputWrapper, CLWrapper *weightsWrapper, CLWrapper *gradInputWrapper);
     VIRTUAL float * backward(int batchSize, float *input, float *gradOutput, float *filters);
 
     // [[[end]]]
@@ -10,8 +10,9 @@
 
 #include "conv/BackwardAuto.h"
 #include "util/stringhelper.h"
-#include "util/StatefulTimer.h"
+#include "util/Profiler.h"
 #include "util/Timer.h"
+#include "conv/TuningCache.h"
 
 using namespace std;
 
@@ -46,9 +47,63 @@ VIRTUAL BackwardAuto::~BackwardAuto() {
         }
     }
 }
+VIRTUAL void BackwardAuto::setFilterCache(FftFilterCache *filterCache) {
+    this->filterCache = filterCache;
+    for(int i = 0; i < num; i++) {
+        if(instances[i] != 0) {
+            instances[i]->setFilterCache(filterCache);
+        }
+    }
+}
+// if a previous run already tuned this layer, on this device, go straight
+// to the kernel it picked.  Returns false if we need to tune
+bool BackwardAuto::useCachedChoice(int batchSize) {
+    cacheKey = TuningCache::makeKey("backward", num, cl, dim, batchSize);
+    int index = -1;
+    int cachedMilliseconds = -1;
+    if(!TuningCache::instance()->lookup(cacheKey, &index, &cachedMilliseconds) || index < 0 || index >= num) {
+        return false;
+    }
+    try {
+        instances[index] = Backward::instanceSpecific(index, cl, dim);
+        instances[index]->setFilterCache(filterCache);
+    } catch(runtime_error &e) {
+        cout << Profiler::layerPrefix() << "BackwardAuto: cached kernel " << index << " cant be used: " << e.what() << ", retuning" << endl;
+        return false;
+    }
+    valid[index] = true;
+    milliseconds[index] = cachedMilliseconds;
+    nextIndex = num;
+    this->chosenIndex = index;
+    cout << Profiler::layerPrefix() << "   backward layer using cached kernel " << index << endl;
+    return true;
+}
+void BackwardAuto::choose(int index) {
+    this->chosenIndex = index;
+    if(cacheKey != "") {
+        TuningCache::instance()->store(cacheKey, index, milliseconds[index]);
+    }
+}
+/// till we've chosen, each tuning run goes to the candidate's own backwardThroughActivation
+VIRTUAL bool BackwardAuto::appliesActivationDeriv() {
+    if(chosenIndex == -1) {
+        return true;
+    }
+    return instances[chosenIndex]->appliesActivationDeriv();
+}
 VIRTUAL void BackwardAuto::backward(
         int batchSize, CLWrapper *inputDataWrapper, CLWrapper *gradOutput, CLWrapper *weightsWrapper,
         CLWrapper *gradInput) {
+    run(batchSize, inputDataWrapper, gradOutput, 0, weightsWrapper, gradInput);
+}
+VIRTUAL void BackwardAuto::backwardThroughActivation(int batchSize, CLWrapper *inputDataWrapper, CLWrapper *gradOutput, CLWrapper *outputWrapper, CLWrapper *weightsWrapper, CLWrapper *gradInput) {
+    run(batchSize, inputDataWrapper, gradOutput, outputWrapper, weightsWrapper, gradInput);
+}
+// tunes, or uses the chosen instance; outputWrapper is 0 for plain backward
+void BackwardAuto::run(int batchSize, CLWrapper *inputDataWrapper, CLWrapper *gradOutput, CLWrapper *outputWrapper, CLWrapper *weightsWrapper, CLWrapper *gradInput) {
+    if(chosenIndex == -1 && nextIndex == 0) {
+        useCachedChoice(batchSize);
+    }
     while(chosenIndex == -1 && nextIndex < num) {
         int thisIndex = nextIndex;
         nextIndex++;
@@ -57,26 +112,27 @@ VIRTUAL void BackwardAuto::backward(
             Backward *candidate = 0;
             try {
                 candidate = Backward::instanceSpecific(thisIndex, cl, dim);
+                candidate->setFilterCache(filterCache);
                 instances[thisIndex] = candidate;
                 valid[thisIndex] = true;
                 cout << "   ... seems valid" << endl;
             } catch(runtime_error &e) {
-                cout << StatefulTimer::instance()->prefix << "BackwardAuto: kernel " << thisIndex << ": this instance cant be used: " << e.what() << endl;
+                cout << Profiler::layerPrefix() << "BackwardAuto: kernel " << thisIndex << ": this instance cant be used: " << e.what() << endl;
                 valid[thisIndex] = false;
             }
             if(valid[thisIndex]) {
                 Timer timer;
                 try {
-                    candidate->backward(batchSize, inputDataWrapper, gradOutput, weightsWrapper, gradInput);
+                    runInstance(candidate, batchSize, inputDataWrapper, gradOutput, outputWrapper, weightsWrapper, gradInput);
                     milliseconds[thisIndex] = (int)timer.lap();
-                    cout << StatefulTimer::instance()->prefix << "BackwardAuto: kernel " << thisIndex << " " << milliseconds[thisIndex] << "ms" << endl;
+                    cout << Profiler::layerPrefix() << "BackwardAuto: kernel " << thisIndex << " " << milliseconds[thisIndex] << "ms" << endl;
                     if (milliseconds[thisIndex] == 0) { //we can't get better time, use this instance
                         cout << "   backward layer selected kernel with zero time" << thisIndex << endl;
-                        this->chosenIndex = thisIndex;
+                        choose(thisIndex);
                     }
                     return;
                 } catch(runtime_error &e) {
-                    cout << StatefulTimer::instance()->prefix << "BackwardAuto: kernel " << thisIndex << " this instance cant be used: " << e.what() << endl;
+                    cout << Profiler::layerPrefix() << "BackwardAuto: kernel " << thisIndex << " this instance cant be used: " << e.what() << endl;
                     valid[thisIndex] = false;
                     delete instances[thisIndex];
                     instances[thisIndex] = 0;
@@ -89,7 +145,7 @@ VIRTUAL void BackwardAuto::backward(
         }
     }
     if(chosenIndex == -1) {
-//        cout << StatefulTimer::instance()->prefix + "BackwardAuto::backward choosing best instance:" << endl;
+//        cout << Profiler::layerPrefix() + "BackwardAuto::backward choosing best instance:" << endl;
         int bestIndex = -1;
         int bestTime = 0;
         for(int i = 0; i < num; i++) {
@@ -110,12 +166,19 @@ VIRTUAL void BackwardAuto::backward(
         }
         if(bestIndex != -1) {
             cout << "   backward layer selected kernel " << bestIndex << endl;
-            this->chosenIndex = bestIndex;
+            choose(bestIndex);
         } else {
-            throw runtime_error(StatefulTimer::instance()->prefix + "No valid backward implementations found");
+            throw runtime_error(Profiler::layerPrefix() + "No valid backward implementations found");
         }
     }
 //    cout << "BackwardAuto::backward using instance index: " << chosenIndex << endl;
-    instances[chosenIndex]->backward(batchSize, inputDataWrapper, gradOutput, weightsWrapper, gradInput);
+    runInstance(instances[chosenIndex], batchSize, inputDataWrapper, gradOutput, outputWrapper, weightsWrapper, gradInput);
+}
+void BackwardAuto::runInstance(Backward *instance, int batchSize, CLWrapper *inputDataWrapper, CLWrapper *gradOutput, CLWrapper *outputWrapper, CLWrapper *weightsWrapper, CLWrapper *gradInput) {
+    if(outputWrapper == 0) {
+        instance->backward(batchSize, inputDataWrapper, gradOutput, weightsWrapper, gradInput);
+    } else {
+        instance->backwardThroughActivation(batchSize, inputDataWrapper, gradOutput, outputWrapper, weightsWrapper, gradInput);
+    }
 }
 
@@ -37,6 +37,7 @@ public:
     int chosenIndex;
     Backward **instances;
     int nextIndex;
+    std::string cacheKey;
 
     // [[[cog
     // import cog_addheaders
@@ -45,9 +46,16 @@ public:
     // generated, using cog:
     BackwardAuto(EasyCL *cl, LayerDimensions dim);
     VIRTUAL ~BackwardAuto();
+    VIRTUAL void setFilterCache(FftFilterCache *filterCache);
+    bool useCachedChoice(int batchSize);
+    void choose(int index);
+    VIRTUAL bool appliesActivationDeriv();
     VIRTUAL void backward(
     int batchSize, CLWrapper *inputDataWrapper, CLWrapper *gradOutput, CLWrapper *weightsWrapper,
     CLWrapper *gradInput);
+    VIRTUAL void backwardThroughActivation(int batchSize, CLWrapper *inputDataWrapper, CLWrapper *gradOutput, CLWrapper *outputWrapper, CLWrapper *weightsWrapper, CLWrapper *gradInput);
+    void run(int batchSize, CLWrapper *inputDataWrapper, CLWrapper *gradOutput, CLWrapper *outputWrapper, CLWrapper *weightsWrapper, CLWrapper *gradInput);
+    void runInstance(Backward *instance, int batchSize, CLWrapper *inputDataWrapper, CLWrapper *gradOutput, CLWrapper *outputWrapper, CLWrapper *weightsWrapper, CLWrapper *gradInput);
 
     // [[[end]]]
 
@@ -7,7 +7,6 @@
 #include <algorithm>
 
 #include "BackwardCpu.h"
-#include "util/StatefulTimer.h"
 #include "util/stringhelper.h"
 
 using namespace std;
@@ -29,7 +28,6 @@ VIRTUAL float *BackwardCpu::backward(int batchSize, float *inputs,
     float *gradInput = new float[ batchSize * dim.inputCubeSize ];
 
 //        Timer timer;
-    StatefulTimer::instance()->timeCheck("BackwardCpu start");
     const int halfFilterSize = dim.filterSize >> 1;
     const int margin = dim.padZeros ? halfFilterSize : 0;
     // handle lower layer...
@@ -82,7 +80,6 @@ VIRTUAL float *BackwardCpu::backward(int batchSize, float *inputs,
         }
     }
 //        timer.timeCheck("calced errors for upstream");   
-    StatefulTimer::instance()->timeCheck("BackwardCpu end");
 
     return gradInput;
 }
@@ -0,0 +1,41 @@
+// Copyright Hugh Perkins 2015 hughperkins at gmail
+//
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file, You can
+// obtain one at http://mozilla.org/MPL/2.0/.
+
+#include "EasyCL.h"
+#include "conv/FftConvolution.h"
+#include "conv/FftFilterCache.h"
+
+#include "conv/BackwardFft.h"
+
+using namespace std;
+
+#undef VIRTUAL
+#undef STATIC
+#define VIRTUAL
+#define STATIC
+#define PUBLIC
+
+PUBLIC BackwardFft::BackwardFft(EasyCL *cl, LayerDimensions dim) :
+        Backward(cl, dim) {
+    fft = new FftConvolution(cl, dim);
+    ownFilterCache = new FftFilterCache(cl);
+}
+PUBLIC VIRTUAL BackwardFft::~BackwardFft() {
+    delete ownFilterCache;
+    delete fft;
+}
+PUBLIC VIRTUAL void BackwardFft::backward(int batchSize,
+        CLWrapper *inputDataWrapper, CLWrapper *gradOutputWrapper, CLWrapper *weightsWrapper,
+        CLWrapper *gradInputWrapper) {
+    FftFilterCache *cache = filterCache;
+    if(cache == 0) {
+        // no way to know if the weights changed since last time
+        ownFilterCache->invalidate();
+        cache = ownFilterCache;
+    }
+    CLWrapper *filterSpectraWrapper = fft->getFilterSpectra(cache, weightsWrapper);
+    fft->backward(batchSize, gradOutputWrapper, filterSpectraWrapper, gradInputWrapper);
+}
@@ -1,6 +1,6 @@
-#include "util/StatefulTimer.h"
 
 #include "BackwardGpuCached.h"
+#include "util/KernelCache.h"
 
 using namespace std;
 
@@ -17,7 +17,16 @@ VIRTUAL BackwardGpuCached::~BackwardGpuCached() {
 VIRTUAL void BackwardGpuCached::backward(int batchSize, 
         CLWrapper *inputDataWrapper, CLWrapper *gradOutputWrapper, CLWrapper *weightsWrapper,
         CLWrapper *gradInputWrapper) {
-    StatefulTimer::instance()->timeCheck("BackwardGpuCached start");
+    if(dim.activation != 0) {
+        throw runtime_error("BackwardGpuCached: built for a fused activation, so needs backwardThroughActivation");
+    }
+    backwardThroughActivation(batchSize, inputDataWrapper, gradOutputWrapper, 0, weightsWrapper, gradInputWrapper);
+}
+VIRTUAL bool BackwardGpuCached::appliesActivationDeriv() {
+    return true;
+}
+/// the derivative is applied as calcGradInputCached copies gradOutput into local memory
+VIRTUAL void BackwardGpuCached::backwardThroughActivation(int batchSize, CLWrapper *inputDataWrapper, CLWrapper *gradOutputWrapper, CLWrapper *outputWrapper, CLWrapper *weightsWrapper, CLWrapper *gradInputWrapper) {
 
 //        const int batchSize,
 //        global const float *gradOutputGlobal,
@@ -28,7 +37,11 @@ VIRTUAL void BackwardGpuCached::backward(int batchSize,
 
     kernel
        ->in(batchSize)
-        ->in(gradOutputWrapper)
+        ->in(gradOutputWrapper);
+    if(dim.activation != 0) {
+        kernel->in(outputWrapper);
+    }
+    kernel
        ->in(weightsWrapper)
         ->out(gradInputWrapper)
         ->localFloats(square(dim.outputSize) )
@@ -48,7 +61,6 @@ VIRTUAL void BackwardGpuCached::backward(int batchSize,
     kernel->run_1d(globalSize, workgroupSize);
     cl->finish();
 //    gradInputWrapper->copyToHost();
-    StatefulTimer::instance()->timeCheck("BackwardGpuCached after first kernel");
 //    for(int i = 0; i < min(40, batchSize * dim.inputCubeSize); i++) {
 //        cout << "efu[" << i << "]=" << gradInput[i] << endl;
 //    }
@@ -64,7 +76,6 @@ VIRTUAL void BackwardGpuCached::backward(int batchSize,
 //        cout << "efu2[" << i << "]=" << gradInput[i] << endl;
 //    }
     
-    StatefulTimer::instance()->timeCheck("BackwardGpuCached end");
 }
 BackwardGpuCached::BackwardGpuCached(EasyCL *cl, LayerDimensions dim) :
         Backward(cl, dim)
@@ -74,7 +85,9 @@ BackwardGpuCached::BackwardGpuCached(EasyCL *cl, LayerDimensions dim) :
     }
 
     std::string options = dim.buildOptionsString();
-    options += ""; // " -D " + upstreamFn->getDefineName();
+    if(dim.activation != 0) {
+        options += " -D " + string(dim.activation->getDefineName());
+    }
     // [[[cog
     // import stringify
     // stringify.write_kernel2("kernel", "cl/backward_cached.cl", "calcGradInputCached", 'options')
@@ -90,6 +103,52 @@ BackwardGpuCached::BackwardGpuCached(EasyCL *cl, LayerDimensions dim) :
     "// v. 2.0. If a copy of the MPL was not distributed with this file, You can\n"
     "// obtain one at http://mozilla.org/MPL/2.0/.\n"
     "\n"
+    "// expected defines:\n"
+    "//  - one of: [ TANH | RELU | LINEAR | SIGMOID | SCALEDTANH | ELU ] (optional)\n"
+    "//    for a layer with a fused activation, see backward.cl\n"
+    "\n"
+    "// including cl/activate_defines.cl:\n"
+    "// Copyright Hugh Perkins 2015 hughperkins at gmail\n"
+    "//\n"
+    "// This Source Code Form is subject to the terms of the Mozilla Public License,\n"
+    "// v. 2.0. If a copy of the MPL was not distributed with this file, You can\n"
+    "// obtain one at http://mozilla.org/MPL/2.0/.\n"
+    "\n"
+    "// ACTIVATION_FUNCTION, for kernels that fuse an activation into their output,\n"
+    "// and ACTIVATION_DERIV, its derivative, written in terms of that output, for\n"
+    "// kernels that fuse it into reading gradOutput;\n"
+    "// both left undefined if none of the activation defines is given\n"
+    "// one of: [ TANH | RELU | LINEAR | SIGMOID | SCALEDTANH | ELU ] (optional)\n"
+    "\n"
+    "#ifdef TANH\n"
+    "    #define ACTIVATION_FUNCTION(output) (tanh(output))\n"
+    "#elif defined SCALEDTANH\n"
+    "    #define ACTIVATION_FUNCTION(output) (1.7159f * tanh(0.66667f * output))\n"
+    "#elif defined SIGMOID\n"
+    "    #define ACTIVATION_FUNCTION(output) (1.0f / (1 + exp(-output)))\n"
+    "#elif defined RELU\n"
+    "    #define ACTIVATION_FUNCTION(output) (output> 0 ? output : 0)\n"
+    "#elif defined ELU\n"
+    "    #define ACTIVATION_FUNCTION(output) (output> 0 ? output : exp(output) - 1)\n"
+    "#elif defined LINEAR\n"
+    "    #define ACTIVATION_FUNCTION(output) (output)\n"
+    "#endif\n"
+    "\n"
+    "#ifdef TANH\n"
+    "    #define ACTIVATION_DERIV(output) (1 - output * output)\n"
+    "#elif defined SCALEDTANH\n"
+    "    #define ACTIVATION_DERIV(output) (0.66667f * (1.7159f - 1 / 1.7159f * output * output) )\n"
+    "#elif defined SIGMOID\n"
+    "    #define ACTIVATION_DERIV(output) (output * (1 - output) )\n"
+    "#elif defined RELU\n"
+    "    #define ACTIVATION_DERIV(output) (output > 0 ? 1 : 0)\n"
+    "#elif defined ELU\n"
+    "    #define ACTIVATION_DERIV(output) (output > 0 ? 1 : output + 1)\n"
+    "#elif defined LINEAR\n"
+    "    #define ACTIVATION_DERIV(output) (1.0f)\n"
+    "#endif\n"
+    "\n"
+    "\n"
     "void copyLocal(local float *target, global float const *source, int N) {\n"
     "    int numLoops = (N + get_local_size(0) - 1) / get_local_size(0);\n"
     "    for (int loop = 0; loop < numLoops; loop++) {\n"
@@ -100,6 +159,19 @@ BackwardGpuCached::BackwardGpuCached(EasyCL *cl, LayerDimensions dim) :
     "    }\n"
     "}\n"
     "\n"
+    "#ifdef ACTIVATION_DERIV\n"
+    "// as copyLocal, applying the derivative of the fused activation on the way\n"
+    "void copyLocalTimesDeriv(local float *target, global float const *source, global float const *output, int N) {\n"
+    "    int numLoops = (N + get_local_size(0) - 1) / get_local_size(0);\n"
+    "    for (int loop = 0; loop < numLoops; loop++) {\n"
+    "        int offset = loop * get_local_size(0) + get_local_id(0);\n"
+    "        if (offset < N) {\n"
+    "            target[offset] = source[offset] * ACTIVATION_DERIV(output[offset]);\n"
+    "        }\n"
+    "    }\n"
+    "}\n"
+    "#endif\n"
+    "\n"
     "// as calcGradInput, but with local cache\n"
     "// convolve weights with gradOutput to produce gradInput\n"
     "// workgroupid: [n][inputPlane]\n"
@@ -121,6 +193,9 @@ BackwardGpuCached::BackwardGpuCached(EasyCL *cl, LayerDimensions dim) :
     "void kernel calcGradInputCached(\n"
     "        const int batchSize,\n"
     "        global const float *gradOutputGlobal,\n"
+    "#ifdef ACTIVATION_DERIV\n"
+    "        global const float *outputGlobal,\n"
+    "#endif\n"
     "        global const float *filtersGlobal,\n"
     "        global float *gradInput,\n"
     "        local float *_gradOutputPlane,\n"
@@ -141,7 +216,12 @@ BackwardGpuCached::BackwardGpuCached(EasyCL *cl, LayerDimensions dim) :
     "    for (int outPlane = 0; outPlane < gNumFilters; outPlane++) {\n"
     "        barrier(CLK_LOCAL_MEM_FENCE);\n"
     "        copyLocal(_filterPlane, filtersGlobal + (outPlane * gInputPlanes + upstreamPlane) * gFilterSizeSquared, gFilterSizeSquared);\n"
+    "#ifdef ACTIVATION_DERIV\n"
+    "        copyLocalTimesDeriv(_gradOutputPlane, gradOutputGlobal + (n * gNumFilters + outPlane) * gOutputSizeSquared,\n"
+    "            outputGlobal + (n * gNumFilters + outPlane) * gOutputSizeSquared, gOutputSizeSquared);\n"
+    "#else\n"
     "        copyLocal(_gradOutputPlane, gradOutputGlobal + (n * gNumFilters + outPlane) * gOutputSizeSquared, gOutputSizeSquared);\n"
+    "#endif\n"
     "        barrier(CLK_LOCAL_MEM_FENCE);\n"
     "        for (int filterRow = 0; filterRow < gFilterSize; filterRow++) {\n"
     "            int outRow = upstreamRow + gMargin - filterRow;\n"
@@ -163,7 +243,7 @@ BackwardGpuCached::BackwardGpuCached(EasyCL *cl, LayerDimensions dim) :
     "}\n"
     "\n"
     "";
-    kernel = cl->buildKernelFromString(kernelSource, "calcGradInputCached", options, "cl/backward_cached.cl");
+    kernel = KernelCache::buildKernelFromString(cl, kernelSource, "calcGradInputCached", options, "cl/backward_cached.cl");
     // [[[end]]]
 //    kernel = cl->buildKernel("backproperrorsv2.cl", "calcGradInput", options);
 //    kernel = cl->buildKernelFromString(kernelSource, "calcGradInput", options);
@@ -20,6 +20,8 @@ public:
     VIRTUAL void backward(int batchSize,
     CLWrapper *inputDataWrapper, CLWrapper *gradOutputWrapper, CLWrapper *weightsWrapper,
     CLWrapper *gradInputWrapper);
+    VIRTUAL bool appliesActivationDeriv();
+    VIRTUAL void backwardThroughActivation(int batchSize, CLWrapper *inputDataWrapper, CLWrapper *gradOutputWrapper, CLWrapper *outputWrapper, CLWrapper *weightsWrapper, CLWrapper *gradInputWrapper);
     BackwardGpuCached(EasyCL *cl, LayerDimensions dim);
 
     // [[[end]]]
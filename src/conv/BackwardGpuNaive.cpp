@@ -1,6 +1,8 @@
-#include "util/StatefulTimer.h"
+
+#include <stdexcept>
 
 #include "BackwardGpuNaive.h"
+#include "util/KernelCache.h"
 
 using namespace std;
 
@@ -18,11 +20,23 @@ VIRTUAL BackwardGpuNaive::~BackwardGpuNaive() {
 VIRTUAL void BackwardGpuNaive::backward(int batchSize, 
         CLWrapper *inputDataWrapper, CLWrapper *gradOutputWrapper, CLWrapper *weightsWrapper,
         CLWrapper *gradInputWrapper) {
-    StatefulTimer::instance()->timeCheck("BackwardGpuNaive start");
-
+    if(dim.activation != 0) {
+        throw runtime_error("BackwardGpuNaive: built for a fused activation, so needs backwardThroughActivation");
+    }
+    backwardThroughActivation(batchSize, inputDataWrapper, gradOutputWrapper, 0, weightsWrapper, gradInputWrapper);
+}
+VIRTUAL bool BackwardGpuNaive::appliesActivationDeriv() {
+    return true;
+}
+/// the derivative is applied as calcGradInput reads gradOutput
+VIRTUAL void BackwardGpuNaive::backwardThroughActivation(int batchSize, CLWrapper *inputDataWrapper, CLWrapper *gradOutputWrapper, CLWrapper *outputWrapper, CLWrapper *weightsWrapper, CLWrapper *gradInputWrapper) {
     kernel
        ->in(batchSize)
-        ->in(gradOutputWrapper)
+        ->in(gradOutputWrapper);
+    if(dim.activation != 0) {
+        kernel->in(outputWrapper);
+    }
+    kernel
        ->in(weightsWrapper)
         ->out(gradInputWrapper);
 
@@ -32,20 +46,20 @@ VIRTUAL void BackwardGpuNaive::backward(int batchSize,
     kernel->run_1d(globalSize, workgroupsize);
 
     cl->finish();
-    StatefulTimer::instance()->timeCheck("BackwardGpuNaive after first kernel");
 
 //    applyActivationDeriv->in(batchSize * dim.inputCubeSize)->in(gradInputWrapper)->in(inputDataWrapper);
 //    applyActivationDeriv->run_1d(globalSize, workgroupsize);
 //    cl->finish();
 //    StatefulTimer::instance()->timeCheck("BackwardGpuNaive after applyActivationDeriv");
     
-    StatefulTimer::instance()->timeCheck("BackwardGpuNaive end");
 }
 BackwardGpuNaive::BackwardGpuNaive(EasyCL *cl, LayerDimensions dim) :
         Backward(cl, dim)
             {
     std::string options = dim.buildOptionsString();
-    options += ""; // " -D " + upstreamFn->getDefineName();
+    if(dim.activation != 0) {
+        options += " -D " + string(dim.activation->getDefineName());
+    }
     // [[[cog
     // import stringify
     // stringify.write_kernel2("kernel", "cl/backward.cl", "calcGradInput", 'options')
@@ -62,7 +76,51 @@ BackwardGpuNaive::BackwardGpuNaive(EasyCL *cl, LayerDimensions dim) :
     "// obtain one at http://mozilla.org/MPL/2.0/.\n"
     "\n"
     "// expected defines:\n"
-    "//  - none\n"
+    "//  - one of: [ TANH | RELU | LINEAR | SIGMOID | SCALEDTANH | ELU ] (optional)\n"
+    "//    for a layer with a fused activation: gradOutput is then the gradient of the\n"
+    "//    post-activation output, and the derivative is applied as we read it\n"
+    "\n"
+    "// including cl/activate_defines.cl:\n"
+    "// Copyright Hugh Perkins 2015 hughperkins at gmail\n"
+    "//\n"
+    "// This Source Code Form is subject to the terms of the Mozilla Public License,\n"
+    "// v. 2.0. If a copy of the MPL was not distributed with this file, You can\n"
+    "// obtain one at http://mozilla.org/MPL/2.0/.\n"
+    "\n"
+    "// ACTIVATION_FUNCTION, for kernels that fuse an activation into their output,\n"
+    "// and ACTIVATION_DERIV, its derivative, written in terms of that output, for\n"
+    "// kernels that fuse it into reading gradOutput;\n"
+    "// both left undefined if none of the activation defines is given\n"
+    "// one of: [ TANH | RELU | LINEAR | SIGMOID | SCALEDTANH | ELU ] (optional)\n"
+    "\n"
+    "#ifdef TANH\n"
+    "    #define ACTIVATION_FUNCTION(output) (tanh(output))\n"
+    "#elif defined SCALEDTANH\n"
+    "    #define ACTIVATION_FUNCTION(output) (1.7159f * tanh(0.66667f * output))\n"
+    "#elif defined SIGMOID\n"
+    "    #define ACTIVATION_FUNCTION(output) (1.0f / (1 + exp(-output)))\n"
+    "#elif defined RELU\n"
+    "    #define ACTIVATION_FUNCTION(output) (output> 0 ? output : 0)\n"
+    "#elif defined ELU\n"
+    "    #define ACTIVATION_FUNCTION(output) (output> 0 ? output : exp(output) - 1)\n"
+    "#elif defined LINEAR\n"
+    "    #define ACTIVATION_FUNCTION(output) (output)\n"
+    "#endif\n"
+    "\n"
+    "#ifdef TANH\n"
+    "    #define ACTIVATION_DERIV(output) (1 - output * output)\n"
+    "#elif defined SCALEDTANH\n"
+    "    #define ACTIVATION_DERIV(output) (0.66667f * (1.7159f - 1 / 1.7159f * output * output) )\n"
+    "#elif defined SIGMOID\n"
+    "    #define ACTIVATION_DERIV(output) (output * (1 - output) )\n"
+    "#elif defined RELU\n"
+    "    #define ACTIVATION_DERIV(output) (output > 0 ? 1 : 0)\n"
+    "#elif defined ELU\n"
+    "    #define ACTIVATION_DERIV(output) (output > 0 ? 1 : output + 1)\n"
+    "#elif defined LINEAR\n"
+    "    #define ACTIVATION_DERIV(output) (1.0f)\n"
+    "#endif\n"
+    "\n"
     "\n"
     "// globalid as: [n][upstreamPlane][upstreamrow][upstreamcol]\n"
     "// inputdata: [n][upstreamPlane][upstreamrow][upstreamcol] 128 * 32 * 19 * 19 * 4 = 6MB\n"
@@ -70,7 +128,11 @@ BackwardGpuNaive::BackwardGpuNaive(EasyCL *cl, LayerDimensions dim) :
     "// weights: [filterId][inputPlane][filterRow][filterCol] 32 * 32 * 5 * 5 * 4 = 409KB\n"
     "void kernel calcGradInput(\n"
     "        const int batchSize,\n"
-    "        global const float *gradOutput, global float *weights, global float *gradInput) {\n"
+    "        global const float *gradOutput,\n"
+    "#ifdef ACTIVATION_DERIV\n"
+    "        global const float *output,\n"
+    "#endif\n"
+    "        global float *weights, global float *gradInput) {\n"
     "    int globalId = get_global_id(0);\n"
     "\n"
     "    const int upstreamImage2dId = globalId / gInputSizeSquared;\n"
@@ -103,6 +165,9 @@ BackwardGpuNaive::BackwardGpuNaive(EasyCL *cl, LayerDimensions dim) :
     "                          + outRow) * gOutputSize\n"
     "                          + outCol;\n"
     "                float thisError = gradOutput[resultIndex];\n"
+    "#ifdef ACTIVATION_DERIV\n"
+    "                thisError *= ACTIVATION_DERIV(output[resultIndex]);\n"
+    "#endif\n"
     "                int thisWeightIndex = (( outPlane * gInputPlanes\n"
     "                                    + upstreamPlane) * gFilterSize\n"
     "                                    + filterRow) * gFilterSize\n"
@@ -117,7 +182,7 @@ BackwardGpuNaive::BackwardGpuNaive(EasyCL *cl, LayerDimensions dim) :
     "}\n"
     "\n"
     "";
-    kernel = cl->buildKernelFromString(kernelSource, "calcGradInput", options, "cl/backward.cl");
+    kernel = KernelCache::buildKernelFromString(cl, kernelSource, "calcGradInput", options, "cl/backward.cl");
     // [[[end]]]
 //    kernel = cl->buildKernel("backproperrorsv2.cl", "calcGradInput", options);
 //    kernel = cl->buildKernelFromString(kernelSource, "calcGradInput", options);
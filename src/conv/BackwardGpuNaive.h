@@ -21,6 +21,8 @@ public:
     VIRTUAL void backward(int batchSize,
     CLWrapper *inputDataWrapper, CLWrapper *gradOutputWrapper, CLWrapper *weightsWrapper,
     CLWrapper *gradInputWrapper);
+    VIRTUAL bool appliesActivationDeriv();
+    VIRTUAL void backwardThroughActivation(int batchSize, CLWrapper *inputDataWrapper, CLWrapper *gradOutputWrapper, CLWrapper *outputWrapper, CLWrapper *weightsWrapper, CLWrapper *gradInputWrapper);
     BackwardGpuNaive(EasyCL *cl, LayerDimensions dim);
 
     // [[[end]]]
@@ -1,5 +1,4 @@
 #include "util/stringhelper.h"
-#include "util/StatefulTimer.h"
 
 #include <sstream>
 #include <iostream>
@@ -8,6 +7,7 @@
 //#include "clblas/ClBlasInstance.h"
 #include "clblas/ClBlasHelper.h"
 #include "conv/Im2Col.h"
+#include "util/WorkspaceScope.h"
 #include "BackwardIm2Col.h"
 
 using namespace std;
@@ -32,16 +32,13 @@ PUBLIC VIRTUAL BackwardIm2Col::~BackwardIm2Col() {
 PUBLIC VIRTUAL void BackwardIm2Col::backward(int batchSize, 
         CLWrapper *inputDataWrapper, CLWrapper *gradOutputWrapper, CLWrapper *weightsWrapper,
         CLWrapper *gradInputWrapper) {
-    StatefulTimer::timeCheck("BackwardIm2Col::backward START");
 
     int gradColumnsSize = dim.inputPlanes * dim.filterSizeSquared * dim.outputSizeSquared;
-    float *gradColumns = new float[gradColumnsSize];
-    CLWrapper *gradColumnsWrapper = cl->wrap(gradColumnsSize, gradColumns);
-    gradColumnsWrapper->createOnDevice();
+    WorkspaceScope workspace(cl);
+    CLWrapper *gradColumnsWrapper = workspace.acquire(gradColumnsSize);
 //    cout << "gradColumnsSize: " << gradColumnsSize << endl;
 //    cout << "weightsize: " << weightsWrapper->size() << endl;
 
-    StatefulTimer::timeCheck("BackwardIm2Col::backward after alloc");
 
     if(!gradInputWrapper->isOnDevice()) {
         gradInputWrapper->createOnDevice();
@@ -66,11 +63,6 @@ PUBLIC VIRTUAL void BackwardIm2Col::backward(int batchSize,
         im2Col->col2Im(gradColumnsWrapper, gradInputWrapper, b * dim.inputCubeSize);
     }
 
-    delete gradColumnsWrapper;
-    delete[] gradColumns;
 
-    StatefulTimer::timeCheck("BackwardIm2Col::backward after call backward");
-
-    StatefulTimer::timeCheck("BackwardIm2Col::backward END");
 }
 
@@ -0,0 +1,31 @@
+// Copyright Hugh Perkins 2015 hughperkins at gmail
+//
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file, You can
+// obtain one at http://mozilla.org/MPL/2.0/.
+
+#include "EasyCL.h"
+#include "conv/Winograd.h"
+
+#include "conv/BackwardWinograd.h"
+
+using namespace std;
+
+#undef VIRTUAL
+#undef STATIC
+#define VIRTUAL
+#define STATIC
+#define PUBLIC
+
+PUBLIC BackwardWinograd::BackwardWinograd(EasyCL *cl, LayerDimensions dim) :
+        Backward(cl, dim) {
+    winograd = new Winograd(cl, dim, true);
+}
+PUBLIC VIRTUAL BackwardWinograd::~BackwardWinograd() {
+    delete winograd;
+}
+PUBLIC VIRTUAL void BackwardWinograd::backward(int batchSize,
+        CLWrapper *inputDataWrapper, CLWrapper *gradOutputWrapper, CLWrapper *weightsWrapper,
+        CLWrapper *gradInputWrapper) {
+    winograd->convolve(batchSize, gradOutputWrapper, weightsWrapper, 0, gradInputWrapper);
+}
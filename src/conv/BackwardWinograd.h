@@ -0,0 +1,39 @@
+// Copyright Hugh Perkins 2015 hughperkins at gmail
+//
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file, You can
+// obtain one at http://mozilla.org/MPL/2.0/.
+
+#pragma once
+
+#include "Backward.h"
+
+class Winograd;
+
+#include "DeepCLDllExport.h"
+
+#define VIRTUAL virtual
+#define STATIC static
+
+// gradInput by Winograd F(2x2,3x3) on the gpu, as a forward convolution of
+// gradOutput with the flipped filters, see Winograd.h
+class DeepCL_EXPORT BackwardWinograd : public Backward {
+    private:
+    Winograd *winograd;
+
+    // [[[cog
+    // import cog_addheaders
+    // cog_addheaders.addv2()
+    // ]]]
+    // generated, using cog:
+
+    public:
+    BackwardWinograd(EasyCL *cl, LayerDimensions dim);
+    VIRTUAL ~BackwardWinograd();
+    VIRTUAL void backward(int batchSize,
+        CLWrapper *inputDataWrapper, CLWrapper *gradOutputWrapper, CLWrapper *weightsWrapper,
+    CLWrapper *gradInputWrapper);
+
+    // [[[end]]]
+};
+
@@ -0,0 +1,41 @@
+// Copyright Hugh Perkins 2015 hughperkins at gmail
+//
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file, You can
+// obtain one at http://mozilla.org/MPL/2.0/.
+
+#include "EasyCL.h"
+#include "conv/Winograd.h"
+
+#include "conv/BackwardWinogradCpu.h"
+
+using namespace std;
+
+#undef VIRTUAL
+#undef STATIC
+#define VIRTUAL
+#define STATIC
+#define PUBLIC
+
+PUBLIC BackwardWinogradCpu::BackwardWinogradCpu(EasyCL *cl, LayerDimensions dim) :
+        Backward(cl, dim) {
+    winograd = new Winograd(0, dim, true);
+}
+PUBLIC VIRTUAL BackwardWinogradCpu::~BackwardWinogradCpu() {
+    delete winograd;
+}
+// caller owns the returned gradInput, batchSize * dim.inputCubeSize floats
+PUBLIC VIRTUAL float *BackwardWinogradCpu::backward(int batchSize, float *inputs, float *gradOutput, float *weights) {
+    float *gradInput = new float[batchSize * dim.inputCubeSize];
+    winograd->convolveCpu(batchSize, gradOutput, weights, 0, gradInput);
+    return gradInput;
+}
+PUBLIC VIRTUAL void BackwardWinogradCpu::backward(int batchSize,
+        CLWrapper *inputDataWrapper, CLWrapper *gradOutputWrapper, CLWrapper *weightsWrapper,
+        CLWrapper *gradInputWrapper) {
+    gradOutputWrapper->copyToHost();
+    weightsWrapper->copyToHost();
+    winograd->convolveCpu(batchSize, (float *)gradOutputWrapper->getHostArray(),
+        (float *)weightsWrapper->getHostArray(), 0, (float *)gradInputWrapper->getHostArray());
+    gradInputWrapper->copyToDevice();
+}
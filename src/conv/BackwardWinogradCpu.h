@@ -0,0 +1,39 @@
+// Copyright Hugh Perkins 2015 hughperkins at gmail
+//
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file, You can
+// obtain one at http://mozilla.org/MPL/2.0/.
+
+#pragma once
+
+#include "Backward.h"
+
+class Winograd;
+
+#include "DeepCLDllExport.h"
+
+#define VIRTUAL virtual
+#define STATIC static
+
+// native gradInput by Winograd F(2x2,3x3), on ThreadPool, see Winograd.h
+class DeepCL_EXPORT BackwardWinogradCpu : public Backward {
+    private:
+    Winograd *winograd;
+
+    // [[[cog
+    // import cog_addheaders
+    // cog_addheaders.addv2()
+    // ]]]
+    // generated, using cog:
+
+    public:
+    BackwardWinogradCpu(EasyCL *cl, LayerDimensions dim);
+    VIRTUAL ~BackwardWinogradCpu();
+    VIRTUAL float *backward(int batchSize, float *inputs, float *gradOutput, float *weights);
+    VIRTUAL void backward(int batchSize,
+        CLWrapper *inputDataWrapper, CLWrapper *gradOutputWrapper, CLWrapper *weightsWrapper,
+    CLWrapper *gradInputWrapper);
+
+    // [[[end]]]
+};
+
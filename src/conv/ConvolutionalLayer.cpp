@@ -12,6 +12,9 @@
 #include "weights/WeightsHelper.h"
 #include "Backward.h"
 #include "BackpropWeights.h"
+#include "FftFilterCache.h"
+#include "activate/ActivationBackward.h"
+#include "util/WorkspaceScope.h"
 #include "trainers/TrainerStateMaker.h"
 #include "trainers/TrainerState.h"
 #include "trainers/SGDState.h"
@@ -34,6 +37,8 @@ ConvolutionalLayer::ConvolutionalLayer(EasyCL *cl, Layer *previousLayer, Convolu
         biasTrainerState(0),
         forwardImpl(0),
         backwardImpl(0),
+        filterCache(0),
+        activationDeriv(0),
 
         weights(0),
         bias(0),
@@ -66,10 +71,13 @@ ConvolutionalLayer::ConvolutionalLayer(EasyCL *cl, Layer *previousLayer, Convolu
 
 //    dim = LayerDimensions(upstreamNumPlanes, upstreamImageSize, 
 //        numPlanes, filterSize, padZeros, biased);
+    filterCache = new FftFilterCache(cl);
     forwardImpl = Forward::instance(cl, dim);
+    forwardImpl->setFilterCache(filterCache);
     backpropWeightsImpl = BackpropWeights::instance(cl, dim);
     if(previousLayer->needsBackProp()) {
         backwardImpl = Backward::instance(cl, dim);
+        backwardImpl->setFilterCache(filterCache);
     }
 
     if(dim.filterSize > dim.inputSize) {
@@ -109,12 +117,14 @@ VIRTUAL ConvolutionalLayer::~ConvolutionalLayer() {
 
     delete weightsWrapper;
     delete biasWrapper;
-    delete outputWrapper;
+    if(!sharedOutput) {
+        delete outputWrapper;
+        delete[] output;
+    }
     delete gradInputWrapper;
     delete gradWeightsWrapper;
     delete gradBiasWrapper;
 
-    delete[] output;
     delete[] weights;
     delete[] bias;
     delete[] gradInput;
@@ -124,6 +134,8 @@ VIRTUAL ConvolutionalLayer::~ConvolutionalLayer() {
     delete forwardImpl;
     delete backpropWeightsImpl;
     delete backwardImpl;
+    delete filterCache;
+    delete activationDeriv;
     delete trainerState;
     delete biasTrainerState;
 }
@@ -160,7 +172,9 @@ VIRTUAL bool ConvolutionalLayer::providesGradInputWrapper() const {
 VIRTUAL CLWrapper *ConvolutionalLayer::getGradInputWrapper() {
     return gradInputWrapper;
 }
+// the trainers update the weights through this, so the fft'd filters wont be valid
 VIRTUAL CLWrapper *ConvolutionalLayer::getWeightsWrapper() {
+    filterCache->invalidate();
     return weightsWrapper;
 }
 VIRTUAL CLWrapper *ConvolutionalLayer::getBiasWrapper() {
@@ -283,11 +297,17 @@ VIRTUAL void ConvolutionalLayer::setBatchSize(int batchSize) {
     this->batchSize = batchSize;
     this->allocatedSpaceNumExamples = batchSize;
 
-    delete outputWrapper;
-    delete[] output;
-
     delete gradInputWrapper;
     delete[] gradInput;
+    gradInputWrapper = 0;
+    gradInput = 0;
+
+    // a shared output belongs to the net, and means inference only, so no gradients either
+    if(sharedOutput) {
+        return;
+    }
+    delete outputWrapper;
+    delete[] output;
 
     output = new float[getOutputNumElements()];
     outputWrapper = cl->wrap(getOutputNumElements(), output);
@@ -297,6 +317,31 @@ VIRTUAL void ConvolutionalLayer::setBatchSize(int batchSize) {
         gradInputWrapper = cl->wrap(previousLayer->getOutputNumElements(), gradInput);
     }
 }
+VIRTUAL bool ConvolutionalLayer::canShareOutput() const {
+    return true;
+}
+VIRTUAL void ConvolutionalLayer::setSharedOutput(float *output, CLWrapper *outputWrapper) {
+    adoptSharedOutput(output, outputWrapper, &this->output, &this->outputWrapper, &gradInput, &gradInputWrapper, &allocatedSpaceNumExamples);
+}
+VIRTUAL bool ConvolutionalLayer::canFuseActivation() const {
+    return dim.activation == 0;
+}
+// our output is then post-activation, and the gradOutput we get in backward is
+// the gradient of that, since the activation layer just passes it through.  So
+// backward applies the activation's derivative, see backwardThroughActivation
+VIRTUAL void ConvolutionalLayer::fuseActivation(ActivationFunction const *activation) {
+    dim.setActivation(activation);
+    delete forwardImpl;
+    forwardImpl = Forward::instance(cl, dim);
+    forwardImpl->setFilterCache(filterCache);
+    delete backpropWeightsImpl;
+    backpropWeightsImpl = BackpropWeights::instance(cl, dim);
+    if(backwardImpl != 0) {
+        delete backwardImpl;
+        backwardImpl = Backward::instance(cl, dim);
+        backwardImpl->setFilterCache(filterCache);
+    }
+}
 VIRTUAL void ConvolutionalLayer::setWeights(float *weights, float *bias) {
 //    cout << "setweights" << endl;
     initWeights(weights);
@@ -335,6 +380,7 @@ VIRTUAL void ConvolutionalLayer::initWeights(float const*weights) {
     int weightsSize = getWeightsSize();
     memcpy(this->weights, weights, sizeof(float) * weightsSize);
     weightsWrapper->copyToDevice();
+    filterCache->invalidate();
 }
 VIRTUAL void ConvolutionalLayer::initBias(float const*bias) {
     int biasSize = dim.numFilters;
@@ -389,7 +435,6 @@ VIRTUAL void ConvolutionalLayer::forward() {
     if(batchSize == 0) {
         throw runtime_error("Need to call setBatchSize(size) before calling forward etc");
     }
-    StatefulTimer::instance()->timeCheck("    forward layer " + toString(layerIndex) + ", START");
 
     CLWrapper *upstreamWrapper = 0;
     if(previousLayer->hasOutputWrapper()) {
@@ -400,9 +445,7 @@ VIRTUAL void ConvolutionalLayer::forward() {
         upstreamWrapper = cl->wrap(previousLayer->getOutputNumElements(), (float *)previousLayer->getOutput());
         upstreamWrapper->copyToDevice();
     }
-    StatefulTimer::instance()->timeCheck("    forward layer " + toString(layerIndex) + ", copied to device");
     forwardImpl->forward(batchSize, upstreamWrapper, weightsWrapper, biasWrapper, outputWrapper);
-    StatefulTimer::instance()->timeCheck("    forward layer " + toString(layerIndex) + ",  after clFinish");
 
     if(!previousLayer->hasOutputWrapper()) {
         delete upstreamWrapper;
@@ -410,7 +453,6 @@ VIRTUAL void ConvolutionalLayer::forward() {
 //    outputCopiedToHost = false;
 }
 VIRTUAL void ConvolutionalLayer::backward() {
-    StatefulTimer::instance()->timeCheck("backprop(): start, layer " + toString(layerIndex) );
 
     CLWrapper *inputWrapper = 0;
     if(previousLayer->hasOutputWrapper()) {
@@ -430,14 +472,15 @@ VIRTUAL void ConvolutionalLayer::backward() {
         weOwnGradOutputWrapper = true;
     }
 
-    if(previousLayer->needsBackProp()) {
-        backwardImpl->backward(batchSize, inputWrapper, gradOutputWrapper, weightsWrapper, gradInputWrapper);
-        StatefulTimer::instance()->timeCheck("backproperrors(): calced gradInput, layer " + ::toString(layerIndex) );
+    if(dim.activation != 0) {
+        backwardThroughActivation(inputWrapper, gradOutputWrapper);
+    } else {
+        if(previousLayer->needsBackProp()) {
+            backwardImpl->backward(batchSize, inputWrapper, gradOutputWrapper, weightsWrapper, gradInputWrapper);
+        }
+        backpropWeightsImpl->calcGradWeights(batchSize, gradOutputWrapper, inputWrapper,  gradWeightsWrapper, gradBiasWrapper);
     }
 
-    backpropWeightsImpl->calcGradWeights(batchSize, gradOutputWrapper, inputWrapper,  gradWeightsWrapper, gradBiasWrapper);
-    StatefulTimer::instance()->timeCheck("backproperrors(): done calc gradWeights, layer " + ::toString(layerIndex) );
-
 //    gradWeightsCopiedToHost = false;
 //    gradBiasCopiedToHost = false;
 
@@ -448,6 +491,36 @@ VIRTUAL void ConvolutionalLayer::backward() {
         delete gradOutputWrapper;
     }
 }
+// with a fused activation, gradOutput is the gradient of our post-activation
+// output.  The direct kernels apply the derivative as they read gradOutput; for
+// the others, eg the gemm ones, we apply it here, in one pass shared by both
+void ConvolutionalLayer::backwardThroughActivation(CLWrapper *inputWrapper, CLWrapper *gradOutputWrapper) {
+    bool backwardApplies = backwardImpl == 0 || backwardImpl->appliesActivationDeriv();
+    bool weightsApplies = backpropWeightsImpl->appliesActivationDeriv();
+
+    WorkspaceScope workspace(cl);
+    CLWrapper *gradPreActivationWrapper = 0;
+    if(!backwardApplies || !weightsApplies) {
+        if(activationDeriv == 0) {
+            activationDeriv = ActivationBackward::instance(cl, dim.numFilters, dim.outputSize, dim.activation);
+        }
+        gradPreActivationWrapper = workspace.acquire(batchSize * dim.outputCubeSize);
+        activationDeriv->backward(batchSize, outputWrapper, gradOutputWrapper, gradPreActivationWrapper);
+    }
+
+    if(previousLayer->needsBackProp()) {
+        if(backwardApplies) {
+            backwardImpl->backwardThroughActivation(batchSize, inputWrapper, gradOutputWrapper, outputWrapper, weightsWrapper, gradInputWrapper);
+        } else {
+            backwardImpl->backward(batchSize, inputWrapper, gradPreActivationWrapper, weightsWrapper, gradInputWrapper);
+        }
+    }
+    if(weightsApplies) {
+        backpropWeightsImpl->calcGradWeightsThroughActivation(batchSize, gradOutputWrapper, outputWrapper, inputWrapper, gradWeightsWrapper, gradBiasWrapper);
+    } else {
+        backpropWeightsImpl->calcGradWeights(batchSize, gradPreActivationWrapper, inputWrapper, gradWeightsWrapper, gradBiasWrapper);
+    }
+}
 //VIRTUAL void ConvolutionalLayer::setWeights(CLWrapper *weightWrapper, CLWrapper *biasWrapper) {
 //    copyBuffer->copy(getWeightsSize(), weightWrapper, this->weightsWrapper);
 //    if(dim.biased) {
@@ -23,6 +23,8 @@ class TrainerStateMaker;
 class Forward;
 class Backward;
 class BackpropWeights;
+class FftFilterCache;
+class ActivationBackward;
 class ConvolutionalMaker;
 class GpuAdd;
 class CopyBuffer;
@@ -37,6 +39,8 @@ public:
     Forward *forwardImpl;
     BackpropWeights *backpropWeightsImpl;
     Backward *backwardImpl;
+    FftFilterCache *filterCache; // shared by forwardImpl and backwardImpl
+    ActivationBackward *activationDeriv; // fused activation's derivative, when the impls dont apply it themselves
 
     LayerDimensions dim;
 //    ActivationFunction const *const activationFunction;
@@ -136,6 +140,10 @@ public:
     VIRTUAL void printWeights();
     VIRTUAL void printOutput();
     VIRTUAL void setBatchSize(int batchSize);
+    VIRTUAL bool canShareOutput() const;
+    VIRTUAL void setSharedOutput(float *output, CLWrapper *outputWrapper);
+    VIRTUAL bool canFuseActivation() const;
+    VIRTUAL void fuseActivation(ActivationFunction const *activation);
     VIRTUAL void setWeights(float *weights, float *bias);
     VIRTUAL int getOutputCubeSize() const;
     VIRTUAL int getPersistSize(int version) const;
@@ -152,6 +160,7 @@ public:
     VIRTUAL float * getOutput();
     VIRTUAL void forward();
     VIRTUAL void backward();
+    void backwardThroughActivation(CLWrapper *inputWrapper, CLWrapper *gradOutputWrapper);
     VIRTUAL std::string asString() const;
     VIRTUAL bool needsTrainerState() const;
     VIRTUAL bool biased();
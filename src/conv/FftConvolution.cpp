@@ -0,0 +1,596 @@
+// Copyright Hugh Perkins 2015 hughperkins at gmail
+//
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file, You can
+// obtain one at http://mozilla.org/MPL/2.0/.
+
+#include <iostream>
+#include <stdexcept>
+#include <algorithm>
+
+#include "EasyCL.h"
+#include "activate/ActivationFunction.h"
+#include "util/stringhelper.h"
+#include "util/KernelCache.h"
+#include "util/WorkspaceScope.h"
+#include "conv/FftFilterCache.h"
+
+#include "conv/FftConvolution.h"
+
+using namespace std;
+
+#undef STATIC
+#undef VIRTUAL
+#define STATIC
+#define VIRTUAL
+#define PUBLIC
+
+// scratch budget for the grids and spectra of each chunk of images
+#define FFT_WORKSPACE_MB 256
+
+PUBLIC STATIC bool FftConvolution::supports(LayerDimensions dim) {
+    return dim.skip == 0 && !(dim.isEven && dim.padZeros);
+}
+PUBLIC STATIC int FftConvolution::chooseGridSize(LayerDimensions dim) {
+    const int margin = dim.padZeros ? dim.halfFilterSize : 0;
+    int gridSize = 4;
+    while(gridSize < dim.inputSize + 2 * margin) {
+        gridSize <<= 1;
+    }
+    return gridSize;
+}
+/// whether the spectra multiplies are enough cheaper than direct convolution
+/// to pay for the transforms: not for small filters, nor for small outputs,
+/// like fully connected layers, where the grid is mostly padding
+PUBLIC STATIC bool FftConvolution::worthwhile(LayerDimensions dim) {
+    if(!supports(dim) || dim.filterSize < 7) {
+        return false;
+    }
+    // a complex multiply-add is 4 real ones, then allow as much again for the transforms
+    const int gridSize = chooseGridSize(dim);
+    const int64 fftCost = (int64)8 * gridSize * (gridSize / 2 + 1);
+    const int64 directCost = (int64)dim.filterSizeSquared * dim.outputSizeSquared;
+    return fftCost < directCost;
+}
+PUBLIC FftConvolution::FftConvolution(EasyCL *cl, LayerDimensions dim) :
+        cl(cl),
+        dim(dim),
+        kernelLoad(0),
+        kernelPass(0),
+        kernelHermitian(0),
+        kernelMultiplyForward(0),
+        kernelMultiplyBackward(0),
+        kernelMultiplyWeights(0),
+        kernelStore(0),
+        kernelStoreForward(0) {
+    if(dim.skip != 0) {
+        throw runtime_error("FftConvolution: skip not supported");
+    }
+    if(dim.isEven && dim.padZeros) {
+        throw runtime_error("FftConvolution: even filter sizes not supported with padZeros");
+    }
+    margin = dim.padZeros ? dim.halfFilterSize : 0;
+    gridSize = chooseGridSize(dim);
+    halfSize = gridSize / 2 + 1;
+    numBins = gridSize * halfSize;
+    buildKernels();
+}
+PUBLIC VIRTUAL FftConvolution::~FftConvolution() {
+    // kernels are owned by cl
+}
+/// floats needed for the spectra of numPlanes planes
+PUBLIC int FftConvolution::getSpectraSize(int numPlanes) {
+    return numPlanes * numBins * 2;
+}
+/// the spectra of weightsWrapper, from filterCache if still valid for
+/// them, otherwise transformed into it
+PUBLIC CLWrapper *FftConvolution::getFilterSpectra(FftFilterCache *filterCache, CLWrapper *weightsWrapper) {
+    if(filterCache->isValidFor(weightsWrapper, gridSize)) {
+        return filterCache->getSpectraWrapper();
+    }
+    const int numPlanes = dim.numFilters * dim.inputPlanes;
+    CLWrapper *spectraWrapper = filterCache->reserve(getSpectraSize(numPlanes));
+    const int planesPerBatch = getPlanesPerBatch(numPlanes);
+    WorkspaceScope workspace(cl);
+    CLWrapper *grid0Wrapper = workspace.acquire(getGridsSize(planesPerBatch));
+    CLWrapper *grid1Wrapper = workspace.acquire(getGridsSize(planesPerBatch));
+    for(int planeStart = 0; planeStart < numPlanes; planeStart += planesPerBatch) {
+        const int thisNumPlanes = std::min(planesPerBatch, numPlanes - planeStart);
+        transform(thisNumPlanes, dim.filterSize, 0, weightsWrapper, planeStart * dim.filterSizeSquared,
+            grid0Wrapper, grid1Wrapper, spectraWrapper, planeStart * numBins);
+    }
+    cl->finish();
+    filterCache->setValid(weightsWrapper, gridSize);
+    return spectraWrapper;
+}
+/// output = input convolved with filters, plus bias, then the activation, if
+/// any.  biasWrapper is only read if biased
+PUBLIC void FftConvolution::forward(int batchSize, CLWrapper *inputWrapper, CLWrapper *filterSpectraWrapper, CLWrapper *biasWrapper, CLWrapper *outputWrapper) {
+    const int maxPlanes = std::max(dim.inputPlanes, dim.numFilters);
+    const int chunkSize = getChunkSize(batchSize);
+    WorkspaceScope workspace(cl);
+    CLWrapper *grid0Wrapper = workspace.acquire(getGridsSize(chunkSize * maxPlanes));
+    CLWrapper *grid1Wrapper = workspace.acquire(getGridsSize(chunkSize * maxPlanes));
+    CLWrapper *inputSpectraWrapper = workspace.acquire(getSpectraSize(chunkSize * dim.inputPlanes));
+    CLWrapper *outputSpectraWrapper = workspace.acquire(getSpectraSize(chunkSize * dim.numFilters));
+    if(!outputWrapper->isOnDevice()) {
+        outputWrapper->createOnDevice();
+    }
+    for(int chunkStart = 0; chunkStart < batchSize; chunkStart += chunkSize) {
+        const int thisChunkSize = std::min(chunkSize, batchSize - chunkStart);
+        transform(thisChunkSize * dim.inputPlanes, dim.inputSize, margin, inputWrapper, chunkStart * dim.inputCubeSize,
+            grid0Wrapper, grid1Wrapper, inputSpectraWrapper, 0);
+        kernelMultiplyForward->in(thisChunkSize)->in(inputSpectraWrapper)->in(filterSpectraWrapper)
+            ->out(outputSpectraWrapper);
+        run(kernelMultiplyForward, thisChunkSize * dim.numFilters * numBins);
+        inverse(thisChunkSize * dim.numFilters, outputSpectraWrapper, 0, grid0Wrapper, grid1Wrapper,
+            kernelStoreForward, dim.outputSize, 0, dim.biased ? biasWrapper : 0,
+            outputWrapper, chunkStart * dim.outputCubeSize);
+    }
+    cl->finish();
+}
+PUBLIC void FftConvolution::backward(int batchSize, CLWrapper *gradOutputWrapper, CLWrapper *filterSpectraWrapper, CLWrapper *gradInputWrapper) {
+    const int maxPlanes = std::max(dim.inputPlanes, dim.numFilters);
+    const int chunkSize = getChunkSize(batchSize);
+    WorkspaceScope workspace(cl);
+    CLWrapper *grid0Wrapper = workspace.acquire(getGridsSize(chunkSize * maxPlanes));
+    CLWrapper *grid1Wrapper = workspace.acquire(getGridsSize(chunkSize * maxPlanes));
+    CLWrapper *gradOutputSpectraWrapper = workspace.acquire(getSpectraSize(chunkSize * dim.numFilters));
+    CLWrapper *gradInputSpectraWrapper = workspace.acquire(getSpectraSize(chunkSize * dim.inputPlanes));
+    if(!gradInputWrapper->isOnDevice()) {
+        gradInputWrapper->createOnDevice();
+    }
+    for(int chunkStart = 0; chunkStart < batchSize; chunkStart += chunkSize) {
+        const int thisChunkSize = std::min(chunkSize, batchSize - chunkStart);
+        transform(thisChunkSize * dim.numFilters, dim.outputSize, 0, gradOutputWrapper, chunkStart * dim.outputCubeSize,
+            grid0Wrapper, grid1Wrapper, gradOutputSpectraWrapper, 0);
+        kernelMultiplyBackward->in(thisChunkSize)->in(gradOutputSpectraWrapper)->in(filterSpectraWrapper)
+            ->out(gradInputSpectraWrapper);
+        run(kernelMultiplyBackward, thisChunkSize * dim.inputPlanes * numBins);
+        inverse(thisChunkSize * dim.inputPlanes, gradInputSpectraWrapper, 0, grid0Wrapper, grid1Wrapper,
+            kernelStore, dim.inputSize, margin, 0, gradInputWrapper, chunkStart * dim.inputCubeSize);
+    }
+    cl->finish();
+}
+/// gradWeights only, overwriting it; the bias gradient is left to the caller
+PUBLIC void FftConvolution::calcGradWeights(int batchSize, CLWrapper *gradOutputWrapper, CLWrapper *inputWrapper, CLWrapper *gradWeightsWrapper) {
+    const int numWeightPlanes = dim.numFilters * dim.inputPlanes;
+    const int maxPlanes = std::max(dim.inputPlanes, dim.numFilters);
+    const int chunkSize = getChunkSize(batchSize);
+    WorkspaceScope workspace(cl);
+    CLWrapper *grid0Wrapper = workspace.acquire(getGridsSize(chunkSize * maxPlanes));
+    CLWrapper *grid1Wrapper = workspace.acquire(getGridsSize(chunkSize * maxPlanes));
+    CLWrapper *inputSpectraWrapper = workspace.acquire(getSpectraSize(chunkSize * dim.inputPlanes));
+    CLWrapper *gradOutputSpectraWrapper = workspace.acquire(getSpectraSize(chunkSize * dim.numFilters));
+    CLWrapper *gradWeightsSpectraWrapper = workspace.acquire(getSpectraSize(numWeightPlanes));
+    if(!gradWeightsWrapper->isOnDevice()) {
+        gradWeightsWrapper->createOnDevice();
+    }
+    for(int chunkStart = 0; chunkStart < batchSize; chunkStart += chunkSize) {
+        const int thisChunkSize = std::min(chunkSize, batchSize - chunkStart);
+        transform(thisChunkSize * dim.inputPlanes, dim.inputSize, margin, inputWrapper, chunkStart * dim.inputCubeSize,
+            grid0Wrapper, grid1Wrapper, inputSpectraWrapper, 0);
+        transform(thisChunkSize * dim.numFilters, dim.outputSize, 0, gradOutputWrapper, chunkStart * dim.outputCubeSize,
+            grid0Wrapper, grid1Wrapper, gradOutputSpectraWrapper, 0);
+        kernelMultiplyWeights->in(thisChunkSize)->in(chunkStart > 0 ? 1 : 0)
+            ->in(inputSpectraWrapper)->in(gradOutputSpectraWrapper)->inout(gradWeightsSpectraWrapper);
+        run(kernelMultiplyWeights, numWeightPlanes * numBins);
+    }
+    // the grids hold chunkSize * maxPlanes planes
+    const int planesPerBatch = chunkSize * maxPlanes;
+    for(int planeStart = 0; planeStart < numWeightPlanes; planeStart += planesPerBatch) {
+        const int thisNumPlanes = std::min(planesPerBatch, numWeightPlanes - planeStart);
+        inverse(thisNumPlanes, gradWeightsSpectraWrapper, planeStart * numBins, grid0Wrapper, grid1Wrapper,
+            kernelStore, dim.filterSize, 0, 0, gradWeightsWrapper, planeStart * dim.filterSizeSquared);
+    }
+    cl->finish();
+}
+// floats in a grid of numPlanes planes
+PRIVATE int FftConvolution::getGridsSize(int numPlanes) {
+    return numPlanes * gridSize * gridSize * 2;
+}
+// how many of numPlanes planes to transform at once, with two grids each,
+// within FFT_WORKSPACE_MB
+PRIVATE int FftConvolution::getPlanesPerBatch(int numPlanes) {
+    int64 gridBytesPerPlane = (int64)getGridsSize(1) * sizeof(float);
+    int64 budgetBytes = (int64)FFT_WORKSPACE_MB * 1024 * 1024;
+    int64 maxAllocBytes = (int64)cl->getMaxAllocSizeMB() * 1024 * 1024;
+    int64 planesPerBatch = budgetBytes / (2 * gridBytesPerPlane);
+    planesPerBatch = std::min(planesPerBatch, maxAllocBytes / gridBytesPerPlane);
+    planesPerBatch = std::min(planesPerBatch, (int64)numPlanes);
+    return std::max((int)planesPerBatch, 1);
+}
+// how many images per chunk, within FFT_WORKSPACE_MB: the grids hold
+// max(inputPlanes, numFilters) planes per image, the spectra inputPlanes +
+// numFilters
+PRIVATE int FftConvolution::getChunkSize(int batchSize) {
+    const int maxPlanes = std::max(dim.inputPlanes, dim.numFilters);
+    int64 gridBytesPerImage = (int64)maxPlanes * getGridsSize(1) * sizeof(float);
+    int64 spectraBytesPerImage = (int64)(dim.inputPlanes + dim.numFilters) * getSpectraSize(1) * sizeof(float);
+    int64 budgetBytes = (int64)FFT_WORKSPACE_MB * 1024 * 1024;
+    int64 maxAllocBytes = (int64)cl->getMaxAllocSizeMB() * 1024 * 1024;
+    int64 chunkSize = budgetBytes / (2 * gridBytesPerImage + spectraBytesPerImage);
+    chunkSize = std::min(chunkSize, maxAllocBytes / gridBytesPerImage);
+    chunkSize = std::min(chunkSize, (int64)batchSize);
+    return std::max((int)chunkSize, 1);
+}
+// numPlanes real size x size planes, from images + imagesOffset, placed at
+// (pad, pad), into compact spectra at spectraOffset, in complex values
+// grid0 and grid1 each hold numPlanes planes
+PRIVATE void FftConvolution::transform(int numPlanes, int size, int pad, CLWrapper *imagesWrapper, int imagesOffset, CLWrapper *grid0Wrapper, CLWrapper *grid1Wrapper, CLWrapper *spectraWrapper, int spectraOffset) {
+    const int planeStride = gridSize * gridSize;
+    kernelLoad->in(numPlanes)->in(size)->in(pad)->in(imagesWrapper)->in(imagesOffset)->out(grid0Wrapper);
+    run(kernelLoad, numPlanes * planeStride);
+    CLWrapper *current = grid0Wrapper;
+    CLWrapper *other = grid1Wrapper;
+    // rows: all of them
+    for(int p = 1; p < gridSize; p <<= 1) {
+        pass(numPlanes * gridSize, gridSize, p, 1.0f,
+            current, 0, planeStride, gridSize, 1,
+            other, 0, planeStride, gridSize, 1);
+        std::swap(current, other);
+    }
+    // columns: only the first halfSize, the rest are their conjugates, the
+    // last pass writing straight into the compact spectra
+    for(int p = 1; p < gridSize; p <<= 1) {
+        if(p * 2 == gridSize) {
+            pass(numPlanes * halfSize, halfSize, p, 1.0f,
+                current, 0, planeStride, 1, gridSize,
+                spectraWrapper, spectraOffset, numBins, 1, halfSize);
+        } else {
+            pass(numPlanes * halfSize, halfSize, p, 1.0f,
+                current, 0, planeStride, 1, gridSize,
+                other, 0, planeStride, 1, gridSize);
+            std::swap(current, other);
+        }
+    }
+}
+// inverse of transform, from spectra at spectraOffset, in complex values,
+// then store crops size x size planes at (crop, crop) into output +
+// outputOffset.  biasWrapper only for kernelStoreForward, when biased
+PRIVATE void FftConvolution::inverse(int numPlanes, CLWrapper *spectraWrapper, int spectraOffset, CLWrapper *grid0Wrapper, CLWrapper *grid1Wrapper, CLKernel *store, int size, int crop, CLWrapper *biasWrapper, CLWrapper *outputWrapper, int outputOffset) {
+    const int planeStride = gridSize * gridSize;
+    CLWrapper *current = grid0Wrapper;
+    CLWrapper *other = grid1Wrapper;
+    // columns, the first pass reading the compact spectra
+    for(int p = 1; p < gridSize; p <<= 1) {
+        if(p == 1) {
+            pass(numPlanes * halfSize, halfSize, p, -1.0f,
+                spectraWrapper, spectraOffset, numBins, 1, halfSize,
+                current, 0, planeStride, 1, gridSize);
+        } else {
+            pass(numPlanes * halfSize, halfSize, p, -1.0f,
+                current, 0, planeStride, 1, gridSize,
+                other, 0, planeStride, 1, gridSize);
+            std::swap(current, other);
+        }
+    }
+    kernelHermitian->in(numPlanes * gridSize)->inout(current);
+    run(kernelHermitian, numPlanes * gridSize * (gridSize - halfSize));
+    for(int p = 1; p < gridSize; p <<= 1) {
+        pass(numPlanes * gridSize, gridSize, p, -1.0f,
+            current, 0, planeStride, gridSize, 1,
+            other, 0, planeStride, gridSize, 1);
+        std::swap(current, other);
+    }
+    store->in(numPlanes)->in(size)->in(crop)->in(current)
+        ->in(biasWrapper != 0 ? biasWrapper : current) // not read, if not biased
+        ->out(outputWrapper)->in(outputOffset);
+    run(store, numPlanes * size * size);
+}
+// one radix-2 pass over numTransforms transforms, see fft_pass in cl/fft.cl
+PRIVATE void FftConvolution::pass(int numTransforms, int transformsPerPlane, int p, float direction, CLWrapper *inWrapper, int inOffset, int inPlaneStride, int inTransformStride, int inElemStride, CLWrapper *outWrapper, int outOffset, int outPlaneStride, int outTransformStride, int outElemStride) {
+    kernelPass->in(numTransforms)->in(transformsPerPlane)->in(p)->in(direction)
+        ->in(inWrapper)->in(inOffset)->in(inPlaneStride)->in(inTransformStride)->in(inElemStride)
+        ->out(outWrapper)->in(outOffset)->in(outPlaneStride)->in(outTransformStride)->in(outElemStride);
+    run(kernelPass, numTransforms * (gridSize / 2));
+}
+PRIVATE void FftConvolution::run(CLKernel *kernel, int numThreads) {
+    const int workgroupSize = 64;
+    const int numWorkgroups = (numThreads + workgroupSize - 1) / workgroupSize;
+    kernel->run_1d(numWorkgroups * workgroupSize, workgroupSize);
+}
+PRIVATE void FftConvolution::buildKernels() {
+    string options = "";
+    options += " -D gP=" + toString(gridSize);
+    options += " -D gH=" + toString(halfSize);
+    options += " -D gInputPlanes=" + toString(dim.inputPlanes);
+    options += " -D gNumFilters=" + toString(dim.numFilters);
+    // the forward store also adds the bias, and the activation
+    string forwardOptions = options;
+    if(dim.biased) {
+        forwardOptions += " -D BIASED";
+    }
+    if(dim.activation != 0) {
+        forwardOptions += " -D " + string(dim.activation->getDefineName());
+    }
+    const string suffix = forwardOptions;
+    string kernelName = "FftConvolution.fft_pass" + suffix;
+    if(cl->kernelExists(kernelName)) {
+        kernelPass = cl->getKernel(kernelName);
+        kernelLoad = cl->getKernel("FftConvolution.fft_load" + suffix);
+        kernelHermitian = cl->getKernel("FftConvolution.fft_hermitian" + suffix);
+        kernelMultiplyForward = cl->getKernel("FftConvolution.fft_multiply_forward" + suffix);
+        kernelMultiplyBackward = cl->getKernel("FftConvolution.fft_multiply_backward" + suffix);
+        kernelMultiplyWeights = cl->getKernel("FftConvolution.fft_multiply_weights" + suffix);
+        kernelStore = cl->getKernel("FftConvolution.fft_store" + suffix);
+        kernelStoreForward = cl->getKernel("FftConvolution.fft_store_forward" + suffix);
+        return;
+    }
+    // [[[cog
+    // import stringify
+    // stringify.write_kernel2("kernelPass", "cl/fft.cl", "fft_pass", 'options')
+    // ]]]
+    // generated using cog, from cl/fft.cl:
+    const char * kernelPassSource =  
+    "// Copyright Hugh Perkins 2015 hughperkins at gmail\n"
+    "//\n"
+    "// This Source Code Form is subject to the terms of the Mozilla Public License,\n"
+    "// v. 2.0. If a copy of the MPL was not distributed with this file, You can\n"
+    "// obtain one at http://mozilla.org/MPL/2.0/.\n"
+    "\n"
+    "// fft convolution, see FftConvolution.h\n"
+    "// planes are zero-padded into a gP x gP grid of complex values, [plane][row][col]\n"
+    "// spectra of real planes only keep columns [0, gH), gH = gP / 2 + 1, and are\n"
+    "// stored compact, as [plane][row][gH]\n"
+    "// complex values are float2, .x real, .y imaginary\n"
+    "\n"
+    "// expected defines:\n"
+    "// gP: grid size, a power of 2\n"
+    "// gH: gP / 2 + 1\n"
+    "// gInputPlanes, gNumFilters (multiply kernels)\n"
+    "// BIASED (optional, fft_store)\n"
+    "// one of: [ TANH | RELU | LINEAR | SIGMOID | SCALEDTANH | ELU ] (optional, fft_store)\n"
+    "\n"
+    "// including cl/activate_defines.cl:\n"
+    "// Copyright Hugh Perkins 2015 hughperkins at gmail\n"
+    "//\n"
+    "// This Source Code Form is subject to the terms of the Mozilla Public License,\n"
+    "// v. 2.0. If a copy of the MPL was not distributed with this file, You can\n"
+    "// obtain one at http://mozilla.org/MPL/2.0/.\n"
+    "\n"
+    "// ACTIVATION_FUNCTION, for kernels that fuse an activation into their output,\n"
+    "// and ACTIVATION_DERIV, its derivative, written in terms of that output, for\n"
+    "// kernels that fuse it into reading gradOutput;\n"
+    "// both left undefined if none of the activation defines is given\n"
+    "// one of: [ TANH | RELU | LINEAR | SIGMOID | SCALEDTANH | ELU ] (optional)\n"
+    "\n"
+    "#ifdef TANH\n"
+    "    #define ACTIVATION_FUNCTION(output) (tanh(output))\n"
+    "#elif defined SCALEDTANH\n"
+    "    #define ACTIVATION_FUNCTION(output) (1.7159f * tanh(0.66667f * output))\n"
+    "#elif defined SIGMOID\n"
+    "    #define ACTIVATION_FUNCTION(output) (1.0f / (1 + exp(-output)))\n"
+    "#elif defined RELU\n"
+    "    #define ACTIVATION_FUNCTION(output) (output> 0 ? output : 0)\n"
+    "#elif defined ELU\n"
+    "    #define ACTIVATION_FUNCTION(output) (output> 0 ? output : exp(output) - 1)\n"
+    "#elif defined LINEAR\n"
+    "    #define ACTIVATION_FUNCTION(output) (output)\n"
+    "#endif\n"
+    "\n"
+    "#ifdef TANH\n"
+    "    #define ACTIVATION_DERIV(output) (1 - output * output)\n"
+    "#elif defined SCALEDTANH\n"
+    "    #define ACTIVATION_DERIV(output) (0.66667f * (1.7159f - 1 / 1.7159f * output * output) )\n"
+    "#elif defined SIGMOID\n"
+    "    #define ACTIVATION_DERIV(output) (output * (1 - output) )\n"
+    "#elif defined RELU\n"
+    "    #define ACTIVATION_DERIV(output) (output > 0 ? 1 : 0)\n"
+    "#elif defined ELU\n"
+    "    #define ACTIVATION_DERIV(output) (output > 0 ? 1 : output + 1)\n"
+    "#elif defined LINEAR\n"
+    "    #define ACTIVATION_DERIV(output) (1.0f)\n"
+    "#endif\n"
+    "\n"
+    "\n"
+    "#define gBins (gP * gH)\n"
+    "\n"
+    "// a * b, or a * conj(b)\n"
+    "inline float2 complexMul(float2 a, float2 b) {\n"
+    "    float2 result;\n"
+    "    result.x = a.x * b.x - a.y * b.y;\n"
+    "    result.y = a.x * b.y + a.y * b.x;\n"
+    "    return result;\n"
+    "}\n"
+    "inline float2 complexMulConj(float2 a, float2 b) {\n"
+    "    float2 result;\n"
+    "    result.x = a.x * b.x + a.y * b.y;\n"
+    "    result.y = a.y * b.x - a.x * b.y;\n"
+    "    return result;\n"
+    "}\n"
+    "\n"
+    "// numPlanes real planes of size x size, from images + imagesOffset, placed\n"
+    "// at (pad, pad) in the grid, zeros elsewhere\n"
+    "kernel void fft_load(const int numPlanes, const int size, const int pad,\n"
+    "        global const float *images, const int imagesOffset, global float2 *grid) {\n"
+    "    const int globalId = get_global_id(0);\n"
+    "    if(globalId >= numPlanes * gP * gP) {\n"
+    "        return;\n"
+    "    }\n"
+    "    const int col = globalId % gP - pad;\n"
+    "    const int row = (globalId / gP) % gP - pad;\n"
+    "    const int plane = globalId / gP / gP;\n"
+    "    float2 value;\n"
+    "    value.x = 0;\n"
+    "    value.y = 0;\n"
+    "    if(row >= 0 && row < size && col >= 0 && col < size) {\n"
+    "        value.x = images[imagesOffset + (plane * size + row) * size + col];\n"
+    "    }\n"
+    "    grid[globalId] = value;\n"
+    "}\n"
+    "\n"
+    "// one radix-2 pass of a Stockham fft of length gP, over numTransforms\n"
+    "// transforms, each writing its own output, so no bit reversal pass is needed\n"
+    "// p is 1, 2, 4, ..., gP / 2 over the passes; direction is 1 forward, -1 inverse\n"
+    "// transform t, of transformsPerPlane per plane, starts at\n"
+    "// offset + (t / transformsPerPlane) * planeStride + (t % transformsPerPlane) * transformStride\n"
+    "// and its elements are elemStride apart.  Rows and columns of the grid, and\n"
+    "// columns of compact spectra, are all just different strides\n"
+    "kernel void fft_pass(const int numTransforms, const int transformsPerPlane, const int p, const float direction,\n"
+    "        global const float2 *in, const int inOffset, const int inPlaneStride, const int inTransformStride, const int inElemStride,\n"
+    "        global float2 *out, const int outOffset, const int outPlaneStride, const int outTransformStride, const int outElemStride) {\n"
+    "    const int globalId = get_global_id(0);\n"
+    "    const int halfP = gP >> 1;\n"
+    "    if(globalId >= numTransforms * halfP) {\n"
+    "        return;\n"
+    "    }\n"
+    "    // neighbouring threads should read neighbouring elements\n"
+    "    int transform;\n"
+    "    int i;\n"
+    "    if(inElemStride == 1) {\n"
+    "        i = globalId % halfP;\n"
+    "        transform = globalId / halfP;\n"
+    "    } else {\n"
+    "        transform = globalId % numTransforms;\n"
+    "        i = globalId / numTransforms;\n"
+    "    }\n"
+    "    const int plane = transform / transformsPerPlane;\n"
+    "    const int planeTransform = transform % transformsPerPlane;\n"
+    "    global const float2 *src = in + inOffset + plane * inPlaneStride + planeTransform * inTransformStride;\n"
+    "    global float2 *dst = out + outOffset + plane * outPlaneStride + planeTransform * outTransformStride;\n"
+    "\n"
+    "    const int k = i & (p - 1);\n"
+    "    float2 a0 = src[i * inElemStride];\n"
+    "    float2 a1 = src[(i + halfP) * inElemStride];\n"
+    "    const float angle = -direction * 3.14159265358979f * k / p;\n"
+    "    float2 twiddle;\n"
+    "    twiddle.x = cos(angle);\n"
+    "    twiddle.y = sin(angle);\n"
+    "    a1 = complexMul(a1, twiddle);\n"
+    "    const int j = (i << 1) - k;\n"
+    "    float2 sum;\n"
+    "    sum.x = a0.x + a1.x;\n"
+    "    sum.y = a0.y + a1.y;\n"
+    "    float2 diff;\n"
+    "    diff.x = a0.x - a1.x;\n"
+    "    diff.y = a0.y - a1.y;\n"
+    "    dst[j * outElemStride] = sum;\n"
+    "    dst[(j + p) * outElemStride] = diff;\n"
+    "}\n"
+    "\n"
+    "// rows of a real plane's spectrum are conjugate symmetric, so fill columns\n"
+    "// (gP / 2, gP) of each grid row from columns [1, gP / 2)\n"
+    "kernel void fft_hermitian(const int numRows, global float2 *grid) {\n"
+    "    const int globalId = get_global_id(0);\n"
+    "    const int numFill = gP - gH;\n"
+    "    if(globalId >= numRows * numFill) {\n"
+    "        return;\n"
+    "    }\n"
+    "    const int col = gH + globalId % numFill;\n"
+    "    const int row = globalId / numFill;\n"
+    "    float2 value = grid[row * gP + gP - col];\n"
+    "    value.y = -value.y;\n"
+    "    grid[row * gP + col] = value;\n"
+    "}\n"
+    "\n"
+    "// output[n][f] = sum over c of input[n][c] * conj(filters[f][c])\n"
+    "kernel void fft_multiply_forward(const int numImages,\n"
+    "        global const float2 *inputSpectra, global const float2 *filterSpectra, global float2 *outputSpectra) {\n"
+    "    const int globalId = get_global_id(0);\n"
+    "    if(globalId >= numImages * gNumFilters * gBins) {\n"
+    "        return;\n"
+    "    }\n"
+    "    const int bin = globalId % gBins;\n"
+    "    const int filter = (globalId / gBins) % gNumFilters;\n"
+    "    const int n = globalId / gBins / gNumFilters;\n"
+    "    float2 sum;\n"
+    "    sum.x = 0;\n"
+    "    sum.y = 0;\n"
+    "    for(int c = 0; c < gInputPlanes; c++) {\n"
+    "        float2 product = complexMulConj(inputSpectra[(n * gInputPlanes + c) * gBins + bin],\n"
+    "            filterSpectra[(filter * gInputPlanes + c) * gBins + bin]);\n"
+    "        sum.x += product.x;\n"
+    "        sum.y += product.y;\n"
+    "    }\n"
+    "    outputSpectra[globalId] = sum;\n"
+    "}\n"
+    "\n"
+    "// gradInput[n][c] = sum over f of gradOutput[n][f] * filters[f][c]\n"
+    "kernel void fft_multiply_backward(const int numImages,\n"
+    "        global const float2 *gradOutputSpectra, global const float2 *filterSpectra, global float2 *gradInputSpectra) {\n"
+    "    const int globalId = get_global_id(0);\n"
+    "    if(globalId >= numImages * gInputPlanes * gBins) {\n"
+    "        return;\n"
+    "    }\n"
+    "    const int bin = globalId % gBins;\n"
+    "    const int c = (globalId / gBins) % gInputPlanes;\n"
+    "    const int n = globalId / gBins / gInputPlanes;\n"
+    "    float2 sum;\n"
+    "    sum.x = 0;\n"
+    "    sum.y = 0;\n"
+    "    for(int filter = 0; filter < gNumFilters; filter++) {\n"
+    "        float2 product = complexMul(gradOutputSpectra[(n * gNumFilters + filter) * gBins + bin],\n"
+    "            filterSpectra[(filter * gInputPlanes + c) * gBins + bin]);\n"
+    "        sum.x += product.x;\n"
+    "        sum.y += product.y;\n"
+    "    }\n"
+    "    gradInputSpectra[globalId] = sum;\n"
+    "}\n"
+    "\n"
+    "// gradWeights[f][c] (+)= sum over n of input[n][c] * conj(gradOutput[n][f])\n"
+    "kernel void fft_multiply_weights(const int numImages, const int accumulate,\n"
+    "        global const float2 *inputSpectra, global const float2 *gradOutputSpectra, global float2 *gradWeightsSpectra) {\n"
+    "    const int globalId = get_global_id(0);\n"
+    "    if(globalId >= gNumFilters * gInputPlanes * gBins) {\n"
+    "        return;\n"
+    "    }\n"
+    "    const int bin = globalId % gBins;\n"
+    "    const int c = (globalId / gBins) % gInputPlanes;\n"
+    "    const int filter = globalId / gBins / gInputPlanes;\n"
+    "    float2 sum;\n"
+    "    sum.x = 0;\n"
+    "    sum.y = 0;\n"
+    "    if(accumulate) {\n"
+    "        sum = gradWeightsSpectra[globalId];\n"
+    "    }\n"
+    "    for(int n = 0; n < numImages; n++) {\n"
+    "        float2 product = complexMulConj(inputSpectra[(n * gInputPlanes + c) * gBins + bin],\n"
+    "            gradOutputSpectra[(n * gNumFilters + filter) * gBins + bin]);\n"
+    "        sum.x += product.x;\n"
+    "        sum.y += product.y;\n"
+    "    }\n"
+    "    gradWeightsSpectra[globalId] = sum;\n"
+    "}\n"
+    "\n"
+    "// real parts of grid[plane][crop + row][crop + col], for row, col in [0, size),\n"
+    "// scaled by 1 / (gP * gP), for the inverse fft, into output + outputOffset\n"
+    "// plane is [n][filter] when BIASED\n"
+    "kernel void fft_store(const int numPlanes, const int size, const int crop,\n"
+    "        global const float2 *grid, global const float *bias, global float *output, const int outputOffset) {\n"
+    "    const int globalId = get_global_id(0);\n"
+    "    if(globalId >= numPlanes * size * size) {\n"
+    "        return;\n"
+    "    }\n"
+    "    const int col = globalId % size;\n"
+    "    const int row = (globalId / size) % size;\n"
+    "    const int plane = globalId / size / size;\n"
+    "    float value = grid[(plane * gP + crop + row) * gP + crop + col].x * (1.0f / (gP * gP));\n"
+    "    #ifdef BIASED\n"
+    "    value += bias[plane % gNumFilters];\n"
+    "    #endif\n"
+    "    #ifdef ACTIVATION_FUNCTION\n"
+    "    value = ACTIVATION_FUNCTION(value);\n"
+    "    #endif\n"
+    "    output[outputOffset + globalId] = value;\n"
+    "}\n"
+    "\n"
+    "";
+    kernelPass = KernelCache::buildKernelFromString(cl, kernelPassSource, "fft_pass", options, "cl/fft.cl");
+    // [[[end]]]
+    kernelLoad = KernelCache::buildKernelFromString(cl, kernelPassSource, "fft_load", options, "cl/fft.cl");
+    kernelHermitian = KernelCache::buildKernelFromString(cl, kernelPassSource, "fft_hermitian", options, "cl/fft.cl");
+    kernelMultiplyForward = KernelCache::buildKernelFromString(cl, kernelPassSource, "fft_multiply_forward", options, "cl/fft.cl");
+    kernelMultiplyBackward = KernelCache::buildKernelFromString(cl, kernelPassSource, "fft_multiply_backward", options, "cl/fft.cl");
+    kernelMultiplyWeights = KernelCache::buildKernelFromString(cl, kernelPassSource, "fft_multiply_weights", options, "cl/fft.cl");
+    kernelStore = KernelCache::buildKernelFromString(cl, kernelPassSource, "fft_store", options, "cl/fft.cl");
+    kernelStoreForward = KernelCache::buildKernelFromString(cl, kernelPassSource, "fft_store", forwardOptions, "cl/fft.cl");
+    cl->storeKernel(kernelName, kernelPass, true);
+    cl->storeKernel("FftConvolution.fft_load" + suffix, kernelLoad, true);
+    cl->storeKernel("FftConvolution.fft_hermitian" + suffix, kernelHermitian, true);
+    cl->storeKernel("FftConvolution.fft_multiply_forward" + suffix, kernelMultiplyForward, true);
+    cl->storeKernel("FftConvolution.fft_multiply_backward" + suffix, kernelMultiplyBackward, true);
+    cl->storeKernel("FftConvolution.fft_multiply_weights" + suffix, kernelMultiplyWeights, true);
+    cl->storeKernel("FftConvolution.fft_store" + suffix, kernelStore, true);
+    cl->storeKernel("FftConvolution.fft_store_forward" + suffix, kernelStoreForward, true);
+}
@@ -0,0 +1,80 @@
+// Copyright Hugh Perkins 2015 hughperkins at gmail
+//
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file, You can
+// obtain one at http://mozilla.org/MPL/2.0/.
+
+#pragma once
+
+#include "LayerDimensions.h"
+
+class EasyCL;
+class CLWrapper;
+class CLKernel;
+class FftFilterCache;
+
+#include "DeepCLDllExport.h"
+
+#define STATIC static
+#define VIRTUAL virtual
+
+// fft convolution, shared by ForwardFft, BackwardFft and BackpropWeightsFft
+// each plane is zero-padded into a gridSize x gridSize grid, gridSize a power
+// of 2 at least inputSize + 2 * margin, so the circular convolution of the
+// grids contains the linear one.  Multiplying spectra costs the same whatever
+// the filter size, so this pays off for large filters, see worthwhile
+// - forward: output[n][f] = sum over c of input[n][c] * conj(filters[f][c])
+// - backward: gradInput[n][c] = sum over f of gradOutput[n][f] * filters[f][c]
+// - weights: gradWeights[f][c] = sum over n of input[n][c] * conj(gradOutput[n][f])
+// cropping the inverse at the right offset in each case
+// needs skip == 0; even filters only without padZeros
+class DeepCL_EXPORT FftConvolution {
+    public:
+    EasyCL *cl;
+    LayerDimensions dim;
+
+    int margin;
+    int gridSize;
+    int halfSize; // gridSize / 2 + 1, columns kept of real planes' spectra
+    int numBins; // gridSize * halfSize, complex values per spectrum
+
+    CLKernel *kernelLoad;
+    CLKernel *kernelPass;
+    CLKernel *kernelHermitian;
+    CLKernel *kernelMultiplyForward;
+    CLKernel *kernelMultiplyBackward;
+    CLKernel *kernelMultiplyWeights;
+    CLKernel *kernelStore;
+    CLKernel *kernelStoreForward; // adds bias, and activation, if any
+
+    // [[[cog
+    // import cog_addheaders
+    // cog_addheaders.addv2()
+    // ]]]
+    // generated, using cog:
+
+    public:
+    STATIC bool supports(LayerDimensions dim);
+    STATIC int chooseGridSize(LayerDimensions dim);
+    STATIC bool worthwhile(LayerDimensions dim);
+    FftConvolution(EasyCL *cl, LayerDimensions dim);
+    VIRTUAL ~FftConvolution();
+    int getSpectraSize(int numPlanes);
+    CLWrapper *getFilterSpectra(FftFilterCache *filterCache, CLWrapper *weightsWrapper);
+    void forward(int batchSize, CLWrapper *inputWrapper, CLWrapper *filterSpectraWrapper, CLWrapper *biasWrapper, CLWrapper *outputWrapper);
+    void backward(int batchSize, CLWrapper *gradOutputWrapper, CLWrapper *filterSpectraWrapper, CLWrapper *gradInputWrapper);
+    void calcGradWeights(int batchSize, CLWrapper *gradOutputWrapper, CLWrapper *inputWrapper, CLWrapper *gradWeightsWrapper);
+
+    private:
+    int getGridsSize(int numPlanes);
+    int getPlanesPerBatch(int numPlanes);
+    int getChunkSize(int batchSize);
+    void transform(int numPlanes, int size, int pad, CLWrapper *imagesWrapper, int imagesOffset, CLWrapper *grid0Wrapper, CLWrapper *grid1Wrapper, CLWrapper *spectraWrapper, int spectraOffset);
+    void inverse(int numPlanes, CLWrapper *spectraWrapper, int spectraOffset, CLWrapper *grid0Wrapper, CLWrapper *grid1Wrapper, CLKernel *store, int size, int crop, CLWrapper *biasWrapper, CLWrapper *outputWrapper, int outputOffset);
+    void pass(int numTransforms, int transformsPerPlane, int p, float direction, CLWrapper *inWrapper, int inOffset, int inPlaneStride, int inTransformStride, int inElemStride, CLWrapper *outWrapper, int outOffset, int outPlaneStride, int outTransformStride, int outElemStride);
+    void run(CLKernel *kernel, int numThreads);
+    void buildKernels();
+
+    // [[[end]]]
+};
+
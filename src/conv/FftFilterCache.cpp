@@ -0,0 +1,61 @@
+// Copyright Hugh Perkins 2015 hughperkins at gmail
+//
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file, You can
+// obtain one at http://mozilla.org/MPL/2.0/.
+
+#include "EasyCL.h"
+
+#include "conv/FftFilterCache.h"
+
+using namespace std;
+
+#undef STATIC
+#undef VIRTUAL
+#define STATIC
+#define VIRTUAL
+#define PUBLIC
+
+PUBLIC FftFilterCache::FftFilterCache(EasyCL *cl) :
+        cl(cl),
+        spectra(0),
+        spectraWrapper(0),
+        allocated(0),
+        weightsWrapper(0),
+        gridSize(0),
+        numTransforms(0) {
+}
+PUBLIC FftFilterCache::~FftFilterCache() {
+    delete spectraWrapper;
+    delete[] spectra;
+}
+PUBLIC void FftFilterCache::invalidate() {
+    weightsWrapper = 0;
+}
+PUBLIC bool FftFilterCache::isValidFor(CLWrapper *weightsWrapper, int gridSize) {
+    return this->weightsWrapper == weightsWrapper && this->gridSize == gridSize;
+}
+/// a device buffer of at least numFloats, to transform into, then call setValid
+PUBLIC CLWrapper *FftFilterCache::reserve(int numFloats) {
+    if(numFloats > allocated) {
+        delete spectraWrapper;
+        delete[] spectra;
+        spectra = new float[numFloats];
+        spectraWrapper = cl->wrap(numFloats, spectra);
+        spectraWrapper->createOnDevice();
+        allocated = numFloats;
+    }
+    return spectraWrapper;
+}
+PUBLIC void FftFilterCache::setValid(CLWrapper *weightsWrapper, int gridSize) {
+    this->weightsWrapper = weightsWrapper;
+    this->gridSize = gridSize;
+    numTransforms++;
+}
+PUBLIC CLWrapper *FftFilterCache::getSpectraWrapper() {
+    return spectraWrapper;
+}
+/// how many times the filters have been transformed, for tests
+PUBLIC int FftFilterCache::getNumTransforms() const {
+    return numTransforms;
+}
@@ -0,0 +1,52 @@
+// Copyright Hugh Perkins 2015 hughperkins at gmail
+//
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file, You can
+// obtain one at http://mozilla.org/MPL/2.0/.
+
+#pragma once
+
+#include "DeepCLDllExport.h"
+
+class EasyCL;
+class CLWrapper;
+
+#define VIRTUAL virtual
+#define STATIC static
+
+/// \brief a layer's filters, after the fft, shared by its fft forward and backward
+///
+/// so the filters are transformed once per weight update, rather than once
+/// per forward and once per backward.  ConvolutionalLayer owns one, hands it
+/// to its Forward and Backward with setFilterCache, and invalidates it whenever
+/// its weights might change: initWeights, and getWeightsWrapper, which is how
+/// the trainers get at them
+class DeepCL_EXPORT FftFilterCache {
+    private:
+    EasyCL *cl;
+    float *spectra;
+    CLWrapper *spectraWrapper;
+    int allocated; // floats
+    CLWrapper *weightsWrapper; // the weights the spectra are of, 0 if invalid
+    int gridSize; // fft size the spectra are for
+    int numTransforms;
+
+    // [[[cog
+    // import cog_addheaders
+    // cog_addheaders.addv2()
+    // ]]]
+    // generated, using cog:
+
+    public:
+    FftFilterCache(EasyCL *cl);
+    ~FftFilterCache();
+    void invalidate();
+    bool isValidFor(CLWrapper *weightsWrapper, int gridSize);
+    CLWrapper *reserve(int numFloats);
+    void setValid(CLWrapper *weightsWrapper, int gridSize);
+    CLWrapper *getSpectraWrapper();
+    int getNumTransforms() const;
+
+    // [[[end]]]
+};
+
@@ -10,6 +10,7 @@
 #include "conv/Forward.h"
 #include "util/stringhelper.h"
 #include "conv/ForwardCpu.h"
+#include "conv/ForwardCpuThreaded.h"
 #include "conv/Forward1.h"
 #include "conv/Forward2.h"
 #include "conv/Forward3.h"
@@ -17,8 +18,13 @@
 #include "conv/ForwardFc.h"
 #include "conv/ForwardByInputPlane.h"
 #include "conv/ForwardIm2Col.h"
+#include "conv/ForwardWinograd.h"
+#include "conv/ForwardWinogradCpu.h"
+#include "conv/Winograd.h"
+#include "conv/ForwardFft.h"
+#include "conv/FftConvolution.h"
 #include "conv/ForwardAuto.h"
-#include "util/StatefulTimer.h"
+#include "util/DeviceKey.h"
 
 using namespace std;
 
@@ -30,7 +36,8 @@ using namespace std;
 
 Forward::Forward(EasyCL *cl, LayerDimensions layerDimensions) :
         cl(cl),
-        dim(layerDimensions) {
+        dim(layerDimensions),
+        filterCache(0) {
 }
 STATIC Forward *Forward::instance(EasyCL *cl, LayerDimensions dim) {
     return new ForwardAuto(cl, dim);
@@ -54,15 +61,28 @@ STATIC Forward *Forward::instanceTest(EasyCL *cl, LayerDimensions layerDimension
     return new Forward2(cl, layerDimensions);
 }
 STATIC int Forward::getNumImplementations() {
-    return 8;
+    return 12;
 }
-STATIC bool Forward::plausiblyOptimal(int index, int batchSize, LayerDimensions dim) {
+// index 8 runs natively, on the host, and only makes sense when the OpenCL
+// device is that same host; ask for it by index or name otherwise
+STATIC bool Forward::plausiblyOptimal(int index, int batchSize, EasyCL *cl, LayerDimensions dim) {
     if(index == 0) { 
         return false;
     }
-    if(index > 7) {
+    if(index > 11) {
         return false;
     }
+    if(index == 8 && !DeviceKey::isCpu(cl)) {
+        return false;
+    }
+    if(index == 9 || index == 10) {
+        // winograd only saves multiplies for small filters
+        return Winograd::supports(dim) && (dim.filterSize == 3 || dim.filterSize == 5);
+    }
+    if(index == 11) {
+        // fft only pays for its transforms with large filters
+        return FftConvolution::worthwhile(dim);
+    }
     return true;
 }
 STATIC Forward *Forward::instanceSpecific(int idx, EasyCL *cl, LayerDimensions layerDimensions) {
@@ -87,6 +107,14 @@ STATIC Forward *Forward::instanceSpecific(int idx, EasyCL *cl, LayerDimensions l
         return new ForwardByInputPlane(cl, layerDimensions);
     } else if(idx == 7) {
         return new ForwardIm2Col(cl, layerDimensions);
+    } else if(idx == 8) {
+        return new ForwardCpuThreaded(cl, layerDimensions);
+    } else if(idx == 9) {
+        return new ForwardWinograd(cl, layerDimensions);
+    } else if(idx == 10) {
+        return new ForwardWinogradCpu(cl, layerDimensions);
+    } else if(idx == 11) {
+        return new ForwardFft(cl, layerDimensions);
     } else {
         throw runtime_error(string("") + __FILE__ + ":" + toString(__LINE__) + " Forward::instanceSpecific: no instance defined for index " + toString(idx));
     }
@@ -104,6 +132,14 @@ STATIC Forward *Forward::instanceSpecific(std::string name, EasyCL *cl, LayerDim
         return new ForwardFc(cl, layerDimensions);
     } else if(name == "byinplane") {
         return new ForwardByInputPlane(cl, layerDimensions);
+    } else if(name == "cputhreaded") {
+        return new ForwardCpuThreaded(cl, layerDimensions);
+    } else if(name == "winograd") {
+        return new ForwardWinograd(cl, layerDimensions);
+    } else if(name == "winogradcpu") {
+        return new ForwardWinogradCpu(cl, layerDimensions);
+    } else if(name == "fft") {
+        return new ForwardFft(cl, layerDimensions);
     } else {
         throw runtime_error(string("") + __FILE__ + ":" + toString(__LINE__) + " Forward::instanceSpecific: no instance defined for name " + name);
     }
@@ -114,12 +150,15 @@ STATIC Forward *Forward::instanceSpecific(std::string name, EasyCL *cl, LayerDim
 //    forward(batchSize, inputData, filters, biases, output);
 //    return output;
 //}
+/// the layer's cache of fft'd filters, only used by ForwardFft
+VIRTUAL void Forward::setFilterCache(FftFilterCache *filterCache) {
+    this->filterCache = filterCache;
+}
 VIRTUAL int Forward::getOutputTotalSize(int batchSize) {
     return batchSize * dim.outputCubeSize;
 }
 // must allocate output yourself before the call
 VIRTUAL void Forward::forward(int batchSize, float *inputData, float *filters, float *biases, float *output) {
-    StatefulTimer::timeCheck("Forward::forward begin");
     int inputDataSize = batchSize * dim.inputCubeSize;
     CLWrapper *dataWrapper = cl->wrap(inputDataSize, inputData);
     dataWrapper->copyToDevice();
@@ -144,13 +183,10 @@ VIRTUAL void Forward::forward(int batchSize, float *inputData, float *filters, f
     outputWrapper->createOnDevice();
     cl->finish();
 
-    StatefulTimer::timeCheck("Forward::forward after copied to device");
     forward(batchSize, dataWrapper, weightsWrapper, biasWrapper,
             outputWrapper);
-    StatefulTimer::timeCheck("Forward::forward after call forward");
     cl->finish();
     outputWrapper->copyToHost();
-    StatefulTimer::timeCheck("Forward::forward after copytohost");
 //    for(int i = 0; i < 20; i++) {
 //        cout << "output[" << i << "]=" << output[i] << endl;
 //    }
@@ -21,6 +21,8 @@ using namespace std;
 //    return value * value;
 //}
 
+class FftFilterCache;
+
 #define STATIC static
 #define VIRTUAL virtual
 
@@ -28,6 +30,7 @@ class DeepCL_EXPORT Forward {
 public:
     EasyCL *cl;
     LayerDimensions dim;
+    FftFilterCache *filterCache; // set by ConvolutionalLayer, only FftConvolution uses it
 
     virtual ~Forward() {}
     virtual void forward(int batchSize, 
@@ -43,9 +46,10 @@ public:
     STATIC Forward *instance(EasyCL *cl, LayerDimensions dim);
     STATIC Forward *instanceTest(EasyCL *cl, LayerDimensions layerDimensions);
     STATIC int getNumImplementations();
-    STATIC bool plausiblyOptimal(int index, int batchSize, LayerDimensions dim);
+    STATIC bool plausiblyOptimal(int index, int batchSize, EasyCL *cl, LayerDimensions dim);
     STATIC Forward *instanceSpecific(int idx, EasyCL *cl, LayerDimensions layerDimensions);
     STATIC Forward *instanceSpecific(std::string name, EasyCL *cl, LayerDimensions layerDimensions);
+    VIRTUAL void setFilterCache(FftFilterCache *filterCache);
     VIRTUAL int getOutputTotalSize(int batchSize);
     VIRTUAL void forward(int batchSize, float *inputData, float *filters, float *biases, float *output);
 
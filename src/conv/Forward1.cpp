@@ -6,8 +6,8 @@
 
 #include "conv/Forward1.h"
 #include "util/stringhelper.h"
-#include "util/StatefulTimer.h"
 #include "conv/AddBias.h"
+#include "util/KernelCache.h"
 
 using namespace std;
 
@@ -22,7 +22,6 @@ VIRTUAL Forward1::~Forward1() {
 }
 VIRTUAL void Forward1::forward(int batchSize, CLWrapper *dataWrapper, CLWrapper *weightsWrapper, CLWrapper *biasWrapper,
     CLWrapper *outputWrapper) {
-    StatefulTimer::timeCheck("Forward1::forward START");
 
     kernel->in(batchSize);
     kernel->input(dataWrapper);
@@ -36,19 +35,17 @@ VIRTUAL void Forward1::forward(int batchSize, CLWrapper *dataWrapper, CLWrapper
 
     kernel->run_1d(globalSize, workgroupsize);
     cl->finish();
-    StatefulTimer::timeCheck("Forward1::forward after call forward");
 
-    if(dim.biased) {
+    if(dim.biased || dim.activation != 0) {
         addBias->forward(
             batchSize, dim.numFilters, dim.outputSize,
             outputWrapper, biasWrapper);
     }
-    StatefulTimer::timeCheck("Forward1::forward END");
 }
 Forward1::Forward1(EasyCL *cl, LayerDimensions dim) :
             Forward(cl, dim)
         {
-    addBias = new AddBias(cl);
+    addBias = new AddBias(cl, dim);
 
     std::string options = "";
     options += dim.buildOptionsString();
@@ -176,7 +173,7 @@ Forward1::Forward1(EasyCL *cl, LayerDimensions dim) :
     "}\n"
     "\n"
     "";
-    kernel = cl->buildKernelFromString(kernelSource, "convolve_imagecubes_float2", options, "cl/forward1.cl");
+    kernel = KernelCache::buildKernelFromString(cl, kernelSource, "convolve_imagecubes_float2", options, "cl/forward1.cl");
     // [[[end]]]
 }
 
@@ -8,8 +8,8 @@
 
 #include "conv/Forward2.h"
 #include "util/stringhelper.h"
-#include "util/StatefulTimer.h"
 #include "conv/AddBias.h"
+#include "util/KernelCache.h"
 
 using namespace std;
 
@@ -26,7 +26,6 @@ VIRTUAL Forward2::~Forward2() {
 // condition: square(dim.filterSize) * dim.inputPlanes * 4 < 5000 (about 5KB)
 VIRTUAL void Forward2::forward(int batchSize, CLWrapper *dataWrapper, CLWrapper *weightsWrapper, CLWrapper *biasWrapper,
     CLWrapper *outputWrapper) {
-    StatefulTimer::timeCheck("Forward2::forward START");
     kernel->in(batchSize);
     kernel->input(dataWrapper);
     kernel->input(weightsWrapper);
@@ -37,14 +36,12 @@ VIRTUAL void Forward2::forward(int batchSize, CLWrapper *dataWrapper, CLWrapper
 //    cout << "forward2 globalsize " << globalSize << " workgroupsize " << workgroupsize << endl;
     kernel->run_1d(globalSize, workgroupSize);
     cl->finish();
-    StatefulTimer::timeCheck("Forward2::forward after call forward");
 
-    if(dim.biased) {
+    if(dim.biased || dim.activation != 0) {
         addBias->forward(
             batchSize, dim.numFilters, dim.outputSize,
             outputWrapper, biasWrapper);
     }
-    StatefulTimer::timeCheck("Forward2::forward END");
 }
 Forward2::Forward2(EasyCL *cl, LayerDimensions dim) :
             Forward(cl, dim)
@@ -53,7 +50,7 @@ Forward2::Forward2(EasyCL *cl, LayerDimensions dim) :
         throw runtime_error("cannot use forward2, since outputimagesize * outputimagesize > maxworkgroupsize");
     }
 
-    addBias = new AddBias(cl);
+    addBias = new AddBias(cl, dim);
 
     this->workgroupSize = square(dim.outputSize);
     // round up to nearest 32, so dont waste threads:
@@ -170,7 +167,7 @@ Forward2::Forward2(EasyCL *cl, LayerDimensions dim) :
     "#endif\n"
     "\n"
     "";
-    kernel = cl->buildKernelFromString(kernelSource, "forward_2_by_outplane", options, "cl/forward2.cl");
+    kernel = KernelCache::buildKernelFromString(cl, kernelSource, "forward_2_by_outplane", options, "cl/forward2.cl");
     // [[[end]]]
 }
 
@@ -9,7 +9,7 @@
 #include "conv/Forward3.h"
 #include "conv/AddBias.h"
 #include "util/stringhelper.h"
-#include "util/StatefulTimer.h"
+#include "util/KernelCache.h"
 
 using namespace std;
 
@@ -24,7 +24,6 @@ VIRTUAL Forward3::~Forward3() {
 }
 VIRTUAL void Forward3::forward(int batchSize, CLWrapper *dataWrapper, CLWrapper *weightsWrapper, CLWrapper *biasWrapper,
     CLWrapper *outputWrapper) {
-    StatefulTimer::timeCheck("Forward3::forward begin");
 //    const int maxWorkgroupSize = cl->getMaxWorkgroupSize();
 //    int maxglobalId = 0;
 
@@ -41,9 +40,8 @@ VIRTUAL void Forward3::forward(int batchSize, CLWrapper *dataWrapper, CLWrapper
     kernel->run_1d(globalSize, workgroupsize);
     cl->finish();
 
-    StatefulTimer::timeCheck("Forward3::forward after kernel1");
 
-    if(dim.biased) {
+    if(dim.biased || dim.activation != 0) {
         addBias->forward(batchSize, dim.numFilters, dim.outputSize,
                           outputWrapper, biasWrapper);
     }
@@ -52,7 +50,7 @@ Forward3::Forward3(EasyCL *cl, LayerDimensions dim) :
         Forward(cl, dim)
             {
 
-    addBias = new AddBias(cl);
+    addBias = new AddBias(cl, dim);
 
     if(square(dim.outputSize) > cl->getMaxWorkgroupSize()) {
         throw runtime_error("cannot use forward3, since outputimagesize * outputimagesize > maxworkgroupsize");
@@ -157,7 +155,7 @@ Forward3::Forward3(EasyCL *cl, LayerDimensions dim) :
     "}\n"
     "\n"
     "";
-    kernel = cl->buildKernelFromString(kernelSource, "forward_3_by_n_outplane", options, "cl/forward3.cl");
+    kernel = KernelCache::buildKernelFromString(cl, kernelSource, "forward_3_by_n_outplane", options, "cl/forward3.cl");
     // [[[end]]]
 }
 
@@ -6,8 +6,8 @@
 
 #include "conv/Forward4.h"
 #include "util/stringhelper.h"
-#include "util/StatefulTimer.h"
 #include "conv/AddBias.h"
+#include "util/KernelCache.h"
 
 using namespace std;
 
@@ -22,7 +22,6 @@ VIRTUAL Forward4::~Forward4() {
 }
 VIRTUAL void Forward4::forward(int batchSize, CLWrapper *dataWrapper, CLWrapper *weightsWrapper, CLWrapper *biasWrapper,
     CLWrapper *outputWrapper) {
-    StatefulTimer::timeCheck("Forward4::forward start");
 
     int numWorkgroups = dim.numFilters * batchSize * pixelsPerThread;
     int globalSize = workgroupSize * numWorkgroups;
@@ -36,9 +35,8 @@ VIRTUAL void Forward4::forward(int batchSize, CLWrapper *dataWrapper, CLWrapper
 
     kernel->run_1d(globalSize, workgroupSize);
     cl->finish();
-    StatefulTimer::timeCheck("Forward4::forward after call forward");
 
-    if(dim.biased) {
+    if(dim.biased || dim.activation != 0) {
         addBias->forward(
             batchSize, dim.numFilters, dim.outputSize,
             outputWrapper, biasWrapper);
@@ -47,7 +45,7 @@ VIRTUAL void Forward4::forward(int batchSize, CLWrapper *dataWrapper, CLWrapper
 Forward4::Forward4(EasyCL *cl, LayerDimensions dim) :
         Forward(cl, dim)
             {
-    addBias = new AddBias(cl);
+    addBias = new AddBias(cl, dim);
 
     workgroupSize = std::max(32, square(dim.outputSize) ); // no point in wasting threads....
     const int maxWorkgroupSize = cl->getMaxWorkgroupSize();
@@ -187,7 +185,7 @@ Forward4::Forward4(EasyCL *cl, LayerDimensions dim) :
     "#endif\n"
     "\n"
     "";
-    kernel = cl->buildKernelFromString(kernelSource, "forward_4_by_n_outplane_smallercache", options, "cl/forward4.cl");
+    kernel = KernelCache::buildKernelFromString(cl, kernelSource, "forward_4_by_n_outplane_smallercache", options, "cl/forward4.cl");
     // [[[end]]]
 }
 
@@ -10,8 +10,9 @@
 
 #include "conv/ForwardAuto.h"
 #include "util/stringhelper.h"
-#include "util/StatefulTimer.h"
+#include "util/Profiler.h"
 #include "util/Timer.h"
+#include "conv/TuningCache.h"
 
 using namespace std;
 
@@ -46,23 +47,65 @@ VIRTUAL ForwardAuto::~ForwardAuto() {
         }
     }
 }
+VIRTUAL void ForwardAuto::setFilterCache(FftFilterCache *filterCache) {
+    this->filterCache = filterCache;
+    for(int i = 0; i < num; i++) {
+        if(instances[i] != 0) {
+            instances[i]->setFilterCache(filterCache);
+        }
+    }
+}
+// if a previous run already tuned this layer, on this device, go straight
+// to the kernel it picked.  Returns false if we need to tune
+bool ForwardAuto::useCachedChoice(int batchSize) {
+    cacheKey = TuningCache::makeKey("forward", num, cl, dim, batchSize);
+    int index = -1;
+    int cachedMilliseconds = -1;
+    if(!TuningCache::instance()->lookup(cacheKey, &index, &cachedMilliseconds) || index < 0 || index >= num
+            || !Forward::plausiblyOptimal(index, batchSize, cl, dim)) {
+        return false;
+    }
+    try {
+        instances[index] = Forward::instanceSpecific(index, cl, dim);
+        instances[index]->setFilterCache(filterCache);
+    } catch(runtime_error &e) {
+        cout << Profiler::layerPrefix() << "ForwardAuto: cached kernel " << index << " cant be used: " << e.what() << ", retuning" << endl;
+        return false;
+    }
+    valid[index] = true;
+    milliseconds[index] = cachedMilliseconds;
+    nextIndex = num;
+    this->chosenIndex = index;
+    cout << Profiler::layerPrefix() << "   forward layer using cached kernel " << index << endl;
+    return true;
+}
+void ForwardAuto::choose(int index) {
+    this->chosenIndex = index;
+    if(cacheKey != "") {
+        TuningCache::instance()->store(cacheKey, index, milliseconds[index]);
+    }
+}
 VIRTUAL void ForwardAuto::forward(int batchSize, CLWrapper *dataWrapper, CLWrapper *weightsWrapper, 
         CLWrapper *biasWrapper, CLWrapper *outputWrapper) {
 //    Forward *instance = 0;
 //    cout << "ForwardAuto::forward" << endl;
+    if(chosenIndex == -1 && nextIndex == 0) {
+        useCachedChoice(batchSize);
+    }
     while(chosenIndex == -1 && nextIndex < num) {
         int thisIndex = nextIndex;
         nextIndex++;
         cout << "forward try kernel " << thisIndex << endl;
-        if(Forward::plausiblyOptimal(thisIndex, batchSize, dim)) {
+        if(Forward::plausiblyOptimal(thisIndex, batchSize, cl, dim)) {
             Forward *candidate = 0;
             try {
                 candidate = Forward::instanceSpecific(thisIndex, cl, dim);
+                candidate->setFilterCache(filterCache);
                 instances[thisIndex] = candidate;
                 valid[thisIndex] = true;
                 cout << "   ... seems valid" << endl;
             } catch(runtime_error &e) {
-                cout << StatefulTimer::instance()->prefix << "ForwardAuto: kernel " << thisIndex << ": this instance cant be used: " << e.what() << endl;
+                cout << Profiler::layerPrefix() << "ForwardAuto: kernel " << thisIndex << ": this instance cant be used: " << e.what() << endl;
                 valid[thisIndex] = false;
             }
             if(valid[thisIndex]) {
@@ -70,14 +113,14 @@ VIRTUAL void ForwardAuto::forward(int batchSize, CLWrapper *dataWrapper, CLWrapp
                 try {
                     candidate->forward(batchSize, dataWrapper, weightsWrapper, biasWrapper, outputWrapper);
                     milliseconds[thisIndex] = (int)timer.lap();
-                    cout << StatefulTimer::instance()->prefix << "ForwardAuto: kernel " << thisIndex << " " << milliseconds[thisIndex] << "ms" << endl;
+                    cout << Profiler::layerPrefix() << "ForwardAuto: kernel " << thisIndex << " " << milliseconds[thisIndex] << "ms" << endl;
                     if (milliseconds[thisIndex] == 0) { //we can't get better time, use this instance
                         cout << "   forward layer selected kernel with zero time" << thisIndex << endl;
-                        this->chosenIndex = thisIndex;
+                        choose(thisIndex);
                     }
                     return;
                 } catch(runtime_error &e) {
-                    cout << StatefulTimer::instance()->prefix << "ForwardAuto: kernel " << thisIndex << " this instance cant be used: " << e.what() << endl;
+                    cout << Profiler::layerPrefix() << "ForwardAuto: kernel " << thisIndex << " this instance cant be used: " << e.what() << endl;
                     valid[thisIndex] = false;
                     delete instances[thisIndex];
                     instances[thisIndex] = 0;
@@ -90,7 +133,7 @@ VIRTUAL void ForwardAuto::forward(int batchSize, CLWrapper *dataWrapper, CLWrapp
         }
     }
     if(chosenIndex == -1) {
-//        cout << StatefulTimer::instance()->prefix + "ForwardAuto::forward choosing best instance:" << endl;
+//        cout << Profiler::layerPrefix() + "ForwardAuto::forward choosing best instance:" << endl;
         int bestIndex = -1;
         int bestTime = 0;
         for(int i = 0; i < num; i++) {
@@ -111,9 +154,9 @@ VIRTUAL void ForwardAuto::forward(int batchSize, CLWrapper *dataWrapper, CLWrapp
         }
         if(bestIndex != -1) {
             cout << "   forward layer selected kernel " << bestIndex << endl;
-            this->chosenIndex = bestIndex;
+            choose(bestIndex);
         } else {
-            throw runtime_error(StatefulTimer::instance()->prefix + "No valid forward implementations found");
+            throw runtime_error(Profiler::layerPrefix() + "No valid forward implementations found");
         }
     }
 //    cout << "ForwardAuto::forward using instance index: " << chosenIndex << endl;
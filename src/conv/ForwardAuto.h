@@ -37,6 +37,7 @@ public:
     int chosenIndex;
     Forward **instances;
     int nextIndex;
+    std::string cacheKey;
 
     // [[[cog
     // import cog_addheaders
@@ -45,6 +46,9 @@ public:
     // generated, using cog:
     ForwardAuto(EasyCL *cl, LayerDimensions dim);
     VIRTUAL ~ForwardAuto();
+    VIRTUAL void setFilterCache(FftFilterCache *filterCache);
+    bool useCachedChoice(int batchSize);
+    void choose(int index);
     VIRTUAL void forward(int batchSize, CLWrapper *dataWrapper, CLWrapper *weightsWrapper,
     CLWrapper *biasWrapper, CLWrapper *outputWrapper);
 
@@ -7,8 +7,9 @@
 #include <algorithm>
 
 #include "ForwardByInputPlane.h"
+#include "conv/AddBias.h"
 #include "util/stringhelper.h"
-#include "util/StatefulTimer.h"
+#include "util/KernelCache.h"
 
 using namespace std;
 
@@ -20,12 +21,11 @@ using namespace std;
 VIRTUAL ForwardByInputPlane::~ForwardByInputPlane() {
     delete kernel;
     delete reduceSegments;
-    delete repeatedAdd;
+    delete addBias;
 //    delete activate;
 }
 VIRTUAL void ForwardByInputPlane::forward(int batchSize, CLWrapper *dataWrapper, CLWrapper *weightsWrapper, CLWrapper *biasWrapper,
     CLWrapper *outputWrapper) {
-    StatefulTimer::timeCheck("ForwardByInputPlane::forward begin");
     const int maxWorkgroupSize = cl->getMaxWorkgroupSize();
     int maxglobalId = 0;
 
@@ -58,7 +58,6 @@ VIRTUAL void ForwardByInputPlane::forward(int batchSize, CLWrapper *dataWrapper,
 //    cout << "forwardbyinputplane numworkgroups " << numWorkgroups << " globalsize " << globalSize << " workgroupsize " << workgroupsize << " numinputplanes=" << dim.numInputPlanes << endl;
     kernel->run_1d(globalSize, workgroupsize);
     cl->finish();
-    StatefulTimer::timeCheck("ForwardByInputPlane::forward after kernel1");
 
 //    {
 //        output1Wrapper->copyToHost();
@@ -72,18 +71,11 @@ VIRTUAL void ForwardByInputPlane::forward(int batchSize, CLWrapper *dataWrapper,
     numWorkgroups = (maxglobalId + maxWorkgroupSize - 1) / maxWorkgroupSize;
     reduceSegments->run_1d(numWorkgroups * maxWorkgroupSize, maxWorkgroupSize);
     cl->finish();
-    StatefulTimer::timeCheck("ForwardByInputPlane::forward after reduce over inputplanes");
 
-    if(dim.biased) {
-        repeatedAdd->in(batchSize * dim.numFilters * dim.outputSize * dim.outputSize)
-            ->in(dim.numFilters)
-            ->in(dim.outputSize * dim.outputSize)
-            ->inout(outputWrapper)->in(biasWrapper);
-        maxglobalId = batchSize * dim.numFilters * dim.outputSize * dim.outputSize;
-        numWorkgroups = (maxglobalId + maxWorkgroupSize - 1) / maxWorkgroupSize;
-        repeatedAdd->run_1d(numWorkgroups * maxWorkgroupSize, maxWorkgroupSize);
-        cl->finish();
-        StatefulTimer::timeCheck("ForwardByInputPlane::forward after repeatedAdd");
+    if(dim.biased || dim.activation != 0) {
+        addBias->forward(
+            batchSize, dim.numFilters, dim.outputSize,
+            outputWrapper, biasWrapper);
     }
 
 //    activate->in(batchSize * dim.numFilters * dim.outputSize * dim.outputSize)
@@ -97,11 +89,11 @@ VIRTUAL void ForwardByInputPlane::forward(int batchSize, CLWrapper *dataWrapper,
     delete output1Wrapper;
     delete[] output1;
 
-    StatefulTimer::timeCheck("ForwardByInputPlane::forward after call forward");
 }
 ForwardByInputPlane::ForwardByInputPlane(EasyCL *cl, LayerDimensions dim) :
         Forward(cl, dim)
             {
+    addBias = new AddBias(cl, dim);
 
     std::string options = ""; // "-D " + fn->getDefineName();
     options += dim.buildOptionsString();
@@ -110,7 +102,6 @@ ForwardByInputPlane::ForwardByInputPlane(EasyCL *cl, LayerDimensions dim) :
     // import stringify
     // stringify.write_kernel2("kernel", "cl/forward_byinputplane.cl", "forward_byinputplane", 'options')
     // stringify.write_kernel2("reduceSegments", "cl/reduce_segments.cl", "reduce_segments", 'options')
-    // stringify.write_kernel2("repeatedAdd", "cl/per_element_add.cl", "repeated_add", 'options')
     // # stringify.write_kernel2("activate", "cl/activate.cl", "activate", 'options')
     // ]]]
     // generated using cog, from cl/forward_byinputplane.cl:
@@ -219,7 +210,7 @@ ForwardByInputPlane::ForwardByInputPlane(EasyCL *cl, LayerDimensions dim) :
     "}\n"
     "\n"
     "";
-    kernel = cl->buildKernelFromString(kernelSource, "forward_byinputplane", options, "cl/forward_byinputplane.cl");
+    kernel = KernelCache::buildKernelFromString(cl, kernelSource, "forward_byinputplane", options, "cl/forward_byinputplane.cl");
     // generated using cog, from cl/reduce_segments.cl:
     const char * reduceSegmentsSource =  
     "// Copyright Hugh Perkins 2015 hughperkins at gmail\n"
@@ -247,43 +238,7 @@ ForwardByInputPlane::ForwardByInputPlane(EasyCL *cl, LayerDimensions dim) :
     "\n"
     "\n"
     "";
-    reduceSegments = cl->buildKernelFromString(reduceSegmentsSource, "reduce_segments", options, "cl/reduce_segments.cl");
-    // generated using cog, from cl/per_element_add.cl:
-    const char * repeatedAddSource =  
-    "// Copyright Hugh Perkins 2015 hughperkins at gmail\n"
-    "//\n"
-    "// This Source Code Form is subject to the terms of the Mozilla Public License,\n"
-    "// v. 2.0. If a copy of the MPL was not distributed with this file, You can\n"
-    "// obtain one at http://mozilla.org/MPL/2.0/.\n"
-    "\n"
-    "kernel void per_element_add(const int N, global float *target, global const float *source) {\n"
-    "    const int globalId = get_global_id(0);\n"
-    "    if (globalId >= N) {\n"
-    "        return;\n"
-    "    }\n"
-    "    target[globalId] += source[globalId];\n"
-    "}\n"
-    "\n"
-    "// adds source to target\n"
-    "// tiles source as necessary, according to tilingSize\n"
-    "kernel void per_element_tiled_add(const int N, const int tilingSize, global float *target, global const float *source) {\n"
-    "    const int globalId = get_global_id(0);\n"
-    "    if (globalId >= N) {\n"
-    "        return;\n"
-    "    }\n"
-    "    target[globalId] += source[globalId % tilingSize];\n"
-    "}\n"
-    "\n"
-    "kernel void repeated_add(const int N, const int sourceSize, const int repeatSize, global float *target, global const float *source) {\n"
-    "    const int globalId = get_global_id(0);\n"
-    "    if (globalId >= N) {\n"
-    "        return;\n"
-    "    }\n"
-    "    target[globalId] += source[ (globalId / repeatSize) % sourceSize ];\n"
-    "}\n"
-    "\n"
-    "";
-    repeatedAdd = cl->buildKernelFromString(repeatedAddSource, "repeated_add", options, "cl/per_element_add.cl");
+    reduceSegments = KernelCache::buildKernelFromString(cl, reduceSegmentsSource, "reduce_segments", options, "cl/reduce_segments.cl");
     // [[[end]]]
 }
 
@@ -2,11 +2,13 @@
 
 #include "Forward.h"
 
+class AddBias;
+
 class ForwardByInputPlane : public Forward {
 public:
     CLKernel *kernel;
     CLKernel *reduceSegments;
-    CLKernel *repeatedAdd;
+    AddBias *addBias;
 //    CLKernel *activate;
 
     // [[[cog
@@ -85,7 +85,9 @@ VIRTUAL float *ForwardCpu::forward(int batchSize, float *inputData, float *weigh
                     if(dim.biased) {
                         sum += bias[filter];
                     }
-//                    sum = fn->calc(sum);
+                    if(dim.activation != 0) {
+                        sum = dim.activation->calc(sum);
+                    }
                     int outputIndex = (( n 
                         * dim.numFilters + filter) 
                         * dim.outputSize + outRow)
@@ -0,0 +1,154 @@
+// Copyright Hugh Perkins 2015 hughperkins at gmail
+//
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file, You can
+// obtain one at http://mozilla.org/MPL/2.0/.
+
+#include <stdexcept>
+#include <cstring>
+
+#include "EasyCL.h"
+#include "util/ThreadPool.h"
+#include "util/stringhelper.h"
+
+#include "conv/ForwardCpuThreaded.h"
+
+#if defined(__SSE__) || defined(_M_X64)
+#define FORWARDCPU_SSE
+#include <xmmintrin.h>
+#endif
+
+using namespace std;
+
+#undef VIRTUAL
+#undef STATIC
+#define VIRTUAL
+#define STATIC
+
+// number of filters each task works on; the input row we read is reused
+// across all of them, while it is still in L1
+#define FILTER_BLOCK 4
+
+// y[i] += a * x[i], for i in [0, n)
+static inline void axpy(int n, float a, const float *x, float *y) {
+    int i = 0;
+    #ifdef FORWARDCPU_SSE
+    __m128 a4 = _mm_set1_ps(a);
+    for(; i + 4 <= n; i += 4) {
+        __m128 y4 = _mm_loadu_ps(y + i);
+        y4 = _mm_add_ps(y4, _mm_mul_ps(a4, _mm_loadu_ps(x + i)));
+        _mm_storeu_ps(y + i, y4);
+    }
+    #endif
+    for(; i < n; i++) {
+        y[i] += a * x[i];
+    }
+}
+
+PUBLIC ForwardCpuThreaded::ForwardCpuThreaded(EasyCL *cl, LayerDimensions dim) :
+        Forward(cl, dim),
+        paddedInput(0),
+        paddedInputAllocated(0) {
+    if(dim.isEven) {
+        throw runtime_error("ForwardCpuThreaded: even filter sizes not supported");
+    }
+    if(dim.skip != 0) {
+        throw runtime_error("ForwardCpuThreaded: skip not supported");
+    }
+    padding = dim.padZeros ? dim.halfFilterSize : 0;
+    paddedSize = dim.inputSize + 2 * padding;
+    paddedCubeSize = dim.inputPlanes * paddedSize * paddedSize;
+}
+PUBLIC VIRTUAL ForwardCpuThreaded::~ForwardCpuThreaded() {
+    delete[] paddedInput;
+}
+PUBLIC VIRTUAL void ForwardCpuThreaded::forward(int batchSize, CLWrapper *inputDataWrapper, CLWrapper *weightsWrapper, CLWrapper *biasWrapper, CLWrapper *outputWrapper) {
+    inputDataWrapper->copyToHost();
+    weightsWrapper->copyToHost();
+    float *bias = 0;
+    if(dim.biased) {
+        biasWrapper->copyToHost();
+        bias = (float *)biasWrapper->getHostArray();
+    }
+    forward(batchSize, (float *)inputDataWrapper->getHostArray(), (float *)weightsWrapper->getHostArray(),
+        bias, (float *)outputWrapper->getHostArray());
+    outputWrapper->copyToDevice();
+}
+// writes batchSize * dim.outputCubeSize floats into output, which caller allocates
+PUBLIC VIRTUAL void ForwardCpuThreaded::forward(int batchSize, float *inputData, float *weights, float *bias, float *output) {
+    ThreadPool *pool = ThreadPool::instance();
+    float *padded = inputData;
+    if(padding > 0) {
+        int needed = batchSize * paddedCubeSize;
+        if(needed > paddedInputAllocated) {
+            delete[] paddedInput;
+            paddedInput = new float[needed];
+            paddedInputAllocated = needed;
+            // borders stay zero from here on, we only ever overwrite the interior
+            memset(paddedInput, 0, sizeof(float) * needed);
+        }
+        padded = paddedInput;
+        pool->parallelFor(batchSize, [&](int n) {
+            padImage(inputData + n * dim.inputCubeSize, paddedInput + n * paddedCubeSize);
+        });
+    }
+    int numFilterBlocks = (dim.numFilters + FILTER_BLOCK - 1) / FILTER_BLOCK;
+    pool->parallelFor(batchSize * numFilterBlocks, [&](int task) {
+        int n = task / numFilterBlocks;
+        int filterStart = (task % numFilterBlocks) * FILTER_BLOCK;
+        int filterEnd = std::min(filterStart + FILTER_BLOCK, dim.numFilters);
+        forwardTile(padded + n * paddedCubeSize, weights, bias, filterStart, filterEnd,
+            output + n * dim.outputCubeSize);
+    });
+}
+// copies one image into the interior of its zero-bordered slot
+PRIVATE void ForwardCpuThreaded::padImage(float const*image, float *paddedImage) {
+    for(int plane = 0; plane < dim.inputPlanes; plane++) {
+        for(int row = 0; row < dim.inputSize; row++) {
+            memcpy(paddedImage + (plane * paddedSize + row + padding) * paddedSize + padding,
+                image + (plane * dim.inputSize + row) * dim.inputSize,
+                sizeof(float) * dim.inputSize);
+        }
+    }
+}
+// output planes [filterStart, filterEnd) of one image
+// paddedImage is inputPlanes * paddedSize * paddedSize, so no bounds checks needed
+PRIVATE void ForwardCpuThreaded::forwardTile(float const*paddedImage, float const*weights, float const*bias, int filterStart, int filterEnd, float *imageOutput) {
+    const int outputSize = dim.outputSize;
+    const int filterSize = dim.filterSize;
+    for(int filter = filterStart; filter < filterEnd; filter++) {
+        float *outPlane = imageOutput + filter * dim.outputSizeSquared;
+        float initial = dim.biased ? bias[filter] : 0.0f;
+        for(int i = 0; i < dim.outputSizeSquared; i++) {
+            outPlane[i] = initial;
+        }
+    }
+    for(int inPlane = 0; inPlane < dim.inputPlanes; inPlane++) {
+        float const*inputPlane = paddedImage + inPlane * paddedSize * paddedSize;
+        for(int filterRow = 0; filterRow < filterSize; filterRow++) {
+            for(int filterCol = 0; filterCol < filterSize; filterCol++) {
+                float blockWeights[FILTER_BLOCK];
+                for(int filter = filterStart; filter < filterEnd; filter++) {
+                    blockWeights[filter - filterStart] = weights[((filter * dim.inputPlanes + inPlane)
+                        * filterSize + filterRow) * filterSize + filterCol];
+                }
+                for(int outRow = 0; outRow < outputSize; outRow++) {
+                    float const*inputRow = inputPlane + (outRow + filterRow) * paddedSize + filterCol;
+                    for(int filter = filterStart; filter < filterEnd; filter++) {
+                        axpy(outputSize, blockWeights[filter - filterStart], inputRow,
+                            imageOutput + filter * dim.outputSizeSquared + outRow * outputSize);
+                    }
+                }
+            }
+        }
+    }
+    // fused activation, while the tile is still in cache
+    if(dim.activation != 0) {
+        float *tileOutput = imageOutput + filterStart * dim.outputSizeSquared;
+        const int tileSize = (filterEnd - filterStart) * dim.outputSizeSquared;
+        for(int i = 0; i < tileSize; i++) {
+            tileOutput[i] = dim.activation->calc(tileOutput[i]);
+        }
+    }
+}
+
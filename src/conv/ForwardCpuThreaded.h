@@ -0,0 +1,46 @@
+// Copyright Hugh Perkins 2015 hughperkins at gmail
+//
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file, You can
+// obtain one at http://mozilla.org/MPL/2.0/.
+
+#pragma once
+
+#include "Forward.h"
+
+#include "DeepCLDllExport.h"
+
+#define VIRTUAL virtual
+#define STATIC static
+
+// native multithreaded cpu implementation, doesnt need any opencl kernels
+// splits the batch into [image][block of filters] tiles, runs them on
+// ThreadPool, against a zero-padded copy of the input, so the inner
+// loops have no bounds checks
+class DeepCL_EXPORT ForwardCpuThreaded : public Forward {
+    private:
+    int padding;
+    int paddedSize;
+    int paddedCubeSize;
+
+    float *paddedInput; // reused across calls, grows as needed
+    int paddedInputAllocated;
+
+    // [[[cog
+    // import cog_addheaders
+    // cog_addheaders.addv2()
+    // ]]]
+    // generated, using cog:
+
+    public:
+    ForwardCpuThreaded(EasyCL *cl, LayerDimensions dim);
+    VIRTUAL ~ForwardCpuThreaded();
+    VIRTUAL void forward(int batchSize, CLWrapper *inputDataWrapper, CLWrapper *weightsWrapper, CLWrapper *biasWrapper, CLWrapper *outputWrapper);
+    VIRTUAL void forward(int batchSize, float *inputData, float *weights, float *bias, float *output);
+
+    private:
+    void padImage(float const*image, float *paddedImage);
+    void forwardTile(float const*paddedImage, float const*weights, float const*bias, int filterStart, int filterEnd, float *imageOutput);
+
+    // [[[end]]]
+};
@@ -8,9 +8,9 @@
 
 #include "conv/ForwardFc.h"
 #include "util/stringhelper.h"
-#include "util/StatefulTimer.h"
 #include "conv/AddBias.h"
 #include "conv/ReduceSegments.h"
+#include "util/KernelCache.h"
 
 using namespace std;
 
@@ -26,7 +26,6 @@ VIRTUAL ForwardFc::~ForwardFc() {
     delete reduceSegments;
 }
 VIRTUAL void ForwardFc::forward(int batchSize, CLWrapper *dataWrapper, CLWrapper *weightsWrapper, CLWrapper *biasWrapper, CLWrapper *outputWrapper) {
-    StatefulTimer::timeCheck("ForwardFc::forward begin");
 
 //    const int maxWorkgroupSize = cl->getMaxWorkgroupSize();
 
@@ -58,13 +57,12 @@ VIRTUAL void ForwardFc::forward(int batchSize, CLWrapper *dataWrapper, CLWrapper
 
     kernel1->run_1d(workgroupSize * numWorkgroups, workgroupSize);
     cl->finish();
-    StatefulTimer::timeCheck("ForwardFc::forward after first kernel");
 
     reduceSegments->reduce(output1Size, dim.filterSize, output1Wrapper, output2Wrapper);
     reduceSegments->reduce(output2Size, dim.numInputPlanes, output2Wrapper, outputWrapper);
 
     // add bias...
-    if(dim.biased) {
+    if(dim.biased || dim.activation != 0) {
         addBias->forward(
             batchSize, dim.numFilters, dim.outputSize,
             outputWrapper, biasWrapper);
@@ -75,7 +73,6 @@ VIRTUAL void ForwardFc::forward(int batchSize, CLWrapper *dataWrapper, CLWrapper
 
     delete output1Wrapper;
     delete[] output1;
-    StatefulTimer::timeCheck("ForwardFc::forward end");
 }
 ForwardFc::ForwardFc(EasyCL *cl, LayerDimensions dim) :
         Forward(cl, dim)
@@ -88,7 +85,7 @@ ForwardFc::ForwardFc(EasyCL *cl, LayerDimensions dim) :
         throw runtime_error("For ForwardFc, padzeros must be disabled");
     }
 
-    this->addBias = new AddBias(cl);
+    this->addBias = new AddBias(cl, dim);
     this->reduceSegments = new ReduceSegments(cl);
 
     std::string options = "";
@@ -207,7 +204,7 @@ ForwardFc::ForwardFc(EasyCL *cl, LayerDimensions dim) :
     "#endif\n"
     "\n"
     "";
-    kernel1 = cl->buildKernelFromString(kernel1Source, "forward_fc_workgroup_perrow", options, "cl/forward_fc_wgperrow.cl");
+    kernel1 = KernelCache::buildKernelFromString(cl, kernel1Source, "forward_fc_workgroup_perrow", options, "cl/forward_fc_wgperrow.cl");
     // [[[end]]]
 }
 
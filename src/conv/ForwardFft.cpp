@@ -0,0 +1,39 @@
+// Copyright Hugh Perkins 2015 hughperkins at gmail
+//
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file, You can
+// obtain one at http://mozilla.org/MPL/2.0/.
+
+#include "EasyCL.h"
+#include "conv/FftConvolution.h"
+#include "conv/FftFilterCache.h"
+
+#include "conv/ForwardFft.h"
+
+using namespace std;
+
+#undef VIRTUAL
+#undef STATIC
+#define VIRTUAL
+#define STATIC
+#define PUBLIC
+
+PUBLIC ForwardFft::ForwardFft(EasyCL *cl, LayerDimensions dim) :
+        Forward(cl, dim) {
+    fft = new FftConvolution(cl, dim);
+    ownFilterCache = new FftFilterCache(cl);
+}
+PUBLIC VIRTUAL ForwardFft::~ForwardFft() {
+    delete ownFilterCache;
+    delete fft;
+}
+PUBLIC VIRTUAL void ForwardFft::forward(int batchSize, CLWrapper *dataWrapper, CLWrapper *weightsWrapper, CLWrapper *biasWrapper, CLWrapper *outputWrapper) {
+    FftFilterCache *cache = filterCache;
+    if(cache == 0) {
+        // no way to know if the weights changed since last time
+        ownFilterCache->invalidate();
+        cache = ownFilterCache;
+    }
+    CLWrapper *filterSpectraWrapper = fft->getFilterSpectra(cache, weightsWrapper);
+    fft->forward(batchSize, dataWrapper, filterSpectraWrapper, biasWrapper, outputWrapper);
+}
@@ -0,0 +1,40 @@
+// Copyright Hugh Perkins 2015 hughperkins at gmail
+//
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file, You can
+// obtain one at http://mozilla.org/MPL/2.0/.
+
+#pragma once
+
+#include "Forward.h"
+
+class FftConvolution;
+class FftFilterCache;
+
+#include "DeepCLDllExport.h"
+
+#define VIRTUAL virtual
+#define STATIC static
+
+// fft convolution on the gpu, see FftConvolution.h
+// the filter spectra come from the layer's FftFilterCache, if it set one,
+// otherwise they are transformed on every call
+class DeepCL_EXPORT ForwardFft : public Forward {
+    private:
+    FftConvolution *fft;
+    FftFilterCache *ownFilterCache;
+
+    // [[[cog
+    // import cog_addheaders
+    // cog_addheaders.addv2()
+    // ]]]
+    // generated, using cog:
+
+    public:
+    ForwardFft(EasyCL *cl, LayerDimensions dim);
+    VIRTUAL ~ForwardFft();
+    VIRTUAL void forward(int batchSize, CLWrapper *dataWrapper, CLWrapper *weightsWrapper, CLWrapper *biasWrapper, CLWrapper *outputWrapper);
+
+    // [[[end]]]
+};
+
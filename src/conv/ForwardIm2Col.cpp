@@ -6,15 +6,16 @@
 
 #include "conv/ForwardIm2Col.h"
 #include "util/stringhelper.h"
-#include "util/StatefulTimer.h"
-#include "conv/AddBias.h"
 //#include "clblas/ClBlasInstance.h"
 #include "clblas/ClBlasHelper.h"
 #include "conv/Im2Col.h"
+#include "util/KernelCache.h"
+#include "util/WorkspaceScope.h"
 
 #include <sstream>
 #include <iostream>
 #include <string>
+#include <algorithm>
 
 using namespace std;
 
@@ -24,34 +25,158 @@ using namespace std;
 #define STATIC
 #define PUBLIC
 
+int ForwardIm2Col::chunkSizeOverride = 0;
+int ForwardIm2Col::workspaceBudgetMB = 256;
+
 PUBLIC ForwardIm2Col::ForwardIm2Col(EasyCL *cl, LayerDimensions dim) :
             Forward(cl, dim)
         {
 //    ClBlasInstance::initializeIfNecessary();
 
-    addBias = new AddBias(cl);
     im2Col = new Im2Col(cl, dim);
+
+    std::string options = "";
+    if(dim.biased) {
+        options += " -D BIASED";
+    }
+    if(dim.activation != 0) {
+        options += " -D " + string(dim.activation->getDefineName());
+    }
+    string kernelName = "ForwardIm2Col.im2col_unbatch" + options;
+    if(cl->kernelExists(kernelName)) {
+        kernelUnbatch = cl->getKernel(kernelName);
+    } else {
+        // [[[cog
+        // import stringify
+        // stringify.write_kernel2("kernelUnbatch", "cl/im2col_unbatch.cl", "im2col_unbatch", 'options')
+        // ]]]
+        // generated using cog, from cl/im2col_unbatch.cl:
+        const char * kernelUnbatchSource =  
+        "// Copyright Hugh Perkins 2015 hughperkins at gmail\n"
+        "//\n"
+        "// This Source Code Form is subject to the terms of the Mozilla Public License,\n"
+        "// v. 2.0. If a copy of the MPL was not distributed with this file, You can\n"
+        "// obtain one at http://mozilla.org/MPL/2.0/.\n"
+        "\n"
+        "// expected defines:\n"
+        "// BIASED (optional)\n"
+        "// one of: [ TANH | RELU | LINEAR | SIGMOID | SCALEDTANH | ELU ] (optional, fuses the activation)\n"
+        "\n"
+        "// including cl/activate_defines.cl:\n"
+        "// Copyright Hugh Perkins 2015 hughperkins at gmail\n"
+        "//\n"
+        "// This Source Code Form is subject to the terms of the Mozilla Public License,\n"
+        "// v. 2.0. If a copy of the MPL was not distributed with this file, You can\n"
+        "// obtain one at http://mozilla.org/MPL/2.0/.\n"
+        "\n"
+        "// ACTIVATION_FUNCTION, for kernels that fuse an activation into their output,\n"
+        "// and ACTIVATION_DERIV, its derivative, written in terms of that output, for\n"
+        "// kernels that fuse it into reading gradOutput;\n"
+        "// both left undefined if none of the activation defines is given\n"
+        "// one of: [ TANH | RELU | LINEAR | SIGMOID | SCALEDTANH | ELU ] (optional)\n"
+        "\n"
+        "#ifdef TANH\n"
+        "    #define ACTIVATION_FUNCTION(output) (tanh(output))\n"
+        "#elif defined SCALEDTANH\n"
+        "    #define ACTIVATION_FUNCTION(output) (1.7159f * tanh(0.66667f * output))\n"
+        "#elif defined SIGMOID\n"
+        "    #define ACTIVATION_FUNCTION(output) (1.0f / (1 + exp(-output)))\n"
+        "#elif defined RELU\n"
+        "    #define ACTIVATION_FUNCTION(output) (output> 0 ? output : 0)\n"
+        "#elif defined ELU\n"
+        "    #define ACTIVATION_FUNCTION(output) (output> 0 ? output : exp(output) - 1)\n"
+        "#elif defined LINEAR\n"
+        "    #define ACTIVATION_FUNCTION(output) (output)\n"
+        "#endif\n"
+        "\n"
+        "#ifdef TANH\n"
+        "    #define ACTIVATION_DERIV(output) (1 - output * output)\n"
+        "#elif defined SCALEDTANH\n"
+        "    #define ACTIVATION_DERIV(output) (0.66667f * (1.7159f - 1 / 1.7159f * output * output) )\n"
+        "#elif defined SIGMOID\n"
+        "    #define ACTIVATION_DERIV(output) (output * (1 - output) )\n"
+        "#elif defined RELU\n"
+        "    #define ACTIVATION_DERIV(output) (output > 0 ? 1 : 0)\n"
+        "#elif defined ELU\n"
+        "    #define ACTIVATION_DERIV(output) (output > 0 ? 1 : output + 1)\n"
+        "#elif defined LINEAR\n"
+        "    #define ACTIVATION_DERIV(output) (1.0f)\n"
+        "#endif\n"
+        "\n"
+        "\n"
+        "// the batched im2col gemm gives [filter][n][outputPlane], we want [n][filter][outputPlane]\n"
+        "// also adds the bias, if BIASED, and applies the activation, if there is one,\n"
+        "// so we dont need separate passes for those\n"
+        "// one thread per output element, indexed by destination\n"
+        "kernel void im2col_unbatch(\n"
+        "        const int numImages, const int numFilters, const int outputSizeSquared,\n"
+        "        global const float *gemmOutput,\n"
+        "        global const float *bias,\n"
+        "        global float *output, const int outputOffset) {\n"
+        "    const int globalId = get_global_id(0);\n"
+        "    if (globalId >= numImages * numFilters * outputSizeSquared) {\n"
+        "        return;\n"
+        "    }\n"
+        "    const int pixel = globalId % outputSizeSquared;\n"
+        "    const int filter = (globalId / outputSizeSquared) % numFilters;\n"
+        "    const int n = globalId / outputSizeSquared / numFilters;\n"
+        "    float value = gemmOutput[(filter * numImages + n) * outputSizeSquared + pixel];\n"
+        "    #ifdef BIASED\n"
+        "    value += bias[filter];\n"
+        "    #endif\n"
+        "    #ifdef ACTIVATION_FUNCTION\n"
+        "    value = ACTIVATION_FUNCTION(value);\n"
+        "    #endif\n"
+        "    output[outputOffset + globalId] = value;\n"
+        "}\n"
+        "\n"
+        "";
+        kernelUnbatch = KernelCache::buildKernelFromString(cl, kernelUnbatchSource, "im2col_unbatch", options, "cl/im2col_unbatch.cl");
+        // [[[end]]]
+        cl->storeKernel(kernelName, kernelUnbatch, true);
+    }
 }
 PUBLIC VIRTUAL ForwardIm2Col::~ForwardIm2Col() {
-    delete addBias;
     delete im2Col;
 }
+// 0 means choose automatically, from the workspace budget
+PUBLIC STATIC void ForwardIm2Col::setChunkSize(int chunkSize) {
+    chunkSizeOverride = chunkSize;
+}
+PUBLIC STATIC void ForwardIm2Col::setWorkspaceBudgetMB(int budgetMB) {
+    workspaceBudgetMB = budgetMB;
+}
+// how many images to unroll into each gemm
+PUBLIC int ForwardIm2Col::getChunkSize(int batchSize) {
+    if(chunkSizeOverride > 0) {
+        return std::min(chunkSizeOverride, batchSize);
+    }
+    int64 columnsBytesPerImage = (int64)dim.inputPlanes * dim.filterSizeSquared * dim.outputSizeSquared * sizeof(float);
+    int64 gemmOutputBytesPerImage = (int64)dim.outputCubeSize * sizeof(float);
+    int64 budgetBytes = (int64)workspaceBudgetMB * 1024 * 1024;
+    int64 maxAllocBytes = (int64)cl->getMaxAllocSizeMB() * 1024 * 1024;
+    int64 chunkSize = budgetBytes / (columnsBytesPerImage + gemmOutputBytesPerImage);
+    chunkSize = std::min(chunkSize, maxAllocBytes / columnsBytesPerImage);
+    chunkSize = std::min(chunkSize, maxAllocBytes / gemmOutputBytesPerImage);
+    chunkSize = std::min(chunkSize, (int64)batchSize);
+    return std::max((int)chunkSize, 1);
+}
 PUBLIC VIRTUAL void ForwardIm2Col::forward(int batchSize, CLWrapper *dataWrapper, CLWrapper *weightsWrapper, CLWrapper *biasWrapper, CLWrapper *outputWrapper) {
-    StatefulTimer::timeCheck("ForwardIm2Col::forward START");
 
-    int columnsSize= dim.inputPlanes * dim.filterSizeSquared * dim.outputSizeSquared;
-    float *columns = new float[columnsSize];
-    CLWrapper *columnsWrapper = cl->wrap(columnsSize, columns);
-    columnsWrapper->createOnDevice();
-//    cout << "columnsSize: " << columnsSize << endl;
-//    cout << "weightsize: " << weightsWrapper->size() << endl;
+    int chunkSize = getChunkSize(batchSize);
+    // [inputPlanes * filterSizeSquared][chunk][outputSizeSquared]
+    // and [numFilters][chunk][outputSizeSquared]
+    WorkspaceScope workspace(cl);
+    CLWrapper *columnsWrapper = workspace.acquire(chunkSize * dim.inputPlanes * dim.filterSizeSquared * dim.outputSizeSquared);
+    CLWrapper *gemmOutputWrapper = workspace.acquire(chunkSize * dim.outputCubeSize);
+//    cout << "chunkSize: " << chunkSize << endl;
 
-    StatefulTimer::timeCheck("ForwardIm2Col::forward after alloc");
 
-    for (int b = 0; b < batchSize; b ++) {
-        im2Col->im2Col(dataWrapper, b * dim.inputCubeSize, columnsWrapper);
+    for (int chunkStart = 0; chunkStart < batchSize; chunkStart += chunkSize) {
+        int thisChunkSize = std::min(chunkSize, batchSize - chunkStart);
+        im2Col->im2ColBatch(dataWrapper, chunkStart * dim.inputCubeSize, thisChunkSize, columnsWrapper);
 
-        long m = dim.outputSizeSquared;
+        long m = thisChunkSize * dim.outputSizeSquared;
         long n = dim.numFilters;
         long k = dim.inputPlanes * dim.filterSizeSquared;
 //        cout << "m=" << m << " n=" << n << " k=" << k << endl;
@@ -63,20 +188,22 @@ PUBLIC VIRTUAL void ForwardIm2Col::forward(int batchSize, CLWrapper *dataWrapper
             columnsWrapper, 0,
             weightsWrapper, 0,
             0,
-            outputWrapper, b * dim.outputCubeSize
+            gemmOutputWrapper, 0
         );
-    }
-
-    delete columnsWrapper;
-    delete[] columns;
 
-    StatefulTimer::timeCheck("ForwardIm2Col::forward after call forward");
-
-    if(dim.biased) {
-        addBias->forward(
-            batchSize, dim.numFilters, dim.outputSize,
-            outputWrapper, biasWrapper);
+        int numOutputs = thisChunkSize * dim.outputCubeSize;
+        kernelUnbatch->in(thisChunkSize)
+            ->in(dim.numFilters)
+            ->in(dim.outputSizeSquared)
+            ->in(gemmOutputWrapper)
+            ->in(dim.biased ? biasWrapper : gemmOutputWrapper) // not read, if not biased
+            ->out(outputWrapper)
+            ->in(chunkStart * dim.outputCubeSize);
+        int workgroupSize = 64;
+        int numWorkgroups = (numOutputs + workgroupSize - 1) / workgroupSize;
+        kernelUnbatch->run_1d(numWorkgroups * workgroupSize, workgroupSize);
     }
-    StatefulTimer::timeCheck("ForwardIm2Col::forward END");
+    cl->finish();
+
 }
 
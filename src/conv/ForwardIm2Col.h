@@ -8,24 +8,28 @@
 
 #include "Forward.h"
 
-class AddBias;
 class Im2Col;
+class CLKernel;
 
 #include "DeepCLDllExport.h"
 
 #define VIRTUAL virtual
 #define STATIC static
 
+// unrolls chunks of images with im2col, then one gemm per chunk, rather than one
+// gemm per image.  The chunk size is chosen automatically from a device memory
+// budget, unless set explicitly with setChunkSize
+// the columns and gemm output buffers come from the per-EasyCL Workspace, so
+// they are shared with the other layers, and only grow
 class DeepCL_EXPORT ForwardIm2Col : public Forward {
     private:
 //    CLKernel *kernelIm2Col;
 //    CLKernel *kernelCol2Im;
-    AddBias *addBias;
     Im2Col *im2Col;
+    CLKernel *kernelUnbatch;
 
-    float *columns;
-    CLWrapper *columnsWrapper;
-    int numKernels;
+    static int chunkSizeOverride;
+    static int workspaceBudgetMB;
 
     // [[[cog
     // import cog_addheaders
@@ -36,6 +40,9 @@ class DeepCL_EXPORT ForwardIm2Col : public Forward {
     public:
     ForwardIm2Col(EasyCL *cl, LayerDimensions dim);
     VIRTUAL ~ForwardIm2Col();
+    STATIC void setChunkSize(int chunkSize);
+    STATIC void setWorkspaceBudgetMB(int budgetMB);
+    int getChunkSize(int batchSize);
     VIRTUAL void forward(int batchSize, CLWrapper *dataWrapper, CLWrapper *weightsWrapper, CLWrapper *biasWrapper, CLWrapper *outputWrapper);
 
     // [[[end]]]
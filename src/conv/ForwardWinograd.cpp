@@ -0,0 +1,29 @@
+// Copyright Hugh Perkins 2015 hughperkins at gmail
+//
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file, You can
+// obtain one at http://mozilla.org/MPL/2.0/.
+
+#include "EasyCL.h"
+#include "conv/Winograd.h"
+
+#include "conv/ForwardWinograd.h"
+
+using namespace std;
+
+#undef VIRTUAL
+#undef STATIC
+#define VIRTUAL
+#define STATIC
+#define PUBLIC
+
+PUBLIC ForwardWinograd::ForwardWinograd(EasyCL *cl, LayerDimensions dim) :
+        Forward(cl, dim) {
+    winograd = new Winograd(cl, dim, false);
+}
+PUBLIC VIRTUAL ForwardWinograd::~ForwardWinograd() {
+    delete winograd;
+}
+PUBLIC VIRTUAL void ForwardWinograd::forward(int batchSize, CLWrapper *dataWrapper, CLWrapper *weightsWrapper, CLWrapper *biasWrapper, CLWrapper *outputWrapper) {
+    winograd->convolve(batchSize, dataWrapper, weightsWrapper, biasWrapper, outputWrapper);
+}
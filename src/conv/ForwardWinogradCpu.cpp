@@ -0,0 +1,42 @@
+// Copyright Hugh Perkins 2015 hughperkins at gmail
+//
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file, You can
+// obtain one at http://mozilla.org/MPL/2.0/.
+
+#include "EasyCL.h"
+#include "conv/Winograd.h"
+
+#include "conv/ForwardWinogradCpu.h"
+
+using namespace std;
+
+#undef VIRTUAL
+#undef STATIC
+#define VIRTUAL
+#define STATIC
+#define PUBLIC
+
+PUBLIC ForwardWinogradCpu::ForwardWinogradCpu(EasyCL *cl, LayerDimensions dim) :
+        Forward(cl, dim) {
+    winograd = new Winograd(0, dim, false);
+}
+PUBLIC VIRTUAL ForwardWinogradCpu::~ForwardWinogradCpu() {
+    delete winograd;
+}
+PUBLIC VIRTUAL void ForwardWinogradCpu::forward(int batchSize, CLWrapper *dataWrapper, CLWrapper *weightsWrapper, CLWrapper *biasWrapper, CLWrapper *outputWrapper) {
+    dataWrapper->copyToHost();
+    weightsWrapper->copyToHost();
+    float *bias = 0;
+    if(dim.biased) {
+        biasWrapper->copyToHost();
+        bias = (float *)biasWrapper->getHostArray();
+    }
+    forward(batchSize, (float *)dataWrapper->getHostArray(), (float *)weightsWrapper->getHostArray(),
+        bias, (float *)outputWrapper->getHostArray());
+    outputWrapper->copyToDevice();
+}
+// writes batchSize * dim.outputCubeSize floats into output, which caller allocates
+PUBLIC VIRTUAL void ForwardWinogradCpu::forward(int batchSize, float *inputData, float *weights, float *bias, float *output) {
+    winograd->convolveCpu(batchSize, inputData, weights, bias, output);
+}
@@ -0,0 +1,38 @@
+// Copyright Hugh Perkins 2015 hughperkins at gmail
+//
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file, You can
+// obtain one at http://mozilla.org/MPL/2.0/.
+
+#pragma once
+
+#include "Forward.h"
+
+class Winograd;
+
+#include "DeepCLDllExport.h"
+
+#define VIRTUAL virtual
+#define STATIC static
+
+// native Winograd F(2x2,3x3), on ThreadPool, see Winograd.h
+// odd filter sizes, skip 0; larger filters are split into 3x3 sub filters
+class DeepCL_EXPORT ForwardWinogradCpu : public Forward {
+    private:
+    Winograd *winograd;
+
+    // [[[cog
+    // import cog_addheaders
+    // cog_addheaders.addv2()
+    // ]]]
+    // generated, using cog:
+
+    public:
+    ForwardWinogradCpu(EasyCL *cl, LayerDimensions dim);
+    VIRTUAL ~ForwardWinogradCpu();
+    VIRTUAL void forward(int batchSize, CLWrapper *dataWrapper, CLWrapper *weightsWrapper, CLWrapper *biasWrapper, CLWrapper *outputWrapper);
+    VIRTUAL void forward(int batchSize, float *inputData, float *weights, float *bias, float *output);
+
+    // [[[end]]]
+};
+
@@ -2,11 +2,13 @@
 #include "clblas/ClBlasHelper.h"
 #include "EasyCL.h"
 #include "templates/TemplatedKernel.h"
+#include "util/KernelCache.h"
 
 #include "Im2Col.h"
 
 #include <iostream>
 #include <stdexcept>
+#include <algorithm>
 using namespace std;
 
 #undef STATIC
@@ -20,10 +22,12 @@ PUBLIC Im2Col::Im2Col(EasyCL *cl, LayerDimensions dim) :
         dim(dim) {
 //    ClBlasInstance::initializeIfNecessary();
     this->kernelIm2Col = 0;
+    this->kernelIm2ColBatched = 0;
     this->kernelCol2Im = 0;
 }
 PUBLIC VIRTUAL Im2Col::~Im2Col() {
     delete kernelIm2Col;
+    delete kernelIm2ColBatched;
     delete kernelCol2Im;
 }
 void Im2Col::setupBuilder(TemplatedKernel *builder) {
@@ -46,23 +50,31 @@ void Im2Col::setupBuilder(TemplatedKernel *builder) {
 void Im2Col::buildKernelIm2Col() {
     TemplatedKernel builder(cl);
     setupBuilder(&builder);
-    this->kernelIm2Col = builder.buildKernel(
-        "im2col",
+    this->kernelIm2Col = KernelCache::buildTemplatedKernel(
+        cl, &builder,
         "ForwardIm2Col.cl",
         getKernelTemplate(),
-        "im2col",
-        false
+        "im2col"
+    );
+}
+void Im2Col::buildKernelIm2ColBatched() {
+    TemplatedKernel builder(cl);
+    setupBuilder(&builder);
+    this->kernelIm2ColBatched = KernelCache::buildTemplatedKernel(
+        cl, &builder,
+        "ForwardIm2Col.cl",
+        getKernelTemplate(),
+        "im2col_batched"
     );
 }
 void Im2Col::buildKernelCol2Im() {
     TemplatedKernel builder(cl);
     setupBuilder(&builder);
-    this->kernelCol2Im = builder.buildKernel(
-        "col2im",
+    this->kernelCol2Im = KernelCache::buildTemplatedKernel(
+        cl, &builder,
         "ForwardIm2Col.cl",
         getKernelTemplate(),
-        "col2im",
-        false
+        "col2im"
     );
 }
 PUBLIC void Im2Col::im2Col(CLWrapper *imagesWrapper, int imagesOffset, CLWrapper *columnsWrapper) {
@@ -79,6 +91,25 @@ PUBLIC void Im2Col::im2Col(CLWrapper *imagesWrapper, int imagesOffset, CLWrapper
 
     kernelIm2Col->run_1d(numWorkgroups * workgroupSize, workgroupSize);
 }
+// unrolls numImages images, starting at imagesOffset, into one columns matrix,
+// of (inputPlanes * filterSizeSquared) rows, each of numImages * outputSizeSquared
+// values, laid out as [image][outputRow][outputCol]
+PUBLIC void Im2Col::im2ColBatch(CLWrapper *imagesWrapper, int imagesOffset, int numImages, CLWrapper *columnsWrapper) {
+    if(kernelIm2ColBatched == 0) {
+        buildKernelIm2ColBatched();
+    }
+    int numKernels = numImages * numKernelsIm2Col;
+    kernelIm2ColBatched->in(numKernels);
+    kernelIm2ColBatched->in(numImages);
+    kernelIm2ColBatched->in(imagesWrapper);
+    kernelIm2ColBatched->in(imagesOffset);
+    kernelIm2ColBatched->out(columnsWrapper);
+
+    int workgroupSize = std::min(cl->getMaxWorkgroupSize(), 256);
+    int numWorkgroups = (numKernels + workgroupSize - 1) / workgroupSize;
+
+    kernelIm2ColBatched->run_1d(numWorkgroups * workgroupSize, workgroupSize);
+}
 PUBLIC void Im2Col::col2Im(CLWrapper *columnsWrapper, CLWrapper *imagesWrapper, int imagesOffset) {
     if(kernelCol2Im == 0) {
         buildKernelCol2Im();
@@ -145,6 +176,41 @@ STATIC std::string Im2Col::getKernelTemplate() {
     "  }\n"
     "}\n"
     "\n"
+    "// batched version of im2col: unrolls numImages images side by side, so\n"
+    "// each row of data_col is [image][h_out][w_out], ie the columns matrix\n"
+    "// is (channels * filterSize * filterSize) rows by (numImages * colSize * colSize)\n"
+    "// cols, and one gemm covers all numImages images\n"
+    "kernel void im2col_batched(\n"
+    "    const int n, const int numImages,\n"
+    "    global float const * im_data, int im_offset,\n"
+    "    global float* data_col) {\n"
+    "  const int rowLength = numImages * {{colSize}} * {{colSize}};\n"
+    "  CL_KERNEL_LOOP(index, n) {\n"
+    "    int w_out = index % {{colSize}};\n"
+    "    int remainder = index / {{colSize}};\n"
+    "    int h_out = remainder % {{colSize}};\n"
+    "    remainder /= {{colSize}};\n"
+    "    int channel_in = remainder % {{channels}};\n"
+    "    int image = remainder / {{channels}};\n"
+    "    int channel_out = channel_in * {{filterSize}} * {{filterSize}};\n"
+    "    int h_in = h_out * {{stride}} - {{padding}};\n"
+    "    int w_in = w_out * {{stride}} - {{padding}};\n"
+    "    global float *col = data_col + channel_out * rowLength\n"
+    "      + (image * {{colSize}} + h_out) * {{colSize}} + w_out;\n"
+    "    global float const *im = im_data + im_offset\n"
+    "      + ((image * {{channels}} + channel_in) * {{size}} + h_in) * {{size}} + w_in;\n"
+    "    for (int i = 0; i < {{filterSize}}; ++i) {\n"
+    "      for (int j = 0; j < {{filterSize}}; ++j) {\n"
+    "        int h = h_in + i;\n"
+    "        int w = w_in + j;\n"
+    "        *col = (h >= 0 && w >= 0 && h < {{size}} && w < {{size}}) ?\n"
+    "          im[i * {{size}} + j] : 0;\n"
+    "        col += rowLength;\n"
+    "      }\n"
+    "    }\n"
+    "  }\n"
+    "}\n"
+    "\n"
     "kernel void col2im(\n"
     "    const int n,\n"
     "    global float const *data_col,\n"
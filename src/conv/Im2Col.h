@@ -17,6 +17,7 @@ class Im2Col {
     LayerDimensions dim;
 
     CLKernel *kernelIm2Col;
+    CLKernel *kernelIm2ColBatched;
     CLKernel *kernelCol2Im;
 
     int numKernelsIm2Col;
@@ -32,11 +33,13 @@ class Im2Col {
     Im2Col(EasyCL *cl, LayerDimensions dim);
     VIRTUAL ~Im2Col();
     void im2Col(CLWrapper *imagesWrapper, int imagesOffset, CLWrapper *columnsWrapper);
+    void im2ColBatch(CLWrapper *imagesWrapper, int imagesOffset, int numImages, CLWrapper *columnsWrapper);
     void col2Im(CLWrapper *columnsWrapper, CLWrapper *imagesWrapper, int imagesOffset);
 
     private:
     void setupBuilder(TemplatedKernel *builder);
     void buildKernelIm2Col();
+    void buildKernelIm2ColBatched();
     void buildKernelCol2Im();
     STATIC std::string getKernelTemplate();
 
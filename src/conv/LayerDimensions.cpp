@@ -4,6 +4,7 @@
 #include "util/stringhelper.h"
 
 #include "conv/LayerDimensions.h"
+#include "activate/ActivationFunction.h"
 
 using namespace std;
 
@@ -17,6 +18,9 @@ ostream &operator<<(ostream &os, const LayerDimensions &dim) {
     os << " padZeros=" << dim.padZeros;
     os << " biased=" << dim.biased;
     os << " skip=" << dim.skip;
+    if(dim.activation != 0) {
+        os << " activation=" << dim.activation->getDefineName();
+    }
     os << "}";
     return os;
 }
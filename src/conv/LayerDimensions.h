@@ -5,6 +5,8 @@
 
 #include "DeepCLDllExport.h"
 
+class ActivationFunction;
+
 inline int square(int value) {
     return value * value;
 }
@@ -27,6 +29,9 @@ public:
 
     int halfFilterSize;
 
+    // applied in the forward epilogue, after the bias, if non-zero.  NOT owned
+    ActivationFunction const *activation;
+
     LayerDimensions() {
         memset(this, 0, sizeof(LayerDimensions) );
     }
@@ -38,7 +43,8 @@ public:
             numFilters(numFilters),
             filterSize(filterSize),
             padZeros(padZeros),
-            biased(biased)
+            biased(biased),
+            activation(0)
         {
         skip = 0;
         deriveOthers();
@@ -85,6 +91,10 @@ public:
         deriveOthers();
         return *this;
     }
+    LayerDimensions &setActivation(ActivationFunction const *activation) {
+        this->activation = activation;
+        return *this;
+    }
     void deriveOthers();
     std::string buildOptionsString();
 };
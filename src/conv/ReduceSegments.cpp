@@ -6,8 +6,8 @@
 
 #include <iostream>
 
-#include "util/StatefulTimer.h"
 #include "conv/ReduceSegments.h"
+#include "util/KernelCache.h"
 
 using namespace std;
 
@@ -24,7 +24,6 @@ VIRTUAL void ReduceSegments::reduce(
         CLWrapper *inputWrapper,
         CLWrapper *outputWrapper
             ) {
-    StatefulTimer::timeCheck("ReduceSegments::reduce begin");
 
     if(totalLength % segmentLength != 0) {
         throw runtime_error("ReduceSegments: totalLength should be multiple of segmentLength");
@@ -39,7 +38,6 @@ VIRTUAL void ReduceSegments::reduce(
     kernel->run_1d(numWorkgroups * 64, 64);
     cl->finish();
 
-    StatefulTimer::timeCheck("ReduceSegments::reduce end");
 }
 ReduceSegments::ReduceSegments(EasyCL *cl) :
         cl(cl)
@@ -83,7 +81,7 @@ ReduceSegments::ReduceSegments(EasyCL *cl) :
     "\n"
     "\n"
     "";
-    kernel = cl->buildKernelFromString(kernelSource, "reduce_segments", options, "cl/reduce_segments.cl");
+    kernel = KernelCache::buildKernelFromString(cl, kernelSource, "reduce_segments", options, "cl/reduce_segments.cl");
     // [[[end]]]
 
     cl->storeKernel(kernelName, kernel, true);
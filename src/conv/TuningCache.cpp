@@ -0,0 +1,165 @@
+// Copyright Hugh Perkins 2015 hughperkins at gmail
+//
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file, You can
+// obtain one at http://mozilla.org/MPL/2.0/.
+
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+#include <cstdlib>
+#include <vector>
+
+#include "EasyCL.h"
+#include "util/FileHelper.h"
+#include "util/FileLock.h"
+#include "util/DeviceKey.h"
+#include "util/stringhelper.h"
+
+#include "conv/TuningCache.h"
+#include "activate/ActivationFunction.h"
+
+using namespace std;
+
+#undef STATIC
+#define STATIC
+#undef VIRTUAL
+#define VIRTUAL
+
+PUBLIC TuningCache::TuningCache() :
+        loaded(false),
+        enabled(true) {
+    const char *fromEnv = getenv("DEEPCL_TUNING_CACHE");
+    if(fromEnv != 0 && string(fromEnv) == "0") {
+        enabled = false;
+    }
+}
+PUBLIC STATIC TuningCache *TuningCache::instance() {
+    static TuningCache *thisinstance = new TuningCache();
+    return thisinstance;
+}
+// when disabled, lookup never finds anything, and store doesnt write anything
+PUBLIC void TuningCache::setEnabled(bool enabled) {
+    lock_guard<std::mutex> lock(mutex);
+    this->enabled = enabled;
+}
+PUBLIC bool TuningCache::isEnabled() {
+    lock_guard<std::mutex> lock(mutex);
+    return enabled;
+}
+// kind is eg "forward", numImplementations is there so that adding a new
+// kernel invalidates the old results, which might have picked a different index
+PUBLIC STATIC std::string TuningCache::makeKey(std::string kind, int numImplementations, EasyCL *cl, LayerDimensions dim, int batchSize) {
+    ostringstream key;
+    key << kind << " impls=" << numImplementations
+        << " device=" << DeviceKey::get(cl)
+        << " inputPlanes=" << dim.inputPlanes
+        << " inputSize=" << dim.inputSize
+        << " numFilters=" << dim.numFilters
+        << " filterSize=" << dim.filterSize
+        << " padZeros=" << dim.padZeros
+        << " biased=" << dim.biased
+        << " skip=" << dim.skip;
+    // fused activations get their own entries, keys without one are as before
+    if(dim.activation != 0) {
+        key << " activation=" << dim.activation->getDefineName();
+    }
+    key << " batchSize=" << batchSize;
+    return key.str();
+}
+// returns "" if there is no cache directory
+PUBLIC std::string TuningCache::getFilepath() {
+    string directory = FileHelper::getCacheDirectory();
+    if(directory == "") {
+        return "";
+    }
+    return directory + FileHelper::pathSeparator() + "tuning.txt";
+}
+PUBLIC bool TuningCache::lookup(std::string key, int *p_index, int *p_milliseconds) {
+    lock_guard<std::mutex> lock(mutex);
+    if(!enabled) {
+        return false;
+    }
+    if(!loaded) {
+        string filepath = getFilepath();
+        if(filepath != "") {
+            readFile(filepath, entries);
+        }
+        loaded = true;
+    }
+    map< string, TuningCacheEntry >::iterator it = entries.find(key);
+    if(it == entries.end()) {
+        return false;
+    }
+    *p_index = it->second.index;
+    *p_milliseconds = it->second.milliseconds;
+    return true;
+}
+PUBLIC void TuningCache::store(std::string key, int index, int milliseconds) {
+    lock_guard<std::mutex> lock(mutex);
+    if(!enabled) {
+        return;
+    }
+    TuningCacheEntry entry;
+    entry.index = index;
+    entry.milliseconds = milliseconds;
+    entries[key] = entry;
+    string filepath = getFilepath();
+    if(filepath == "") {
+        return;
+    }
+    // pick up anything other processes wrote since we loaded, then put ours on top,
+    // holding the lock from the read to the rename, so concurrent tuners dont
+    // drop each other's entries
+    FileLock fileLock(filepath);
+    map< string, TuningCacheEntry > onDisk;
+    readFile(filepath, onDisk);
+    for(map< string, TuningCacheEntry >::iterator it = entries.begin(); it != entries.end(); it++) {
+        onDisk[it->first] = it->second;
+    }
+    entries = onDisk;
+    loaded = true;
+    ostringstream contents;
+    contents << "# DeepCL kernel tuning cache.  Safe to delete" << endl;
+    for(map< string, TuningCacheEntry >::iterator it = entries.begin(); it != entries.end(); it++) {
+        contents << it->first << "\t" << it->second.index << "\t" << it->second.milliseconds << endl;
+    }
+    string contentsString = contents.str();
+    try {
+        FileHelper::writeBinaryAtomic(filepath, contentsString.c_str(), (long)contentsString.size());
+    } catch(runtime_error &e) {
+        cout << "Warning: failed to write tuning cache " << filepath << ": " << e.what() << endl;
+    }
+}
+// forgets everything, including what is on disk
+PUBLIC void TuningCache::clear() {
+    lock_guard<std::mutex> lock(mutex);
+    entries.clear();
+    loaded = true;
+    string filepath = getFilepath();
+    if(filepath != "" && FileHelper::exists(filepath)) {
+        FileHelper::remove(filepath);
+    }
+}
+// lines we cant parse are ignored, so a damaged file just means retuning
+PRIVATE STATIC void TuningCache::readFile(std::string filepath, std::map< std::string, TuningCacheEntry > &target) {
+    ifstream file(FileHelper::localizePath(filepath).c_str());
+    if(!file.is_open()) {
+        return;
+    }
+    string line;
+    while(getline(file, line)) {
+        if(line.size() == 0 || line[0] == '#') {
+            continue;
+        }
+        vector<string> fields = split(line, "\t");
+        if(fields.size() != 3 || fields[0] == "") {
+            continue;
+        }
+        TuningCacheEntry entry;
+        entry.index = atoi(fields[1]);
+        entry.milliseconds = atoi(fields[2]);
+        target[fields[0]] = entry;
+    }
+}
@@ -0,0 +1,70 @@
+// Copyright Hugh Perkins 2015 hughperkins at gmail
+//
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file, You can
+// obtain one at http://mozilla.org/MPL/2.0/.
+
+#pragma once
+
+#include <string>
+#include <map>
+#include <mutex>
+
+#include "conv/LayerDimensions.h"
+#include "DeepCLDllExport.h"
+
+class EasyCL;
+
+#define VIRTUAL virtual
+#define STATIC static
+
+class TuningCacheEntry {
+public:
+    int index;
+    int milliseconds;
+};
+
+// remembers which kernel ForwardAuto, BackwardAuto and BackpropWeightsAuto
+// chose, keyed by device, driver, layer dimensions and batch size, in
+// tuning.txt, in FileHelper::getCacheDirectory()
+// So later processes can go straight to the winning kernel, without
+// timing all the others first
+// The file is plain text, one entry per line: key <tab> index <tab> milliseconds
+// Several processes can tune at the same time: each write merges what is
+// already on disk, and replaces the file atomically
+class DeepCL_EXPORT TuningCache {
+    private:
+    #ifdef _WIN32
+    #pragma warning(disable: 4251)
+    #endif
+    std::mutex mutex;
+    std::map< std::string, TuningCacheEntry > entries;
+    #ifdef _WIN32
+    #pragma warning(default: 4251)
+    #endif
+    bool loaded;
+    bool enabled;
+
+    // [[[cog
+    // import cog_addheaders
+    // cog_addheaders.addv2()
+    // ]]]
+    // generated, using cog:
+
+    public:
+    TuningCache();
+    STATIC TuningCache *instance();
+    void setEnabled(bool enabled);
+    bool isEnabled();
+    STATIC std::string makeKey(std::string kind, int numImplementations, EasyCL *cl, LayerDimensions dim, int batchSize);
+    std::string getFilepath();
+    bool lookup(std::string key, int *p_index, int *p_milliseconds);
+    void store(std::string key, int index, int milliseconds);
+    void clear();
+
+    private:
+    STATIC void readFile(std::string filepath, std::map< std::string, TuningCacheEntry > &target);
+
+    // [[[end]]]
+};
+
@@ -0,0 +1,915 @@
+// Copyright Hugh Perkins 2015 hughperkins at gmail
+//
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file, You can
+// obtain one at http://mozilla.org/MPL/2.0/.
+
+#include <iostream>
+#include <stdexcept>
+#include <algorithm>
+#include <vector>
+
+#include "EasyCL.h"
+#include "clblas/ClBlasHelper.h"
+#include "activate/ActivationFunction.h"
+#include "util/stringhelper.h"
+#include "util/ThreadPool.h"
+#include "util/KernelCache.h"
+#include "util/WorkspaceScope.h"
+
+#include "conv/Winograd.h"
+
+using namespace std;
+
+#undef STATIC
+#undef VIRTUAL
+#define STATIC
+#define VIRTUAL
+#define PUBLIC
+
+// scratch budget for the transformed inputs and products of each chunk of images
+#define WINOGRAD_WORKSPACE_MB 256
+
+PUBLIC STATIC bool Winograd::supports(LayerDimensions dim) {
+    return dim.skip == 0 && !dim.isEven;
+}
+/// cl can be 0, then only convolveCpu can be used
+PUBLIC Winograd::Winograd(EasyCL *cl, LayerDimensions dim, bool backward) :
+        cl(cl),
+        dim(dim),
+        backward(backward),
+        kernelFilters(0),
+        kernelInput(0),
+        kernelOutput(0) {
+    if(dim.skip != 0) {
+        throw runtime_error("Winograd: skip not supported");
+    }
+    if(dim.isEven) {
+        throw runtime_error("Winograd: even filter sizes not supported");
+    }
+    const int forwardMargin = dim.padZeros ? dim.halfFilterSize : 0;
+    if(backward) {
+        inPlanes = dim.numFilters;
+        inSize = dim.outputSize;
+        outPlanes = dim.inputPlanes;
+        outSize = dim.inputSize;
+        margin = dim.filterSize - 1 - forwardMargin;
+        biased = false;
+    } else {
+        inPlanes = dim.inputPlanes;
+        inSize = dim.inputSize;
+        outPlanes = dim.numFilters;
+        outSize = dim.outputSize;
+        margin = forwardMargin;
+        biased = dim.biased;
+    }
+    numSubFilters = (dim.filterSize + 2) / 3;
+    channels = inPlanes * numSubFilters * numSubFilters;
+    tilesPerRow = (outSize + 1) / 2;
+    tilesPerImage = tilesPerRow * tilesPerRow;
+    if(cl != 0) {
+        buildKernels();
+    }
+}
+PUBLIC VIRTUAL Winograd::~Winograd() {
+    // kernels are owned by cl
+}
+PUBLIC int Winograd::getTransformedFiltersSize() {
+    return 16 * outPlanes * channels;
+}
+// filter weight, as seen by the forward convolution we are doing
+PRIVATE float Winograd::filterAt(float const*filters, int outPlane, int inPlane, int row, int col) {
+    const int filterSize = dim.filterSize;
+    if(backward) {
+        return filters[((inPlane * outPlanes + outPlane) * filterSize + filterSize - 1 - row)
+            * filterSize + filterSize - 1 - col];
+    }
+    return filters[((outPlane * inPlanes + inPlane) * filterSize + row) * filterSize + col];
+}
+/// G g G^T, into transformed[16][outPlanes][channels]; same as winograd_filters in cl/winograd.cl
+PUBLIC void Winograd::transformFilters(float const*filters, float *transformed) {
+    const int stride = outPlanes * channels;
+    for(int outPlane = 0; outPlane < outPlanes; outPlane++) {
+        for(int channel = 0; channel < channels; channel++) {
+            const int inPlane = channel % inPlanes;
+            const int sub = channel / inPlanes;
+            const int subRow = sub / numSubFilters;
+            const int subCol = sub % numSubFilters;
+            float g[3][3];
+            for(int i = 0; i < 3; i++) {
+                for(int j = 0; j < 3; j++) {
+                    const int row = subRow * 3 + i;
+                    const int col = subCol * 3 + j;
+                    g[i][j] = (row < dim.filterSize && col < dim.filterSize) ?
+                        filterAt(filters, outPlane, inPlane, row, col) : 0.0f;
+                }
+            }
+            float t[4][3];
+            for(int j = 0; j < 3; j++) {
+                t[0][j] = g[0][j];
+                t[1][j] = 0.5f * (g[0][j] + g[1][j] + g[2][j]);
+                t[2][j] = 0.5f * (g[0][j] - g[1][j] + g[2][j]);
+                t[3][j] = g[2][j];
+            }
+            float *out = transformed + outPlane * channels + channel;
+            for(int i = 0; i < 4; i++) {
+                out[(i * 4 + 0) * stride] = t[i][0];
+                out[(i * 4 + 1) * stride] = 0.5f * (t[i][0] + t[i][1] + t[i][2]);
+                out[(i * 4 + 2) * stride] = 0.5f * (t[i][0] - t[i][1] + t[i][2]);
+                out[(i * 4 + 3) * stride] = t[i][2];
+            }
+        }
+    }
+}
+/// native path, on ThreadPool, one task per [image][row of tiles]
+/// output is batchSize * outPlanes * outSize * outSize floats, which caller allocates
+/// bias is only read if biased
+PUBLIC void Winograd::convolveCpu(int batchSize, float const*input, float const*filters, float const*bias, float *output) {
+    float *transformed = new float[getTransformedFiltersSize()];
+    transformFilters(filters, transformed);
+    const int inCubeSize = inPlanes * inSize * inSize;
+    const int outCubeSize = outPlanes * outSize * outSize;
+    ThreadPool::instance()->parallelFor(batchSize * tilesPerRow, [&](int task) {
+        const int n = task / tilesPerRow;
+        vector<float> V(16 * channels * tilesPerRow);
+        vector<float> M(16 * outPlanes * tilesPerRow);
+        convolveCpuTileRow(input + n * inCubeSize, transformed, bias, task % tilesPerRow,
+            &V[0], &M[0], output + n * outCubeSize);
+    });
+    delete[] transformed;
+}
+// V and M are scratch, [16][channels][tilesPerRow] and [16][outPlanes][tilesPerRow]
+PRIVATE void Winograd::convolveCpuTileRow(float const*image, float const*transformed, float const*bias, int tileRow, float *V, float *M, float *imageOutput) {
+    const int rowStride = channels * tilesPerRow;
+    for(int channel = 0; channel < channels; channel++) {
+        const int inPlane = channel % inPlanes;
+        const int sub = channel / inPlanes;
+        const int row0 = tileRow * 2 - margin + (sub / numSubFilters) * 3;
+        float const*plane = image + inPlane * inSize * inSize;
+        for(int tileCol = 0; tileCol < tilesPerRow; tileCol++) {
+            const int col0 = tileCol * 2 - margin + (sub % numSubFilters) * 3;
+            float d[4][4];
+            for(int i = 0; i < 4; i++) {
+                const int row = row0 + i;
+                for(int j = 0; j < 4; j++) {
+                    const int col = col0 + j;
+                    d[i][j] = (row >= 0 && row < inSize && col >= 0 && col < inSize) ?
+                        plane[row * inSize + col] : 0.0f;
+                }
+            }
+            float b[4][4];
+            for(int j = 0; j < 4; j++) {
+                b[0][j] = d[0][j] - d[2][j];
+                b[1][j] = d[1][j] + d[2][j];
+                b[2][j] = d[2][j] - d[1][j];
+                b[3][j] = d[1][j] - d[3][j];
+            }
+            float *out = V + channel * tilesPerRow + tileCol;
+            for(int i = 0; i < 4; i++) {
+                out[(i * 4 + 0) * rowStride] = b[i][0] - b[i][2];
+                out[(i * 4 + 1) * rowStride] = b[i][1] + b[i][2];
+                out[(i * 4 + 2) * rowStride] = b[i][2] - b[i][1];
+                out[(i * 4 + 3) * rowStride] = b[i][1] - b[i][3];
+            }
+        }
+    }
+    // the 16 small gemms: M[k] = transformed[k] * V[k]
+    for(int k = 0; k < 16; k++) {
+        for(int outPlane = 0; outPlane < outPlanes; outPlane++) {
+            float *m = M + (k * outPlanes + outPlane) * tilesPerRow;
+            float const*u = transformed + (k * outPlanes + outPlane) * channels;
+            for(int tileCol = 0; tileCol < tilesPerRow; tileCol++) {
+                m[tileCol] = 0;
+            }
+            for(int channel = 0; channel < channels; channel++) {
+                const float weight = u[channel];
+                float const*v = V + (k * channels + channel) * tilesPerRow;
+                for(int tileCol = 0; tileCol < tilesPerRow; tileCol++) {
+                    m[tileCol] += weight * v[tileCol];
+                }
+            }
+        }
+    }
+    ActivationFunction const*activation = backward ? 0 : dim.activation;
+    for(int outPlane = 0; outPlane < outPlanes; outPlane++) {
+        float *plane = imageOutput + outPlane * outSize * outSize;
+        for(int tileCol = 0; tileCol < tilesPerRow; tileCol++) {
+            float m[16];
+            for(int k = 0; k < 16; k++) {
+                m[k] = M[(k * outPlanes + outPlane) * tilesPerRow + tileCol];
+            }
+            float a[2][4];
+            for(int j = 0; j < 4; j++) {
+                a[0][j] = m[j] + m[4 + j] + m[8 + j];
+                a[1][j] = m[4 + j] - m[8 + j] - m[12 + j];
+            }
+            for(int i = 0; i < 2; i++) {
+                const int row = tileRow * 2 + i;
+                for(int j = 0; j < 2; j++) {
+                    const int col = tileCol * 2 + j;
+                    if(row >= outSize || col >= outSize) {
+                        continue;
+                    }
+                    float value = j == 0 ? a[i][0] + a[i][1] + a[i][2] : a[i][1] - a[i][2] - a[i][3];
+                    if(biased) {
+                        value += bias[outPlane];
+                    }
+                    if(activation != 0) {
+                        value = activation->calc(value);
+                    }
+                    plane[row * outSize + col] = value;
+                }
+            }
+        }
+    }
+}
+// how many images to transform per chunk, within WINOGRAD_WORKSPACE_MB
+PUBLIC int Winograd::getChunkSize(int batchSize) {
+    int64 VBytesPerImage = (int64)16 * channels * tilesPerImage * sizeof(float);
+    int64 MBytesPerImage = (int64)16 * outPlanes * tilesPerImage * sizeof(float);
+    int64 budgetBytes = (int64)WINOGRAD_WORKSPACE_MB * 1024 * 1024;
+    int64 maxAllocBytes = (int64)cl->getMaxAllocSizeMB() * 1024 * 1024;
+    int64 chunkSize = budgetBytes / (VBytesPerImage + MBytesPerImage);
+    chunkSize = std::min(chunkSize, maxAllocBytes / VBytesPerImage);
+    chunkSize = std::min(chunkSize, maxAllocBytes / MBytesPerImage);
+    chunkSize = std::min(chunkSize, (int64)batchSize);
+    return std::max((int)chunkSize, 1);
+}
+/// opencl path: transform filters, then per chunk of images, transform the
+/// inputs, 16 gemms, and transform back into outputWrapper
+/// biasWrapper is only read if biased
+PUBLIC void Winograd::convolve(int batchSize, CLWrapper *inputWrapper, CLWrapper *filtersWrapper, CLWrapper *biasWrapper, CLWrapper *outputWrapper) {
+    const int chunkSize = getChunkSize(batchSize);
+    WorkspaceScope workspace(cl);
+    CLWrapper *transformedWrapper = workspace.acquire(getTransformedFiltersSize());
+    CLWrapper *VWrapper = workspace.acquire(16 * channels * tilesPerImage * chunkSize);
+    CLWrapper *MWrapper = workspace.acquire(16 * outPlanes * tilesPerImage * chunkSize);
+    if(!outputWrapper->isOnDevice()) {
+        outputWrapper->createOnDevice();
+    }
+    const int workgroupSize = 64;
+
+    kernelFilters->in(filtersWrapper)->out(transformedWrapper);
+    int numWorkgroups = (outPlanes * channels + workgroupSize - 1) / workgroupSize;
+    kernelFilters->run_1d(numWorkgroups * workgroupSize, workgroupSize);
+
+    for(int chunkStart = 0; chunkStart < batchSize; chunkStart += chunkSize) {
+        const int thisChunkSize = std::min(chunkSize, batchSize - chunkStart);
+        const int numTiles = thisChunkSize * tilesPerImage;
+
+        kernelInput->in(thisChunkSize)->in(inputWrapper)->in(chunkStart * inPlanes * inSize * inSize)
+            ->out(VWrapper);
+        numWorkgroups = (channels * numTiles + workgroupSize - 1) / workgroupSize;
+        kernelInput->run_1d(numWorkgroups * workgroupSize, workgroupSize);
+
+        for(int k = 0; k < 16; k++) {
+            ClBlasHelper::Gemm(
+                cl, clblasRowMajor, clblasNoTrans, clblasNoTrans,
+                outPlanes, channels, numTiles,
+                1,
+                transformedWrapper, (int64)k * outPlanes * channels,
+                VWrapper, (int64)k * channels * numTiles,
+                0,
+                MWrapper, (int64)k * outPlanes * numTiles
+            );
+        }
+
+        kernelOutput->in(thisChunkSize)->in(MWrapper)
+            ->in(biased ? biasWrapper : MWrapper) // not read, if not biased
+            ->out(outputWrapper)->in(chunkStart * outPlanes * outSize * outSize);
+        numWorkgroups = (outPlanes * numTiles + workgroupSize - 1) / workgroupSize;
+        kernelOutput->run_1d(numWorkgroups * workgroupSize, workgroupSize);
+    }
+    cl->finish();
+}
+PRIVATE void Winograd::buildKernels() {
+    string options = "";
+    options += " -D gInPlanes=" + toString(inPlanes);
+    options += " -D gInSize=" + toString(inSize);
+    options += " -D gOutPlanes=" + toString(outPlanes);
+    options += " -D gOutSize=" + toString(outSize);
+    options += " -D gFilterSize=" + toString(dim.filterSize);
+    options += " -D gMargin=" + toString(margin);
+    options += " -D gNumSubFilters=" + toString(numSubFilters);
+    options += " -D gChannels=" + toString(channels);
+    options += " -D gTilesPerRow=" + toString(tilesPerRow);
+    options += " -D gTilesPerImage=" + toString(tilesPerImage);
+    if(backward) {
+        options += " -D BACKWARD";
+    }
+    if(biased) {
+        options += " -D BIASED";
+    }
+    if(!backward && dim.activation != 0) {
+        options += " -D " + string(dim.activation->getDefineName());
+    }
+    string kernelName = "Winograd.winograd_filters" + options;
+    if(cl->kernelExists(kernelName)) {
+        kernelFilters = cl->getKernel(kernelName);
+        kernelInput = cl->getKernel("Winograd.winograd_input" + options);
+        kernelOutput = cl->getKernel("Winograd.winograd_output" + options);
+        return;
+    }
+    // [[[cog
+    // import stringify
+    // stringify.write_kernel2("kernelFilters", "cl/winograd.cl", "winograd_filters", 'options')
+    // stringify.write_kernel2("kernelInput", "cl/winograd.cl", "winograd_input", 'options')
+    // stringify.write_kernel2("kernelOutput", "cl/winograd.cl", "winograd_output", 'options')
+    // ]]]
+    // generated using cog, from cl/winograd.cl:
+    const char * kernelFiltersSource =  
+    "// Copyright Hugh Perkins 2015 hughperkins at gmail\n"
+    "//\n"
+    "// This Source Code Form is subject to the terms of the Mozilla Public License,\n"
+    "// v. 2.0. If a copy of the MPL was not distributed with this file, You can\n"
+    "// obtain one at http://mozilla.org/MPL/2.0/.\n"
+    "\n"
+    "// Winograd F(2x2,3x3), see Winograd.h\n"
+    "// the 16 transformed filters times transformed inputs are 16 gemms, done with\n"
+    "// clblas between winograd_input and winograd_output\n"
+    "\n"
+    "// expected defines:\n"
+    "// gInPlanes, gInSize, gOutPlanes, gOutSize, gFilterSize, gMargin\n"
+    "// gNumSubFilters, gChannels, gTilesPerRow, gTilesPerImage\n"
+    "// BACKWARD (optional): filters are [gInPlanes][gOutPlanes], and flipped\n"
+    "// BIASED (optional)\n"
+    "// one of: [ TANH | RELU | LINEAR | SIGMOID | SCALEDTANH | ELU ] (optional, fuses the activation)\n"
+    "\n"
+    "// including cl/activate_defines.cl:\n"
+    "// Copyright Hugh Perkins 2015 hughperkins at gmail\n"
+    "//\n"
+    "// This Source Code Form is subject to the terms of the Mozilla Public License,\n"
+    "// v. 2.0. If a copy of the MPL was not distributed with this file, You can\n"
+    "// obtain one at http://mozilla.org/MPL/2.0/.\n"
+    "\n"
+    "// ACTIVATION_FUNCTION, for kernels that fuse an activation into their output,\n"
+    "// and ACTIVATION_DERIV, its derivative, written in terms of that output, for\n"
+    "// kernels that fuse it into reading gradOutput;\n"
+    "// both left undefined if none of the activation defines is given\n"
+    "// one of: [ TANH | RELU | LINEAR | SIGMOID | SCALEDTANH | ELU ] (optional)\n"
+    "\n"
+    "#ifdef TANH\n"
+    "    #define ACTIVATION_FUNCTION(output) (tanh(output))\n"
+    "#elif defined SCALEDTANH\n"
+    "    #define ACTIVATION_FUNCTION(output) (1.7159f * tanh(0.66667f * output))\n"
+    "#elif defined SIGMOID\n"
+    "    #define ACTIVATION_FUNCTION(output) (1.0f / (1 + exp(-output)))\n"
+    "#elif defined RELU\n"
+    "    #define ACTIVATION_FUNCTION(output) (output> 0 ? output : 0)\n"
+    "#elif defined ELU\n"
+    "    #define ACTIVATION_FUNCTION(output) (output> 0 ? output : exp(output) - 1)\n"
+    "#elif defined LINEAR\n"
+    "    #define ACTIVATION_FUNCTION(output) (output)\n"
+    "#endif\n"
+    "\n"
+    "#ifdef TANH\n"
+    "    #define ACTIVATION_DERIV(output) (1 - output * output)\n"
+    "#elif defined SCALEDTANH\n"
+    "    #define ACTIVATION_DERIV(output) (0.66667f * (1.7159f - 1 / 1.7159f * output * output) )\n"
+    "#elif defined SIGMOID\n"
+    "    #define ACTIVATION_DERIV(output) (output * (1 - output) )\n"
+    "#elif defined RELU\n"
+    "    #define ACTIVATION_DERIV(output) (output > 0 ? 1 : 0)\n"
+    "#elif defined ELU\n"
+    "    #define ACTIVATION_DERIV(output) (output > 0 ? 1 : output + 1)\n"
+    "#elif defined LINEAR\n"
+    "    #define ACTIVATION_DERIV(output) (1.0f)\n"
+    "#endif\n"
+    "\n"
+    "\n"
+    "// G g G^T, for each [outPlane][channel]\n"
+    "// transformed is [16][gOutPlanes][gChannels]\n"
+    "kernel void winograd_filters(global const float *filters, global float *transformed) {\n"
+    "    const int globalId = get_global_id(0);\n"
+    "    if(globalId >= gOutPlanes * gChannels) {\n"
+    "        return;\n"
+    "    }\n"
+    "    const int channel = globalId % gChannels;\n"
+    "    const int outPlane = globalId / gChannels;\n"
+    "    const int inPlane = channel % gInPlanes;\n"
+    "    const int sub = channel / gInPlanes;\n"
+    "    const int subRow = sub / gNumSubFilters;\n"
+    "    const int subCol = sub % gNumSubFilters;\n"
+    "    float g[3][3];\n"
+    "    for(int i = 0; i < 3; i++) {\n"
+    "        for(int j = 0; j < 3; j++) {\n"
+    "            const int row = subRow * 3 + i;\n"
+    "            const int col = subCol * 3 + j;\n"
+    "            float value = 0;\n"
+    "            if(row < gFilterSize && col < gFilterSize) {\n"
+    "                #ifdef BACKWARD\n"
+    "                value = filters[((inPlane * gOutPlanes + outPlane) * gFilterSize + gFilterSize - 1 - row)\n"
+    "                    * gFilterSize + gFilterSize - 1 - col];\n"
+    "                #else\n"
+    "                value = filters[((outPlane * gInPlanes + inPlane) * gFilterSize + row) * gFilterSize + col];\n"
+    "                #endif\n"
+    "            }\n"
+    "            g[i][j] = value;\n"
+    "        }\n"
+    "    }\n"
+    "    float t[4][3];\n"
+    "    for(int j = 0; j < 3; j++) {\n"
+    "        t[0][j] = g[0][j];\n"
+    "        t[1][j] = 0.5f * (g[0][j] + g[1][j] + g[2][j]);\n"
+    "        t[2][j] = 0.5f * (g[0][j] - g[1][j] + g[2][j]);\n"
+    "        t[3][j] = g[2][j];\n"
+    "    }\n"
+    "    global float *out = transformed + outPlane * gChannels + channel;\n"
+    "    const int stride = gOutPlanes * gChannels;\n"
+    "    for(int i = 0; i < 4; i++) {\n"
+    "        out[(i * 4 + 0) * stride] = t[i][0];\n"
+    "        out[(i * 4 + 1) * stride] = 0.5f * (t[i][0] + t[i][1] + t[i][2]);\n"
+    "        out[(i * 4 + 2) * stride] = 0.5f * (t[i][0] - t[i][1] + t[i][2]);\n"
+    "        out[(i * 4 + 3) * stride] = t[i][2];\n"
+    "    }\n"
+    "}\n"
+    "\n"
+    "// B^T d B, for each [channel][tile] of numImages images, from input + inputOffset\n"
+    "// V is [16][gChannels][numImages * gTilesPerImage]\n"
+    "kernel void winograd_input(const int numImages, global const float *input, const int inputOffset,\n"
+    "        global float *V) {\n"
+    "    const int globalId = get_global_id(0);\n"
+    "    const int numTiles = numImages * gTilesPerImage;\n"
+    "    if(globalId >= gChannels * numTiles) {\n"
+    "        return;\n"
+    "    }\n"
+    "    const int tile = globalId % numTiles;\n"
+    "    const int channel = globalId / numTiles;\n"
+    "    const int n = tile / gTilesPerImage;\n"
+    "    const int tileRow = (tile % gTilesPerImage) / gTilesPerRow;\n"
+    "    const int tileCol = tile % gTilesPerRow;\n"
+    "    const int inPlane = channel % gInPlanes;\n"
+    "    const int sub = channel / gInPlanes;\n"
+    "    const int row0 = tileRow * 2 - gMargin + (sub / gNumSubFilters) * 3;\n"
+    "    const int col0 = tileCol * 2 - gMargin + (sub % gNumSubFilters) * 3;\n"
+    "    global const float *plane = input + inputOffset + (n * gInPlanes + inPlane) * gInSize * gInSize;\n"
+    "    float d[4][4];\n"
+    "    for(int i = 0; i < 4; i++) {\n"
+    "        const int row = row0 + i;\n"
+    "        for(int j = 0; j < 4; j++) {\n"
+    "            const int col = col0 + j;\n"
+    "            d[i][j] = (row >= 0 && row < gInSize && col >= 0 && col < gInSize) ? plane[row * gInSize + col] : 0;\n"
+    "        }\n"
+    "    }\n"
+    "    float b[4][4];\n"
+    "    for(int j = 0; j < 4; j++) {\n"
+    "        b[0][j] = d[0][j] - d[2][j];\n"
+    "        b[1][j] = d[1][j] + d[2][j];\n"
+    "        b[2][j] = d[2][j] - d[1][j];\n"
+    "        b[3][j] = d[1][j] - d[3][j];\n"
+    "    }\n"
+    "    global float *out = V + channel * numTiles + tile;\n"
+    "    const int stride = gChannels * numTiles;\n"
+    "    for(int i = 0; i < 4; i++) {\n"
+    "        out[(i * 4 + 0) * stride] = b[i][0] - b[i][2];\n"
+    "        out[(i * 4 + 1) * stride] = b[i][1] + b[i][2];\n"
+    "        out[(i * 4 + 2) * stride] = b[i][2] - b[i][1];\n"
+    "        out[(i * 4 + 3) * stride] = b[i][1] - b[i][3];\n"
+    "    }\n"
+    "}\n"
+    "\n"
+    "// A^T m A, for each [outPlane][tile], then bias and activation\n"
+    "// M is [16][gOutPlanes][numImages * gTilesPerImage]\n"
+    "kernel void winograd_output(const int numImages, global const float *M, global const float *bias,\n"
+    "        global float *output, const int outputOffset) {\n"
+    "    const int globalId = get_global_id(0);\n"
+    "    const int numTiles = numImages * gTilesPerImage;\n"
+    "    if(globalId >= gOutPlanes * numTiles) {\n"
+    "        return;\n"
+    "    }\n"
+    "    const int tile = globalId % numTiles;\n"
+    "    const int outPlane = globalId / numTiles;\n"
+    "    const int n = tile / gTilesPerImage;\n"
+    "    const int tileRow = (tile % gTilesPerImage) / gTilesPerRow;\n"
+    "    const int tileCol = tile % gTilesPerRow;\n"
+    "    float m[16];\n"
+    "    for(int k = 0; k < 16; k++) {\n"
+    "        m[k] = M[(k * gOutPlanes + outPlane) * numTiles + tile];\n"
+    "    }\n"
+    "    float a[2][4];\n"
+    "    for(int j = 0; j < 4; j++) {\n"
+    "        a[0][j] = m[j] + m[4 + j] + m[8 + j];\n"
+    "        a[1][j] = m[4 + j] - m[8 + j] - m[12 + j];\n"
+    "    }\n"
+    "    global float *plane = output + outputOffset + (n * gOutPlanes + outPlane) * gOutSize * gOutSize;\n"
+    "    for(int i = 0; i < 2; i++) {\n"
+    "        const int row = tileRow * 2 + i;\n"
+    "        for(int j = 0; j < 2; j++) {\n"
+    "            const int col = tileCol * 2 + j;\n"
+    "            if(row >= gOutSize || col >= gOutSize) {\n"
+    "                continue;\n"
+    "            }\n"
+    "            float value = j == 0 ? a[i][0] + a[i][1] + a[i][2] : a[i][1] - a[i][2] - a[i][3];\n"
+    "            #ifdef BIASED\n"
+    "            value += bias[outPlane];\n"
+    "            #endif\n"
+    "            #ifdef ACTIVATION_FUNCTION\n"
+    "            value = ACTIVATION_FUNCTION(value);\n"
+    "            #endif\n"
+    "            plane[row * gOutSize + col] = value;\n"
+    "        }\n"
+    "    }\n"
+    "}\n"
+    "\n"
+    "";
+    kernelFilters = KernelCache::buildKernelFromString(cl, kernelFiltersSource, "winograd_filters", options, "cl/winograd.cl");
+    // generated using cog, from cl/winograd.cl:
+    const char * kernelInputSource =  
+    "// Copyright Hugh Perkins 2015 hughperkins at gmail\n"
+    "//\n"
+    "// This Source Code Form is subject to the terms of the Mozilla Public License,\n"
+    "// v. 2.0. If a copy of the MPL was not distributed with this file, You can\n"
+    "// obtain one at http://mozilla.org/MPL/2.0/.\n"
+    "\n"
+    "// Winograd F(2x2,3x3), see Winograd.h\n"
+    "// the 16 transformed filters times transformed inputs are 16 gemms, done with\n"
+    "// clblas between winograd_input and winograd_output\n"
+    "\n"
+    "// expected defines:\n"
+    "// gInPlanes, gInSize, gOutPlanes, gOutSize, gFilterSize, gMargin\n"
+    "// gNumSubFilters, gChannels, gTilesPerRow, gTilesPerImage\n"
+    "// BACKWARD (optional): filters are [gInPlanes][gOutPlanes], and flipped\n"
+    "// BIASED (optional)\n"
+    "// one of: [ TANH | RELU | LINEAR | SIGMOID | SCALEDTANH | ELU ] (optional, fuses the activation)\n"
+    "\n"
+    "// including cl/activate_defines.cl:\n"
+    "// Copyright Hugh Perkins 2015 hughperkins at gmail\n"
+    "//\n"
+    "// This Source Code Form is subject to the terms of the Mozilla Public License,\n"
+    "// v. 2.0. If a copy of the MPL was not distributed with this file, You can\n"
+    "// obtain one at http://mozilla.org/MPL/2.0/.\n"
+    "\n"
+    "// ACTIVATION_FUNCTION, for kernels that fuse an activation into their output,\n"
+    "// and ACTIVATION_DERIV, its derivative, written in terms of that output, for\n"
+    "// kernels that fuse it into reading gradOutput;\n"
+    "// both left undefined if none of the activation defines is given\n"
+    "// one of: [ TANH | RELU | LINEAR | SIGMOID | SCALEDTANH | ELU ] (optional)\n"
+    "\n"
+    "#ifdef TANH\n"
+    "    #define ACTIVATION_FUNCTION(output) (tanh(output))\n"
+    "#elif defined SCALEDTANH\n"
+    "    #define ACTIVATION_FUNCTION(output) (1.7159f * tanh(0.66667f * output))\n"
+    "#elif defined SIGMOID\n"
+    "    #define ACTIVATION_FUNCTION(output) (1.0f / (1 + exp(-output)))\n"
+    "#elif defined RELU\n"
+    "    #define ACTIVATION_FUNCTION(output) (output> 0 ? output : 0)\n"
+    "#elif defined ELU\n"
+    "    #define ACTIVATION_FUNCTION(output) (output> 0 ? output : exp(output) - 1)\n"
+    "#elif defined LINEAR\n"
+    "    #define ACTIVATION_FUNCTION(output) (output)\n"
+    "#endif\n"
+    "\n"
+    "#ifdef TANH\n"
+    "    #define ACTIVATION_DERIV(output) (1 - output * output)\n"
+    "#elif defined SCALEDTANH\n"
+    "    #define ACTIVATION_DERIV(output) (0.66667f * (1.7159f - 1 / 1.7159f * output * output) )\n"
+    "#elif defined SIGMOID\n"
+    "    #define ACTIVATION_DERIV(output) (output * (1 - output) )\n"
+    "#elif defined RELU\n"
+    "    #define ACTIVATION_DERIV(output) (output > 0 ? 1 : 0)\n"
+    "#elif defined ELU\n"
+    "    #define ACTIVATION_DERIV(output) (output > 0 ? 1 : output + 1)\n"
+    "#elif defined LINEAR\n"
+    "    #define ACTIVATION_DERIV(output) (1.0f)\n"
+    "#endif\n"
+    "\n"
+    "\n"
+    "// G g G^T, for each [outPlane][channel]\n"
+    "// transformed is [16][gOutPlanes][gChannels]\n"
+    "kernel void winograd_filters(global const float *filters, global float *transformed) {\n"
+    "    const int globalId = get_global_id(0);\n"
+    "    if(globalId >= gOutPlanes * gChannels) {\n"
+    "        return;\n"
+    "    }\n"
+    "    const int channel = globalId % gChannels;\n"
+    "    const int outPlane = globalId / gChannels;\n"
+    "    const int inPlane = channel % gInPlanes;\n"
+    "    const int sub = channel / gInPlanes;\n"
+    "    const int subRow = sub / gNumSubFilters;\n"
+    "    const int subCol = sub % gNumSubFilters;\n"
+    "    float g[3][3];\n"
+    "    for(int i = 0; i < 3; i++) {\n"
+    "        for(int j = 0; j < 3; j++) {\n"
+    "            const int row = subRow * 3 + i;\n"
+    "            const int col = subCol * 3 + j;\n"
+    "            float value = 0;\n"
+    "            if(row < gFilterSize && col < gFilterSize) {\n"
+    "                #ifdef BACKWARD\n"
+    "                value = filters[((inPlane * gOutPlanes + outPlane) * gFilterSize + gFilterSize - 1 - row)\n"
+    "                    * gFilterSize + gFilterSize - 1 - col];\n"
+    "                #else\n"
+    "                value = filters[((outPlane * gInPlanes + inPlane) * gFilterSize + row) * gFilterSize + col];\n"
+    "                #endif\n"
+    "            }\n"
+    "            g[i][j] = value;\n"
+    "        }\n"
+    "    }\n"
+    "    float t[4][3];\n"
+    "    for(int j = 0; j < 3; j++) {\n"
+    "        t[0][j] = g[0][j];\n"
+    "        t[1][j] = 0.5f * (g[0][j] + g[1][j] + g[2][j]);\n"
+    "        t[2][j] = 0.5f * (g[0][j] - g[1][j] + g[2][j]);\n"
+    "        t[3][j] = g[2][j];\n"
+    "    }\n"
+    "    global float *out = transformed + outPlane * gChannels + channel;\n"
+    "    const int stride = gOutPlanes * gChannels;\n"
+    "    for(int i = 0; i < 4; i++) {\n"
+    "        out[(i * 4 + 0) * stride] = t[i][0];\n"
+    "        out[(i * 4 + 1) * stride] = 0.5f * (t[i][0] + t[i][1] + t[i][2]);\n"
+    "        out[(i * 4 + 2) * stride] = 0.5f * (t[i][0] - t[i][1] + t[i][2]);\n"
+    "        out[(i * 4 + 3) * stride] = t[i][2];\n"
+    "    }\n"
+    "}\n"
+    "\n"
+    "// B^T d B, for each [channel][tile] of numImages images, from input + inputOffset\n"
+    "// V is [16][gChannels][numImages * gTilesPerImage]\n"
+    "kernel void winograd_input(const int numImages, global const float *input, const int inputOffset,\n"
+    "        global float *V) {\n"
+    "    const int globalId = get_global_id(0);\n"
+    "    const int numTiles = numImages * gTilesPerImage;\n"
+    "    if(globalId >= gChannels * numTiles) {\n"
+    "        return;\n"
+    "    }\n"
+    "    const int tile = globalId % numTiles;\n"
+    "    const int channel = globalId / numTiles;\n"
+    "    const int n = tile / gTilesPerImage;\n"
+    "    const int tileRow = (tile % gTilesPerImage) / gTilesPerRow;\n"
+    "    const int tileCol = tile % gTilesPerRow;\n"
+    "    const int inPlane = channel % gInPlanes;\n"
+    "    const int sub = channel / gInPlanes;\n"
+    "    const int row0 = tileRow * 2 - gMargin + (sub / gNumSubFilters) * 3;\n"
+    "    const int col0 = tileCol * 2 - gMargin + (sub % gNumSubFilters) * 3;\n"
+    "    global const float *plane = input + inputOffset + (n * gInPlanes + inPlane) * gInSize * gInSize;\n"
+    "    float d[4][4];\n"
+    "    for(int i = 0; i < 4; i++) {\n"
+    "        const int row = row0 + i;\n"
+    "        for(int j = 0; j < 4; j++) {\n"
+    "            const int col = col0 + j;\n"
+    "            d[i][j] = (row >= 0 && row < gInSize && col >= 0 && col < gInSize) ? plane[row * gInSize + col] : 0;\n"
+    "        }\n"
+    "    }\n"
+    "    float b[4][4];\n"
+    "    for(int j = 0; j < 4; j++) {\n"
+    "        b[0][j] = d[0][j] - d[2][j];\n"
+    "        b[1][j] = d[1][j] + d[2][j];\n"
+    "        b[2][j] = d[2][j] - d[1][j];\n"
+    "        b[3][j] = d[1][j] - d[3][j];\n"
+    "    }\n"
+    "    global float *out = V + channel * numTiles + tile;\n"
+    "    const int stride = gChannels * numTiles;\n"
+    "    for(int i = 0; i < 4; i++) {\n"
+    "        out[(i * 4 + 0) * stride] = b[i][0] - b[i][2];\n"
+    "        out[(i * 4 + 1) * stride] = b[i][1] + b[i][2];\n"
+    "        out[(i * 4 + 2) * stride] = b[i][2] - b[i][1];\n"
+    "        out[(i * 4 + 3) * stride] = b[i][1] - b[i][3];\n"
+    "    }\n"
+    "}\n"
+    "\n"
+    "// A^T m A, for each [outPlane][tile], then bias and activation\n"
+    "// M is [16][gOutPlanes][numImages * gTilesPerImage]\n"
+    "kernel void winograd_output(const int numImages, global const float *M, global const float *bias,\n"
+    "        global float *output, const int outputOffset) {\n"
+    "    const int globalId = get_global_id(0);\n"
+    "    const int numTiles = numImages * gTilesPerImage;\n"
+    "    if(globalId >= gOutPlanes * numTiles) {\n"
+    "        return;\n"
+    "    }\n"
+    "    const int tile = globalId % numTiles;\n"
+    "    const int outPlane = globalId / numTiles;\n"
+    "    const int n = tile / gTilesPerImage;\n"
+    "    const int tileRow = (tile % gTilesPerImage) / gTilesPerRow;\n"
+    "    const int tileCol = tile % gTilesPerRow;\n"
+    "    float m[16];\n"
+    "    for(int k = 0; k < 16; k++) {\n"
+    "        m[k] = M[(k * gOutPlanes + outPlane) * numTiles + tile];\n"
+    "    }\n"
+    "    float a[2][4];\n"
+    "    for(int j = 0; j < 4; j++) {\n"
+    "        a[0][j] = m[j] + m[4 + j] + m[8 + j];\n"
+    "        a[1][j] = m[4 + j] - m[8 + j] - m[12 + j];\n"
+    "    }\n"
+    "    global float *plane = output + outputOffset + (n * gOutPlanes + outPlane) * gOutSize * gOutSize;\n"
+    "    for(int i = 0; i < 2; i++) {\n"
+    "        const int row = tileRow * 2 + i;\n"
+    "        for(int j = 0; j < 2; j++) {\n"
+    "            const int col = tileCol * 2 + j;\n"
+    "            if(row >= gOutSize || col >= gOutSize) {\n"
+    "                continue;\n"
+    "            }\n"
+    "            float value = j == 0 ? a[i][0] + a[i][1] + a[i][2] : a[i][1] - a[i][2] - a[i][3];\n"
+    "            #ifdef BIASED\n"
+    "            value += bias[outPlane];\n"
+    "            #endif\n"
+    "            #ifdef ACTIVATION_FUNCTION\n"
+    "            value = ACTIVATION_FUNCTION(value);\n"
+    "            #endif\n"
+    "            plane[row * gOutSize + col] = value;\n"
+    "        }\n"
+    "    }\n"
+    "}\n"
+    "\n"
+    "";
+    kernelInput = KernelCache::buildKernelFromString(cl, kernelInputSource, "winograd_input", options, "cl/winograd.cl");
+    // generated using cog, from cl/winograd.cl:
+    const char * kernelOutputSource =  
+    "// Copyright Hugh Perkins 2015 hughperkins at gmail\n"
+    "//\n"
+    "// This Source Code Form is subject to the terms of the Mozilla Public License,\n"
+    "// v. 2.0. If a copy of the MPL was not distributed with this file, You can\n"
+    "// obtain one at http://mozilla.org/MPL/2.0/.\n"
+    "\n"
+    "// Winograd F(2x2,3x3), see Winograd.h\n"
+    "// the 16 transformed filters times transformed inputs are 16 gemms, done with\n"
+    "// clblas between winograd_input and winograd_output\n"
+    "\n"
+    "// expected defines:\n"
+    "// gInPlanes, gInSize, gOutPlanes, gOutSize, gFilterSize, gMargin\n"
+    "// gNumSubFilters, gChannels, gTilesPerRow, gTilesPerImage\n"
+    "// BACKWARD (optional): filters are [gInPlanes][gOutPlanes], and flipped\n"
+    "// BIASED (optional)\n"
+    "// one of: [ TANH | RELU | LINEAR | SIGMOID | SCALEDTANH | ELU ] (optional, fuses the activation)\n"
+    "\n"
+    "// including cl/activate_defines.cl:\n"
+    "// Copyright Hugh Perkins 2015 hughperkins at gmail\n"
+    "//\n"
+    "// This Source Code Form is subject to the terms of the Mozilla Public License,\n"
+    "// v. 2.0. If a copy of the MPL was not distributed with this file, You can\n"
+    "// obtain one at http://mozilla.org/MPL/2.0/.\n"
+    "\n"
+    "// ACTIVATION_FUNCTION, for kernels that fuse an activation into their output,\n"
+    "// and ACTIVATION_DERIV, its derivative, written in terms of that output, for\n"
+    "// kernels that fuse it into reading gradOutput;\n"
+    "// both left undefined if none of the activation defines is given\n"
+    "// one of: [ TANH | RELU | LINEAR | SIGMOID | SCALEDTANH | ELU ] (optional)\n"
+    "\n"
+    "#ifdef TANH\n"
+    "    #define ACTIVATION_FUNCTION(output) (tanh(output))\n"
+    "#elif defined SCALEDTANH\n"
+    "    #define ACTIVATION_FUNCTION(output) (1.7159f * tanh(0.66667f * output))\n"
+    "#elif defined SIGMOID\n"
+    "    #define ACTIVATION_FUNCTION(output) (1.0f / (1 + exp(-output)))\n"
+    "#elif defined RELU\n"
+    "    #define ACTIVATION_FUNCTION(output) (output> 0 ? output : 0)\n"
+    "#elif defined ELU\n"
+    "    #define ACTIVATION_FUNCTION(output) (output> 0 ? output : exp(output) - 1)\n"
+    "#elif defined LINEAR\n"
+    "    #define ACTIVATION_FUNCTION(output) (output)\n"
+    "#endif\n"
+    "\n"
+    "#ifdef TANH\n"
+    "    #define ACTIVATION_DERIV(output) (1 - output * output)\n"
+    "#elif defined SCALEDTANH\n"
+    "    #define ACTIVATION_DERIV(output) (0.66667f * (1.7159f - 1 / 1.7159f * output * output) )\n"
+    "#elif defined SIGMOID\n"
+    "    #define ACTIVATION_DERIV(output) (output * (1 - output) )\n"
+    "#elif defined RELU\n"
+    "    #define ACTIVATION_DERIV(output) (output > 0 ? 1 : 0)\n"
+    "#elif defined ELU\n"
+    "    #define ACTIVATION_DERIV(output) (output > 0 ? 1 : output + 1)\n"
+    "#elif defined LINEAR\n"
+    "    #define ACTIVATION_DERIV(output) (1.0f)\n"
+    "#endif\n"
+    "\n"
+    "\n"
+    "// G g G^T, for each [outPlane][channel]\n"
+    "// transformed is [16][gOutPlanes][gChannels]\n"
+    "kernel void winograd_filters(global const float *filters, global float *transformed) {\n"
+    "    const int globalId = get_global_id(0);\n"
+    "    if(globalId >= gOutPlanes * gChannels) {\n"
+    "        return;\n"
+    "    }\n"
+    "    const int channel = globalId % gChannels;\n"
+    "    const int outPlane = globalId / gChannels;\n"
+    "    const int inPlane = channel % gInPlanes;\n"
+    "    const int sub = channel / gInPlanes;\n"
+    "    const int subRow = sub / gNumSubFilters;\n"
+    "    const int subCol = sub % gNumSubFilters;\n"
+    "    float g[3][3];\n"
+    "    for(int i = 0; i < 3; i++) {\n"
+    "        for(int j = 0; j < 3; j++) {\n"
+    "            const int row = subRow * 3 + i;\n"
+    "            const int col = subCol * 3 + j;\n"
+    "            float value = 0;\n"
+    "            if(row < gFilterSize && col < gFilterSize) {\n"
+    "                #ifdef BACKWARD\n"
+    "                value = filters[((inPlane * gOutPlanes + outPlane) * gFilterSize + gFilterSize - 1 - row)\n"
+    "                    * gFilterSize + gFilterSize - 1 - col];\n"
+    "                #else\n"
+    "                value = filters[((outPlane * gInPlanes + inPlane) * gFilterSize + row) * gFilterSize + col];\n"
+    "                #endif\n"
+    "            }\n"
+    "            g[i][j] = value;\n"
+    "        }\n"
+    "    }\n"
+    "    float t[4][3];\n"
+    "    for(int j = 0; j < 3; j++) {\n"
+    "        t[0][j] = g[0][j];\n"
+    "        t[1][j] = 0.5f * (g[0][j] + g[1][j] + g[2][j]);\n"
+    "        t[2][j] = 0.5f * (g[0][j] - g[1][j] + g[2][j]);\n"
+    "        t[3][j] = g[2][j];\n"
+    "    }\n"
+    "    global float *out = transformed + outPlane * gChannels + channel;\n"
+    "    const int stride = gOutPlanes * gChannels;\n"
+    "    for(int i = 0; i < 4; i++) {\n"
+    "        out[(i * 4 + 0) * stride] = t[i][0];\n"
+    "        out[(i * 4 + 1) * stride] = 0.5f * (t[i][0] + t[i][1] + t[i][2]);\n"
+    "        out[(i * 4 + 2) * stride] = 0.5f * (t[i][0] - t[i][1] + t[i][2]);\n"
+    "        out[(i * 4 + 3) * stride] = t[i][2];\n"
+    "    }\n"
+    "}\n"
+    "\n"
+    "// B^T d B, for each [channel][tile] of numImages images, from input + inputOffset\n"
+    "// V is [16][gChannels][numImages * gTilesPerImage]\n"
+    "kernel void winograd_input(const int numImages, global const float *input, const int inputOffset,\n"
+    "        global float *V) {\n"
+    "    const int globalId = get_global_id(0);\n"
+    "    const int numTiles = numImages * gTilesPerImage;\n"
+    "    if(globalId >= gChannels * numTiles) {\n"
+    "        return;\n"
+    "    }\n"
+    "    const int tile = globalId % numTiles;\n"
+    "    const int channel = globalId / numTiles;\n"
+    "    const int n = tile / gTilesPerImage;\n"
+    "    const int tileRow = (tile % gTilesPerImage) / gTilesPerRow;\n"
+    "    const int tileCol = tile % gTilesPerRow;\n"
+    "    const int inPlane = channel % gInPlanes;\n"
+    "    const int sub = channel / gInPlanes;\n"
+    "    const int row0 = tileRow * 2 - gMargin + (sub / gNumSubFilters) * 3;\n"
+    "    const int col0 = tileCol * 2 - gMargin + (sub % gNumSubFilters) * 3;\n"
+    "    global const float *plane = input + inputOffset + (n * gInPlanes + inPlane) * gInSize * gInSize;\n"
+    "    float d[4][4];\n"
+    "    for(int i = 0; i < 4; i++) {\n"
+    "        const int row = row0 + i;\n"
+    "        for(int j = 0; j < 4; j++) {\n"
+    "            const int col = col0 + j;\n"
+    "            d[i][j] = (row >= 0 && row < gInSize && col >= 0 && col < gInSize) ? plane[row * gInSize + col] : 0;\n"
+    "        }\n"
+    "    }\n"
+    "    float b[4][4];\n"
+    "    for(int j = 0; j < 4; j++) {\n"
+    "        b[0][j] = d[0][j] - d[2][j];\n"
+    "        b[1][j] = d[1][j] + d[2][j];\n"
+    "        b[2][j] = d[2][j] - d[1][j];\n"
+    "        b[3][j] = d[1][j] - d[3][j];\n"
+    "    }\n"
+    "    global float *out = V + channel * numTiles + tile;\n"
+    "    const int stride = gChannels * numTiles;\n"
+    "    for(int i = 0; i < 4; i++) {\n"
+    "        out[(i * 4 + 0) * stride] = b[i][0] - b[i][2];\n"
+    "        out[(i * 4 + 1) * stride] = b[i][1] + b[i][2];\n"
+    "        out[(i * 4 + 2) * stride] = b[i][2] - b[i][1];\n"
+    "        out[(i * 4 + 3) * stride] = b[i][1] - b[i][3];\n"
+    "    }\n"
+    "}\n"
+    "\n"
+    "// A^T m A, for each [outPlane][tile], then bias and activation\n"
+    "// M is [16][gOutPlanes][numImages * gTilesPerImage]\n"
+    "kernel void winograd_output(const int numImages, global const float *M, global const float *bias,\n"
+    "        global float *output, const int outputOffset) {\n"
+    "    const int globalId = get_global_id(0);\n"
+    "    const int numTiles = numImages * gTilesPerImage;\n"
+    "    if(globalId >= gOutPlanes * numTiles) {\n"
+    "        return;\n"
+    "    }\n"
+    "    const int tile = globalId % numTiles;\n"
+    "    const int outPlane = globalId / numTiles;\n"
+    "    const int n = tile / gTilesPerImage;\n"
+    "    const int tileRow = (tile % gTilesPerImage) / gTilesPerRow;\n"
+    "    const int tileCol = tile % gTilesPerRow;\n"
+    "    float m[16];\n"
+    "    for(int k = 0; k < 16; k++) {\n"
+    "        m[k] = M[(k * gOutPlanes + outPlane) * numTiles + tile];\n"
+    "    }\n"
+    "    float a[2][4];\n"
+    "    for(int j = 0; j < 4; j++) {\n"
+    "        a[0][j] = m[j] + m[4 + j] + m[8 + j];\n"
+    "        a[1][j] = m[4 + j] - m[8 + j] - m[12 + j];\n"
+    "    }\n"
+    "    global float *plane = output + outputOffset + (n * gOutPlanes + outPlane) * gOutSize * gOutSize;\n"
+    "    for(int i = 0; i < 2; i++) {\n"
+    "        const int row = tileRow * 2 + i;\n"
+    "        for(int j = 0; j < 2; j++) {\n"
+    "            const int col = tileCol * 2 + j;\n"
+    "            if(row >= gOutSize || col >= gOutSize) {\n"
+    "                continue;\n"
+    "            }\n"
+    "            float value = j == 0 ? a[i][0] + a[i][1] + a[i][2] : a[i][1] - a[i][2] - a[i][3];\n"
+    "            #ifdef BIASED\n"
+    "            value += bias[outPlane];\n"
+    "            #endif\n"
+    "            #ifdef ACTIVATION_FUNCTION\n"
+    "            value = ACTIVATION_FUNCTION(value);\n"
+    "            #endif\n"
+    "            plane[row * gOutSize + col] = value;\n"
+    "        }\n"
+    "    }\n"
+    "}\n"
+    "\n"
+    "";
+    kernelOutput = KernelCache::buildKernelFromString(cl, kernelOutputSource, "winograd_output", options, "cl/winograd.cl");
+    // [[[end]]]
+    cl->storeKernel(kernelName, kernelFilters, true);
+    cl->storeKernel("Winograd.winograd_input" + options, kernelInput, true);
+    cl->storeKernel("Winograd.winograd_output" + options, kernelOutput, true);
+}
+
@@ -0,0 +1,75 @@
+// Copyright Hugh Perkins 2015 hughperkins at gmail
+//
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file, You can
+// obtain one at http://mozilla.org/MPL/2.0/.
+
+#pragma once
+
+#include "LayerDimensions.h"
+
+class EasyCL;
+class CLWrapper;
+class CLKernel;
+
+#include "DeepCLDllExport.h"
+
+#define STATIC static
+#define VIRTUAL virtual
+
+// Winograd F(2x2,3x3) convolution, shared by ForwardWinograd[Cpu] and
+// BackwardWinograd[Cpu]
+// each 2x2 output tile costs 16 multiplies per input plane, instead of 36
+// larger odd filters are split into 3x3 sub filters, zero-padded at the
+// bottom and right, each reading the input shifted by 3 rows or columns.  The
+// shifted input planes just become extra 'channels' of the multiply, so 5x5
+// costs 64 multiplies per tile per input plane, instead of 100
+// backward (gradInput) is a forward convolution too: of gradOutput, with the
+// filters transposed and flipped, and a margin of filterSize - 1 - margin
+// needs skip == 0, and an odd filterSize
+class DeepCL_EXPORT Winograd {
+    public:
+    EasyCL *cl; // 0 for the cpu path
+    LayerDimensions dim;
+    bool backward;
+
+    // the convolution, as a forward one
+    int inPlanes;
+    int inSize;
+    int outPlanes;
+    int outSize;
+    int margin;
+    bool biased; // never for backward
+    int numSubFilters; // per side
+    int channels; // inPlanes * numSubFilters * numSubFilters
+    int tilesPerRow;
+    int tilesPerImage;
+
+    CLKernel *kernelFilters;
+    CLKernel *kernelInput;
+    CLKernel *kernelOutput;
+
+    // [[[cog
+    // import cog_addheaders
+    // cog_addheaders.addv2()
+    // ]]]
+    // generated, using cog:
+
+    public:
+    STATIC bool supports(LayerDimensions dim);
+    Winograd(EasyCL *cl, LayerDimensions dim, bool backward);
+    VIRTUAL ~Winograd();
+    int getTransformedFiltersSize();
+    void transformFilters(float const*filters, float *transformed);
+    void convolveCpu(int batchSize, float const*input, float const*filters, float const*bias, float *output);
+    int getChunkSize(int batchSize);
+    void convolve(int batchSize, CLWrapper *inputWrapper, CLWrapper *filtersWrapper, CLWrapper *biasWrapper, CLWrapper *outputWrapper);
+
+    private:
+    float filterAt(float const*filters, int outPlane, int inPlane, int row, int col);
+    void convolveCpuTileRow(float const*image, float const*transformed, float const*bias, int tileRow, float *V, float *M, float *imageOutput);
+    void buildKernels();
+
+    // [[[end]]]
+};
+
@@ -9,10 +9,10 @@
 
 #include "EasyCL.h"
 #include "util/stringhelper.h"
-#include "util/StatefulTimer.h"
 
 #include "DropoutBackwardCpu.h"
 #include "DropoutBackwardGpuNaive.h"
+#include "DropoutForward.h"
 
 #include "DropoutBackward.h"
 
@@ -57,7 +57,6 @@ VIRTUAL int DropoutBackward::getOutputNumElements(int batchSize) {
 }
 VIRTUAL void DropoutBackward::backward(int batchSize, uchar *mask, float *gradOutput, float *gradInput) {
 //    cout << "DropoutBackward::backward(float *)" << endl;
-    StatefulTimer::instance()->timeCheck("DropoutBackward::backward float->wrapper start");
     CLWrapper *maskWrapper = cl->wrap(getOutputNumElements(batchSize), mask);
     CLWrapper *gradOutputWrapper = cl->wrap(getOutputNumElements(batchSize), gradOutput);
     CLWrapper *gradInputWrapper = cl->wrap(getInputNumElements(batchSize), gradInput);
@@ -73,9 +72,20 @@ VIRTUAL void DropoutBackward::backward(int batchSize, uchar *mask, float *gradOu
     delete maskWrapper;
     delete gradOutputWrapper;
     delete gradInputWrapper;
-    StatefulTimer::instance()->timeCheck("DropoutBackward::backward float->wrapper end");
 }
 VIRTUAL void DropoutBackward::backward(int batchSize, CLWrapper *maskWrapper, CLWrapper *gradOutputWrapper, CLWrapper *gradInputWrapper) {
     throw runtime_error("DropoutBackward::backward wrappers not implemented");
 }
+// regenerates the masks that DropoutForward made for the same seeds; the gpu implementation
+// overrides this, to do it inside the kernel
+VIRTUAL void DropoutBackward::backward(int batchSize, unsigned int seed0, unsigned int seed1, CLWrapper *gradOutputWrapper, CLWrapper *gradInputWrapper) {
+    int N = getOutputNumElements(batchSize);
+    unsigned char *masks = new unsigned char[N];
+    DropoutForward::generateMasks(N, dropRatio, seed0, seed1, masks);
+    CLWrapper *masksWrapper = cl->wrap(N, masks);
+    masksWrapper->copyToDevice();
+    backward(batchSize, masksWrapper, gradOutputWrapper, gradInputWrapper);
+    delete masksWrapper;
+    delete[] masks;
+}
 
@@ -51,6 +51,7 @@ public:
     VIRTUAL int getOutputNumElements(int batchSize);
     VIRTUAL void backward(int batchSize, uchar *mask, float *gradOutput, float *gradInput);
     VIRTUAL void backward(int batchSize, CLWrapper *maskWrapper, CLWrapper *gradOutputWrapper, CLWrapper *gradInputWrapper);
+    VIRTUAL void backward(int batchSize, unsigned int seed0, unsigned int seed1, CLWrapper *gradOutputWrapper, CLWrapper *gradInputWrapper);
 
     // [[[end]]]
 };
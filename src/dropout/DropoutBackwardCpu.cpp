@@ -10,7 +10,6 @@
 
 #include "EasyCL.h"
 #include "DropoutBackward.h"
-#include "util/StatefulTimer.h"
 
 #include "DropoutBackwardCpu.h"
 
@@ -32,7 +31,6 @@ VIRTUAL void DropoutBackwardCpu::backward(int batchSize, uchar *mask,  float *gr
 }
 VIRTUAL void DropoutBackwardCpu::backward(int batchSize, CLWrapper *maskWrapper, CLWrapper *gradOutputWrapper, 
         CLWrapper *gradInputWrapper) {
-    StatefulTimer::instance()->timeCheck("DropoutBackwardCpu::backward start");
 
     maskWrapper->copyToHost();
     gradOutputWrapper->copyToHost();
@@ -49,6 +47,5 @@ VIRTUAL void DropoutBackwardCpu::backward(int batchSize, CLWrapper *maskWrapper,
 
     delete[] gradInput;
     
-    StatefulTimer::instance()->timeCheck("DropoutBackwardCpu::backward end");
 }
 
@@ -10,10 +10,10 @@
 
 #include "EasyCL.h"
 #include "DropoutBackward.h"
-#include "util/StatefulTimer.h"
 #include "util/stringhelper.h"
 
 #include "DropoutBackwardGpuNaive.h"
+#include "util/KernelCache.h"
 
 using namespace std;
 
@@ -24,6 +24,7 @@ using namespace std;
 
 VIRTUAL DropoutBackwardGpuNaive::~DropoutBackwardGpuNaive() {
     delete kernel;
+    delete philoxKernel;
 //    delete kMemset;
 }
 VIRTUAL void DropoutBackwardGpuNaive::backward( 
@@ -33,7 +34,6 @@ VIRTUAL void DropoutBackwardGpuNaive::backward(
             CLWrapper *gradInputWrapper) 
         {
 
-    StatefulTimer::instance()->timeCheck("DropoutBackwardGpuNaive::backward start");
 
     // first, memset errors to 0 ...
 //    kMemset ->out(gradInputWrapper)
@@ -55,7 +55,21 @@ VIRTUAL void DropoutBackwardGpuNaive::backward(
     kernel->run_1d(numWorkgroups * workgroupSize, workgroupSize);
     cl->finish();
 
-    StatefulTimer::instance()->timeCheck("DropoutBackwardGpuNaive::backward end");
+}
+// regenerates the forward masks in the kernel, from the same seeds
+VIRTUAL void DropoutBackwardGpuNaive::backward(int batchSize, unsigned int seed0, unsigned int seed1, CLWrapper *gradOutputWrapper, CLWrapper *gradInputWrapper) {
+
+    int N = batchSize * numPlanes * outputSize * outputSize;
+    philoxKernel->in(N)
+            ->in((int)seed0) // same bits, kernel reads it as unsigned
+            ->in((int)seed1)
+            ->in(gradOutputWrapper)
+            ->out(gradInputWrapper);
+    int workgroupSize = 64;
+    int numWorkgroups = (N + workgroupSize - 1) / workgroupSize;
+    philoxKernel->run_1d(numWorkgroups * workgroupSize, workgroupSize);
+    cl->finish();
+
 }
 DropoutBackwardGpuNaive::DropoutBackwardGpuNaive(EasyCL *cl, int numPlanes, int inputSize, float dropRatio) :
         DropoutBackward(cl, numPlanes, inputSize, dropRatio) {
@@ -67,14 +81,8 @@ DropoutBackwardGpuNaive::DropoutBackwardGpuNaive(EasyCL *cl, int numPlanes, int
     options += " -D gOutputSize=" + toString(outputSize);
     options += " -D gOutputSizeSquared=" + toString(outputSize * outputSize);
 //    float inverseDropRatio = 1.0f / dropRatio;
-    string dropRatioString = toString(dropRatio);
-    if(dropRatioString.find(".") == string::npos) {
-        dropRatioString += ".0f";
-    } else {
-        dropRatioString += "f";
-    }
 //    cout << "inverseDropRatioString " << inverseDropRatioString << endl;
-    options += " -D gDropRatio=" + dropRatioString;
+    options += " -D gDropRatio=" + toFloatLiteral(dropRatio);
 
     // [[[cog
     // import stringify
@@ -113,8 +121,78 @@ DropoutBackwardGpuNaive::DropoutBackwardGpuNaive(EasyCL *cl, int numPlanes, int
     "    output[globalId] = mask[globalId] == 1 ? gradOutput[globalId] : 0.0f;\n"
     "}\n"
     "\n"
+    "// each element gets counter (globalId, 0, 0, 0), and the key is the per-batch seed,\n"
+    "// so forward and backward regenerate the same mask, without storing it\n"
+    "// including cl/philox.cl:\n"
+    "// Copyright Hugh Perkins 2015 hughperkins at gmail\n"
+    "//\n"
+    "// This Source Code Form is subject to the terms of the Mozilla Public License,\n"
+    "// v. 2.0. If a copy of the MPL was not distributed with this file, You can\n"
+    "// obtain one at http://mozilla.org/MPL/2.0/.\n"
+    "\n"
+    "// philox4x32-10 counter-based generator, see Salmon et al, 'Parallel random numbers: as\n"
+    "// easy as 1, 2, 3'.  Counter is (index, 0, 0, 0), and the key is the caller's seed, so\n"
+    "// any thread can recompute any index's number, with no state.\n"
+    "// must match util/Philox.cpp\n"
+    "float philoxUniform(const unsigned int index, unsigned int key0, unsigned int key1) {\n"
+    "    unsigned int c0 = index;\n"
+    "    unsigned int c1 = 0;\n"
+    "    unsigned int c2 = 0;\n"
+    "    unsigned int c3 = 0;\n"
+    "    for(int round = 0; round < 10; round++) {\n"
+    "        const unsigned int hi0 = mul_hi(0xD2511F53u, c0);\n"
+    "        const unsigned int lo0 = 0xD2511F53u * c0;\n"
+    "        const unsigned int hi1 = mul_hi(0xCD9E8D57u, c2);\n"
+    "        const unsigned int lo1 = 0xCD9E8D57u * c2;\n"
+    "        c0 = hi1 ^ c1 ^ key0;\n"
+    "        c1 = lo1;\n"
+    "        c2 = hi0 ^ c3 ^ key1;\n"
+    "        c3 = lo0;\n"
+    "        key0 += 0x9E3779B9u;\n"
+    "        key1 += 0xBB67AE85u;\n"
+    "    }\n"
+    "    return (c0 >> 8) * (1.0f / 16777216.0f);\n"
+    "}\n"
+    "\n"
+    "// uniform int in [minValue, maxValue], inclusive\n"
+    "int philoxUniformInt(const unsigned int index, const int minValue, const int maxValue, unsigned int key0, unsigned int key1) {\n"
+    "    const int range = maxValue - minValue + 1;\n"
+    "    const int offset = (int)(philoxUniform(index, key0, key1) * range);\n"
+    "    return minValue + min(offset, range - 1);\n"
+    "}\n"
+    "\n"
+    "\n"
+    "// same as forwardNaive, but makes the mask as it goes: keeps an element if its uniform\n"
+    "// is above gDropRatio\n"
+    "kernel void forwardPhilox(\n"
+    "        const int N,\n"
+    "        const unsigned int seed0,\n"
+    "        const unsigned int seed1,\n"
+    "        global const float *input,\n"
+    "        global float *output) {\n"
+    "    const int globalId = get_global_id(0);\n"
+    "    if (globalId >= N) {\n"
+    "        return;\n"
+    "    }\n"
+    "    output[globalId] = philoxUniform(globalId, seed0, seed1) > gDropRatio ? input[globalId] : 0.0f;\n"
+    "}\n"
+    "\n"
+    "kernel void backpropPhilox(\n"
+    "        const int N,\n"
+    "        const unsigned int seed0,\n"
+    "        const unsigned int seed1,\n"
+    "        global const float *gradOutput,\n"
+    "        global float *output) {\n"
+    "    const int globalId = get_global_id(0);\n"
+    "    if (globalId >= N) {\n"
+    "        return;\n"
+    "    }\n"
+    "    output[globalId] = philoxUniform(globalId, seed0, seed1) > gDropRatio ? gradOutput[globalId] : 0.0f;\n"
+    "}\n"
+    "\n"
     "";
-    kernel = cl->buildKernelFromString(kernelSource, "backpropNaive", options, "cl/dropout.cl");
+    kernel = KernelCache::buildKernelFromString(cl, kernelSource, "backpropNaive", options, "cl/dropout.cl");
     // [[[end]]]
+    philoxKernel = KernelCache::buildKernelFromString(cl, kernelSource, "backpropPhilox", options, "cl/dropout.cl");
 }
 
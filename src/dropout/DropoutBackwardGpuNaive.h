@@ -14,6 +14,7 @@
 class DropoutBackwardGpuNaive : public DropoutBackward {
 public:
     CLKernel *kernel;
+    CLKernel *philoxKernel;
 //    CLKernel *kMemset;
 
     // [[[cog
@@ -27,6 +28,7 @@ public:
     CLWrapper *maskWrapper,
     CLWrapper *gradOutputWrapper,
     CLWrapper *gradInputWrapper);
+    VIRTUAL void backward(int batchSize, unsigned int seed0, unsigned int seed1, CLWrapper *gradOutputWrapper, CLWrapper *gradInputWrapper);
     DropoutBackwardGpuNaive(EasyCL *cl, int numPlanes, int inputSize, float dropRatio);
 
     // [[[end]]]
@@ -8,6 +8,7 @@
 
 #include "EasyCL.h"
 #include "util/stringhelper.h"
+#include "util/Philox.h"
 #include "DropoutForwardCpu.h"
 #include "DropoutForwardGpuNaive.h"
 
@@ -66,6 +67,25 @@ VIRTUAL void DropoutForward::forward(int batchSize, unsigned char *masks, float
     delete inputWrapper;
     delete masksWrapper;
 }
+// fills masks the same way the philox kernels in cl/dropout.cl do: element i is kept (1)
+// if its uniform, for key (seed0, seed1), is above dropRatio
+STATIC void DropoutForward::generateMasks(int N, float dropRatio, unsigned int seed0, unsigned int seed1, unsigned char *masks) {
+    for(int i = 0; i < N; i++) {
+        masks[i] = Philox::uniform(i, seed0, seed1) <= dropRatio ? 0 : 1;
+    }
+}
+// default implementation makes the masks on the host, and uses the masks version; the gpu
+// implementation overrides this, to make the masks inside the kernel instead
+VIRTUAL void DropoutForward::forward(int batchSize, unsigned int seed0, unsigned int seed1, CLWrapper *inputWrapper, CLWrapper *outputWrapper) {
+    int N = getInputNumElements(batchSize);
+    unsigned char *masks = new unsigned char[N];
+    generateMasks(N, dropRatio, seed0, seed1, masks);
+    CLWrapper *masksWrapper = cl->wrap(N, masks);
+    masksWrapper->copyToDevice();
+    forward(batchSize, masksWrapper, inputWrapper, outputWrapper);
+    delete masksWrapper;
+    delete[] masks;
+}
 VIRTUAL int DropoutForward::getInputNumElements(int batchSize) {
     return batchSize * numPlanes * inputSize * inputSize;
 }
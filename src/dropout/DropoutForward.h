@@ -49,6 +49,8 @@ public:
     STATIC DropoutForward *instanceSpecific(int idx, EasyCL *cl, int numPlanes, int inputSize, float dropRatio);
     VIRTUAL void forward(int batchSize, CLWrapper *masksWrapper, CLWrapper *inputData, CLWrapper *outputData);
     VIRTUAL void forward(int batchSize, unsigned char *masks, float *input, float *output);
+    STATIC void generateMasks(int N, float dropRatio, unsigned int seed0, unsigned int seed1, unsigned char *masks);
+    VIRTUAL void forward(int batchSize, unsigned int seed0, unsigned int seed1, CLWrapper *inputWrapper, CLWrapper *outputWrapper);
     VIRTUAL int getInputNumElements(int batchSize);
     VIRTUAL int getOutputNumElements(int batchSize);
 
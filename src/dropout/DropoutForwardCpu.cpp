@@ -9,7 +9,6 @@
 
 #include "EasyCL.h"
 
-#include "util/StatefulTimer.h"
 
 #include "DropoutForwardCpu.h"
 
@@ -44,13 +43,11 @@ VIRTUAL void DropoutForwardCpu::forward(int batchSize, CLWrapper *masksWrapper,
 VIRTUAL void DropoutForwardCpu::forward(int batchSize, unsigned char *masks, float *input, float *output) {
 //    float *output = new float[ getOutputNumElements(batchSize) ];
 //    cout << "DropoutForwardCpu::forward(float *)" << endl;
-    StatefulTimer::instance()->timeCheck("DropoutForwardCpu::forward start");
     int totalLinearSize = batchSize * numPlanes * inputSize * inputSize;
 //    float inverseDropRatio = 1.0f / dropRatio; // since multiply faster than divide, just divide once
     for(int i = 0; i < totalLinearSize; i++) {
         output[i] = masks[i] == 1 ? input[i] : 0;
     }
-    StatefulTimer::instance()->timeCheck("DropoutForwardCpu::forward end");
 //    return output;
 }
 
@@ -16,6 +16,7 @@ class CLKernel;
 class DropoutForwardGpuNaive : public DropoutForward {
 public:
     CLKernel *kernel;
+    CLKernel *philoxKernel;
 
     // [[[cog
     // import cog_addheaders
@@ -24,6 +25,7 @@ public:
     // generated, using cog:
     VIRTUAL ~DropoutForwardGpuNaive();
     VIRTUAL void forward(int batchSize, CLWrapper *masksWrapper, CLWrapper *inputWrapper, CLWrapper *outputWrapper);
+    VIRTUAL void forward(int batchSize, unsigned int seed0, unsigned int seed1, CLWrapper *inputWrapper, CLWrapper *outputWrapper);
     DropoutForwardGpuNaive(EasyCL *cl, int numPlanes, int inputSize, float dropRatio);
 
     // [[[end]]]
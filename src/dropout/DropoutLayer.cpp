@@ -32,10 +32,10 @@ DropoutLayer::DropoutLayer(EasyCL *cl, Layer *previousLayer, DropoutMaker *maker
         outputSize(previousLayer->getOutputSize()),
         random(RandomSingleton::instance()),
         cl(cl),
-        masks(0),
+        seed0(0),
+        seed1(0),
         output(0),
         gradInput(0),
-        maskWrapper(0),
         outputWrapper(0),
         gradInputWrapper(0),
 //        outputCopiedToHost(false),
@@ -58,16 +58,8 @@ VIRTUAL DropoutLayer::~DropoutLayer() {
     delete multiplyBuffer;
     delete dropoutForwardImpl;
     delete dropoutBackwardImpl;
-    if(maskWrapper != 0) {
-        delete maskWrapper;
-    }
-    if(outputWrapper != 0) {
+    if(!sharedOutput) {
         delete outputWrapper;
-    }
-    if(masks != 0) {
-        delete[] masks;
-    }
-    if(output != 0) {
         delete[] output;
     }
     if(gradInputWrapper != 0) {
@@ -89,33 +81,30 @@ VIRTUAL void DropoutLayer::setBatchSize(int batchSize) {
         this->batchSize = batchSize;
         return;
     }
-    if(maskWrapper != 0) {
-        delete maskWrapper;
-    }
-    if(outputWrapper != 0) {
+    if(!sharedOutput) {
         delete outputWrapper;
-    }
-    if(masks != 0) {
-        delete[] masks;
-    }
-    if(output != 0) {
         delete[] output;
     }
-    if(gradInputWrapper != 0) {
-        delete gradInputWrapper;
-    }
-    if(gradInput != 0) {
-        delete[] gradInput;
-    }
+    delete gradInputWrapper;
+    delete[] gradInput;
+    gradInputWrapper = 0;
+    gradInput = 0;
     this->batchSize = batchSize;
     this->allocatedSize = batchSize;
-    masks = new unsigned char[ getOutputNumElements() ];
-    maskWrapper = cl->wrap(getOutputNumElements(), masks);
-    output = new float[ getOutputNumElements() ];
-    outputWrapper = cl->wrap(getOutputNumElements(), output);
-    gradInput = new float[ previousLayer->getOutputNumElements() ];
-    gradInputWrapper = cl->wrap(previousLayer->getOutputNumElements(), gradInput);
-    gradInputWrapper->createOnDevice();
+    // a shared output belongs to the net, and means inference only, so no gradients either
+    if(!sharedOutput) {
+        output = new float[ getOutputNumElements() ];
+        outputWrapper = cl->wrap(getOutputNumElements(), output);
+        gradInput = new float[ previousLayer->getOutputNumElements() ];
+        gradInputWrapper = cl->wrap(previousLayer->getOutputNumElements(), gradInput);
+        gradInputWrapper->createOnDevice();
+    }
+}
+VIRTUAL bool DropoutLayer::canShareOutput() const {
+    return true;
+}
+VIRTUAL void DropoutLayer::setSharedOutput(float *output, CLWrapper *outputWrapper) {
+    adoptSharedOutput(output, outputWrapper, &this->output, &this->outputWrapper, &gradInput, &gradInputWrapper, &allocatedSize);
 }
 VIRTUAL int DropoutLayer::getOutputNumElements() {
     return batchSize * numPlanes * outputSize * outputSize;
@@ -163,36 +152,6 @@ VIRTUAL float *DropoutLayer::getGradInput() {
 VIRTUAL ActivationFunction const *DropoutLayer::getActivationFunction() {
     return new LinearActivation();
 }
-//VIRTUAL void DropoutLayer::generateMasks() {
-//    int totalInputLinearSize = getOutputNumElements();
-////    int numBytes = (totalInputLinearSize+8-1)/8;
-////    unsigned char *bitsField = new unsigned char[numBytes];
-//    int idx = 0;
-//    unsigned char thisByte = 0;
-//    int bitsPacked = 0;
-//    for(int i = 0; i < totalInputLinearSize; i++) {
-//        //double value = ((int)random() % 10000) / 20000.0f + 0.5f;
-//        // 1 means we pass value through, 0 means we drop
-//        // dropRatio is probability that mask value is 0 therefore
-//        // so higher dropRatio => more likely to be 0
-//        unsigned char bit = random->_uniform() <= dropRatio ? 0 : 1;
-////        unsigned char bit = 0;
-//        thisByte <<= 1;
-//        thisByte |= bit;
-//        bitsPacked++;
-//        if(bitsPacked >= 8) {
-//            masks[idx] = thisByte;
-//            idx++;
-//            bitsPacked = 0;
-//        }
-//    }
-//}
-VIRTUAL void DropoutLayer::generateMasks() {
-    int totalInputLinearSize = getOutputNumElements();
-    for(int i = 0; i < totalInputLinearSize; i++) {
-        masks[i] = random->_uniform() <= dropRatio ? 0 : 1;
-    }
-}
 VIRTUAL void DropoutLayer::forward() {
     CLWrapper *upstreamOutputWrapper = 0;
     if(previousLayer->hasOutputWrapper()) {
@@ -205,10 +164,10 @@ VIRTUAL void DropoutLayer::forward() {
 
 //    cout << "training: " << training << endl;
     if(training) {
-        // create new masks...
-        generateMasks();
-        maskWrapper->copyToDevice();
-        dropoutForwardImpl->forward(batchSize, maskWrapper, upstreamOutputWrapper, outputWrapper);
+        // new masks each batch; they are made on the device, from the seeds
+        seed0 = random->_uint32();
+        seed1 = random->_uint32();
+        dropoutForwardImpl->forward(batchSize, seed0, seed1, upstreamOutputWrapper, outputWrapper);
     } else {
         // if not training, then simply skip the dropout bit, copy the buffers directly
         multiplyBuffer->multiply(getOutputNumElements(), dropRatio, upstreamOutputWrapper, outputWrapper);
@@ -229,7 +188,7 @@ VIRTUAL void DropoutLayer::backward() {
         gradOutputWrapper->copyToDevice();
         weOwnErrorsWrapper = true;
     }
-    dropoutBackwardImpl->backward(batchSize, maskWrapper, gradOutputWrapper, gradInputWrapper);
+    dropoutBackwardImpl->backward(batchSize, seed0, seed1, gradOutputWrapper, gradInputWrapper);
     if(weOwnErrorsWrapper) {
         delete gradOutputWrapper;
     }
@@ -34,11 +34,13 @@ public:
     DropoutBackward *dropoutBackwardImpl;
     MultiplyBuffer *multiplyBuffer; // for skipping dropout...
 
-    unsigned char *masks;
+    // key for the philox masks of the current batch: forward draws new ones, each
+    // training batch, and backward regenerates the same masks from them
+    unsigned int seed0;
+    unsigned int seed1;
     float *output;
     float *gradInput;
 
-    CLWrapper *maskWrapper;
     CLWrapper *outputWrapper;
     CLWrapper *gradInputWrapper;
 
@@ -58,6 +60,8 @@ public:
     VIRTUAL std::string getClassName() const;
     VIRTUAL void fortesting_setRandomSingleton(RandomSingleton *random);
     VIRTUAL void setBatchSize(int batchSize);
+    VIRTUAL bool canShareOutput() const;
+    VIRTUAL void setSharedOutput(float *output, CLWrapper *outputWrapper);
     VIRTUAL int getOutputNumElements();
     VIRTUAL float *getOutput();
     VIRTUAL bool needsBackProp();
@@ -71,7 +75,6 @@ public:
     VIRTUAL CLWrapper *getOutputWrapper();
     VIRTUAL float *getGradInput();
     VIRTUAL ActivationFunction const *getActivationFunction();
-    VIRTUAL void generateMasks();
     VIRTUAL void forward();
     VIRTUAL void backward();
     VIRTUAL std::string asString() const;
@@ -42,6 +42,19 @@ VIRTUAL void FullyConnectedLayer::setBatchSize(int batchSize) {
     convolutionalLayer->setBatchSize(batchSize);
     this->batchSize = batchSize;
 }
+VIRTUAL bool FullyConnectedLayer::canShareOutput() const {
+    return true;
+}
+VIRTUAL void FullyConnectedLayer::setSharedOutput(float *output, CLWrapper *outputWrapper) {
+    convolutionalLayer->setSharedOutput(output, outputWrapper);
+    sharedOutput = convolutionalLayer->sharedOutput;
+}
+VIRTUAL bool FullyConnectedLayer::canFuseActivation() const {
+    return convolutionalLayer->canFuseActivation();
+}
+VIRTUAL void FullyConnectedLayer::fuseActivation(ActivationFunction const *activation) {
+    convolutionalLayer->fuseActivation(activation);
+}
 VIRTUAL int FullyConnectedLayer::getOutputCubeSize() const {
     return numPlanes * imageSize * imageSize;
 }
@@ -32,6 +32,10 @@ public:
     VIRTUAL ~FullyConnectedLayer();
     VIRTUAL std::string getClassName() const;
     VIRTUAL void setBatchSize(int batchSize);
+    VIRTUAL bool canShareOutput() const;
+    VIRTUAL void setSharedOutput(float *output, CLWrapper *outputWrapper);
+    VIRTUAL bool canFuseActivation() const;
+    VIRTUAL void fuseActivation(ActivationFunction const *activation);
     VIRTUAL int getOutputCubeSize() const;
     VIRTUAL int getOutputSize() const;
     VIRTUAL int getOutputPlanes() const;
@@ -4,7 +4,12 @@
 // v. 2.0. If a copy of the MPL was not distributed with this file, You can 
 // obtain one at http://mozilla.org/MPL/2.0/.
 
+#include <cstring>
+#include <stdexcept>
+
+#include "EasyCL.h"
 #include "input/InputLayerMaker.h"
+#include "layer/LayerMaker.h"
 
 #include "input/InputLayer.h"
 
@@ -20,14 +25,35 @@ InputLayer::InputLayer(InputLayerMaker *maker) :
     outputPlanes(maker->_numPlanes),
     outputSize(maker->_imageSize),
     input(0),
-    output(0) {
+    output(0),
+    cl(maker->cl),
+    byteInput(0),
+    byteBuffer(0),
+    byteInputWrapper(0),
+    outputStale(false) {
 }
 VIRTUAL InputLayer::~InputLayer() {
+    if(byteInputWrapper != 0) {
+        delete byteInputWrapper;
+    }
+    if(byteBuffer != 0) {
+        delete[] byteBuffer;
+    }
+    if(output != 0) {
+        delete[] output;
+    }
 }
 VIRTUAL std::string InputLayer::getClassName() const {
     return "InputLayer";
 }
 VIRTUAL float *InputLayer::getOutput() {
+    if(outputStale) {
+        int totalLinearLength = getOutputNumElements();
+        for(int i = 0; i < totalLinearLength; i++) {
+            output[i] = byteInput[i];
+        }
+        outputStale = false;
+    }
     return output;
 }
 VIRTUAL bool InputLayer::needsBackProp() {
@@ -69,10 +95,27 @@ VIRTUAL void InputLayer::print() {
  void InputLayer::in(float const*images) {
 //        std::cout << "InputLayer::in()" << std::endl;
     this->input = images;
+    this->byteInput = 0;
 //        this->batchStart = batchStart;
 //        this->batchEnd = batchEnd;
 //        print();
 }
+/// \brief uint8 input: uploaded to the device as bytes, on forward, 4 times less than
+/// floats.  The next layer should be a NormalizationLayer, which reads the bytes directly
+void InputLayer::in(unsigned char const*images) {
+    if(cl == 0) {
+        throw runtime_error("InputLayer: uint8 input needs an EasyCL, please create the net with one");
+    }
+    this->byteInput = images;
+    this->input = 0;
+}
+VIRTUAL bool InputLayer::hasByteInput() const {
+    return byteInput != 0;
+}
+/// \brief the device copy of the current uint8 batch, valid after forward()
+VIRTUAL CLWrapper *InputLayer::getByteInputWrapper() {
+    return byteInputWrapper;
+}
 VIRTUAL bool InputLayer::needErrorsBackprop() {
     return false;
 }
@@ -85,12 +128,31 @@ VIRTUAL void InputLayer::setBatchSize(int batchSize) {
     if(output != 0) {
         delete[] output;
     }
+    if(byteInputWrapper != 0) {
+        delete byteInputWrapper;
+        byteInputWrapper = 0;
+    }
+    if(byteBuffer != 0) {
+        delete[] byteBuffer;
+        byteBuffer = 0;
+    }
     this->batchSize = batchSize;
     this->allocatedSize = batchSize;
     output = new float[batchSize * getOutputCubeSize() ];
 }
 VIRTUAL void InputLayer::forward() {
     int totalLinearLength = getOutputNumElements();
+    if(byteInput != 0) {
+        if(byteInputWrapper == 0) {
+            byteBuffer = new unsigned char[allocatedSize * getOutputCubeSize()];
+            byteInputWrapper = cl->wrap(allocatedSize * getOutputCubeSize(), byteBuffer);
+        }
+        memcpy(byteBuffer, byteInput, totalLinearLength);
+        byteInputWrapper->copyToDevice();
+        outputStale = true;
+        return;
+    }
+    outputStale = false;
     for(int i = 0; i < totalLinearLength; i++) {
         output[i] = input[i];
     }
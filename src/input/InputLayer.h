@@ -13,6 +13,8 @@
 #include "DeepCLDllExport.h"
 
 class InputLayerMaker;
+class EasyCL;
+class CLWrapper;
 
 #define VIRTUAL virtual
 
@@ -27,6 +29,15 @@ public:
     float const*input; // we dont own this
     float *output; // we own this :-)
 
+    // uint8 input, see in(unsigned char const*): the batch is uploaded as bytes, and
+    // NormalizationLayer converts it to float on the device.  output is only filled in
+    // on the host if someone calls getOutput()
+    EasyCL *cl; // NOT owned by us
+    unsigned char const*byteInput; // we dont own this
+    unsigned char *byteBuffer; // we own this
+    CLWrapper *byteInputWrapper;
+    bool outputStale;
+
     inline int getOutputIndex(int n, int outPlane, int outRow, int outCol) const {
         return (( n
             * outputPlanes + outPlane)
@@ -51,6 +62,9 @@ public:
     VIRTUAL void printOutput();
     VIRTUAL void print();
     void in(float const*images);
+    void in(unsigned char const*images);
+    VIRTUAL bool hasByteInput() const;
+    VIRTUAL CLWrapper *getByteInputWrapper();
     VIRTUAL bool needErrorsBackprop();
     VIRTUAL void setBatchSize(int batchSize);
     VIRTUAL void forward();
@@ -12,6 +12,7 @@ PUBLICAPI Layer::Layer(Layer *previousLayer, LayerMaker2 *maker) :
     nextLayer(0),
     layerIndex(previousLayer == 0 ? 0 : previousLayer->layerIndex + 1),
     training(false),
+    sharedOutput(false),
     maker(maker)
      {
     if(previousLayer != 0) {
@@ -33,6 +34,51 @@ PUBLICAPI VIRTUAL void Layer::setTraining(bool training) {
 PUBLICAPI VIRTUAL void Layer::setBatchSize(int batchSize) {
     throw std::runtime_error("setBatchsize not implemetned for this layer type");
 }
+/// \brief can NeuralNet::planInference put our output in a buffer shared with other layers?
+VIRTUAL bool Layer::canShareOutput() const {
+    return false;
+}
+/// \brief write output into these buffers, which belong to the net, and drop our gradient buffers
+///
+/// pass 0, 0 to own our buffers again, from the next setBatchSize
+VIRTUAL void Layer::setSharedOutput(float *output, CLWrapper *outputWrapper) {
+    throw std::runtime_error("setSharedOutput not implemented for " + getClassName());
+}
+/// \brief setSharedOutput, for layers that own an output and a gradInput buffer
+///
+/// A shared output belongs to the net, and means inference only, so no
+/// gradients either: our own output and gradInput buffers are freed, and
+/// *p_allocatedSize set to 0 when output is 0 again, so setBatchSize allocates
+/// our own buffers afresh
+PROTECTED void Layer::adoptSharedOutput(float *output, CLWrapper *outputWrapper, float **p_output, CLWrapper **p_outputWrapper, float **p_gradInput, CLWrapper **p_gradInputWrapper, int *p_allocatedSize) {
+    if(!sharedOutput) {
+        delete *p_outputWrapper;
+        delete[] *p_output;
+        delete *p_gradInputWrapper;
+        delete[] *p_gradInput;
+        *p_gradInputWrapper = 0;
+        *p_gradInput = 0;
+    }
+    sharedOutput = output != 0;
+    *p_output = output;
+    *p_outputWrapper = outputWrapper;
+    if(!sharedOutput) {
+        *p_allocatedSize = 0;
+    }
+}
+/// \brief is our output the previous layer's output, as is?  Then that output
+/// has to live as long as ours
+VIRTUAL bool Layer::passesThroughOutput() const {
+    return false;
+}
+/// \brief can we apply an activation at the end of our forward?  See NeuralNet::fuseActivations
+VIRTUAL bool Layer::canFuseActivation() const {
+    return false;
+}
+/// \brief apply activation to our output, after the bias.  activation is NOT owned
+VIRTUAL void Layer::fuseActivation(ActivationFunction const *activation) {
+    throw std::runtime_error("fuseActivation not implemented for " + getClassName());
+}
 VIRTUAL bool Layer::providesGradInputWrapper() const {
     return false;
 }
@@ -31,6 +31,7 @@ public:
     Layer *nextLayer;
     const int layerIndex;
     bool training;
+    bool sharedOutput; // output buffers belong to the net, see NeuralNet::planInference
 
     LayerMaker2 *maker;
 
@@ -45,13 +46,20 @@ public:
 
     // [[[cog
     // import cog_addheaders
-    // cog_addheaders.add()
+    // cog_addheaders.addv2(default_access='public')
     // ]]]
     // generated, using cog:
+
+    public:
     PUBLICAPI Layer(Layer *previousLayer, LayerMaker2 *maker);
     VIRTUAL ~Layer();
     PUBLICAPI VIRTUAL void setTraining(bool training);
     PUBLICAPI VIRTUAL void setBatchSize(int batchSize);
+    VIRTUAL bool canShareOutput() const;
+    VIRTUAL void setSharedOutput(float *output, CLWrapper *outputWrapper);
+    VIRTUAL bool passesThroughOutput() const;
+    VIRTUAL bool canFuseActivation() const;
+    VIRTUAL void fuseActivation(ActivationFunction const *activation);
     VIRTUAL bool providesGradInputWrapper() const;
     VIRTUAL const char *getClassNameAsCharStar() const;
     VIRTUAL float *getGradInput();
@@ -98,6 +106,9 @@ public:
     VIRTUAL TrainerState *getBiasTrainerState();
     VIRTUAL void updateWeights(CLWrapper *weightChangesWrapper, CLWrapper *biasChangesWrapper);
 
+    protected:
+    void adoptSharedOutput(float *output, CLWrapper *outputWrapper, float **p_output, CLWrapper **p_outputWrapper, float **p_gradInput, CLWrapper **p_gradInputWrapper, int *p_allocatedSize);
+
     // [[[end]]]
 
 };
@@ -9,7 +9,6 @@
 #include "loaders/NorbLoader.h"
 #include "util/FileHelper.h"
 #include "Kgsv2Loader.h"
-#include "util/StatefulTimer.h"
 #include "loaders/MnistLoader.h"
 #include "DeepCLDllExport.h"
 #include "loaders/GenericLoader.h"
@@ -69,7 +68,6 @@ PUBLIC STATIC void GenericLoader::load(const char * trainFilepath, unsigned char
 }
 // for now, if pass in 0 for labels, it wont read labels
 PUBLIC STATIC void GenericLoader::load(const char * trainFilepath, unsigned char *images, int *labels, int startN, int numExamples) {
-    StatefulTimer::timeCheck("GenericLoader::load start");
     char *headerBytes = FileHelper::readBinaryChunk(trainFilepath, 0, 1024);
     char type[1025];
     strncpy(type, headerBytes, 4);
@@ -88,7 +86,6 @@ PUBLIC STATIC void GenericLoader::load(const char * trainFilepath, unsigned char
         cout << "headstring" << type << endl;
         throw runtime_error(string("Filetype of ") + trainFilepath + " not recognised");
     }
-    StatefulTimer::timeCheck("GenericLoader::load end");
 }
 
 
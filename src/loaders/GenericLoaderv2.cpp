@@ -7,10 +7,12 @@
 #include <iostream>
 
 #include "util/FileHelper.h"
-#include "util/StatefulTimer.h"
+#include "util/ProfileScope.h"
+#include "util/Profiler.h"
 #include "loaders/Loader.h"
 #include "loaders/GenericLoaderv1Wrapper.h"
 #include "loaders/GenericLoaderv2.h"
+#include "loaders/PackedLoader.h"
 
 #ifdef LIBJPEG_FOUND
 #include "loaders/ManifestLoaderv1.h"
@@ -29,8 +31,13 @@ using namespace std;
 
 PUBLIC GenericLoaderv2::GenericLoaderv2(std::string imagesFilepath) {
     loader = 0;
+    packedLoader = 0;
+    if(PackedLoader::isFormatFor(imagesFilepath)) {
+        packedLoader = new PackedLoader(imagesFilepath);
+        loader = packedLoader;
+    }
     #ifdef LIBJPEG_FOUND
-    if(ManifestLoaderv1::isFormatFor(imagesFilepath) ) {
+    if(loader == 0 && ManifestLoaderv1::isFormatFor(imagesFilepath) ) {
         loader = new ManifestLoaderv1(imagesFilepath);
     }
     #endif
@@ -38,8 +45,18 @@ PUBLIC GenericLoaderv2::GenericLoaderv2(std::string imagesFilepath) {
         loader = new GenericLoaderv1Wrapper(imagesFilepath);
     }
 }
+PUBLIC GenericLoaderv2::~GenericLoaderv2() {
+    delete loader;
+}
 
 PUBLIC void GenericLoaderv2::load(float *images, int *labels, int startN, int numExamples) {
+    if(packedLoader != 0) {
+        // straight from the mapped file, no intermediate buffer, and
+        // handles float files too
+        ProfileScope profile(0, Profiler::IO, 0, -1);
+        packedLoader->load(images, labels, startN, numExamples);
+        return;
+    }
     int linearSize =  numExamples * loader->getImageCubeSize();
     unsigned char *ucImages = new unsigned char[ linearSize ];
 
@@ -59,16 +76,17 @@ PUBLIC int GenericLoaderv2::getPlanes() {
 PUBLIC int GenericLoaderv2::getImageSize() {
     return loader->getImageSize();
 }
+/// \brief true for packed files that pack-dataset normalized, which hold floats, and can only be loaded as floats
+PUBLIC bool GenericLoaderv2::getIsFloat() {
+    return packedLoader != 0 && packedLoader->getIsFloat();
+}
 PUBLIC void GenericLoaderv2::load(unsigned char *images, int *labels) {
     load(images, labels, 0, 0);
 }
 
 PUBLIC void GenericLoaderv2::load(unsigned char *images, int *labels, int startN, int numExamples) {
-    StatefulTimer::timeCheck("GenericLoaderv2::load start");
-
+    ProfileScope profile(0, Profiler::IO, 0, -1);
     loader->load(images, labels, startN, numExamples);
-
-    StatefulTimer::timeCheck("GenericLoaderv2::load end");
 }
 
 
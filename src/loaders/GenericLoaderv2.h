@@ -14,6 +14,7 @@
 #include "DeepCLDllExport.h"
 
 class Loader;
+class PackedLoader;
 
 #define VIRTUAL virtual
 #define STATIC static
@@ -24,6 +25,7 @@ class Loader;
 class DeepCL_EXPORT GenericLoaderv2 {
     private:
     Loader *loader;
+    PackedLoader *packedLoader; // same object as loader, if the file is packed format
 
     // [[[cog
     // import cog_addheaders
@@ -33,10 +35,12 @@ class DeepCL_EXPORT GenericLoaderv2 {
 
     public:
     GenericLoaderv2(std::string imagesFilepath);
+    ~GenericLoaderv2();
     void load(float *images, int *labels, int startN, int numExamples);
     int getN();
     int getPlanes();
     int getImageSize();
+    bool getIsFloat();
     void load(unsigned char *images, int *labels);
     void load(unsigned char *images, int *labels, int startN, int numExamples);
 
@@ -16,6 +16,7 @@
 
 class Loader {
     public:
+    VIRTUAL ~Loader() {}
     VIRTUAL std::string getType() = 0;
     VIRTUAL void load(unsigned char *data, int *labels, int startRecord, int numRecords) = 0;
     VIRTUAL int getImageCubeSize() = 0;
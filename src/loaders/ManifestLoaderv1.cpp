@@ -9,11 +9,14 @@
 #include <cstring>
 #include <fstream>
 #include <stdexcept>
+#include <vector>
+#include <algorithm>
 
 #include "util/FileHelper.h"
 #include "util/stringhelper.h"
 #include "ManifestLoaderv1.h"
 #include "util/JpegHelper.h"
+#include "util/ThreadPool.h"
 
 #include "DeepCLDllExport.h"
 
@@ -33,7 +36,8 @@ PUBLIC STATIC bool ManifestLoaderv1::isFormatFor(std::string imagesFilepath) {
     cout << "matched: " << matched << endl;
     return matched;
 }
-PUBLIC ManifestLoaderv1::ManifestLoaderv1(std::string imagesFilepath) {
+PUBLIC ManifestLoaderv1::ManifestLoaderv1(std::string imagesFilepath) :
+        numDecodeErrors(0) {
     init(imagesFilepath);
 }
 PRIVATE void ManifestLoaderv1::init(std::string imagesFilepath) {
@@ -166,20 +170,40 @@ int ManifestLoaderv1::readIntValue(std::vector< std::string > splitLine, std::st
     }
     throw runtime_error("Key " + key + " not found in file header");
 }
+// decodes the jpegs in parallel, on ThreadPool, each one straight into its own
+// slot in data, so the output is the same as decoding them in order
+// A record that cant be decoded is reported, and left as zeros, rather than
+// failing the whole chunk
 PUBLIC VIRTUAL void ManifestLoaderv1::load(unsigned char *data, int *labels, int startRecord, int numRecords) {
+    if(labels != 0 && !hasLabels) {
+        throw runtime_error("ManifestLoaderv1: labels reqested in load() method, but none found in file");
+    }
     int imageCubeSize = planes * size * size;
+    numRecords = std::max(0, std::min(numRecords, N - startRecord));
 //    cout << "ManifestLoaderv1, loading " << numRecords << " jpegs" << endl;
-    for(int localN = 0; localN < numRecords; localN++) {
+    vector<string> errors(numRecords);
+    ThreadPool::instance()->parallelFor(numRecords, [&](int localN) {
         int globalN = localN + startRecord;
-        if(globalN >= N) {
-            return;
+        unsigned char *image = data + (long)localN * imageCubeSize;
+        try {
+            JpegHelper::read(files[globalN], planes, size, size, image);
+        } catch(runtime_error &e) {
+            memset(image, 0, imageCubeSize);
+            errors[localN] = e.what();
         }
-        JpegHelper::read(files[globalN], planes, size, size, data + localN * imageCubeSize);
+    });
+    for(int localN = 0; localN < numRecords; localN++) {
+        int globalN = localN + startRecord;
         if(labels != 0) {
-            if(!hasLabels) {
-                throw runtime_error("ManifestLoaderv1: labels reqested in load() method, but none found in file");
-            }
             labels[localN] = this->labels[globalN];
         }
+        if(errors[localN] != "") {
+            numDecodeErrors++;
+            cout << "ManifestLoaderv1: record " << globalN << " left blank: " << errors[localN] << endl;
+        }
     }
-}
\ No newline at end of file
+}
+// how many records failed to decode, over all load() calls so far
+PUBLIC int ManifestLoaderv1::getNumDecodeErrors() {
+    return numDecodeErrors;
+}
@@ -10,6 +10,7 @@
 #include <string>
 #include <iostream>
 #include <algorithm>
+#include <vector>
 
 #include "loaders/Loader.h"
 
@@ -26,6 +27,7 @@ class ManifestLoaderv1 : public Loader {
     bool hasLabels;
     std::string *files;
     int *labels;
+    int numDecodeErrors;
 
     // [[[cog
     // import cog_addheaders
@@ -42,6 +44,7 @@ class ManifestLoaderv1 : public Loader {
     VIRTUAL int getPlanes();
     VIRTUAL int getImageSize();
     VIRTUAL void load(unsigned char *data, int *labels, int startRecord, int numRecords);
+    int getNumDecodeErrors();
 
     private:
     void init(std::string imagesFilepath);
@@ -0,0 +1,202 @@
+// Copyright Hugh Perkins 2015 hughperkins at gmail
+//
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file, You can
+// obtain one at http://mozilla.org/MPL/2.0/.
+
+#include <iostream>
+#include <fstream>
+#include <string>
+#include <cstring>
+#include <stdexcept>
+
+#include "util/FileHelper.h"
+#include "util/MappedFile.h"
+#include "util/stringhelper.h"
+#include "loaders/PackedLoader.h"
+
+using namespace std;
+
+#undef STATIC
+#undef VIRTUAL
+#define STATIC
+#define VIRTUAL
+
+#define PACKED_MAGIC "DCLPACK1"
+#define PACKED_VERSION 1
+#define PACKED_HEADER_SIZE 64
+#define PACKED_BYTE_ORDER 0x01020304
+
+static int readInt(char const*header, int offset) {
+    int value;
+    memcpy(&value, header + offset, 4);
+    return value;
+}
+static float readFloat(char const*header, int offset) {
+    float value;
+    memcpy(&value, header + offset, 4);
+    return value;
+}
+static void writeInt(char *header, int offset, int value) {
+    memcpy(header + offset, &value, 4);
+}
+static void writeFloat(char *header, int offset, float value) {
+    memcpy(header + offset, &value, 4);
+}
+
+PUBLIC STATIC bool PackedLoader::isFormatFor(std::string imagesFilepath) {
+    ifstream infile(FileHelper::localizePath(imagesFilepath).c_str(), ios::in | ios::binary);
+    char magic[8];
+    if(!infile.read(magic, 8)) {
+        return false;
+    }
+    return memcmp(magic, PACKED_MAGIC, 8) == 0;
+}
+// the 64 byte header; file is this, then the images, then the labels
+//  0  "DCLPACK1"
+//  8  int32 version
+// 12  int32 header size, ie 64
+// 16  int32 N
+// 20  int32 planes
+// 24  int32 image size
+// 28  int32 data type: 0 uint8, 1 float32
+// 32  int32 has labels
+// 36  float32 translate
+// 40  float32 scale
+// 44  int32 0x01020304, to catch files from big-endian machines
+// 48  reserved, zeros
+PUBLIC STATIC std::string PackedLoader::makeHeader(int N, int planes, int size, bool isFloat, bool hasLabels, float translate, float scale) {
+    char header[PACKED_HEADER_SIZE];
+    memset(header, 0, PACKED_HEADER_SIZE);
+    memcpy(header, PACKED_MAGIC, 8);
+    writeInt(header, 8, PACKED_VERSION);
+    writeInt(header, 12, PACKED_HEADER_SIZE);
+    writeInt(header, 16, N);
+    writeInt(header, 20, planes);
+    writeInt(header, 24, size);
+    writeInt(header, 28, isFloat ? 1 : 0);
+    writeInt(header, 32, hasLabels ? 1 : 0);
+    writeFloat(header, 36, translate);
+    writeFloat(header, 40, scale);
+    writeInt(header, 44, PACKED_BYTE_ORDER);
+    return string(header, PACKED_HEADER_SIZE);
+}
+PUBLIC PackedLoader::PackedLoader(std::string imagesFilepath) :
+        imagesFilepath(imagesFilepath),
+        file(0) {
+    file = new MappedFile(imagesFilepath);
+    char const*header = file->getData();
+    if(file->getSize() < PACKED_HEADER_SIZE || memcmp(header, PACKED_MAGIC, 8) != 0) {
+        delete file;
+        throw runtime_error("file " + imagesFilepath + " is not a deepcl packed dataset file");
+    }
+    int version = readInt(header, 8);
+    int headerSize = readInt(header, 12);
+    if(version != PACKED_VERSION || readInt(header, 44) != PACKED_BYTE_ORDER || headerSize < PACKED_HEADER_SIZE) {
+        delete file;
+        throw runtime_error("packed dataset file " + imagesFilepath + " has version " + toString(version) +
+            ", or byte order, that we cant read");
+    }
+    N = readInt(header, 16);
+    planes = readInt(header, 20);
+    size = readInt(header, 24);
+    isFloat = readInt(header, 28) == 1;
+    hasLabels = readInt(header, 32) == 1;
+    translate = readFloat(header, 36);
+    scale = readFloat(header, 40);
+    long imagesBytes = (long)N * getImageCubeSize() * (isFloat ? 4 : 1);
+    long expectedSize = headerSize + imagesBytes + (hasLabels ? (long)N * 4 : 0);
+    if(N < 0 || planes <= 0 || size <= 0 || file->getSize() < expectedSize) {
+        delete file;
+        throw runtime_error("packed dataset file " + imagesFilepath + " is truncated: expected " +
+            toString(expectedSize) + " bytes, found " + toString(file->getSize()));
+    }
+    images = header + headerSize;
+    labels = hasLabels ? (int const*)(images + imagesBytes) : 0;
+    cout << "packed dataset " << imagesFilepath << " N=" << N << " planes=" << planes << " size=" << size
+        << " float? " << isFloat << " labels? " << hasLabels << endl;
+}
+PUBLIC VIRTUAL PackedLoader::~PackedLoader() {
+    delete file;
+}
+PUBLIC VIRTUAL std::string PackedLoader::getType() {
+    return "PackedLoader";
+}
+PUBLIC VIRTUAL int PackedLoader::getImageCubeSize() {
+    return planes * size * size;
+}
+PUBLIC VIRTUAL int PackedLoader::getN() {
+    return N;
+}
+PUBLIC VIRTUAL int PackedLoader::getPlanes() {
+    return planes;
+}
+PUBLIC VIRTUAL int PackedLoader::getImageSize() {
+    return size;
+}
+PUBLIC bool PackedLoader::getIsFloat() {
+    return isFloat;
+}
+PUBLIC bool PackedLoader::getHasLabels() {
+    return hasLabels;
+}
+// translate and scale already applied to the stored values, or 0 and 1
+PUBLIC float PackedLoader::getTranslate() {
+    return translate;
+}
+PUBLIC float PackedLoader::getScale() {
+    return scale;
+}
+// views into the mapped file, valid while this loader lives; no copy is made
+PUBLIC unsigned char const*PackedLoader::getRecord(int n) {
+    if(isFloat) {
+        throw runtime_error("packed dataset " + imagesFilepath + " stores floats, use getFloatRecord()");
+    }
+    return (unsigned char const*)images + (long)n * getImageCubeSize();
+}
+PUBLIC float const*PackedLoader::getFloatRecord(int n) {
+    if(!isFloat) {
+        throw runtime_error("packed dataset " + imagesFilepath + " stores uint8s, use getRecord()");
+    }
+    return (float const*)images + (long)n * getImageCubeSize();
+}
+PUBLIC int const*PackedLoader::getLabels() {
+    return labels;
+}
+PRIVATE int PackedLoader::checkRange(int *labels, int startRecord, int numRecords) {
+    if(labels != 0 && !hasLabels) {
+        throw runtime_error("PackedLoader: labels requested, but " + imagesFilepath + " has none");
+    }
+    if(numRecords == 0) {
+        numRecords = N - startRecord;
+    }
+    if(startRecord < 0 || startRecord + numRecords > N) {
+        throw runtime_error("PackedLoader: records " + toString(startRecord) + " to " +
+            toString(startRecord + numRecords) + " out of range for " + imagesFilepath + ", N=" + toString(N));
+    }
+    file->willNeed(images - file->getData() + (long)startRecord * getImageCubeSize() * (isFloat ? 4 : 1),
+        (long)numRecords * getImageCubeSize() * (isFloat ? 4 : 1));
+    if(labels != 0) {
+        memcpy(labels, this->labels + startRecord, sizeof(int) * numRecords);
+    }
+    return numRecords;
+}
+PUBLIC VIRTUAL void PackedLoader::load(unsigned char *data, int *labels, int startRecord, int numRecords) {
+    if(isFloat) {
+        throw runtime_error("packed dataset " + imagesFilepath + " stores floats, so can only be loaded as floats");
+    }
+    numRecords = checkRange(labels, startRecord, numRecords);
+    memcpy(data, getRecord(startRecord), (long)numRecords * getImageCubeSize());
+}
+PUBLIC void PackedLoader::load(float *data, int *labels, int startRecord, int numRecords) {
+    numRecords = checkRange(labels, startRecord, numRecords);
+    long linearSize = (long)numRecords * getImageCubeSize();
+    if(isFloat) {
+        memcpy(data, getFloatRecord(startRecord), sizeof(float) * linearSize);
+    } else {
+        unsigned char const*source = getRecord(startRecord);
+        for(long i = 0; i < linearSize; i++) {
+            data[i] = source[i];
+        }
+    }
+}
@@ -0,0 +1,77 @@
+// Copyright Hugh Perkins 2015 hughperkins at gmail
+//
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file, You can
+// obtain one at http://mozilla.org/MPL/2.0/.
+
+#pragma once
+
+#include <stdexcept>
+#include <string>
+#include <iostream>
+#include <algorithm>
+
+#include "loaders/Loader.h"
+#include "DeepCLDllExport.h"
+
+class MappedFile;
+
+#define VIRTUAL virtual
+#define STATIC static
+
+// DeepCL's own dataset format, written by pack-dataset: fixed-size records,
+// so any record can be read without parsing the ones before it
+// layout, all little-endian:
+//   64 byte header, see makeHeader()
+//   N images, each planes * size * size values, either uint8 or float32
+//   N int32 labels, if hasLabels
+// float32 files are usually already normalized, and the header keeps the
+// translate and scale that were applied
+// The file is mmapped, so reads are straight from the page cache, and
+// getRecord() etc give views into the file, without copying
+class DeepCL_EXPORT PackedLoader : public Loader {
+    private:
+    std::string imagesFilepath;
+    MappedFile *file;
+    int N;
+    int planes;
+    int size;
+    bool isFloat;
+    bool hasLabels;
+    float translate;
+    float scale;
+    char const*images;
+    int const*labels;
+
+    // [[[cog
+    // import cog_addheaders
+    // cog_addheaders.addv2()
+    // ]]]
+    // generated, using cog:
+
+    public:
+    STATIC bool isFormatFor(std::string imagesFilepath);
+    STATIC std::string makeHeader(int N, int planes, int size, bool isFloat, bool hasLabels, float translate, float scale);
+    PackedLoader(std::string imagesFilepath);
+    VIRTUAL ~PackedLoader();
+    VIRTUAL std::string getType();
+    VIRTUAL int getImageCubeSize();
+    VIRTUAL int getN();
+    VIRTUAL int getPlanes();
+    VIRTUAL int getImageSize();
+    bool getIsFloat();
+    bool getHasLabels();
+    float getTranslate();
+    float getScale();
+    unsigned char const*getRecord(int n);
+    float const*getFloatRecord(int n);
+    int const*getLabels();
+    VIRTUAL void load(unsigned char *data, int *labels, int startRecord, int numRecords);
+    void load(float *data, int *labels, int startRecord, int numRecords);
+
+    private:
+    int checkRange(int *labels, int startRecord, int numRecords);
+
+    // [[[end]]]
+};
+
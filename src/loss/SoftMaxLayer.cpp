@@ -4,7 +4,10 @@
 // v. 2.0. If a copy of the MPL was not distributed with this file, You can 
 // obtain one at http://mozilla.org/MPL/2.0/.
 
-#include "util/StatefulTimer.h"
+#include <cstring>
+#include <algorithm>
+
+#include "util/KernelCache.h"
 
 #include "layer/LayerMaker.h"
 #include "loss/SoftMaxLayer.h"
@@ -22,299 +25,393 @@ SoftMaxLayer::SoftMaxLayer(Layer *previousLayer, SoftMaxMaker *maker) :
         imageSize(previousLayer->getOutputSize()),
         numPlanes(previousLayer->getOutputPlanes()),
         imageSizeSquared(previousLayer->getOutputSize() * previousLayer->getOutputSize()),
+        cl(maker->cl),
         output(0),
         gradInput(0),
+        outputWrapper(0),
+        gradInputWrapper(0),
+        labels(0),
+        labelsWrapper(0),
+        groupLoss(0),
+        groupLossWrapper(0),
+        groupRight(0),
+        groupRightWrapper(0),
+        resultsWrapper(0),
+        labelStatsValid(false),
+        loss(0),
+        numRight(0),
         allocatedSize(0),
         batchSize(0)
          {
-}
-VIRTUAL SoftMaxLayer::~SoftMaxLayer() {
-    if(gradInput != 0) {
-        delete[] gradInput;
+    if(cl == 0) {
+        throw runtime_error("SoftMaxLayer: needs an EasyCL, set on the maker");
+    }
+    // see cl/softmax.cl for what the groups are
+    groupSize = perPlane ? imageSizeSquared : numPlanes;
+    groupInner = perPlane ? 1 : imageSizeSquared;
+    groupsPerExample = perPlane ? numPlanes : imageSizeSquared;
+    results[0] = 0;
+    results[1] = 0;
+    resultsWrapper = cl->wrap(2, results);
+    resultsWrapper->createOnDevice();
+
+    sumWorkgroupSize = 1;
+    while(sumWorkgroupSize * 2 <= std::min(256, cl->getMaxWorkgroupSize())) {
+        sumWorkgroupSize *= 2;
     }
-    if(output != 0) {
-        delete[] output;
+    string options = " -DgGroupSize=" + toString(groupSize) + " -DgInner=" + toString(groupInner);
+    string kernelName = "SoftMaxLayer.softmax" + options;
+    if(cl->kernelExists(kernelName + ".forward")) {
+        kernelForward = cl->getKernel(kernelName + ".forward");
+        kernelLabels = cl->getKernel(kernelName + ".labels");
+        kernelArgmax = cl->getKernel(kernelName + ".argmax");
+        kernelSum = cl->getKernel(kernelName + ".sum");
+        return;
     }
+    // [[[cog
+    // import stringify
+    // stringify.write_kernel2("kernelForward", "cl/softmax.cl", "softmax_forward", 'options')
+    // ]]]
+    // generated using cog, from cl/softmax.cl:
+    const char * kernelForwardSource =  
+    "// Copyright Hugh Perkins 2015 hughperkins at gmail\n"
+    "//\n"
+    "// This Source Code Form is subject to the terms of the Mozilla Public License,\n"
+    "// v. 2.0. If a copy of the MPL was not distributed with this file, You can\n"
+    "// obtain one at http://mozilla.org/MPL/2.0/.\n"
+    "\n"
+    "// softmax, cross-entropy loss and argmax, for SoftMaxLayer\n"
+    "// each softmax is over one 'group' of gGroupSize values, spaced gInner apart:\n"
+    "// - per-plane: a group is one plane of one example, so gGroupSize is imageSizeSquared, gInner 1\n"
+    "// - per-column: a group is all the planes at one pixel of one example, so gGroupSize is\n"
+    "//   numPlanes, and gInner is imageSizeSquared\n"
+    "// there is one label per group, in group order, in both cases\n"
+    "// one thread per group, except for softmax_sum\n"
+    "\n"
+    "// expected defines:\n"
+    "// gGroupSize: number of values in each softmax\n"
+    "// gInner: distance between consecutive values of one group\n"
+    "\n"
+    "int groupBase(const int group) {\n"
+    "    return (group / gInner) * gGroupSize * gInner + group % gInner;\n"
+    "}\n"
+    "\n"
+    "kernel void softmax_forward(\n"
+    "        const int numGroups,\n"
+    "        global const float *input,\n"
+    "        global float *output) {\n"
+    "    const int group = get_global_id(0);\n"
+    "    if(group >= numGroups) {\n"
+    "        return;\n"
+    "    }\n"
+    "    const int base = groupBase(group);\n"
+    "    float maxValue = input[base];\n"
+    "    for(int i = 1; i < gGroupSize; i++) {\n"
+    "        maxValue = max(maxValue, input[base + i * gInner]);\n"
+    "    }\n"
+    "    float denominator = 0;\n"
+    "    for(int i = 0; i < gGroupSize; i++) {\n"
+    "        denominator += exp(input[base + i * gInner] - maxValue);\n"
+    "    }\n"
+    "    for(int i = 0; i < gGroupSize; i++) {\n"
+    "        output[base + i * gInner] = exp(input[base + i * gInner] - maxValue) / denominator;\n"
+    "    }\n"
+    "}\n"
+    "\n"
+    "// gradInput is output minus one-hot label; also writes each group's loss, and 1.0f if\n"
+    "// the argmax matches the label, else 0.0f, for softmax_sum to add up\n"
+    "kernel void softmax_labels(\n"
+    "        const int numGroups,\n"
+    "        global const float *output,\n"
+    "        global const int *labels,\n"
+    "        global float *gradInput,\n"
+    "        global float *groupLoss,\n"
+    "        global float *groupRight) {\n"
+    "    const int group = get_global_id(0);\n"
+    "    if(group >= numGroups) {\n"
+    "        return;\n"
+    "    }\n"
+    "    const int base = groupBase(group);\n"
+    "    const int label = labels[group];\n"
+    "    float thisMax = output[base];\n"
+    "    int iMax = 0;\n"
+    "    for(int i = 0; i < gGroupSize; i++) {\n"
+    "        const float value = output[base + i * gInner];\n"
+    "        gradInput[base + i * gInner] = i == label ? value - 1.0f : value;\n"
+    "        if(value > thisMax) {\n"
+    "            thisMax = value;\n"
+    "            iMax = i;\n"
+    "        }\n"
+    "    }\n"
+    "    groupLoss[group] = - log(output[base + label * gInner]);\n"
+    "    groupRight[group] = iMax == label ? 1.0f : 0.0f;\n"
+    "}\n"
+    "\n"
+    "kernel void softmax_argmax(\n"
+    "        const int numGroups,\n"
+    "        global const float *output,\n"
+    "        global int *labels) {\n"
+    "    const int group = get_global_id(0);\n"
+    "    if(group >= numGroups) {\n"
+    "        return;\n"
+    "    }\n"
+    "    const int base = groupBase(group);\n"
+    "    float thisMax = output[base];\n"
+    "    int iMax = 0;\n"
+    "    for(int i = 1; i < gGroupSize; i++) {\n"
+    "        const float value = output[base + i * gInner];\n"
+    "        if(value > thisMax) {\n"
+    "            thisMax = value;\n"
+    "            iMax = i;\n"
+    "        }\n"
+    "    }\n"
+    "    labels[group] = iMax;\n"
+    "}\n"
+    "\n"
+    "// results[0] = sum of groupLoss, results[1] = sum of groupRight\n"
+    "// run as a single workgroup, whose size is a power of two\n"
+    "kernel void softmax_sum(\n"
+    "        const int numGroups,\n"
+    "        global const float *groupLoss,\n"
+    "        global const float *groupRight,\n"
+    "        global float *results,\n"
+    "        local float *lossScratch,\n"
+    "        local float *rightScratch) {\n"
+    "    const int localId = get_local_id(0);\n"
+    "    const int workgroupSize = get_local_size(0);\n"
+    "    float loss = 0;\n"
+    "    float right = 0;\n"
+    "    for(int group = localId; group < numGroups; group += workgroupSize) {\n"
+    "        loss += groupLoss[group];\n"
+    "        right += groupRight[group];\n"
+    "    }\n"
+    "    lossScratch[localId] = loss;\n"
+    "    rightScratch[localId] = right;\n"
+    "    barrier(CLK_LOCAL_MEM_FENCE);\n"
+    "    for(int offset = workgroupSize >> 1; offset > 0; offset >>= 1) {\n"
+    "        if(localId < offset) {\n"
+    "            lossScratch[localId] += lossScratch[localId + offset];\n"
+    "            rightScratch[localId] += rightScratch[localId + offset];\n"
+    "        }\n"
+    "        barrier(CLK_LOCAL_MEM_FENCE);\n"
+    "    }\n"
+    "    if(localId == 0) {\n"
+    "        results[0] = lossScratch[0];\n"
+    "        results[1] = rightScratch[0];\n"
+    "    }\n"
+    "}\n"
+    "\n"
+    "";
+    kernelForward = KernelCache::buildKernelFromString(cl, kernelForwardSource, "softmax_forward", options, "cl/softmax.cl");
+    // [[[end]]]
+    kernelLabels = KernelCache::buildKernelFromString(cl, kernelForwardSource, "softmax_labels", options, "cl/softmax.cl");
+    kernelArgmax = KernelCache::buildKernelFromString(cl, kernelForwardSource, "softmax_argmax", options, "cl/softmax.cl");
+    kernelSum = KernelCache::buildKernelFromString(cl, kernelForwardSource, "softmax_sum", options, "cl/softmax.cl");
+    cl->storeKernel(kernelName + ".forward", kernelForward, true);
+    cl->storeKernel(kernelName + ".labels", kernelLabels, true);
+    cl->storeKernel(kernelName + ".argmax", kernelArgmax, true);
+    cl->storeKernel(kernelName + ".sum", kernelSum, true);
+}
+VIRTUAL SoftMaxLayer::~SoftMaxLayer() {
+    freeBuffers();
+    delete resultsWrapper;
 }
 VIRTUAL std::string SoftMaxLayer::getClassName() const {
     return "SoftMaxLayer";
 }
 VIRTUAL float *SoftMaxLayer::getOutput() {
+    if(outputWrapper->isDeviceDirty()) {
+        outputWrapper->copyToHost();
+    }
     return output;
 }
 VIRTUAL float *SoftMaxLayer::getGradInput() {
+    if(gradInputWrapper->isDeviceDirty()) {
+        gradInputWrapper->copyToHost();
+    }
     return gradInput;
 }
+VIRTUAL bool SoftMaxLayer::hasOutputWrapper() const {
+    return true;
+}
+VIRTUAL CLWrapper *SoftMaxLayer::getOutputWrapper() {
+    return outputWrapper;
+}
+VIRTUAL bool SoftMaxLayer::providesGradInputWrapper() const {
+    return true;
+}
+VIRTUAL CLWrapper *SoftMaxLayer::getGradInputWrapper() {
+    return gradInputWrapper;
+}
+// overwrites the output, eg with the averaged outputs of several nets, in MultiNet
+// output is getOutputNumElements() floats
+void SoftMaxLayer::setOutput(float const*newOutput) {
+    memcpy(output, newOutput, sizeof(float) * getOutputNumElements());
+    outputWrapper->copyToDevice();
+    labelStatsValid = false;
+}
+void SoftMaxLayer::freeBuffers() {
+    delete outputWrapper;
+    delete gradInputWrapper;
+    delete labelsWrapper;
+    delete groupLossWrapper;
+    delete groupRightWrapper;
+    delete[] output;
+    delete[] gradInput;
+    delete[] labels;
+    delete[] groupLoss;
+    delete[] groupRight;
+}
 VIRTUAL void SoftMaxLayer::setBatchSize(int batchSize) {
     this->batchSize = batchSize;
+    labelStatsValid = false;
     if(batchSize <= this->allocatedSize) {
         return;
     }
-    if(output != 0) {
-        delete[] output;
-    }
-    if(gradInput != 0) {
-        delete[] gradInput;
-    }
+    freeBuffers();
     output = new float[ getOutputNumElements() ];
+    outputWrapper = cl->wrap(getOutputNumElements(), output);
+    outputWrapper->createOnDevice();
     gradInput = new float[ previousLayer-> getOutputNumElements() ];
+    gradInputWrapper = cl->wrap(previousLayer->getOutputNumElements(), gradInput);
+    gradInputWrapper->createOnDevice();
+    const int numGroups = batchSize * groupsPerExample;
+    labels = new int[numGroups];
+    labelsWrapper = cl->wrap(numGroups, labels);
+    labelsWrapper->createOnDevice();
+    groupLoss = new float[numGroups];
+    groupLossWrapper = cl->wrap(numGroups, groupLoss);
+    groupLossWrapper->createOnDevice();
+    groupRight = new float[numGroups];
+    groupRightWrapper = cl->wrap(numGroups, groupRight);
+    groupRightWrapper->createOnDevice();
     allocatedSize = batchSize;
 }
 VIRTUAL int SoftMaxLayer::getBatchSize() {
     return this->batchSize;
 }
-// need to calculate multinomial logistic /cross-entropy loss
-VIRTUAL float SoftMaxLayer::calcLossFromLabels(int const *labels) {
-//    cout << "softmaxlayer::calcloss" << endl;
-    StatefulTimer::timeCheck("start SoftMaxLayer calcLossfromlabels");
-    float loss = 0;
-    if(perPlane) {
-        for(int n = 0; n < batchSize; n++) {
-            for(int plane = 0; plane < numPlanes; plane++) {
-                int label = labels[n * numPlanes + plane];
-                int imageOffset = (n * numPlanes + plane) * imageSizeSquared;
-                loss += - log(output[ imageOffset + label ]);
-            }
-        }
-    } else {
-        // force imagesize of 1 for now
-        if(imageSize != 1) {
-            throw std::runtime_error("perColumn only supported for imagesize 1 for now.  Sit tight :-)  (But please raise an issue to highlight your need)");
-        }
-        for(int n = 0; n < batchSize; n++) {
-            int imageOffset = n * numPlanes * imageSizeSquared;
-            int label = labels[n];
-            loss += - log(output[imageOffset + label]);
+// runs the loss, num-right and gradInput kernels for these labels, unless already done
+// since the last forward. Only the loss and num-right come back to the host
+void SoftMaxLayer::calcLabelStats(int const *labels) {
+    const int numGroups = batchSize * groupsPerExample;
+    if(labelStatsValid && memcmp(labels, this->labels, sizeof(int) * numGroups) == 0) {
+        return;
+    }
+    for(int i = 0; i < numGroups; i++) {
+        if(labels[i] >= groupSize) {
+            throw runtime_error("Label " + toString(labels[i]) + " exceeds number of softmax " + 
+                (perPlane ? "pixels " : "planes ") + toString(groupSize) );
+        } else if(labels[i] < 0) {
+            throw runtime_error("Label " + toString(labels[i]) + " negative");
         }
     }
-    StatefulTimer::timeCheck("end SoftMaxLayer calcLossfromlabels");
+    memcpy(this->labels, labels, sizeof(int) * numGroups);
+    labelsWrapper->copyToDevice();
+
+    int workgroupSize = sumWorkgroupSize;
+    int numWorkgroups = (numGroups + workgroupSize - 1) / workgroupSize;
+    kernelLabels->in(numGroups)
+        ->in(outputWrapper)
+        ->in(labelsWrapper)
+        ->out(gradInputWrapper)
+        ->out(groupLossWrapper)
+        ->out(groupRightWrapper);
+    kernelLabels->run_1d(numWorkgroups * workgroupSize, workgroupSize);
+
+    kernelSum->in(numGroups)
+        ->in(groupLossWrapper)
+        ->in(groupRightWrapper)
+        ->out(resultsWrapper)
+        ->localFloats(sumWorkgroupSize)
+        ->localFloats(sumWorkgroupSize);
+    kernelSum->run_1d(sumWorkgroupSize, sumWorkgroupSize);
+    resultsWrapper->copyToHost();
+    loss = results[0];
+    numRight = (int)(results[1] + 0.5f);
+    labelStatsValid = true;
+}
+// need to calculate multinomial logistic /cross-entropy loss
+VIRTUAL float SoftMaxLayer::calcLossFromLabels(int const *labels) {
+    calcLabelStats(labels);
     return loss;
 }
 // need to calculate multinomial logistic /cross-entropy loss
 VIRTUAL float SoftMaxLayer::calcLoss(float const *expectedValues) {
-    StatefulTimer::timeCheck("start SoftMaxLayer calcLoss");
+    float const*output = getOutput();
+    // same sum in both modes, since every value belongs to exactly one softmax
     float loss = 0;
-    if(perPlane) {
-        for(int n = 0; n < batchSize; n++) {
-            for(int plane = 0; plane < numPlanes; plane++) {
-                int imageOffset = (n * numPlanes + plane) * imageSizeSquared;
-                for(int i = 0; i < imageSizeSquared; i++) {
-                    if(expectedValues[ imageOffset + i ] != 0) {
-                        float thisloss = - expectedValues[ imageOffset + i ] * log(output[ imageOffset + i ]);
-                        loss += thisloss;
-                    }
-                }
-            }
-        }
-    } else {
-        // force imagesize of 1 for now
-        if(imageSize != 1) {
-            throw std::runtime_error("perColumn only supported for imagesize 1 for now.  Sit tight :-)  (But please raise an issue to highlight your need)");
-        }
-        for(int n = 0; n < batchSize; n++) {
-            int imageOffset = n * numPlanes * imageSizeSquared;
-            for(int plane = 0; plane < numPlanes; plane++) {
-                float thisloss = - expectedValues[imageOffset + plane] * log(output[imageOffset + plane]);
-                loss += thisloss;
-            }
+    const int numElements = getOutputNumElements();
+    for(int i = 0; i < numElements; i++) {
+        if(expectedValues[i] != 0) {
+            loss += - expectedValues[i] * log(output[i]);
         }
     }
-    StatefulTimer::timeCheck("end SoftMaxLayer calcLoss");
     return loss;
 }
 // calculate partial deriv loss wrt our inputs, in other words, product of
 // (multinomial cross-entropy) loss derivative wrt our output, and
 // derivative of softmax wrt our inputs
 VIRTUAL void SoftMaxLayer::calcGradInputFromLabels(int const *labels) {
-//    cout << "softmaxlayer::calcerrors" << endl;
-    StatefulTimer::timeCheck("start SoftMaxLayer calcGradInputfromlabels");
-    if(perPlane) {
-        for(int n = 0; n < batchSize; n++) {
-            for(int plane = 0; plane < numPlanes; plane++) {
-                int imageOffset = (n * numPlanes + plane) * imageSizeSquared;
-                int label = labels[n * numPlanes + plane];
-                for(int i = 0; i < imageSizeSquared; i++) {
-                    gradInput[imageOffset + i] = output[imageOffset + i];
-                }
-                gradInput[imageOffset + label] -= 1;
-            }
-        }
-    } else {
-        // force imagesize of 1 for now
-        if(imageSize != 1) {
-            throw std::runtime_error("perColumn only supported for imagesize 1 for now.  Sit tight :-)  (But please raise an issue to highlight your need)");
-        }
-        for(int n = 0; n < batchSize; n++) {
-            int imageOffset = n * numPlanes * imageSizeSquared;
-            int label = labels[n];
-            for(int plane = 0; plane < numPlanes; plane++) {
-                gradInput[imageOffset + plane] = output[imageOffset + plane];
-            }
-            if(label >= numPlanes) {
-                throw runtime_error("Label " + toString(label) + " exceeds number of softmax planes " + toString(numPlanes) );
-            } else if(label < 0) {
-                throw runtime_error("Label " + toString(label) + " negative");
-            }
-            gradInput[imageOffset + label] -= 1;
-        }
-    }
-    StatefulTimer::timeCheck("end SoftMaxLayer calcGradInputfromlabels");
+    calcLabelStats(labels);
 }
 // calculate partial deriv loss wrt our inputs, in other words, product of
 // (multinomial cross-entropy) loss derivative wrt our output, and
 // derivative of softmax wrt our inputs
 VIRTUAL void SoftMaxLayer::calcGradInput(float const *expectedValues) {
-//    cout << "softmaxlayer::calcerrors" << endl;
-    StatefulTimer::timeCheck("start SoftMaxLayer calcGradInput");
-    if(perPlane) {
-        for(int n = 0; n < batchSize; n++) {
-            for(int plane = 0; plane < numPlanes; plane++) {
-                int imageOffset = (n * numPlanes + plane) * imageSizeSquared;
-                for(int i = 0; i < imageSizeSquared; i++) {
-                    int resultIndex = imageOffset + i;
-                    gradInput[resultIndex] = output[resultIndex] - expectedValues[resultIndex];
-                }
-            }
-        }
-    } else {
-        // force imagesize of 1 for now
-        if(imageSize != 1) {
-            throw std::runtime_error("perColumn only supported for imagesize 1 for now.  Sit tight :-)  (But please raise an issue to highlight your need)");
-        }
-        for(int n = 0; n < batchSize; n++) {
-            int imageOffset = n * numPlanes * imageSizeSquared;
-            for(int plane = 0; plane < numPlanes; plane++) {
-                int resultIndex = imageOffset + plane;
-                gradInput[resultIndex] = output[resultIndex] - expectedValues[resultIndex];
-            }
-        }
+    float const*output = getOutput();
+    const int numElements = getOutputNumElements();
+    for(int i = 0; i < numElements; i++) {
+        gradInput[i] = output[i] - expectedValues[i];
     }
-    StatefulTimer::timeCheck("end SoftMaxLayer calcGradInput");
+    gradInputWrapper->copyToDevice();
+    // gradInput no longer matches the last labels
+    labelStatsValid = false;
 }
 VIRTUAL int SoftMaxLayer::getNumLabelsPerExample() {
-    if(perPlane) {
-        return numPlanes;
-    } else {
-        return imageSizeSquared;
-    }
+    return groupsPerExample;
 }
 VIRTUAL int SoftMaxLayer::getPersistSize(int version) const {
     return 0;
 }
 VIRTUAL int SoftMaxLayer::calcNumRightFromLabels(int const*labels) {
-    StatefulTimer::timeCheck("start SoftMaxLayer calcNumRight");
-//    float *input = previousLayer->getOutput(); // just retrieve as host-side array for now
-    int numRight = 0;
-    if(perPlane) {
-        for(int n = 0; n < batchSize; n++) {
-            for(int plane = 0; plane < numPlanes; plane++) {
-                int imageOffset = (n * numPlanes + plane) * imageSizeSquared;
-                int label = labels[n * numPlanes + plane];
-                float thisMax = output[imageOffset + 0];
-                int iMax = 0;
-                for(int i = 1; i < imageSizeSquared; i++) {
-                    if(output[imageOffset + i] > thisMax) {
-                        thisMax = output[imageOffset + i];
-                        iMax = i;
-                    }
-                }
-                if(label == iMax) {
-//                    cout << "n " << n << " plane " << plane << " label " << label << endl;
-                    numRight++;
-                }
-            }
-        }
-    } else {
-        // force imagesize of 1 for now
-        if(imageSize != 1) {
-            throw std::runtime_error("perColumn only supported for imagesize 1 for now.  Sit tight :-)  (But please raise an issue to highlight your need)");
-        }
-        for(int n = 0; n < batchSize; n++) {
-            int imageOffset = n * numPlanes * imageSizeSquared;
-            int label = labels[n];
-            float thisMax = output[imageOffset + 0];
-            int iMax = 0;
-            for(int i = 1; i < numPlanes; i++) {
-                if(output[imageOffset + i] > thisMax) {
-                    thisMax = output[imageOffset + i];
-                    iMax = i;
-                }
-            }
-            if(label == iMax) {
-                numRight++;
-            }
-        }
-    }
-
-    StatefulTimer::timeCheck("start SoftMaxLayer calcNumRight");
+    calcLabelStats(labels);
     return numRight;
 }
 // for forward, we just need to apply the softmax activation. "just" :-P
 VIRTUAL void SoftMaxLayer::forward() {
-//    cout << "softmaxlayer::forward" << endl;
-    StatefulTimer::timeCheck("start SoftMaxLayer forward");
-    float *input = previousLayer->getOutput(); // just retrieve as host-side array for now
-    if(perPlane) {
-        for(int n = 0; n < batchSize; n++) {
-            for(int plane = 0; plane < numPlanes; plane++) {
-                int imageOffset = (n * numPlanes + plane) * imageSizeSquared;
-                float maxValue = input[imageOffset + 0];
-                for(int i = 1; i < imageSizeSquared; i++) {
-                    maxValue = std::max(maxValue, input[imageOffset + i]);
-                }
-                float denominator = 0;
-                for(int i = 0; i < imageSizeSquared; i++) {
-                    denominator += exp(input[imageOffset + i] - maxValue);
-                }
-                for(int i = 0; i < imageSizeSquared; i++) {
-                    output[imageOffset + i] = exp(input[imageOffset + i] - maxValue) / denominator;
-                }
-            }
-        }
+    CLWrapper *inputWrapper = 0;
+    if(previousLayer->hasOutputWrapper()) {
+        inputWrapper = previousLayer->getOutputWrapper();
     } else {
-        // force imagesize of 1 for now
-        if(imageSize != 1) {
-            throw std::runtime_error("perColumn only supported for imagesize 1 for now.  Sit tight :-)  (But please raise an issue to highlight your need)");
-        }
-        for(int n = 0; n < batchSize; n++) {
-            int imageOffset = n * numPlanes * imageSizeSquared;
-            // first get the max
-            float maxValue = input[imageOffset + 0]; // since we assume imagesize 1, this is correct
-            for(int plane = 1; plane < numPlanes; plane++) {
-                maxValue = std::max(maxValue, input[imageOffset + plane]);
-            }
-            // calculate sum, under this max
-            float denominator = 0;
-            for(int plane = 0; plane < numPlanes; plane++) {
-                denominator += exp(input[imageOffset + plane] - maxValue);
-            }
-            // now calc the softmaxes:
-            for(int plane = 0; plane < numPlanes; plane++) {
-                output[imageOffset + plane] = exp(input[imageOffset + plane] - maxValue) / denominator;
-            }
-        }
-    }
-    StatefulTimer::timeCheck("end SoftMaxLayer forward");
-}
-VIRTUAL void SoftMaxLayer::getLabels(int *labels) { // need to allocate labels array first, and have called 'forward' first
-    if(perPlane) {
-        throw std::runtime_error("getLabels doesnt work with 'perPlane' option currently, though it wouldnt be hard to add, so ask if you need");
+        inputWrapper = cl->wrap(previousLayer->getOutputNumElements(), previousLayer->getOutput());
+        inputWrapper->copyToDevice();
     }
-    if(imageSize != 1) {
-        throw std::runtime_error("perColumn only supported for imagesize 1 for now.  Sit tight :-)  (But please raise an issue to highlight your need)");
-    }
-    for(int n = 0; n < batchSize; n++) {
-        float *outputStack = output + n * numPlanes;
-        float highestProb = outputStack[0];
-        int bestPlane = 0;
-        for(int plane = 1; plane < numPlanes; plane++) {
-            if(outputStack[plane] > highestProb) {
-                bestPlane = plane;
-                highestProb = outputStack[plane];
-            }
-        }
-        labels[n] = bestPlane;
+    const int numGroups = batchSize * groupsPerExample;
+    int workgroupSize = sumWorkgroupSize;
+    int numWorkgroups = (numGroups + workgroupSize - 1) / workgroupSize;
+    kernelForward->in(numGroups)
+        ->in(inputWrapper)
+        ->out(outputWrapper);
+    kernelForward->run_1d(numWorkgroups * workgroupSize, workgroupSize);
+    if(!previousLayer->hasOutputWrapper()) {
+        delete inputWrapper;
     }
+    labelStatsValid = false;
+}
+// need to allocate labels array first, batchSize * getNumLabelsPerExample() ints, and have called 'forward' first
+// per-column, this is the most likely plane at each pixel; per-plane, the most likely pixel in each plane
+VIRTUAL void SoftMaxLayer::getLabels(int *labels) {
+    const int numGroups = batchSize * groupsPerExample;
+    int workgroupSize = sumWorkgroupSize;
+    int numWorkgroups = (numGroups + workgroupSize - 1) / workgroupSize;
+    kernelArgmax->in(numGroups)
+        ->in(outputWrapper)
+        ->out(labelsWrapper);
+    kernelArgmax->run_1d(numWorkgroups * workgroupSize, workgroupSize);
+    labelsWrapper->copyToHost();
+    memcpy(labels, this->labels, sizeof(int) * numGroups);
+    // this->labels no longer holds the labels the stats were calculated for
+    labelStatsValid = false;
 }
 // this seems to be handled by calcGradInput? So, just to a nop?
 // (cos this layer kind of combines loss layer and a 'normal' propagation layer)
@@ -17,17 +17,42 @@ class SoftMaxMaker;
 
 // this doesnt have any weights as such, just handles propagation, and backpropagation
 // it will have the same shape as the previous layer, ie same imagesize, same number of planes
-// the softmax will be per-plane, or maybe that is configurable?
+// the softmax is per-plane, or per-column (across planes, at each pixel), set on the maker
 // this will ALWAYS use multinomial logistic loss (ie cross-entropy loss), at least for now
+// forward, loss, num-right and gradInput all run on the device; for labels, only the
+// loss and num-right are copied back, once per batch
 class SoftMaxLayer : public LossLayer, public IAcceptsLabels {
 public:
     const bool perPlane;
     const int imageSize;
     const int numPlanes;
     const int imageSizeSquared;
+    EasyCL *const cl; // NOT owned by us
+
+    int groupSize;
+    int groupInner;
+    int groupsPerExample;
+    int sumWorkgroupSize;
 
     float *output;
     float *gradInput;
+    CLWrapper *outputWrapper;
+    CLWrapper *gradInputWrapper;
+    int *labels; // the labels the stats are for
+    CLWrapper *labelsWrapper;
+    float *groupLoss;
+    CLWrapper *groupLossWrapper;
+    float *groupRight;
+    CLWrapper *groupRightWrapper;
+    float results[2];
+    CLWrapper *resultsWrapper;
+    CLKernel *kernelForward;
+    CLKernel *kernelLabels;
+    CLKernel *kernelArgmax;
+    CLKernel *kernelSum;
+    bool labelStatsValid;
+    float loss;
+    int numRight;
     int allocatedSize;
     int batchSize;
 
@@ -41,8 +66,15 @@ public:
     VIRTUAL std::string getClassName() const;
     VIRTUAL float *getOutput();
     VIRTUAL float *getGradInput();
+    VIRTUAL bool hasOutputWrapper() const;
+    VIRTUAL CLWrapper *getOutputWrapper();
+    VIRTUAL bool providesGradInputWrapper() const;
+    VIRTUAL CLWrapper *getGradInputWrapper();
+    void setOutput(float const*newOutput);
+    void freeBuffers();
     VIRTUAL void setBatchSize(int batchSize);
     VIRTUAL int getBatchSize();
+    void calcLabelStats(int const *labels);
     VIRTUAL float calcLossFromLabels(int const *labels);
     VIRTUAL float calcLoss(float const *expectedValues);
     VIRTUAL void calcGradInputFromLabels(int const *labels);
@@ -51,7 +83,7 @@ public:
     VIRTUAL int getPersistSize(int version) const;
     VIRTUAL int calcNumRightFromLabels(int const*labels);
     VIRTUAL void forward();
-    VIRTUAL void getLabels(int *labels);  // need to allocate labels array first, and have called 'forward' first
+    VIRTUAL void getLabels(int *labels);
     VIRTUAL std::string asString() const;
 
     // [[[end]]]
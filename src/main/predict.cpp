@@ -4,6 +4,25 @@
 // v. 2.0. If a copy of the MPL was not distributed with this file, You can
 // obtain one at http://mozilla.org/MPL/2.0/.
 
+#include <thread>
+#include <chrono>
+#include <csignal>
+#include <cstring>
+#include <cerrno>
+#ifdef _WIN32
+// winsock2 has to come before anything that pulls in windows.h
+#include <winsock2.h>
+typedef SOCKET SocketHandle;
+#define closeSocket closesocket
+#else
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <netinet/in.h>
+#include <unistd.h>
+typedef int SocketHandle;
+#define INVALID_SOCKET -1
+#define closeSocket close
+#endif // _WIN32
 
 #include "DeepCL.h"
 #include "loss/SoftMaxLayer.h"
@@ -13,6 +32,9 @@
 #include <io.h>
 #endif // _WIN32
 #include "clblas/ClBlasInstance.h"
+#include "batch/InferenceQueue.h"
+#include "quantize/QuantizedNet.h"
+#include "util/ProfileScope.h"
 
 using namespace std;
 
@@ -21,7 +43,7 @@ using namespace std;
     options = [
         {'name': 'gpuIndex', 'type': 'int', 'description': 'gpu device index; default value is gpu if present, cpu otw.', 'default': -1, 'ispublicapi': True},
 
-        {'name': 'weightsFile', 'type': 'string', 'description': 'file to read weights from', 'default': 'weights.dat', 'ispublicapi': True},
+        {'name': 'weightsFile', 'type': 'string', 'description': 'file to read weights from; an int8 model from deepcl_quantize runs on the cpu', 'default': 'weights.dat', 'ispublicapi': True},
         # removing loadondemand for now, let's always load exactly one batch at a time for now
         # ('loadOnDemand', 'int', 'load data on demand [1|0]', 0, [0,1], True},
         {'name': 'batchSize', 'type': 'int', 'description': 'batch size', 'default': 128, 'ispublicapi': True},
@@ -31,7 +53,15 @@ using namespace std;
         {'name': 'outputFile', 'type': 'string', 'description': 'file to write outputs to, if empty, write to stdout', 'default': ''},
         {'name': 'outputLayer', 'type': 'int', 'description': 'layer to write output from, default -1 means: last layer', 'default': -1},
         {'name': 'writeLabels', 'type': 'int', 'description': 'write integer labels, instead of probabilities etc (default 0)', 'default': 0},
-        {'name': 'outputFormat', 'type': 'string', 'description': 'output format [binary|text]', 'default': 'text'}
+        {'name': 'outputFormat', 'type': 'string', 'description': 'output format [binary|text]', 'default': 'text'},
+        {'name': 'server', 'type': 'string', 'description': 'serve requests, on tcp:[port] (localhost only), or unix:[path], instead of reading inputfile or stdin', 'default': ''},
+        {'name': 'numPlanes', 'type': 'int', 'description': 'server mode: number of input planes', 'default': 0},
+        {'name': 'imageSize', 'type': 'int', 'description': 'server mode: input image size', 'default': 0},
+        {'name': 'maxLatency', 'type': 'float', 'description': 'server mode: max milliseconds a request waits for a fuller batch', 'default': 5.0},
+        {'name': 'statsInterval', 'type': 'int', 'description': 'server mode: seconds between latency and throughput reports, 0 means only at exit', 'default': 60},
+        {'name': 'shareBuffers', 'type': 'int', 'description': 'layers share a few output buffers, and skip gradient buffers, to use less device memory [1|0]', 'default': 1},
+        {'name': 'dumpTimings', 'type': 'int', 'description': 'write per-layer timings to stderr at exit [1|0]', 'default': 0},
+        {'name': 'profileTrace', 'type': 'string', 'description': 'write per-layer timings to this file, as a chrome trace, for chrome://tracing or perfetto', 'default': ''}
     ]
 *///]]]
 // [[[end]]]
@@ -52,6 +82,14 @@ public:
     int outputLayer;
     int writeLabels;
     string outputFormat;
+    string server;
+    int numPlanes;
+    int imageSize;
+    float maxLatency;
+    int statsInterval;
+    int shareBuffers;
+    int dumpTimings;
+    string profileTrace;
     // [[[end]]]
 
     Config() {
@@ -81,22 +119,371 @@ public:
         outputLayer = -1;
         writeLabels = 0;
         outputFormat = "text";
+        server = "";
+        numPlanes = 0;
+        imageSize = 0;
+        maxLatency = 5.0f;
+        statsInterval = 60;
+        shareBuffers = 1;
+        dumpTimings = 0;
+        profileTrace = "";
         // [[[end]]]
     }
 };
 
+//
+// ## Server mode
+//
+// Protocol, per connection: server first sends two int32s: the number of floats per
+// request (inputCubeSize), and the number of 4-byte values per reply (the output
+// layer's cube size, or 1, with writelabels=1).  Then the client sends any number of
+// requests, each one example of float32s, and gets one reply per request, in order,
+// as float32s, or an int32 label.  Native byte order, since it's local only.
+// Requests from all connections are coalesced into batches, by InferenceQueue
+//
+
+static volatile sig_atomic_t serverStopRequested = 0;
+
+static void requestServerStop(int signal) {
+    serverStopRequested = 1;
+}
+// returns false if the peer closed the connection first
+static bool readFully(SocketHandle socket, char *data, long numBytes) {
+    while(numBytes > 0) {
+        int numRead = recv(socket, data, (int)std::min(numBytes, 1l << 20), 0);
+        if(numRead <= 0) {
+            return false;
+        }
+        data += numRead;
+        numBytes -= numRead;
+    }
+    return true;
+}
+static bool writeFully(SocketHandle socket, char const*data, long numBytes) {
+    while(numBytes > 0) {
+        int numWritten = send(socket, data, (int)std::min(numBytes, 1l << 20), 0);
+        if(numWritten <= 0) {
+            return false;
+        }
+        data += numWritten;
+        numBytes -= numWritten;
+    }
+    return true;
+}
+static SocketHandle openServerSocket(string address) {
+    size_t colonPos = address.find(":");
+    string scheme = colonPos == string::npos ? "" : address.substr(0, colonPos);
+    string where = colonPos == string::npos ? "" : address.substr(colonPos + 1);
+    SocketHandle serverSocket = INVALID_SOCKET;
+    if(scheme == "tcp") {
+        serverSocket = socket(AF_INET, SOCK_STREAM, 0);
+        if(serverSocket == INVALID_SOCKET) {
+            throw runtime_error("server: couldnt create socket");
+        }
+        int reuse = 1;
+        setsockopt(serverSocket, SOL_SOCKET, SO_REUSEADDR, reinterpret_cast<char const*>(&reuse), sizeof(reuse));
+        struct sockaddr_in addr;
+        memset(&addr, 0, sizeof(addr));
+        addr.sin_family = AF_INET;
+        addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        addr.sin_port = htons((unsigned short)atoi(where));
+        if(bind(serverSocket, reinterpret_cast<struct sockaddr *>(&addr), sizeof(addr)) != 0) {
+            closeSocket(serverSocket);
+            throw runtime_error("server: couldnt bind to localhost port " + where);
+        }
+    #ifndef _WIN32
+    } else if(scheme == "unix") {
+        struct sockaddr_un addr;
+        memset(&addr, 0, sizeof(addr));
+        if(where == "" || where.size() >= sizeof(addr.sun_path)) {
+            throw runtime_error("server: unix socket path empty or too long: " + where);
+        }
+        serverSocket = socket(AF_UNIX, SOCK_STREAM, 0);
+        if(serverSocket == INVALID_SOCKET) {
+            throw runtime_error("server: couldnt create socket");
+        }
+        // left over from a previous run, that was killed
+        unlink(where.c_str());
+        addr.sun_family = AF_UNIX;
+        strcpy(addr.sun_path, where.c_str());
+        if(bind(serverSocket, reinterpret_cast<struct sockaddr *>(&addr), sizeof(addr)) != 0) {
+            closeSocket(serverSocket);
+            throw runtime_error("server: couldnt bind to " + where);
+        }
+    #endif
+    } else {
+        #ifdef _WIN32
+        throw runtime_error("server should be tcp:[port], not " + address);
+        #else
+        throw runtime_error("server should be tcp:[port] or unix:[path], not " + address);
+        #endif
+    }
+    if(listen(serverSocket, 64) != 0) {
+        closeSocket(serverSocket);
+        throw runtime_error("server: couldnt listen on " + address);
+    }
+    return serverSocket;
+}
+// one thread per connection, blocks in submit until its example has been run
+// labels: the output is a softmax label, sent as an int32, rather than as floats
+static void serveClient(SocketHandle client, InferenceQueue *queue, bool labels) {
+    int header[2];
+    header[0] = queue->getInputCubeSize();
+    header[1] = queue->getOutputCubeSize();
+    float *input = new float[header[0]];
+    float *output = new float[header[1]];
+    bool ok = writeFully(client, reinterpret_cast<char *>(header), sizeof(header));
+    try {
+        while(ok && readFully(client, reinterpret_cast<char *>(input), header[0] * 4l)) {
+            queue->submit(input, output);
+            if(labels) {
+                int label = (int)output[0];
+                ok = writeFully(client, reinterpret_cast<char *>(&label), 4);
+            } else {
+                ok = writeFully(client, reinterpret_cast<char *>(output), header[1] * 4l);
+            }
+        }
+    } catch(runtime_error &e) {
+        cout << "server: dropping connection: " << e.what() << endl;
+    }
+    closeSocket(client);
+    delete[] input;
+    delete[] output;
+}
+// the error from the last failed socket call, as the errno, or WSA, code, and its message
+static int lastSocketError() {
+    #ifdef _WIN32
+    return WSAGetLastError();
+    #else
+    return errno;
+    #endif
+}
+static string socketErrorString(int error) {
+    #ifdef _WIN32
+    return "error " + toString(error);
+    #else
+    return "errno " + toString(error) + " (" + strerror(error) + ")";
+    #endif
+}
+// while accept keeps failing, eg out of file descriptors, we wait a little longer
+// each time, up to a second, rather than spinning.  If the socket itself has gone,
+// we stop
+static void acceptClients(SocketHandle serverSocket, InferenceQueue *queue, bool labels) {
+    int backoffMilliseconds = 0;
+    while(true) {
+        SocketHandle client = accept(serverSocket, 0, 0);
+        if(client == INVALID_SOCKET) {
+            int error = lastSocketError();
+            if(serverStopRequested) {
+                return;
+            }
+            #ifdef _WIN32
+            bool socketGone = error == WSAENOTSOCK || error == WSAEINVAL;
+            bool retryNow = error == WSAEINTR || error == WSAECONNRESET;
+            #else
+            bool socketGone = error == EBADF || error == ENOTSOCK || error == EINVAL;
+            bool retryNow = error == EINTR || error == ECONNABORTED;
+            #endif
+            if(socketGone) {
+                cout << "server: accept failed, " << socketErrorString(error) << ", no longer accepting connections" << endl;
+                return;
+            }
+            if(retryNow) {
+                continue;
+            }
+            backoffMilliseconds = backoffMilliseconds == 0 ? 10 : std::min(1000, backoffMilliseconds * 2);
+            cout << "server: accept failed, " << socketErrorString(error) << ", retrying in " << backoffMilliseconds << "ms" << endl;
+            this_thread::sleep_for(chrono::milliseconds(backoffMilliseconds));
+            continue;
+        }
+        backoffMilliseconds = 0;
+        thread(serveClient, client, queue, labels).detach();
+    }
+}
+// runs until SIGINT or SIGTERM.  The net is run on the calling thread, always with
+// config.batchSize examples, and we only keep the outputs of the ones that were requested
+void serve(Config config, NeuralNet *net, int inputCubeSize) {
+    SoftMaxLayer *softMaxLayer = 0;
+    if(config.writeLabels) {
+        softMaxLayer = dynamic_cast< SoftMaxLayer *>(net->getLayer(config.outputLayer) );
+        if(softMaxLayer == 0) {
+            throw runtime_error("must choose softmaxlayer, if want to output labels");
+        }
+    }
+    const int outputCubeSize = config.writeLabels ? 1 : net->getLayer(config.outputLayer)->getOutputCubeSize();
+    int *labels = new int[config.batchSize];
+    InferenceBatchFunction runBatch = [&](int batchSize, float const*inputs, float *outputs) {
+        dynamic_cast<InputLayer *>(net->getLayer(0))->in(inputs);
+        for(int layerId = 0; layerId <= config.outputLayer; layerId++) {
+            ProfileScope profile(net->getCl(), Profiler::FORWARD, net, layerId);
+            net->getLayer(layerId)->forward();
+        }
+        if(softMaxLayer != 0) {
+            softMaxLayer->getLabels(labels);
+            for(int i = 0; i < batchSize; i++) {
+                outputs[i] = (float)labels[i];
+            }
+        } else {
+            memcpy(outputs, net->getLayer(config.outputLayer)->getOutput(), sizeof(float) * batchSize * outputCubeSize);
+        }
+    };
+    // connection threads might still be blocked on their sockets when we return, so this is never deleted
+    InferenceQueue *queue = new InferenceQueue(inputCubeSize, outputCubeSize, config.batchSize, config.maxLatency);
+
+    #ifdef _WIN32
+    WSADATA wsaData;
+    if(WSAStartup(MAKEWORD(2, 2), &wsaData) != 0) {
+        throw runtime_error("server: WSAStartup failed");
+    }
+    #else
+    // a client going away mid-reply should just drop its connection
+    signal(SIGPIPE, SIG_IGN);
+    #endif
+    signal(SIGINT, requestServerStop);
+    signal(SIGTERM, requestServerStop);
+    SocketHandle serverSocket = openServerSocket(config.server);
+    cout << "serving on " << config.server << ", inputcubesize " << inputCubeSize << " outputcubesize " << outputCubeSize
+        << " batchsize " << config.batchSize << " maxlatency " << config.maxLatency << "ms" << endl;
+    thread(acceptClients, serverSocket, queue, config.writeLabels != 0).detach();
+
+    double lastReportSeconds = LatencyStats::nowSeconds();
+    while(!serverStopRequested) {
+        queue->runOnce(runBatch, 100);
+        double nowSeconds = LatencyStats::nowSeconds();
+        if(config.statsInterval > 0 && nowSeconds - lastReportSeconds >= config.statsInterval) {
+            cout << queue->getStatsString() << endl;
+            lastReportSeconds = nowSeconds;
+        }
+    }
+    queue->stop();
+    cout << "server stopping. " << queue->getStatsString() << endl;
+    closeSocket(serverSocket);
+    #ifndef _WIN32
+    if(config.server.find("unix:") == 0) {
+        unlink(config.server.substr(5).c_str());
+    }
+    #endif
+    delete[] labels;
+}
+
+// weightsfile is an int8 model, written by deepcl_quantize: run it on the cpu
+// stdout might be carrying the predictions, so the summary goes to stderr
+void writeProfile(Config config) {
+    if(config.dumpTimings) {
+        cerr << Profiler::getSummary(false);
+    }
+    if(config.profileTrace != "") {
+        Profiler::writeChromeTrace(config.profileTrace);
+        cerr << "wrote profile trace to " << config.profileTrace << endl;
+    }
+}
+
+void predictQuantized(Config config, GenericLoaderv2 *loader, int N, int numPlanes, int imageSize, bool verbose) {
+    if(config.server != "") {
+        throw runtime_error("server mode not supported for quantized models");
+    }
+    if(config.outputLayer != -1) {
+        throw runtime_error("outputlayer not supported for quantized models, only the last layer");
+    }
+    QuantizedNet *net = QuantizedNet::load(config.weightsFile);
+    if(net->getInputPlanes() != numPlanes || net->getInputSize() != imageSize) {
+        throw runtime_error("input is " + toString(numPlanes) + "x" + toString(imageSize) + "x" + toString(imageSize)
+            + " but quantized model expects " + toString(net->getInputPlanes()) + "x" + toString(net->getInputSize())
+            + "x" + toString(net->getInputSize()));
+    }
+    if(verbose) cout << net->asString() << endl;
+    const long inputCubeSize = net->getInputCubeSize();
+    const int outputCubeSize = net->getOutputCubeSize();
+    float *inputData = new float[inputCubeSize * config.batchSize];
+    int *labels = new int[config.batchSize];
+    ostream *outFile = &cout;
+    if(config.outputFile == "") {
+        #ifdef _WIN32
+        _setmode(_fileno(stdout), _O_BINARY);
+        #endif
+    } else if(config.outputFormat == "text") {
+        outFile = new ofstream(config.outputFile, ios::out);
+    } else {
+        outFile = new ofstream(config.outputFile, ios::out | std::ios::binary);
+    }
+    int n = 0;
+    bool more = true;
+    if(config.inputFile == "") {
+        cin.read(reinterpret_cast< char * >(inputData), inputCubeSize * config.batchSize * 4l);
+        more = !cin.eof();
+    } else {
+        loader->load(inputData, 0, n, config.batchSize);
+    }
+    while(more) {
+        float const*output = net->forward(config.batchSize, inputData);
+        int numToWrite = config.batchSize;
+        if(N != -1 && N - n < numToWrite) {
+            numToWrite = N - n;
+        }
+        if(!config.writeLabels) {
+            if(config.outputFormat == "text") {
+                for(int i = 0; i < numToWrite; i++) {
+                    for(int f = 0; f < outputCubeSize; f++) {
+                        if(f > 0) {
+                            *outFile << " ";
+                        }
+                        *outFile << output[ i * outputCubeSize + f ];
+                    }
+                    *outFile << "\n";
+                }
+            } else {
+                outFile->write(reinterpret_cast<const char *>(output), numToWrite * outputCubeSize * 4l);
+            }
+        } else {
+            net->getLabels(labels);
+            if(config.outputFormat == "text") {
+                for(int i = 0; i < numToWrite; i++) {
+                    *outFile << labels[i] << "\n";
+                }
+            } else {
+                outFile->write(reinterpret_cast< char * >(labels), numToWrite * 4l);
+            }
+        }
+        outFile->flush();
+        n += config.batchSize;
+        if(config.inputFile == "") {
+            cin.read(reinterpret_cast< char * >(inputData), inputCubeSize * config.batchSize * 4l);
+            more = !cin.eof();
+        } else if(n < N) {
+            loader->load(inputData, 0, n, config.batchSize);
+        } else {
+            more = false;
+        }
+    }
+    if(config.outputFile != "") {
+        delete outFile;
+    }
+    delete[] inputData;
+    delete[] labels;
+    delete net;
+}
+
 void go(Config config) {
     bool verbose = true;
-    if(config.outputFile == "") {
+    if(config.outputFile == "" && config.server == "") {
         verbose = false;
     }
+    if(config.dumpTimings || config.profileTrace != "") {
+        Profiler::setEnabled(true);
+    }
 
     int N = -1;
     int numPlanes;
     int imageSize;
     int imageSizeCheck;
     GenericLoaderv2* loader = NULL;
-    if(config.inputFile == "") {
+    if(config.server != "") {
+        numPlanes = config.numPlanes;
+        imageSize = config.imageSize;
+        if(numPlanes <= 0 || imageSize <= 0) {
+            throw std::runtime_error("server mode needs numplanes and imagesize");
+        }
+    } else if(config.inputFile == "") {
         int dims[3];
         cin.read(reinterpret_cast< char * >(dims), 3 * 4l);
         numPlanes = dims[0];
@@ -116,6 +503,13 @@ void go(Config config) {
 
     const long inputCubeSize = numPlanes * imageSize * imageSize ;
 
+    if(QuantizedNet::isQuantizedFile(config.weightsFile)) {
+        predictQuantized(config, loader, N, numPlanes, imageSize, verbose);
+        writeProfile(config);
+        if(loader != NULL) delete loader;
+        return;
+    }
+
     //
     // ## Set up the Network
     //
@@ -167,9 +561,28 @@ void go(Config config) {
     if(verbose) {
         net->print();
     }
+    if(config.shareBuffers) {
+        net->planInference(config.outputLayer);
+    }
     net->setBatchSize(config.batchSize);
+    if(verbose && config.shareBuffers) cout << net->getInferencePlanString() << endl;
     if(verbose) cout << "batchSize: " << config.batchSize << endl;
 
+    if(config.server != "") {
+        if(config.outputLayer == -1) {
+            config.outputLayer = net->getNumLayers() - 1;
+        }
+        if(config.outputLayer < 0 || config.outputLayer >= net->getNumLayers()) {
+            throw runtime_error("outputLayer should be the layer number of one of the layers in the network");
+        }
+        serve(config, net, inputCubeSize);
+        cl->finish();
+        writeProfile(config);
+        delete weightsInitializer;
+        delete net;
+        delete cl;
+        return;
+    }
 
     //
     // ## All is set up now
@@ -219,9 +632,8 @@ void go(Config config) {
         }
         dynamic_cast<InputLayer *>(net->getLayer(0))->in(inputData);
         for(int layerId = 0; layerId <= config.outputLayer; layerId++) {
-            StatefulTimer::setPrefix("layer" + toString(layerId) + " ");
+            ProfileScope profile(cl, Profiler::FORWARD, net, layerId);
             net->getLayer(layerId)->forward();
-            StatefulTimer::setPrefix("");
         }
 
         if(!config.writeLabels) {
@@ -281,6 +693,8 @@ void go(Config config) {
         delete outFile;
     }
     if(loader != NULL) delete loader;
+    cl->finish();
+    writeProfile(config);
 
     delete[] inputData;
     delete[] labels;
@@ -312,7 +726,7 @@ void printUsage(char *argv[], Config config) {
     // generated using cog:
     cout << "public api, shouldnt change within major version:" << endl;
     cout << "    gpuindex=[gpu device index; default value is gpu if present, cpu otw.] (" << config.gpuIndex << ")" << endl;
-    cout << "    weightsfile=[file to read weights from] (" << config.weightsFile << ")" << endl;
+    cout << "    weightsfile=[file to read weights from; an int8 model from deepcl_quantize runs on the cpu] (" << config.weightsFile << ")" << endl;
     cout << "    batchsize=[batch size] (" << config.batchSize << ")" << endl;
     cout << "" << endl; 
     cout << "unstable, might change within major version:" << endl; 
@@ -321,6 +735,14 @@ void printUsage(char *argv[], Config config) {
     cout << "    outputlayer=[layer to write output from, default -1 means: last layer] (" << config.outputLayer << ")" << endl;
     cout << "    writelabels=[write integer labels, instead of probabilities etc (default 0)] (" << config.writeLabels << ")" << endl;
     cout << "    outputformat=[output format [binary|text]] (" << config.outputFormat << ")" << endl;
+    cout << "    server=[serve requests, on tcp:[port] (localhost only), or unix:[path], instead of reading inputfile or stdin] (" << config.server << ")" << endl;
+    cout << "    numplanes=[server mode: number of input planes] (" << config.numPlanes << ")" << endl;
+    cout << "    imagesize=[server mode: input image size] (" << config.imageSize << ")" << endl;
+    cout << "    maxlatency=[server mode: max milliseconds a request waits for a fuller batch] (" << config.maxLatency << ")" << endl;
+    cout << "    statsinterval=[server mode: seconds between latency and throughput reports, 0 means only at exit] (" << config.statsInterval << ")" << endl;
+    cout << "    sharebuffers=[layers share a few output buffers, and skip gradient buffers, to use less device memory [1|0]] (" << config.shareBuffers << ")" << endl;
+    cout << "    dumptimings=[write per-layer timings to stderr at exit [1|0]] (" << config.dumpTimings << ")" << endl;
+    cout << "    profiletrace=[write per-layer timings to this file, as a chrome trace, for chrome://tracing or perfetto] (" << config.profileTrace << ")" << endl;
     // [[[end]]]
 }
 
@@ -370,6 +792,22 @@ int main(int argc, char *argv[]) {
                 config.writeLabels = atoi(value);
             } else if(key == "outputformat") {
                 config.outputFormat = (value);
+            } else if(key == "server") {
+                config.server = (value);
+            } else if(key == "numplanes") {
+                config.numPlanes = atoi(value);
+            } else if(key == "imagesize") {
+                config.imageSize = atoi(value);
+            } else if(key == "maxlatency") {
+                config.maxLatency = atof(value);
+            } else if(key == "statsinterval") {
+                config.statsInterval = atoi(value);
+            } else if(key == "sharebuffers") {
+                config.shareBuffers = atoi(value);
+            } else if(key == "dumptimings") {
+                config.dumpTimings = atoi(value);
+            } else if(key == "profiletrace") {
+                config.profileTrace = (value);
             // [[[end]]]
             } else {
                 cout << endl;
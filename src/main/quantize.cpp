@@ -0,0 +1,294 @@
+// Copyright Hugh Perkins 2015 hughperkins at gmail
+//
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file, You can
+// obtain one at http://mozilla.org/MPL/2.0/.
+
+#include <algorithm>
+
+#include "DeepCL.h"
+#include "util/LatencyStats.h"
+#include "quantize/ActivationCalibrator.h"
+#include "quantize/QuantizedNet.h"
+#include "quantize/QuantizationReport.h"
+
+using namespace std;
+
+/* [[[cog
+    # These are used in the later cog sections in this file:
+    options = [
+        {'name': 'gpuIndex', 'type': 'int', 'description': 'gpu device index; default value is gpu if present, cpu otw.', 'default': -1, 'ispublicapi': True},
+        {'name': 'weightsFile', 'type': 'string', 'description': 'float weights file to quantize, from deepcl_train', 'default': 'weights.dat', 'ispublicapi': True},
+        {'name': 'outputFile', 'type': 'string', 'description': 'file to write the int8 model to', 'default': 'weights.q8', 'ispublicapi': True},
+        {'name': 'calibrationFile', 'type': 'string', 'description': 'sample data, to calibrate the range of each layer', 'default': '', 'ispublicapi': True},
+        {'name': 'calibrationExamples', 'type': 'int', 'description': 'number of calibration examples to use', 'default': 1024, 'ispublicapi': True},
+        {'name': 'validateFile', 'type': 'string', 'description': 'data to compare the int8 and float models on, if empty, use calibrationfile', 'default': '', 'ispublicapi': True},
+        {'name': 'validateExamples', 'type': 'int', 'description': 'number of examples to compare on, 0 means none', 'default': 1024, 'ispublicapi': True},
+        {'name': 'batchSize', 'type': 'int', 'description': 'batch size', 'default': 128, 'ispublicapi': True}
+    ]
+*///]]]
+// [[[end]]]
+
+class Config {
+public:
+    /* [[[cog
+        cog.outl('// generated using cog:')
+        for option in options:
+            cog.outl(option['type'] + ' ' + option['name'] + ';')
+    */// ]]]
+    // generated using cog:
+    int gpuIndex;
+    string weightsFile;
+    string outputFile;
+    string calibrationFile;
+    int calibrationExamples;
+    string validateFile;
+    int validateExamples;
+    int batchSize;
+    // [[[end]]]
+
+    Config() {
+        /* [[[cog
+            cog.outl('// generated using cog:')
+            for option in options:
+                defaultString = ''
+                default = option['default']
+                type = option['type']
+                if type == 'string':
+                    defaultString = '"' + default + '"'
+                elif type == 'int':
+                    defaultString = str(default)
+                elif type == 'float':
+                    defaultString = str(default)
+                    if '.' not in defaultString:
+                        defaultString += '.0'
+                    defaultString += 'f'
+                cog.outl(option['name'] + ' = ' + defaultString + ';')
+        */// ]]]
+        // generated using cog:
+        gpuIndex = -1;
+        weightsFile = "weights.dat";
+        outputFile = "weights.q8";
+        calibrationFile = "";
+        calibrationExamples = 1024;
+        validateFile = "";
+        validateExamples = 1024;
+        batchSize = 128;
+        // [[[end]]]
+    }
+};
+
+NeuralNet *loadNet(EasyCL *cl, string weightsFile, int numPlanes, int imageSize) {
+    string netDef;
+    if(!WeightsPersister::loadConfigString(weightsFile, netDef)) {
+        throw runtime_error("Cannot load network definition from " + weightsFile);
+    }
+    NeuralNet *net = new NeuralNet(cl);
+    net->addLayer(InputLayerMaker::instance()->numPlanes(numPlanes)->imageSize(imageSize));
+    net->addLayer(NormalizationLayerMaker::instance()->translate(0.0f)->scale(1.0f)); // read from weights file
+    OriginalInitializer weightsInitializer;
+    if(!NetdefToNet::createNetFromNetdef(net, netDef, &weightsInitializer)) {
+        delete net;
+        throw runtime_error("Cannot create network from netdef " + netDef);
+    }
+    int ignI;
+    float ignF;
+    if(!WeightsPersister::loadWeights(weightsFile, string("netDef=") + netDef, net, &ignI, &ignI, &ignF, &ignI, &ignF)) {
+        delete net;
+        throw runtime_error("Cannot load network weights from " + weightsFile);
+    }
+    return net;
+}
+
+void go(Config config) {
+    if(config.calibrationFile == "") {
+        throw runtime_error("calibrationfile not specified");
+    }
+    GenericLoaderv2 loader(config.calibrationFile);
+    const int numPlanes = loader.getPlanes();
+    const int imageSize = loader.getImageSize();
+    const int inputCubeSize = numPlanes * imageSize * imageSize;
+    // checked before anything else is allocated, so only this needs deleting if it fails
+    GenericLoaderv2 *validateLoader = &loader;
+    if(config.validateFile != "") {
+        validateLoader = new GenericLoaderv2(config.validateFile);
+        if(validateLoader->getPlanes() != numPlanes || validateLoader->getImageSize() != imageSize) {
+            delete validateLoader;
+            throw runtime_error("validatefile dimensions dont match calibrationfile");
+        }
+    }
+
+    EasyCL *cl = 0;
+    if(config.gpuIndex >= 0) {
+        cl = EasyCL::createForIndexedGpu(config.gpuIndex);
+    } else {
+        cl = EasyCL::createForFirstGpuOtherwiseCpu();
+    }
+    ClBlasInstance blasInstance;
+    NeuralNet *net = loadNet(cl, config.weightsFile, numPlanes, imageSize);
+    net->print();
+    net->setTraining(false);
+    float *inputData = new float[config.batchSize * inputCubeSize];
+    int *labels = new int[config.batchSize];
+
+    //
+    // ## Calibrate, and quantize
+    //
+
+    ActivationCalibrator calibrator;
+    const int numCalibration = std::min(loader.getN(), config.calibrationExamples);
+    for(int start = 0; start < numCalibration; start += config.batchSize) {
+        int thisBatchSize = std::min(config.batchSize, numCalibration - start);
+        net->setBatchSize(thisBatchSize);
+        loader.load(inputData, 0, start, thisBatchSize);
+        net->forward(inputData);
+        calibrator.observe(net, thisBatchSize);
+    }
+    cout << "calibrated on " << calibrator.getNumExamples() << " examples" << endl;
+    QuantizedNet *quantized = QuantizedNet::quantize(net, &calibrator);
+    quantized->save(config.outputFile);
+    delete quantized;
+    cout << "wrote " << config.outputFile << endl;
+
+    //
+    // ## Compare int8 against float, on the model as saved
+    //
+
+    quantized = QuantizedNet::load(config.outputFile);
+    cout << quantized->asString() << endl;
+    cout << "weights: float " << WeightsPersister::getTotalNumWeights(net) * 4 << " bytes, int8 "
+        << quantized->getWeightsBytes() << " bytes" << endl;
+    QuantizationReport report;
+    double floatSeconds = 0;
+    double quantizedSeconds = 0;
+    const int outputCubeSize = quantized->getOutputCubeSize();
+    const int numValidate = std::min(validateLoader->getN(), config.validateExamples);
+    for(int start = 0; start < numValidate; start += config.batchSize) {
+        int thisBatchSize = std::min(config.batchSize, numValidate - start);
+        net->setBatchSize(thisBatchSize);
+        validateLoader->load(inputData, labels, start, thisBatchSize);
+        double startSeconds = LatencyStats::nowSeconds();
+        net->forward(inputData);
+        float const*floatOutput = net->getOutput();
+        double floatDoneSeconds = LatencyStats::nowSeconds();
+        float const*quantizedOutput = quantized->forward(thisBatchSize, inputData);
+        double quantizedDoneSeconds = LatencyStats::nowSeconds();
+        floatSeconds += floatDoneSeconds - startSeconds;
+        quantizedSeconds += quantizedDoneSeconds - floatDoneSeconds;
+        report.add(thisBatchSize, outputCubeSize, floatOutput, quantizedOutput, labels);
+    }
+    if(report.getNumExamples() > 0) {
+        cout << report.toString() << endl;
+        cout << "examples/sec: float " << (report.getNumExamples() / floatSeconds) << " int8 (cpu) "
+            << (report.getNumExamples() / quantizedSeconds) << endl;
+    }
+
+    if(validateLoader != &loader) {
+        delete validateLoader;
+    }
+    delete[] inputData;
+    delete[] labels;
+    delete quantized;
+    delete net;
+    delete cl;
+}
+
+void printUsage(char *argv[], Config config) {
+    cout << "Usage: " << argv[0] << " [key]=[value] [[key]=[value]] ..." << endl;
+    cout << endl;
+    cout << "Possible key=value pairs:" << endl;
+    /* [[[cog
+        cog.outl('// generated using cog:')
+        cog.outl('cout << "public api, shouldnt change within major version:" << endl;')
+        for option in options:
+            name = option['name']
+            description = option['description']
+            if 'ispublicapi' in option and option['ispublicapi']:
+                cog.outl('cout << "    ' + name.lower() + '=[' + description + '] (" << config.' + name + ' << ")" << endl;')
+        cog.outl('cout << "" << endl; ')
+        cog.outl('cout << "unstable, might change within major version:" << endl; ')
+        for option in options:
+            if 'ispublicapi' not in option or not option['ispublicapi']:
+                name = option['name']
+                description = option['description']
+                cog.outl('cout << "    ' + name.lower() + '=[' + description + '] (" << config.' + name + ' << ")" << endl;')
+    *///]]]
+    // generated using cog:
+    cout << "public api, shouldnt change within major version:" << endl;
+    cout << "    gpuindex=[gpu device index; default value is gpu if present, cpu otw.] (" << config.gpuIndex << ")" << endl;
+    cout << "    weightsfile=[float weights file to quantize, from deepcl_train] (" << config.weightsFile << ")" << endl;
+    cout << "    outputfile=[file to write the int8 model to] (" << config.outputFile << ")" << endl;
+    cout << "    calibrationfile=[sample data, to calibrate the range of each layer] (" << config.calibrationFile << ")" << endl;
+    cout << "    calibrationexamples=[number of calibration examples to use] (" << config.calibrationExamples << ")" << endl;
+    cout << "    validatefile=[data to compare the int8 and float models on, if empty, use calibrationfile] (" << config.validateFile << ")" << endl;
+    cout << "    validateexamples=[number of examples to compare on, 0 means none] (" << config.validateExamples << ")" << endl;
+    cout << "    batchsize=[batch size] (" << config.batchSize << ")" << endl;
+    cout << "" << endl; 
+    cout << "unstable, might change within major version:" << endl; 
+    // [[[end]]]
+}
+
+int main(int argc, char *argv[]) {
+    Config config;
+    if(argc == 2 && (string(argv[1]) == "--help" || string(argv[1]) == "--?" || string(argv[1]) == "-?" || string(argv[1]) == "-h") ) {
+        printUsage(argv, config);
+    }
+    for(int i = 1; i < argc; i++) {
+        vector<string> splitkeyval = split(argv[i], "=");
+        if(splitkeyval.size() != 2) {
+          cout << "Usage: " << argv[0] << " [key]=[value] [[key]=[value]] ..." << endl;
+          exit(1);
+        } else {
+            string key = splitkeyval[0];
+            string value = splitkeyval[1];
+            /* [[[cog
+                cog.outl('// generated using cog:')
+                cog.outl('if(false) {')
+                for option in options:
+                    name = option['name']
+                    type = option['type']
+                    cog.outl('} else if(key == "' + name.lower() + '") {')
+                    converter = '';
+                    if type == 'int':
+                        converter = 'atoi';
+                    elif type == 'float':
+                        converter = 'atof';
+                    cog.outl('    config.' + name + ' = ' + converter + '(value);')
+            */// ]]]
+            // generated using cog:
+            if(false) {
+            } else if(key == "gpuindex") {
+                config.gpuIndex = atoi(value);
+            } else if(key == "weightsfile") {
+                config.weightsFile = (value);
+            } else if(key == "outputfile") {
+                config.outputFile = (value);
+            } else if(key == "calibrationfile") {
+                config.calibrationFile = (value);
+            } else if(key == "calibrationexamples") {
+                config.calibrationExamples = atoi(value);
+            } else if(key == "validatefile") {
+                config.validateFile = (value);
+            } else if(key == "validateexamples") {
+                config.validateExamples = atoi(value);
+            } else if(key == "batchsize") {
+                config.batchSize = atoi(value);
+            // [[[end]]]
+            } else {
+                cout << endl;
+                cout << "Error: key '" << key << "' not recognised" << endl;
+                cout << endl;
+                printUsage(argv, config);
+                cout << endl;
+                return -1;
+            }
+        }
+    }
+    try {
+        go(config);
+    } catch(runtime_error e) {
+        cout << "Something went wrong: " << e.what() << endl;
+        return -1;
+    }
+}
+
@@ -11,6 +11,7 @@
 #include "DeepCL.h"
 //#include "test/Sampler.h"  // TODO: REMOVE THIS
 #include "clblas/ClBlasInstance.h"
+#include "util/Workspace.h"
 
 using namespace std;
 
@@ -32,13 +33,22 @@ using namespace std;
         ('loadWeights', 'int', 'load weights from file at startup?', 0, True),
         ('weightsFile', 'string', 'file to write weights to','weights.dat', True),
         ('writeWeightsInterval', 'float', 'write weights every this many minutes', 0, True),
+        ('weightsFp16', 'int', 'store weights as fp16, halving the weights file; meant for deploying, since training resumed from it has lost precision [1|0]', 0, False),
         ('normalization', 'string', '[stddev|maxmin]', 'stddev', True),
         ('normalizationNumStds', 'float', 'with stddev normalization, how many stddevs from mean is 1?', 2.0, True),
         ('dumpTimings', 'int', 'dump detailed timings each epoch? [1|0]', 0, True),
+        ('profileTrace', 'string', 'write per-layer timings to this file, as a chrome trace, for chrome://tracing or perfetto', '', False),
         ('multiNet', 'int', 'number of Mcdnn columns to train', 1, True),
+        ('replicas', 'int', 'data-parallel: split each batch across this many copies of the net, each on its own device or context', 1, False),
+        ('replicaGpuIndices', 'string', 'data-parallel: comma-separated gpu indices of the replicas, eg 0,1 (default: all on gpuindex)', '', False),
         ('loadOnDemand', 'int', 'load data on demand [1|0]', 0, True),
         ('fileReadBatches', 'int', 'how many batches to read from file each time? (for loadondemand=1)', 50, True),
+        ('prefetchDepth', 'int', 'for loadondemand=1, how many file batches to hold in memory; 2 loads the next while training on the current, 1 disables prefetching', 2, False),
+        ('shuffleBlocks', 'int', 'for loadondemand=1, shuffle the training examples each epoch: each file batch is read as this many blocks, from random places in the file, then shuffled in memory; 0 reads in file order', 0, False),
+        ('shuffleSeed', 'int', 'seed for shuffleblocks; a resumed run needs the same seed to carry on in the same order', 0, False),
         ('normalizationExamples', 'int', 'number of examples to read to determine normalization parameters', 10000, True),
+        ('normalizationSampling', 'string', 'which examples normalizationexamples reads: first, the first ones, or strided, chunks spread over the whole training file [first|strided]', 'first', False),
+        ('normalizationCache', 'int', 'cache normalization statistics in a .normstats file next to the training file, so later runs skip reading the examples [1|0]', 1, False),
         ('weightsInitializer', 'string', 'initializer for weights, choices: original, uniform (default: original)', 'original', True),
         ('initialWeights', 'float', 'for uniform initializer, weights will be initialized randomly within range -initialweights to +initialweights, divided by fanin, (default: 1.0f)', 1.0, False),
         ('trainer', 'string', 'which trainer, sgd, anneal, nesterov, adagrad, rmsprop, or adadelta (default: sgd)', 'sgd', True),
@@ -72,13 +82,22 @@ public:
     int loadWeights;
     string weightsFile;
     float writeWeightsInterval;
+    int weightsFp16;
     string normalization;
     float normalizationNumStds;
     int dumpTimings;
+    string profileTrace;
     int multiNet;
+    int replicas;
+    string replicaGpuIndices;
     int loadOnDemand;
     int fileReadBatches;
+    int prefetchDepth;
+    int shuffleBlocks;
+    int shuffleSeed;
     int normalizationExamples;
+    string normalizationSampling;
+    int normalizationCache;
     string weightsInitializer;
     float initialWeights;
     string trainer;
@@ -119,13 +138,22 @@ public:
         loadWeights = 0;
         weightsFile = "weights.dat";
         writeWeightsInterval = 0.0f;
+        weightsFp16 = 0;
         normalization = "stddev";
         normalizationNumStds = 2.0f;
         dumpTimings = 0;
+        profileTrace = "";
         multiNet = 1;
+        replicas = 1;
+        replicaGpuIndices = "";
         loadOnDemand = 0;
         fileReadBatches = 50;
+        prefetchDepth = 2;
+        shuffleBlocks = 0;
+        shuffleSeed = 0;
         normalizationExamples = 10000;
+        normalizationSampling = "first";
+        normalizationCache = 1;
         weightsInitializer = "original";
         initialWeights = 1.0f;
         trainer = "sgd";
@@ -152,6 +180,46 @@ public:
     }
 };
 
+Trainer *createTrainer(Config config, EasyCL *cl) {
+    Trainer *trainer = 0;
+    if(toLower(config.trainer) == "sgd") {
+        SGD *sgd = new SGD(cl);
+        sgd->setLearningRate(config.learningRate);
+        sgd->setMomentum(config.momentum);
+        sgd->setWeightDecay(config.weightDecay);
+        trainer = sgd;
+    } else if(toLower(config.trainer) == "anneal") {
+        Annealer *annealer = new Annealer(cl);
+        annealer->setLearningRate(config.learningRate);
+        annealer->setAnneal(config.anneal);
+        trainer = annealer;
+    } else if(toLower(config.trainer) == "nesterov") {
+        Nesterov *nesterov = new Nesterov(cl);
+        nesterov->setLearningRate(config.learningRate);
+        nesterov->setMomentum(config.momentum);
+        trainer = nesterov;
+    } else if(toLower(config.trainer) == "adagrad") {
+        Adagrad *adagrad = new Adagrad(cl);
+        adagrad->setLearningRate(config.learningRate);
+        trainer = adagrad;
+    } else if(toLower(config.trainer) == "rmsprop") {
+        Rmsprop *rmsprop = new Rmsprop(cl);
+        rmsprop->setLearningRate(config.learningRate);
+        trainer = rmsprop;
+    } else if(toLower(config.trainer) == "adadelta") {
+        Adadelta *adadelta = new Adadelta(cl, config.rho);
+        trainer = adadelta;
+    } else {
+        cout << "trainer " << config.trainer << " unknown." << endl;
+    }
+    return trainer;
+}
+EasyCL *createCl(int gpuIndex) {
+    if(gpuIndex >= 0) {
+        return EasyCL::createForIndexedGpu(gpuIndex);
+    }
+    return EasyCL::createForFirstGpuOtherwiseCpu();
+}
 void go(Config config) {
     Timer timer;
 
@@ -160,18 +228,21 @@ void go(Config config) {
     int numPlanes;
     int imageSize;
 
-    float *trainData = 0;
-    float *testData = 0;
+    // kept as uint8, as loaded; NormalizationLayer normalizes each batch on the device.
+    // Except packed files that pack-dataset already normalized, which hold floats
+    unsigned char *trainData = 0;
+    unsigned char *testData = 0;
+    float *trainFloatData = 0;
+    float *testFloatData = 0;
     int *trainLabels = 0;
     int *testLabels = 0;
 
     int trainAllocateN = 0;
     int testAllocateN = 0;
 
-    if(config.dumpTimings) {
-        StatefulTimer::setEnabled(true);
+    if(config.dumpTimings || config.profileTrace != "") {
+        Profiler::setEnabled(true);
     }
-    cout << "Statefultimer enabled: " << StatefulTimer::enabled << endl;
 
 //    int totalLinearSize;
     GenericLoaderv2 trainLoader(config.dataDir + "/" + config.trainFile);
@@ -182,18 +253,31 @@ void go(Config config) {
     Ntrain = config.numTrain == -1 ? Ntrain : config.numTrain;
 //    long allocateSize = (long)Ntrain * numPlanes * imageSize * imageSize;
     cout << "Ntrain " << Ntrain << " numPlanes " << numPlanes << " imageSize " << imageSize << endl;
+    const bool floatData = trainLoader.getIsFloat();
     if(config.loadOnDemand) {
         trainAllocateN = config.batchSize; // can improve this later
     } else {
         trainAllocateN = Ntrain;
     }
-    trainData = new float[ (long)trainAllocateN * numPlanes * imageSize * imageSize ];
     trainLabels = new int[trainAllocateN];
+    if(!config.loadOnDemand && floatData) {
+        trainFloatData = new float[ (long)trainAllocateN * numPlanes * imageSize * imageSize ];
+    } else if(!config.loadOnDemand) {
+        trainData = new unsigned char[ (long)trainAllocateN * numPlanes * imageSize * imageSize ];
+    }
     if(!config.loadOnDemand && Ntrain > 0) {
-        trainLoader.load(trainData, trainLabels, 0, Ntrain);
+        if(floatData) {
+            trainLoader.load(trainFloatData, trainLabels, 0, Ntrain);
+        } else {
+            trainLoader.load(trainData, trainLabels, 0, Ntrain);
+        }
     }
 
     GenericLoaderv2 testLoader(config.dataDir + "/" + config.validateFile);
+    if(testLoader.getIsFloat() != floatData) {
+        cout << "Error: trainfile and validatefile should both be normalized float packed files, or neither" << endl;
+        return;
+    }
     Ntest = testLoader.getN();
     numPlanes = testLoader.getPlanes();
     imageSize = testLoader.getImageSize();
@@ -203,10 +287,18 @@ void go(Config config) {
     } else {
         testAllocateN = Ntest;
     }
-    testData = new float[ (long)testAllocateN * numPlanes * imageSize * imageSize ];
     testLabels = new int[testAllocateN]; 
+    if(!config.loadOnDemand && floatData) {
+        testFloatData = new float[ (long)testAllocateN * numPlanes * imageSize * imageSize ];
+    } else if(!config.loadOnDemand) {
+        testData = new unsigned char[ (long)testAllocateN * numPlanes * imageSize * imageSize ];
+    }
     if(!config.loadOnDemand && Ntest > 0) {
-        testLoader.load(testData, testLabels, 0, Ntest);
+        if(floatData) {
+            testLoader.load(testFloatData, testLabels, 0, Ntest);
+        } else {
+            testLoader.load(testData, testLabels, 0, Ntest);
+        }
     }
     cout << "Ntest " << Ntest << " Ntest" << endl;
     
@@ -216,38 +308,45 @@ void go(Config config) {
     float translate;
     float scale;
     int normalizationExamples = config.normalizationExamples > Ntrain ? Ntrain : config.normalizationExamples;
-    if(!config.loadOnDemand) {
-        if(config.normalization == "stddev") {
-            float mean, stdDev;
-            NormalizationHelper::getMeanAndStdDev(trainData, normalizationExamples * inputCubeSize, &mean, &stdDev);
-            cout << " image stats mean " << mean << " stdDev " << stdDev << endl;
-            translate = - mean;
-            scale = 1.0f / stdDev / config.normalizationNumStds;
-        } else if(config.normalization == "maxmin") {
-            float mean, stdDev;
-            NormalizationHelper::getMinMax(trainData, normalizationExamples * inputCubeSize, &mean, &stdDev);
-            translate = - mean;
-            scale = 1.0f / stdDev;
+    if(config.normalization != "stddev" && config.normalization != "maxmin") {
+        cout << "Error: Unknown normalization: " << config.normalization << endl;
+        return;
+    }
+    if(config.normalizationSampling != "first" && config.normalizationSampling != "strided") {
+        cout << "Error: Unknown normalizationsampling: " << config.normalizationSampling << endl;
+        return;
+    }
+    if(floatData) {
+        // pack-dataset normalized these already, so the NormalizationLayer passes them through
+        cout << "float packed files are already normalized, skipping normalization" << endl;
+        translate = 0.0f;
+        scale = 1.0f;
+    } else {
+        bool stridedSampling = config.normalizationSampling == "strided";
+        // the same chunks whether the data is in memory or not, so the cached statistics
+        // are the same either way
+        int normalizationChunkSize = config.batchSize * config.fileReadBatches;
+        string trainFilepath = config.dataDir + "/" + config.trainFile;
+        string statsCacheFilepath = NormalizationStats::getCacheFilepath(trainFilepath);
+        string statsKey = NormalizationStats::getCacheKey(trainFilepath, Ntrain, inputCubeSize, normalizationExamples, normalizationChunkSize, stridedSampling);
+        NormalizationStats stats;
+        if(config.normalizationCache && stats.readCache(statsCacheFilepath, statsKey)) {
+            cout << "read normalization statistics from " << statsCacheFilepath << endl;
         } else {
-            cout << "Error: Unknown normalization: " << config.normalization << endl;
-            return;
+            if(config.loadOnDemand) {
+                stats = NormalizationStats::compute(&trainLoader, Ntrain, normalizationExamples, normalizationChunkSize, stridedSampling, config.prefetchDepth);
+            } else {
+                stats = NormalizationStats::compute(trainData, Ntrain, inputCubeSize, normalizationExamples, normalizationChunkSize, stridedSampling);
+            }
+            if(config.normalizationCache) {
+                stats.writeCache(statsCacheFilepath, statsKey);
+            }
         }
-    } else {
+        cout << " image stats " << stats.toString() << endl;
         if(config.normalization == "stddev") {
-            float mean, stdDev;
-            NormalizeGetStdDev normalizeGetStdDev(trainData, trainLabels); 
-            BatchProcessv2::run(&trainLoader, 0, config.batchSize, normalizationExamples, inputCubeSize, &normalizeGetStdDev);
-            normalizeGetStdDev.calcMeanStdDev(&mean, &stdDev);
-            cout << " image stats mean " << mean << " stdDev " << stdDev << endl;
-            translate = - mean;
-            scale = 1.0f / stdDev / config.normalizationNumStds;
-        } else if(config.normalization == "maxmin") {
-            NormalizeGetMinMax normalizeGetMinMax(trainData, trainLabels);
-            BatchProcessv2::run(&trainLoader, 0, config.batchSize, normalizationExamples, inputCubeSize, &normalizeGetMinMax);
-            normalizeGetMinMax.calcMinMaxTransform(&translate, &scale);
+            stats.getStdDevTransform(config.normalizationNumStds, &translate, &scale);
         } else {
-            cout << "Error: Unknown normalization: " << config.normalization << endl;
-            return;
+            stats.getMinMaxTransform(&translate, &scale);
         }
     }
     cout << " image norm translate " << translate << " scale " << scale << endl;
@@ -256,12 +355,28 @@ void go(Config config) {
 //    const int numToTrain = Ntrain;
 //    const int batchSize = config.batchSize;
 
-    EasyCL *cl = 0;
-    if(config.gpuIndex >= 0) {
-        cl = EasyCL::createForIndexedGpu(config.gpuIndex);
-    } else {
-        cl = EasyCL::createForFirstGpuOtherwiseCpu();
+    // replica 0 is the main net; the other replicas follow it, see DataParallelTrainer
+    if(config.replicas < 1) {
+        cout << "Error: replicas should be at least 1" << endl;
+        return;
+    }
+    vector<int> replicaGpuIndices(config.replicas, config.gpuIndex);
+    if(config.replicaGpuIndices != "") {
+        vector<string> splitIndices = split(config.replicaGpuIndices, ",");
+        if((int)splitIndices.size() != config.replicas) {
+            cout << "Error: replicagpuindices should list " << config.replicas << " gpu indices, one per replica" << endl;
+            return;
+        }
+        for(int i = 0; i < config.replicas; i++) {
+            replicaGpuIndices[i] = atoi(splitIndices[i]);
+        }
+    }
+    if(config.replicas > 1 && config.multiNet > 1) {
+        cout << "Error: replicas and multinet cant be used together" << endl;
+        return;
     }
+
+    EasyCL *cl = createCl(replicaGpuIndices[0]);
     ClBlasInstance blasInstance;
 
     NeuralNet *net;
@@ -284,36 +399,8 @@ void go(Config config) {
         return;
     }
     // apply the trainer
-    Trainer *trainer = 0;
-    if(toLower(config.trainer) == "sgd") {
-        SGD *sgd = new SGD(cl);
-        sgd->setLearningRate(config.learningRate);
-        sgd->setMomentum(config.momentum);
-        sgd->setWeightDecay(config.weightDecay);
-        trainer = sgd;
-    } else if(toLower(config.trainer) == "anneal") {
-        Annealer *annealer = new Annealer(cl);
-        annealer->setLearningRate(config.learningRate);
-        annealer->setAnneal(config.anneal);
-        trainer = annealer;
-    } else if(toLower(config.trainer) == "nesterov") {
-        Nesterov *nesterov = new Nesterov(cl);
-        nesterov->setLearningRate(config.learningRate);
-        nesterov->setMomentum(config.momentum);
-        trainer = nesterov;
-    } else if(toLower(config.trainer) == "adagrad") {
-        Adagrad *adagrad = new Adagrad(cl);
-        adagrad->setLearningRate(config.learningRate);
-        trainer = adagrad;
-    } else if(toLower(config.trainer) == "rmsprop") {
-        Rmsprop *rmsprop = new Rmsprop(cl);
-        rmsprop->setLearningRate(config.learningRate);
-        trainer = rmsprop;
-    } else if(toLower(config.trainer) == "adadelta") {
-        Adadelta *adadelta = new Adadelta(cl, config.rho);
-        trainer = adadelta;
-    } else {
-        cout << "trainer " << config.trainer << " unknown." << endl;
+    Trainer *trainer = createTrainer(config, cl);
+    if(trainer == 0) {
         return;
     }
     cout << "Using trainer " << trainer->asString() << endl;
@@ -348,11 +435,34 @@ void go(Config config) {
         cout << "reloaded epoch=" << restartEpoch << " batch=" << restartBatch << " numRight=" << restartNumRight << " loss=" << restartLoss << endl;
     }
 
+    vector<EasyCL *> replicaCls;
+    vector<NeuralNet *> replicaNets;
+    vector<Trainer *> replicaTrainers;
+    DataParallelTrainer *dataParallel = 0;
+    if(config.replicas > 1) {
+        replicaNets.push_back(net);
+        replicaTrainers.push_back(trainer);
+        for(int i = 1; i < config.replicas; i++) {
+            EasyCL *replicaCl = createCl(replicaGpuIndices[i]);
+            NeuralNet *replicaNet = new NeuralNet(replicaCl);
+            replicaNet->addLayer(InputLayerMaker::instance()->numPlanes(numPlanes)->imageSize(imageSize));
+            replicaNet->addLayer(NormalizationLayerMaker::instance()->translate(translate)->scale(scale));
+            NetdefToNet::createNetFromNetdef(replicaNet, config.netDef, weightsInitializer);
+            replicaNet->setBatchSize(config.batchSize);
+            replicaCls.push_back(replicaCl);
+            replicaNets.push_back(replicaNet);
+            replicaTrainers.push_back(createTrainer(config, replicaCl));
+        }
+        // copies net's weights, which might just have been loaded, to the other replicas
+        dataParallel = new DataParallelTrainer(replicaNets, replicaTrainers);
+        trainer = dataParallel;
+        cout << "Using " << dataParallel->asString() << endl;
+    }
+
     timer.timeCheck("before learning start");
     if(config.dumpTimings) {
-        StatefulTimer::dump(true);
+        cout << Profiler::getSummary(true);
     }
-    StatefulTimer::timeCheck("START");
 
     Trainable *trainable = net;
     MultiNet *multiNet = 0;
@@ -362,17 +472,28 @@ void go(Config config) {
     }
     NetLearnerBase *netLearner = 0;
     if(config.loadOnDemand) {
-        netLearner = new NetLearnerOnDemandv2(trainer, trainable,
+        NetLearnerOnDemandv2 *netLearnerOnDemand = new NetLearnerOnDemandv2(trainer, trainable,
             &trainLoader, Ntrain,
             &testLoader, Ntest,
             config.fileReadBatches, config.batchSize
         );
+        netLearnerOnDemand->setQueueDepth(config.prefetchDepth);
+        netLearnerOnDemand->setShuffle(config.shuffleBlocks, (unsigned int)config.shuffleSeed);
+        netLearner = netLearnerOnDemand;
     } else {
-        netLearner = new NetLearner(trainer, trainable,
-            Ntrain, trainData, trainLabels,
-            Ntest, testData, testLabels,
-            config.batchSize 
-        );
+        if(floatData) {
+            netLearner = new NetLearner(trainer, trainable,
+                Ntrain, trainFloatData, trainLabels,
+                Ntest, testFloatData, testLabels,
+                config.batchSize
+            );
+        } else {
+            netLearner = new NetLearner(trainer, trainable,
+                Ntrain, trainData, trainLabels,
+                Ntest, testData, testLabels,
+                config.batchSize 
+            );
+        }
     }
 //    netLearner->setTrainer(trainer);
     netLearner->reset();
@@ -383,48 +504,87 @@ void go(Config config) {
     netLearner->setDumpTimings(config.dumpTimings);
 //    netLearner->setLearningRate(config.learningRate, config.annealLearningRate);
     Timer weightsWriteTimer;
-    while(!netLearner->isLearningDone()) {
+    WeightsWriter *weightsWriter = 0;
+    if(config.weightsFile != "") {
+        weightsWriter = new WeightsWriter();
+        weightsWriter->setDtype(config.weightsFp16 ? WeightsFile::FLOAT16 : WeightsFile::FLOAT32);
+    }
+    // the writer finishes any snapshot in flight, and stops its thread, when
+    // deleted, so do that on the way out too, if training, or the last write, throws
+    try {
+        while(!netLearner->isLearningDone()) {
 //        netLearnerBase->tickEpoch();
-        netLearner->tickBatch();
-        if(netLearner->getEpochDone()) {
+            netLearner->tickBatch();
+            if(netLearner->getEpochDone()) {
 //            cout << "epoch done" << endl;
-            if(config.weightsFile != "") {
-                cout << "record epoch=" << netLearner->getNextEpoch() << endl;
-                WeightsPersister::persistWeights(config.weightsFile, config.getTrainingString(), net, netLearner->getNextEpoch(), 0, 0, 0, 0);
-                weightsWriteTimer.lap();
-            }
+                if(config.weightsFile != "") {
+                    cout << "record epoch=" << netLearner->getNextEpoch() << endl;
+                    weightsWriter->snapshot(config.weightsFile, config.getTrainingString(), net, netLearner->getNextEpoch(), 0, 0, 0, 0);
+                    cout << "weights snapshot paused training for " << weightsWriter->getLastStallMilliseconds() << "ms" << endl;
+                    weightsWriteTimer.lap();
+                }
 //            Sampler::sampleFloatWrapper("conv weights", net->getLayer(6)->getWeightsWrapper());
 //            Sampler::sampleFloatWrapper("fc weights", net->getLayer(11)->getWeightsWrapper());
 //            Sampler::sampleFloatWrapper("conv bias", net->getLayer(6)->getBiasWrapper());
 //            Sampler::sampleFloatWrapper("fc bias", net->getLayer(11)->getBiasWrapper());
-            if(config.dumpTimings) {
-                StatefulTimer::dump(true);
-            }
-        } else {
-            if(config.writeWeightsInterval > 0) {
+                if(config.dumpTimings) {
+                    cout << Workspace::get(cl)->getStatsString() << endl;
+                }
+                if(dataParallel != 0) {
+                    cout << dataParallel->getStatsString() << endl;
+                    dataParallel->resetStats();
+                }
+            } else {
+                if(config.writeWeightsInterval > 0 && weightsWriter != 0) {
 //                cout << "batch done" << endl;
-                float timeMinutes = weightsWriteTimer.interval() / 1000.0f / 60.0f;
+                    float timeMinutes = weightsWriteTimer.interval() / 1000.0f / 60.0f;
 //                cout << "timeMinutes " << timeMinutes << endl;
-                if(timeMinutes >= config.writeWeightsInterval) {
-                    int nextEpoch = netLearner->getNextEpoch();
-                    int nextBatch = netLearner->getNextBatch();
-                    int batchNumRight = netLearner->getBatchNumRight();
-                    float batchLoss = netLearner->getBatchLoss();
-                    cout << "record epoch=" << nextEpoch << " batch=" << nextBatch <<
-                        "(" << ((float)nextBatch * 100.0f / netLearner->getNTrain() * config.batchSize) << "% of epoch)" <<
-                        " numRight=" << batchNumRight << "(" << (batchNumRight * 100.0f / nextBatch / config.batchSize) << "%)" <<
-                        " loss=" << batchLoss << endl;
-                    WeightsPersister::persistWeights(config.weightsFile, config.getTrainingString(), net,
-                        nextEpoch, nextBatch, 0, batchNumRight, batchLoss);
-                    weightsWriteTimer.lap();
+                    if(timeMinutes >= config.writeWeightsInterval) {
+                        int nextEpoch = netLearner->getNextEpoch();
+                        int nextBatch = netLearner->getNextBatch();
+                        int batchNumRight = netLearner->getBatchNumRight();
+                        float batchLoss = netLearner->getBatchLoss();
+                        cout << "record epoch=" << nextEpoch << " batch=" << nextBatch <<
+                            "(" << ((float)nextBatch * 100.0f / netLearner->getNTrain() * config.batchSize) << "% of epoch)" <<
+                            " numRight=" << batchNumRight << "(" << (batchNumRight * 100.0f / nextBatch / config.batchSize) << "%)" <<
+                            " loss=" << batchLoss << endl;
+                        weightsWriter->snapshot(config.weightsFile, config.getTrainingString(), net,
+                            nextEpoch, nextBatch, 0, batchNumRight, batchLoss);
+                        cout << "weights snapshot paused training for " << weightsWriter->getLastStallMilliseconds() << "ms" << endl;
+                        weightsWriteTimer.lap();
+                    }
                 }
             }
         }
+        if(weightsWriter != 0) {
+            weightsWriter->flush();
+        }
+    } catch(...) {
+        delete weightsWriter;
+        throw;
+    }
+    if(weightsWriter != 0) {
+        cout << weightsWriter->getStatsString() << endl;
+        delete weightsWriter;
+    }
+    if(config.profileTrace != "") {
+        cl->finish();
+        Profiler::writeChromeTrace(config.profileTrace);
+        cout << "wrote profile trace to " << config.profileTrace << endl;
     }
 
     delete weightsInitializer;
-    delete trainer;
     delete netLearner;
+    if(dataParallel != 0) {
+        delete dataParallel;
+        for(int i = 1; i < (int)replicaNets.size(); i++) {
+            delete replicaTrainers[i];
+            delete replicaNets[i];
+            delete replicaCls[i - 1];
+        }
+        trainer = replicaTrainers[0];
+    }
+    delete trainer;
     if(multiNet != 0) {
         delete multiNet;
     }
@@ -435,6 +595,12 @@ void go(Config config) {
     if(testData != 0) {
         delete[] testData;
     }
+    if(trainFloatData != 0) {
+        delete[] trainFloatData;
+    }
+    if(testFloatData != 0) {
+        delete[] testFloatData;
+    }
     if(testLabels != 0) {
         delete[] testLabels;
     }
@@ -489,6 +655,15 @@ void printUsage(char *argv[], Config config) {
     cout << "    weightdecay=[weight decay, 0 means no decay; 1 means full decay, used by sgd trainer] (" << config.weightDecay << ")" << endl;
     cout << "" << endl; 
     cout << "unstable, might change within major version:" << endl; 
+    cout << "    weightsfp16=[store weights as fp16, halving the weights file; meant for deploying, since training resumed from it has lost precision [1|0]] (" << config.weightsFp16 << ")" << endl;
+    cout << "    profiletrace=[write per-layer timings to this file, as a chrome trace, for chrome://tracing or perfetto] (" << config.profileTrace << ")" << endl;
+    cout << "    replicas=[data-parallel: split each batch across this many copies of the net, each on its own device or context] (" << config.replicas << ")" << endl;
+    cout << "    replicagpuindices=[data-parallel: comma-separated gpu indices of the replicas, eg 0,1 (default: all on gpuindex)] (" << config.replicaGpuIndices << ")" << endl;
+    cout << "    prefetchdepth=[for loadondemand=1, how many file batches to hold in memory; 2 loads the next while training on the current, 1 disables prefetching] (" << config.prefetchDepth << ")" << endl;
+    cout << "    shuffleblocks=[for loadondemand=1, shuffle the training examples each epoch: each file batch is read as this many blocks, from random places in the file, then shuffled in memory; 0 reads in file order] (" << config.shuffleBlocks << ")" << endl;
+    cout << "    shuffleseed=[seed for shuffleblocks; a resumed run needs the same seed to carry on in the same order] (" << config.shuffleSeed << ")" << endl;
+    cout << "    normalizationsampling=[which examples normalizationexamples reads: first, the first ones, or strided, chunks spread over the whole training file [first|strided]] (" << config.normalizationSampling << ")" << endl;
+    cout << "    normalizationcache=[cache normalization statistics in a .normstats file next to the training file, so later runs skip reading the examples [1|0]] (" << config.normalizationCache << ")" << endl;
     cout << "    initialweights=[for uniform initializer, weights will be initialized randomly within range -initialweights to +initialweights, divided by fanin, (default: 1.0f)] (" << config.initialWeights << ")" << endl;
     cout << "    rho=[rho decay, in adadelta trainer. 1 is no decay. 0 is full decay (default 0.9)] (" << config.rho << ")" << endl;
     cout << "    anneal=[multiply learningrate by this amount each epoch, used by anneal trainer, default 1.0] (" << config.anneal << ")" << endl;
@@ -549,20 +724,38 @@ int main(int argc, char *argv[]) {
                 config.weightsFile = (value);
             } else if(key == "writeweightsinterval") {
                 config.writeWeightsInterval = atof(value);
+            } else if(key == "weightsfp16") {
+                config.weightsFp16 = atoi(value);
             } else if(key == "normalization") {
                 config.normalization = (value);
             } else if(key == "normalizationnumstds") {
                 config.normalizationNumStds = atof(value);
             } else if(key == "dumptimings") {
                 config.dumpTimings = atoi(value);
+            } else if(key == "profiletrace") {
+                config.profileTrace = (value);
             } else if(key == "multinet") {
                 config.multiNet = atoi(value);
+            } else if(key == "replicas") {
+                config.replicas = atoi(value);
+            } else if(key == "replicagpuindices") {
+                config.replicaGpuIndices = (value);
             } else if(key == "loadondemand") {
                 config.loadOnDemand = atoi(value);
             } else if(key == "filereadbatches") {
                 config.fileReadBatches = atoi(value);
+            } else if(key == "prefetchdepth") {
+                config.prefetchDepth = atoi(value);
+            } else if(key == "shuffleblocks") {
+                config.shuffleBlocks = atoi(value);
+            } else if(key == "shuffleseed") {
+                config.shuffleSeed = atoi(value);
             } else if(key == "normalizationexamples") {
                 config.normalizationExamples = atoi(value);
+            } else if(key == "normalizationsampling") {
+                config.normalizationSampling = (value);
+            } else if(key == "normalizationcache") {
+                config.normalizationCache = atoi(value);
             } else if(key == "weightsinitializer") {
                 config.weightsInitializer = (value);
             } else if(key == "initialweights") {
@@ -0,0 +1,272 @@
+// Copyright Hugh Perkins 2015 hughperkins at gmail
+//
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file, You can
+// obtain one at http://mozilla.org/MPL/2.0/.
+
+// runs a network forward and backward on random data, for long enough that
+// ForwardAuto, BackwardAuto and BackpropWeightsAuto try every kernel on every
+// layer, and writes the winners to the tuning cache (see conv/TuningCache.h)
+// Later deepcl_train and deepcl_predict runs, with the same network, batch size
+// and device, then use the tuned kernels straight away
+
+#include <algorithm>
+
+#include "DeepCL.h"
+#include "conv/Forward.h"
+#include "conv/Backward.h"
+#include "conv/BackpropWeights.h"
+#include "conv/TuningCache.h"
+#include "util/FileHelper.h"
+#include "clblas/ClBlasInstance.h"
+
+using namespace std;
+
+/* [[[cog
+    # These are used in the later cog sections in this file:
+    options = [
+        {'name': 'gpuIndex', 'type': 'int', 'description': 'gpu device index; default value is gpu if present, cpu otw.', 'default': -1, 'ispublicapi': True},
+        {'name': 'netDef', 'type': 'string', 'description': 'network definition, eg 8c5z-relu-mp2-16c5z-relu-mp3-150n-tanh-10n', 'default': '', 'ispublicapi': True},
+        {'name': 'weightsFile', 'type': 'string', 'description': 'read the network definition from this weights file, instead of netdef', 'default': '', 'ispublicapi': True},
+        {'name': 'numPlanes', 'type': 'int', 'description': 'number of input planes', 'default': 1, 'ispublicapi': True},
+        {'name': 'imageSize', 'type': 'int', 'description': 'input image size', 'default': 28, 'ispublicapi': True},
+        {'name': 'batchSize', 'type': 'int', 'description': 'batch size', 'default': 128, 'ispublicapi': True},
+        {'name': 'forwardOnly', 'type': 'int', 'description': 'only tune forward, eg for prediction [1|0]', 'default': 0, 'ispublicapi': True},
+        {'name': 'cacheDir', 'type': 'string', 'description': 'directory for the tuning cache; default DEEPCL_CACHE_DIR, or ~/.deepcl', 'default': ''},
+        {'name': 'retune', 'type': 'int', 'description': 'throw away existing tuning results first [1|0]', 'default': 0}
+    ]
+*///]]]
+// [[[end]]]
+
+class Config {
+public:
+    /* [[[cog
+        cog.outl('// generated using cog:')
+        for option in options:
+            cog.outl(option['type'] + ' ' + option['name'] + ';')
+    */// ]]]
+    // generated using cog:
+    int gpuIndex;
+    string netDef;
+    string weightsFile;
+    int numPlanes;
+    int imageSize;
+    int batchSize;
+    int forwardOnly;
+    string cacheDir;
+    int retune;
+    // [[[end]]]
+
+    Config() {
+        /* [[[cog
+            cog.outl('// generated using cog:')
+            for option in options:
+                defaultString = ''
+                default = option['default']
+                type = option['type']
+                if type == 'string':
+                    defaultString = '"' + default + '"'
+                elif type == 'int':
+                    defaultString = str(default)
+                elif type == 'float':
+                    defaultString = str(default)
+                    if '.' not in defaultString:
+                        defaultString += '.0'
+                    defaultString += 'f'
+                cog.outl(option['name'] + ' = ' + defaultString + ';')
+        */// ]]]
+        // generated using cog:
+        gpuIndex = -1;
+        netDef = "";
+        weightsFile = "";
+        numPlanes = 1;
+        imageSize = 28;
+        batchSize = 128;
+        forwardOnly = 0;
+        cacheDir = "";
+        retune = 0;
+        // [[[end]]]
+    }
+};
+
+void go(Config config) {
+    if(config.cacheDir != "") {
+        FileHelper::setCacheDirectory(config.cacheDir);
+    }
+    TuningCache *tuningCache = TuningCache::instance();
+    tuningCache->setEnabled(true);
+    if(tuningCache->getFilepath() == "") {
+        cout << "No usable cache directory, nothing to write the results to" << endl;
+        return;
+    }
+    if(config.retune) {
+        tuningCache->clear();
+    }
+
+    string netDef = config.netDef;
+    if(config.weightsFile != "") {
+        if(!WeightsPersister::loadConfigString(config.weightsFile, netDef)) {
+            cout << "Cannot load network definition from weightsFile." << endl;
+            return;
+        }
+    }
+    if(netDef == "") {
+        cout << "Please specify netdef, or weightsfile" << endl;
+        return;
+    }
+
+    EasyCL *cl = 0;
+    if(config.gpuIndex >= 0) {
+        cl = EasyCL::createForIndexedGpu(config.gpuIndex);
+    } else {
+        cl = EasyCL::createForFirstGpuOtherwiseCpu();
+    }
+    ClBlasInstance blasInstance;
+
+    NeuralNet *net = new NeuralNet(cl);
+    WeightsInitializer *weightsInitializer = new OriginalInitializer();
+    net->addLayer(InputLayerMaker::instance()->numPlanes(config.numPlanes)->imageSize(config.imageSize));
+    net->addLayer(NormalizationLayerMaker::instance()->translate(0.0f)->scale(1.0f));
+    if(!NetdefToNet::createNetFromNetdef(net, netDef, weightsInitializer)) {
+        return;
+    }
+    net->setBatchSize(config.batchSize);
+    net->print();
+
+    const int inputCubeSize = config.numPlanes * config.imageSize * config.imageSize;
+    float *inputData = new float[inputCubeSize * config.batchSize];
+    for(int i = 0; i < inputCubeSize * config.batchSize; i++) {
+        inputData[i] = (rand() % 1000) / 500.0f - 1.0f;
+    }
+    int *labels = new int[config.batchSize];
+    memset(labels, 0, sizeof(int) * config.batchSize);
+
+    // the Auto classes try one kernel per call, then need one more call to
+    // pick the winner, and thats when it gets written to the cache
+    int numPasses = Forward::getNumImplementations();
+    if(!config.forwardOnly) {
+        numPasses = std::max(numPasses, Backward::getNumImplementations());
+        numPasses = std::max(numPasses, BackpropWeights::getNumImplementations());
+    }
+    numPasses++;
+    net->setTraining(!config.forwardOnly);
+    for(int pass = 0; pass < numPasses; pass++) {
+        cout << "tuning pass " << (pass + 1) << " of " << numPasses << endl;
+        net->forward(inputData);
+        if(!config.forwardOnly) {
+            net->backwardFromLabels(labels);
+        }
+    }
+    cout << "tuning results written to " << tuningCache->getFilepath() << endl;
+
+    delete[] labels;
+    delete[] inputData;
+    delete weightsInitializer;
+    delete net;
+    delete cl;
+}
+
+void printUsage(char *argv[], Config config) {
+    cout << "Usage: " << argv[0] << " [key]=[value] [[key]=[value]] ..." << endl;
+    cout << endl;
+    cout << "Possible key=value pairs:" << endl;
+    /* [[[cog
+        cog.outl('// generated using cog:')
+        cog.outl('cout << "public api, shouldnt change within major version:" << endl;')
+        for option in options:
+            name = option['name']
+            description = option['description']
+            if 'ispublicapi' in option and option['ispublicapi']:
+                cog.outl('cout << "    ' + name.lower() + '=[' + description + '] (" << config.' + name + ' << ")" << endl;')
+        cog.outl('cout << "" << endl; ')
+        cog.outl('cout << "unstable, might change within major version:" << endl; ')
+        for option in options:
+            if 'ispublicapi' not in option or not option['ispublicapi']:
+                name = option['name']
+                description = option['description']
+                cog.outl('cout << "    ' + name.lower() + '=[' + description + '] (" << config.' + name + ' << ")" << endl;')
+    *///]]]
+    // generated using cog:
+    cout << "public api, shouldnt change within major version:" << endl;
+    cout << "    gpuindex=[gpu device index; default value is gpu if present, cpu otw.] (" << config.gpuIndex << ")" << endl;
+    cout << "    netdef=[network definition, eg 8c5z-relu-mp2-16c5z-relu-mp3-150n-tanh-10n] (" << config.netDef << ")" << endl;
+    cout << "    weightsfile=[read the network definition from this weights file, instead of netdef] (" << config.weightsFile << ")" << endl;
+    cout << "    numplanes=[number of input planes] (" << config.numPlanes << ")" << endl;
+    cout << "    imagesize=[input image size] (" << config.imageSize << ")" << endl;
+    cout << "    batchsize=[batch size] (" << config.batchSize << ")" << endl;
+    cout << "    forwardonly=[only tune forward, eg for prediction [1|0]] (" << config.forwardOnly << ")" << endl;
+    cout << "" << endl; 
+    cout << "unstable, might change within major version:" << endl; 
+    cout << "    cachedir=[directory for the tuning cache; default DEEPCL_CACHE_DIR, or ~/.deepcl] (" << config.cacheDir << ")" << endl;
+    cout << "    retune=[throw away existing tuning results first [1|0]] (" << config.retune << ")" << endl;
+    // [[[end]]]
+}
+
+int main(int argc, char *argv[]) {
+    Config config;
+    if(argc == 2 && (string(argv[1]) == "--help" || string(argv[1]) == "--?" || string(argv[1]) == "-?" || string(argv[1]) == "-h") ) {
+        printUsage(argv, config);
+    }
+    for(int i = 1; i < argc; i++) {
+        vector<string> splitkeyval = split(argv[i], "=");
+        if(splitkeyval.size() != 2) {
+          cout << "Usage: " << argv[0] << " [key]=[value] [[key]=[value]] ..." << endl;
+          exit(1);
+        } else {
+            string key = splitkeyval[0];
+            string value = splitkeyval[1];
+//            cout << "key [" << key << "]" << endl;
+            /* [[[cog
+                cog.outl('// generated using cog:')
+                cog.outl('if(false) {')
+                for option in options:
+                    name = option['name']
+                    type = option['type']
+                    cog.outl('} else if(key == "' + name.lower() + '") {')
+                    converter = '';
+                    if type == 'int':
+                        converter = 'atoi';
+                    elif type == 'float':
+                        converter = 'atof';
+                    cog.outl('    config.' + name + ' = ' + converter + '(value);')
+            */// ]]]
+            // generated using cog:
+            if(false) {
+            } else if(key == "gpuindex") {
+                config.gpuIndex = atoi(value);
+            } else if(key == "netdef") {
+                config.netDef = (value);
+            } else if(key == "weightsfile") {
+                config.weightsFile = (value);
+            } else if(key == "numplanes") {
+                config.numPlanes = atoi(value);
+            } else if(key == "imagesize") {
+                config.imageSize = atoi(value);
+            } else if(key == "batchsize") {
+                config.batchSize = atoi(value);
+            } else if(key == "forwardonly") {
+                config.forwardOnly = atoi(value);
+            } else if(key == "cachedir") {
+                config.cacheDir = (value);
+            } else if(key == "retune") {
+                config.retune = atoi(value);
+            // [[[end]]]
+            } else {
+                cout << endl;
+                cout << "Error: key '" << key << "' not recognised" << endl;
+                cout << endl;
+                printUsage(argv, config);
+                cout << endl;
+                return -1;
+            }
+        }
+    }
+    try {
+        go(config);
+    } catch(runtime_error e) {
+        cout << "Something went wrong: " << e.what() << endl;
+        return -1;
+    }
+}
+
+
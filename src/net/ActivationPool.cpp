@@ -0,0 +1,106 @@
+// Copyright Hugh Perkins 2015 hughperkins at gmail
+//
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file, You can
+// obtain one at http://mozilla.org/MPL/2.0/.
+
+#include <stdexcept>
+
+#include "EasyCL.h"
+#include "util/stringhelper.h"
+#include "net/ActivationPool.h"
+
+using namespace std;
+
+#undef STATIC
+#define STATIC
+#undef VIRTUAL
+#define VIRTUAL
+
+/// \brief assign each layer output a slot, reusing slots once their last reader has run
+///
+/// lastReaders[i] is the index of the last layer that reads layer i's output,
+/// or -1 if layer i's output isnt shared.  layerSlots gets each layer's slot,
+/// or -1.  Returns the number of slots
+PUBLIC STATIC int ActivationPool::planSlots(std::vector<int> const&lastReaders, std::vector<int> *layerSlots) {
+    vector<int> busyUntil; // last reader of each slot's current output
+    layerSlots->clear();
+    for(int i = 0; i < (int)lastReaders.size(); i++) {
+        if(lastReaders[i] < 0) {
+            layerSlots->push_back(-1);
+            continue;
+        }
+        if(lastReaders[i] <= i) {
+            throw runtime_error("ActivationPool::planSlots: layer " + toString(i) + " is read before it is written");
+        }
+        int slot = -1;
+        for(int s = 0; s < (int)busyUntil.size(); s++) {
+            // a layer writes its output while it reads its input, so the
+            // slot must be free strictly before layer i
+            if(busyUntil[s] < i) {
+                slot = s;
+                break;
+            }
+        }
+        if(slot == -1) {
+            slot = (int)busyUntil.size();
+            busyUntil.push_back(0);
+        }
+        busyUntil[slot] = lastReaders[i];
+        layerSlots->push_back(slot);
+    }
+    return (int)busyUntil.size();
+}
+/// slotCubeSizes: per example number of floats of each slot
+PUBLIC ActivationPool::ActivationPool(EasyCL *cl, std::vector<int> slotCubeSizes) :
+        cl(cl),
+        slotCubeSizes(slotCubeSizes),
+        allocatedBatchSize(0) {
+}
+PUBLIC ActivationPool::~ActivationPool() {
+    freeBuffers();
+}
+void ActivationPool::freeBuffers() {
+    for(int i = 0; i < (int)outputWrappers.size(); i++) {
+        delete outputWrappers[i];
+        delete[] outputs[i];
+    }
+    outputWrappers.clear();
+    outputs.clear();
+    allocatedBatchSize = 0;
+}
+/// \brief make the slots big enough for batchSize
+///
+/// returns true if the buffers moved, and so need handing to the layers again
+PUBLIC bool ActivationPool::reserve(int batchSize) {
+    if(batchSize <= allocatedBatchSize) {
+        return false;
+    }
+    freeBuffers();
+    for(int i = 0; i < (int)slotCubeSizes.size(); i++) {
+        int numFloats = slotCubeSizes[i] * batchSize;
+        float *output = new float[numFloats];
+        CLWrapper *outputWrapper = cl->wrap(numFloats, output);
+        outputWrapper->createOnDevice();
+        outputs.push_back(output);
+        outputWrappers.push_back(outputWrapper);
+    }
+    allocatedBatchSize = batchSize;
+    return true;
+}
+PUBLIC int ActivationPool::getNumSlots() const {
+    return (int)slotCubeSizes.size();
+}
+PUBLIC float *ActivationPool::getOutput(int slot) {
+    return outputs[slot];
+}
+PUBLIC CLWrapper *ActivationPool::getOutputWrapper(int slot) {
+    return outputWrappers[slot];
+}
+PUBLIC long ActivationPool::getAllocatedBytes() const {
+    long bytes = 0;
+    for(int i = 0; i < (int)slotCubeSizes.size(); i++) {
+        bytes += (long)slotCubeSizes[i] * allocatedBatchSize * 4;
+    }
+    return bytes;
+}
@@ -0,0 +1,61 @@
+// Copyright Hugh Perkins 2015 hughperkins at gmail
+//
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file, You can
+// obtain one at http://mozilla.org/MPL/2.0/.
+
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include "DeepCLDllExport.h"
+
+class EasyCL;
+class CLWrapper;
+
+#define VIRTUAL virtual
+#define STATIC static
+
+/// \brief output buffers shared by the layers of a net, for inference
+///
+/// planSlots gives layers whose outputs are never needed at the same time the
+/// same slot.  For a chain of layers, that is two slots, used in turn.  Each
+/// slot is sized for the largest output it holds, and grows with the batch
+/// size.  See NeuralNet::planInference
+class DeepCL_EXPORT ActivationPool {
+    private:
+    EasyCL *cl;
+    #ifdef _WIN32
+    #pragma warning(disable: 4251)
+    #endif
+    std::vector<int> slotCubeSizes;
+    std::vector<float *> outputs;
+    std::vector<CLWrapper *> outputWrappers;
+    #ifdef _WIN32
+    #pragma warning(default: 4251)
+    #endif
+    int allocatedBatchSize;
+
+    // [[[cog
+    // import cog_addheaders
+    // cog_addheaders.addv2()
+    // ]]]
+    // generated, using cog:
+
+    public:
+    STATIC int planSlots(std::vector<int> const&lastReaders, std::vector<int> *layerSlots);
+    ActivationPool(EasyCL *cl, std::vector<int> slotCubeSizes);
+    ~ActivationPool();
+    bool reserve(int batchSize);
+    int getNumSlots() const;
+    float *getOutput(int slot);
+    CLWrapper *getOutputWrapper(int slot);
+    long getAllocatedBytes() const;
+
+    private:
+    void freeBuffers();
+
+    // [[[end]]]
+};
+
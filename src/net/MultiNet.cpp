@@ -158,7 +158,7 @@ void MultiNet::forwardToOurselves() {
     for(int i = 0; i < outputNumElements; i++) {
         output[i] /= numChildren;
     }
-    memcpy(dynamic_cast< SoftMaxLayer * >(lossLayer)->output, output, sizeof(float) * lossLayer->getOutputNumElements());
+    dynamic_cast< SoftMaxLayer * >(lossLayer)->setOutput(output);
 //    proxyInputLayer->in(output);
 }
 VIRTUAL void MultiNet::forward(float const*images) {
@@ -167,6 +167,12 @@ VIRTUAL void MultiNet::forward(float const*images) {
     }
     forwardToOurselves();
 }
+VIRTUAL void MultiNet::forward(unsigned char const*images) {
+    for(vector< Trainable * >::iterator it = trainables.begin(); it != trainables.end(); it++) {
+        (*it)->forward(images);
+    }
+    forwardToOurselves();
+}
 VIRTUAL void MultiNet::backwardFromLabels(int const *labels) {
     // dont think we need to backprop onto ourselves?  Just direclty onto children, right?
     for(vector< Trainable * >::iterator it = trainables.begin(); it != trainables.end(); it++) {
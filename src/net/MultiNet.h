@@ -51,6 +51,7 @@ public:
     VIRTUAL int calcNumRight(int const *labels);
     void forwardToOurselves();
     VIRTUAL void forward(float const*images);
+    VIRTUAL void forward(unsigned char const*images);
     VIRTUAL void backwardFromLabels(int const *labels);
     VIRTUAL void backward(float const *expectedOutput);
     VIRTUAL float const *getOutput() const;
@@ -12,11 +12,13 @@
 #include "layer/LayerMaker.h"
 #include "net/NeuralNetMould.h"
 #include "activate/ActivationFunction.h"
-#include "util/StatefulTimer.h"
+#include "util/ProfileScope.h"
+#include "util/Profiler.h"
 //#include "AccuracyHelper.h"
 #include "layer/Layer.h"
 #include "input/InputLayer.h"
 #include "fc/FullyConnectedLayer.h"
+#include "activate/ActivationLayer.h"
 #include "batch/EpochMaker.h"
 #include "loss/LossLayer.h"
 #include "loss/IAcceptsLabels.h"
@@ -26,6 +28,7 @@
 #include "trainers/TrainerMaker.h"
 #include "weights/WeightsPersister.h"
 #include "CppRuntimeBoundary.h"
+#include "net/ActivationPool.h"
 
 #include "net/NeuralNet.h"
 
@@ -39,7 +42,8 @@ using namespace std;
 #define STATIC
 
 NeuralNet::NeuralNet(EasyCL *cl) :
-        cl(cl) {
+        cl(cl),
+        activationPool(0) {
     trainer = 0;
     isTraining = true;
 }
@@ -57,7 +61,8 @@ void NeuralNet::deleteMe() {
 }
 /// Constructor
 NeuralNet::NeuralNet(EasyCL *cl, int numPlanes, int imageSize) :
-        cl(cl) {
+        cl(cl),
+        activationPool(0) {
     addLayer(InputLayerMaker::instance()->numPlanes(numPlanes)->imageSize(imageSize) );
     trainer = 0;
 }
@@ -65,6 +70,7 @@ NeuralNet::~NeuralNet() {
     for(int i = 0; i < (int)layers.size(); i++) {
         delete layers[i];
     }
+    delete activationPool;
 }
 STATIC NeuralNetMould *NeuralNet::maker(EasyCL *cl) {
     return new NeuralNetMould(cl);
@@ -89,6 +95,7 @@ PUBLICAPI void NeuralNet::addLayer(LayerMaker2 *maker) {
 //    cout << "neuralnet::insert numplanes " << inputLayerMaker._numPlanes << " imageSize " << inputLayerMaker._imageSize << endl;
     maker->setCl(cl);
     Layer *layer = maker->createLayer(getLastLayer());
+    Profiler::setLayerName(this, (int)layers.size(), layer->getClassName());
     layers.push_back(layer);
 }
 PUBLICAPI void NeuralNet::initWeights(int layerIndex, float *weights, float *bias) {
@@ -167,11 +174,128 @@ PUBLICAPI VIRTUAL int NeuralNet::getOutputSize() const {
     return getLastLayer()->getOutputSize();
 }
 PUBLICAPI void NeuralNet::setBatchSize(int batchSize) {
+    if(activationPool != 0 && activationPool->reserve(batchSize)) {
+        for(int i = 0; i < (int)layers.size(); i++) {
+            if(layerSlots[i] >= 0) {
+                layers[i]->setSharedOutput(activationPool->getOutput(layerSlots[i]), activationPool->getOutputWrapper(layerSlots[i]));
+            }
+        }
+    }
     for(std::vector<Layer*>::iterator it = layers.begin(); it != layers.end(); it++) {
         (*it)->setBatchSize(batchSize);
     }
 }
+/// \brief for prediction only: layers share a few output buffers, and drop their gradient buffers
+///
+/// Each layer's output is only needed until the next layer has run, so,
+/// for a chain of layers, two buffers, used in turn, are enough.  The output
+/// of layer outputLayer (-1 means the last layer), and of the last layer, stay
+/// in their own buffers, so can be read after forward; the other layers'
+/// outputs are overwritten by later layers.  Call setBatchSize afterwards.
+/// Backward isnt possible until clearInferencePlan
+PUBLICAPI void NeuralNet::planInference(int outputLayer) {
+    clearInferencePlan();
+    setTraining(false);
+    const int numLayers = (int)layers.size();
+    if(outputLayer < 0) {
+        outputLayer = numLayers - 1;
+    }
+    if(outputLayer >= numLayers) {
+        throw runtime_error("NeuralNet::planInference: outputLayer " + toString(outputLayer) + " not in net of " + toString(numLayers) + " layers");
+    }
+    vector<bool> keep(numLayers, false);
+    keep[numLayers - 1] = true;
+    keep[outputLayer] = true;
+    // layers that dont own an output, eg the loss layers, hand out their
+    // input layer's output, so keep that one too
+    for(int i = numLayers - 1; i > 0; i--) {
+        if(keep[i] && !layers[i]->canShareOutput()) {
+            keep[i - 1] = true;
+        }
+    }
+    vector<int> lastReaders;
+    for(int i = 0; i < numLayers; i++) {
+        if(i == 0 || keep[i] || !layers[i]->canShareOutput()) {
+            lastReaders.push_back(-1);
+        } else {
+            // eg a fused activation layer hands on our output as its own
+            int lastReader = i + 1;
+            while(lastReader < numLayers - 1 && layers[lastReader]->passesThroughOutput()) {
+                lastReader++;
+            }
+            lastReaders.push_back(lastReader);
+        }
+    }
+    int numSlots = ActivationPool::planSlots(lastReaders, &layerSlots);
+    vector<int> slotCubeSizes(numSlots, 0);
+    for(int i = 0; i < numLayers; i++) {
+        if(layerSlots[i] >= 0) {
+            int cubeSize = layers[i]->getOutputPlanes() * layers[i]->getOutputSize() * layers[i]->getOutputSize();
+            slotCubeSizes[layerSlots[i]] = std::max(slotCubeSizes[layerSlots[i]], cubeSize);
+        }
+    }
+    activationPool = new ActivationPool(cl, slotCubeSizes);
+}
+/// \brief apply each activation layer's activation in the forward of the conv or fc layer before it
+///
+/// the conv layer's output is then post-activation, and the activation layer
+/// hands it on as its own output, saving a pass over the output, and a buffer.
+/// backward likewise: the conv layer applies the derivative as it reads its
+/// gradOutput, and the activation layer hands that gradient through.
+/// Outputs and weight gradients are as before.  Call before setBatchSize and
+/// planInference.  Returns the number of activation layers fused
+PUBLICAPI int NeuralNet::fuseActivations() {
+    if(activationPool != 0) {
+        throw runtime_error("NeuralNet::fuseActivations: call before planInference");
+    }
+    int numFused = 0;
+    for(int i = 1; i < (int)layers.size(); i++) {
+        ActivationLayer *activationLayer = dynamic_cast<ActivationLayer *>(layers[i]);
+        if(activationLayer == 0 || activationLayer->fused || !layers[i - 1]->canFuseActivation()) {
+            continue;
+        }
+        layers[i - 1]->fuseActivation(activationLayer->fn);
+        activationLayer->setFused();
+        numFused++;
+    }
+    return numFused;
+}
+/// \brief layers go back to their own buffers, from the next setBatchSize
+PUBLICAPI void NeuralNet::clearInferencePlan() {
+    if(activationPool == 0) {
+        return;
+    }
+    for(int i = 0; i < (int)layers.size(); i++) {
+        if(layers[i]->sharedOutput) {
+            layers[i]->setSharedOutput(0, 0);
+        }
+    }
+    layerSlots.clear();
+    delete activationPool;
+    activationPool = 0;
+}
+PUBLICAPI bool NeuralNet::isInferencePlanned() const {
+    return activationPool != 0;
+}
+/// eg "inference plan: 7 of 12 layers share 2 buffers, 1.2MB"
+PUBLICAPI std::string NeuralNet::getInferencePlanString() const {
+    if(activationPool == 0) {
+        return "inference plan: none";
+    }
+    int numShared = 0;
+    for(int i = 0; i < (int)layerSlots.size(); i++) {
+        if(layerSlots[i] >= 0) {
+            numShared++;
+        }
+    }
+    return "inference plan: " + toString(numShared) + " of " + toString(layers.size()) + " layers share "
+        + toString(activationPool->getNumSlots()) + " buffers, "
+        + toString(activationPool->getAllocatedBytes() / 1024 / 1024.0f) + "MB";
+}
 PUBLICAPI void NeuralNet::setTraining(bool training) {
+    if(training && activationPool != 0) {
+        throw runtime_error("NeuralNet::setTraining: net is planned for inference only, call clearInferencePlan first");
+    }
     for(std::vector<Layer*>::iterator it = layers.begin(); it != layers.end(); it++) {
         (*it)->setTraining(training);
     }
@@ -187,41 +311,57 @@ PUBLICAPI void NeuralNet::forward(float const*images) {
     // forward...
     dynamic_cast<InputLayer *>(layers[0])->in(images);
     for(int layerId = 0; layerId < (int)layers.size(); layerId++) {
-        StatefulTimer::setPrefix("layer" + toString(layerId) + " ");
+        ProfileScope profile(cl, Profiler::FORWARD, this, layerId);
+        layers[layerId]->forward();
+    }
+}
+/// \brief forward uint8 images; they are uploaded as bytes, and normalized on the device
+///
+/// the second layer should be a NormalizationLayer
+PUBLICAPI void NeuralNet::forward(unsigned char const*images) {
+    dynamic_cast<InputLayer *>(layers[0])->in(images);
+    for(int layerId = 0; layerId < (int)layers.size(); layerId++) {
+        ProfileScope profile(cl, Profiler::FORWARD, this, layerId);
         layers[layerId]->forward();
-        StatefulTimer::setPrefix("");
     }
 }
 /// \brief note: this does no learning, just calculates the gradients
 PUBLICAPI void NeuralNet::backwardFromLabels(int const *labels) {
+    if(activationPool != 0) {
+        throw runtime_error("NeuralNet::backward: net is planned for inference only, call clearInferencePlan first");
+    }
     IAcceptsLabels *acceptsLabels = dynamic_cast<IAcceptsLabels*>(getLastLayer());
     if(acceptsLabels == 0) {
         throw std::runtime_error("Must add a child of IAcceptsLabels as last layer, to use backwardFromLabels");
     }
     acceptsLabels->calcGradInputFromLabels(labels);
     for(int layerIdx = (int)layers.size() - 2; layerIdx >= 1; layerIdx--) { // no point in propagating to input layer :-P
-        StatefulTimer::setPrefix("layer" + toString(layerIdx) + " ");
         Layer *layer = layers[layerIdx];
         if(layer->needsBackProp()) {
+            ProfileScope profile(cl, Profiler::BACKWARD, this, layerIdx);
             layer->backward();
         }
-        StatefulTimer::setPrefix("");
     }
 }
 /// \brief note: this does no learning, just calculates the gradients
 PUBLICAPI void NeuralNet::backward(float const *expectedOutput) {
+    if(activationPool != 0) {
+        throw runtime_error("NeuralNet::backward: net is planned for inference only, call clearInferencePlan first");
+    }
     LossLayer *lossLayer = dynamic_cast<LossLayer*>(getLastLayer());
     if(lossLayer == 0) {
         throw std::runtime_error("Must add a LossLayer as last layer of net");
     }
     lossLayer->calcGradInput(expectedOutput);
     for(int layerIdx = (int)layers.size() - 2; layerIdx >= 1; layerIdx--) { // no point in propagating to input layer
-        StatefulTimer::setPrefix("layer" + toString(layerIdx) + " ");
+        ProfileScope profile(cl, Profiler::BACKWARD, this, layerIdx);
         layers[layerIdx]->backward();
-        StatefulTimer::setPrefix("");
     }
 }
 void NeuralNet::backward(OutputData *outputData) {
+    if(activationPool != 0) {
+        throw runtime_error("NeuralNet::backward: net is planned for inference only, call clearInferencePlan first");
+    }
     LossLayer *lossLayer = dynamic_cast<LossLayer*>(getLastLayer());
     lossLayer->calcGradInput(outputData);
     for(int layerIdx = (int)layers.size() - 2; layerIdx >= 1; layerIdx--) { // no point in propagating to input layer
@@ -229,9 +369,8 @@ void NeuralNet::backward(OutputData *outputData) {
         if(!layer->needsBackProp()) {
             break;
         }
-        StatefulTimer::setPrefix("layer" + toString(layerIdx) + " ");
+        ProfileScope profile(cl, Profiler::BACKWARD, this, layerIdx);
         layer->backward();
-        StatefulTimer::setPrefix("");
     }
 }
 PUBLICAPI int NeuralNet::getNumLayers() {
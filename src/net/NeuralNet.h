@@ -26,6 +26,7 @@ class EpochMaker;
 class InputMaker;
 class InputLayer;
 class OutputData;
+class ActivationPool;
 
 #define VIRTUAL virtual
 #define STATIC static
@@ -38,11 +39,13 @@ protected:
 #pragma warning(disable: 4251)
 #endif
     std::vector< Layer *> layers;
+    std::vector<int> layerSlots; // activationPool slot of each layer, or -1
 #ifdef _WIN32
 #pragma warning(default: 4251)
 #endif
     EasyCL *cl; // NOT owned by us, dont delete
     Trainer *trainer; // NOT owned by us, dont delete
+    ActivationPool *activationPool; // set by planInference
 
 public:
     int isTraining; // = true;
@@ -80,9 +83,15 @@ public:
     PUBLICAPI VIRTUAL int getOutputPlanes() const;
     PUBLICAPI VIRTUAL int getOutputSize() const;
     PUBLICAPI void setBatchSize(int batchSize);
+    PUBLICAPI void planInference(int outputLayer);
+    PUBLICAPI int fuseActivations();
+    PUBLICAPI void clearInferencePlan();
+    PUBLICAPI bool isInferencePlanned() const;
+    PUBLICAPI std::string getInferencePlanString() const;
     PUBLICAPI void setTraining(bool training);
     PUBLICAPI int calcNumRight(int const *labels);
     PUBLICAPI void forward(float const*images);
+    PUBLICAPI void forward(unsigned char const*images);
     PUBLICAPI void backwardFromLabels(int const *labels);
     PUBLICAPI void backward(float const *expectedOutput);
     void backward(OutputData *outputData);
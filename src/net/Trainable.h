@@ -27,6 +27,7 @@ public:
     virtual void setTraining(bool training) = 0;
     virtual int calcNumRight(int const *labels) = 0;
     virtual void forward(float const*images) = 0;
+    virtual void forward(unsigned char const*images) = 0;
     virtual void backwardFromLabels(int const *labels) = 0;
     virtual void backward(float const *expectedOutput) = 0;
     virtual float const *getOutput() const = 0;
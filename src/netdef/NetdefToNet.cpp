@@ -264,5 +264,7 @@ STATIC bool NetdefToNet::createNetFromNetdef(NeuralNet *net, std::string netdef,
         }
     }
     net->addLayer(SoftMaxMaker::instance());
+    // conv and fc layers apply the activation after them in their own forward
+    net->fuseActivations();
     return true;
 }
\ No newline at end of file
@@ -53,7 +53,9 @@ public:
         *p_stdDev = sqrt(( statistics->sumYSquared - statistics->sumY * statistics->sumY / statistics->count) / (statistics->count - 1) );
     }
     
-    static void getMeanAndStdDev(float *data, int length, float *p_mean, float *p_stdDev) {
+    // T is float, or unsigned char, for uint8 datasets
+    template< typename T >
+    static void getMeanAndStdDev(T const*data, int length, float *p_mean, float *p_stdDev) {
         // get mean of the dataset, and stddev
     //    float thismax = 0;
         float sum = 0;
@@ -100,7 +102,8 @@ public:
         *p_maxDev = std::max<float>(255-mean, mean);
     }
     
-    static void getMinMax(float *data, int length, float *p_middle, float *p_maxDev) {
+    template< typename T >
+    static void getMinMax(T const*data, int length, float *p_middle, float *p_maxDev) {
         // get mean of the dataset, and stddev
         float thismin = 0;
         float thismax = 0;
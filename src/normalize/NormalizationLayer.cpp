@@ -4,7 +4,10 @@
 // v. 2.0. If a copy of the MPL was not distributed with this file, You can 
 // obtain one at http://mozilla.org/MPL/2.0/.
 
+#include "EasyCL.h"
 #include "normalize/NormalizationLayerMaker.h"
+#include "input/InputLayer.h"
+#include "util/KernelCache.h"
 
 #include "normalize/NormalizationLayer.h"
 
@@ -21,9 +24,16 @@ NormalizationLayer::NormalizationLayer(Layer *previousLayer, NormalizationLayerM
     outputSize(previousLayer->getOutputSize()),
     batchSize(0),
     allocatedSize(0),
-    output(0) {
+    output(0),
+    cl(maker->cl),
+    kernelNormalizeBytes(0),
+    outputWrapper(0),
+    outputOnDevice(false) {
 }
 VIRTUAL NormalizationLayer::~NormalizationLayer() {
+    if(outputWrapper != 0) {
+        delete outputWrapper;
+    }
     if(output != 0) {
         delete[] output;
     }
@@ -32,8 +42,17 @@ VIRTUAL std::string NormalizationLayer::getClassName() const {
     return "NormalizationLayer";
 }
 VIRTUAL float *NormalizationLayer::getOutput() {
+    if(outputOnDevice && outputWrapper->isDeviceDirty()) {
+        outputWrapper->copyToHost();
+    }
     return output;
 }
+VIRTUAL bool NormalizationLayer::hasOutputWrapper() const {
+    return outputOnDevice;
+}
+VIRTUAL CLWrapper *NormalizationLayer::getOutputWrapper() {
+    return outputWrapper;
+}
 VIRTUAL ActivationFunction const *NormalizationLayer::getActivationFunction() {
     return new LinearActivation();
 }
@@ -99,20 +118,91 @@ VIRTUAL void NormalizationLayer::setBatchSize(int batchSize) {
         this->batchSize = batchSize;
         return;
     }
+    if(outputWrapper != 0) {
+        delete outputWrapper;
+        outputWrapper = 0;
+    }
     if(output != 0) {
         delete[] output;
     }
     this->batchSize = batchSize;
-    this->allocatedSize = allocatedSize;
+    this->allocatedSize = batchSize;
     output = new float[ getOutputNumElements() ];
 }
 VIRTUAL void NormalizationLayer::forward() {
     int totalLinearLength = getOutputNumElements();
+    InputLayer *inputLayer = dynamic_cast< InputLayer * >(previousLayer);
+    if(inputLayer != 0 && inputLayer->hasByteInput()) {
+        forwardBytes(inputLayer->getByteInputWrapper());
+        return;
+    }
+    outputOnDevice = false;
     float *upstreamOutput = previousLayer->getOutput();
     for(int i = 0; i < totalLinearLength; i++) {
         output[i] = (upstreamOutput[i] + translate) * scale;
     }
 }
+// uint8 input batch on the device => normalized floats on the device
+VIRTUAL void NormalizationLayer::forwardBytes(CLWrapper *inputBytesWrapper) {
+    if(kernelNormalizeBytes == 0) {
+        buildKernel();
+    }
+    if(outputWrapper == 0) {
+        outputWrapper = cl->wrap(allocatedSize * getOutputCubeSize(), output);
+        outputWrapper->createOnDevice();
+    }
+    int N = getOutputNumElements();
+    kernelNormalizeBytes->in(N)
+        ->in(translate)
+        ->in(scale)
+        ->in(inputBytesWrapper)
+        ->out(outputWrapper);
+    int workgroupSize = 64;
+    int numWorkgroups = (N + workgroupSize - 1) / workgroupSize;
+    kernelNormalizeBytes->run_1d(numWorkgroups * workgroupSize, workgroupSize);
+    cl->finish();
+    outputOnDevice = true;
+}
+VIRTUAL void NormalizationLayer::buildKernel() {
+    string kernelName = "NormalizationLayer.normalize_bytes";
+    if(cl->kernelExists(kernelName)) {
+        kernelNormalizeBytes = cl->getKernel(kernelName);
+        return;
+    }
+    string options = "";
+    // [[[cog
+    // import stringify
+    // stringify.write_kernel2("kernelNormalizeBytes", "cl/normalize.cl", "normalize_bytes", 'options')
+    // ]]]
+    // generated using cog, from cl/normalize.cl:
+    const char * kernelNormalizeBytesSource =  
+    "// Copyright Hugh Perkins 2015 hughperkins at gmail\n"
+    "//\n"
+    "// This Source Code Form is subject to the terms of the Mozilla Public License,\n"
+    "// v. 2.0. If a copy of the MPL was not distributed with this file, You can\n"
+    "// obtain one at http://mozilla.org/MPL/2.0/.\n"
+    "\n"
+    "// reads the uint8 input batch, as uploaded by InputLayer, and writes the\n"
+    "// normalized floats, (input + translate) * scale, in one pass\n"
+    "// one thread per element\n"
+    "kernel void normalize_bytes(\n"
+    "        const int N,\n"
+    "        const float translate,\n"
+    "        const float scale,\n"
+    "        global const unsigned char *input,\n"
+    "        global float *output) {\n"
+    "    const int globalId = get_global_id(0);\n"
+    "    if (globalId >= N) {\n"
+    "        return;\n"
+    "    }\n"
+    "    output[globalId] = ((float)input[globalId] + translate) * scale;\n"
+    "}\n"
+    "\n"
+    "";
+    kernelNormalizeBytes = KernelCache::buildKernelFromString(cl, kernelNormalizeBytesSource, "normalize_bytes", options, "cl/normalize.cl");
+    // [[[end]]]
+    cl->storeKernel(kernelName, kernelNormalizeBytes, true);
+}
 VIRTUAL void NormalizationLayer::backward(float learningRate, float const *gradOutput) {
   // do nothing...
 }
@@ -13,6 +13,9 @@
 #define VIRTUAL virtual
 
 class NormalizationLayerMaker;
+class EasyCL;
+class CLWrapper;
+class CLKernel;
 
 class NormalizationLayer : public Layer, IHasToString {
 public:
@@ -26,6 +29,13 @@ public:
     int allocatedSize;
     float *output;
 
+    // when the input layer has uint8 input, we normalize on the device, straight from
+    // the uploaded bytes, and the output stays on the device
+    EasyCL *cl; // NOT owned by us
+    CLKernel *kernelNormalizeBytes;
+    CLWrapper *outputWrapper;
+    bool outputOnDevice;
+
     inline int getResultIndex(int n, int outPlane, int outRow, int outCol) const {
         return (( n
             * outputPlanes + outPlane)
@@ -45,6 +55,8 @@ public:
     VIRTUAL ~NormalizationLayer();
     VIRTUAL std::string getClassName() const;
     VIRTUAL float *getOutput();
+    VIRTUAL bool hasOutputWrapper() const;
+    VIRTUAL CLWrapper *getOutputWrapper();
     VIRTUAL ActivationFunction const *getActivationFunction();
     VIRTUAL int getPersistSize(int version) const;
     VIRTUAL void persistToArray(int version, float *array);
@@ -55,6 +67,8 @@ public:
     VIRTUAL bool needErrorsBackprop();
     VIRTUAL void setBatchSize(int batchSize);
     VIRTUAL void forward();
+    VIRTUAL void forwardBytes(CLWrapper *inputBytesWrapper);
+    VIRTUAL void buildKernel();
     VIRTUAL void backward(float learningRate, float const *gradOutput);
     VIRTUAL int getOutputSize() const;
     VIRTUAL int getOutputPlanes() const;
@@ -0,0 +1,360 @@
+// Copyright Hugh Perkins 2015 hughperkins at gmail
+//
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file, You can
+// obtain one at http://mozilla.org/MPL/2.0/.
+
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <iomanip>
+#include <vector>
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <stdexcept>
+#include <stdint.h>
+
+#include "util/ThreadPool.h"
+#include "util/FileHelper.h"
+#include "util/Philox.h"
+#include "util/stringhelper.h"
+#include "loaders/GenericLoaderv2.h"
+#include "batch/BatchPrefetcher.h"
+
+#include "normalize/NormalizationStats.h"
+
+#if defined(__SSE2__) || defined(_M_X64)
+#define NORMALIZATIONSTATS_SSE2
+#include <emmintrin.h>
+#endif
+
+using namespace std;
+
+#undef STATIC
+#define STATIC
+#undef VIRTUAL
+#define VIRTUAL
+
+// values per ThreadPool task.  At most 65536, so the sse2 sums of squares of
+// uint8 values, 4 per 32-bit lane per 16 values, cant overflow
+#define STATS_BLOCK_SIZE 65536
+
+// keys for Philox, for the offsets of strided chunks; fixed, so the same
+// settings always read the same records, and the cache stays valid
+#define STATS_SAMPLE_KEY0 0x6e6f726d
+#define STATS_SAMPLE_KEY1 0x73746174
+
+// bytes hashed at each end of the dataset for the cache key
+#define STATS_HASH_BYTES 65536
+
+static NormalizationStats blockStats(unsigned char const*data, long length) {
+    uint64_t sum = 0;
+    uint64_t sumSquares = 0;
+    unsigned char minValue = 255;
+    unsigned char maxValue = 0;
+    long i = 0;
+    #ifdef NORMALIZATIONSTATS_SSE2
+    __m128i zero = _mm_setzero_si128();
+    __m128i sums = zero; // 2 x 64-bit
+    __m128i squares = zero; // 4 x 32-bit
+    __m128i mins = _mm_set1_epi8((char)255);
+    __m128i maxs = zero;
+    for(; i + 16 <= length; i += 16) {
+        __m128i x = _mm_loadu_si128(reinterpret_cast<__m128i const*>(data + i));
+        sums = _mm_add_epi64(sums, _mm_sad_epu8(x, zero));
+        __m128i low = _mm_unpacklo_epi8(x, zero);
+        __m128i high = _mm_unpackhi_epi8(x, zero);
+        squares = _mm_add_epi32(squares, _mm_add_epi32(_mm_madd_epi16(low, low), _mm_madd_epi16(high, high)));
+        mins = _mm_min_epu8(mins, x);
+        maxs = _mm_max_epu8(maxs, x);
+    }
+    uint64_t sumLanes[2];
+    uint32_t squareLanes[4];
+    unsigned char minLanes[16];
+    unsigned char maxLanes[16];
+    _mm_storeu_si128(reinterpret_cast<__m128i *>(sumLanes), sums);
+    _mm_storeu_si128(reinterpret_cast<__m128i *>(squareLanes), squares);
+    _mm_storeu_si128(reinterpret_cast<__m128i *>(minLanes), mins);
+    _mm_storeu_si128(reinterpret_cast<__m128i *>(maxLanes), maxs);
+    sum = sumLanes[0] + sumLanes[1];
+    sumSquares = (uint64_t)squareLanes[0] + squareLanes[1] + squareLanes[2] + squareLanes[3];
+    for(int lane = 0; lane < 16; lane++) {
+        minValue = std::min(minValue, minLanes[lane]);
+        maxValue = std::max(maxValue, maxLanes[lane]);
+    }
+    #endif
+    for(; i < length; i++) {
+        unsigned char value = data[i];
+        sum += value;
+        sumSquares += (uint64_t)value * value;
+        minValue = std::min(minValue, value);
+        maxValue = std::max(maxValue, value);
+    }
+    NormalizationStats stats;
+    stats.count = length;
+    stats.mean = (double)sum / length;
+    // sum and sumSquares are exact, so this only loses what double does
+    stats.m2 = std::max(0.0, (double)sumSquares - (double)sum * stats.mean);
+    stats.minValue = minValue;
+    stats.maxValue = maxValue;
+    return stats;
+}
+static NormalizationStats blockStats(float const*data, long length) {
+    double sum = 0;
+    float minValue = data[0];
+    float maxValue = data[0];
+    for(long i = 0; i < length; i++) {
+        sum += data[i];
+        minValue = std::min(minValue, data[i]);
+        maxValue = std::max(maxValue, data[i]);
+    }
+    double mean = sum / length;
+    double m2 = 0;
+    for(long i = 0; i < length; i++) {
+        double diff = data[i] - mean;
+        m2 += diff * diff;
+    }
+    NormalizationStats stats;
+    stats.count = length;
+    stats.mean = mean;
+    stats.m2 = m2;
+    stats.minValue = minValue;
+    stats.maxValue = maxValue;
+    return stats;
+}
+// blocks reduced in parallel, then merged pairwise, in a fixed order
+template< typename T >
+static NormalizationStats reduceBlocks(T const*data, long length) {
+    int numBlocks = (int)((length + STATS_BLOCK_SIZE - 1) / STATS_BLOCK_SIZE);
+    vector<NormalizationStats> blocks(numBlocks);
+    ThreadPool::instance()->parallelFor(numBlocks, [&](int block) {
+        long start = (long)block * STATS_BLOCK_SIZE;
+        blocks[block] = blockStats(data + start, std::min((long)STATS_BLOCK_SIZE, length - start));
+    });
+    for(int width = 1; width < numBlocks; width *= 2) {
+        for(int block = 0; block + width < numBlocks; block += 2 * width) {
+            blocks[block].merge(blocks[block + width]);
+        }
+    }
+    return numBlocks > 0 ? blocks[0] : NormalizationStats();
+}
+static uint64_t hashBytes(char const*data, long length) {
+    uint64_t hash = 14695981039346656037ULL;
+    for(long i = 0; i < length; i++) {
+        hash ^= (unsigned char)data[i];
+        hash *= 1099511628211ULL;
+    }
+    return hash;
+}
+
+PUBLIC NormalizationStats::NormalizationStats() :
+        count(0),
+        mean(0),
+        m2(0),
+        minValue(0),
+        maxValue(0) {
+}
+PUBLIC void NormalizationStats::merge(NormalizationStats const&other) {
+    if(other.count == 0) {
+        return;
+    }
+    if(count == 0) {
+        *this = other;
+        return;
+    }
+    double n = (double)count;
+    double otherN = (double)other.count;
+    double total = n + otherN;
+    double delta = other.mean - mean;
+    mean += delta * otherN / total;
+    m2 += other.m2 + delta * delta * n * otherN / total;
+    count += other.count;
+    minValue = std::min(minValue, other.minValue);
+    maxValue = std::max(maxValue, other.maxValue);
+}
+PUBLIC void NormalizationStats::add(unsigned char const*data, long length) {
+    merge(reduceBlocks(data, length));
+}
+PUBLIC void NormalizationStats::add(float const*data, long length) {
+    merge(reduceBlocks(data, length));
+}
+PUBLIC double NormalizationStats::getMean() {
+    return mean;
+}
+// sample standard deviation, as NormalizationHelper::getMeanAndStdDev
+PUBLIC double NormalizationStats::getStdDev() {
+    if(count < 2) {
+        return 0;
+    }
+    return sqrt(m2 / (count - 1));
+}
+/// translate and scale so that numStds standard deviations from the mean map to +/- 1
+PUBLIC void NormalizationStats::getStdDevTransform(float numStds, float *p_translate, float *p_scale) {
+    double stdDev = getStdDev();
+    *p_translate = (float)-mean;
+    *p_scale = stdDev == 0 ? 1.0f : (float)(1.0 / stdDev / numStds);
+}
+/// translate and scale so that [min, max] maps to [-1, 1]
+PUBLIC void NormalizationStats::getMinMaxTransform(float *p_translate, float *p_scale) {
+    *p_translate = -(maxValue + minValue) / 2.0f;
+    *p_scale = maxValue == minValue ? 1.0f : 2.0f / (maxValue - minValue);
+}
+PUBLIC STATIC int NormalizationStats::getNumChunks(int numExamples, int chunkSize) {
+    return (numExamples + chunkSize - 1) / chunkSize;
+}
+/// first record of chunk, of getNumChunks(numExamples, chunkSize), out of N records
+///
+/// strided: the N - numExamples records that arent read are shared out evenly
+/// between the gaps before each chunk, and each chunk starts at a random
+/// offset within its share, so chunks never overlap, and cover the whole
+/// dataset, even if it is sorted, eg by label
+PUBLIC STATIC int NormalizationStats::getChunkStart(int N, int numExamples, int chunkSize, bool strided, int chunk) {
+    long long start = (long long)chunk * chunkSize;
+    if(!strided) {
+        return (int)start;
+    }
+    int numChunks = getNumChunks(numExamples, chunkSize);
+    long long unread = N - numExamples;
+    long long shareStart = (long long)chunk * unread / numChunks;
+    long long shareEnd = (long long)(chunk + 1) * unread / numChunks;
+    int offset = Philox::uniformInt(chunk, 0, (int)(shareEnd - shareStart), STATS_SAMPLE_KEY0, STATS_SAMPLE_KEY1);
+    return (int)(start + shareStart + offset);
+}
+PUBLIC STATIC int NormalizationStats::getChunkN(int numExamples, int chunkSize, int chunk) {
+    return std::min(chunkSize, numExamples - chunk * chunkSize);
+}
+/// statistics of numExamples of the N images already in memory
+PUBLIC STATIC NormalizationStats NormalizationStats::compute(unsigned char const*images, int N, int cubeSize, int numExamples, int chunkSize, bool strided) {
+    numExamples = std::min(numExamples, N);
+    NormalizationStats stats;
+    int numChunks = getNumChunks(numExamples, chunkSize);
+    for(int chunk = 0; chunk < numChunks; chunk++) {
+        long start = getChunkStart(N, numExamples, chunkSize, strided, chunk);
+        stats.add(images + start * cubeSize, (long)getChunkN(numExamples, chunkSize, chunk) * cubeSize);
+    }
+    return stats;
+}
+/// statistics of numExamples of the first N records of loader; each chunk is
+/// read while the one before is reduced, with prefetchDepth chunks in memory
+///
+/// gives the same result as reading everything into memory first
+PUBLIC STATIC NormalizationStats NormalizationStats::compute(GenericLoaderv2 *loader, int N, int numExamples, int chunkSize, bool strided, int prefetchDepth) {
+    numExamples = std::min(numExamples, N);
+    int cubeSize = loader->getPlanes() * loader->getImageSize() * loader->getImageSize();
+    int numChunks = getNumChunks(numExamples, chunkSize);
+    // the prefetcher carries on from the first chunk after the last; skip
+    // those.  It loads from one thread at a time, in order
+    int numLoads = 0;
+    BatchPrefetcher prefetcher([&](unsigned char *data, int *labels, int start, int count) {
+        if(numLoads++ >= numChunks) {
+            return;
+        }
+        loader->load(data, labels, getChunkStart(N, numExamples, chunkSize, strided, start / chunkSize), count);
+    }, numExamples, chunkSize, cubeSize, prefetchDepth);
+    NormalizationStats stats;
+    for(int chunk = 0; chunk < numChunks; chunk++) {
+        unsigned char *data;
+        int *labels;
+        prefetcher.acquire(chunk, &data, &labels);
+        stats.add(data, (long)getChunkN(numExamples, chunkSize, chunk) * cubeSize);
+    }
+    prefetcher.release();
+    return stats;
+}
+PUBLIC STATIC std::string NormalizationStats::getCacheFilepath(std::string dataFilepath) {
+    return dataFilepath + ".normstats";
+}
+/// identifies the records compute would read, and what is in them, give or
+/// take changes to the middle of the dataset that keep its size
+PUBLIC STATIC std::string NormalizationStats::getCacheKey(std::string dataFilepath, int N, int cubeSize, int numExamples, int chunkSize, bool strided) {
+    long fileSize = FileHelper::getFilesize(dataFilepath);
+    long hashLength = std::min((long)STATS_HASH_BYTES, fileSize);
+    ostringstream key;
+    key << "fileSize=" << fileSize;
+    if(hashLength > 0) {
+        char *head = FileHelper::readBinaryChunk(dataFilepath, 0, hashLength);
+        char *tail = FileHelper::readBinaryChunk(dataFilepath, fileSize - hashLength, hashLength);
+        key << " head=" << hex << hashBytes(head, hashLength) << " tail=" << hashBytes(tail, hashLength) << dec;
+        delete[] head;
+        delete[] tail;
+    }
+    key << " N=" << N << " cubeSize=" << cubeSize << " numExamples=" << std::min(numExamples, N);
+    // reading the first numExamples gives the same records whatever the chunk size
+    if(strided) {
+        key << " chunkSize=" << chunkSize << " sampling=strided";
+    } else {
+        key << " sampling=first";
+    }
+    return key.str();
+}
+/// loads the statistics from cacheFilepath, if it has them for key
+PUBLIC bool NormalizationStats::readCache(std::string cacheFilepath, std::string key) {
+    ifstream file(FileHelper::localizePath(cacheFilepath).c_str());
+    if(!file.is_open()) {
+        return false;
+    }
+    NormalizationStats cached;
+    bool keyMatches = false;
+    int numValues = 0;
+    string line;
+    while(getline(file, line)) {
+        if(line.size() == 0 || line[0] == '#') {
+            continue;
+        }
+        vector<string> fields = split(line, "\t");
+        if(fields.size() != 2) {
+            return false;
+        }
+        string name = fields[0];
+        char const*value = fields[1].c_str();
+        if(name == "key") {
+            keyMatches = fields[1] == key;
+            continue;
+        }
+        if(name == "count") {
+            cached.count = strtoll(value, 0, 10);
+        } else if(name == "mean") {
+            cached.mean = strtod(value, 0);
+        } else if(name == "m2") {
+            cached.m2 = strtod(value, 0);
+        } else if(name == "min") {
+            cached.minValue = (float)strtod(value, 0);
+        } else if(name == "max") {
+            cached.maxValue = (float)strtod(value, 0);
+        } else {
+            continue;
+        }
+        numValues++;
+    }
+    if(!keyMatches || numValues != 5 || cached.count <= 0) {
+        return false;
+    }
+    *this = cached;
+    return true;
+}
+/// a write that fails only warns: the cache is just an optimization
+PUBLIC void NormalizationStats::writeCache(std::string cacheFilepath, std::string key) {
+    ostringstream contents;
+    contents << "# DeepCL normalization statistics.  Safe to delete" << endl;
+    contents << setprecision(17);
+    contents << "key\t" << key << endl;
+    contents << "count\t" << count << endl;
+    contents << "mean\t" << mean << endl;
+    contents << "m2\t" << m2 << endl;
+    contents << "min\t" << minValue << endl;
+    contents << "max\t" << maxValue << endl;
+    string contentsString = contents.str();
+    try {
+        FileHelper::writeBinaryAtomic(cacheFilepath, contentsString.c_str(), (long)contentsString.size());
+    } catch(runtime_error &e) {
+        cout << "Warning: failed to write normalization statistics cache " << cacheFilepath << ": " << e.what() << endl;
+    }
+}
+PUBLIC std::string NormalizationStats::toString() {
+    ostringstream result;
+    result << "count " << count << " mean " << getMean() << " stdDev " << getStdDev()
+        << " min " << minValue << " max " << maxValue;
+    return result.str();
+}
+
@@ -0,0 +1,71 @@
+// Copyright Hugh Perkins 2015 hughperkins at gmail
+//
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file, You can
+// obtain one at http://mozilla.org/MPL/2.0/.
+
+#pragma once
+
+#include <string>
+
+#include "DeepCLDllExport.h"
+
+class GenericLoaderv2;
+
+#define VIRTUAL virtual
+#define STATIC static
+
+/// \brief count, mean, variance, min and max of a dataset's values, for the normalization layer
+///
+/// add() splits its values into blocks, reduced in parallel on the ThreadPool:
+/// exactly, as integers, for uint8 data, using sse2 where there is one, and
+/// in double, two-pass, for floats.  The blocks are then merged pairwise,
+/// carrying each one's mean and sum of squared differences from it (Chan et
+/// al), rather than a sum and sum of squares, so there is no cancellation,
+/// and the result doesnt depend on the number of threads.
+///
+/// compute() reads numExamples records in chunks of chunkSize: either the
+/// first numExamples, or, strided, chunks spread evenly over the dataset,
+/// each at a random offset within its share.  From a loader, chunks are read
+/// on a BatchPrefetcher thread, while the previous one is being reduced.
+///
+/// The result can be cached in a small text file next to the dataset, keyed by
+/// the dataset's size, a hash of its first and last 64KB, and the sampling
+/// settings, so later runs skip the pass
+class DeepCL_EXPORT NormalizationStats {
+    public:
+    long long count;
+    double mean;
+    double m2; // sum of squared differences from mean
+    float minValue;
+    float maxValue;
+
+    // [[[cog
+    // import cog_addheaders
+    // cog_addheaders.addv2()
+    // ]]]
+    // generated, using cog:
+
+    public:
+    NormalizationStats();
+    void merge(NormalizationStats const&other);
+    void add(unsigned char const*data, long length);
+    void add(float const*data, long length);
+    double getMean();
+    double getStdDev();
+    void getStdDevTransform(float numStds, float *p_translate, float *p_scale);
+    void getMinMaxTransform(float *p_translate, float *p_scale);
+    STATIC int getNumChunks(int numExamples, int chunkSize);
+    STATIC int getChunkStart(int N, int numExamples, int chunkSize, bool strided, int chunk);
+    STATIC int getChunkN(int numExamples, int chunkSize, int chunk);
+    STATIC NormalizationStats compute(unsigned char const*images, int N, int cubeSize, int numExamples, int chunkSize, bool strided);
+    STATIC NormalizationStats compute(GenericLoaderv2 *loader, int N, int numExamples, int chunkSize, bool strided, int prefetchDepth);
+    STATIC std::string getCacheFilepath(std::string dataFilepath);
+    STATIC std::string getCacheKey(std::string dataFilepath, int N, int cubeSize, int numExamples, int chunkSize, bool strided);
+    bool readCache(std::string cacheFilepath, std::string key);
+    void writeCache(std::string cacheFilepath, std::string key);
+    std::string toString();
+
+    // [[[end]]]
+};
+
@@ -6,11 +6,15 @@
 
 #include <iostream>
 
+#include "EasyCL.h"
 #include "net/NeuralNet.h"
 #include "layer/Layer.h"
 #include "RandomPatches.h"
 #include "RandomPatchesMaker.h"
 #include "util/RandomSingleton.h"
+#include "util/Philox.h"
+#include "util/ThreadPool.h"
+#include "util/KernelCache.h"
 #include "PatchExtractor.h"
 
 using namespace std;
@@ -28,7 +32,10 @@ RandomPatches::RandomPatches(Layer *previousLayer, RandomPatchesMaker *maker) :
         outputSize(maker->_patchSize),
         output(0),
         batchSize(0),
-        allocatedSize(0) {
+        allocatedSize(0),
+        cl(maker->cl),
+        kernel(0),
+        outputWrapper(0) {
     if(inputSize == 0) {
 //        maker->net->print();
         throw runtime_error("Error: Pooling layer " + toString(layerIndex) + ": input image size is 0");
@@ -40,8 +47,14 @@ RandomPatches::RandomPatches(Layer *previousLayer, RandomPatchesMaker *maker) :
     if(previousLayer->needsBackProp()) {
         throw runtime_error("Error: RandomPatches layer does not provide backprop currently, so you cannot put it after a layer that needs backprop");
     }
+    if(cl != 0) {
+        buildKernel();
+    }
 }
 VIRTUAL RandomPatches::~RandomPatches() {
+    if(outputWrapper != 0) {
+        delete outputWrapper;
+    }
     if(output != 0) {
         delete[] output;
     }
@@ -54,17 +67,27 @@ VIRTUAL void RandomPatches::setBatchSize(int batchSize) {
         this->batchSize = batchSize;
         return;
     }
+    if(outputWrapper != 0) {
+        delete outputWrapper;
+        outputWrapper = 0;
+    }
     if(output != 0) {
         delete[] output;
     }
     this->batchSize = batchSize;
     this->allocatedSize = batchSize;
     output = new float[ getOutputNumElements() ];
+    if(cl != 0) {
+        outputWrapper = cl->wrap(getOutputNumElements(), output);
+    }
 }
 VIRTUAL int RandomPatches::getOutputNumElements() {
     return batchSize * numPlanes * outputSize * outputSize;
 }
 VIRTUAL float *RandomPatches::getOutput() {
+    if(outputWrapper != 0 && outputWrapper->isDeviceDirty()) {
+        outputWrapper->copyToHost();
+    }
     return output;
 }
 VIRTUAL bool RandomPatches::needsBackProp() {
@@ -86,23 +109,197 @@ VIRTUAL bool RandomPatches::providesGradInputWrapper() const {
     return false;
 }
 VIRTUAL bool RandomPatches::hasOutputWrapper() const {
-    return false;
+    return cl != 0;
+}
+VIRTUAL CLWrapper *RandomPatches::getOutputWrapper() {
+    return outputWrapper;
 }
 VIRTUAL void RandomPatches::forward() {
-    float *upstreamOutput = previousLayer->getOutput();
-    for(int n = 0; n < batchSize; n++) {
-        int patchMargin = inputSize - outputSize;
+    unsigned int seed0 = 0;
+    unsigned int seed1 = 0;
+    if(training) {
+        RandomSingleton *random = RandomSingleton::instance();
+        seed0 = random->_uint32();
+        seed1 = random->_uint32();
+    }
+    forward(seed0, seed1);
+}
+// the patch offsets come only from the seeds, so the device and host
+// versions give the same patches, for the same seeds
+void RandomPatches::forward(unsigned int seed0, unsigned int seed1) {
+    if(cl == 0) {
+        forwardHost(seed0, seed1, previousLayer->getOutput(), output);
+        return;
+    }
+    CLWrapper *upstreamOutputWrapper = 0;
+    if(previousLayer->hasOutputWrapper()) {
+        upstreamOutputWrapper = previousLayer->getOutputWrapper();
+    } else {
+        float *upstreamOutput = previousLayer->getOutput();
+        upstreamOutputWrapper = cl->wrap(previousLayer->getOutputNumElements(), upstreamOutput);
+        upstreamOutputWrapper->copyToDevice();
+    }
+    const int numElements = getOutputNumElements();
+    kernel->in(numElements)
+        ->in(training ? 1 : 0)
+        ->in((int)seed0)
+        ->in((int)seed1)
+        ->in(upstreamOutputWrapper)
+        ->out(outputWrapper);
+    int workgroupSize = 64;
+    int numWorkgroups = (numElements + workgroupSize - 1) / workgroupSize;
+    kernel->run_1d(numWorkgroups * workgroupSize, workgroupSize);
+    cl->finish();
+    if(!previousLayer->hasOutputWrapper()) {
+        delete upstreamOutputWrapper;
+    }
+}
+// host version, one image per task, for when there is no device
+void RandomPatches::forwardHost(unsigned int seed0, unsigned int seed1, float *upstreamOutput, float *output) {
+    const int patchMargin = inputSize - outputSize;
+    ThreadPool::instance()->parallelFor(batchSize, [&](int n) {
         int patchRow = patchMargin / 2;
         int patchCol = patchMargin / 2;
         if(training) {
-            patchRow = RandomSingleton::instance()->uniformInt(0, patchMargin);
-            patchCol = RandomSingleton::instance()->uniformInt(0, patchMargin);
+            patchRow = Philox::uniformInt(2 * n, 0, patchMargin, seed0, seed1);
+            patchCol = Philox::uniformInt(2 * n + 1, 0, patchMargin, seed0, seed1);
         }
         PatchExtractor::extractPatch(n, numPlanes, inputSize, patchSize, patchRow, patchCol, upstreamOutput, output);
-    }
+    });
 }
 VIRTUAL std::string RandomPatches::asString() const {
     return "RandomPatches{ inputPlanes=" + toString(numPlanes) + " inputSize=" + toString(inputSize) + " patchSize=" + toString(patchSize) + " }";
 }
-
+void RandomPatches::buildKernel() {
+    string options = "-DgNumPlanes=" + toString(numPlanes) + " -DgInputSize=" + toString(inputSize)
+        + " -DgOutputSize=" + toString(outputSize);
+    string kernelName = "RandomPatches.random_patches" + options;
+    if(cl->kernelExists(kernelName)) {
+        kernel = cl->getKernel(kernelName);
+        return;
+    }
+    // [[[cog
+    // import stringify
+    // stringify.write_kernel2("kernel", "cl/patches.cl", "random_patches", 'options')
+    // ]]]
+    // generated using cog, from cl/patches.cl:
+    const char * kernelSource =  
+    "// Copyright Hugh Perkins 2015 hughperkins at gmail\n"
+    "//\n"
+    "// This Source Code Form is subject to the terms of the Mozilla Public License,\n"
+    "// v. 2.0. If a copy of the MPL was not distributed with this file, You can\n"
+    "// obtain one at http://mozilla.org/MPL/2.0/.\n"
+    "\n"
+    "// random patches and translations, for data augmentation\n"
+    "// the offsets for image n come from philox counters 2n and 2n+1, so each thread can\n"
+    "// work out its own image's offsets, and the host version in patches/ gets the same ones\n"
+    "//\n"
+    "// expected defines:\n"
+    "// gNumPlanes\n"
+    "// gInputSize\n"
+    "// gOutputSize (random_patches only)\n"
+    "// gTranslateSize (random_translations only)\n"
+    "\n"
+    "// including cl/philox.cl:\n"
+    "// Copyright Hugh Perkins 2015 hughperkins at gmail\n"
+    "//\n"
+    "// This Source Code Form is subject to the terms of the Mozilla Public License,\n"
+    "// v. 2.0. If a copy of the MPL was not distributed with this file, You can\n"
+    "// obtain one at http://mozilla.org/MPL/2.0/.\n"
+    "\n"
+    "// philox4x32-10 counter-based generator, see Salmon et al, 'Parallel random numbers: as\n"
+    "// easy as 1, 2, 3'.  Counter is (index, 0, 0, 0), and the key is the caller's seed, so\n"
+    "// any thread can recompute any index's number, with no state.\n"
+    "// must match util/Philox.cpp\n"
+    "float philoxUniform(const unsigned int index, unsigned int key0, unsigned int key1) {\n"
+    "    unsigned int c0 = index;\n"
+    "    unsigned int c1 = 0;\n"
+    "    unsigned int c2 = 0;\n"
+    "    unsigned int c3 = 0;\n"
+    "    for(int round = 0; round < 10; round++) {\n"
+    "        const unsigned int hi0 = mul_hi(0xD2511F53u, c0);\n"
+    "        const unsigned int lo0 = 0xD2511F53u * c0;\n"
+    "        const unsigned int hi1 = mul_hi(0xCD9E8D57u, c2);\n"
+    "        const unsigned int lo1 = 0xCD9E8D57u * c2;\n"
+    "        c0 = hi1 ^ c1 ^ key0;\n"
+    "        c1 = lo1;\n"
+    "        c2 = hi0 ^ c3 ^ key1;\n"
+    "        c3 = lo0;\n"
+    "        key0 += 0x9E3779B9u;\n"
+    "        key1 += 0xBB67AE85u;\n"
+    "    }\n"
+    "    return (c0 >> 8) * (1.0f / 16777216.0f);\n"
+    "}\n"
+    "\n"
+    "// uniform int in [minValue, maxValue], inclusive\n"
+    "int philoxUniformInt(const unsigned int index, const int minValue, const int maxValue, unsigned int key0, unsigned int key1) {\n"
+    "    const int range = maxValue - minValue + 1;\n"
+    "    const int offset = (int)(philoxUniform(index, key0, key1) * range);\n"
+    "    return minValue + min(offset, range - 1);\n"
+    "}\n"
+    "\n"
+    "\n"
+    "// one thread per output element\n"
+    "// when not training, the patch comes from the centre\n"
+    "#ifdef gOutputSize\n"
+    "kernel void random_patches(\n"
+    "        const int N, const int training,\n"
+    "        const unsigned int seed0, const unsigned int seed1,\n"
+    "        global const float *input,\n"
+    "        global float *output) {\n"
+    "    const int globalId = get_global_id(0);\n"
+    "    if (globalId >= N) {\n"
+    "        return;\n"
+    "    }\n"
+    "    const int col = globalId % gOutputSize;\n"
+    "    const int row = (globalId / gOutputSize) % gOutputSize;\n"
+    "    const int imagePlane = globalId / gOutputSize / gOutputSize;\n"
+    "    const int n = imagePlane / gNumPlanes;\n"
+    "    const int margin = gInputSize - gOutputSize;\n"
+    "    int patchRow = margin / 2;\n"
+    "    int patchCol = margin / 2;\n"
+    "    if (training) {\n"
+    "        patchRow = philoxUniformInt(2 * n, 0, margin, seed0, seed1);\n"
+    "        patchCol = philoxUniformInt(2 * n + 1, 0, margin, seed0, seed1);\n"
+    "    }\n"
+    "    output[globalId] = input[(imagePlane * gInputSize + row + patchRow) * gInputSize + col + patchCol];\n"
+    "}\n"
+    "#endif\n"
+    "\n"
+    "// one thread per output element; output is same size as input\n"
+    "// pixels shifted in from outside the image are zero\n"
+    "// when not training, just copies\n"
+    "#ifdef gTranslateSize\n"
+    "kernel void random_translations(\n"
+    "        const int N, const int training,\n"
+    "        const unsigned int seed0, const unsigned int seed1,\n"
+    "        global const float *input,\n"
+    "        global float *output) {\n"
+    "    const int globalId = get_global_id(0);\n"
+    "    if (globalId >= N) {\n"
+    "        return;\n"
+    "    }\n"
+    "    if (!training) {\n"
+    "        output[globalId] = input[globalId];\n"
+    "        return;\n"
+    "    }\n"
+    "    const int col = globalId % gInputSize;\n"
+    "    const int row = (globalId / gInputSize) % gInputSize;\n"
+    "    const int imagePlane = globalId / gInputSize / gInputSize;\n"
+    "    const int n = imagePlane / gNumPlanes;\n"
+    "    const int inRow = row - philoxUniformInt(2 * n, - gTranslateSize, gTranslateSize, seed0, seed1);\n"
+    "    const int inCol = col - philoxUniformInt(2 * n + 1, - gTranslateSize, gTranslateSize, seed0, seed1);\n"
+    "    float value = 0.0f;\n"
+    "    if (inRow >= 0 && inRow < gInputSize && inCol >= 0 && inCol < gInputSize) {\n"
+    "        value = input[(imagePlane * gInputSize + inRow) * gInputSize + inCol];\n"
+    "    }\n"
+    "    output[globalId] = value;\n"
+    "}\n"
+    "#endif\n"
+    "\n"
+    "";
+    kernel = KernelCache::buildKernelFromString(cl, kernelSource, "random_patches", options, "cl/patches.cl");
+    // [[[end]]]
+    cl->storeKernel(kernelName, kernel, true);
+}
 
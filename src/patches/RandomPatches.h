@@ -11,6 +11,7 @@
 #define VIRTUAL virtual
 #define STATIC static
 
+class EasyCL;
 class CLKernel;
 class CLWrapper;
 class PoolingForward;
@@ -30,6 +31,10 @@ public:
     int batchSize;
     int allocatedSize;
 
+    EasyCL *cl; // NOT owned by us; 0 means use the host version
+    CLKernel *kernel;
+    CLWrapper *outputWrapper;
+
     // [[[cog
     // import cog_addheaders
     // cog_addheaders.add()
@@ -48,8 +53,12 @@ public:
     VIRTUAL int getPersistSize(int version) const;
     VIRTUAL bool providesGradInputWrapper() const;
     VIRTUAL bool hasOutputWrapper() const;
+    VIRTUAL CLWrapper *getOutputWrapper();
     VIRTUAL void forward();
+    void forward(unsigned int seed0, unsigned int seed1);
+    void forwardHost(unsigned int seed0, unsigned int seed1, float *upstreamOutput, float *output);
     VIRTUAL std::string asString() const;
+    void buildKernel();
 
     // [[[end]]]
 };
@@ -9,7 +9,6 @@
 
 #include "EasyCL.h"
 #include "util/stringhelper.h"
-#include "util/StatefulTimer.h"
 
 #include "PoolingBackwardCpu.h"
 #include "PoolingBackwardGpuNaive.h"
@@ -58,7 +57,6 @@ VIRTUAL int PoolingBackward::getOutputNumElements(int batchSize) {
 }
 VIRTUAL void PoolingBackward::backward(int batchSize, float *gradOutput, int *selectors, float *gradInput) {
 //    cout << "PoolingBackward::backward(float *)" << endl;
-    StatefulTimer::instance()->timeCheck("PoolingBackward::backward float->wrapper start");
     CLWrapper *gradOutputWrapper = cl->wrap(getOutputNumElements(batchSize), gradOutput);
     CLWrapper *selectorsWrapper = cl->wrap(getOutputNumElements(batchSize), selectors);
     CLWrapper *gradInputWrapper = cl->wrap(getInputNumElements(batchSize), gradInput);
@@ -74,7 +72,6 @@ VIRTUAL void PoolingBackward::backward(int batchSize, float *gradOutput, int *se
     delete gradOutputWrapper;
     delete selectorsWrapper;
     delete gradInputWrapper;
-    StatefulTimer::instance()->timeCheck("PoolingBackward::backward float->wrapper end");
 }
 VIRTUAL void PoolingBackward::backward(int batchSize, CLWrapper *gradOutputWrapper, CLWrapper *selectorsWrapper, CLWrapper *gradInputWrapper) {
     throw runtime_error("PoolingBackward::backward wrappers not implemented");
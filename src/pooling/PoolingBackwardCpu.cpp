@@ -10,7 +10,6 @@
 
 #include "EasyCL.h"
 #include "PoolingBackward.h"
-#include "util/StatefulTimer.h"
 
 #include "PoolingBackwardCpu.h"
 
@@ -45,7 +44,6 @@ VIRTUAL void PoolingBackwardCpu::backward(int batchSize,  float *gradOutput, int
 }
 VIRTUAL void PoolingBackwardCpu::backward(int batchSize, CLWrapper *gradOutputWrapper, CLWrapper *selectorsWrapper, 
         CLWrapper *gradInputWrapper) {
-    StatefulTimer::instance()->timeCheck("PoolingBackwardCpu::backward start");
 
     gradOutputWrapper->copyToHost();
     selectorsWrapper->copyToHost();
@@ -62,6 +60,5 @@ VIRTUAL void PoolingBackwardCpu::backward(int batchSize, CLWrapper *gradOutputWr
 
     delete[] gradInput;
     
-    StatefulTimer::instance()->timeCheck("PoolingBackwardCpu::backward end");
 }
 
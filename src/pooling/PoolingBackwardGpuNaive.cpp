@@ -10,10 +10,10 @@
 
 #include "EasyCL.h"
 #include "PoolingBackward.h"
-#include "util/StatefulTimer.h"
 #include "util/stringhelper.h"
 
 #include "PoolingBackwardGpuNaive.h"
+#include "util/KernelCache.h"
 
 using namespace std;
 
@@ -29,7 +29,6 @@ VIRTUAL PoolingBackwardGpuNaive::~PoolingBackwardGpuNaive() {
 VIRTUAL void PoolingBackwardGpuNaive::backward(int batchSize, CLWrapper *gradOutputWrapper, CLWrapper *selectorsWrapper, 
         CLWrapper *gradInputWrapper) {
 
-    StatefulTimer::instance()->timeCheck("PoolingBackwardGpuNaive::backward start");
 
     // first, memset errors to 0 ...
     kMemset->out(gradInputWrapper)->in(0.0f)->in(batchSize * numPlanes * inputSize * inputSize);
@@ -46,7 +45,6 @@ VIRTUAL void PoolingBackwardGpuNaive::backward(int batchSize, CLWrapper *gradOut
     kernel->run_1d(numWorkgroups * workgroupSize, workgroupSize);
     cl->finish();
 
-    StatefulTimer::instance()->timeCheck("PoolingBackwardGpuNaive::backward end");
 }
 PoolingBackwardGpuNaive::PoolingBackwardGpuNaive(EasyCL *cl, bool padZeros, int numPlanes, int inputSize, int poolingSize) :
         PoolingBackward(cl, padZeros, numPlanes, inputSize, poolingSize) {
@@ -116,7 +114,7 @@ PoolingBackwardGpuNaive::PoolingBackwardGpuNaive(EasyCL *cl, bool padZeros, int
     "}\n"
     "\n"
     "";
-    kernel = cl->buildKernelFromString(kernelSource, "backward", options, "cl/PoolingBackwardGpuNaive.cl");
+    kernel = KernelCache::buildKernelFromString(cl, kernelSource, "backward", options, "cl/PoolingBackwardGpuNaive.cl");
     // generated using cog, from cl/memset.cl:
     const char * kMemsetSource =  
     "// Copyright Hugh Perkins 2015 hughperkins at gmail\n"
@@ -133,7 +131,7 @@ PoolingBackwardGpuNaive::PoolingBackwardGpuNaive(EasyCL *cl, bool padZeros, int
     "}\n"
     "\n"
     "";
-    kMemset = cl->buildKernelFromString(kMemsetSource, "cl_memset", "", "cl/memset.cl");
+    kMemset = KernelCache::buildKernelFromString(cl, kMemsetSource, "cl_memset", "", "cl/memset.cl");
     // [[[end]]]
 }
 
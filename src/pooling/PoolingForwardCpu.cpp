@@ -9,7 +9,6 @@
 
 #include "EasyCL.h"
 
-#include "util/StatefulTimer.h"
 
 #include "PoolingForwardCpu.h"
 
@@ -49,7 +48,6 @@ VIRTUAL void PoolingForwardCpu::forward(int batchSize, CLWrapper *inputWrapper,
 VIRTUAL void PoolingForwardCpu::forward(int batchSize, float *input, int *selectors, float *output) {
 //    float *output = new float[ getOutputNumElements(batchSize) ];
 //    cout << "PoolingForwardCpu::forward(float *)" << endl;
-    StatefulTimer::instance()->timeCheck("PoolingForwardCpu::forward start");
     for(int n = 0; n < batchSize; n++) {
         for(int plane = 0; plane < numPlanes; plane++) {
             for(int outputRow = 0; outputRow < outputSize; outputRow++) {
@@ -76,7 +74,6 @@ VIRTUAL void PoolingForwardCpu::forward(int batchSize, float *input, int *select
             }
         }
     }
-    StatefulTimer::instance()->timeCheck("PoolingForwardCpu::forward end");
 //    return output;
 }
 
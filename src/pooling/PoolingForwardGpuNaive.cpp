@@ -9,10 +9,10 @@
 
 #include "EasyCL.h"
 
-#include "util/StatefulTimer.h"
 #include "util/stringhelper.h"
 
 #include "PoolingForwardGpuNaive.h"
+#include "util/KernelCache.h"
 
 //#include "test/PrintBuffer.h"
 
@@ -28,7 +28,6 @@ VIRTUAL PoolingForwardGpuNaive::~PoolingForwardGpuNaive() {
 }
 VIRTUAL void PoolingForwardGpuNaive::forward(int batchSize, CLWrapper *inputWrapper, CLWrapper *selectorsWrapper, CLWrapper *outputWrapper) {
 //    cout << StatefulTimer::instance()->prefix << "PoolingForwardGpuNaive::forward(CLWrapper *)" << endl;
-    StatefulTimer::instance()->timeCheck("PoolingForwardGpuNaive::forward start");
 
     kernel->input(batchSize)->input(inputWrapper)->output(selectorsWrapper)->output(outputWrapper);
     int globalSize = batchSize * numPlanes * outputSize * outputSize;
@@ -41,7 +40,6 @@ VIRTUAL void PoolingForwardGpuNaive::forward(int batchSize, CLWrapper *inputWrap
 //    cout << "PoolingForwardGpuNaive::forward selectorswrapper:" << endl;
 //    PrintBuffer::printInts(cl, selectorsWrapper, outputSize, outputSize);
 
-    StatefulTimer::instance()->timeCheck("PoolingForwardGpuNaive::forward end");
 }
 PoolingForwardGpuNaive::PoolingForwardGpuNaive(EasyCL *cl, bool padZeros, int numPlanes, int inputSize, int poolingSize) :
         PoolingForward(cl, padZeros, numPlanes, inputSize, poolingSize) {
@@ -107,7 +105,7 @@ PoolingForwardGpuNaive::PoolingForwardGpuNaive(EasyCL *cl, bool padZeros, int nu
     "}\n"
     "\n"
     "";
-    kernel = cl->buildKernelFromString(kernelSource, "forwardNaive", options, "cl/pooling.cl");
+    kernel = KernelCache::buildKernelFromString(cl, kernelSource, "forwardNaive", options, "cl/pooling.cl");
     // [[[end]]]
 //    kernel = cl->buildKernel("pooling.cl", "forwardNaive", options);
 }
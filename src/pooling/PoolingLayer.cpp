@@ -54,10 +54,8 @@ PoolingLayer::PoolingLayer(EasyCL *cl, Layer *previousLayer, PoolingMaker *maker
 VIRTUAL PoolingLayer::~PoolingLayer() {
     delete poolingForwardImpl;
     delete poolingBackpropImpl;
-    if(outputWrapper != 0) {
+    if(!sharedOutput) {
         delete outputWrapper;
-    }
-    if(output != 0) {
         delete[] output;
     }
     if(selectorsWrapper != 0) {
@@ -82,10 +80,8 @@ VIRTUAL void PoolingLayer::setBatchSize(int batchSize) {
         this->batchSize = batchSize;
         return;
     }
-    if(outputWrapper != 0) {
+    if(!sharedOutput) {
         delete outputWrapper;
-    }
-    if(output != 0) {
         delete[] output;
     }
     if(selectorsWrapper != 0) {
@@ -94,21 +90,31 @@ VIRTUAL void PoolingLayer::setBatchSize(int batchSize) {
     if(selectors != 0) {
         delete[] selectors;
     }
-    if(gradInputWrapper != 0) {
-        delete gradInputWrapper;
-    }
-    if(gradInput != 0) {
-        delete[] gradInput;
-    }
+    delete gradInputWrapper;
+    delete[] gradInput;
+    gradInputWrapper = 0;
+    gradInput = 0;
     this->batchSize = batchSize;
     this->allocatedSize = batchSize;
-    output = new float[ getOutputNumElements() ];
-    outputWrapper = cl->wrap(getOutputNumElements(), output);
+    // a shared output belongs to the net
+    if(!sharedOutput) {
+        output = new float[ getOutputNumElements() ];
+        outputWrapper = cl->wrap(getOutputNumElements(), output);
+    }
     selectors = new int[ getOutputNumElements() ];
     selectorsWrapper = cl->wrap(getOutputNumElements(), selectors);
-    gradInput = new float[ previousLayer->getOutputNumElements() ];
-    gradInputWrapper = cl->wrap(previousLayer->getOutputNumElements(), gradInput);
-    gradInputWrapper->createOnDevice();
+    // a shared output means inference only, so no gradients
+    if(!sharedOutput) {
+        gradInput = new float[ previousLayer->getOutputNumElements() ];
+        gradInputWrapper = cl->wrap(previousLayer->getOutputNumElements(), gradInput);
+        gradInputWrapper->createOnDevice();
+    }
+}
+VIRTUAL bool PoolingLayer::canShareOutput() const {
+    return true;
+}
+VIRTUAL void PoolingLayer::setSharedOutput(float *output, CLWrapper *outputWrapper) {
+    adoptSharedOutput(output, outputWrapper, &this->output, &this->outputWrapper, &gradInput, &gradInputWrapper, &allocatedSize);
 }
 VIRTUAL int PoolingLayer::getOutputNumElements() {
     return batchSize * numPlanes * outputSize * outputSize;
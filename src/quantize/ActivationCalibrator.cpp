@@ -0,0 +1,61 @@
+// Copyright Hugh Perkins 2015 hughperkins at gmail
+//
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file, You can
+// obtain one at http://mozilla.org/MPL/2.0/.
+
+#include <stdexcept>
+#include <cmath>
+#include <algorithm>
+
+#include "net/NeuralNet.h"
+#include "layer/Layer.h"
+#include "util/stringhelper.h"
+
+#include "quantize/ActivationCalibrator.h"
+
+using namespace std;
+
+#undef VIRTUAL
+#undef STATIC
+#define VIRTUAL
+#define STATIC
+
+PUBLIC ActivationCalibrator::ActivationCalibrator() :
+        numExamples(0) {
+}
+// net should just have been forwarded, with batchSize examples
+PUBLIC void ActivationCalibrator::observe(NeuralNet *net, int batchSize) {
+    const int numLayers = net->getNumLayers();
+    if(absMax.size() == 0) {
+        absMax.resize(numLayers, 0.0f);
+    } else if((int)absMax.size() != numLayers) {
+        throw runtime_error("ActivationCalibrator: net has " + toString(numLayers) + " layers, but was calibrating "
+            + toString(absMax.size()));
+    }
+    for(int layerIndex = 0; layerIndex < numLayers; layerIndex++) {
+        Layer *layer = net->getLayer(layerIndex);
+        float const*output = layer->getOutput();
+        const int numValues = batchSize * layer->getOutputCubeSize();
+        float layerMax = absMax[layerIndex];
+        for(int i = 0; i < numValues; i++) {
+            layerMax = std::max(layerMax, fabsf(output[i]));
+        }
+        absMax[layerIndex] = layerMax;
+    }
+    numExamples += batchSize;
+}
+PUBLIC int ActivationCalibrator::getNumExamples() {
+    return numExamples;
+}
+PUBLIC int ActivationCalibrator::getNumLayers() {
+    return (int)absMax.size();
+}
+// largest absolute value seen in the output of layer layerIndex
+PUBLIC float ActivationCalibrator::getAbsMax(int layerIndex) {
+    if(layerIndex < 0 || layerIndex >= (int)absMax.size()) {
+        throw runtime_error("ActivationCalibrator: no calibration data for layer " + toString(layerIndex));
+    }
+    return absMax[layerIndex];
+}
+
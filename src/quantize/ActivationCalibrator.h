@@ -0,0 +1,49 @@
+// Copyright Hugh Perkins 2015 hughperkins at gmail
+//
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file, You can
+// obtain one at http://mozilla.org/MPL/2.0/.
+
+#pragma once
+
+#include <vector>
+
+#include "DeepCLDllExport.h"
+
+class NeuralNet;
+
+#define VIRTUAL virtual
+#define STATIC static
+
+/// \brief records the range of each layer's output, over sample data
+///
+/// Call observe after each forward of the float net, over a few batches of
+/// representative data; QuantizedNet::quantize then uses the ranges to scale
+/// each convolutional and fully-connected layer's int8 input
+class DeepCL_EXPORT ActivationCalibrator {
+    private:
+    #ifdef _WIN32
+    #pragma warning(disable: 4251)
+    #endif
+    std::vector<float> absMax;
+    #ifdef _WIN32
+    #pragma warning(default: 4251)
+    #endif
+    int numExamples;
+
+    // [[[cog
+    // import cog_addheaders
+    // cog_addheaders.addv2()
+    // ]]]
+    // generated, using cog:
+
+    public:
+    ActivationCalibrator();
+    void observe(NeuralNet *net, int batchSize);
+    int getNumExamples();
+    int getNumLayers();
+    float getAbsMax(int layerIndex);
+
+    // [[[end]]]
+};
+
@@ -0,0 +1,96 @@
+// Copyright Hugh Perkins 2015 hughperkins at gmail
+//
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file, You can
+// obtain one at http://mozilla.org/MPL/2.0/.
+
+#include <cmath>
+#include <sstream>
+
+#include "quantize/QuantizationReport.h"
+
+using namespace std;
+
+#undef VIRTUAL
+#undef STATIC
+#define VIRTUAL
+#define STATIC
+
+static int argmax(int n, float const*values) {
+    int best = 0;
+    for(int i = 1; i < n; i++) {
+        if(values[i] > values[best]) {
+            best = i;
+        }
+    }
+    return best;
+}
+
+PUBLIC QuantizationReport::QuantizationReport() :
+        numExamples(0),
+        numAgree(0),
+        numLabelled(0),
+        floatRight(0),
+        quantizedRight(0),
+        numValues(0),
+        sumAbsDiff(0),
+        maxAbsDiff(0) {
+}
+// labels can be 0, if there are none; then only agreement and differences are reported
+PUBLIC void QuantizationReport::add(int batchSize, int outputCubeSize, float const*floatOutput, float const*quantizedOutput, int const*labels) {
+    for(int n = 0; n < batchSize; n++) {
+        float const*floatExample = floatOutput + n * outputCubeSize;
+        float const*quantizedExample = quantizedOutput + n * outputCubeSize;
+        int floatLabel = argmax(outputCubeSize, floatExample);
+        int quantizedLabel = argmax(outputCubeSize, quantizedExample);
+        if(floatLabel == quantizedLabel) {
+            numAgree++;
+        }
+        if(labels != 0) {
+            numLabelled++;
+            floatRight += floatLabel == labels[n] ? 1 : 0;
+            quantizedRight += quantizedLabel == labels[n] ? 1 : 0;
+        }
+        for(int i = 0; i < outputCubeSize; i++) {
+            float diff = fabsf(floatExample[i] - quantizedExample[i]);
+            sumAbsDiff += diff;
+            if(diff > maxAbsDiff) {
+                maxAbsDiff = diff;
+            }
+        }
+        numValues += outputCubeSize;
+    }
+    numExamples += batchSize;
+}
+PUBLIC long QuantizationReport::getNumExamples() {
+    return numExamples;
+}
+// fraction of examples where both nets give the same top-1
+PUBLIC float QuantizationReport::getAgreement() {
+    return numExamples == 0 ? 0.0f : (float)numAgree / numExamples;
+}
+PUBLIC float QuantizationReport::getFloatAccuracy() {
+    return numLabelled == 0 ? 0.0f : (float)floatRight / numLabelled;
+}
+PUBLIC float QuantizationReport::getQuantizedAccuracy() {
+    return numLabelled == 0 ? 0.0f : (float)quantizedRight / numLabelled;
+}
+PUBLIC float QuantizationReport::getMaxAbsDiff() {
+    return maxAbsDiff;
+}
+PUBLIC float QuantizationReport::getMeanAbsDiff() {
+    return numValues == 0 ? 0.0f : (float)(sumAbsDiff / numValues);
+}
+PUBLIC std::string QuantizationReport::toString() {
+    ostringstream ss;
+    ss << "examples: " << numExamples << endl;
+    if(numLabelled > 0) {
+        ss << "float accuracy: " << (getFloatAccuracy() * 100.0f) << "%" << endl;
+        ss << "int8 accuracy: " << (getQuantizedAccuracy() * 100.0f) << "%" << endl;
+        ss << "accuracy change: " << ((getQuantizedAccuracy() - getFloatAccuracy()) * 100.0f) << "%" << endl;
+    }
+    ss << "top-1 agreement: " << (getAgreement() * 100.0f) << "%" << endl;
+    ss << "output abs diff: max " << maxAbsDiff << " mean " << getMeanAbsDiff();
+    return ss.str();
+}
+
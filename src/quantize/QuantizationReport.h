@@ -0,0 +1,50 @@
+// Copyright Hugh Perkins 2015 hughperkins at gmail
+//
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file, You can
+// obtain one at http://mozilla.org/MPL/2.0/.
+
+#pragma once
+
+#include <string>
+
+#include "DeepCLDllExport.h"
+
+#define VIRTUAL virtual
+#define STATIC static
+
+/// \brief how far a quantized net's outputs are from the float net's
+///
+/// Add the outputs of both nets, batch by batch, for the same inputs.  Top-1
+/// is the argmax over each example's output cube
+class DeepCL_EXPORT QuantizationReport {
+    private:
+    long numExamples;
+    long numAgree;
+    long numLabelled;
+    long floatRight;
+    long quantizedRight;
+    long numValues;
+    double sumAbsDiff;
+    float maxAbsDiff;
+
+    // [[[cog
+    // import cog_addheaders
+    // cog_addheaders.addv2()
+    // ]]]
+    // generated, using cog:
+
+    public:
+    QuantizationReport();
+    void add(int batchSize, int outputCubeSize, float const*floatOutput, float const*quantizedOutput, int const*labels);
+    long getNumExamples();
+    float getAgreement();
+    float getFloatAccuracy();
+    float getQuantizedAccuracy();
+    float getMaxAbsDiff();
+    float getMeanAbsDiff();
+    std::string toString();
+
+    // [[[end]]]
+};
+
@@ -0,0 +1,459 @@
+// Copyright Hugh Perkins 2015 hughperkins at gmail
+//
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file, You can
+// obtain one at http://mozilla.org/MPL/2.0/.
+
+#include <stdexcept>
+#include <cstring>
+#include <cmath>
+#include <algorithm>
+
+#include "activate/ActivationFunction.h"
+#include "util/ThreadPool.h"
+#include "util/stringhelper.h"
+
+#include "quantize/QuantizedLayer.h"
+
+using namespace std;
+
+#undef VIRTUAL
+#undef STATIC
+#define VIRTUAL
+#define STATIC
+
+// number of filters each task works on, as in ForwardCpuThreaded
+#define FILTER_BLOCK 4
+
+static void writeInt(vector<char> *buffer, int value) {
+    buffer->insert(buffer->end(), reinterpret_cast<char const*>(&value), reinterpret_cast<char const*>(&value) + 4);
+}
+static void writeFloat(vector<char> *buffer, float value) {
+    buffer->insert(buffer->end(), reinterpret_cast<char const*>(&value), reinterpret_cast<char const*>(&value) + 4);
+}
+static void writeBytes(vector<char> *buffer, void const*data, long numBytes) {
+    buffer->insert(buffer->end(), reinterpret_cast<char const*>(data), reinterpret_cast<char const*>(data) + numBytes);
+}
+static void readBytes(char const*data, long size, long *pos, void *target, long numBytes) {
+    if(numBytes < 0 || *pos + numBytes > size) {
+        throw runtime_error("QuantizedLayer: quantized model file is truncated");
+    }
+    memcpy(target, data + *pos, numBytes);
+    *pos += numBytes;
+}
+static int readInt(char const*data, long size, long *pos) {
+    int value;
+    readBytes(data, size, pos, &value, 4);
+    return value;
+}
+static float readFloat(char const*data, long size, long *pos) {
+    float value;
+    readBytes(data, size, pos, &value, 4);
+    return value;
+}
+// sum of a[i] * b[i], in int32; simple enough for the compiler to vectorize
+static inline int dotInt8(int n, signed char const*a, signed char const*b) {
+    int sum = 0;
+    for(int i = 0; i < n; i++) {
+        sum += a[i] * b[i];
+    }
+    return sum;
+}
+// y[i] += a * x[i], in int32
+static inline void axpyInt8(int n, int a, signed char const*x, int *y) {
+    for(int i = 0; i < n; i++) {
+        y[i] += a * x[i];
+    }
+}
+static inline signed char quantizeValue(float value, float invScale) {
+    float scaled = value * invScale;
+    if(scaled > 127.0f) {
+        scaled = 127.0f;
+    } else if(scaled < -127.0f) {
+        scaled = -127.0f;
+    }
+    return (signed char)(scaled < 0 ? scaled - 0.5f : scaled + 0.5f);
+}
+
+PUBLIC QuantizedLayer::QuantizedLayer(int type, int inputPlanes, int inputSize, int outputPlanes, int outputSize) :
+        type(type),
+        inputPlanes(inputPlanes),
+        inputSize(inputSize),
+        outputPlanes(outputPlanes),
+        outputSize(outputSize),
+        translate(0.0f),
+        scale(1.0f),
+        filterSize(0),
+        padZeros(false),
+        biased(false),
+        inputScale(1.0f),
+        fn(0),
+        poolingSize(0),
+        perPlane(false),
+        output(0),
+        allocatedSize(0) {
+    if(type < NORMALIZE || type > COPY) {
+        throw runtime_error("QuantizedLayer: unknown layer type " + toString(type));
+    }
+}
+PUBLIC QuantizedLayer::~QuantizedLayer() {
+    delete fn;
+    delete[] output;
+}
+PUBLIC int QuantizedLayer::getInputCubeSize() const {
+    return inputPlanes * inputSize * inputSize;
+}
+PUBLIC int QuantizedLayer::getOutputCubeSize() const {
+    return outputPlanes * outputSize * outputSize;
+}
+PUBLIC float *QuantizedLayer::getOutput() {
+    return output;
+}
+PUBLIC void QuantizedLayer::setActivation(std::string activation) {
+    delete fn;
+    fn = 0;
+    fn = ActivationFunction::fromName(activation);
+    this->activation = activation;
+}
+// CONV only.  filterSize, padZeros and biased should be set first.
+// Each filter gets its own scale, so that one filter with large weights
+// doesnt cost the others their precision.  inputAbsMax is the largest
+// absolute input value seen during calibration; inputs beyond it saturate
+PUBLIC void QuantizedLayer::quantizeWeights(float const*floatWeights, float const*floatBias, float inputAbsMax) {
+    const int filterCubeSize = inputPlanes * filterSize * filterSize;
+    filterScales.resize(outputPlanes);
+    weights.resize(outputPlanes * filterCubeSize);
+    for(int filter = 0; filter < outputPlanes; filter++) {
+        float const*filterWeights = floatWeights + filter * filterCubeSize;
+        float absMax = 0.0f;
+        for(int i = 0; i < filterCubeSize; i++) {
+            absMax = std::max(absMax, fabsf(filterWeights[i]));
+        }
+        filterScales[filter] = absMax > 0.0f ? absMax / 127.0f : 1.0f;
+        float invScale = 1.0f / filterScales[filter];
+        for(int i = 0; i < filterCubeSize; i++) {
+            weights[filter * filterCubeSize + i] = quantizeValue(filterWeights[i], invScale);
+        }
+    }
+    bias.clear();
+    if(biased) {
+        bias.assign(floatBias, floatBias + outputPlanes);
+    }
+    inputScale = inputAbsMax > 0.0f ? inputAbsMax / 127.0f : 1.0f;
+}
+// bytes of parameters held, for comparing against the float model
+PUBLIC int QuantizedLayer::getWeightsBytes() const {
+    return (int)(weights.size() + sizeof(float) * (filterScales.size() + bias.size()));
+}
+// returns this layer's output, batchSize * getOutputCubeSize() floats, which
+// stays valid until the next call
+PUBLIC float const*QuantizedLayer::forward(int batchSize, float const*input) {
+    const int numOutputs = batchSize * getOutputCubeSize();
+    if(numOutputs > allocatedSize) {
+        delete[] output;
+        output = new float[numOutputs];
+        allocatedSize = numOutputs;
+    }
+    const int numInputs = batchSize * getInputCubeSize();
+    switch(type) {
+        case NORMALIZE:
+            for(int i = 0; i < numInputs; i++) {
+                output[i] = (input[i] + translate) * scale;
+            }
+            break;
+        case CONV:
+            forwardConv(batchSize, input);
+            break;
+        case ACTIVATION:
+            for(int i = 0; i < numInputs; i++) {
+                output[i] = fn->calc(input[i]);
+            }
+            break;
+        case POOLING:
+            forwardPooling(batchSize, input);
+            break;
+        case SOFTMAX:
+            forwardSoftMax(batchSize, input);
+            break;
+        case SCALE:
+            for(int i = 0; i < numInputs; i++) {
+                output[i] = input[i] * scale;
+            }
+            break;
+        case CROP:
+            forwardCrop(batchSize, input);
+            break;
+        case COPY:
+            memcpy(output, input, sizeof(float) * numInputs);
+            break;
+    }
+    return output;
+}
+PRIVATE void QuantizedLayer::forwardConv(int batchSize, float const*input) {
+    ThreadPool *pool = ThreadPool::instance();
+    const int padding = padZeros ? filterSize / 2 : 0;
+    const int paddedSize = inputSize + 2 * padding;
+    const int paddedCubeSize = inputPlanes * paddedSize * paddedSize;
+    const int needed = batchSize * paddedCubeSize;
+    if((int)quantizedInput.size() < needed) {
+        // borders stay zero from here on, we only ever overwrite the interior
+        quantizedInput.assign(needed, 0);
+    }
+    pool->parallelFor(batchSize, [&](int n) {
+        quantizeImage(input + n * getInputCubeSize(), &quantizedInput[n * paddedCubeSize], paddedSize);
+    });
+    const bool fullyConnected = outputSize == 1 && padding == 0 && filterSize == inputSize;
+    const int numFilterBlocks = (outputPlanes + FILTER_BLOCK - 1) / FILTER_BLOCK;
+    pool->parallelFor(batchSize * numFilterBlocks, [&](int task) {
+        int n = task / numFilterBlocks;
+        int filterStart = (task % numFilterBlocks) * FILTER_BLOCK;
+        int filterEnd = std::min(filterStart + FILTER_BLOCK, outputPlanes);
+        signed char const*paddedImage = &quantizedInput[n * paddedCubeSize];
+        float *imageOutput = output + n * getOutputCubeSize();
+        if(fullyConnected) {
+            fcTile(paddedImage, filterStart, filterEnd, imageOutput);
+        } else {
+            convTile(paddedImage, paddedSize, filterStart, filterEnd, imageOutput);
+        }
+    });
+}
+// quantizes one image into the interior of its zero-bordered slot
+PRIVATE void QuantizedLayer::quantizeImage(float const*image, signed char *paddedImage, int paddedSize) {
+    const int padding = (paddedSize - inputSize) / 2;
+    const float invScale = 1.0f / inputScale;
+    for(int plane = 0; plane < inputPlanes; plane++) {
+        for(int row = 0; row < inputSize; row++) {
+            float const*inputRow = image + (plane * inputSize + row) * inputSize;
+            signed char *paddedRow = paddedImage + (plane * paddedSize + row + padding) * paddedSize + padding;
+            for(int col = 0; col < inputSize; col++) {
+                paddedRow[col] = quantizeValue(inputRow[col], invScale);
+            }
+        }
+    }
+}
+// output planes [filterStart, filterEnd) of one image, same loop order as
+// ForwardCpuThreaded::forwardTile, but accumulating int8 products in int32
+PRIVATE void QuantizedLayer::convTile(signed char const*paddedImage, int paddedSize, int filterStart, int filterEnd, float *imageOutput) {
+    const int outputSizeSquared = outputSize * outputSize;
+    // int32 sums for the block, on the stack unless the planes are large
+    int accumulators[FILTER_BLOCK * 1024];
+    vector<int> bigAccumulators;
+    int *acc = accumulators;
+    if(outputSizeSquared > 1024) {
+        bigAccumulators.resize(FILTER_BLOCK * outputSizeSquared);
+        acc = &bigAccumulators[0];
+    }
+    memset(acc, 0, sizeof(int) * (filterEnd - filterStart) * outputSizeSquared);
+    for(int inPlane = 0; inPlane < inputPlanes; inPlane++) {
+        signed char const*inputPlane = paddedImage + inPlane * paddedSize * paddedSize;
+        for(int filterRow = 0; filterRow < filterSize; filterRow++) {
+            for(int filterCol = 0; filterCol < filterSize; filterCol++) {
+                int blockWeights[FILTER_BLOCK];
+                for(int filter = filterStart; filter < filterEnd; filter++) {
+                    blockWeights[filter - filterStart] = weights[((filter * inputPlanes + inPlane)
+                        * filterSize + filterRow) * filterSize + filterCol];
+                }
+                for(int outRow = 0; outRow < outputSize; outRow++) {
+                    signed char const*inputRow = inputPlane + (outRow + filterRow) * paddedSize + filterCol;
+                    for(int filter = filterStart; filter < filterEnd; filter++) {
+                        axpyInt8(outputSize, blockWeights[filter - filterStart], inputRow,
+                            acc + (filter - filterStart) * outputSizeSquared + outRow * outputSize);
+                    }
+                }
+            }
+        }
+    }
+    for(int filter = filterStart; filter < filterEnd; filter++) {
+        int const*filterAcc = acc + (filter - filterStart) * outputSizeSquared;
+        float *outPlane = imageOutput + filter * outputSizeSquared;
+        float multiplier = inputScale * filterScales[filter];
+        float initial = biased ? bias[filter] : 0.0f;
+        for(int i = 0; i < outputSizeSquared; i++) {
+            outPlane[i] = filterAcc[i] * multiplier + initial;
+        }
+    }
+}
+// fully-connected: each output is one dot product, over the whole input cube
+PRIVATE void QuantizedLayer::fcTile(signed char const*image, int filterStart, int filterEnd, float *imageOutput) {
+    const int cubeSize = getInputCubeSize();
+    for(int filter = filterStart; filter < filterEnd; filter++) {
+        int acc = dotInt8(cubeSize, image, &weights[filter * cubeSize]);
+        imageOutput[filter] = acc * inputScale * filterScales[filter] + (biased ? bias[filter] : 0.0f);
+    }
+}
+// max pooling, as PoolingForwardCpu
+PRIVATE void QuantizedLayer::forwardPooling(int batchSize, float const*input) {
+    for(int n = 0; n < batchSize; n++) {
+        for(int plane = 0; plane < inputPlanes; plane++) {
+            float const*inputPlane = input + (n * inputPlanes + plane) * inputSize * inputSize;
+            float *outputPlane = output + (n * outputPlanes + plane) * outputSize * outputSize;
+            for(int outputRow = 0; outputRow < outputSize; outputRow++) {
+                int inputRow = outputRow * poolingSize;
+                for(int outputCol = 0; outputCol < outputSize; outputCol++) {
+                    int inputCol = outputCol * poolingSize;
+                    float maxValue = inputPlane[inputRow * inputSize + inputCol];
+                    for(int dx = 0; dx < poolingSize; dx++) {
+                        for(int dy = 0; dy < poolingSize; dy++) {
+                            if(inputRow + dx < inputSize && inputCol + dy < inputSize) {
+                                maxValue = std::max(maxValue, inputPlane[(inputRow + dx) * inputSize + inputCol + dy]);
+                            }
+                        }
+                    }
+                    outputPlane[outputRow * outputSize + outputCol] = maxValue;
+                }
+            }
+        }
+    }
+}
+// same groups as SoftMaxLayer: per-plane, or across planes at each pixel
+PRIVATE void QuantizedLayer::forwardSoftMax(int batchSize, float const*input) {
+    const int imageSizeSquared = inputSize * inputSize;
+    const int groupSize = perPlane ? imageSizeSquared : inputPlanes;
+    const int groupInner = perPlane ? 1 : imageSizeSquared;
+    const int numGroups = batchSize * (perPlane ? inputPlanes : imageSizeSquared);
+    for(int group = 0; group < numGroups; group++) {
+        const int base = (group / groupInner) * groupSize * groupInner + group % groupInner;
+        float maxValue = input[base];
+        for(int i = 1; i < groupSize; i++) {
+            maxValue = std::max(maxValue, input[base + i * groupInner]);
+        }
+        float sum = 0.0f;
+        for(int i = 0; i < groupSize; i++) {
+            float value = expf(input[base + i * groupInner] - maxValue);
+            output[base + i * groupInner] = value;
+            sum += value;
+        }
+        for(int i = 0; i < groupSize; i++) {
+            output[base + i * groupInner] /= sum;
+        }
+    }
+}
+// RandomPatches at inference: the patch from the centre
+PRIVATE void QuantizedLayer::forwardCrop(int batchSize, float const*input) {
+    const int margin = (inputSize - outputSize) / 2;
+    for(int imagePlane = 0; imagePlane < batchSize * inputPlanes; imagePlane++) {
+        for(int row = 0; row < outputSize; row++) {
+            memcpy(output + (imagePlane * outputSize + row) * outputSize,
+                input + (imagePlane * inputSize + row + margin) * inputSize + margin,
+                sizeof(float) * outputSize);
+        }
+    }
+}
+PUBLIC void QuantizedLayer::write(std::vector<char> *buffer) const {
+    writeInt(buffer, type);
+    writeInt(buffer, inputPlanes);
+    writeInt(buffer, inputSize);
+    writeInt(buffer, outputPlanes);
+    writeInt(buffer, outputSize);
+    switch(type) {
+        case NORMALIZE:
+            writeFloat(buffer, translate);
+            writeFloat(buffer, scale);
+            break;
+        case CONV:
+            writeInt(buffer, filterSize);
+            writeInt(buffer, padZeros ? 1 : 0);
+            writeInt(buffer, biased ? 1 : 0);
+            writeFloat(buffer, inputScale);
+            writeBytes(buffer, &filterScales[0], sizeof(float) * outputPlanes);
+            if(biased) {
+                writeBytes(buffer, &bias[0], sizeof(float) * outputPlanes);
+            }
+            writeBytes(buffer, &weights[0], weights.size());
+            break;
+        case ACTIVATION:
+            writeInt(buffer, (int)activation.size());
+            writeBytes(buffer, activation.c_str(), activation.size());
+            break;
+        case POOLING:
+            writeInt(buffer, poolingSize);
+            writeInt(buffer, padZeros ? 1 : 0);
+            break;
+        case SOFTMAX:
+            writeInt(buffer, perPlane ? 1 : 0);
+            break;
+        case SCALE:
+            writeFloat(buffer, scale);
+            break;
+    }
+}
+// reads one layer written by write, starting at *pos, and moves *pos past it
+PUBLIC STATIC QuantizedLayer *QuantizedLayer::read(char const*data, long size, long *pos) {
+    int type = readInt(data, size, pos);
+    int inputPlanes = readInt(data, size, pos);
+    int inputSize = readInt(data, size, pos);
+    int outputPlanes = readInt(data, size, pos);
+    int outputSize = readInt(data, size, pos);
+    QuantizedLayer *layer = new QuantizedLayer(type, inputPlanes, inputSize, outputPlanes, outputSize);
+    try {
+        switch(type) {
+            case NORMALIZE:
+                layer->translate = readFloat(data, size, pos);
+                layer->scale = readFloat(data, size, pos);
+                break;
+            case CONV: {
+                layer->filterSize = readInt(data, size, pos);
+                layer->padZeros = readInt(data, size, pos) != 0;
+                layer->biased = readInt(data, size, pos) != 0;
+                layer->inputScale = readFloat(data, size, pos);
+                layer->filterScales.resize(outputPlanes);
+                readBytes(data, size, pos, &layer->filterScales[0], sizeof(float) * outputPlanes);
+                if(layer->biased) {
+                    layer->bias.resize(outputPlanes);
+                    readBytes(data, size, pos, &layer->bias[0], sizeof(float) * outputPlanes);
+                }
+                layer->weights.resize((long)outputPlanes * inputPlanes * layer->filterSize * layer->filterSize);
+                readBytes(data, size, pos, &layer->weights[0], layer->weights.size());
+                break;
+            }
+            case ACTIVATION: {
+                int nameLength = readInt(data, size, pos);
+                string name(std::max(nameLength, 0), ' ');
+                readBytes(data, size, pos, &name[0], nameLength);
+                layer->setActivation(name);
+                break;
+            }
+            case POOLING:
+                layer->poolingSize = readInt(data, size, pos);
+                layer->padZeros = readInt(data, size, pos) != 0;
+                break;
+            case SOFTMAX:
+                layer->perPlane = readInt(data, size, pos) != 0;
+                break;
+            case SCALE:
+                layer->scale = readFloat(data, size, pos);
+                break;
+        }
+    } catch(...) {
+        delete layer;
+        throw;
+    }
+    return layer;
+}
+PUBLIC STATIC std::string QuantizedLayer::typeToString(int type) {
+    switch(type) {
+        case NORMALIZE: return "normalize";
+        case CONV: return "conv";
+        case ACTIVATION: return "activation";
+        case POOLING: return "pooling";
+        case SOFTMAX: return "softmax";
+        case SCALE: return "scale";
+        case CROP: return "crop";
+        case COPY: return "copy";
+    }
+    return "unknown";
+}
+PUBLIC std::string QuantizedLayer::asString() const {
+    string result = "QuantizedLayer{ " + typeToString(type) + " " + toString(inputPlanes) + "x" + toString(inputSize)
+        + "x" + toString(inputSize) + " -> " + toString(outputPlanes) + "x" + toString(outputSize) + "x" + toString(outputSize);
+    if(type == CONV) {
+        result += " filterSize=" + toString(filterSize) + " padZeros=" + toString(padZeros)
+            + " biased=" + toString(biased) + " inputScale=" + toString(inputScale);
+    } else if(type == ACTIVATION) {
+        result += " " + activation;
+    } else if(type == POOLING) {
+        result += " poolingSize=" + toString(poolingSize);
+    }
+    return result + " }";
+}
+
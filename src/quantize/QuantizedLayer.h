@@ -0,0 +1,111 @@
+// Copyright Hugh Perkins 2015 hughperkins at gmail
+//
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file, You can
+// obtain one at http://mozilla.org/MPL/2.0/.
+
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include "DeepCLDllExport.h"
+
+class ActivationFunction;
+
+#define VIRTUAL virtual
+#define STATIC static
+
+/// \brief one layer of a QuantizedNet, runs on the cpu, no OpenCL needed
+///
+/// Convolutional and fully-connected layers hold int8 weights, one float scale
+/// per filter, and the scale of one int8 step of their input, calibrated from
+/// sample data.  They quantize their input, accumulate in int32, and
+/// dequantize the output, adding the float bias.  The other layers work on
+/// floats, as in the float net, at inference.
+class DeepCL_EXPORT QuantizedLayer {
+    public:
+    // these values are stored in quantized model files, so only ever append
+    enum Type {
+        NORMALIZE = 1,
+        CONV = 2,
+        ACTIVATION = 3,
+        POOLING = 4,
+        SOFTMAX = 5,
+        SCALE = 6,
+        CROP = 7,
+        COPY = 8
+    };
+
+    const int type;
+    const int inputPlanes;
+    const int inputSize;
+    const int outputPlanes;
+    const int outputSize;
+
+    // NORMALIZE: (x + translate) * scale; SCALE: x * scale
+    float translate;
+    float scale;
+
+    // CONV, fully-connected layers are convs with filterSize == inputSize
+    int filterSize;
+    bool padZeros;
+    bool biased;
+    float inputScale;
+    #ifdef _WIN32
+    #pragma warning(disable: 4251)
+    #endif
+    std::vector<float> filterScales;
+    std::vector<signed char> weights; // [filter][inputPlane][row][col]
+    std::vector<float> bias;
+    std::vector<signed char> quantizedInput;
+
+    // ACTIVATION
+    std::string activation;
+    #ifdef _WIN32
+    #pragma warning(default: 4251)
+    #endif
+    ActivationFunction *fn;
+
+    // POOLING uses padZeros too
+    int poolingSize;
+
+    // SOFTMAX
+    bool perPlane;
+
+    float *output;
+    int allocatedSize;
+
+    // [[[cog
+    // import cog_addheaders
+    // cog_addheaders.addv2()
+    // ]]]
+    // generated, using cog:
+
+    public:
+    QuantizedLayer(int type, int inputPlanes, int inputSize, int outputPlanes, int outputSize);
+    ~QuantizedLayer();
+    int getInputCubeSize() const;
+    int getOutputCubeSize() const;
+    float *getOutput();
+    void setActivation(std::string activation);
+    void quantizeWeights(float const*floatWeights, float const*floatBias, float inputAbsMax);
+    int getWeightsBytes() const;
+    float const*forward(int batchSize, float const*input);
+    void write(std::vector<char> *buffer) const;
+    STATIC QuantizedLayer *read(char const*data, long size, long *pos);
+    STATIC std::string typeToString(int type);
+    std::string asString() const;
+
+    private:
+    void forwardConv(int batchSize, float const*input);
+    void quantizeImage(float const*image, signed char *paddedImage, int paddedSize);
+    void convTile(signed char const*paddedImage, int paddedSize, int filterStart, int filterEnd, float *imageOutput);
+    void fcTile(signed char const*image, int filterStart, int filterEnd, float *imageOutput);
+    void forwardPooling(int batchSize, float const*input);
+    void forwardSoftMax(int batchSize, float const*input);
+    void forwardCrop(int batchSize, float const*input);
+
+    // [[[end]]]
+};
+
@@ -0,0 +1,260 @@
+// Copyright Hugh Perkins 2015 hughperkins at gmail
+//
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file, You can
+// obtain one at http://mozilla.org/MPL/2.0/.
+
+#include <stdexcept>
+#include <cstring>
+
+#include "net/NeuralNet.h"
+#include "layer/Layer.h"
+#include "normalize/NormalizationLayer.h"
+#include "conv/ConvolutionalLayer.h"
+#include "fc/FullyConnectedLayer.h"
+#include "activate/ActivationLayer.h"
+#include "activate/ActivationFunction.h"
+#include "pooling/PoolingLayer.h"
+#include "dropout/DropoutLayer.h"
+#include "patches/RandomPatches.h"
+#include "patches/RandomTranslations.h"
+#include "forcebackprop/ForceBackpropLayer.h"
+#include "loss/SoftMaxLayer.h"
+#include "loss/LossLayer.h"
+#include "util/FileHelper.h"
+#include "util/stringhelper.h"
+#include "util/ProfileScope.h"
+#include "util/Profiler.h"
+#include "quantize/ActivationCalibrator.h"
+#include "quantize/QuantizedLayer.h"
+
+#include "quantize/QuantizedNet.h"
+
+using namespace std;
+
+#undef VIRTUAL
+#undef STATIC
+#define VIRTUAL
+#define STATIC
+
+// file layout: magic, then int32 version, numLayers, inputPlanes, inputSize,
+// then each layer, as written by QuantizedLayer::write
+static const char *quantizedMagic = "ClQ8";
+static const int quantizedVersion = 1;
+
+PUBLIC QuantizedNet::QuantizedNet(int inputPlanes, int inputSize) :
+        inputPlanes(inputPlanes),
+        inputSize(inputSize),
+        batchSize(0) {
+}
+PUBLIC QuantizedNet::~QuantizedNet() {
+    for(int i = 0; i < (int)layers.size(); i++) {
+        delete layers[i];
+    }
+}
+// net's first layer is its InputLayer, which has no counterpart here.  Each
+// convolutional and fully-connected layer's input is scaled from the range
+// calibrator saw at the output of the layer before
+PUBLIC STATIC QuantizedNet *QuantizedNet::quantize(NeuralNet *net, ActivationCalibrator *calibrator) {
+    if(calibrator->getNumLayers() != net->getNumLayers()) {
+        throw runtime_error("QuantizedNet::quantize: calibrator hasnt observed this net");
+    }
+    Layer *inputLayer = net->getLayer(0);
+    QuantizedNet *quantized = new QuantizedNet(inputLayer->getOutputPlanes(), inputLayer->getOutputSize());
+    try {
+        for(int layerIndex = 1; layerIndex < net->getNumLayers(); layerIndex++) {
+            Layer *layer = net->getLayer(layerIndex);
+            Layer *previous = net->getLayer(layerIndex - 1);
+            int type = 0;
+            ConvolutionalLayer *conv = dynamic_cast<ConvolutionalLayer *>(layer);
+            if(dynamic_cast<FullyConnectedLayer *>(layer) != 0) {
+                conv = dynamic_cast<FullyConnectedLayer *>(layer)->convolutionalLayer;
+            }
+            if(dynamic_cast<NormalizationLayer *>(layer) != 0) {
+                type = QuantizedLayer::NORMALIZE;
+            } else if(conv != 0) {
+                type = QuantizedLayer::CONV;
+            } else if(dynamic_cast<ActivationLayer *>(layer) != 0) {
+                type = QuantizedLayer::ACTIVATION;
+            } else if(dynamic_cast<PoolingLayer *>(layer) != 0) {
+                type = QuantizedLayer::POOLING;
+            } else if(dynamic_cast<SoftMaxLayer *>(layer) != 0) {
+                type = QuantizedLayer::SOFTMAX;
+            } else if(dynamic_cast<DropoutLayer *>(layer) != 0) {
+                type = QuantizedLayer::SCALE;
+            } else if(dynamic_cast<RandomPatches *>(layer) != 0) {
+                type = QuantizedLayer::CROP;
+            } else if(dynamic_cast<RandomTranslations *>(layer) != 0 || dynamic_cast<ForceBackpropLayer *>(layer) != 0
+                    || dynamic_cast<LossLayer *>(layer) != 0) {
+                type = QuantizedLayer::COPY;
+            } else {
+                throw runtime_error("QuantizedNet::quantize: layer " + toString(layerIndex) + " "
+                    + layer->getClassName() + " not supported");
+            }
+            QuantizedLayer *quantizedLayer = new QuantizedLayer(type, previous->getOutputPlanes(),
+                previous->getOutputSize(), layer->getOutputPlanes(), layer->getOutputSize());
+            quantized->addLayer(quantizedLayer);
+            if(type == QuantizedLayer::NORMALIZE) {
+                NormalizationLayer *normalization = dynamic_cast<NormalizationLayer *>(layer);
+                quantizedLayer->translate = normalization->translate;
+                quantizedLayer->scale = normalization->scale;
+            } else if(type == QuantizedLayer::CONV) {
+                if(conv->dim.skip != 0) {
+                    throw runtime_error("QuantizedNet::quantize: layer " + toString(layerIndex) + ": skip not supported");
+                }
+                if(conv->dim.isEven && conv->dim.padZeros) {
+                    throw runtime_error("QuantizedNet::quantize: layer " + toString(layerIndex)
+                        + ": even filter sizes with padzeros not supported");
+                }
+                quantizedLayer->filterSize = conv->dim.filterSize;
+                quantizedLayer->padZeros = conv->dim.padZeros;
+                quantizedLayer->biased = conv->dim.biased;
+                quantizedLayer->quantizeWeights(conv->getWeights(), conv->dim.biased ? conv->getBias() : 0,
+                    calibrator->getAbsMax(layerIndex - 1));
+            } else if(type == QuantizedLayer::ACTIVATION) {
+                quantizedLayer->setActivation(dynamic_cast<ActivationLayer *>(layer)->fn->getName());
+            } else if(type == QuantizedLayer::POOLING) {
+                PoolingLayer *pooling = dynamic_cast<PoolingLayer *>(layer);
+                quantizedLayer->poolingSize = pooling->poolingSize;
+                quantizedLayer->padZeros = pooling->padZeros;
+            } else if(type == QuantizedLayer::SOFTMAX) {
+                quantizedLayer->perPlane = dynamic_cast<SoftMaxLayer *>(layer)->perPlane;
+            } else if(type == QuantizedLayer::SCALE) {
+                // dropout, at inference
+                quantizedLayer->scale = dynamic_cast<DropoutLayer *>(layer)->dropRatio;
+            }
+        }
+    } catch(...) {
+        delete quantized;
+        throw;
+    }
+    return quantized;
+}
+// takes ownership of layer
+PUBLIC void QuantizedNet::addLayer(QuantizedLayer *layer) {
+    int planes = layers.size() == 0 ? inputPlanes : layers.back()->outputPlanes;
+    int size = layers.size() == 0 ? inputSize : layers.back()->outputSize;
+    if(layer->inputPlanes != planes || layer->inputSize != size) {
+        delete layer;
+        throw runtime_error("QuantizedNet::addLayer: layer input doesnt match previous layer output");
+    }
+    Profiler::setLayerName(this, (int)layers.size(), "int8 " + QuantizedLayer::typeToString(layer->type));
+    layers.push_back(layer);
+}
+PUBLIC int QuantizedNet::getNumLayers() {
+    return (int)layers.size();
+}
+PUBLIC QuantizedLayer *QuantizedNet::getLayer(int index) {
+    return layers[index];
+}
+PUBLIC int QuantizedNet::getInputPlanes() {
+    return inputPlanes;
+}
+PUBLIC int QuantizedNet::getInputSize() {
+    return inputSize;
+}
+PUBLIC int QuantizedNet::getInputCubeSize() {
+    return inputPlanes * inputSize * inputSize;
+}
+PUBLIC int QuantizedNet::getOutputCubeSize() {
+    return layers.size() == 0 ? getInputCubeSize() : layers.back()->getOutputCubeSize();
+}
+PUBLIC int QuantizedNet::getWeightsBytes() {
+    int total = 0;
+    for(int i = 0; i < (int)layers.size(); i++) {
+        total += layers[i]->getWeightsBytes();
+    }
+    return total;
+}
+// input is batchSize * getInputCubeSize() floats; returns the last layer's
+// output, valid until the next call
+PUBLIC float const*QuantizedNet::forward(int batchSize, float const*input) {
+    if(layers.size() == 0) {
+        throw runtime_error("QuantizedNet::forward: no layers");
+    }
+    this->batchSize = batchSize;
+    float const*layerInput = input;
+    for(int i = 0; i < (int)layers.size(); i++) {
+        ProfileScope profile(0, Profiler::FORWARD, this, i);
+        layerInput = layers[i]->forward(batchSize, layerInput);
+    }
+    return layerInput;
+}
+PUBLIC float const*QuantizedNet::getOutput() {
+    return layers.back()->getOutput();
+}
+// argmax of each softmax group of the last forward, like SoftMaxLayer::getLabels
+PUBLIC void QuantizedNet::getLabels(int *labels) {
+    QuantizedLayer *last = layers.back();
+    if(last->type != QuantizedLayer::SOFTMAX) {
+        throw runtime_error("QuantizedNet::getLabels: last layer must be softmax, to output labels");
+    }
+    const int imageSizeSquared = last->outputSize * last->outputSize;
+    const int groupSize = last->perPlane ? imageSizeSquared : last->outputPlanes;
+    const int groupInner = last->perPlane ? 1 : imageSizeSquared;
+    const int numGroups = batchSize * (last->perPlane ? last->outputPlanes : imageSizeSquared);
+    float const*output = last->getOutput();
+    for(int group = 0; group < numGroups; group++) {
+        const int base = (group / groupInner) * groupSize * groupInner + group % groupInner;
+        int best = 0;
+        for(int i = 1; i < groupSize; i++) {
+            if(output[base + i * groupInner] > output[base + best * groupInner]) {
+                best = i;
+            }
+        }
+        labels[group] = best;
+    }
+}
+PUBLIC void QuantizedNet::save(std::string filepath) {
+    vector<char> buffer(quantizedMagic, quantizedMagic + 4);
+    int header[4] = { quantizedVersion, (int)layers.size(), inputPlanes, inputSize };
+    buffer.insert(buffer.end(), reinterpret_cast<char *>(header), reinterpret_cast<char *>(header) + sizeof(header));
+    for(int i = 0; i < (int)layers.size(); i++) {
+        layers[i]->write(&buffer);
+    }
+    FileHelper::writeBinaryAtomic(filepath, &buffer[0], (long)buffer.size());
+}
+PUBLIC STATIC QuantizedNet *QuantizedNet::load(std::string filepath) {
+    long size = 0;
+    char *data = FileHelper::readBinary(filepath, &size);
+    if(size < 20 || strncmp(data, quantizedMagic, 4) != 0) {
+        delete[] data;
+        throw runtime_error("QuantizedNet::load: " + filepath + " is not a quantized model file");
+    }
+    int header[4];
+    memcpy(header, data + 4, sizeof(header));
+    if(header[0] != quantizedVersion) {
+        delete[] data;
+        throw runtime_error("QuantizedNet::load: " + filepath + " has version " + toString(header[0])
+            + ", but only version " + toString(quantizedVersion) + " is supported");
+    }
+    QuantizedNet *net = new QuantizedNet(header[2], header[3]);
+    long pos = 20;
+    try {
+        for(int i = 0; i < header[1]; i++) {
+            net->addLayer(QuantizedLayer::read(data, size, &pos));
+        }
+    } catch(...) {
+        delete[] data;
+        delete net;
+        throw;
+    }
+    delete[] data;
+    return net;
+}
+PUBLIC STATIC bool QuantizedNet::isQuantizedFile(std::string filepath) {
+    if(!FileHelper::exists(filepath) || FileHelper::getFilesize(filepath) < 4) {
+        return false;
+    }
+    char magic[4];
+    FileHelper::readBinaryChunk(magic, filepath, 0, 4);
+    return strncmp(magic, quantizedMagic, 4) == 0;
+}
+PUBLIC std::string QuantizedNet::asString() {
+    string result = "QuantizedNet{ input=" + toString(inputPlanes) + "x" + toString(inputSize) + "x" + toString(inputSize) + "\n";
+    for(int i = 0; i < (int)layers.size(); i++) {
+        result += "    " + toString(i) + ": " + layers[i]->asString() + "\n";
+    }
+    return result + "}";
+}
+
@@ -0,0 +1,69 @@
+// Copyright Hugh Perkins 2015 hughperkins at gmail
+//
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file, You can
+// obtain one at http://mozilla.org/MPL/2.0/.
+
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include "DeepCLDllExport.h"
+
+class NeuralNet;
+class QuantizedLayer;
+class ActivationCalibrator;
+
+#define VIRTUAL virtual
+#define STATIC static
+
+/// \brief int8 copy of a trained NeuralNet, for inference on the cpu
+///
+/// Built from the float net by quantize, after calibrating on sample data, and
+/// saved to / loaded from its own file format, so deepcl_predict can run it
+/// without an OpenCL device.  Weights take a quarter of the space of the float
+/// net's.  Input is the raw input, as for the float net: the normalization
+/// layer is part of the quantized net
+class DeepCL_EXPORT QuantizedNet {
+    private:
+    #ifdef _WIN32
+    #pragma warning(disable: 4251)
+    #endif
+    std::vector<QuantizedLayer *> layers;
+    #ifdef _WIN32
+    #pragma warning(default: 4251)
+    #endif
+    int inputPlanes;
+    int inputSize;
+    int batchSize;
+
+    // [[[cog
+    // import cog_addheaders
+    // cog_addheaders.addv2()
+    // ]]]
+    // generated, using cog:
+
+    public:
+    QuantizedNet(int inputPlanes, int inputSize);
+    ~QuantizedNet();
+    STATIC QuantizedNet *quantize(NeuralNet *net, ActivationCalibrator *calibrator);
+    void addLayer(QuantizedLayer *layer);
+    int getNumLayers();
+    QuantizedLayer *getLayer(int index);
+    int getInputPlanes();
+    int getInputSize();
+    int getInputCubeSize();
+    int getOutputCubeSize();
+    int getWeightsBytes();
+    float const*forward(int batchSize, float const*input);
+    float const*getOutput();
+    void getLabels(int *labels);
+    void save(std::string filepath);
+    STATIC QuantizedNet *load(std::string filepath);
+    STATIC bool isQuantizedFile(std::string filepath);
+    std::string asString();
+
+    // [[[end]]]
+};
+
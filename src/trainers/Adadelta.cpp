@@ -7,6 +7,8 @@
 #include <iostream>
 
 #include "util/stringhelper.h"
+#include "util/ProfileScope.h"
+#include "util/Profiler.h"
 #include "net/NeuralNet.h"
 #include "layer/Layer.h"
 #include "loss/LossLayer.h"
@@ -16,6 +18,7 @@
 #include "loss/IAcceptsLabels.h"
 #include "batch/NetAction.h"
 #include "clmath/CLMathWrapper.h"
+#include "clmath/FusedOp.h"
 #include "batch/BatchData.h"
 
 //#include "test/Sampler.h"
@@ -42,17 +45,15 @@ VIRTUAL void Adadelta::updateWeights(CLWrapper *weightsWrapper, CLWrapper *gradW
     // weights += update
 
     int numWeights = trainerState->numWeights;
-    float *working = new float[ numWeights ];
-    CLWrapper *workingWrapper = cl->wrap(numWeights, working);
-    workingWrapper->createOnDevice();
+    FusedOp fused(cl, numWeights);
 
-    CLMathWrapper clWeights(weightsWrapper);
-    CLMathWrapper clGradWeights(gradWeightsWrapper);
-    CLMathWrapper clSumGradSquared(trainerState->sumGradSquaredWrapper);
-    CLMathWrapper clSumUpdateSquared(trainerState->sumUpdateSquaredWrapper);
-    CLMathWrapper clWorking(workingWrapper);
+    CLMathWrapper clWeights(weightsWrapper, &fused);
+    CLMathWrapper clGradWeights(gradWeightsWrapper, &fused);
+    CLMathWrapper clSumGradSquared(trainerState->sumGradSquaredWrapper, &fused);
+    CLMathWrapper clSumUpdateSquared(trainerState->sumUpdateSquaredWrapper, &fused);
+    CLMathWrapper clWorking(&fused); // registers only, no buffer
 
-    // following all happens on gpu, via clmathwrapper:
+    // following all gets recorded, then runs on the gpu as a single kernel:
     clWorking = clGradWeights;
     clWorking.squared();
     clWorking *= (1 - decay);
@@ -74,20 +75,20 @@ VIRTUAL void Adadelta::updateWeights(CLWrapper *weightsWrapper, CLWrapper *gradW
     clWorking *= (1 - decay);
     clSumUpdateSquared += clWorking;
 
-    delete workingWrapper;
-    delete[] working;
+    fused.run();
 }
 VIRTUAL BatchResult Adadelta::trainNet(NeuralNet *net, TrainingContext *context,
-    float const*input, OutputData *outputData) {
+    InputData *inputData, OutputData *outputData) {
     // learns one batch, including updating weights
     // doesnt have to think about running multiple batches,
     // or loading data, or anything like that
     bindState(net);
 
-    net->forward(input);
+    inputData->forward(net);
     int numRight = net->calcNumRight(outputData);
     float loss = net->calcLoss(outputData);
     net->backward(outputData);
+    reduceGradients(net);
 
     int numLayers = net->getNumLayers();
     for(int layerIdx = numLayers - 2; layerIdx > 0; layerIdx--) {
@@ -96,6 +97,7 @@ VIRTUAL BatchResult Adadelta::trainNet(NeuralNet *net, TrainingContext *context,
             break;
         }
         if(layer->needsTrainerState()) {
+            ProfileScope profile(cl, Profiler::UPDATE, net, layerIdx);
             updateWeights(layer->getWeightsWrapper(), layer->getGradWeightsWrapper(), 
                 dynamic_cast< AdadeltaState * >(layer->getTrainerState()) );
             if(layer->biased()) {
@@ -109,12 +111,14 @@ VIRTUAL BatchResult Adadelta::trainNet(NeuralNet *net, TrainingContext *context,
 VIRTUAL BatchResult Adadelta::trainNet(NeuralNet *net, TrainingContext *context,
         float const*input, float const*expectedOutput) {
     ExpectedData expectedData(net, expectedOutput);
-    return this->trainNet(net, context, input, &expectedData);
+    InputData inputData(net, input);
+    return this->trainNet(net, context, &inputData, &expectedData);
 }
 VIRTUAL BatchResult Adadelta::trainNetFromLabels(NeuralNet *net, TrainingContext *context,
         float const*input, int const*labels) {
     LabeledData labeledData(net, labels);
-    return this->trainNet(net, context, input, &labeledData);
+    InputData inputData(net, input);
+    return this->trainNet(net, context, &inputData, &labeledData);
 }
 VIRTUAL void Adadelta::bindState(NeuralNet *net) {
     AdadeltaStateMaker stateMaker;
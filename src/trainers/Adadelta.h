@@ -16,6 +16,7 @@
 class AdadeltaState;
 class CLWrapper;
 class EasyCL;
+class InputData;
 class OutputData;
 
 #include "DeepCLDllExport.h"
@@ -38,7 +39,7 @@ public:
     VIRTUAL void updateWeights(CLWrapper *weightsWrapper, CLWrapper *gradWeightsWrapper,
     AdadeltaState *trainerState);
     VIRTUAL BatchResult trainNet(NeuralNet *net, TrainingContext *context,
-    float const*input, OutputData *outputData);
+    InputData *inputData, OutputData *outputData);
     VIRTUAL BatchResult trainNet(NeuralNet *net, TrainingContext *context,
     float const*input, float const*expectedOutput);
     VIRTUAL BatchResult trainNetFromLabels(NeuralNet *net, TrainingContext *context,
@@ -7,6 +7,8 @@
 #include <iostream>
 
 #include "util/stringhelper.h"
+#include "util/ProfileScope.h"
+#include "util/Profiler.h"
 #include "net/NeuralNet.h"
 #include "layer/Layer.h"
 #include "loss/LossLayer.h"
@@ -16,6 +18,7 @@
 #include "loss/IAcceptsLabels.h"
 #include "batch/NetAction.h"
 #include "clmath/CLMathWrapper.h"
+#include "clmath/FusedOp.h"
 #include "batch/BatchData.h"
 
 //#include "test/Sampler.h"
@@ -41,16 +44,14 @@ VIRTUAL void Adagrad::updateWeights(CLWrapper *weightsWrapper, CLWrapper *gradWe
         AdagradState *trainerState) {
 
     int numWeights = trainerState->numWeights;
-    float *working = new float[ numWeights ];
-    CLWrapper *workingWrapper = cl->wrap(numWeights, working);
-    workingWrapper->createOnDevice();
+    FusedOp fused(cl, numWeights);
 
-    CLMathWrapper clWeights(weightsWrapper);
-    CLMathWrapper clGradWeights(gradWeightsWrapper);
-    CLMathWrapper clSumSquares(trainerState->sumSquaresWrapper);
-    CLMathWrapper clWorking(workingWrapper);
+    CLMathWrapper clWeights(weightsWrapper, &fused);
+    CLMathWrapper clGradWeights(gradWeightsWrapper, &fused);
+    CLMathWrapper clSumSquares(trainerState->sumSquaresWrapper, &fused);
+    CLMathWrapper clWorking(&fused); // registers only, no buffer
 
-    // following all happens on gpu, via clmathwrapper:
+    // following all gets recorded, then runs on the gpu as a single kernel:
     clWorking = clGradWeights;
     clWorking.squared();
     clSumSquares += clWorking;
@@ -62,20 +63,20 @@ VIRTUAL void Adagrad::updateWeights(CLWrapper *weightsWrapper, CLWrapper *gradWe
     clWorking *= - learningRate;
     clWeights += clWorking;
 
-    delete workingWrapper;
-    delete[] working;
+    fused.run();
 }
 VIRTUAL BatchResult Adagrad::trainNet(NeuralNet *net, TrainingContext *context,
-    float const*input, OutputData *outputData) {
+    InputData *inputData, OutputData *outputData) {
     // learns one batch, including updating weights
     // doesnt have to think about running multiple batches,
     // or loading data, or anything like that
     bindState(net);
 
-    net->forward(input);
+    inputData->forward(net);
     int numRight = net->calcNumRight(outputData);
     float loss = net->calcLoss(outputData);
     net->backward(outputData);
+    reduceGradients(net);
 
     int numLayers = net->getNumLayers();
     for(int layerIdx = numLayers - 2; layerIdx > 0; layerIdx--) {
@@ -84,6 +85,7 @@ VIRTUAL BatchResult Adagrad::trainNet(NeuralNet *net, TrainingContext *context,
             break;
         }
         if(layer->needsTrainerState()) {
+            ProfileScope profile(cl, Profiler::UPDATE, net, layerIdx);
             updateWeights(layer->getWeightsWrapper(), layer->getGradWeightsWrapper(), 
                 dynamic_cast< AdagradState * >(layer->getTrainerState()) );
             if(layer->biased()) {
@@ -97,12 +99,14 @@ VIRTUAL BatchResult Adagrad::trainNet(NeuralNet *net, TrainingContext *context,
 VIRTUAL BatchResult Adagrad::trainNet(NeuralNet *net, TrainingContext *context,
         float const*input, float const*expectedOutput) {
     ExpectedData expectedData(net, expectedOutput);
-    return this->trainNet(net, context, input, &expectedData);
+    InputData inputData(net, input);
+    return this->trainNet(net, context, &inputData, &expectedData);
 }
 VIRTUAL BatchResult Adagrad::trainNetFromLabels(NeuralNet *net, TrainingContext *context,
         float const*input, int const*labels) {
     LabeledData labeledData(net, labels);
-    return this->trainNet(net, context, input, &labeledData);
+    InputData inputData(net, input);
+    return this->trainNet(net, context, &inputData, &labeledData);
 }
 VIRTUAL void Adagrad::bindState(NeuralNet *net) {
     AdagradStateMaker stateMaker(fudgeFactor);
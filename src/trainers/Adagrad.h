@@ -16,6 +16,7 @@
 class AdagradState;
 class CLWrapper;
 class EasyCL;
+class InputData;
 class OutputData;
 
 #include "DeepCLDllExport.h"
@@ -40,7 +41,7 @@ public:
     VIRTUAL void updateWeights(CLWrapper *weightsWrapper, CLWrapper *gradWeightsWrapper,
     AdagradState *trainerState);
     VIRTUAL BatchResult trainNet(NeuralNet *net, TrainingContext *context,
-    float const*input, OutputData *outputData);
+    InputData *inputData, OutputData *outputData);
     VIRTUAL BatchResult trainNet(NeuralNet *net, TrainingContext *context,
     float const*input, float const*expectedOutput);
     VIRTUAL BatchResult trainNetFromLabels(NeuralNet *net, TrainingContext *context,
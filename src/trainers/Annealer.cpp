@@ -10,9 +10,12 @@
 #include "trainers/Trainer.h"
 #include "EasyCL.h"
 #include "util/stringhelper.h"
+#include "util/ProfileScope.h"
+#include "util/Profiler.h"
 #include "net/NeuralNet.h"
 #include "layer/Layer.h"
 #include "clmath/CLMathWrapper.h"
+#include "clmath/FusedOp.h"
 #include "loss/LossLayer.h"
 #include "loss/IAcceptsLabels.h"
 #include "batch/BatchData.h"
@@ -57,25 +60,22 @@ VIRTUAL void Annealer::updateWeights(float annealedLearningRate, CLWrapper *weig
 
     int numWeights = weightsWrapper->size();
 
-    float *gradWeightsCopy = new float[ numWeights ];
-    CLWrapper *gradWeightsCopyWrapper = cl->wrap(numWeights, gradWeightsCopy);
-    gradWeightsCopyWrapper->createOnDevice();
+    FusedOp fused(cl, numWeights);
 
-    CLMathWrapper gradWeights_(gradWeightsWrapper);
-    CLMathWrapper gradWeightsCopy_(gradWeightsCopyWrapper);
-    CLMathWrapper weights_(weightsWrapper);
+    CLMathWrapper gradWeights_(gradWeightsWrapper, &fused);
+    CLMathWrapper gradWeightsCopy_(&fused); // registers only, no buffer
+    CLMathWrapper weights_(weightsWrapper, &fused);
 
-    // following all happens on gpu, via CLMathWrapper:
+    // following all gets recorded, then runs on the gpu as a single kernel:
     gradWeightsCopy_ = gradWeights_;
     gradWeightsCopy_ *= - annealedLearningRate;
     weights_ += gradWeightsCopy_;
 
-    delete gradWeightsCopyWrapper;
-    delete[] gradWeightsCopy;
+    fused.run();
 }
 VIRTUAL BatchResult Annealer::trainNet( 
         NeuralNet *net, TrainingContext *context,
-        float const *input, OutputData *outputData) {
+        InputData *inputData, OutputData *outputData) {
 
     // hmmmm, so all we need to do is calculate:
     // annealedLearningRate = learningRate * pow(anneal, epoch)
@@ -89,10 +89,11 @@ VIRTUAL BatchResult Annealer::trainNet(
 
     bindState(net);
 
-    net->forward(input);
+    inputData->forward(net);
     int numRight = net->calcNumRight(outputData);
     float loss = net->calcLoss(outputData);
     net->backward(outputData);
+    reduceGradients(net);
 
     int numLayers = net->getNumLayers();
     for(int layerIdx = numLayers - 2; layerIdx > 0; layerIdx--) {
@@ -101,6 +102,7 @@ VIRTUAL BatchResult Annealer::trainNet(
             break;
         }
         if(layer->needsTrainerState()) {
+            ProfileScope profile(cl, Profiler::UPDATE, net, layerIdx);
             updateWeights(annealedLearningRate, layer->getWeightsWrapper(), layer->getGradWeightsWrapper());
             if(layer->biased()) {
                 updateWeights(annealedLearningRate, layer->getBiasWrapper(), layer->getGradBiasWrapper());
@@ -112,12 +114,14 @@ VIRTUAL BatchResult Annealer::trainNet(
 VIRTUAL BatchResult Annealer::trainNet(NeuralNet *net, TrainingContext *context,
         float const*input, float const*expectedOutput) {
     ExpectedData expectedData(net, expectedOutput);
-    return this->trainNet(net, context, input, &expectedData);
+    InputData inputData(net, input);
+    return this->trainNet(net, context, &inputData, &expectedData);
 }
 VIRTUAL BatchResult Annealer::trainNetFromLabels(NeuralNet *net, TrainingContext *context,
         float const*input, int const*labels) {
     LabeledData labeledData(net, labels);
-    return this->trainNet(net, context, input, &labeledData);
+    InputData inputData(net, input);
+    return this->trainNet(net, context, &inputData, &labeledData);
 }
 VIRTUAL void Annealer::bindState(NeuralNet *net) {
     // since we have no state, all we will do is strip any existing state,
@@ -16,6 +16,7 @@
 class CLWrapper;
 class EasyCL;
 class NeuralNet;
+class InputData;
 class OutputData;
 
 #include "DeepCLDllExport.h"
@@ -48,7 +49,7 @@ public:
     VIRTUAL void updateWeights(float annealedLearningRate, CLWrapper *weightsWrapper, CLWrapper *gradWeightsWrapper);
     VIRTUAL BatchResult trainNet(
     NeuralNet *net, TrainingContext *context,
-    float const *input, OutputData *outputData);
+    InputData *inputData, OutputData *outputData);
     VIRTUAL BatchResult trainNet(NeuralNet *net, TrainingContext *context,
     float const*input, float const*expectedOutput);
     VIRTUAL BatchResult trainNetFromLabels(NeuralNet *net, TrainingContext *context,
@@ -0,0 +1,207 @@
+// Copyright Hugh Perkins 2015 hughperkins at gmail
+//
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file, You can
+// obtain one at http://mozilla.org/MPL/2.0/.
+
+#include <iostream>
+#include <sstream>
+#include <thread>
+#include <stdexcept>
+
+#include "net/NeuralNet.h"
+#include "input/InputLayer.h"
+#include "batch/BatchData.h"
+#include "weights/WeightsPersister.h"
+#include "util/LatencyStats.h"
+#include "util/stringhelper.h"
+#include "trainers/GradientAllReduce.h"
+#include "trainers/DataParallelTrainer.h"
+
+using namespace std;
+
+#undef STATIC
+#undef VIRTUAL
+#define STATIC
+#define VIRTUAL
+
+/// \brief trainers[i] trains replicas[i]; each trainer must use its replica's EasyCL
+///
+/// The replicas need the same layers.  Their weights are set to replica 0's here.
+PUBLIC DataParallelTrainer::DataParallelTrainer(std::vector<NeuralNet *> replicas, std::vector<Trainer *> trainers) :
+        Trainer(replicas.size() > 0 ? replicas[0]->getCl() : 0),
+        replicas(replicas),
+        trainers(trainers),
+        reducer(0) {
+    if(replicas.size() == 0 || replicas.size() != trainers.size()) {
+        throw runtime_error("DataParallelTrainer: need one trainer per replica, and at least one replica");
+    }
+    reducer = new GradientAllReduce((int)replicas.size());
+    for(int i = 0; i < (int)trainers.size(); i++) {
+        trainers[i]->setGradientReducer(reducer, i);
+    }
+    this->learningRate = trainers[0]->learningRate;
+    syncWeights();
+    resetStats();
+}
+PUBLIC VIRTUAL DataParallelTrainer::~DataParallelTrainer() {
+    for(int i = 0; i < (int)trainers.size(); i++) {
+        trainers[i]->setGradientReducer(0, 0);
+    }
+    delete reducer;
+}
+PUBLIC int DataParallelTrainer::getNumReplicas() {
+    return (int)replicas.size();
+}
+PUBLIC NeuralNet *DataParallelTrainer::getReplica(int replica) {
+    return replicas[replica];
+}
+/// \brief copies replica 0's weights to the others, eg after loading weights into replica 0
+PUBLIC void DataParallelTrainer::syncWeights() {
+    int numWeights = WeightsPersister::getTotalNumWeights(replicas[0]);
+    float *weights = new float[numWeights];
+    WeightsPersister::copyNetWeightsToArray(replicas[0], weights);
+    for(int i = 1; i < (int)replicas.size(); i++) {
+        if(WeightsPersister::getTotalNumWeights(replicas[i]) != numWeights) {
+            delete[] weights;
+            throw runtime_error("DataParallelTrainer: replica " + toString(i) + " has different layers from replica 0");
+        }
+        WeightsPersister::copyArrayToNetWeights(weights, replicas[i]);
+    }
+    delete[] weights;
+}
+PUBLIC VIRTUAL void DataParallelTrainer::setLearningRate(float learningRate) {
+    Trainer::setLearningRate(learningRate);
+    for(int i = 0; i < (int)trainers.size(); i++) {
+        trainers[i]->setLearningRate(learningRate);
+    }
+}
+PUBLIC VIRTUAL std::string DataParallelTrainer::asString() {
+    return "DataParallelTrainer{ replicas=" + toString(replicas.size()) + ", " + trainers[0]->asString() + " }";
+}
+PUBLIC VIRTUAL BatchResult DataParallelTrainer::trainNet(NeuralNet *net, TrainingContext *context,
+        float const*input, float const*expectedOutput) {
+    ExpectedData expectedData(net, expectedOutput);
+    InputData inputData(net, input);
+    return this->trainNet(net, context, &inputData, &expectedData);
+}
+PUBLIC VIRTUAL BatchResult DataParallelTrainer::trainNetFromLabels(NeuralNet *net, TrainingContext *context,
+        float const*input, int const*labels) {
+    LabeledData labeledData(net, labels);
+    InputData inputData(net, input);
+    return this->trainNet(net, context, &inputData, &labeledData);
+}
+/// \brief learns one batch: splits it across the replicas, and updates all their weights
+PUBLIC VIRTUAL BatchResult DataParallelTrainer::trainNet(NeuralNet *net, TrainingContext *context,
+        InputData *inputData, OutputData *outputData) {
+    if(net != replicas[0]) {
+        throw runtime_error("DataParallelTrainer: train replica 0, the other replicas follow it");
+    }
+    const int numReplicas = (int)replicas.size();
+    const int batchSize = net->getFirstLayer()->batchSize;
+
+    // shards differ in size by at most one example.  If the batch is smaller than the
+    // number of replicas, the spare replicas run one example, but add nothing to the
+    // gradients; they still need to apply the update, to stay in sync
+    vector<int> shardStarts(numReplicas);
+    vector<int> shardSizes(numReplicas);
+    int shardStart = 0;
+    for(int i = 0; i < numReplicas; i++) {
+        int shardSize = batchSize / numReplicas + (i < batchSize % numReplicas ? 1 : 0);
+        reducer->setActive(i, shardSize > 0);
+        shardStarts[i] = shardSize > 0 ? shardStart : 0;
+        shardSizes[i] = shardSize > 0 ? shardSize : 1;
+        shardStart += shardSize;
+    }
+
+    vector<BatchResult> results(numReplicas);
+    vector<exception_ptr> errors(numReplicas);
+    double startSeconds = LatencyStats::nowSeconds();
+    reducer->beginStep();
+    vector<thread> threads;
+    for(int i = 1; i < numReplicas; i++) {
+        threads.push_back(thread([=, &shardStarts, &shardSizes, &results, &errors]() {
+            trainReplica(i, shardStarts[i], shardSizes[i], context, inputData, outputData, &results[i], &errors[i]);
+        }));
+    }
+    trainReplica(0, shardStarts[0], shardSizes[0], context, inputData, outputData, &results[0], &errors[0]);
+    for(int i = 0; i < (int)threads.size(); i++) {
+        threads[i].join();
+    }
+    net->setBatchSize(batchSize);
+    for(int i = 0; i < numReplicas; i++) {
+        if(errors[i]) {
+            rethrow_exception(errors[i]);
+        }
+    }
+    double wallSeconds = LatencyStats::nowSeconds() - startSeconds;
+
+    BatchResult result;
+    double computeSeconds = 0;
+    for(int i = 0; i < numReplicas; i++) {
+        computeSeconds += reducer->getComputeSeconds(i);
+        if(i < batchSize) {
+            result.loss += results[i].loss;
+            result.numRight += results[i].numRight;
+        }
+    }
+    statsNumBatches++;
+    statsNumExamples += batchSize;
+    statsWallSeconds += wallSeconds;
+    statsComputeSeconds += computeSeconds;
+    statsReduceSeconds += reducer->getReduceSeconds();
+    return result;
+}
+PUBLIC void DataParallelTrainer::resetStats() {
+    statsNumBatches = 0;
+    statsNumExamples = 0;
+    statsWallSeconds = 0;
+    statsComputeSeconds = 0;
+    statsReduceSeconds = 0;
+}
+/// \brief the replicas' total forward and backward time, over the wall time, since resetStats
+///
+/// ie roughly how many times faster than one replica doing all the work
+PUBLIC float DataParallelTrainer::getSpeedup() {
+    if(statsWallSeconds <= 0) {
+        return 0;
+    }
+    return (float)(statsComputeSeconds / statsWallSeconds);
+}
+/// \brief speedup over the number of replicas
+///
+/// 1 means no time was lost to the all-reduce, the weight updates, or waiting for the
+/// slowest replica
+PUBLIC float DataParallelTrainer::getScalingEfficiency() {
+    return getSpeedup() / replicas.size();
+}
+/// \brief stats since resetStats, eg for each epoch
+PUBLIC std::string DataParallelTrainer::getStatsString() {
+    ostringstream oss;
+    oss << "data parallel: replicas=" << replicas.size() << " batches=" << statsNumBatches;
+    if(statsWallSeconds > 0) {
+        oss << " examples/s=" << (statsNumExamples / statsWallSeconds)
+            << " speedup=" << getSpeedup()
+            << " efficiency=" << getScalingEfficiency()
+            << " allreduce=" << (statsReduceSeconds * 100.0 / statsWallSeconds) << "% of time";
+    }
+    return oss.str();
+}
+// runs in its own thread, except replica 0, which runs in the caller's
+PRIVATE void DataParallelTrainer::trainReplica(int replica, int shardStart, int shardSize, TrainingContext *context,
+        InputData *inputData, OutputData *outputData, BatchResult *result, std::exception_ptr *error) {
+    InputData *shardInput = inputData->slice(shardStart);
+    OutputData *shardOutput = outputData->slice(shardStart);
+    try {
+        NeuralNet *net = replicas[replica];
+        net->setBatchSize(shardSize);
+        net->setTraining(true);
+        *result = trainers[replica]->trainNet(net, context, shardInput, shardOutput);
+    } catch(...) {
+        *error = current_exception();
+        reducer->cancel();
+    }
+    delete shardInput;
+    delete shardOutput;
+}
+
@@ -0,0 +1,83 @@
+// Copyright Hugh Perkins 2015 hughperkins at gmail
+//
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file, You can
+// obtain one at http://mozilla.org/MPL/2.0/.
+
+#pragma once
+
+#include <vector>
+#include <string>
+#include <exception>
+
+#include "trainers/Trainer.h"
+
+#include "DeepCLDllExport.h"
+
+class NeuralNet;
+class GradientAllReduce;
+
+#define VIRTUAL virtual
+#define STATIC static
+
+/// \brief trains N replicas of one net, each on its own device or context, on 1/N of each batch
+///
+/// Each replica runs forward and backward on its shard of the batch, in its own thread,
+/// then the replicas' weight gradients are summed, and each replica's own trainer applies
+/// the summed gradients.  Since the replicas start with the same weights and trainer state,
+/// and apply the same updates, they stay in sync, and replica 0 can be used for testing
+/// and saving the weights, as normal.  The gradients are sums over the examples, so this
+/// learns the same as one net training on the whole batch.
+///
+/// Train replica 0, eg pass replica 0 as the trainable to NetLearner, with this as the trainer.
+class DeepCL_EXPORT DataParallelTrainer : public Trainer {
+    private:
+    #ifdef _WIN32
+    #pragma warning(disable: 4251)
+    #endif
+    std::vector<NeuralNet *> replicas; // NOT delete
+    std::vector<Trainer *> trainers; // NOT delete
+    #ifdef _WIN32
+    #pragma warning(default: 4251)
+    #endif
+    GradientAllReduce *reducer;
+
+    // since the last resetStats
+    int statsNumBatches;
+    long statsNumExamples;
+    double statsWallSeconds;
+    double statsComputeSeconds;
+    double statsReduceSeconds;
+
+    // [[[cog
+    // import cog_addheaders
+    // cog_addheaders.addv2()
+    // ]]]
+    // generated, using cog:
+
+    public:
+    DataParallelTrainer(std::vector<NeuralNet *> replicas, std::vector<Trainer *> trainers);
+    VIRTUAL ~DataParallelTrainer();
+    int getNumReplicas();
+    NeuralNet *getReplica(int replica);
+    void syncWeights();
+    VIRTUAL void setLearningRate(float learningRate);
+    VIRTUAL std::string asString();
+    VIRTUAL BatchResult trainNet(NeuralNet *net, TrainingContext *context,
+    float const*input, float const*expectedOutput);
+    VIRTUAL BatchResult trainNetFromLabels(NeuralNet *net, TrainingContext *context,
+    float const*input, int const*labels);
+    VIRTUAL BatchResult trainNet(NeuralNet *net, TrainingContext *context,
+    InputData *inputData, OutputData *outputData);
+    void resetStats();
+    float getSpeedup();
+    float getScalingEfficiency();
+    std::string getStatsString();
+
+    private:
+    void trainReplica(int replica, int shardStart, int shardSize, TrainingContext *context,
+    InputData *inputData, OutputData *outputData, BatchResult *result, std::exception_ptr *error);
+
+    // [[[end]]]
+};
+
@@ -0,0 +1,165 @@
+// Copyright Hugh Perkins 2015 hughperkins at gmail
+//
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file, You can
+// obtain one at http://mozilla.org/MPL/2.0/.
+
+#include <stdexcept>
+
+#include "EasyCL.h"
+#include "net/NeuralNet.h"
+#include "layer/Layer.h"
+#include "util/LatencyStats.h"
+#include "util/stringhelper.h"
+#include "trainers/GradientAllReduce.h"
+
+using namespace std;
+
+#undef STATIC
+#define STATIC
+#undef VIRTUAL
+#define VIRTUAL
+
+PUBLIC GradientAllReduce::GradientAllReduce(int numReplicas) :
+        active(numReplicas, true),
+        replicaGradients(numReplicas),
+        arrivalSeconds(numReplicas, 0),
+        numReplicas(numReplicas),
+        numArrived(0),
+        generation(0),
+        cancelled(false),
+        stepStartSeconds(0),
+        lastArrivalSeconds(0),
+        reduceSeconds(0) {
+    if(numReplicas < 1) {
+        throw runtime_error("GradientAllReduce: need at least one replica");
+    }
+}
+PUBLIC int GradientAllReduce::getNumReplicas() {
+    return numReplicas;
+}
+// an inactive replica still calls allReduce, and gets the sum, but adds nothing to it
+PUBLIC void GradientAllReduce::setActive(int replica, bool active) {
+    this->active[replica] = active;
+}
+// call before starting the replicas on a batch, for the timings
+PUBLIC void GradientAllReduce::beginStep() {
+    unique_lock<std::mutex> lock(mutex);
+    // after a cancelled step, some replicas might have been counted in
+    cancelled = false;
+    numArrived = 0;
+    stepStartSeconds = LatencyStats::nowSeconds();
+}
+// seconds from beginStep until this replica arrived, ie its forward and backward
+PUBLIC double GradientAllReduce::getComputeSeconds(int replica) {
+    return arrivalSeconds[replica] - stepStartSeconds;
+}
+// seconds from the last replica arriving until the sums were back on the devices
+PUBLIC double GradientAllReduce::getReduceSeconds() {
+    return reduceSeconds;
+}
+// wakes any replicas waiting in allReduce, which then throw, so one replica
+// failing doesnt leave the others waiting forever
+PUBLIC void GradientAllReduce::cancel() {
+    unique_lock<std::mutex> lock(mutex);
+    cancelled = true;
+    allArrived.notify_all();
+}
+PUBLIC void GradientAllReduce::allReduce(int replica, NeuralNet *net) {
+    vector<CLWrapper *> &gradients = replicaGradients[replica];
+    gradients.clear();
+    getGradients(net, &gradients);
+    if(active[replica]) {
+        for(int i = 0; i < (int)gradients.size(); i++) {
+            gradients[i]->copyToHost();
+        }
+    }
+    arrivalSeconds[replica] = LatencyStats::nowSeconds();
+    barrier();
+    if(replica == 0) {
+        lastArrivalSeconds = arrivalSeconds[0];
+        for(int other = 1; other < numReplicas; other++) {
+            lastArrivalSeconds = max(lastArrivalSeconds, arrivalSeconds[other]);
+        }
+    }
+    for(int other = 0; other < numReplicas; other++) {
+        bool sameShape = replicaGradients[other].size() == gradients.size();
+        for(int i = 0; sameShape && i < (int)gradients.size(); i++) {
+            sameShape = replicaGradients[other][i]->size() == gradients[i]->size();
+        }
+        if(!sameShape) {
+            cancel();
+            throw runtime_error("GradientAllReduce: replica " + toString(other) + " has different layers from replica " +
+                toString(replica));
+        }
+    }
+    sumSlice(replica);
+    barrier();
+    for(int i = 0; i < (int)gradients.size(); i++) {
+        gradients[i]->copyToDevice();
+    }
+    barrier();
+    if(replica == 0) {
+        reduceSeconds = LatencyStats::nowSeconds() - lastArrivalSeconds;
+    }
+}
+// the gradients the trainers update from: weights, then bias, of each layer
+// from the top down, stopping at the first layer that doesnt backprop
+PUBLIC STATIC void GradientAllReduce::getGradients(NeuralNet *net, std::vector<CLWrapper *> *gradients) {
+    int numLayers = net->getNumLayers();
+    for(int layerIdx = numLayers - 2; layerIdx > 0; layerIdx--) {
+        Layer *layer = net->getLayer(layerIdx);
+        if(!layer->needsBackProp()) {
+            break;
+        }
+        if(layer->needsTrainerState()) {
+            gradients->push_back(layer->getGradWeightsWrapper());
+            if(layer->biased()) {
+                gradients->push_back(layer->getGradBiasWrapper());
+            }
+        }
+    }
+}
+// waits until all replicas get here
+PRIVATE void GradientAllReduce::barrier() {
+    unique_lock<std::mutex> lock(mutex);
+    if(cancelled) {
+        throw runtime_error("GradientAllReduce: cancelled, another replica failed");
+    }
+    long ourGeneration = generation;
+    numArrived++;
+    if(numArrived == numReplicas) {
+        numArrived = 0;
+        generation++;
+        allArrived.notify_all();
+        return;
+    }
+    while(generation == ourGeneration && !cancelled) {
+        allArrived.wait(lock);
+    }
+    if(cancelled) {
+        throw runtime_error("GradientAllReduce: cancelled, another replica failed");
+    }
+}
+// each replica sums its own slice of every buffer, across all replicas, and writes
+// the sum back to every replica's host copy, so the slices never overlap
+PRIVATE void GradientAllReduce::sumSlice(int replica) {
+    vector<CLWrapper *> &gradients = replicaGradients[replica];
+    for(int i = 0; i < (int)gradients.size(); i++) {
+        const int size = gradients[i]->size();
+        const int sliceStart = (int)((long long)size * replica / numReplicas);
+        const int sliceEnd = (int)((long long)size * (replica + 1) / numReplicas);
+        for(int j = sliceStart; j < sliceEnd; j++) {
+            float sum = 0;
+            for(int other = 0; other < numReplicas; other++) {
+                if(active[other]) {
+                    sum += ((float *)replicaGradients[other][i]->getHostArray())[j];
+                }
+            }
+            for(int other = 0; other < numReplicas; other++) {
+                ((float *)replicaGradients[other][i]->getHostArray())[j] = sum;
+            }
+        }
+    }
+}
+
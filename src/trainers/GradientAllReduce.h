@@ -0,0 +1,74 @@
+// Copyright Hugh Perkins 2015 hughperkins at gmail
+//
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file, You can
+// obtain one at http://mozilla.org/MPL/2.0/.
+
+#pragma once
+
+#include <vector>
+#include <mutex>
+#include <condition_variable>
+
+#include "DeepCLDllExport.h"
+
+class NeuralNet;
+class CLWrapper;
+
+#define VIRTUAL virtual
+#define STATIC static
+
+/// \brief sums the weight and bias gradients of N replicas of one net, in place
+///
+/// Each replica's thread calls allReduce once per batch, between backward and
+/// updating its weights, and it returns once every replica's gradients hold the
+/// sum.  Replicas can live on different devices, or different contexts, so
+/// the gradients go through the host: each replica copies its own to the host,
+/// sums one slice of every buffer, across all replicas, then copies its own
+/// back.  An inactive replica takes part, but adds nothing, eg when a batch
+/// is smaller than the number of replicas.
+class DeepCL_EXPORT GradientAllReduce {
+    private:
+    #ifdef _WIN32
+    #pragma warning(disable: 4251)
+    #endif
+    std::vector<bool> active;
+    std::vector< std::vector<CLWrapper *> > replicaGradients;
+    std::vector<double> arrivalSeconds;
+    std::mutex mutex;
+    std::condition_variable allArrived;
+    #ifdef _WIN32
+    #pragma warning(default: 4251)
+    #endif
+    const int numReplicas;
+    int numArrived;
+    long generation;
+    bool cancelled;
+    double stepStartSeconds;
+    double lastArrivalSeconds;
+    double reduceSeconds;
+
+    // [[[cog
+    // import cog_addheaders
+    // cog_addheaders.addv2()
+    // ]]]
+    // generated, using cog:
+
+    public:
+    GradientAllReduce(int numReplicas);
+    int getNumReplicas();
+    void setActive(int replica, bool active);
+    void beginStep();
+    double getComputeSeconds(int replica);
+    double getReduceSeconds();
+    void cancel();
+    void allReduce(int replica, NeuralNet *net);
+    STATIC void getGradients(NeuralNet *net, std::vector<CLWrapper *> *gradients);
+
+    private:
+    void barrier();
+    void sumSlice(int replica);
+
+    // [[[end]]]
+};
+
@@ -7,6 +7,8 @@
 #include <iostream>
 
 #include "util/stringhelper.h"
+#include "util/ProfileScope.h"
+#include "util/Profiler.h"
 #include "net/NeuralNet.h"
 #include "layer/Layer.h"
 #include "loss/LossLayer.h"
@@ -16,6 +18,7 @@
 #include "loss/IAcceptsLabels.h"
 #include "batch/NetAction.h"
 #include "clmath/CLMathWrapper.h"
+#include "clmath/FusedOp.h"
 #include "batch/BatchData.h"
 
 using namespace std;
@@ -42,15 +45,18 @@ VIRTUAL void Nesterov::loadFutureWeights(
     // and then add mom * dweights to them
 
     // create CLMathWrapper objects, so we can do per-element maths on the gpu:
-    CLMathWrapper clOldWeights(trainerState->oldWeightsWrapper);
-    CLMathWrapper clWeights(weightsWrapper);
-    CLMathWrapper clGradWeights(gradWeightsWrapper);
+    FusedOp fused(cl, trainerState->numWeights);
+    CLMathWrapper clOldWeights(trainerState->oldWeightsWrapper, &fused);
+    CLMathWrapper clWeights(weightsWrapper, &fused);
+    CLMathWrapper clGradWeights(gradWeightsWrapper, &fused);
 
-    // following happens on the gpu:
+    // following gets recorded, then runs on the gpu as a single kernel:
     clOldWeights = clWeights;
     clWeights = clGradWeights;
     clWeights *= momentum;
     clWeights += clOldWeights;
+
+    fused.run();
 }
 VIRTUAL void Nesterov::updateWeights(CLWrapper *weightsWrapper,
         CLWrapper *gradWeightsWrapper,
@@ -64,22 +70,25 @@ VIRTUAL void Nesterov::updateWeights(CLWrapper *weightsWrapper,
     //      weights[t+1] = weights[t] + dweights[t+1]
 
     // create CLMathWrapper objects, so we can do per-element maths on the gpu:
-    CLMathWrapper clLastUpdate(trainerState->lastUpdateWrapper);
-    CLMathWrapper clOldWeights(trainerState->oldWeightsWrapper);
-    CLMathWrapper clGradWeights(gradWeightsWrapper);
-    CLMathWrapper clWeights(weightsWrapper);
+    FusedOp fused(cl, trainerState->numWeights);
+    CLMathWrapper clLastUpdate(trainerState->lastUpdateWrapper, &fused);
+    CLMathWrapper clOldWeights(trainerState->oldWeightsWrapper, &fused);
+    CLMathWrapper clGradWeights(gradWeightsWrapper, &fused);
+    CLMathWrapper clWeights(weightsWrapper, &fused);
 
-    // following happens on the gpu, via CLMathWrapper:
+    // following gets recorded, then runs on the gpu as a single kernel:
 
     clGradWeights *= - learningRate;
     clLastUpdate *= momentum;
     clLastUpdate += clGradWeights;
     clWeights = clOldWeights;
     clWeights += clLastUpdate;
+
+    fused.run();
 }
 VIRTUAL BatchResult Nesterov::trainNet( 
     NeuralNet *net, TrainingContext *context,
-    float const *input, OutputData *outputData) {
+    InputData *inputData, OutputData *outputData) {
     // learns one batch, including updating weights
     // doesnt have to think about running multiple batches,
     // or loading data, or anything like that
@@ -105,6 +114,7 @@ VIRTUAL BatchResult Nesterov::trainNet(
             break;
         }
         if(layer->needsTrainerState()) {
+            ProfileScope profile(cl, Profiler::UPDATE, net, layerIdx);
             loadFutureWeights(layer->getWeightsWrapper(), layer->getGradWeightsWrapper(), 
                 dynamic_cast< NesterovState * >(layer->getTrainerState()) );
             if(layer->biased()) {
@@ -116,10 +126,11 @@ VIRTUAL BatchResult Nesterov::trainNet(
 
     // now, we have loaded in weigths + mom * dweights into the weights
     // do forward/backward:
-    net->forward(input);
+    inputData->forward(net);
     int numRight = net->calcNumRight(outputData);
     float loss = net->calcLoss(outputData);
     net->backward(outputData);
+    reduceGradients(net);
 
     // now, calculate the new weights
     for(int layerIdx = numLayers - 2; layerIdx > 0; layerIdx--) {
@@ -128,6 +139,7 @@ VIRTUAL BatchResult Nesterov::trainNet(
             break;
         }
         if(layer->needsTrainerState()) {
+            ProfileScope profile(cl, Profiler::UPDATE, net, layerIdx);
             updateWeights(layer->getWeightsWrapper(), layer->getGradWeightsWrapper(), 
                 dynamic_cast< NesterovState * >(layer->getTrainerState()) );
             if(layer->biased()) {
@@ -143,13 +155,15 @@ VIRTUAL BatchResult Nesterov::trainNet(NeuralNet *net, TrainingContext *context,
         float const*input, float const*expectedOutput) {
 
     ExpectedData expectedData(net, expectedOutput);
-    return this->trainNet(net, context, input, &expectedData);
+    InputData inputData(net, input);
+    return this->trainNet(net, context, &inputData, &expectedData);
 }
 VIRTUAL BatchResult Nesterov::trainNetFromLabels(NeuralNet *net, TrainingContext *context,
         float const*input, int const*labels) {
 
     LabeledData labeledData(net, labels);
-    return this->trainNet(net, context, input, &labeledData);
+    InputData inputData(net, input);
+    return this->trainNet(net, context, &inputData, &labeledData);
 }
 VIRTUAL void Nesterov::bindState(NeuralNet *net) {
     NesterovStateMaker stateMaker;
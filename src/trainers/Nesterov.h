@@ -50,7 +50,7 @@ public:
     NesterovState *trainerState);
     VIRTUAL BatchResult trainNet(
     NeuralNet *net, TrainingContext *context,
-    float const *input, OutputData *outputData);
+    InputData *inputData, OutputData *outputData);
     VIRTUAL BatchResult trainNet(NeuralNet *net, TrainingContext *context,
     float const*input, float const*expectedOutput);
     VIRTUAL BatchResult trainNetFromLabels(NeuralNet *net, TrainingContext *context,
@@ -7,6 +7,8 @@
 #include <iostream>
 
 #include "util/stringhelper.h"
+#include "util/ProfileScope.h"
+#include "util/Profiler.h"
 #include "net/NeuralNet.h"
 #include "layer/Layer.h"
 #include "loss/LossLayer.h"
@@ -16,6 +18,7 @@
 #include "loss/IAcceptsLabels.h"
 #include "batch/NetAction.h"
 #include "clmath/CLMathWrapper.h"
+#include "clmath/FusedOp.h"
 #include "batch/BatchData.h"
 
 using namespace std;
@@ -42,16 +45,14 @@ VIRTUAL void SGD::updateWeights(CLWrapper *weightsWrapper, CLWrapper *gradWeight
         SGDState *trainerState) {
     int numWeights = trainerState->numWeights;
     CLWrapper *lastUpdateWrapper = trainerState->lastUpdateWrapper;
-    float *gradWeightsCopy = new float[ numWeights ];
-    CLWrapper *gradWeightsCopyWrapper = cl->wrap(numWeights, gradWeightsCopy);
-    gradWeightsCopyWrapper->createOnDevice();
+    FusedOp fused(cl, numWeights);
 
-    CLMathWrapper lastUpdates_(lastUpdateWrapper);
-    CLMathWrapper gradWeights_(gradWeightsWrapper);
-    CLMathWrapper gradWeightsCopy_(gradWeightsCopyWrapper);
-    CLMathWrapper weights_(weightsWrapper);
+    CLMathWrapper lastUpdates_(lastUpdateWrapper, &fused);
+    CLMathWrapper gradWeights_(gradWeightsWrapper, &fused);
+    CLMathWrapper gradWeightsCopy_(&fused); // registers only, no buffer
+    CLMathWrapper weights_(weightsWrapper, &fused);
 
-    // following all happens on gpu, via clmathwrapper:
+    // following all gets recorded, then runs on the gpu as a single kernel:
     lastUpdates_ *= momentum;
     gradWeightsCopy_ = gradWeights_;
     gradWeightsCopy_ *= - learningRate;
@@ -65,20 +66,20 @@ VIRTUAL void SGD::updateWeights(CLWrapper *weightsWrapper, CLWrapper *gradWeight
         weights_ *= 1.0f - weightDecay;
     }
 
-    delete gradWeightsCopyWrapper;
-    delete[] gradWeightsCopy;
+    fused.run();
 }
 VIRTUAL BatchResult SGD::trainNet(NeuralNet *net, TrainingContext *context,
-    float const*input, OutputData *outputData) {
+    InputData *inputData, OutputData *outputData) {
     // learns one batch, including updating weights
     // doesnt have to think about running multiple batches,
     // or loading data, or anything like that
     bindState(net);
 
-    net->forward(input);
+    inputData->forward(net);
     int numRight = net->calcNumRight(outputData);
     float loss = net->calcLoss(outputData);
     net->backward(outputData);
+    reduceGradients(net);
 
     int numLayers = net->getNumLayers();
     for(int layerIdx = numLayers - 2; layerIdx > 0; layerIdx--) {
@@ -87,6 +88,7 @@ VIRTUAL BatchResult SGD::trainNet(NeuralNet *net, TrainingContext *context,
             break;
         }
         if(layer->needsTrainerState()) {
+            ProfileScope profile(cl, Profiler::UPDATE, net, layerIdx);
             updateWeights(layer->getWeightsWrapper(), layer->getGradWeightsWrapper(), 
                 dynamic_cast< SGDState * >(layer->getTrainerState()) );
             if(layer->biased()) {
@@ -100,12 +102,14 @@ VIRTUAL BatchResult SGD::trainNet(NeuralNet *net, TrainingContext *context,
 VIRTUAL BatchResult SGD::trainNet(NeuralNet *net, TrainingContext *context,
         float const*input, float const*expectedOutput) {
     ExpectedData expectedData(net, expectedOutput);
-    return this->trainNet(net, context, input, &expectedData);
+    InputData inputData(net, input);
+    return this->trainNet(net, context, &inputData, &expectedData);
 }
 VIRTUAL BatchResult SGD::trainNetFromLabels(NeuralNet *net, TrainingContext *context,
         float const*input, int const*labels) {
     LabeledData labeledData(net, labels);
-    return this->trainNet(net, context, input, &labeledData);
+    InputData inputData(net, input);
+    return this->trainNet(net, context, &inputData, &labeledData);
 }
 VIRTUAL void SGD::bindState(NeuralNet *net) {
     SGDStateMaker stateMaker;
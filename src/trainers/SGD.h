@@ -16,6 +16,7 @@
 class SGDState;
 class CLWrapper;
 class EasyCL;
+class InputData;
 class OutputData;
 
 #include "DeepCLDllExport.h"
@@ -52,7 +53,7 @@ public:
     VIRTUAL void updateWeights(CLWrapper *weightsWrapper, CLWrapper *gradWeightsWrapper,
     SGDState *trainerState);
     VIRTUAL BatchResult trainNet(NeuralNet *net, TrainingContext *context,
-    float const*input, OutputData *outputData);
+    InputData *inputData, OutputData *outputData);
     VIRTUAL BatchResult trainNet(NeuralNet *net, TrainingContext *context,
     float const*input, float const*expectedOutput);
     VIRTUAL BatchResult trainNetFromLabels(NeuralNet *net, TrainingContext *context,
@@ -7,7 +7,6 @@
 #include <iostream>
 
 #include "EasyCL.h"
-#include "util/StatefulTimer.h"
 #include "trainers/SGDState.h"
 
 using namespace std;
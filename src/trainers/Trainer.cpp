@@ -15,6 +15,8 @@
 #include "trainers/TrainerStateMaker.h"
 #include "trainers/TrainerState.h"
 #include "layer/Layer.h"
+#include "batch/BatchData.h"
+#include "trainers/GradientAllReduce.h"
 
 using namespace std;
 
@@ -26,7 +28,9 @@ using namespace std;
 
 Trainer::Trainer(EasyCL *cl) :
     cl(cl),
-    learningRate(0) {
+    learningRate(0),
+    gradientReducer(0),
+    replicaIndex(0) {
 }
 VIRTUAL Trainer::~Trainer() {
 }
@@ -57,20 +61,47 @@ VIRTUAL BatchResult Trainer::trainFromLabels(Trainable *trainable,
     TrainingContext *context,
     float const*input, int const*labels) {
     MultiNet *multiNet = dynamic_cast< MultiNet *>(trainable);
-    float loss = 0;
-    int numRight = 0;
     if(multiNet != 0) {
         for(int i = 0; i < multiNet->getNumNets(); i++) {
             Trainable *child = multiNet->getNet(i);
-            BatchResult result = this->trainFromLabels(child, context, input, labels);
-            loss += result.loss;
-            numRight += result.numRight;
+            this->trainFromLabels(child, context, input, labels);
         }
+        // the ensemble's loss and numRight, rather than the children's summed
+        return BatchResult(multiNet->calcLossFromLabels(labels), multiNet->calcNumRight(labels));
     } else {
         NeuralNet *net = dynamic_cast< NeuralNet * > (trainable);
         return this->trainNetFromLabels(net, context, input, labels);
     }
-    return BatchResult(loss, numRight);
+}
+/// \brief learn one batch of uint8 input, which the net normalizes on the device
+VIRTUAL BatchResult Trainer::trainFromLabels(Trainable *trainable,
+    TrainingContext *context,
+    unsigned char const*input, int const*labels) {
+    MultiNet *multiNet = dynamic_cast< MultiNet *>(trainable);
+    if(multiNet != 0) {
+        for(int i = 0; i < multiNet->getNumNets(); i++) {
+            Trainable *child = multiNet->getNet(i);
+            this->trainFromLabels(child, context, input, labels);
+        }
+        return BatchResult(multiNet->calcLossFromLabels(labels), multiNet->calcNumRight(labels));
+    } else {
+        NeuralNet *net = dynamic_cast< NeuralNet * > (trainable);
+        InputData inputData(net, input);
+        LabeledData labeledData(net, labels);
+        return this->trainNet(net, context, &inputData, &labeledData);
+    }
+}
+/// \brief used by DataParallelTrainer: this trainer's net is replica replicaIndex, and
+/// its gradients are all-reduced with the other replicas' before each update
+VIRTUAL void Trainer::setGradientReducer(GradientAllReduce *gradientReducer, int replicaIndex) {
+    this->gradientReducer = gradientReducer;
+    this->replicaIndex = replicaIndex;
+}
+// called by each trainer between backward and updating the weights
+void Trainer::reduceGradients(NeuralNet *net) {
+    if(gradientReducer != 0) {
+        gradientReducer->allReduce(replicaIndex, net);
+    }
 }
 VIRTUAL void Trainer::_bindState(NeuralNet *net, TrainerStateMaker *stateMaker) {
     // go through network layers, and assign TrainerState objects
@@ -17,6 +17,9 @@ class Trainable;
 class EpochResult;
 class TrainerStateMaker;
 class BatchResult;
+class InputData;
+class OutputData;
+class GradientAllReduce;
 
 #include "trainers/TrainingContext.h"
 
@@ -59,11 +62,17 @@ public:
 
     float learningRate;
 
+    GradientAllReduce *gradientReducer; // NOT delete; 0 unless training data-parallel
+    int replicaIndex;
+
     virtual BatchResult trainNet(NeuralNet *net, TrainingContext *context,
         float const*input, float const*expectedOutput) = 0;
     virtual BatchResult trainNetFromLabels(NeuralNet *net, 
         TrainingContext *context,
         float const*input, int const*labels) = 0;
+    // input can be float or uint8, see InputData
+    virtual BatchResult trainNet(NeuralNet *net, TrainingContext *context,
+        InputData *inputData, OutputData *outputData) = 0;
 
     // [[[cog
     // import cog_addheaders
@@ -80,6 +89,11 @@ public:
     VIRTUAL BatchResult trainFromLabels(Trainable *trainable,
     TrainingContext *context,
     float const*input, int const*labels);
+    VIRTUAL BatchResult trainFromLabels(Trainable *trainable,
+    TrainingContext *context,
+    unsigned char const*input, int const*labels);
+    VIRTUAL void setGradientReducer(GradientAllReduce *gradientReducer, int replicaIndex);
+    void reduceGradients(NeuralNet *net);
     VIRTUAL void _bindState(NeuralNet *net, TrainerStateMaker *stateMaker);
 
     // [[[end]]]
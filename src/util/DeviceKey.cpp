@@ -0,0 +1,58 @@
+// Copyright Hugh Perkins 2015 hughperkins at gmail
+//
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file, You can
+// obtain one at http://mozilla.org/MPL/2.0/.
+
+#include <string>
+
+#include "EasyCL.h"
+
+#include "util/DeviceKey.h"
+
+using namespace std;
+
+#undef STATIC
+#define STATIC
+#undef VIRTUAL
+#define VIRTUAL
+
+// eg "GeForce GTX 970/OpenCL 1.2 CUDA/352.30"
+PUBLIC STATIC std::string DeviceKey::get(EasyCL *cl) {
+    return getDeviceInfo(cl, CL_DEVICE_NAME) + "/" + getDeviceInfo(cl, CL_DEVICE_VERSION)
+        + "/" + getDeviceInfo(cl, CL_DRIVER_VERSION);
+}
+// keys go into text files, one per line, with fields separated by tabs, so
+// we strip anything that could break that
+PUBLIC STATIC std::string DeviceKey::sanitize(std::string value) {
+    string result = "";
+    for(int i = 0; i < (int)value.size(); i++) {
+        char c = value[i];
+        if(c == 0) {
+            break;
+        }
+        if(c == '\t' || c == '\n' || c == '\r') {
+            c = ' ';
+        }
+        result += c;
+    }
+    size_t end = result.find_last_not_of(' ');
+    return end == string::npos ? "" : result.substr(0, end + 1);
+}
+// true if cl runs on the host cpu, where native implementations compete
+// with the OpenCL kernels for the same cores
+PUBLIC STATIC bool DeviceKey::isCpu(EasyCL *cl) {
+    cl_device_type type = 0;
+    cl_int error = clGetDeviceInfo(cl->device, CL_DEVICE_TYPE, sizeof(type), &type, 0);
+    return error == CL_SUCCESS && (type & CL_DEVICE_TYPE_CPU) != 0;
+}
+PRIVATE STATIC std::string DeviceKey::getDeviceInfo(EasyCL *cl, int name) {
+    char buffer[1024];
+    size_t size = 0;
+    cl_int error = clGetDeviceInfo(cl->device, (cl_device_info)name, sizeof(buffer) - 1, buffer, &size);
+    if(error != CL_SUCCESS) {
+        return "unknown";
+    }
+    buffer[size < sizeof(buffer) ? size : sizeof(buffer) - 1] = 0;
+    return sanitize(buffer);
+}
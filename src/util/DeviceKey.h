@@ -0,0 +1,38 @@
+// Copyright Hugh Perkins 2015 hughperkins at gmail
+//
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file, You can
+// obtain one at http://mozilla.org/MPL/2.0/.
+
+#pragma once
+
+#include <string>
+
+#include "DeepCLDllExport.h"
+
+class EasyCL;
+
+#define VIRTUAL virtual
+#define STATIC static
+
+// identifies the device and driver an EasyCL instance runs on, so we can key
+// on-disk caches (tuning results, ...) by it.  If the driver is upgraded,
+// the key changes, and the old entries are simply not found any more
+class DeepCL_EXPORT DeviceKey {
+    // [[[cog
+    // import cog_addheaders
+    // cog_addheaders.addv2()
+    // ]]]
+    // generated, using cog:
+
+    public:
+    STATIC std::string get(EasyCL *cl);
+    STATIC std::string sanitize(std::string value);
+    STATIC bool isCpu(EasyCL *cl);
+
+    private:
+    STATIC std::string getDeviceInfo(EasyCL *cl, int name);
+
+    // [[[end]]]
+};
+
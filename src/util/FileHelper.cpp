@@ -10,11 +10,17 @@
 #include <iostream>
 #include <fstream>
 #include <algorithm>
+#include <sstream>
+#include <cstdlib>
+#include <atomic>
 
 #ifdef _WIN32
 #include "windows.h"
+#include <process.h>
+#include <io.h>
 #else
 #include <sys/stat.h>
+#include <unistd.h>
 #endif
 
 #include "FileHelper.h"
@@ -24,6 +30,12 @@
 #undef STATIC
 #define STATIC
 
+// set by setCacheDirectory; empty means use the default
+static std::string &cacheDirectoryOverride() {
+    static std::string directory = "";
+    return directory;
+}
+
 PUBLIC STATIC char *FileHelper::readBinary(std::string filepath, long *p_filesize) {
     std::string localPath = localizePath(filepath);
     std::ifstream file(localPath.c_str(), std::ios::in | std::ios::binary | std::ios::ate);
@@ -84,6 +96,52 @@ PUBLIC STATIC void FileHelper::writeBinary(std::string filepath, char const*data
     }
     file.close();
 }
+// like writeBinary, but only returns once the data is on the disk, not just
+// in the os's cache
+PUBLIC STATIC void FileHelper::writeBinarySynced(std::string filepath, char const*data, long filesize) {
+    std::string localPath = localizePath(filepath);
+    FILE *file = fopen(localPath.c_str(), "wb");
+    if(file == 0) {
+         throw std::runtime_error("cannot open file " + localPath);
+    }
+    bool ok = (long)fwrite(data, 1, filesize, file) == filesize && fflush(file) == 0;
+    #ifdef _WIN32
+    ok = ok && _commit(_fileno(file)) == 0;
+    #else
+    ok = ok && fsync(fileno(file)) == 0;
+    #endif
+    ok = fclose(file) == 0 && ok;
+    if(!ok) {
+        throw std::runtime_error("failed to write to " + localPath);
+    }
+}
+// writes to a temporary file next to filepath, syncs it, then renames it over
+// filepath, so other processes reading filepath, or a restart after a crash,
+// see either the old or the new contents, never a partial write.  The temporary
+// file is named by pid and a per-process counter, so threads writing the same
+// filepath at the same time each get their own
+PUBLIC STATIC void FileHelper::writeBinaryAtomic(std::string filepath, char const*data, long filesize) {
+    static std::atomic<long> numTempFiles(0);
+    #ifdef _WIN32
+    int pid = _getpid();
+    #else
+    int pid = getpid();
+    #endif
+    std::ostringstream tempPath;
+    tempPath << filepath << ".tmp" << pid << "." << numTempFiles++;
+    writeBinarySynced(tempPath.str(), data, filesize);
+    std::string localPath = localizePath(filepath);
+    std::string localTempPath = localizePath(tempPath.str());
+    #ifdef _WIN32
+    bool ok = MoveFileEx(localTempPath.c_str(), localPath.c_str(), MOVEFILE_REPLACE_EXISTING) != 0;
+    #else
+    bool ok = ::rename(localTempPath.c_str(), localPath.c_str()) == 0;
+    #endif
+    if(!ok) {
+        ::remove(localTempPath.c_str());
+        throw std::runtime_error("failed to rename " + localTempPath + " to " + localPath);
+    }
+}
 PUBLIC STATIC void FileHelper::writeBinaryChunk(std::string filepath, char const*data, long startPos, long filesize) {
     std::string localPath = localizePath(filepath);
     std::ofstream file(localPath.c_str(), std::ios::out | std::ios::binary);
@@ -139,8 +197,55 @@ PUBLIC STATIC bool FileHelper::folderExists(std::string path) {
         return GetFileAttributes(path.c_str()) != INVALID_FILE_ATTRIBUTES;
     #else
         struct stat status;
-        stat(path.c_str(), &status);
+        if(stat(path.c_str(), &status) != 0) {
+            return false;
+        }
         return S_ISDIR(status.st_mode);
     #endif
 }
+// directory for persistent caches (kernel tuning results, ...)
+// in order: whatever was passed to setCacheDirectory, env var DEEPCL_CACHE_DIR,
+// then ~/.deepcl (%LOCALAPPDATA%\deepcl on Windows)
+// created if it doesnt exist yet.  Returns "" if there is nowhere usable,
+// in which case callers should just not cache anything
+PUBLIC STATIC std::string FileHelper::getCacheDirectory() {
+    std::string directory = cacheDirectoryOverride();
+    if(directory == "") {
+        const char *fromEnv = getenv("DEEPCL_CACHE_DIR");
+        if(fromEnv != 0) {
+            directory = fromEnv;
+        }
+    }
+    if(directory == "") {
+        #ifdef _WIN32
+        const char *home = getenv("LOCALAPPDATA");
+        if(home == 0) {
+            home = getenv("USERPROFILE");
+        }
+        std::string subdirectory = "deepcl";
+        #else
+        const char *home = getenv("HOME");
+        std::string subdirectory = ".deepcl";
+        #endif
+        if(home == 0 || std::string(home) == "") {
+            return "";
+        }
+        directory = std::string(home) + pathSeparator() + subdirectory;
+    }
+    if(!folderExists(directory)) {
+        try {
+            createDirectory(directory);
+        } catch(std::runtime_error &e) {
+            // maybe another process just created it
+            if(!folderExists(directory)) {
+                std::cout << "Warning: cannot create cache directory " << directory << ", not caching" << std::endl;
+                return "";
+            }
+        }
+    }
+    return directory;
+}
+PUBLIC STATIC void FileHelper::setCacheDirectory(std::string directory) {
+    cacheDirectoryOverride() = directory;
+}
 
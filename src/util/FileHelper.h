@@ -29,6 +29,8 @@ class DeepCL_EXPORT FileHelper {
     STATIC char *readBinaryChunk(std::string filepath, long start, long length);
     STATIC void readBinaryChunk(char *targetArray, std::string filepath, long start, long length);
     STATIC void writeBinary(std::string filepath, char const*data, long filesize);
+    STATIC void writeBinarySynced(std::string filepath, char const*data, long filesize);
+    STATIC void writeBinaryAtomic(std::string filepath, char const*data, long filesize);
     STATIC void writeBinaryChunk(std::string filepath, char const*data, long startPos, long filesize);
     STATIC bool exists(const std::string filepath);
     STATIC void rename(std::string oldname, std::string newname);
@@ -37,6 +39,8 @@ class DeepCL_EXPORT FileHelper {
     STATIC std::string pathSeparator();
     STATIC void createDirectory(std::string path);
     STATIC bool folderExists(std::string path);
+    STATIC std::string getCacheDirectory();
+    STATIC void setCacheDirectory(std::string directory);
 
     // [[[end]]]
 };
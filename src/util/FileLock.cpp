@@ -0,0 +1,76 @@
+// Copyright Hugh Perkins 2015 hughperkins at gmail
+//
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file, You can
+// obtain one at http://mozilla.org/MPL/2.0/.
+
+#include <string>
+
+#ifdef _WIN32
+#include "windows.h"
+#else
+#include <sys/file.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <cerrno>
+#endif
+
+#include "util/FileHelper.h"
+#include "util/FileLock.h"
+
+using namespace std;
+
+#undef STATIC
+#define STATIC
+#undef VIRTUAL
+#define VIRTUAL
+
+PUBLIC FileLock::FileLock(std::string filepath) :
+        fd(-1),
+        handle(0),
+        locked(false) {
+    string localPath = FileHelper::localizePath(filepath + ".lock");
+    #ifdef _WIN32
+    HANDLE file = CreateFileA(localPath.c_str(), GENERIC_READ | GENERIC_WRITE,
+        FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE, NULL, OPEN_ALWAYS,
+        FILE_ATTRIBUTE_NORMAL, NULL);
+    if(file == INVALID_HANDLE_VALUE) {
+        return;
+    }
+    handle = file;
+    OVERLAPPED overlapped = {0};
+    locked = LockFileEx(file, LOCKFILE_EXCLUSIVE_LOCK, 0, MAXDWORD, MAXDWORD, &overlapped) != 0;
+    #else
+    fd = ::open(localPath.c_str(), O_RDWR | O_CREAT, 0666);
+    if(fd == -1) {
+        return;
+    }
+    int result;
+    while((result = flock(fd, LOCK_EX)) == -1 && errno == EINTR) {
+    }
+    locked = result == 0;
+    #endif
+}
+PUBLIC FileLock::~FileLock() {
+    #ifdef _WIN32
+    if(handle != 0) {
+        if(locked) {
+            OVERLAPPED overlapped = {0};
+            UnlockFileEx((HANDLE)handle, 0, MAXDWORD, MAXDWORD, &overlapped);
+        }
+        CloseHandle((HANDLE)handle);
+    }
+    #else
+    if(fd != -1) {
+        if(locked) {
+            flock(fd, LOCK_UN);
+        }
+        ::close(fd);
+    }
+    #endif
+}
+/// \brief false if the lock file couldnt be opened or locked, and we are going ahead without
+PUBLIC bool FileLock::isLocked() {
+    return locked;
+}
+
@@ -0,0 +1,40 @@
+// Copyright Hugh Perkins 2015 hughperkins at gmail
+//
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file, You can
+// obtain one at http://mozilla.org/MPL/2.0/.
+
+#pragma once
+
+#include <string>
+
+#include "DeepCLDllExport.h"
+
+#define VIRTUAL virtual
+#define STATIC static
+
+// exclusive advisory lock, held from construction to destruction, on
+// filepath + ".lock", for read-modify-write of a file shared between processes
+// uses flock, or LockFileEx on windows.  The lock file is left in place, since
+// removing it would let a third process lock a new file while the old one is held.
+// If the lock file cant be opened, eg a read-only directory, carries on unlocked
+class DeepCL_EXPORT FileLock {
+    private:
+    int fd;
+    void *handle; // windows only
+    bool locked;
+
+    // [[[cog
+    // import cog_addheaders
+    // cog_addheaders.addv2()
+    // ]]]
+    // generated, using cog:
+
+    public:
+    FileLock(std::string filepath);
+    ~FileLock();
+    bool isLocked();
+
+    // [[[end]]]
+};
+
@@ -6,6 +6,7 @@
 
 #include <iostream>
 #include <cstdio>
+#include <csetjmp>
 extern "C" {
     #include <jpeglib.h>
 }
@@ -22,6 +23,20 @@ using namespace std;
 #define STATIC
 #define VIRTUAL
 
+// libjpeg's default error handler calls exit(), which would take down the
+// whole process for one bad file; this one jumps back into read(), which
+// cleans up and throws instead
+struct JpegErrorManager {
+    struct jpeg_error_mgr pub;
+    jmp_buf setjmpBuffer;
+    char message[JMSG_LENGTH_MAX];
+};
+static void jpegErrorExit(j_common_ptr cinfo) {
+    JpegErrorManager *errorManager = (JpegErrorManager *)cinfo->err;
+    (*cinfo->err->format_message)(cinfo, errorManager->message);
+    longjmp(errorManager->setjmpBuffer, 1);
+}
+
 PUBLIC STATIC void JpegHelper::write(std::string filename, int planes, int width, int height, unsigned char *values) {
     unsigned char *image_buffer = new unsigned char[width * height * planes];
 //    for(int i = 0 ; i < 28 *28 *3; i++) {
@@ -84,37 +99,48 @@ PUBLIC STATIC void JpegHelper::write(std::string filename, int planes, int width
     delete[] image_buffer;
 }
 
+// throws runtime_error if the file cant be opened, isnt a valid jpeg, or
+// doesnt have the expected dimensions.  Safe to call from several threads at once
 PUBLIC STATIC void JpegHelper::read(std::string filename, int planes, int width, int height, unsigned char *values) {
+    FILE * infile;
+    if ((infile = fopen(FileHelper::localizePath(filename).c_str(), "rb")) == NULL) {
+        throw runtime_error("can't open "  + filename);
+    }
     unsigned char *image_buffer = new unsigned char[width * height * planes];
 
+    string error = ""; // declared before setjmp, so longjmp doesnt skip its destructor
     struct jpeg_decompress_struct cinfo;
-    struct jpeg_error_mgr jerr;
-    cinfo.err = jpeg_std_error(&jerr);
+    JpegErrorManager errorManager;
+    cinfo.err = jpeg_std_error(&errorManager.pub);
+    errorManager.pub.error_exit = jpegErrorExit;
+    if(setjmp(errorManager.setjmpBuffer)) {
+        jpeg_destroy_decompress(&cinfo);
+        fclose(infile);
+        delete[] image_buffer;
+        throw runtime_error("error reading " + filename + ": " + errorManager.message);
+    }
     jpeg_create_decompress(&cinfo);
 
 //    string filename = "foo.jpeg";
-    FILE * infile;
-    if ((infile = fopen(FileHelper::localizePath(filename).c_str(), "rb")) == NULL) {
-        throw runtime_error("can't open "  + filename);
-    }
     jpeg_stdio_src(&cinfo, infile);
     jpeg_read_header(&cinfo, TRUE);
 
     jpeg_start_decompress(&cinfo);
     if((int)cinfo.output_width != width) {
-        throw runtime_error("error reading " + filename + ":" + 
-            " width is " + toString(cinfo.output_width) + 
-            " and not " + toString(width) );
-    }
-    if((int)cinfo.output_height != height) {
-        throw runtime_error("error reading " + filename + ":" + 
-            " height is " + toString(cinfo.output_height) + 
-            " and not " + toString(height) );
+        error = " width is " + toString(cinfo.output_width) + 
+            " and not " + toString(width);
+    } else if((int)cinfo.output_height != height) {
+        error = " height is " + toString(cinfo.output_height) + 
+            " and not " + toString(height);
+    } else if((int)cinfo.output_components != planes) {
+        error = " planes is " + toString(cinfo.output_components) + 
+            " and not " + toString(planes);
     }
-    if((int)cinfo.output_components != planes) {
-        throw runtime_error("error reading " + filename + ":" + 
-            " planes is " + toString(cinfo.output_components) + 
-            " and not " + toString(planes) );
+    if(error != "") {
+        jpeg_destroy_decompress(&cinfo);
+        fclose(infile);
+        delete[] image_buffer;
+        throw runtime_error("error reading " + filename + ":" + error);
     }
 
     JSAMPROW row_pointer[1];        /* pointer to a single row */
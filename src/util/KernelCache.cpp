@@ -0,0 +1,181 @@
+// Copyright Hugh Perkins 2015 hughperkins at gmail
+//
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file, You can
+// obtain one at http://mozilla.org/MPL/2.0/.
+
+#include <iostream>
+#include <sstream>
+#include <stdexcept>
+#include <cstring>
+#include <cstdlib>
+#include <atomic>
+
+#include "EasyCL.h"
+#include "templates/TemplatedKernel.h"
+#include "util/FileHelper.h"
+#include "util/DeviceKey.h"
+
+#include "util/KernelCache.h"
+
+using namespace std;
+
+#undef STATIC
+#define STATIC
+#undef VIRTUAL
+#define VIRTUAL
+
+// first 8 bytes of each cached file; bump the version if the layout changes
+#define KERNELCACHE_MAGIC "DCLBIN01"
+
+static bool &enabledFlag() {
+    static bool enabled = getenv("DEEPCL_KERNEL_CACHE") == 0 || string(getenv("DEEPCL_KERNEL_CACHE")) != "0";
+    return enabled;
+}
+// by this process: kernels loaded from a cached binary, and kernels built
+// from source because there wasnt one, when the cache is enabled
+static atomic<long long> numHits(0);
+static atomic<long long> numMisses(0);
+
+PUBLIC STATIC void KernelCache::setEnabled(bool enabled) {
+    enabledFlag() = enabled;
+}
+PUBLIC STATIC bool KernelCache::isEnabled() {
+    return enabledFlag();
+}
+// drop-in replacement for cl->buildKernelFromString
+PUBLIC STATIC CLKernel *KernelCache::buildKernelFromString(EasyCL *cl, std::string source, std::string kernelName, std::string options, std::string sourceFilename) {
+    string directory = "";
+    if(isEnabled()) {
+        directory = getDirectory();
+    }
+    if(directory == "") {
+        return cl->buildKernelFromString(source, kernelName, options, sourceFilename);
+    }
+    string key = DeviceKey::get(cl) + "\n" + options + "\n" + source;
+    string filepath = directory + FileHelper::pathSeparator() + toHex(hash(key, 0)) + ".bin";
+    unsigned long long check = hash(key, 1);
+
+    CLKernel *kernel = loadKernel(cl, filepath, check, source, kernelName, options, sourceFilename);
+    if(kernel != 0) {
+        numHits++;
+        return kernel;
+    }
+    numMisses++;
+    kernel = cl->buildKernelFromString(source, kernelName, options, sourceFilename);
+    saveProgram(kernel->program, filepath, check);
+    return kernel;
+}
+// drop-in replacement for TemplatedKernel::buildKernel(..., false)
+PUBLIC STATIC CLKernel *KernelCache::buildTemplatedKernel(EasyCL *cl, TemplatedKernel *builder, std::string sourceFilename, std::string templateSource, std::string kernelName) {
+    return buildKernelFromString(cl, builder->getRenderedKernel(templateSource), kernelName, "", sourceFilename);
+}
+// where the binaries go, "" if there is nowhere to put them
+PUBLIC STATIC long long KernelCache::getNumHits() {
+    return numHits.load();
+}
+PUBLIC STATIC long long KernelCache::getNumMisses() {
+    return numMisses.load();
+}
+PUBLIC STATIC std::string KernelCache::getDirectory() {
+    string cacheDirectory = FileHelper::getCacheDirectory();
+    if(cacheDirectory == "") {
+        return "";
+    }
+    string directory = cacheDirectory + FileHelper::pathSeparator() + "kernels";
+    if(!FileHelper::folderExists(directory)) {
+        try {
+            FileHelper::createDirectory(directory);
+        } catch(runtime_error &e) {
+            if(!FileHelper::folderExists(directory)) { // maybe another process just created it
+                return "";
+            }
+        }
+    }
+    return directory;
+}
+// 64-bit FNV-1a.  seed gives us a second, independent hash, which we store
+// in the file, and check on load, so a collision on the filename cant give
+// us the wrong program
+PRIVATE STATIC unsigned long long KernelCache::hash(std::string value, int seed) {
+    unsigned long long result = 14695981039346656037ULL;
+    result ^= (unsigned long long)seed;
+    result *= 1099511628211ULL;
+    for(int i = 0; i < (int)value.size(); i++) {
+        result ^= (unsigned char)value[i];
+        result *= 1099511628211ULL;
+    }
+    return result;
+}
+PRIVATE STATIC std::string KernelCache::toHex(unsigned long long value) {
+    const char *digits = "0123456789abcdef";
+    string result = "";
+    for(int i = 15; i >= 0; i--) {
+        result += digits[(value >> (i * 4)) & 15];
+    }
+    return result;
+}
+// returns 0 if there is no usable cached binary, eg not there yet, or
+// the driver refuses it, in which case the caller builds from source
+PRIVATE STATIC CLKernel *KernelCache::loadKernel(EasyCL *cl, std::string filepath, unsigned long long check, std::string source, std::string kernelName, std::string options, std::string sourceFilename) {
+    if(!FileHelper::exists(filepath)) {
+        return 0;
+    }
+    long fileSize = 0;
+    char *data = 0;
+    try {
+        data = FileHelper::readBinary(filepath, &fileSize);
+    } catch(runtime_error &e) {
+        return 0;
+    }
+    const long headerSize = 8 + sizeof(check);
+    if(fileSize <= headerSize || memcmp(data, KERNELCACHE_MAGIC, 8) != 0
+            || memcmp(data + 8, &check, sizeof(check)) != 0) {
+        delete[] data;
+        return 0;
+    }
+    size_t binarySize = (size_t)(fileSize - headerSize);
+    const unsigned char *binary = reinterpret_cast<const unsigned char *>(data + headerSize);
+    cl_int binaryStatus = CL_SUCCESS;
+    cl_int error = CL_SUCCESS;
+    cl_program program = clCreateProgramWithBinary(*cl->context, 1, &cl->device, &binarySize, &binary, &binaryStatus, &error);
+    delete[] data;
+    if(error != CL_SUCCESS || binaryStatus != CL_SUCCESS) {
+        if(error == CL_SUCCESS) {
+            clReleaseProgram(program);
+        }
+        return 0;
+    }
+    error = clBuildProgram(program, 1, &cl->device, options.c_str(), 0, 0);
+    if(error != CL_SUCCESS) {
+        clReleaseProgram(program);
+        return 0;
+    }
+    cl_kernel kernel = clCreateKernel(program, kernelName.c_str(), &error);
+    if(error != CL_SUCCESS) {
+        clReleaseProgram(program);
+        return 0;
+    }
+    return new CLKernel(cl, sourceFilename, kernelName, source, program, kernel);
+}
+// failing to write the cache isnt fatal, we just build from source next time
+PRIVATE STATIC void KernelCache::saveProgram(cl_program program, std::string filepath, unsigned long long check) {
+    size_t binarySize = 0;
+    if(clGetProgramInfo(program, CL_PROGRAM_BINARY_SIZES, sizeof(binarySize), &binarySize, 0) != CL_SUCCESS
+            || binarySize == 0) {
+        return;
+    }
+    const long headerSize = 8 + sizeof(check);
+    char *data = new char[headerSize + binarySize];
+    memcpy(data, KERNELCACHE_MAGIC, 8);
+    memcpy(data + 8, &check, sizeof(check));
+    unsigned char *binary = reinterpret_cast<unsigned char *>(data + headerSize);
+    if(clGetProgramInfo(program, CL_PROGRAM_BINARIES, sizeof(binary), &binary, 0) == CL_SUCCESS) {
+        try {
+            FileHelper::writeBinaryAtomic(filepath, data, headerSize + (long)binarySize);
+        } catch(runtime_error &e) {
+            cout << "Warning: failed to write kernel cache " << filepath << ": " << e.what() << endl;
+        }
+    }
+    delete[] data;
+}
@@ -0,0 +1,53 @@
+// Copyright Hugh Perkins 2015 hughperkins at gmail
+//
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file, You can
+// obtain one at http://mozilla.org/MPL/2.0/.
+
+#pragma once
+
+#include <string>
+
+#include "EasyCL.h"
+#include "DeepCLDllExport.h"
+
+class TemplatedKernel;
+
+#define VIRTUAL virtual
+#define STATIC static
+
+// builds kernels like EasyCL::buildKernelFromString, but keeps the compiled
+// program binaries in FileHelper::getCacheDirectory()/kernels, so the next
+// process to need the same program loads it, instead of running the compiler
+// Binaries are content-addressed: the filename is a hash of the device, driver,
+// build options, and the (rendered) kernel source, so changing a kernel, or
+// its template parameters, or upgrading the driver, just means a new file
+// Files are written via rename, so concurrent processes never see a partial
+// binary.  Set env var DEEPCL_KERNEL_CACHE=0 to always build from source
+// getNumHits and getNumMisses count this process's loads from the cache, and
+// builds from source for want of a cached binary
+class DeepCL_EXPORT KernelCache {
+    // [[[cog
+    // import cog_addheaders
+    // cog_addheaders.addv2()
+    // ]]]
+    // generated, using cog:
+
+    public:
+    STATIC void setEnabled(bool enabled);
+    STATIC bool isEnabled();
+    STATIC CLKernel *buildKernelFromString(EasyCL *cl, std::string source, std::string kernelName, std::string options, std::string sourceFilename);
+    STATIC CLKernel *buildTemplatedKernel(EasyCL *cl, TemplatedKernel *builder, std::string sourceFilename, std::string templateSource, std::string kernelName);
+    STATIC long long getNumHits();
+    STATIC long long getNumMisses();
+    STATIC std::string getDirectory();
+
+    private:
+    STATIC unsigned long long hash(std::string value, int seed);
+    STATIC std::string toHex(unsigned long long value);
+    STATIC CLKernel *loadKernel(EasyCL *cl, std::string filepath, unsigned long long check, std::string source, std::string kernelName, std::string options, std::string sourceFilename);
+    STATIC void saveProgram(cl_program program, std::string filepath, unsigned long long check);
+
+    // [[[end]]]
+};
+
@@ -0,0 +1,70 @@
+// Copyright Hugh Perkins 2015 hughperkins at gmail
+//
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file, You can
+// obtain one at http://mozilla.org/MPL/2.0/.
+
+#include <algorithm>
+#include <chrono>
+#include <sstream>
+
+#include "util/LatencyStats.h"
+
+using namespace std;
+
+#undef STATIC
+#define STATIC
+#undef VIRTUAL
+#define VIRTUAL
+
+PUBLIC LatencyStats::LatencyStats(int maxSamples) :
+        maxSamples(maxSamples < 1 ? 1 : maxSamples) {
+    reset();
+}
+PUBLIC STATIC double LatencyStats::nowSeconds() {
+    return chrono::duration<double>(chrono::steady_clock::now().time_since_epoch()).count();
+}
+PUBLIC void LatencyStats::reset() {
+    samples.clear();
+    nextSample = 0;
+    count = 0;
+    startSeconds = nowSeconds();
+}
+PUBLIC void LatencyStats::add(float milliseconds) {
+    if((int)samples.size() < maxSamples) {
+        samples.push_back(milliseconds);
+    } else {
+        samples[nextSample] = milliseconds;
+    }
+    nextSample = (nextSample + 1) % maxSamples;
+    count++;
+}
+PUBLIC long LatencyStats::getCount() {
+    return count;
+}
+// percentile is in [0, 100], eg 50 for the median; 0 if nothing added yet
+PUBLIC float LatencyStats::getPercentile(float percentile) {
+    if(samples.size() == 0) {
+        return 0;
+    }
+    vector<float> sorted(samples);
+    int index = (int)(percentile / 100.0f * (sorted.size() - 1) + 0.5f);
+    index = std::max(0, std::min(index, (int)sorted.size() - 1));
+    nth_element(sorted.begin(), sorted.begin() + index, sorted.end());
+    return sorted[index];
+}
+// samples added per second, since construction or the last reset
+PUBLIC double LatencyStats::getThroughput() {
+    double elapsed = nowSeconds() - startSeconds;
+    if(elapsed <= 0) {
+        return 0;
+    }
+    return count / elapsed;
+}
+PUBLIC std::string LatencyStats::toString() {
+    ostringstream oss;
+    oss << "n=" << count << " p50=" << getPercentile(50) << "ms p99=" << getPercentile(99)
+        << "ms throughput=" << getThroughput() << "/s";
+    return oss.str();
+}
+
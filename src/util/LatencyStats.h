@@ -0,0 +1,54 @@
+// Copyright Hugh Perkins 2015 hughperkins at gmail
+//
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file, You can
+// obtain one at http://mozilla.org/MPL/2.0/.
+
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include "DeepCLDllExport.h"
+
+#define VIRTUAL virtual
+#define STATIC static
+
+/// \brief Percentiles and rate of a stream of latencies, eg per-request times in deepcl_predict server mode
+///
+/// Keeps the most recent maxSamples latencies, so the percentiles follow the recent load,
+/// while count and throughput cover everything since construction, or the last reset.
+/// Not thread-safe, the owner locks around it.
+class DeepCL_EXPORT LatencyStats {
+    private:
+    #ifdef _WIN32
+    #pragma warning(disable: 4251)
+    #endif
+    std::vector<float> samples;
+    #ifdef _WIN32
+    #pragma warning(default: 4251)
+    #endif
+    const int maxSamples;
+    int nextSample;
+    long count;
+    double startSeconds;
+
+    // [[[cog
+    // import cog_addheaders
+    // cog_addheaders.addv2()
+    // ]]]
+    // generated, using cog:
+
+    public:
+    LatencyStats(int maxSamples);
+    STATIC double nowSeconds();
+    void reset();
+    void add(float milliseconds);
+    long getCount();
+    float getPercentile(float percentile);
+    double getThroughput();
+    std::string toString();
+
+    // [[[end]]]
+};
+
@@ -0,0 +1,122 @@
+// Copyright Hugh Perkins 2015 hughperkins at gmail
+//
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file, You can
+// obtain one at http://mozilla.org/MPL/2.0/.
+
+#include <stdexcept>
+#include <algorithm>
+
+#ifdef _WIN32
+#include "windows.h"
+#else
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+#include "util/FileHelper.h"
+#include "util/MappedFile.h"
+
+using namespace std;
+
+#undef STATIC
+#define STATIC
+#undef VIRTUAL
+#define VIRTUAL
+
+PUBLIC MappedFile::MappedFile(std::string filepath) :
+        filepath(filepath),
+        data(0),
+        size(0),
+        fileHandle(0),
+        mappingHandle(0) {
+    string localPath = FileHelper::localizePath(filepath);
+    #ifdef _WIN32
+    HANDLE file = CreateFileA(localPath.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING,
+        FILE_ATTRIBUTE_NORMAL, NULL);
+    if(file == INVALID_HANDLE_VALUE) {
+        throw runtime_error("MappedFile: failed to open " + filepath);
+    }
+    LARGE_INTEGER fileSize;
+    if(!GetFileSizeEx(file, &fileSize)) {
+        CloseHandle(file);
+        throw runtime_error("MappedFile: failed to get size of " + filepath);
+    }
+    size = (long)fileSize.QuadPart;
+    fileHandle = file;
+    if(size == 0) {
+        return;
+    }
+    HANDLE mapping = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+    if(mapping == NULL) {
+        CloseHandle(file);
+        throw runtime_error("MappedFile: failed to map " + filepath);
+    }
+    mappingHandle = mapping;
+    data = (char *)MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+    if(data == 0) {
+        CloseHandle(mapping);
+        CloseHandle(file);
+        throw runtime_error("MappedFile: failed to map " + filepath);
+    }
+    #else
+    int fd = open(localPath.c_str(), O_RDONLY);
+    if(fd < 0) {
+        throw runtime_error("MappedFile: failed to open " + filepath);
+    }
+    struct stat status;
+    if(fstat(fd, &status) != 0) {
+        close(fd);
+        throw runtime_error("MappedFile: failed to get size of " + filepath);
+    }
+    size = (long)status.st_size;
+    if(size == 0) {
+        close(fd);
+        return;
+    }
+    void *mapped = mmap(0, size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd); // the mapping keeps its own reference to the file
+    if(mapped == MAP_FAILED) {
+        throw runtime_error("MappedFile: failed to map " + filepath);
+    }
+    data = (char *)mapped;
+    #endif
+}
+PUBLIC MappedFile::~MappedFile() {
+    #ifdef _WIN32
+    if(data != 0) {
+        UnmapViewOfFile(data);
+    }
+    if(mappingHandle != 0) {
+        CloseHandle((HANDLE)mappingHandle);
+    }
+    if(fileHandle != 0) {
+        CloseHandle((HANDLE)fileHandle);
+    }
+    #else
+    if(data != 0) {
+        munmap(data, size);
+    }
+    #endif
+}
+PUBLIC char const*MappedFile::getData() {
+    return data;
+}
+PUBLIC long MappedFile::getSize() {
+    return size;
+}
+// hint that [start, start + length) will be read soon, so the os can start
+// reading it in now
+PUBLIC void MappedFile::willNeed(long start, long length) {
+    if(data == 0 || start >= size) {
+        return;
+    }
+    length = std::min(length, size - start);
+    #ifndef _WIN32
+    long pageSize = sysconf(_SC_PAGESIZE);
+    long alignedStart = start - start % pageSize;
+    madvise(data + alignedStart, length + start - alignedStart, MADV_WILLNEED);
+    #endif
+}
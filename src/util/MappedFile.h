@@ -0,0 +1,42 @@
+// Copyright Hugh Perkins 2015 hughperkins at gmail
+//
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file, You can
+// obtain one at http://mozilla.org/MPL/2.0/.
+
+#pragma once
+
+#include <string>
+
+#include "DeepCLDllExport.h"
+
+#define VIRTUAL virtual
+#define STATIC static
+
+// read-only memory map of a whole file
+// pages are read in by the os as they are touched, and stay in the page
+// cache between epochs, so there is no read() or copy on our side
+class DeepCL_EXPORT MappedFile {
+    private:
+    std::string filepath;
+    char *data;
+    long size;
+    void *fileHandle; // windows only
+    void *mappingHandle; // windows only
+
+    // [[[cog
+    // import cog_addheaders
+    // cog_addheaders.addv2()
+    // ]]]
+    // generated, using cog:
+
+    public:
+    MappedFile(std::string filepath);
+    ~MappedFile();
+    char const*getData();
+    long getSize();
+    void willNeed(long start, long length);
+
+    // [[[end]]]
+};
+
@@ -0,0 +1,59 @@
+// Copyright Hugh Perkins 2015 hughperkins at gmail
+//
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file, You can
+// obtain one at http://mozilla.org/MPL/2.0/.
+
+#include <algorithm>
+
+#include "util/Philox.h"
+
+using namespace std;
+
+#undef STATIC
+#define STATIC
+#undef VIRTUAL
+#define VIRTUAL
+
+// counter is 4 uints, key 2 uints; writes 4 uints to result
+PUBLIC STATIC void Philox::philox4x32_10(unsigned int const*counter, unsigned int const*key, unsigned int *result) {
+    unsigned int c0 = counter[0];
+    unsigned int c1 = counter[1];
+    unsigned int c2 = counter[2];
+    unsigned int c3 = counter[3];
+    unsigned int key0 = key[0];
+    unsigned int key1 = key[1];
+    for(int round = 0; round < 10; round++) {
+        unsigned long long product0 = (unsigned long long)0xD2511F53u * c0;
+        unsigned long long product1 = (unsigned long long)0xCD9E8D57u * c2;
+        unsigned int hi0 = (unsigned int)(product0 >> 32);
+        unsigned int lo0 = (unsigned int)product0;
+        unsigned int hi1 = (unsigned int)(product1 >> 32);
+        unsigned int lo1 = (unsigned int)product1;
+        c0 = hi1 ^ c1 ^ key0;
+        c1 = lo1;
+        c2 = hi0 ^ c3 ^ key1;
+        c3 = lo0;
+        key0 += 0x9E3779B9u;
+        key1 += 0xBB67AE85u;
+    }
+    result[0] = c0;
+    result[1] = c1;
+    result[2] = c2;
+    result[3] = c3;
+}
+// uniform in [0, 1), from the first word for counter (index, 0, 0, 0)
+PUBLIC STATIC float Philox::uniform(unsigned int index, unsigned int key0, unsigned int key1) {
+    unsigned int counter[4] = { index, 0, 0, 0 };
+    unsigned int key[2] = { key0, key1 };
+    unsigned int result[4];
+    philox4x32_10(counter, key, result);
+    return (result[0] >> 8) * (1.0f / 16777216.0f);
+}
+// uniform int in [minValue, maxValue], inclusive; same as philoxUniformInt in cl/philox.cl
+PUBLIC STATIC int Philox::uniformInt(unsigned int index, int minValue, int maxValue, unsigned int key0, unsigned int key1) {
+    const int range = maxValue - minValue + 1;
+    const int offset = (int)(uniform(index, key0, key1) * range);
+    return minValue + std::min(offset, range - 1);
+}
+
@@ -0,0 +1,36 @@
+// Copyright Hugh Perkins 2015 hughperkins at gmail
+//
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file, You can
+// obtain one at http://mozilla.org/MPL/2.0/.
+
+#pragma once
+
+#include "DeepCLDllExport.h"
+
+#define VIRTUAL virtual
+#define STATIC static
+
+/// \brief host version of the philox4x32-10 counter-based generator in cl/philox.cl
+///
+/// Each (counter, key) pair gives its own random numbers, with no state carried between
+/// calls, so any element's random number can be recomputed anywhere, eg on the device
+/// in forward, and again in backward.  Used by the dropout and patches cpu implementations,
+/// so they make the same masks and offsets as the gpu ones, for a given seed.
+class DeepCL_EXPORT Philox {
+    public:
+
+    // [[[cog
+    // import cog_addheaders
+    // cog_addheaders.addv2()
+    // ]]]
+    // generated, using cog:
+
+    public:
+    STATIC void philox4x32_10(unsigned int const*counter, unsigned int const*key, unsigned int *result);
+    STATIC float uniform(unsigned int index, unsigned int key0, unsigned int key1);
+    STATIC int uniformInt(unsigned int index, int minValue, int maxValue, unsigned int key0, unsigned int key1);
+
+    // [[[end]]]
+};
+
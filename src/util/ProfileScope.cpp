@@ -0,0 +1,48 @@
+// Copyright Hugh Perkins 2015 hughperkins at gmail
+//
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file, You can
+// obtain one at http://mozilla.org/MPL/2.0/.
+
+#include "util/Profiler.h"
+
+#include "util/ProfileScope.h"
+
+using namespace std;
+
+#undef VIRTUAL
+#undef STATIC
+#define VIRTUAL
+#define STATIC
+
+PUBLIC ProfileScope::ProfileScope(EasyCL *cl, int phase, void const *net, int layer) :
+        cl(cl),
+        deviceSpan(0),
+        phase(phase),
+        net(net),
+        layer(layer),
+        previousLayer(Profiler::getCurrentLayer()),
+        startNanos(0),
+        active(Profiler::isEnabled()) {
+    if(layer >= 0) {
+        Profiler::setCurrentLayer(layer);
+    }
+    if(!active) {
+        return;
+    }
+    if(cl != 0) {
+        deviceSpan = Profiler::beginDeviceSpan(cl, net, layer, phase);
+    }
+    startNanos = Profiler::nowNanos();
+}
+PUBLIC ProfileScope::~ProfileScope() {
+    Profiler::setCurrentLayer(previousLayer);
+    if(!active) {
+        return;
+    }
+    Profiler::record(net, layer, phase, false, Profiler::getThreadIndex(), startNanos, Profiler::nowNanos());
+    if(deviceSpan != 0) {
+        Profiler::endDeviceSpan(cl, deviceSpan);
+    }
+}
+
@@ -0,0 +1,46 @@
+// Copyright Hugh Perkins 2015 hughperkins at gmail
+//
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file, You can
+// obtain one at http://mozilla.org/MPL/2.0/.
+
+#pragma once
+
+#include "DeepCLDllExport.h"
+
+class EasyCL;
+
+#define VIRTUAL virtual
+#define STATIC static
+
+/// \brief times one phase of one layer, from construction to destruction
+///
+/// eg `ProfileScope profile(cl, Profiler::FORWARD, net, layerIndex);` at the
+/// top of a block, where net owns the layer, and is 0 for spans not in a
+/// layer.  Records nothing unless the Profiler is enabled.  cl can be 0, for
+/// host-only work, like loading data.  Also marks the calling thread as being
+/// in the layer, for Profiler::layerPrefix
+class DeepCL_EXPORT ProfileScope {
+    private:
+    EasyCL *cl;
+    void *deviceSpan;
+    const int phase;
+    void const *const net;
+    const int layer;
+    const int previousLayer;
+    long long startNanos;
+    bool active;
+
+    // [[[cog
+    // import cog_addheaders
+    // cog_addheaders.addv2()
+    // ]]]
+    // generated, using cog:
+
+    public:
+    ProfileScope(EasyCL *cl, int phase, void const *net, int layer);
+    ~ProfileScope();
+
+    // [[[end]]]
+};
+
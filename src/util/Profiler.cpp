@@ -0,0 +1,324 @@
+// Copyright Hugh Perkins 2015 hughperkins at gmail
+//
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file, You can
+// obtain one at http://mozilla.org/MPL/2.0/.
+
+#include <chrono>
+#include <mutex>
+#include <map>
+#include <fstream>
+#include <sstream>
+#include <iomanip>
+#include <stdexcept>
+#include <algorithm>
+
+#include "EasyCL.h"
+#include "util/stringhelper.h"
+
+#include "util/Profiler.h"
+
+using namespace std;
+
+#undef VIRTUAL
+#undef STATIC
+#define VIRTUAL
+#define STATIC
+
+std::atomic<bool> Profiler::enabled(false);
+std::atomic<unsigned long long> Profiler::head(0);
+ProfileEvent *Profiler::events = 0;
+unsigned long long Profiler::capacity = 1 << 18;
+unsigned long long Profiler::summaryStart = 0;
+
+static std::mutex profilerMutex; // allocation, layer names, and readers; never held by record
+static map< pair<void const*, int>, string > layerNames; // (net, layer) => name
+static unsigned long long clearedAt = 0;
+static std::atomic<int> nextThreadIndex(0);
+static thread_local int threadIndex = -1;
+static thread_local int currentLayer = -1;
+
+// a device span whose markers havent both completed yet
+struct DeviceSpan {
+    void const *net;
+    int layer;
+    int phase;
+    int thread;
+    long long startNanos;
+    long long endNanos;
+    std::atomic<int> numDone;
+};
+
+// whichever marker completes second records the span
+static void deviceSpanMarkerDone(DeviceSpan *span) {
+    if(span->numDone.fetch_add(1) == 1) {
+        long long endNanos = std::max(span->startNanos, span->endNanos);
+        Profiler::record(span->net, span->layer, span->phase, true, span->thread, span->startNanos, endNanos);
+        delete span;
+    }
+}
+static void CL_CALLBACK deviceSpanStarted(cl_event event, cl_int status, void *userData) {
+    DeviceSpan *span = reinterpret_cast<DeviceSpan *>(userData);
+    span->startNanos = Profiler::nowNanos();
+    clReleaseEvent(event);
+    deviceSpanMarkerDone(span);
+}
+static void CL_CALLBACK deviceSpanEnded(cl_event event, cl_int status, void *userData) {
+    DeviceSpan *span = reinterpret_cast<DeviceSpan *>(userData);
+    span->endNanos = Profiler::nowNanos();
+    clReleaseEvent(event);
+    deviceSpanMarkerDone(span);
+}
+// queues a marker, which calls callback once all the work queued before it is done
+static bool queueMarker(EasyCL *cl, void (CL_CALLBACK *callback)(cl_event, cl_int, void *), DeviceSpan *span) {
+    cl_event event;
+    if(clEnqueueMarker(*cl->queue, &event) != CL_SUCCESS) {
+        return false;
+    }
+    if(clSetEventCallback(event, CL_COMPLETE, callback, span) != CL_SUCCESS) {
+        clReleaseEvent(event);
+        return false;
+    }
+    return true;
+}
+
+// the ring buffer is allocated on first enable, and kept until exit, since
+// device spans can still arrive after disabling
+PUBLIC STATIC void Profiler::setEnabled(bool enable) {
+    if(enable) {
+        lock_guard<mutex> lock(profilerMutex);
+        if(events == 0) {
+            events = new ProfileEvent[capacity];
+            for(unsigned long long i = 0; i < capacity; i++) {
+                events[i].sequence.store(0);
+            }
+        }
+    }
+    enabled.store(enable);
+}
+PUBLIC STATIC bool Profiler::isEnabled() {
+    return enabled.load(std::memory_order_relaxed);
+}
+// number of spans kept, before the oldest are overwritten; only before first enabled
+PUBLIC STATIC void Profiler::setCapacity(int numSpans) {
+    lock_guard<mutex> lock(profilerMutex);
+    if(events != 0) {
+        throw runtime_error("Profiler::setCapacity: must be called before the profiler is first enabled");
+    }
+    if(numSpans <= 0) {
+        throw runtime_error("Profiler::setCapacity: capacity must be positive");
+    }
+    capacity = numSpans;
+}
+// nanoseconds since the first call
+PUBLIC STATIC long long Profiler::nowNanos() {
+    static const chrono::steady_clock::time_point epoch = chrono::steady_clock::now();
+    return chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now() - epoch).count();
+}
+// small number for the calling thread, in order of first use
+PUBLIC STATIC int Profiler::getThreadIndex() {
+    if(threadIndex < 0) {
+        threadIndex = nextThreadIndex.fetch_add(1);
+    }
+    return threadIndex;
+}
+// the layer the calling thread is working on, for log messages; -1 for none
+PUBLIC STATIC void Profiler::setCurrentLayer(int layer) {
+    currentLayer = layer;
+}
+PUBLIC STATIC int Profiler::getCurrentLayer() {
+    return currentLayer;
+}
+// "layer3 " while the calling thread is in layer 3, otherwise empty
+PUBLIC STATIC std::string Profiler::layerPrefix() {
+    if(currentLayer < 0) {
+        return "";
+    }
+    return "layer" + toString(currentLayer) + " ";
+}
+// names used in summaries and traces, eg the layer's class name.  Keyed by
+// the net owning the layer too, so a QuantizedNet built from a NeuralNet
+// doesnt rename the NeuralNet's layers
+PUBLIC STATIC void Profiler::setLayerName(void const *net, int layer, std::string name) {
+    lock_guard<mutex> lock(profilerMutex);
+    layerNames[make_pair(net, layer)] = name;
+}
+PUBLIC STATIC std::string Profiler::getLayerName(void const *net, int layer) {
+    lock_guard<mutex> lock(profilerMutex);
+    map< pair<void const*, int>, string >::iterator it = layerNames.find(make_pair(net, layer));
+    return it == layerNames.end() ? "" : it->second;
+}
+PUBLIC STATIC std::string Profiler::phaseName(int phase) {
+    switch(phase) {
+        case FORWARD: return "forward";
+        case BACKWARD: return "backward";
+        case UPDATE: return "update";
+        case IO: return "io";
+    }
+    return "unknown";
+}
+// claims the next slot, and writes the span into it; no locks, so safe from
+// any thread, including OpenCL callbacks
+PUBLIC STATIC void Profiler::record(void const *net, int layer, int phase, bool device, int thread, long long startNanos, long long endNanos) {
+    if(events == 0) {
+        return;
+    }
+    unsigned long long index = head.fetch_add(1, std::memory_order_relaxed);
+    ProfileEvent *event = &events[index % capacity];
+    event->sequence.store(0, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    event->span.net = net;
+    event->span.layer = layer;
+    event->span.phase = phase;
+    event->span.thread = thread;
+    event->span.device = device;
+    event->span.startNanos = startNanos;
+    event->span.endNanos = endNanos;
+    event->sequence.store(index + 1, std::memory_order_release);
+}
+// queues the start marker of a device span; returns 0 if markers cant be queued
+PUBLIC STATIC void *Profiler::beginDeviceSpan(EasyCL *cl, void const *net, int layer, int phase) {
+    DeviceSpan *span = new DeviceSpan();
+    span->net = net;
+    span->layer = layer;
+    span->phase = phase;
+    span->thread = getThreadIndex();
+    span->startNanos = 0;
+    span->endNanos = 0;
+    span->numDone.store(0);
+    if(!queueMarker(cl, deviceSpanStarted, span)) {
+        delete span;
+        return 0;
+    }
+    return span;
+}
+PUBLIC STATIC void Profiler::endDeviceSpan(EasyCL *cl, void *span) {
+    DeviceSpan *deviceSpan = reinterpret_cast<DeviceSpan *>(span);
+    if(!queueMarker(cl, deviceSpanEnded, deviceSpan)) {
+        // the start marker will still complete; end the span now instead
+        deviceSpan->endNanos = nowNanos();
+        deviceSpanMarkerDone(deviceSpan);
+    }
+}
+// total spans recorded since start, including any overwritten
+PUBLIC STATIC long long Profiler::getNumRecorded() {
+    return (long long)head.load();
+}
+// forgets all spans recorded so far
+PUBLIC STATIC void Profiler::clear() {
+    lock_guard<mutex> lock(profilerMutex);
+    summaryStart = head.load();
+    clearedAt = summaryStart;
+}
+// copies the completed spans from index start on, that havent been
+// overwritten, in order; returns the index of the first span still held
+PRIVATE STATIC unsigned long long Profiler::copySpans(unsigned long long start, std::vector<ProfileSpan> *spans) {
+    spans->clear();
+    if(events == 0) {
+        return start;
+    }
+    unsigned long long end = head.load(std::memory_order_acquire);
+    if(end > capacity && start < end - capacity) {
+        start = end - capacity;
+    }
+    for(unsigned long long index = start; index < end; index++) {
+        ProfileEvent *event = &events[index % capacity];
+        if(event->sequence.load(std::memory_order_acquire) != index + 1) {
+            continue; // still being written, or already overwritten
+        }
+        ProfileSpan span = event->span;
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if(event->sequence.load(std::memory_order_relaxed) == index + 1) {
+            spans->push_back(span);
+        }
+    }
+    return start;
+}
+// totals per layer and phase, since the last reset, or clear
+PUBLIC STATIC std::string Profiler::getSummary(bool reset) {
+    lock_guard<mutex> lock(profilerMutex);
+    vector<ProfileSpan> spans;
+    unsigned long long end = head.load();
+    unsigned long long first = copySpans(summaryStart, &spans);
+    unsigned long long numDropped = first - summaryStart;
+    if(reset) {
+        summaryStart = end;
+    }
+    // ((net, layer), phase) => calls, host nanos, device nanos
+    typedef pair< pair<void const*, int>, int > SpanKey;
+    map< SpanKey, long long > numCalls;
+    map< SpanKey, long long > hostNanos;
+    map< SpanKey, long long > deviceNanos;
+    long long phaseHostNanos[NUM_PHASES] = { 0 };
+    long long phaseDeviceNanos[NUM_PHASES] = { 0 };
+    for(int i = 0; i < (int)spans.size(); i++) {
+        ProfileSpan const &span = spans[i];
+        SpanKey key(make_pair(span.net, span.layer), span.phase);
+        long long nanos = span.endNanos - span.startNanos;
+        if(span.device) {
+            deviceNanos[key] += nanos;
+            phaseDeviceNanos[span.phase] += nanos;
+        } else {
+            numCalls[key]++;
+            hostNanos[key] += nanos;
+            phaseHostNanos[span.phase] += nanos;
+        }
+    }
+    ostringstream ss;
+    ss << "profile: " << spans.size() << " spans";
+    if(numDropped > 0) {
+        ss << ", " << numDropped << " older spans overwritten";
+    }
+    ss << endl;
+    ss << setw(6) << "layer" << " " << left << setw(22) << "name" << setw(10) << "phase" << right
+        << setw(8) << "calls" << setw(12) << "host ms" << setw(12) << "device ms" << endl;
+    ss << fixed << setprecision(2);
+    for(map< SpanKey, long long >::iterator it = numCalls.begin(); it != numCalls.end(); it++) {
+        SpanKey key = it->first;
+        int layer = key.first.second;
+        map< pair<void const*, int>, string >::iterator nameIt = layerNames.find(key.first);
+        string name = nameIt == layerNames.end() ? "" : nameIt->second;
+        ss << setw(6) << (layer >= 0 ? toString(layer) : string("-")) << " " << left << setw(22) << name
+            << setw(10) << phaseName(key.second) << right << setw(8) << it->second
+            << setw(12) << (hostNanos[key] / 1000000.0) << setw(12) << (deviceNanos[key] / 1000000.0) << endl;
+    }
+    for(int phase = 0; phase < NUM_PHASES; phase++) {
+        ss << setw(6) << "total" << " " << left << setw(22) << "" << setw(10) << phaseName(phase) << right << setw(8) << ""
+            << setw(12) << (phaseHostNanos[phase] / 1000000.0) << setw(12) << (phaseDeviceNanos[phase] / 1000000.0) << endl;
+    }
+    return ss.str();
+}
+// writes all the spans still held, in Chrome's trace event format: host spans
+// under one process, device spans under another, one track per thread
+PUBLIC STATIC void Profiler::writeChromeTrace(std::string filepath) {
+    vector<ProfileSpan> spans;
+    map< pair<void const*, int>, string > names;
+    {
+        lock_guard<mutex> lock(profilerMutex);
+        copySpans(clearedAt, &spans);
+        names = layerNames;
+    }
+    ofstream f(filepath.c_str());
+    if(!f.is_open()) {
+        throw runtime_error("Profiler::writeChromeTrace: couldnt open " + filepath);
+    }
+    f << "{\"displayTimeUnit\": \"ms\", \"traceEvents\": [" << endl;
+    f << "{\"name\": \"process_name\", \"ph\": \"M\", \"pid\": 1, \"args\": {\"name\": \"host\"}}," << endl;
+    f << "{\"name\": \"process_name\", \"ph\": \"M\", \"pid\": 2, \"args\": {\"name\": \"device\"}}";
+    f << fixed << setprecision(3);
+    for(int i = 0; i < (int)spans.size(); i++) {
+        ProfileSpan const &span = spans[i];
+        string name = phaseName(span.phase);
+        if(span.layer >= 0) {
+            map< pair<void const*, int>, string >::iterator nameIt = names.find(make_pair(span.net, span.layer));
+            string layerName = nameIt == names.end() ? "" : nameIt->second;
+            name = "layer" + toString(span.layer) + " " + (layerName != "" ? layerName + " " : "") + name;
+        }
+        f << "," << endl << "{\"name\": \"" << name << "\", \"cat\": \"" << phaseName(span.phase)
+            << "\", \"ph\": \"X\", \"pid\": " << (span.device ? 2 : 1) << ", \"tid\": " << span.thread
+            << ", \"ts\": " << (span.startNanos / 1000.0) << ", \"dur\": " << ((span.endNanos - span.startNanos) / 1000.0)
+            << ", \"args\": {\"layer\": " << span.layer << "}}";
+    }
+    f << endl << "]}" << endl;
+}
+
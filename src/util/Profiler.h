@@ -0,0 +1,95 @@
+// Copyright Hugh Perkins 2015 hughperkins at gmail
+//
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file, You can
+// obtain one at http://mozilla.org/MPL/2.0/.
+
+#pragma once
+
+#include <string>
+#include <vector>
+#include <atomic>
+
+#include "DeepCLDllExport.h"
+
+class EasyCL;
+
+#define VIRTUAL virtual
+#define STATIC static
+
+struct ProfileSpan {
+    void const *net; // the net owning layer, 0 for none
+    int layer; // -1 for spans not in a layer, eg loading data
+    int phase;
+    int thread;
+    bool device;
+    long long startNanos;
+    long long endNanos;
+};
+
+// one slot of the ring buffer.  sequence is the span's index + 1, once it is
+// completely written, so readers can skip slots that are being overwritten
+struct ProfileEvent {
+    std::atomic<unsigned long long> sequence;
+    ProfileSpan span;
+};
+
+/// \brief per-layer timings of forward, backward, weight update, and data loading
+///
+/// ProfileScope records a host span per layer phase, and, given an EasyCL,
+/// a device span too: a marker is queued before and after the phase's
+/// kernels, and the span runs from one marker completing to the other.
+/// Spans go into a fixed-size ring buffer, without locks, so any thread can
+/// record, including OpenCL's callback threads; once full, the oldest spans
+/// are overwritten.  Disabled, a ProfileScope costs one atomic load.
+/// getSummary gives totals per layer and phase, writeChromeTrace writes the
+/// spans in the Chrome trace format, for chrome://tracing or Perfetto.
+class DeepCL_EXPORT Profiler {
+    public:
+    enum Phase {
+        FORWARD = 0,
+        BACKWARD = 1,
+        UPDATE = 2,
+        IO = 3,
+        NUM_PHASES = 4
+    };
+
+    private:
+    static std::atomic<bool> enabled;
+    static std::atomic<unsigned long long> head;
+    static ProfileEvent *events;
+    static unsigned long long capacity;
+    static unsigned long long summaryStart;
+
+    // [[[cog
+    // import cog_addheaders
+    // cog_addheaders.addv2()
+    // ]]]
+    // generated, using cog:
+
+    public:
+    STATIC void setEnabled(bool enable);
+    STATIC bool isEnabled();
+    STATIC void setCapacity(int numSpans);
+    STATIC long long nowNanos();
+    STATIC int getThreadIndex();
+    STATIC void setCurrentLayer(int layer);
+    STATIC int getCurrentLayer();
+    STATIC std::string layerPrefix();
+    STATIC void setLayerName(void const *net, int layer, std::string name);
+    STATIC std::string getLayerName(void const *net, int layer);
+    STATIC std::string phaseName(int phase);
+    STATIC void record(void const *net, int layer, int phase, bool device, int thread, long long startNanos, long long endNanos);
+    STATIC void *beginDeviceSpan(EasyCL *cl, void const *net, int layer, int phase);
+    STATIC void endDeviceSpan(EasyCL *cl, void *span);
+    STATIC long long getNumRecorded();
+    STATIC void clear();
+    STATIC std::string getSummary(bool reset);
+    STATIC void writeChromeTrace(std::string filepath);
+
+    private:
+    STATIC unsigned long long copySpans(unsigned long long start, std::vector<ProfileSpan> *spans);
+
+    // [[[end]]]
+};
+
@@ -31,22 +31,31 @@ PUBLIC RandomSingleton::RandomSingleton() {
 }
 PUBLIC STATIC RandomSingleton *RandomSingleton::instance() {
     static RandomSingleton *thisinstance = new RandomSingleton();
-    return thisinstance; // assume single-threaded, which... we are :-)
+    return thisinstance;
 }
 //    void testingonly_setInstance(RandomSingleton *testInstance) {
 //        _instance = testinstance;
 //    }
 PUBLIC VIRTUAL float RandomSingleton::_uniform() {
+    std::lock_guard<std::mutex> lock(mutex);
     return myrandom() / (float)myrandom.max();
 }
+PUBLIC VIRTUAL unsigned int RandomSingleton::_uint32() {
+    std::lock_guard<std::mutex> lock(mutex);
+    return (unsigned int)myrandom();
+}
 PUBLIC STATIC void RandomSingleton::seed(unsigned long seed) {
-    instance()->myrandom.seed(seed);
+    RandomSingleton *random = instance();
+    std::lock_guard<std::mutex> lock(random->mutex);
+    random->myrandom.seed(seed);
 }
 PUBLIC STATIC float RandomSingleton::uniform() {
     return instance()->_uniform();
 }
 PUBLIC STATIC int RandomSingleton::uniformInt(int minValueInclusive, int maxValueInclusive) {
-    return (instance()->myrandom() % 
+    RandomSingleton *random = instance();
+    std::lock_guard<std::mutex> lock(random->mutex);
+    return (random->myrandom() % 
         (maxValueInclusive - minValueInclusive + 1) )
      + minValueInclusive;
 }
@@ -7,6 +7,8 @@
 #pragma once
 
 #include <random>
+#include <mutex>
+
 #include "DeepCLDllExport.h"
 #include "util/mt19937defs.h"
 
@@ -29,7 +31,7 @@
 // singleton version of mt19937, so we seed it once, based on current time
 // and then keep getting values out of it, even if used from different places
 // and classes
-// probably not threadsafe
+// calls lock a mutex, since data-parallel replicas draw from it from several threads
 // constructor is public, so we can override it, for testing, if we want
 class DeepCL_EXPORT RandomSingleton {
     private:
@@ -38,6 +40,7 @@ class DeepCL_EXPORT RandomSingleton {
     #pragma warning(disable: 4251)
     #endif
     MT19937 myrandom;
+    std::mutex mutex;
     #ifdef _WIN32
     #pragma warning(default: 4251)
     #endif
@@ -52,6 +55,7 @@ class DeepCL_EXPORT RandomSingleton {
     RandomSingleton();
     STATIC RandomSingleton *instance();
     VIRTUAL float _uniform();
+    VIRTUAL unsigned int _uint32();
     STATIC void seed(unsigned long seed);
     STATIC float uniform();
     STATIC int uniformInt(int minValueInclusive, int maxValueInclusive);
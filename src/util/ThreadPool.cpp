@@ -0,0 +1,130 @@
+// Copyright Hugh Perkins 2015 hughperkins at gmail
+//
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file, You can
+// obtain one at http://mozilla.org/MPL/2.0/.
+
+#include <cstdlib>
+
+#include "util/ThreadPool.h"
+
+using namespace std;
+
+#undef STATIC
+#define STATIC
+#undef VIRTUAL
+#define VIRTUAL
+
+PUBLIC ThreadPool::ThreadPool(int numThreads) :
+        numTasks(0),
+        nextTask(0),
+        tasksRemaining(0),
+        generation(0),
+        stopping(false) {
+    // the calling thread works too, so we need one less worker than numThreads
+    for(int i = 1; i < numThreads; i++) {
+        threads.push_back(thread(&ThreadPool::workerLoop, this));
+    }
+}
+PUBLIC ThreadPool::~ThreadPool() {
+    {
+        unique_lock<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    workAvailable.notify_all();
+    for(int i = 0; i < (int)threads.size(); i++) {
+        threads[i].join();
+    }
+}
+PUBLIC STATIC ThreadPool *ThreadPool::instance() {
+    static ThreadPool *thisinstance = new ThreadPool(defaultNumThreads());
+    return thisinstance;
+}
+// number of hardware threads, unless overridden by env var DEEPCL_NUM_THREADS
+PUBLIC STATIC int ThreadPool::defaultNumThreads() {
+    const char *fromEnv = getenv("DEEPCL_NUM_THREADS");
+    if(fromEnv != 0 && atoi(fromEnv) > 0) {
+        return atoi(fromEnv);
+    }
+    int numThreads = (int)thread::hardware_concurrency();
+    return numThreads > 0 ? numThreads : 1;
+}
+PUBLIC int ThreadPool::getNumThreads() {
+    return (int)threads.size() + 1;
+}
+// runs fn(0) ... fn(numTasks - 1), and returns once they are all done
+// the first exception thrown by any task is rethrown here
+PUBLIC void ThreadPool::parallelFor(int numTasks, ThreadPoolTask fn) {
+    if(numTasks <= 0) {
+        return;
+    }
+    unique_lock<std::mutex> callLock(callMutex, try_to_lock);
+    if(!callLock.owns_lock() || threads.size() == 0 || numTasks == 1) {
+        for(int i = 0; i < numTasks; i++) {
+            fn(i);
+        }
+        return;
+    }
+    {
+        unique_lock<std::mutex> lock(mutex);
+        this->job = fn;
+        this->numTasks = numTasks;
+        this->nextTask = 0;
+        this->tasksRemaining = numTasks;
+        this->firstException = exception_ptr();
+        generation++;
+    }
+    workAvailable.notify_all();
+    runTasks();
+    exception_ptr exception;
+    {
+        unique_lock<std::mutex> lock(mutex);
+        while(tasksRemaining > 0) {
+            workDone.wait(lock);
+        }
+        job = nullptr;
+        exception = firstException;
+        firstException = exception_ptr();
+    }
+    if(exception) {
+        rethrow_exception(exception);
+    }
+}
+PRIVATE void ThreadPool::runTasks() {
+    unique_lock<std::mutex> lock(mutex);
+    while(nextTask < numTasks) {
+        int task = nextTask++;
+        lock.unlock();
+        try {
+            job(task);
+        } catch(...) {
+            lock.lock();
+            if(!firstException) {
+                firstException = current_exception();
+            }
+            lock.unlock();
+        }
+        lock.lock();
+        tasksRemaining--;
+        if(tasksRemaining == 0) {
+            workDone.notify_all();
+        }
+    }
+}
+PRIVATE void ThreadPool::workerLoop() {
+    long seenGeneration = 0;
+    while(true) {
+        {
+            unique_lock<std::mutex> lock(mutex);
+            while(!stopping && generation == seenGeneration) {
+                workAvailable.wait(lock);
+            }
+            if(stopping) {
+                return;
+            }
+            seenGeneration = generation;
+        }
+        runTasks();
+    }
+}
+
@@ -0,0 +1,70 @@
+// Copyright Hugh Perkins 2015 hughperkins at gmail
+//
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file, You can
+// obtain one at http://mozilla.org/MPL/2.0/.
+
+#pragma once
+
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <exception>
+
+#include "DeepCLDllExport.h"
+
+#define VIRTUAL virtual
+#define STATIC static
+
+typedef std::function<void(int)> ThreadPoolTask;
+
+// fixed-size pool of worker threads, used by the native cpu paths
+// (convolution, loaders, ...)
+// parallelFor blocks until all tasks are done; the calling thread
+// works on tasks too.  If the pool is already busy (eg called from
+// inside a task, or from two threads at once), the tasks just run
+// serially on the calling thread, so it cant deadlock
+class DeepCL_EXPORT ThreadPool {
+    private:
+    #ifdef _WIN32
+    #pragma warning(disable: 4251)
+    #endif
+    std::vector<std::thread> threads;
+    std::mutex mutex;
+    std::mutex callMutex;
+    std::condition_variable workAvailable;
+    std::condition_variable workDone;
+    ThreadPoolTask job;
+    std::exception_ptr firstException;
+    #ifdef _WIN32
+    #pragma warning(default: 4251)
+    #endif
+    int numTasks;
+    int nextTask;
+    int tasksRemaining;
+    long generation;
+    bool stopping;
+
+    // [[[cog
+    // import cog_addheaders
+    // cog_addheaders.addv2()
+    // ]]]
+    // generated, using cog:
+
+    public:
+    ThreadPool(int numThreads);
+    ~ThreadPool();
+    STATIC ThreadPool *instance();
+    STATIC int defaultNumThreads();
+    int getNumThreads();
+    void parallelFor(int numTasks, ThreadPoolTask fn);
+
+    private:
+    void runTasks();
+    void workerLoop();
+
+    // [[[end]]]
+};
+
@@ -0,0 +1,175 @@
+// Copyright Hugh Perkins 2015 hughperkins at gmail
+//
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file, You can
+// obtain one at http://mozilla.org/MPL/2.0/.
+
+#include <iostream>
+#include <sstream>
+#include <stdexcept>
+#include <map>
+#include <mutex>
+
+#include "EasyCL.h"
+#include "util/KernelCache.h"
+#include "util/Workspace.h"
+#include "util/stringhelper.h"
+
+using namespace std;
+
+#undef STATIC
+#define STATIC
+#undef VIRTUAL
+#define VIRTUAL
+
+// name we store the marker kernel under, in the EasyCL
+#define WORKSPACE_MARKER "Workspace.marker"
+
+static std::mutex &registryMutex() {
+    static std::mutex mutex;
+    return mutex;
+}
+static map<EasyCL *, Workspace *> &registry() {
+    static map<EasyCL *, Workspace *> workspaces;
+    return workspaces;
+}
+
+// the arena for cl, created on first use
+// We cant hook EasyCL's destructor, so each arena leaves a marker kernel in its
+// EasyCL, which EasyCL deletes along with itself.  If an EasyCL has been
+// deleted, and a new one created at the same address, the new one wont have
+// our marker, so we know not to hand out buffers from the dead context
+PUBLIC STATIC Workspace *Workspace::get(EasyCL *cl) {
+    lock_guard<std::mutex> lock(registryMutex());
+    map<EasyCL *, Workspace *> &workspaces = registry();
+    map<EasyCL *, Workspace *>::iterator it = workspaces.find(cl);
+    if(it != workspaces.end()) {
+        if(cl->kernelExists(WORKSPACE_MARKER) && cl->getKernel(WORKSPACE_MARKER) == it->second->marker) {
+            return it->second;
+        }
+        // stale; its buffers belong to a context that is already gone.  Each
+        // cl_mem still holds a reference on that context, so release them
+        // here, or neither they nor the context are ever freed
+        it->second->abandon();
+        delete it->second;
+        workspaces.erase(it);
+    }
+    Workspace *workspace = new Workspace(cl);
+    workspaces[cl] = workspace;
+    return workspace;
+}
+// frees the arena for cl, if any.  Call before deleting cl
+PUBLIC STATIC void Workspace::deleteFor(EasyCL *cl) {
+    lock_guard<std::mutex> lock(registryMutex());
+    map<EasyCL *, Workspace *> &workspaces = registry();
+    map<EasyCL *, Workspace *>::iterator it = workspaces.find(cl);
+    if(it != workspaces.end()) {
+        delete it->second;
+        workspaces.erase(it);
+    }
+}
+PUBLIC Workspace::Workspace(EasyCL *cl) :
+        cl(cl),
+        marker(0),
+        numInUse(0),
+        allocatedBytes(0),
+        inUseBytes(0),
+        peakBytes(0),
+        numAllocations(0),
+        numReallocations(0),
+        numAcquires(0) {
+    marker = KernelCache::buildKernelFromString(cl, "kernel void workspace_marker() {}\n",
+        "workspace_marker", "", "Workspace.cpp");
+    cl->storeKernel(WORKSPACE_MARKER, marker, true);
+}
+PUBLIC Workspace::~Workspace() {
+    for(int i = 0; i < (int)buffers.size(); i++) {
+        delete buffers[i].wrapper;
+        delete[] buffers[i].hostArray;
+    }
+}
+PRIVATE void Workspace::abandon() {
+    for(int i = 0; i < (int)buffers.size(); i++) {
+        delete buffers[i].wrapper;
+        delete[] buffers[i].hostArray;
+    }
+    buffers.clear();
+}
+// a device buffer of at least numFloats floats, contents undefined
+// valid until the enclosing WorkspaceScope ends
+PUBLIC CLWrapper *Workspace::acquire(int numFloats) {
+    if(numFloats <= 0) {
+        throw runtime_error("Workspace::acquire: numFloats must be positive, was " + toString(numFloats));
+    }
+    numAcquires++;
+    if(numInUse == (int)buffers.size()) {
+        WorkspaceBuffer buffer;
+        buffer.hostArray = 0;
+        buffer.wrapper = 0;
+        buffer.capacity = 0;
+        buffer.used = 0;
+        buffers.push_back(buffer);
+    }
+    WorkspaceBuffer &buffer = buffers[numInUse];
+    if(buffer.capacity < numFloats) {
+        if(buffer.wrapper != 0) {
+            numReallocations++;
+            allocatedBytes -= (long)buffer.capacity * sizeof(float);
+            delete buffer.wrapper;
+            delete[] buffer.hostArray;
+        }
+        buffer.hostArray = new float[numFloats];
+        buffer.wrapper = cl->wrap(numFloats, buffer.hostArray);
+        buffer.wrapper->createOnDevice();
+        buffer.capacity = numFloats;
+        numAllocations++;
+        allocatedBytes += (long)numFloats * sizeof(float);
+    }
+    buffer.used = numFloats;
+    inUseBytes += (long)numFloats * sizeof(float);
+    if(inUseBytes > peakBytes) {
+        peakBytes = inUseBytes;
+    }
+    numInUse++;
+    return buffer.wrapper;
+}
+PUBLIC int Workspace::getMark() {
+    return numInUse;
+}
+// gives back everything acquired since getMark() returned mark
+PUBLIC void Workspace::releaseTo(int mark) {
+    if(mark > numInUse) {
+        throw runtime_error("Workspace::releaseTo: mark " + toString(mark) + " is above the top " + toString(numInUse));
+    }
+    while(numInUse > mark) {
+        numInUse--;
+        inUseBytes -= (long)buffers[numInUse].used * sizeof(float);
+        buffers[numInUse].used = 0;
+    }
+}
+// bytes currently held on the device, in use or not
+PUBLIC long Workspace::getAllocatedBytes() {
+    return allocatedBytes;
+}
+// most bytes ever in use at the same time
+PUBLIC long Workspace::getPeakBytes() {
+    return peakBytes;
+}
+// device buffers created, including regrowing one
+PUBLIC int Workspace::getNumAllocations() {
+    return numAllocations;
+}
+// times an existing buffer had to be thrown away, for a bigger one
+PUBLIC int Workspace::getNumReallocations() {
+    return numReallocations;
+}
+PUBLIC long Workspace::getNumAcquires() {
+    return numAcquires;
+}
+PUBLIC std::string Workspace::getStatsString() {
+    ostringstream oss;
+    oss << "workspace: " << buffers.size() << " buffers, " << (allocatedBytes / 1024) << "KB allocated, peak in use " <<
+        (peakBytes / 1024) << "KB, " << numAcquires << " acquires, " << numAllocations << " allocations, " <<
+        numReallocations << " reallocations";
+    return oss.str();
+}
@@ -0,0 +1,85 @@
+// Copyright Hugh Perkins 2015 hughperkins at gmail
+//
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file, You can
+// obtain one at http://mozilla.org/MPL/2.0/.
+
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include "DeepCLDllExport.h"
+
+class EasyCL;
+class CLWrapper;
+class CLKernel;
+
+#define VIRTUAL virtual
+#define STATIC static
+
+class WorkspaceBuffer {
+public:
+    float *hostArray;
+    CLWrapper *wrapper;
+    int capacity; // in floats
+    int used; // floats asked for by the current holder
+};
+
+// scratch device buffers, one arena per EasyCL, shared by all the layers and
+// trainers using that EasyCL
+// Buffers are handed out as a stack: a WorkspaceScope remembers the top of the
+// stack when it is created, and gives everything acquired since back when it
+// goes out of scope.  So the buffer at each depth gets reused on every call,
+// and only grows when someone asks for more than its high-water mark.
+// Open a scope inside forward() for per-forward scratch, or around a whole
+// batch, for scratch that needs to live that long
+// Buffers may be bigger than asked for, so use the explicit-size
+// CLMathWrapper constructor on them, and pass sizes to kernels explicitly
+// Not thread-safe, same as the EasyCL queue it uses
+class DeepCL_EXPORT Workspace {
+    private:
+    EasyCL *cl;
+    CLKernel *marker;
+    #ifdef _WIN32
+    #pragma warning(disable: 4251)
+    #endif
+    std::vector<WorkspaceBuffer> buffers;
+    #ifdef _WIN32
+    #pragma warning(default: 4251)
+    #endif
+    int numInUse;
+    long allocatedBytes;
+    long inUseBytes;
+    long peakBytes;
+    int numAllocations;
+    int numReallocations;
+    long numAcquires;
+
+    // [[[cog
+    // import cog_addheaders
+    // cog_addheaders.addv2()
+    // ]]]
+    // generated, using cog:
+
+    public:
+    STATIC Workspace *get(EasyCL *cl);
+    STATIC void deleteFor(EasyCL *cl);
+    Workspace(EasyCL *cl);
+    ~Workspace();
+    CLWrapper *acquire(int numFloats);
+    int getMark();
+    void releaseTo(int mark);
+    long getAllocatedBytes();
+    long getPeakBytes();
+    int getNumAllocations();
+    int getNumReallocations();
+    long getNumAcquires();
+    std::string getStatsString();
+
+    private:
+    void abandon();
+
+    // [[[end]]]
+};
+
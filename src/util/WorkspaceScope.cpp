@@ -0,0 +1,26 @@
+// Copyright Hugh Perkins 2015 hughperkins at gmail
+//
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file, You can
+// obtain one at http://mozilla.org/MPL/2.0/.
+
+#include "util/Workspace.h"
+#include "util/WorkspaceScope.h"
+
+using namespace std;
+
+#undef STATIC
+#define STATIC
+#undef VIRTUAL
+#define VIRTUAL
+
+PUBLIC WorkspaceScope::WorkspaceScope(EasyCL *cl) {
+    workspace = Workspace::get(cl);
+    mark = workspace->getMark();
+}
+PUBLIC WorkspaceScope::~WorkspaceScope() {
+    workspace->releaseTo(mark);
+}
+PUBLIC CLWrapper *WorkspaceScope::acquire(int numFloats) {
+    return workspace->acquire(numFloats);
+}
@@ -0,0 +1,39 @@
+// Copyright Hugh Perkins 2015 hughperkins at gmail
+//
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file, You can
+// obtain one at http://mozilla.org/MPL/2.0/.
+
+#pragma once
+
+#include "DeepCLDllExport.h"
+
+class EasyCL;
+class CLWrapper;
+class Workspace;
+
+#define VIRTUAL virtual
+#define STATIC static
+
+// scratch from cl's Workspace, given back when this goes out of scope, eg:
+//     WorkspaceScope workspace(cl);
+//     CLWrapper *scratch = workspace.acquire(numFloats);
+class DeepCL_EXPORT WorkspaceScope {
+    private:
+    Workspace *workspace;
+    int mark;
+
+    // [[[cog
+    // import cog_addheaders
+    // cog_addheaders.addv2()
+    // ]]]
+    // generated, using cog:
+
+    public:
+    WorkspaceScope(EasyCL *cl);
+    ~WorkspaceScope();
+    CLWrapper *acquire(int numFloats);
+
+    // [[[end]]]
+};
+
@@ -7,6 +7,7 @@
 #include <string>
 #include <vector>
 #include <sstream>
+#include <cstdio>
 using namespace std;
 
 #include "util/stringhelper.h"
@@ -93,4 +94,12 @@ void strcpy_safe(char *destination, char const*source, int maxLength) {
     destination[i] = 0;
 }
 
-
+std::string toFloatLiteral(float val) {
+    char buffer[64];
+    snprintf(buffer, sizeof(buffer), "%.9g", val); // 9 significant digits round-trip any float
+    string result = buffer;
+    if(result.find_first_of(".e") == string::npos) {
+        result += ".0";
+    }
+    return result + "f";
+}
@@ -59,3 +59,6 @@ std::string toLower(std::string in);
 
 void strcpy_safe(char *destination, char const*source, int maxLength);
 
+// val as an OpenCL float literal, eg "0.5f", "3.0f", "9.53674316e-07f", exact to the last bit
+std::string toFloatLiteral(float val);
+
@@ -0,0 +1,383 @@
+// Copyright Hugh Perkins 2015 hughperkins at gmail
+//
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file, You can
+// obtain one at http://mozilla.org/MPL/2.0/.
+
+#include <iostream>
+#include <cstring>
+#include <cmath>
+#include <stdexcept>
+
+#include "util/FileHelper.h"
+#include "util/MappedFile.h"
+#include "util/stringhelper.h"
+#include "net/NeuralNet.h"
+#include "layer/Layer.h"
+#include "weights/WeightsPersister.h"
+
+#include "weights/WeightsFile.h"
+
+using namespace std;
+
+#undef STATIC
+#define STATIC
+#undef VIRTUAL
+#define VIRTUAL
+
+// where version 4 adds its fields to the version 3 header, after the
+// training config string, which is at most 800 characters from byte 28
+static const int numEntriesOffset = 896;
+static const int tocOffsetOffset = 904;
+
+static uint64_t checksum(char const*data, long length) {
+    uint64_t hash = 14695981039346656037ULL;
+    long numWords = length / 8;
+    for(long i = 0; i < numWords; i++) {
+        uint64_t word;
+        memcpy(&word, data + i * 8, 8);
+        hash ^= word;
+        hash *= 1099511628211ULL;
+    }
+    for(long i = numWords * 8; i < length; i++) {
+        hash ^= (unsigned char)data[i];
+        hash *= 1099511628211ULL;
+    }
+    return hash;
+}
+// rounds to nearest, ties to even; too large for float16 gives infinity
+static uint16_t floatToHalf(float value) {
+    uint32_t bits;
+    memcpy(&bits, &value, 4);
+    uint32_t sign = (bits >> 16) & 0x8000;
+    uint32_t exponent = (bits >> 23) & 0xff;
+    uint32_t mantissa = bits & 0x7fffff;
+    if(exponent == 0xff) { // infinity, nan
+        return (uint16_t)(sign | 0x7c00 | (mantissa != 0 ? 0x200 : 0));
+    }
+    int halfExponent = (int)exponent - 127 + 15;
+    if(halfExponent >= 31) {
+        return (uint16_t)(sign | 0x7c00);
+    }
+    int shift = 13;
+    uint32_t half = 0;
+    if(halfExponent <= 0) { // subnormal, or zero
+        if(halfExponent < -10) {
+            return (uint16_t)sign;
+        }
+        mantissa |= 0x800000;
+        shift = 14 - halfExponent;
+    } else {
+        half = (uint32_t)halfExponent << 10;
+    }
+    half |= mantissa >> shift;
+    uint32_t remainder = mantissa & ((1u << shift) - 1);
+    uint32_t halfway = 1u << (shift - 1);
+    if(remainder > halfway || (remainder == halfway && (half & 1))) {
+        half++; // might carry into the exponent, which is still right
+    }
+    return (uint16_t)(sign | half);
+}
+static float halfToFloat(uint16_t half) {
+    uint32_t sign = (uint32_t)(half & 0x8000) << 16;
+    uint32_t exponent = (half >> 10) & 0x1f;
+    uint32_t mantissa = half & 0x3ff;
+    uint32_t bits;
+    if(exponent == 0x1f) {
+        bits = sign | 0x7f800000 | (mantissa << 13);
+    } else if(exponent == 0) {
+        if(mantissa == 0) {
+            bits = sign;
+        } else { // subnormal, normalize it
+            exponent = 127 - 15 + 1;
+            while((mantissa & 0x400) == 0) {
+                mantissa <<= 1;
+                exponent--;
+            }
+            bits = sign | (exponent << 23) | ((mantissa & 0x3ff) << 13);
+        }
+    } else {
+        bits = sign | ((exponent + 127 - 15) << 23) | (mantissa << 13);
+    }
+    float value;
+    memcpy(&value, &bits, 4);
+    return value;
+}
+
+/// true if filepath is a version 4 weights file; only reads its first bytes
+PUBLIC STATIC bool WeightsFile::isIndexed(std::string filepath) {
+    if(!FileHelper::exists(filepath) || FileHelper::getFilesize(filepath) < headerSize) {
+        return false;
+    }
+    char start[8];
+    FileHelper::readBinaryChunk(start, filepath, 0, 8);
+    int32_t fileVersion;
+    memcpy(&fileVersion, start + 4, 4);
+    return strncmp(start, "ClCn", 4) == 0 && fileVersion == version;
+}
+/// bytes writeToArray writes for net
+PUBLIC STATIC long WeightsFile::getFileSize(NeuralNet *net, int dtype) {
+    int numEntries = 0;
+    long dataSize = 0;
+    for(int layerIndex = 1; layerIndex < net->getNumLayers(); layerIndex++) {
+        int persistSize = net->getLayer(layerIndex)->getPersistSize(WeightsPersister::latestVersion);
+        if(persistSize > 0) {
+            numEntries++;
+            dataSize += alignUp(persistSize * getDtypeSize(dtype));
+        }
+    }
+    return alignUp(headerSize + numEntries * (long)sizeof(WeightsFileEntry)) + dataSize;
+}
+/// writes the whole file into target, of getFileSize(net, dtype) bytes
+PUBLIC STATIC void WeightsFile::writeToArray(char *target, std::string trainingConfigString, NeuralNet *net, int epoch, int batch, float annealedLearningRate, int numRight, float loss, int dtype) {
+    long dtypeSize = getDtypeSize(dtype);
+    memset(target, 0, headerSize);
+    int32_t *targetInts = reinterpret_cast<int32_t *>(target);
+    float *targetFloats = reinterpret_cast<float *>(target);
+    strcpy_safe(target, "ClCn", 4); // so easy to recognise file type
+    targetInts[1] = version;
+    targetInts[2] = epoch;
+    targetInts[3] = batch;
+    targetInts[4] = numRight;
+    targetFloats[5] = loss;
+    targetFloats[6] = annealedLearningRate;
+    strcpy_safe(target + 7 * 4, trainingConfigString.c_str(), 800);
+
+    vector<WeightsFileEntry> entries;
+    for(int layerIndex = 1; layerIndex < net->getNumLayers(); layerIndex++) {
+        int persistSize = net->getLayer(layerIndex)->getPersistSize(WeightsPersister::latestVersion);
+        if(persistSize > 0) {
+            WeightsFileEntry entry;
+            memset(&entry, 0, sizeof(entry));
+            entry.layerIndex = layerIndex;
+            entry.dtype = dtype;
+            entry.numElements = persistSize;
+            entries.push_back(entry);
+        }
+    }
+    int32_t numEntries = (int32_t)entries.size();
+    int64_t tocOffset = headerSize;
+    memcpy(target + numEntriesOffset, &numEntries, 4);
+    memcpy(target + tocOffsetOffset, &tocOffset, 8);
+
+    long offset = alignUp(tocOffset + numEntries * (long)sizeof(WeightsFileEntry));
+    memset(target + tocOffset, 0, offset - tocOffset);
+    vector<float> values;
+    for(int i = 0; i < numEntries; i++) {
+        WeightsFileEntry &entry = entries[i];
+        Layer *layer = net->getLayer(entry.layerIndex);
+        long numBytes = entry.numElements * dtypeSize;
+        entry.offset = offset;
+        if(dtype == FLOAT32) {
+            layer->persistToArray(WeightsPersister::latestVersion, reinterpret_cast<float *>(target + offset));
+        } else {
+            values.resize(entry.numElements);
+            layer->persistToArray(WeightsPersister::latestVersion, &values[0]);
+            uint16_t *halves = reinterpret_cast<uint16_t *>(target + offset);
+            for(int j = 0; j < entry.numElements; j++) {
+                halves[j] = floatToHalf(values[j]);
+                if((halves[j] & 0x7fff) == 0x7c00 && !std::isinf(values[j])) {
+                    throw runtime_error("WeightsFile: layer " + toString(entry.layerIndex) + " has value " +
+                        toString(values[j]) + ", too large for float16; please store as float32");
+                }
+            }
+        }
+        entry.checksum = checksum(target + offset, numBytes);
+        long end = alignUp(offset + numBytes);
+        memset(target + offset + numBytes, 0, end - offset - numBytes);
+        offset = end;
+    }
+    if(numEntries > 0) {
+        memcpy(target + tocOffset, &entries[0], numEntries * sizeof(WeightsFileEntry));
+    }
+}
+/// maps filepath, and checks its header, and table of contents
+///
+/// throws if filepath isnt a version 4 weights file, or its table of contents
+/// points outside the file; the layers' checksums are checked as they are read
+PUBLIC WeightsFile::WeightsFile(std::string filepath) :
+        filepath(filepath),
+        mappedFile(0),
+        epoch(0),
+        batch(0),
+        numRight(0),
+        loss(0),
+        annealedLearningRate(0) {
+    mappedFile = new MappedFile(filepath);
+    char const*data = mappedFile->getData();
+    long size = mappedFile->getSize();
+    try {
+        if(size < headerSize || strncmp(data, "ClCn", 4) != 0) {
+            throw runtime_error("WeightsFile: " + filepath + " is not a weights file");
+        }
+        int32_t header[7];
+        memcpy(header, data, sizeof(header));
+        if(header[1] != version) {
+            throw runtime_error("WeightsFile: " + filepath + " is weights file version " + toString(header[1]) +
+                ", not " + toString(version));
+        }
+        epoch = header[2];
+        batch = header[3];
+        numRight = header[4];
+        memcpy(&loss, &header[5], 4);
+        memcpy(&annealedLearningRate, &header[6], 4);
+        int maxLength = numEntriesOffset - 7 * 4;
+        int length = 0;
+        while(length < maxLength && data[7 * 4 + length] != 0) {
+            length++;
+        }
+        trainingConfigString = string(data + 7 * 4, length);
+
+        int32_t numEntries;
+        int64_t tocOffset;
+        memcpy(&numEntries, data + numEntriesOffset, 4);
+        memcpy(&tocOffset, data + tocOffsetOffset, 8);
+        if(numEntries < 0 || tocOffset < headerSize || tocOffset > size ||
+                numEntries > (size - tocOffset) / (long)sizeof(WeightsFileEntry)) {
+            throw runtime_error("WeightsFile: " + filepath + " table of contents is outside the file");
+        }
+        entries.resize(numEntries);
+        if(numEntries > 0) {
+            memcpy(&entries[0], data + tocOffset, numEntries * sizeof(WeightsFileEntry));
+        }
+        for(int i = 0; i < numEntries; i++) {
+            WeightsFileEntry const&entry = entries[i];
+            if(entry.dtype != FLOAT32 && entry.dtype != FLOAT16) {
+                throw runtime_error("WeightsFile: " + filepath + " layer " + toString(entry.layerIndex) +
+                    " has unknown dtype " + toString(entry.dtype));
+            }
+            if(entry.numElements < 0 || entry.offset % alignment != 0 || entry.offset < tocOffset ||
+                    entry.offset > size || entry.numElements > (size - entry.offset) / getDtypeSize(entry.dtype)) {
+                throw runtime_error("WeightsFile: " + filepath + " layer " + toString(entry.layerIndex) +
+                    " is outside the file");
+            }
+        }
+    } catch(...) {
+        delete mappedFile;
+        throw;
+    }
+}
+PUBLIC WeightsFile::~WeightsFile() {
+    delete mappedFile;
+}
+PUBLIC int WeightsFile::getEpoch() {
+    return epoch;
+}
+PUBLIC int WeightsFile::getBatch() {
+    return batch;
+}
+PUBLIC int WeightsFile::getNumRight() {
+    return numRight;
+}
+PUBLIC float WeightsFile::getLoss() {
+    return loss;
+}
+PUBLIC float WeightsFile::getAnnealedLearningRate() {
+    return annealedLearningRate;
+}
+PUBLIC std::string WeightsFile::getTrainingConfigString() {
+    return trainingConfigString;
+}
+PUBLIC int WeightsFile::getNumEntries() {
+    return (int)entries.size();
+}
+/// the table of contents entry for layerIndex, or 0 if the file has none
+PUBLIC WeightsFileEntry const*WeightsFile::getEntry(int layerIndex) {
+    for(int i = 0; i < (int)entries.size(); i++) {
+        if(entries[i].layerIndex == layerIndex) {
+            return &entries[i];
+        }
+    }
+    return 0;
+}
+/// throws if layerIndex isnt in the file, or its values dont match their checksum
+PUBLIC void WeightsFile::verifyLayer(int layerIndex) {
+    WeightsFileEntry const*entry = getEntry(layerIndex);
+    if(entry == 0) {
+        throw runtime_error("WeightsFile: " + filepath + " has no layer " + toString(layerIndex));
+    }
+    char const*values = mappedFile->getData() + entry->offset;
+    if(checksum(values, entry->numElements * getDtypeSize(entry->dtype)) != entry->checksum) {
+        throw runtime_error("WeightsFile: " + filepath + " layer " + toString(layerIndex) +
+            " doesnt match its checksum, the file is corrupt");
+    }
+}
+/// checks, and copies, layerIndex's values into target, of getEntry(layerIndex)->numElements
+/// floats, converting from float16 if need be.  Needs no net
+PUBLIC void WeightsFile::readLayer(int layerIndex, float *target) {
+    verifyLayer(layerIndex);
+    WeightsFileEntry const*entry = getEntry(layerIndex);
+    char const*values = mappedFile->getData() + entry->offset;
+    if(entry->dtype == FLOAT32) {
+        memcpy(target, values, entry->numElements * sizeof(float));
+    } else {
+        uint16_t const*halves = reinterpret_cast<uint16_t const*>(values);
+        for(int i = 0; i < entry->numElements; i++) {
+            target[i] = halfToFloat(halves[i]);
+        }
+    }
+}
+/// checks, and unpersists, layerIndex's values into net's layer layerIndex
+PUBLIC void WeightsFile::loadLayer(NeuralNet *net, int layerIndex) {
+    if(layerIndex < 1 || layerIndex >= net->getNumLayers()) {
+        throw runtime_error("WeightsFile: net has no layer " + toString(layerIndex));
+    }
+    Layer *layer = net->getLayer(layerIndex);
+    int persistSize = layer->getPersistSize(WeightsPersister::latestVersion);
+    WeightsFileEntry const*entry = getEntry(layerIndex);
+    int numElements = entry == 0 ? 0 : entry->numElements;
+    if(numElements != persistSize) {
+        throw runtime_error("WeightsFile: " + filepath + " layer " + toString(layerIndex) + " has " +
+            toString(numElements) + " values, but we expect to see: " + toString(persistSize) +
+            ".  So there is probably some mismatch between the weights file, and the settings, or network version, used.");
+    }
+    if(entry == 0) {
+        return;
+    }
+    if(entry->dtype == FLOAT32) {
+        verifyLayer(layerIndex);
+        layer->unpersistFromArray(WeightsPersister::latestVersion,
+            reinterpret_cast<float const*>(mappedFile->getData() + entry->offset));
+    } else {
+        vector<float> values(numElements);
+        readLayer(layerIndex, &values[0]);
+        layer->unpersistFromArray(WeightsPersister::latestVersion, &values[0]);
+    }
+}
+/// loads every layer of net, after checking the file has exactly net's layers
+PUBLIC void WeightsFile::loadNet(NeuralNet *net) {
+    int numWithParameters = 0;
+    for(int layerIndex = 1; layerIndex < net->getNumLayers(); layerIndex++) {
+        int persistSize = net->getLayer(layerIndex)->getPersistSize(WeightsPersister::latestVersion);
+        WeightsFileEntry const*entry = getEntry(layerIndex);
+        if(persistSize > 0) {
+            numWithParameters++;
+        }
+        if((entry == 0 ? 0 : entry->numElements) != persistSize) {
+            loadLayer(net, layerIndex); // throws, with the details
+        }
+    }
+    if(numWithParameters != (int)entries.size()) {
+        throw runtime_error("WeightsFile: " + filepath + " has " + toString(entries.size()) +
+            " layers with parameters, but the net has " + toString(numWithParameters) +
+            ".  So there is probably some mismatch between the weights file, and the settings, or network version, used.");
+    }
+    if(entries.size() > 0) {
+        mappedFile->willNeed(entries[0].offset, mappedFile->getSize() - entries[0].offset);
+    }
+    for(int layerIndex = 1; layerIndex < net->getNumLayers(); layerIndex++) {
+        loadLayer(net, layerIndex);
+    }
+}
+PRIVATE STATIC long WeightsFile::getDtypeSize(int dtype) {
+    if(dtype == FLOAT32) {
+        return 4;
+    } else if(dtype == FLOAT16) {
+        return 2;
+    }
+    throw runtime_error("WeightsFile: unknown dtype " + toString(dtype));
+}
+PRIVATE STATIC long WeightsFile::alignUp(long offset) {
+    return (offset + alignment - 1) / alignment * alignment;
+}
+
@@ -0,0 +1,105 @@
+// Copyright Hugh Perkins 2015 hughperkins at gmail
+//
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file, You can
+// obtain one at http://mozilla.org/MPL/2.0/.
+
+#pragma once
+
+#include <string>
+#include <vector>
+#include <stdint.h>
+
+#include "DeepCLDllExport.h"
+
+class NeuralNet;
+class MappedFile;
+
+#define VIRTUAL virtual
+#define STATIC static
+
+// one layer's parameters, in the table of contents of a WeightsFile
+struct WeightsFileEntry {
+    int32_t layerIndex;
+    int32_t dtype;
+    int32_t numElements;
+    int32_t reserved;
+    int64_t offset; // from the start of the file, a multiple of WeightsFile::alignment
+    uint64_t checksum; // of the numElements stored values
+};
+
+/// \brief Version 4 weights files: indexed, aligned, and read through a memory map
+///
+/// layout:
+/// - bytes [0, 1024): the version 3 header: "ClCn", int32 version, epoch,
+///   batch, numRight, float loss, annealedLearningRate, then the training config
+///   string, from byte 28.  Version 4 adds int32 numEntries, and int64
+///   tocOffset, at byte 896
+/// - at tocOffset: numEntries WeightsFileEntrys, one per layer with parameters
+/// - each layer's parameters, as Layer::persistToArray writes them, on a
+///   64-byte boundary, as float32, or optionally float16, to halve the file
+///
+/// The checksum is 64-bit FNV-1a over the stored bytes, 8 bytes at a time,
+/// then the tail.  Layers can be read one at a time; float32 layers are
+/// unpersisted straight from the mapped pages, with no read() or copy
+class DeepCL_EXPORT WeightsFile {
+    public:
+    static const int version = 4;
+    static const int headerSize = 1024;
+    static const int alignment = 64;
+
+    // stored in the files, so only ever append
+    enum Dtype {
+        FLOAT32 = 0,
+        FLOAT16 = 1
+    };
+
+    private:
+    std::string filepath;
+    MappedFile *mappedFile;
+    int epoch;
+    int batch;
+    int numRight;
+    float loss;
+    float annealedLearningRate;
+    #ifdef _WIN32
+    #pragma warning(disable: 4251)
+    #endif
+    std::string trainingConfigString;
+    std::vector<WeightsFileEntry> entries;
+    #ifdef _WIN32
+    #pragma warning(default: 4251)
+    #endif
+
+    // [[[cog
+    // import cog_addheaders
+    // cog_addheaders.addv2()
+    // ]]]
+    // generated, using cog:
+
+    public:
+    STATIC bool isIndexed(std::string filepath);
+    STATIC long getFileSize(NeuralNet *net, int dtype);
+    STATIC void writeToArray(char *target, std::string trainingConfigString, NeuralNet *net, int epoch, int batch, float annealedLearningRate, int numRight, float loss, int dtype);
+    WeightsFile(std::string filepath);
+    ~WeightsFile();
+    int getEpoch();
+    int getBatch();
+    int getNumRight();
+    float getLoss();
+    float getAnnealedLearningRate();
+    std::string getTrainingConfigString();
+    int getNumEntries();
+    WeightsFileEntry const*getEntry(int layerIndex);
+    void verifyLayer(int layerIndex);
+    void readLayer(int layerIndex, float *target);
+    void loadLayer(NeuralNet *net, int layerIndex);
+    void loadNet(NeuralNet *net);
+
+    private:
+    STATIC long getDtypeSize(int dtype);
+    STATIC long alignUp(long offset);
+
+    // [[[end]]]
+};
+
@@ -10,6 +10,7 @@
 #include "util/FileHelper.h"
 #include "net/NeuralNet.h"
 #include "layer/Layer.h"
+#include "weights/WeightsFile.h"
 #include "weights/WeightsPersister.h"
 
 using namespace std;
@@ -75,53 +76,79 @@ STATIC int WeightsPersister::getArrayOffsetForLayer(int version, NeuralNet *net,
     }
     return pos;
 }
-// this will either succeed or fail in general
-// in the worst case, you can find the weights in a file postfixed with '~', if 
-// the machine fails right in between the 'delete' and the 'rename', but you 
-// should ideally never actually lose the weights file (unless the drive itself
-// fails of course...)
+// bytes persistWeights writes for net
+STATIC long WeightsPersister::getPersistArraySize(NeuralNet *net, int dtype) {
+    return WeightsFile::getFileSize(net, dtype);
+}
+// fills persistArray, of getPersistArraySize(net, dtype) bytes, with what persistWeights writes
+STATIC void WeightsPersister::copyNetToPersistArray(char *persistArray, std::string trainingConfigString, NeuralNet *net, int epoch, int batch, float annealedLearningRate, int numRight, float loss, int dtype) {
+    WeightsFile::writeToArray(persistArray, trainingConfigString, net, epoch, batch, annealedLearningRate, numRight, loss, dtype);
+}
 STATIC void WeightsPersister::persistWeights(std::string filepath, std::string trainingConfigString, NeuralNet *net, int epoch, int batch, float annealedLearningRate, int numRight, float loss) { // we should probably rename 'weights' to 'model' now that we are storing normalization data too?
-    int headerLength = 1024;
-    int totalWeightsSize = getTotalNumWeights(latestVersion, net);
-    char *persistArray = new char[headerLength + totalWeightsSize * sizeof(float) ];
-    int *persistArrayInts = reinterpret_cast<int *>(persistArray);
-    float *persistArrayFloats = reinterpret_cast<float *>(persistArray);
-    strcpy_safe(persistArray, "ClCn", 4); // so easy to recognise file type
-    persistArrayInts[1] = latestVersion; // data file version number
-    persistArrayInts[2] = epoch;
-    persistArrayInts[3] = batch;
-    persistArrayInts[4] = numRight;
-    persistArrayFloats[5] = loss;
-    persistArrayFloats[6] = annealedLearningRate;
-    strcpy_safe(persistArray + 7 * 4, trainingConfigString.c_str(), 800);
-    copyNetWeightsToArray(latestVersion, net, reinterpret_cast<float *>(persistArray + headerLength));
-    FileHelper::writeBinary(filepath + "~", reinterpret_cast<char *>(persistArray), 
-        headerLength + totalWeightsSize * sizeof(float));
-    FileHelper::remove(filepath);
-    FileHelper::rename(filepath + "~", filepath);
-    std::cout << "wrote weights to file, filesize " << (( headerLength + totalWeightsSize) *sizeof(float)/1024) << "KB" << std::endl;
+    persistWeights(filepath, trainingConfigString, net, epoch, batch, annealedLearningRate, numRight, loss, WeightsFile::FLOAT32);
+}
+// writes a version 4 file, see WeightsFile, with the weights stored as dtype,
+// WeightsFile::FLOAT32 or FLOAT16
+// this will either succeed or fail in general: the file is written and synced
+// under a temporary name, then renamed over filepath, so a crash leaves either
+// the old weights file, or the new one
+// blocks until the file is on disk; WeightsWriter does the writing on a
+// background thread instead
+STATIC void WeightsPersister::persistWeights(std::string filepath, std::string trainingConfigString, NeuralNet *net, int epoch, int batch, float annealedLearningRate, int numRight, float loss, int dtype) {
+    long persistArraySize = getPersistArraySize(net, dtype);
+    char *persistArray = new char[persistArraySize];
+    try {
+        copyNetToPersistArray(persistArray, trainingConfigString, net, epoch, batch, annealedLearningRate, numRight, loss, dtype);
+        FileHelper::writeBinaryAtomic(filepath, persistArray, persistArraySize);
+    } catch(...) {
+        delete[] persistArray;
+        throw;
+    }
+    std::cout << "wrote weights to file, filesize " << (persistArraySize / 1024) << "KB" << std::endl;
     delete[] persistArray;
 }
 STATIC bool WeightsPersister::loadWeights(std::string filepath, std::string trainingConfigString, NeuralNet *net, int *p_epoch, int *p_batch, float *p_annealedLearningRate, int *p_numRight, float *p_loss) {
     if(FileHelper::exists(filepath) ){
         int headerSize = 1024;
-        long fileSize;
-        char * data = FileHelper::readBinary(filepath, &fileSize);
-
-        if(!checkData(data, headerSize, fileSize) ){
-            delete [] data;
+        long fileSize = FileHelper::getFilesize(filepath);
+        if(fileSize < headerSize) {
+            std::cout << "weights file has invalid size" << std::endl;
             return false;
         }
-        int *dataAsInts = reinterpret_cast<int *>(data);
-        int version = dataAsInts[1];
-        if(version == 1 || version == 3) {
-            return loadWeightsv1or3(data, fileSize, trainingConfigString, net, p_epoch, p_batch, p_annealedLearningRate, p_numRight, p_loss);
-        } else {
-            throw std::runtime_error("weights version " + toString(version) + " not recognized");
+        // just the header for now: version 4 files are mapped, rather than read
+        char *header = FileHelper::readBinaryChunk(filepath, 0, headerSize);
+        if(!checkData(header, headerSize, fileSize) ){
+            delete [] header;
+            return false;
+        }
+        int version = reinterpret_cast<int *>(header)[1];
+        delete [] header;
+        if(version == WeightsFile::version) {
+            return loadWeightsv4(filepath, trainingConfigString, net, p_epoch, p_batch, p_annealedLearningRate, p_numRight, p_loss);
         }
+        char * data = FileHelper::readBinary(filepath, &fileSize);
+        return loadWeightsv1or3(data, fileSize, trainingConfigString, net, p_epoch, p_batch, p_annealedLearningRate, p_numRight, p_loss);
     }
     return false;
 }
+// float32 layers are unpersisted straight from the mapped file, so predict
+// uploads them from the page cache, with no read() into a buffer first
+STATIC bool WeightsPersister::loadWeightsv4(std::string filepath, std::string trainingConfigString, NeuralNet *net, int *p_epoch, int *p_batch, float *p_annealedLearningRate, int *p_numRight, float *p_loss) {
+    WeightsFile file(filepath);
+    if(trainingConfigString != file.getTrainingConfigString()) {
+        std::cout << "training options dont match weights file" << std::endl;
+        std::cout << "in file: [" + file.getTrainingConfigString() + "]" << std::endl;
+        std::cout << "current options: [" + trainingConfigString + "]" << std::endl;
+        return false;
+    }
+    file.loadNet(net);
+    *p_epoch = file.getEpoch();
+    *p_batch = file.getBatch();
+    *p_numRight = file.getNumRight();
+    *p_loss = file.getLoss();
+    *p_annealedLearningRate = file.getAnnealedLearningRate();
+    return true;
+}
 STATIC bool WeightsPersister::loadWeightsv1or3(char *data, long fileSize, std::string trainingConfigString, NeuralNet *net, int *p_epoch, int *p_batch, float *p_annealedLearningRate, int *p_numRight, float *p_loss) {
         int headerSize = 1024;
         data[headerSize - 1] = 0; // null-terminate the string, if not already done
@@ -175,7 +202,7 @@ STATIC bool WeightsPersister::checkData(const char * data, long headerSize, long
     }
 
     const int *dataAsInts = reinterpret_cast<const int *>(data);
-    if(dataAsInts[1] != 1 && dataAsInts[1] != 3) {
+    if(dataAsInts[1] != 1 && dataAsInts[1] != 3 && dataAsInts[1] != WeightsFile::version) {
         std::cout << "weights file version not known" << std::endl;
         return false;
     }
@@ -185,8 +212,13 @@ STATIC bool WeightsPersister::checkData(const char * data, long headerSize, long
 STATIC bool WeightsPersister::loadConfigString(std::string filepath, std::string & configString) {
     if(FileHelper::exists(filepath) ){
         int headerSize = 1024;
-        long fileSize;
-        char * data = FileHelper::readBinary(filepath, &fileSize);
+        long fileSize = FileHelper::getFilesize(filepath);
+        if(fileSize < headerSize) {
+            std::cout << "weights file has invalid size" << std::endl;
+            return false;
+        }
+        // the string is in the header, in every version, so no need to read the weights
+        char * data = FileHelper::readBinaryChunk(filepath, 0, headerSize);
 
         if(!checkData(data, headerSize, fileSize) ) {
             delete [] data;
@@ -198,7 +230,7 @@ STATIC bool WeightsPersister::loadConfigString(std::string filepath, std::string
         // + skip the 'netdef='
         const int *dataAsInts = reinterpret_cast<const int *>(data);
         int version = dataAsInts[1];
-        if(version == 1 || version == 3) {
+        if(version == 1 || version == 3 || version == WeightsFile::version) {
             configString = std::string(data + 7 * 4 + 7);
         } else {
             throw std::runtime_error("unknown versoin " + toString(version));
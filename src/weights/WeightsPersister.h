@@ -25,10 +25,14 @@ class NeuralNet;
 ///
 /// Target usage for this class is quickly snapshotting the weights after each epoch.  
 /// Therefore should be: fast, low IO :-)
+///
+/// Writes version 4 files, see WeightsFile, and reads versions 1, 3 and 4
 /// 
 PUBLICAPI
 class DeepCL_EXPORT WeightsPersister {
 public:
+    // version of the layers' persisted parameters.  Files are written as
+    // WeightsFile::version, 4, which holds each layer's latestVersion parameters
     static const int latestVersion = 3;
 
     // [[[cog
@@ -45,8 +49,12 @@ public:
     STATIC void copyArrayToNetWeights(int version, float const*source, NeuralNet *net);
     STATIC int getArrayOffsetForLayer(NeuralNet *net, int layer);
     STATIC int getArrayOffsetForLayer(int version, NeuralNet *net, int layer);
+    STATIC long getPersistArraySize(NeuralNet *net, int dtype);
+    STATIC void copyNetToPersistArray(char *persistArray, std::string trainingConfigString, NeuralNet *net, int epoch, int batch, float annealedLearningRate, int numRight, float loss, int dtype);
     STATIC void persistWeights(std::string filepath, std::string trainingConfigString, NeuralNet *net, int epoch, int batch, float annealedLearningRate, int numRight, float loss);  // we should probably rename 'weights' to 'model' now that we are storing normalization data too?
+    STATIC void persistWeights(std::string filepath, std::string trainingConfigString, NeuralNet *net, int epoch, int batch, float annealedLearningRate, int numRight, float loss, int dtype);
     STATIC bool loadWeights(std::string filepath, std::string trainingConfigString, NeuralNet *net, int *p_epoch, int *p_batch, float *p_annealedLearningRate, int *p_numRight, float *p_loss);
+    STATIC bool loadWeightsv4(std::string filepath, std::string trainingConfigString, NeuralNet *net, int *p_epoch, int *p_batch, float *p_annealedLearningRate, int *p_numRight, float *p_loss);
     STATIC bool loadWeightsv1or3(char *data, long fileSize, std::string trainingConfigString, NeuralNet *net, int *p_epoch, int *p_batch, float *p_annealedLearningRate, int *p_numRight, float *p_loss);
     STATIC bool checkData(const char * data, long headerSize, long fileSize);
     STATIC bool loadConfigString(std::string filepath, std::string & configString);
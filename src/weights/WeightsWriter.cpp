@@ -0,0 +1,166 @@
+// Copyright Hugh Perkins 2015 hughperkins at gmail
+//
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file, You can
+// obtain one at http://mozilla.org/MPL/2.0/.
+
+#include <iostream>
+#include <sstream>
+#include <stdexcept>
+
+#include "util/Timer.h"
+#include "util/FileHelper.h"
+#include "weights/WeightsFile.h"
+#include "weights/WeightsPersister.h"
+
+#include "weights/WeightsWriter.h"
+
+using namespace std;
+
+#undef STATIC
+#define STATIC
+#undef VIRTUAL
+#define VIRTUAL
+
+PUBLIC WeightsWriter::WeightsWriter() :
+        staging(0),
+        stagingAllocated(0),
+        stagingSize(0),
+        writePending(false),
+        stopping(false),
+        dtype(WeightsFile::FLOAT32),
+        numSnapshots(0),
+        lastStallMilliseconds(0),
+        totalStallMilliseconds(0),
+        totalWriteMilliseconds(0) {
+    writer = thread(&WeightsWriter::writerLoop, this);
+}
+/// finishes any write in flight, so the last snapshot isnt lost
+PUBLIC WeightsWriter::~WeightsWriter() {
+    {
+        unique_lock<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    changed.notify_all();
+    if(writer.joinable()) {
+        writer.join();
+    }
+    if(writeException) {
+        try {
+            rethrow_exception(writeException);
+        } catch(exception &e) {
+            cout << "WeightsWriter: last weights write failed: " << e.what() << endl;
+        }
+    }
+    delete[] staging;
+}
+/// store the weights of later snapshots as WeightsFile::FLOAT32, the default, or FLOAT16
+PUBLIC void WeightsWriter::setDtype(int dtype) {
+    this->dtype = dtype;
+}
+/// \brief copies net's weights, and the training state, to be written to filepath
+///
+/// returns once the copy is done, before the file is written
+PUBLIC void WeightsWriter::snapshot(std::string filepath, std::string trainingConfigString, NeuralNet *net, int epoch, int batch, float annealedLearningRate, int numRight, float loss) {
+    Timer timer;
+    unique_lock<std::mutex> lock(mutex);
+    while(writePending) {
+        changed.wait(lock);
+    }
+    if(writeException) {
+        exception_ptr exception = writeException;
+        writeException = exception_ptr();
+        rethrow_exception(exception);
+    }
+    // the writer doesnt touch staging until writePending
+    lock.unlock();
+    long size = WeightsPersister::getPersistArraySize(net, dtype);
+    if(size > stagingAllocated) {
+        delete[] staging;
+        staging = new char[size];
+        stagingAllocated = size;
+    }
+    WeightsPersister::copyNetToPersistArray(staging, trainingConfigString, net, epoch, batch, annealedLearningRate, numRight, loss, dtype);
+    lock.lock();
+    this->filepath = filepath;
+    stagingSize = size;
+    writePending = true;
+    numSnapshots++;
+    lastStallMilliseconds = timer.lap();
+    totalStallMilliseconds += lastStallMilliseconds;
+    lock.unlock();
+    changed.notify_all();
+}
+/// \brief blocks until the last snapshot is on disk
+///
+/// rethrows the exception, if writing it failed
+PUBLIC void WeightsWriter::flush() {
+    unique_lock<std::mutex> lock(mutex);
+    while(writePending) {
+        changed.wait(lock);
+    }
+    if(writeException) {
+        exception_ptr exception = writeException;
+        writeException = exception_ptr();
+        rethrow_exception(exception);
+    }
+}
+PUBLIC int WeightsWriter::getNumSnapshots() {
+    unique_lock<std::mutex> lock(mutex);
+    return numSnapshots;
+}
+/// how long the last snapshot held up training, in milliseconds
+PUBLIC double WeightsWriter::getLastStallMilliseconds() {
+    unique_lock<std::mutex> lock(mutex);
+    return lastStallMilliseconds;
+}
+PUBLIC double WeightsWriter::getTotalStallMilliseconds() {
+    unique_lock<std::mutex> lock(mutex);
+    return totalStallMilliseconds;
+}
+PUBLIC std::string WeightsWriter::getStatsString() {
+    unique_lock<std::mutex> lock(mutex);
+    ostringstream oss;
+    oss << "weights snapshots: " << numSnapshots << ", training stalled " << totalStallMilliseconds << "ms in total";
+    if(numSnapshots > 0) {
+        oss << ", " << (totalStallMilliseconds / numSnapshots) << "ms per snapshot";
+        oss << ", writes took " << (totalWriteMilliseconds / numSnapshots) << "ms each, in the background";
+    }
+    return oss.str();
+}
+PRIVATE void WeightsWriter::writerLoop() {
+    while(true) {
+        string thisFilepath;
+        long size = 0;
+        {
+            unique_lock<std::mutex> lock(mutex);
+            while(!stopping && !writePending) {
+                changed.wait(lock);
+            }
+            // a pending write still goes out, when stopping
+            if(!writePending) {
+                return;
+            }
+            thisFilepath = filepath;
+            size = stagingSize;
+        }
+        Timer timer;
+        exception_ptr exception;
+        try {
+            FileHelper::writeBinaryAtomic(thisFilepath, staging, size);
+        } catch(...) {
+            exception = current_exception();
+        }
+        double milliseconds = timer.lap();
+        if(!exception) {
+            cout << "wrote weights to file, filesize " << (size / 1024) << "KB, in " << milliseconds << "ms" << endl;
+        }
+        {
+            unique_lock<std::mutex> lock(mutex);
+            writePending = false;
+            writeException = exception;
+            totalWriteMilliseconds += milliseconds;
+        }
+        changed.notify_all();
+    }
+}
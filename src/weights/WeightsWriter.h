@@ -0,0 +1,77 @@
+// Copyright Hugh Perkins 2015 hughperkins at gmail
+//
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file, You can
+// obtain one at http://mozilla.org/MPL/2.0/.
+
+#pragma once
+
+#include <string>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <exception>
+
+#include "DeepCLDllExport.h"
+
+class NeuralNet;
+
+#define VIRTUAL virtual
+#define STATIC static
+
+/// \brief Writes weights files on a background thread, so training doesnt wait for the disk
+///
+/// snapshot copies the net's weights, with the same header as
+/// WeightsPersister::persistWeights, into a staging buffer that is reused
+/// between snapshots, and returns.  The writer thread then writes the buffer
+/// under a temporary name, syncs it, and renames it over the weights file.
+/// At most one write is in flight: a snapshot while the previous one is still
+/// being written first waits for it, and that wait counts as stall, along
+/// with the copy.  A failed write is rethrown by the next snapshot, or flush
+class DeepCL_EXPORT WeightsWriter {
+    private:
+    #ifdef _WIN32
+    #pragma warning(disable: 4251)
+    #endif
+    std::thread writer;
+    std::mutex mutex;
+    std::condition_variable changed;
+    std::exception_ptr writeException;
+    std::string filepath;
+    #ifdef _WIN32
+    #pragma warning(default: 4251)
+    #endif
+    char *staging;
+    long stagingAllocated;
+    long stagingSize;
+    bool writePending; // staging is handed to the writer, and not written yet
+    bool stopping;
+    int dtype; // WeightsFile::FLOAT32 or FLOAT16
+    int numSnapshots;
+    double lastStallMilliseconds;
+    double totalStallMilliseconds;
+    double totalWriteMilliseconds;
+
+    // [[[cog
+    // import cog_addheaders
+    // cog_addheaders.addv2()
+    // ]]]
+    // generated, using cog:
+
+    public:
+    WeightsWriter();
+    ~WeightsWriter();
+    void setDtype(int dtype);
+    void snapshot(std::string filepath, std::string trainingConfigString, NeuralNet *net, int epoch, int batch, float annealedLearningRate, int numRight, float loss);
+    void flush();
+    int getNumSnapshots();
+    double getLastStallMilliseconds();
+    double getTotalStallMilliseconds();
+    std::string getStatsString();
+
+    private:
+    void writerLoop();
+
+    // [[[end]]]
+};
+
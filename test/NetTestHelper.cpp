@@ -4,8 +4,16 @@
 // v. 2.0. If a copy of the MPL was not distributed with this file, You can 
 // obtain one at http://mozilla.org/MPL/2.0/.
 
+#include <stdexcept>
+#include <vector>
+
+#include "EasyCL.h"
 #include "net/NeuralNet.h"
 #include "layer/Layer.h"
+#include "layer/LayerMakers.h"
+#include "netdef/NetdefToNet.h"
+#include "weights/OriginalInitializer.h"
+#include "util/stringhelper.h"
 #include "NetTestHelper.h"
 
 #undef STATIC
@@ -60,4 +68,22 @@ PUBLIC STATIC void NetTestHelper::printBiasAsCode(NeuralNet *net) {
         printBiasAsCode( layer );
     }
 }
-
+/// \brief adds the layers of netdef, then a softmax, eg "4c3z-relu-mp2-5n"
+///
+/// as NetdefToNet, but the activations are left unfused, for the tests to fuse, or not
+PUBLIC STATIC void NetTestHelper::addLayers(NeuralNet *net, std::string netdef) {
+    OriginalInitializer originalInitializer;
+    std::vector<std::string> layerDefs = split(netdef, "-");
+    for(int i = 0; i < (int)layerDefs.size(); i++) {
+        if(!NetdefToNet::parseSubstring(&originalInitializer, net, layerDefs[i], i == (int)layerDefs.size() - 1)) {
+            throw std::runtime_error("NetTestHelper::addLayers: cant parse " + layerDefs[i] + " in " + netdef);
+        }
+    }
+    net->addLayer(SoftMaxMaker::instance());
+}
+/// \brief a small net for the tests, see addLayers
+PUBLIC STATIC NeuralNet *NetTestHelper::makeNet(EasyCL *cl, int numPlanes, int imageSize, std::string netdef) {
+    NeuralNet *net = new NeuralNet(cl, numPlanes, imageSize);
+    addLayers(net, netdef);
+    return net;
+}
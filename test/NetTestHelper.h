@@ -7,6 +7,9 @@
 
 #pragma once
 
+#include <string>
+
+class EasyCL;
 class NeuralNet;
 
 class NetTestHelper {
@@ -21,6 +24,8 @@ class NetTestHelper {
     STATIC void printBiasAsCode( Layer *layer );
     STATIC void printWeightsAsCode(NeuralNet *net);
     STATIC void printBiasAsCode(NeuralNet *net);
+    STATIC void addLayers(NeuralNet *net, std::string netdef);
+    STATIC NeuralNet *makeNet(EasyCL *cl, int numPlanes, int imageSize, std::string netdef);
 
     // [[[end]]]
 };
@@ -0,0 +1,136 @@
+// Copyright Hugh Perkins 2015 hughperkins at gmail
+//
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file, You can
+// obtain one at http://mozilla.org/MPL/2.0/.
+
+// convert any dataset that deepcl_train can read (mnist, norb, kgs, jpeg
+// manifest, ...) into deepcl's packed format, which is fixed-size records,
+// mmapped at load time, so on-demand training reads at page-cache speed
+// Optionally normalizes too, in which case the records are stored as float32
+
+#include <iostream>
+#include <fstream>
+#include <stdexcept>
+#include <algorithm>
+#include <cmath>
+
+#include "loaders/GenericLoaderv2.h"
+#include "loaders/PackedLoader.h"
+#include "util/FileHelper.h"
+#include "util/stringhelper.h"
+
+using namespace std;
+
+#define CHUNK_SIZE 1024
+
+int main( int argc, char *argv[] ) {
+    if( argc < 3 || argc > 5 ) {
+        cout << "Usage: " << argv[0] << " [images file (input)] [packed file (output, overwritten)] [normalization: none|stddev|maxmin, default none] [num examples, default all]" << endl;
+        return 1;
+    }
+    string inFile = argv[1];
+    string outFile = argv[2];
+    string normalization = argc >= 4 ? argv[3] : "none";
+    if( normalization != "none" && normalization != "stddev" && normalization != "maxmin" ) {
+        cout << "Error: unknown normalization " << normalization << endl;
+        return 1;
+    }
+
+    GenericLoaderv2 loader( inFile );
+    int N = loader.getN();
+    if( argc >= 5 && atoi( argv[4] ) > 0 ) {
+        N = min( N, atoi( argv[4] ) );
+    }
+    int planes = loader.getPlanes();
+    int size = loader.getImageSize();
+    int cubeSize = planes * size * size;
+    float *images = new float[ (long)CHUNK_SIZE * cubeSize ];
+    int *labels = new int[ N ];
+
+    bool hasLabels = true;
+    try {
+        loader.load( images, labels, 0, min( N, 1 ) );
+    } catch( runtime_error &e ) {
+        cout << "no labels found, packing images only" << endl;
+        hasLabels = false;
+    }
+
+    // same formulae as deepcl_train, so training on the packed file gives
+    // the same network as training on the original
+    float translate = 0.0f;
+    float scale = 1.0f;
+    if( normalization != "none" ) {
+        double sum = 0;
+        double sumSquares = 0;
+        float thisMin = 0;
+        float thisMax = 0;
+        for( int start = 0; start < N; start += CHUNK_SIZE ) {
+            int count = min( CHUNK_SIZE, N - start );
+            loader.load( images, 0, start, count );
+            for( long i = 0; i < (long)count * cubeSize; i++ ) {
+                sum += images[i];
+                sumSquares += (double)images[i] * images[i];
+                thisMin = min( thisMin, images[i] );
+                thisMax = max( thisMax, images[i] );
+            }
+        }
+        double count = (double)N * cubeSize;
+        if( normalization == "stddev" ) {
+            double mean = sum / count;
+            double stdDev = sqrt( max( 0.0, sumSquares / count - mean * mean ) );
+            translate = (float)-mean;
+            scale = (float)( 1.0 / stdDev / 2.0 );
+        } else {
+            translate = - ( thisMax + thisMin ) / 2;
+            scale = 2.0f / ( thisMax - thisMin );
+        }
+        cout << "normalization " << normalization << " translate " << translate << " scale " << scale << endl;
+    }
+    bool isFloat = normalization != "none";
+
+    // write to a temp file, then rename, so a half-written file never
+    // looks like a valid one
+    string tempFile = outFile + ".partial";
+    ofstream out( FileHelper::localizePath( tempFile ).c_str(), ios::out | ios::binary | ios::trunc );
+    if( !out ) {
+        cout << "Error: cant open " << tempFile << " for writing" << endl;
+        return 1;
+    }
+    string header = PackedLoader::makeHeader( N, planes, size, isFloat, hasLabels, translate, scale );
+    out.write( header.c_str(), header.size() );
+    unsigned char *ucImages = new unsigned char[ (long)CHUNK_SIZE * cubeSize ];
+    for( int start = 0; start < N; start += CHUNK_SIZE ) {
+        int count = min( CHUNK_SIZE, N - start );
+        long linearSize = (long)count * cubeSize;
+        if( isFloat ) {
+            loader.load( images, hasLabels ? labels + start : 0, start, count );
+            for( long i = 0; i < linearSize; i++ ) {
+                images[i] = ( images[i] + translate ) * scale;
+            }
+            out.write( reinterpret_cast< char * >( images ), linearSize * 4l );
+        } else {
+            loader.load( ucImages, hasLabels ? labels + start : 0, start, count );
+            out.write( reinterpret_cast< char * >( ucImages ), linearSize );
+        }
+        cout << "packed " << ( start + count ) << "/" << N << "\r" << flush;
+    }
+    cout << endl;
+    if( hasLabels ) {
+        out.write( reinterpret_cast< char * >( labels ), N * 4l );
+    }
+    out.close();
+    if( !out ) {
+        cout << "Error: failed writing " << tempFile << endl;
+        return 1;
+    }
+    FileHelper::remove( outFile );
+    FileHelper::rename( tempFile, outFile );
+    cout << "wrote " << outFile << endl;
+
+    delete[] ucImages;
+    delete[] labels;
+    delete[] images;
+    return 0;
+}
+
@@ -0,0 +1,117 @@
+// Copyright Hugh Perkins 2015 hughperkins at gmail
+//
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file, You can
+// obtain one at http://mozilla.org/MPL/2.0/.
+
+#include <iostream>
+#include <vector>
+#include <stdexcept>
+
+#include "EasyCL.h"
+#include "net/NeuralNet.h"
+#include "net/ActivationPool.h"
+#include "layer/Layer.h"
+#include "layer/LayerMakers.h"
+#include "weights/WeightsPersister.h"
+
+#include "gtest/gtest.h"
+#include "test/gtest_supp.h"
+#include "test/NetTestHelper.h"
+#include "test/WeightRandomizer.h"
+
+using namespace std;
+
+namespace testActivationPool {
+
+TEST(testActivationPool, chainPingPongs) {
+    // -1: not shared
+    int lastReadersArray[] = { -1, 2, 3, 4, 5, -1, -1 };
+    vector<int> lastReaders(lastReadersArray, lastReadersArray + 7);
+    vector<int> slots;
+    EXPECT_EQ(2, ActivationPool::planSlots(lastReaders, &slots));
+    int expectedArray[] = { -1, 0, 1, 0, 1, -1, -1 };
+    for(int i = 0; i < 7; i++) {
+        EXPECT_EQ(expectedArray[i], slots[i]);
+    }
+}
+
+TEST(testActivationPool, longerLifetimes) {
+    // layer 1 is read by layer 4, so layers 2 and 3 cant use its slot
+    int lastReadersArray[] = { 2, 4, 3, 5, 5 };
+    vector<int> lastReaders(lastReadersArray, lastReadersArray + 5);
+    vector<int> slots;
+    EXPECT_EQ(3, ActivationPool::planSlots(lastReaders, &slots));
+    int expectedArray[] = { 0, 1, 2, 0, 2 };
+    for(int i = 0; i < 5; i++) {
+        EXPECT_EQ(expectedArray[i], slots[i]);
+    }
+}
+
+TEST(testActivationPool, readBeforeWritten) {
+    int lastReadersArray[] = { 1, 1 };
+    vector<int> lastReaders(lastReadersArray, lastReadersArray + 2);
+    vector<int> slots;
+    EXPECT_THROW(ActivationPool::planSlots(lastReaders, &slots), runtime_error);
+}
+
+NeuralNet *makeNet(EasyCL *cl) {
+    return NetTestHelper::makeNet(cl, 2, 8, "4c3z-relu-mp2-3c3z-tanh-drop-5n");
+}
+
+// planned and unplanned nets should give the same output, including after
+// the batch size grows, and the shared buffers are reallocated
+TEST(testActivationPool, sameOutputAsUnplanned) {
+    EasyCL *cl = DeepCLGtestGlobals_createEasyCL();
+    NeuralNet *net = makeNet(cl);
+    NeuralNet *planned = makeNet(cl);
+    int numWeights = WeightsPersister::getTotalNumWeights(net);
+    float *weights = new float[numWeights];
+    WeightsPersister::copyNetWeightsToArray(net, weights);
+    WeightsPersister::copyArrayToNetWeights(weights, planned);
+    delete[] weights;
+
+    net->setTraining(false);
+    planned->planInference(-1);
+    EXPECT_TRUE(planned->isInferencePlanned());
+    cout << planned->getInferencePlanString() << endl;
+
+    const int batchSizes[] = { 3, 7, 2 };
+    float *input = new float[7 * net->getInputCubeSize()];
+    for(int it = 0; it < 3; it++) {
+        const int batchSize = batchSizes[it];
+        WeightRandomizer::randomize(it, input, batchSize * net->getInputCubeSize(), -1.0f, 1.0f);
+        net->setBatchSize(batchSize);
+        planned->setBatchSize(batchSize);
+        net->forward(input);
+        planned->forward(input);
+        float const*output = net->getOutput();
+        float const*plannedOutput = planned->getOutput();
+        for(int i = 0; i < batchSize * net->getOutputCubeSize(); i++) {
+            EXPECT_FLOAT_NEAR(output[i], plannedOutput[i]);
+        }
+    }
+    // only inference
+    EXPECT_THROW(planned->setTraining(true), runtime_error);
+
+    // and back to owning its buffers
+    planned->clearInferencePlan();
+    EXPECT_FALSE(planned->isInferencePlanned());
+    for(int i = 0; i < planned->getNumLayers(); i++) {
+        EXPECT_FALSE(planned->getLayer(i)->sharedOutput);
+    }
+    planned->setBatchSize(4);
+    net->setBatchSize(4);
+    net->forward(input);
+    planned->forward(input);
+    for(int i = 0; i < 4 * net->getOutputCubeSize(); i++) {
+        EXPECT_FLOAT_NEAR(net->getOutput()[i], planned->getOutput()[i]);
+    }
+
+    delete[] input;
+    delete planned;
+    delete net;
+    delete cl;
+}
+
+}
@@ -0,0 +1,108 @@
+// Copyright Hugh Perkins 2015 hughperkins at gmail
+//
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file, You can
+// obtain one at http://mozilla.org/MPL/2.0/.
+
+#include <iostream>
+#include <stdexcept>
+
+#include "batch/BatchPrefetcher.h"
+
+#include "gtest/gtest.h"
+
+using namespace std;
+
+// example n has label n, and every byte of its data is n too
+static void fakeLoad(unsigned char *data, int *labels, int start, int count) {
+    for(int n = 0; n < count; n++) {
+        labels[n] = start + n;
+        for(int i = 0; i < 3; i++) {
+            data[n * 3 + i] = (unsigned char)(start + n);
+        }
+    }
+}
+
+static void checkFileBatch(BatchPrefetcher *prefetcher, int fileBatch) {
+    unsigned char *data = 0;
+    int *labels = 0;
+    prefetcher->acquire(fileBatch, &data, &labels);
+    int count = prefetcher->getFileBatchN(fileBatch);
+    for(int n = 0; n < count; n++) {
+        EXPECT_EQ(fileBatch * 10 + n, labels[n]);
+        EXPECT_EQ(fileBatch * 10 + n, (int)data[n * 3 + 2]);
+    }
+}
+
+TEST(testBatchPrefetcher, inorder) {
+    for(int queueDepth = 1; queueDepth <= 3; queueDepth++) {
+        BatchPrefetcher prefetcher(fakeLoad, 45, 10, 3, queueDepth);
+        EXPECT_EQ(5, prefetcher.getFileBatchN(4));
+        for(int epoch = 0; epoch < 3; epoch++) {
+            for(int fileBatch = 0; fileBatch < 5; fileBatch++) {
+                checkFileBatch(&prefetcher, fileBatch);
+            }
+        }
+    }
+}
+
+TEST(testBatchPrefetcher, jump) {
+    BatchPrefetcher prefetcher(fakeLoad, 45, 10, 3, 3);
+    checkFileBatch(&prefetcher, 0);
+    checkFileBatch(&prefetcher, 3);
+    checkFileBatch(&prefetcher, 4);
+    checkFileBatch(&prefetcher, 0);
+    checkFileBatch(&prefetcher, 2);
+    checkFileBatch(&prefetcher, 1);
+}
+
+static void failingLoad(unsigned char *data, int *labels, int start, int count) {
+    if(start == 20) {
+        throw runtime_error("cant read batch 2");
+    }
+    fakeLoad(data, labels, start, count);
+}
+
+TEST(testBatchPrefetcher, exception) {
+    BatchPrefetcher prefetcher(failingLoad, 45, 10, 3, 2);
+    checkFileBatch(&prefetcher, 0);
+    checkFileBatch(&prefetcher, 1);
+    unsigned char *data = 0;
+    int *labels = 0;
+    EXPECT_THROW(prefetcher.acquire(2, &data, &labels), runtime_error);
+    checkFileBatch(&prefetcher, 3);
+}
+
+// label is epoch * 1000 + example
+static void epochLoad(unsigned char *data, int *labels, int epoch, int start, int count) {
+    fakeLoad(data, labels, start, count);
+    for(int n = 0; n < count; n++) {
+        labels[n] += epoch * 1000;
+    }
+}
+
+static void checkEpochFileBatch(BatchPrefetcher *prefetcher, int epoch, int fileBatch) {
+    unsigned char *data = 0;
+    int *labels = 0;
+    prefetcher->acquire(epoch, fileBatch, &data, &labels);
+    int count = prefetcher->getFileBatchN(fileBatch);
+    for(int n = 0; n < count; n++) {
+        EXPECT_EQ(epoch * 1000 + fileBatch * 10 + n, labels[n]);
+    }
+}
+
+// prefetching runs on into the next epoch, and resuming part way through a later one works
+TEST(testBatchPrefetcher, epochs) {
+    for(int queueDepth = 1; queueDepth <= 3; queueDepth++) {
+        BatchPrefetcher prefetcher(PrefetchEpochLoadFunction(epochLoad), 45, 10, 3, queueDepth);
+        for(int epoch = 0; epoch < 3; epoch++) {
+            for(int fileBatch = 0; fileBatch < 5; fileBatch++) {
+                checkEpochFileBatch(&prefetcher, epoch, fileBatch);
+            }
+        }
+        checkEpochFileBatch(&prefetcher, 7, 3);
+        checkEpochFileBatch(&prefetcher, 7, 4);
+        checkEpochFileBatch(&prefetcher, 8, 0);
+        checkEpochFileBatch(&prefetcher, 2, 1);
+    }
+}
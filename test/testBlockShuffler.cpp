@@ -0,0 +1,118 @@
+// Copyright Hugh Perkins 2015 hughperkins at gmail
+//
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file, You can
+// obtain one at http://mozilla.org/MPL/2.0/.
+
+#include <iostream>
+#include <vector>
+#include <stdexcept>
+
+#include "batch/BlockShuffler.h"
+
+#include "gtest/gtest.h"
+
+using namespace std;
+
+namespace testBlockShuffler {
+
+static vector<int> getEpochOrder(BlockShuffler *shuffler, int epoch) {
+    vector<int> order;
+    for(int pool = 0; pool < shuffler->getNumPools(); pool++) {
+        vector<int> examples;
+        shuffler->getPoolExamples(epoch, pool, &examples);
+        EXPECT_EQ(shuffler->getPoolN(epoch, pool), (int)examples.size());
+        EXPECT_LE((int)examples.size(), shuffler->getPoolCapacity());
+        order.insert(order.end(), examples.begin(), examples.end());
+    }
+    return order;
+}
+
+// every example, once per epoch, including the short last block
+TEST(testBlockShuffler, permutation) {
+    BlockShuffler shuffler(1003, 10, 4, 123);
+    EXPECT_EQ(101, shuffler.getNumBlocks());
+    EXPECT_EQ(26, shuffler.getNumPools());
+    EXPECT_EQ(3, shuffler.getBlockN(100));
+    for(int epoch = 0; epoch < 3; epoch++) {
+        vector<int> order = getEpochOrder(&shuffler, epoch);
+        ASSERT_EQ(1003, (int)order.size());
+        vector<int> seen(1003, 0);
+        for(int i = 0; i < 1003; i++) {
+            seen[order[i]]++;
+        }
+        for(int n = 0; n < 1003; n++) {
+            EXPECT_EQ(1, seen[n]);
+        }
+    }
+}
+
+TEST(testBlockShuffler, seedsAndEpochs) {
+    BlockShuffler shuffler(1000, 10, 4, 123);
+    BlockShuffler same(1000, 10, 4, 123);
+    BlockShuffler other(1000, 10, 4, 124);
+    vector<int> order = getEpochOrder(&shuffler, 2);
+    EXPECT_EQ(order, getEpochOrder(&same, 2));
+    EXPECT_NE(order, getEpochOrder(&shuffler, 3));
+    EXPECT_NE(order, getEpochOrder(&other, 2));
+    int inPlace = 0;
+    for(int i = 0; i < 1000; i++) {
+        if(order[i] == i) {
+            inPlace++;
+        }
+    }
+    EXPECT_LT(inPlace, 20);
+}
+
+// a pool is read as at most blocksPerPool runs, going forwards through the file
+TEST(testBlockShuffler, poolBlocks) {
+    BlockShuffler shuffler(1000, 10, 4, 7);
+    for(int pool = 0; pool < shuffler.getNumPools(); pool++) {
+        vector<int> blocks;
+        shuffler.getPoolBlocks(1, pool, &blocks);
+        EXPECT_EQ(4, (int)blocks.size());
+        for(int i = 1; i < (int)blocks.size(); i++) {
+            EXPECT_LT(blocks[i - 1], blocks[i]);
+        }
+    }
+}
+
+// shufflePool moves the loaded examples to where getPoolExamples says
+TEST(testBlockShuffler, shufflePool) {
+    const int cubeSize = 5;
+    BlockShuffler shuffler(95, 8, 3, 99);
+    for(int pool = 0; pool < shuffler.getNumPools(); pool++) {
+        vector<int> blocks;
+        shuffler.getPoolBlocks(4, pool, &blocks);
+        vector<unsigned char> data(shuffler.getPoolCapacity() * cubeSize);
+        vector<int> labels(shuffler.getPoolCapacity());
+        int poolN = 0;
+        for(int i = 0; i < (int)blocks.size(); i++) {
+            for(int n = 0; n < shuffler.getBlockN(blocks[i]); n++) {
+                int example = shuffler.getBlockStart(blocks[i]) + n;
+                labels[poolN] = example;
+                for(int j = 0; j < cubeSize; j++) {
+                    data[poolN * cubeSize + j] = (unsigned char)example;
+                }
+                poolN++;
+            }
+        }
+        shuffler.shufflePool(4, pool, &data[0], &labels[0], poolN, cubeSize);
+        vector<int> examples;
+        shuffler.getPoolExamples(4, pool, &examples);
+        ASSERT_EQ(poolN, (int)examples.size());
+        for(int i = 0; i < poolN; i++) {
+            EXPECT_EQ(examples[i], labels[i]);
+            EXPECT_EQ((unsigned char)examples[i], data[i * cubeSize]);
+            EXPECT_EQ((unsigned char)examples[i], data[i * cubeSize + cubeSize - 1]);
+        }
+    }
+}
+
+TEST(testBlockShuffler, badSizes) {
+    EXPECT_THROW(BlockShuffler(100, 0, 4, 1), runtime_error);
+    EXPECT_THROW(BlockShuffler(100, 10, 0, 1), runtime_error);
+}
+
+}
+
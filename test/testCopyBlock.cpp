@@ -12,6 +12,7 @@
 #include <algorithm>
 
 #include "EasyCL.h"
+#include "util/KernelCache.h"
 
 using namespace std;
 
@@ -236,7 +237,7 @@ CLKernel *makeTestPosKernel( EasyCL *cl ) {
     "}\n"
     "\n"
     "";
-    kernel = cl->buildKernelFromString(kernelSource, "testPos", "", "test/testCopyBlock.cl");
+    kernel = KernelCache::buildKernelFromString(cl, kernelSource, "testPos", "", "test/testCopyBlock.cl");
     // [[[end]]]
 
     return kernel;
@@ -361,7 +362,7 @@ CLKernel *makeBasicKernel( EasyCL *cl ) {
     "}\n"
     "\n"
     "";
-    kernel = cl->buildKernelFromString(kernelSource, "run", "", "test/testCopyBlock.cl");
+    kernel = KernelCache::buildKernelFromString(cl, kernelSource, "run", "", "test/testCopyBlock.cl");
     // [[[end]]]
 
     return kernel;
@@ -12,6 +12,7 @@
 #include <algorithm>
 
 #include "EasyCL.h"
+#include "util/KernelCache.h"
 
 using namespace std;
 
@@ -163,7 +164,7 @@ CLKernel *makeKernel( EasyCL *cl ) {
     "}\n"
     "\n"
     "";
-    kernel = cl->buildKernelFromString(kernelSource, "run", "", "test/testCopyLocal.cl");
+    kernel = KernelCache::buildKernelFromString(cl, kernelSource, "run", "", "test/testCopyLocal.cl");
     // [[[end]]]
 
     return kernel;
@@ -0,0 +1,162 @@
+// Copyright Hugh Perkins 2015 hughperkins at gmail
+//
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file, You can
+// obtain one at http://mozilla.org/MPL/2.0/.
+
+#include <iostream>
+#include <vector>
+
+#include "EasyCL.h"
+#include "net/NeuralNet.h"
+#include "layer/LayerMakers.h"
+#include "trainers/SGD.h"
+#include "trainers/TrainingContext.h"
+#include "trainers/DataParallelTrainer.h"
+#include "batch/NetLearner.h"
+#include "weights/WeightsPersister.h"
+
+#include "gtest/gtest.h"
+#include "test/gtest_supp.h"
+#include "test/NetTestHelper.h"
+#include "test/WeightRandomizer.h"
+
+using namespace std;
+
+namespace testDataParallelTrainer {
+
+NeuralNet *makeNet(EasyCL *cl) {
+    return NetTestHelper::makeNet(cl, 2, 5, "3c3z-relu-4n");
+}
+
+void expectSameWeights(NeuralNet *one, NeuralNet *two) {
+    int numWeights = WeightsPersister::getTotalNumWeights(one);
+    ASSERT_EQ(numWeights, WeightsPersister::getTotalNumWeights(two));
+    float *oneWeights = new float[numWeights];
+    float *twoWeights = new float[numWeights];
+    WeightsPersister::copyNetWeightsToArray(one, oneWeights);
+    WeightsPersister::copyNetWeightsToArray(two, twoWeights);
+    for(int i = 0; i < numWeights; i++) {
+        EXPECT_NEAR(oneWeights[i], twoWeights[i], 0.00001f);
+    }
+    delete[] oneWeights;
+    delete[] twoWeights;
+}
+
+// two replicas, each with their own context, should learn the same as one net
+// training on the whole batch, including when the batch doesnt split evenly, or
+// is smaller than the number of replicas
+TEST(testDataParallelTrainer, same_as_one_net) {
+    EasyCL *cl = DeepCLGtestGlobals_createEasyCL();
+    EasyCL *cl0 = DeepCLGtestGlobals_createEasyCL();
+    EasyCL *cl1 = DeepCLGtestGlobals_createEasyCL();
+    NeuralNet *net = makeNet(cl);
+    vector<NeuralNet *> replicas;
+    replicas.push_back(makeNet(cl0));
+    replicas.push_back(makeNet(cl1));
+    int numWeights = WeightsPersister::getTotalNumWeights(net);
+    float *weights = new float[numWeights];
+    WeightsPersister::copyNetWeightsToArray(net, weights);
+    WeightsPersister::copyArrayToNetWeights(weights, replicas[0]);
+    delete[] weights;
+
+    SGD *sgd = SGD::instance(cl, 0.1f, 0.5f);
+    vector<Trainer *> trainers;
+    trainers.push_back(SGD::instance(cl0, 0.1f, 0.5f));
+    trainers.push_back(SGD::instance(cl1, 0.1f, 0.5f));
+    DataParallelTrainer dataParallel(replicas, trainers);
+    expectSameWeights(replicas[0], replicas[1]);
+
+    const int maxBatchSize = 6;
+    float *input = new float[maxBatchSize * net->getInputCubeSize()];
+    int *labels = new int[maxBatchSize];
+    const int batchSizes[] = { 6, 5, 1, 6 };
+    for(int batch = 0; batch < 4; batch++) {
+        const int batchSize = batchSizes[batch];
+        WeightRandomizer::randomize(batch, input, batchSize * net->getInputCubeSize(), -1.0f, 1.0f);
+        for(int n = 0; n < batchSize; n++) {
+            labels[n] = (n * 3 + batch) % 4;
+        }
+        TrainingContext context(0, batch);
+        net->setBatchSize(batchSize);
+        BatchResult result = sgd->trainFromLabels(net, &context, input, labels);
+        replicas[0]->setBatchSize(batchSize);
+        BatchResult replicasResult = dataParallel.trainFromLabels(replicas[0], &context, input, labels);
+        EXPECT_FLOAT_NEAR(result.loss, replicasResult.loss);
+        EXPECT_EQ(result.numRight, replicasResult.numRight);
+        expectSameWeights(net, replicas[0]);
+        expectSameWeights(net, replicas[1]);
+    }
+    EXPECT_NE(string::npos, dataParallel.getStatsString().find("replicas=2"));
+
+    delete[] labels;
+    delete[] input;
+    delete trainers[0];
+    delete trainers[1];
+    delete sgd;
+    delete replicas[0];
+    delete replicas[1];
+    delete net;
+    delete cl1;
+    delete cl0;
+    delete cl;
+}
+
+// the epoch loss and numRight deepcl_train reports come from the Batcher.  Replica 0
+// only runs its own shard, so they have to come from the trainer's result, not from
+// asking replica 0's net about the whole batch
+TEST(testDataParallelTrainer, epoch_results_same_as_one_net) {
+    EasyCL *cl = DeepCLGtestGlobals_createEasyCL();
+    EasyCL *cl0 = DeepCLGtestGlobals_createEasyCL();
+    EasyCL *cl1 = DeepCLGtestGlobals_createEasyCL();
+    NeuralNet *net = makeNet(cl);
+    vector<NeuralNet *> replicas;
+    replicas.push_back(makeNet(cl0));
+    replicas.push_back(makeNet(cl1));
+    int numWeights = WeightsPersister::getTotalNumWeights(net);
+    float *weights = new float[numWeights];
+    WeightsPersister::copyNetWeightsToArray(net, weights);
+    WeightsPersister::copyArrayToNetWeights(weights, replicas[0]);
+    delete[] weights;
+
+    SGD *sgd = SGD::instance(cl, 0.1f, 0.5f);
+    vector<Trainer *> trainers;
+    trainers.push_back(SGD::instance(cl0, 0.1f, 0.5f));
+    trainers.push_back(SGD::instance(cl1, 0.1f, 0.5f));
+    DataParallelTrainer dataParallel(replicas, trainers);
+
+    // 10 examples in batches of 4, so the last batch is smaller, and splits unevenly
+    const int N = 10;
+    float *input = new float[N * net->getInputCubeSize()];
+    int *labels = new int[N];
+    WeightRandomizer::randomize(0, input, N * net->getInputCubeSize(), -1.0f, 1.0f);
+    for(int n = 0; n < N; n++) {
+        labels[n] = (n * 3) % 4;
+    }
+    NetLearner learner(sgd, net, N, input, labels, N, input, labels, 4);
+    NetLearner replicasLearner(&dataParallel, replicas[0], N, input, labels, N, input, labels, 4);
+    learner.setSchedule(2);
+    replicasLearner.setSchedule(2);
+    for(int epoch = 0; epoch < 2; epoch++) {
+        learner.tickEpoch();
+        replicasLearner.tickEpoch();
+        EXPECT_FLOAT_NEAR(learner.getBatchLoss(), replicasLearner.getBatchLoss());
+        EXPECT_EQ(learner.getBatchNumRight(), replicasLearner.getBatchNumRight());
+    }
+    expectSameWeights(net, replicas[0]);
+
+    delete[] labels;
+    delete[] input;
+    delete trainers[0];
+    delete trainers[1];
+    delete sgd;
+    delete replicas[0];
+    delete replicas[1];
+    delete net;
+    delete cl1;
+    delete cl0;
+    delete cl;
+}
+
+}
+
@@ -0,0 +1,239 @@
+// Copyright Hugh Perkins 2015 hughperkins at gmail
+//
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file, You can
+// obtain one at http://mozilla.org/MPL/2.0/.
+
+#include <iostream>
+#include <vector>
+#include <stdexcept>
+
+#include "EasyCL.h"
+#include "net/NeuralNet.h"
+#include "layer/Layer.h"
+#include "layer/LayerMakers.h"
+#include "conv/ConvolutionalLayer.h"
+#include "activate/ActivationLayer.h"
+#include "activate/ActivationFunction.h"
+#include "conv/LayerDimensions.h"
+#include "conv/Backward.h"
+#include "conv/BackpropWeights.h"
+#include "weights/WeightsPersister.h"
+
+#include "gtest/gtest.h"
+#include "test/gtest_supp.h"
+#include "test/NetTestHelper.h"
+#include "test/WeightRandomizer.h"
+
+using namespace std;
+
+namespace testFusedActivation {
+
+NeuralNet *makeNet(EasyCL *cl) {
+    return NetTestHelper::makeNet(cl, 2, 9, "4c3z-relu-mp2-3c3z-tanh-6n{nobias}-sigmoid-5n");
+}
+
+void expectSameGrads(CLWrapper *wrapper, CLWrapper *fusedWrapper) {
+    wrapper->copyToHost();
+    fusedWrapper->copyToHost();
+    float const*grads = (float const*)wrapper->getHostArray();
+    float const*fusedGrads = (float const*)fusedWrapper->getHostArray();
+    for(int i = 0; i < wrapper->size(); i++) {
+        EXPECT_FLOAT_NEAR(grads[i], fusedGrads[i]);
+    }
+}
+
+// fused and unfused nets should give the same outputs, at every layer, and
+// the same gradients
+TEST(testFusedActivation, sameAsUnfused) {
+    EasyCL *cl = DeepCLGtestGlobals_createEasyCL();
+    NeuralNet *net = makeNet(cl);
+    NeuralNet *fused = makeNet(cl);
+    int numWeights = WeightsPersister::getTotalNumWeights(net);
+    float *weights = new float[numWeights];
+    WeightsPersister::copyNetWeightsToArray(net, weights);
+    WeightsPersister::copyArrayToNetWeights(weights, fused);
+    delete[] weights;
+
+    EXPECT_EQ(3, fused->fuseActivations());
+    EXPECT_EQ(0, fused->fuseActivations());
+    EXPECT_TRUE(dynamic_cast<ActivationLayer *>(fused->getLayer(2))->fused);
+    EXPECT_TRUE(dynamic_cast<ConvolutionalLayer *>(fused->getLayer(4))->dim.activation != 0);
+    EXPECT_FALSE(dynamic_cast<ActivationLayer *>(net->getLayer(2))->fused);
+    cout << fused->asString() << endl;
+
+    const int batchSize = 5;
+    float *input = new float[batchSize * net->getInputCubeSize()];
+    WeightRandomizer::randomize(0, input, batchSize * net->getInputCubeSize(), -1.0f, 1.0f);
+    int labels[] = { 0, 3, 1, 4, 2 };
+    net->setBatchSize(batchSize);
+    fused->setBatchSize(batchSize);
+    net->forward(input);
+    fused->forward(input);
+    for(int layerIndex = 1; layerIndex < net->getNumLayers(); layerIndex++) {
+        Layer *layer = net->getLayer(layerIndex);
+        Layer *fusedLayer = fused->getLayer(layerIndex);
+        // fused conv layers' outputs are post-activation, so skip those
+        if(layerIndex + 1 < net->getNumLayers() && fused->getLayer(layerIndex + 1)->passesThroughOutput()) {
+            continue;
+        }
+        float const*output = layer->getOutput();
+        float const*fusedOutput = fusedLayer->getOutput();
+        for(int i = 0; i < batchSize * layer->getOutputCubeSize(); i++) {
+            EXPECT_FLOAT_NEAR(output[i], fusedOutput[i]);
+        }
+    }
+
+    net->backwardFromLabels(labels);
+    fused->backwardFromLabels(labels);
+    for(int layerIndex = 1; layerIndex < net->getNumLayers(); layerIndex++) {
+        Layer *layer = net->getLayer(layerIndex);
+        if(layer->getWeightsSize() == 0) {
+            continue;
+        }
+        expectSameGrads(layer->getGradWeightsWrapper(), fused->getLayer(layerIndex)->getGradWeightsWrapper());
+        if(layer->getBiasSize() > 0) {
+            expectSameGrads(layer->getGradBiasWrapper(), fused->getLayer(layerIndex)->getGradBiasWrapper());
+        }
+    }
+
+    // fused activation layers share their input's buffer, which the plan has to allow for
+    net->setTraining(false);
+    fused->planInference(-1);
+    cout << fused->getInferencePlanString() << endl;
+    fused->setBatchSize(batchSize);
+    net->forward(input);
+    fused->forward(input);
+    for(int i = 0; i < batchSize * net->getOutputCubeSize(); i++) {
+        EXPECT_FLOAT_NEAR(net->getOutput()[i], fused->getOutput()[i]);
+    }
+
+    delete[] input;
+    delete fused;
+    delete net;
+    delete cl;
+}
+
+
+// each backward and backprop-weights implementation, given the gradient of the
+// post-activation output, should match the plain one given the gradient before
+// the activation, whether it applies the derivative itself, or in a pass first
+TEST(testFusedActivation, implementationsApplyDeriv) {
+    EasyCL *cl = DeepCLGtestGlobals_createEasyCL();
+    TanhActivation tanhActivation;
+    LayerDimensions dim;
+    dim.setInputPlanes(3).setInputSize(9).setNumFilters(4).setFilterSize(3).setPadZeros(true).setBiased(true);
+    LayerDimensions fusedDim = dim;
+    fusedDim.setActivation(&tanhActivation);
+
+    const int batchSize = 3;
+    const int inputNumElements = batchSize * dim.inputCubeSize;
+    const int outputNumElements = batchSize * dim.outputCubeSize;
+    float *input = new float[inputNumElements];
+    float *weights = new float[dim.filtersSize];
+    float *output = new float[outputNumElements];
+    float *gradOutput = new float[outputNumElements];
+    float *gradPreActivation = new float[outputNumElements];
+    WeightRandomizer::randomize(0, input, inputNumElements, -1.0f, 1.0f);
+    WeightRandomizer::randomize(1, weights, dim.filtersSize, -0.5f, 0.5f);
+    WeightRandomizer::randomize(2, output, outputNumElements, -0.9f, 0.9f);
+    WeightRandomizer::randomize(3, gradOutput, outputNumElements, -1.0f, 1.0f);
+    for(int i = 0; i < outputNumElements; i++) {
+        gradPreActivation[i] = gradOutput[i] * (1 - output[i] * output[i]);
+    }
+    CLWrapper *inputWrapper = cl->wrap(inputNumElements, input);
+    CLWrapper *weightsWrapper = cl->wrap(dim.filtersSize, weights);
+    CLWrapper *outputWrapper = cl->wrap(outputNumElements, output);
+    CLWrapper *gradOutputWrapper = cl->wrap(outputNumElements, gradOutput);
+    CLWrapper *gradPreActivationWrapper = cl->wrap(outputNumElements, gradPreActivation);
+    inputWrapper->copyToDevice();
+    weightsWrapper->copyToDevice();
+    outputWrapper->copyToDevice();
+    gradOutputWrapper->copyToDevice();
+    gradPreActivationWrapper->copyToDevice();
+
+    float *gradInput = new float[inputNumElements];
+    float *fusedGradInput = new float[inputNumElements];
+    CLWrapper *gradInputWrapper = cl->wrap(inputNumElements, gradInput);
+    CLWrapper *fusedGradInputWrapper = cl->wrap(inputNumElements, fusedGradInput);
+    gradInputWrapper->createOnDevice();
+    fusedGradInputWrapper->createOnDevice();
+    for(int i = 1; i < Backward::getNumImplementations(); i++) {
+        Backward *plain = 0;
+        Backward *fusedImpl = 0;
+        try {
+            plain = Backward::instanceSpecific(i, cl, dim);
+            fusedImpl = Backward::instanceSpecific(i, cl, fusedDim);
+            plain->backward(batchSize, inputWrapper, gradPreActivationWrapper, weightsWrapper, gradInputWrapper);
+            fusedImpl->backwardThroughActivation(batchSize, inputWrapper, gradOutputWrapper, outputWrapper, weightsWrapper, fusedGradInputWrapper);
+        } catch(runtime_error &e) {
+            cout << "backward " << i << " cant be used here: " << e.what() << endl;
+            delete plain;
+            delete fusedImpl;
+            continue;
+        }
+        cout << "backward " << i << endl;
+        expectSameGrads(gradInputWrapper, fusedGradInputWrapper);
+        delete plain;
+        delete fusedImpl;
+    }
+
+    float *gradWeights = new float[dim.filtersSize];
+    float *fusedGradWeights = new float[dim.filtersSize];
+    float *gradBias = new float[dim.numFilters];
+    float *fusedGradBias = new float[dim.numFilters];
+    CLWrapper *gradWeightsWrapper = cl->wrap(dim.filtersSize, gradWeights);
+    CLWrapper *fusedGradWeightsWrapper = cl->wrap(dim.filtersSize, fusedGradWeights);
+    CLWrapper *gradBiasWrapper = cl->wrap(dim.numFilters, gradBias);
+    CLWrapper *fusedGradBiasWrapper = cl->wrap(dim.numFilters, fusedGradBias);
+    gradWeightsWrapper->createOnDevice();
+    fusedGradWeightsWrapper->createOnDevice();
+    gradBiasWrapper->createOnDevice();
+    fusedGradBiasWrapper->createOnDevice();
+    for(int i = 1; i < BackpropWeights::getNumImplementations(); i++) {
+        BackpropWeights *plain = 0;
+        BackpropWeights *fusedImpl = 0;
+        try {
+            plain = BackpropWeights::instanceSpecific(i, cl, dim);
+            fusedImpl = BackpropWeights::instanceSpecific(i, cl, fusedDim);
+            plain->calcGradWeights(batchSize, gradPreActivationWrapper, inputWrapper, gradWeightsWrapper, gradBiasWrapper);
+            fusedImpl->calcGradWeightsThroughActivation(batchSize, gradOutputWrapper, outputWrapper, inputWrapper, fusedGradWeightsWrapper, fusedGradBiasWrapper);
+        } catch(runtime_error &e) {
+            cout << "backpropweights " << i << " cant be used here: " << e.what() << endl;
+            delete plain;
+            delete fusedImpl;
+            continue;
+        }
+        cout << "backpropweights " << i << endl;
+        expectSameGrads(gradWeightsWrapper, fusedGradWeightsWrapper);
+        expectSameGrads(gradBiasWrapper, fusedGradBiasWrapper);
+        delete plain;
+        delete fusedImpl;
+    }
+
+    delete fusedGradBiasWrapper;
+    delete gradBiasWrapper;
+    delete fusedGradWeightsWrapper;
+    delete gradWeightsWrapper;
+    delete fusedGradInputWrapper;
+    delete gradInputWrapper;
+    delete gradPreActivationWrapper;
+    delete gradOutputWrapper;
+    delete outputWrapper;
+    delete weightsWrapper;
+    delete inputWrapper;
+    delete[] fusedGradBias;
+    delete[] gradBias;
+    delete[] fusedGradWeights;
+    delete[] gradWeights;
+    delete[] fusedGradInput;
+    delete[] gradInput;
+    delete[] gradPreActivation;
+    delete[] gradOutput;
+    delete[] output;
+    delete[] weights;
+    delete[] input;
+    delete cl;
+}
+
+}
@@ -0,0 +1,129 @@
+// Copyright Hugh Perkins 2015 hughperkins at gmail
+//
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file, You can
+// obtain one at http://mozilla.org/MPL/2.0/.
+
+#include <iostream>
+#include <string>
+#include <cstring>
+
+#include "EasyCL.h"
+#include "clmath/CLMathWrapper.h"
+#include "clmath/FusedOp.h"
+
+#include "gtest/gtest.h"
+#include "test/gtest_supp.h"
+#include "test/WeightRandomizer.h"
+
+using namespace std;
+
+// the adadelta update, on whichever wrappers we're given
+static void adadelta(CLMathWrapper &clWeights, CLMathWrapper &clGradWeights, CLMathWrapper &clSumGradSquared,
+        CLMathWrapper &clSumUpdateSquared, CLMathWrapper &clWorking) {
+    float decay = 0.9f;
+    clWorking = clGradWeights;
+    clWorking.squared();
+    clWorking *= (1 - decay);
+    clSumGradSquared *= decay;
+    clSumGradSquared += clWorking;
+
+    clWorking = clSumGradSquared;
+    clWorking += 0.0000001f;
+    clWorking.inv();
+    clWorking *= clSumUpdateSquared;
+    clWorking.sqrt();
+    clWorking *= clGradWeights;
+    clWorking *= - 1;
+
+    clWeights += clWorking;
+
+    clSumUpdateSquared *= decay;
+    clWorking.squared();
+    clWorking *= (1 - decay);
+    clSumUpdateSquared += clWorking;
+}
+
+TEST(testFusedOp, adadeltaMatchesUnfused) {
+    EasyCL *cl = DeepCLGtestGlobals_createEasyCL();
+    const int N = 1000;
+    // 0-3 unfused, 4-7 fused
+    float *data[8];
+    CLWrapper *wrappers[8];
+    for(int i = 0; i < 4; i++) {
+        data[i] = new float[N];
+        data[i + 4] = new float[N];
+        WeightRandomizer::randomize(i, data[i], N, 0.1f, 1.0f);
+        memcpy(data[i + 4], data[i], sizeof(float) * N);
+    }
+    for(int i = 0; i < 8; i++) {
+        wrappers[i] = cl->wrap(N, data[i]);
+        wrappers[i]->copyToDevice();
+    }
+    float *working = new float[N];
+    CLWrapper *workingWrapper = cl->wrap(N, working);
+    workingWrapper->createOnDevice();
+    {
+        CLMathWrapper weights(wrappers[0]), gradWeights(wrappers[1]), sumGradSquared(wrappers[2]),
+            sumUpdateSquared(wrappers[3]), clWorking(workingWrapper);
+        adadelta(weights, gradWeights, sumGradSquared, sumUpdateSquared, clWorking);
+    }
+    FusedOp fused(cl, N);
+    {
+        CLMathWrapper weights(wrappers[4], &fused), gradWeights(wrappers[5], &fused),
+            sumGradSquared(wrappers[6], &fused), sumUpdateSquared(wrappers[7], &fused),
+            clWorking(&fused);
+        adadelta(weights, gradWeights, sumGradSquared, sumUpdateSquared, clWorking);
+        string source = fused.getKernelSource();
+        // gradWeights is only read, so shouldnt be written back
+        EXPECT_NE(string::npos, source.find("global const float *a1"));
+        EXPECT_EQ(string::npos, source.find("a1[globalId] ="));
+        fused.run();
+        // second run reuses the kernel
+        adadelta(weights, gradWeights, sumGradSquared, sumUpdateSquared, clWorking);
+        fused.run();
+    }
+    // and one more unfused, to match
+    {
+        CLMathWrapper weights(wrappers[0]), gradWeights(wrappers[1]), sumGradSquared(wrappers[2]),
+            sumUpdateSquared(wrappers[3]), clWorking(workingWrapper);
+        adadelta(weights, gradWeights, sumGradSquared, sumUpdateSquared, clWorking);
+    }
+    for(int i = 0; i < 8; i++) {
+        wrappers[i]->copyToHost();
+    }
+    for(int i = 0; i < 4; i++) {
+        for(int j = 0; j < N; j++) {
+            EXPECT_FLOAT_NEAR(data[i][j], data[i + 4][j]);
+        }
+    }
+
+    delete workingWrapper;
+    delete[] working;
+    for(int i = 0; i < 8; i++) {
+        delete wrappers[i];
+        delete[] data[i];
+    }
+    delete cl;
+}
+
+TEST(testFusedOp, mixingThrows) {
+    EasyCL *cl = DeepCLGtestGlobals_createEasyCL();
+    float adat[] = { 1, 2, 3 };
+    float bdat[] = { 4, 5, 6 };
+    CLWrapper *a_ = cl->wrap(3, adat);
+    CLWrapper *b_ = cl->wrap(3, bdat);
+    a_->copyToDevice();
+    b_->copyToDevice();
+    FusedOp fused(cl, 3);
+    CLMathWrapper a(a_, &fused);
+    CLMathWrapper b(b_);
+    EXPECT_THROW(a += b, runtime_error);
+    CLMathWrapper temp(&fused);
+    EXPECT_THROW(temp.sqrt(), runtime_error);
+
+    delete a_;
+    delete b_;
+    delete cl;
+}
+
@@ -0,0 +1,148 @@
+// Copyright Hugh Perkins 2015 hughperkins at gmail
+//
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file, You can
+// obtain one at http://mozilla.org/MPL/2.0/.
+
+#include <iostream>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+#include "batch/InferenceQueue.h"
+#include "util/LatencyStats.h"
+
+#include "gtest/gtest.h"
+
+using namespace std;
+
+// output is sum of the 3 inputs, and the batch size it ran in
+static void fakeNet(vector<int> *batchSizes, int batchSize, float const*inputs, float *outputs) {
+    batchSizes->push_back(batchSize);
+    for(int n = 0; n < batchSize; n++) {
+        outputs[n * 2] = inputs[n * 3] + inputs[n * 3 + 1] + inputs[n * 3 + 2];
+        outputs[n * 2 + 1] = (float)batchSize;
+    }
+}
+
+TEST(testInferenceQueue, coalesces) {
+    InferenceQueue queue(3, 2, 4, 1000.0f);
+    vector<int> batchSizes;
+    const int numClients = 10;
+    float outputs[numClients][2];
+    vector<thread> clients;
+    for(int i = 0; i < numClients; i++) {
+        clients.push_back(thread([&queue, &outputs, i]() {
+            float input[3] = { (float)i, 1.0f, 2.0f };
+            queue.submit(input, outputs[i]);
+        }));
+    }
+    int numRun = 0;
+    while(numRun < numClients) {
+        numRun += queue.runOnce(bind(fakeNet, &batchSizes, placeholders::_1, placeholders::_2, placeholders::_3), 100);
+    }
+    for(int i = 0; i < numClients; i++) {
+        clients[i].join();
+        EXPECT_EQ((float)(i + 3), outputs[i][0]);
+    }
+    // the deadline is long, so only the tail of the queue runs as a partial batch
+    EXPECT_EQ(3, (int)batchSizes.size());
+    EXPECT_EQ(4, batchSizes[0]);
+    EXPECT_EQ(4, batchSizes[1]);
+    EXPECT_EQ(2, batchSizes[2]);
+    EXPECT_EQ(10, queue.getNumRequests());
+    EXPECT_EQ(3, queue.getNumBatches());
+}
+
+TEST(testInferenceQueue, deadline) {
+    InferenceQueue queue(3, 2, 64, 20.0f);
+    vector<int> batchSizes;
+    // nothing submitted yet, so just times out
+    EXPECT_EQ(0, queue.runOnce(bind(fakeNet, &batchSizes, placeholders::_1, placeholders::_2, placeholders::_3), 1));
+    double start = LatencyStats::nowSeconds();
+    float output[2];
+    thread client([&queue, &output]() {
+        float input[3] = { 1.0f, 2.0f, 3.0f };
+        queue.submit(input, output);
+    });
+    int numRun = 0;
+    while(numRun == 0) {
+        numRun = queue.runOnce(bind(fakeNet, &batchSizes, placeholders::_1, placeholders::_2, placeholders::_3), 100);
+    }
+    client.join();
+    EXPECT_EQ(1, numRun);
+    EXPECT_EQ(6.0f, output[0]);
+    EXPECT_EQ(1.0f, output[1]);
+    // waited for the deadline, not for a full batch
+    EXPECT_GT(5.0, LatencyStats::nowSeconds() - start);
+    EXPECT_LE(19.0f, queue.getLatencyPercentile(50));
+}
+
+static void failingNet(int batchSize, float const*inputs, float *outputs) {
+    throw runtime_error("out of memory");
+}
+
+TEST(testInferenceQueue, errors) {
+    InferenceQueue queue(3, 2, 4, 0.0f);
+    bool threw = false;
+    thread client([&queue, &threw]() {
+        float input[3] = { 1.0f, 2.0f, 3.0f };
+        float output[2];
+        try {
+            queue.submit(input, output);
+        } catch(runtime_error &e) {
+            threw = true;
+        }
+    });
+    int numRun = 0;
+    while(numRun == 0) {
+        numRun = queue.runOnce(failingNet, 100);
+    }
+    client.join();
+    EXPECT_TRUE(threw);
+    EXPECT_EQ(0, queue.getNumRequests());
+
+    queue.stop();
+    float input[3];
+    float output[2];
+    EXPECT_THROW(queue.submit(input, output), runtime_error);
+}
+
+static void crashingNet(int batchSize, float const*inputs, float *outputs) {
+    throw 42;
+}
+
+// not a runtime_error: the client still gets an error, rather than waiting forever
+TEST(testInferenceQueue, otherExceptions) {
+    InferenceQueue queue(3, 2, 4, 0.0f);
+    bool threw = false;
+    thread client([&queue, &threw]() {
+        float input[3] = { 1.0f, 2.0f, 3.0f };
+        float output[2];
+        try {
+            queue.submit(input, output);
+        } catch(runtime_error &e) {
+            threw = true;
+        }
+    });
+    int numRun = 0;
+    while(numRun == 0) {
+        numRun = queue.runOnce(crashingNet, 100);
+    }
+    client.join();
+    EXPECT_TRUE(threw);
+}
+
+TEST(testInferenceQueue, latencystats) {
+    LatencyStats stats(100);
+    EXPECT_EQ(0.0f, stats.getPercentile(50));
+    for(int i = 1; i <= 200; i++) {
+        stats.add((float)i);
+    }
+    // only the last 100 are kept for the percentiles
+    EXPECT_EQ(200, stats.getCount());
+    EXPECT_NEAR(150.0f, stats.getPercentile(50), 1.0f);
+    EXPECT_NEAR(199.0f, stats.getPercentile(99), 1.0f);
+    EXPECT_EQ(101.0f, stats.getPercentile(0));
+}
+
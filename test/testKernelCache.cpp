@@ -0,0 +1,68 @@
+// Copyright Hugh Perkins 2015 hughperkins at gmail
+//
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file, You can
+// obtain one at http://mozilla.org/MPL/2.0/.
+
+#include <iostream>
+#include <ctime>
+
+#include "gtest/gtest.h"
+#include "test/gtest_supp.h"
+#include "test/DeepCLGtestGlobals.h"
+#include "EasyCL.h"
+#include "util/FileHelper.h"
+#include "util/KernelCache.h"
+#include "util/stringhelper.h"
+
+using namespace std;
+
+static void runMemset(EasyCL *cl, CLKernel *kernel, float value) {
+    int N = 1000;
+    float *myArray = new float[N];
+    CLWrapper *myArrayWrapper = cl->wrap(N, myArray);
+    myArrayWrapper->createOnDevice();
+    kernel->out(myArrayWrapper)->in(value)->in(N);
+    int workgroupSize = 64;
+    kernel->run_1d((N + workgroupSize - 1) / workgroupSize * workgroupSize, workgroupSize);
+    cl->finish();
+    myArrayWrapper->copyToHost();
+    for(int i = 0; i < N; i++) {
+        EXPECT_EQ(value, myArray[i]);
+    }
+    delete myArrayWrapper;
+    delete[] myArray;
+}
+
+// second build should come from the binary the first one wrote, and still work
+TEST(testKernelCache, buildtwice) {
+    EasyCL *cl = DeepCLGtestGlobals_createEasyCL();
+    FileHelper::setCacheDirectory("testkernelcache");
+    KernelCache::setEnabled(true);
+
+    string source =
+        "kernel void cl_memset(global float *target, const float value, const int N) {\n"
+        "    const int globalId = get_global_id(0);\n"
+        "    if(globalId < N) {\n"
+        "        target[globalId] = value;\n"
+        "    }\n"
+        "}\n";
+    // make the source unique to this run, so the first build is a miss
+    source += "// " + toString((long)time(0)) + "\n";
+
+    long long hits = KernelCache::getNumHits();
+    long long misses = KernelCache::getNumMisses();
+    CLKernel *first = KernelCache::buildKernelFromString(cl, source, "cl_memset", "", "testKernelCache");
+    EXPECT_EQ(hits, KernelCache::getNumHits());
+    EXPECT_EQ(misses + 1, KernelCache::getNumMisses());
+    runMemset(cl, first, 3.0f);
+    CLKernel *second = KernelCache::buildKernelFromString(cl, source, "cl_memset", "", "testKernelCache");
+    EXPECT_EQ(hits + 1, KernelCache::getNumHits());
+    EXPECT_EQ(misses + 1, KernelCache::getNumMisses());
+    runMemset(cl, second, 5.0f);
+
+    delete second;
+    delete first;
+    FileHelper::setCacheDirectory("");
+    delete cl;
+}
@@ -7,6 +7,7 @@
 #include "test/gtest_supp.h"
 #include "util/Timer.h"
 #include "EasyCL.h"
+#include "util/KernelCache.h"
 
 using namespace std;
 
@@ -34,7 +35,7 @@ TEST( testMemset, basic ) {
     "}\n"
     "\n"
     "";
-    kMemset = cl->buildKernelFromString(kMemsetSource, "cl_memset", "", "cl/memset.cl");
+    kMemset = KernelCache::buildKernelFromString(cl, kMemsetSource, "cl_memset", "", "cl/memset.cl");
     // [[[end]]]
 
     int N = 10000;
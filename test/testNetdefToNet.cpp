@@ -13,6 +13,7 @@
 #include "fc/FullyConnectedLayer.h"
 #include "conv/ConvolutionalLayer.h"
 #include "loss/SoftMaxLayer.h"
+#include "activate/ActivationLayer.h"
 #include "layer/LayerMakers.h"
 
 TEST( testNetdefToNet, empty ) {
@@ -198,3 +199,26 @@ TEST( testNetdefToNet, 2x32c7_3x32c5z ) {
     delete cl;
 }
 
+
+TEST( testNetdefToNet, fusesActivations ) {
+    EasyCL *cl = DeepCLGtestGlobals_createEasyCL();
+    NeuralNet *net = new NeuralNet(cl);
+    net->addLayer( InputLayerMaker::instance()->numPlanes(1)->imageSize(19) );
+    ASSERT_EQ( true, NetdefToNet::createNetFromNetdef( net, "8c5z-relu-mp2-tanh-150n{tanh}-10n" ) );
+    net->print();
+    EXPECT_EQ( 9, net->getNumLayers() );
+    ConvolutionalLayer *conv = dynamic_cast< ConvolutionalLayer * >( net->getLayer(1) );
+    ASSERT_TRUE( conv->dim.activation != 0 );
+    EXPECT_EQ( std::string("RELU"), conv->dim.activation->getDefineName() );
+    EXPECT_TRUE( dynamic_cast< ActivationLayer * >( net->getLayer(2) )->fused );
+    // follows a pooling layer, so stays as it is
+    EXPECT_FALSE( dynamic_cast< ActivationLayer * >( net->getLayer(4) )->fused );
+    FullyConnectedLayer *fc = dynamic_cast< FullyConnectedLayer * >( net->getLayer(5) );
+    EXPECT_EQ( std::string("TANH"), fc->convolutionalLayer->dim.activation->getDefineName() );
+    EXPECT_TRUE( dynamic_cast< ActivationLayer * >( net->getLayer(6) )->fused );
+    // the last fc layer has softmax after it
+    fc = dynamic_cast< FullyConnectedLayer * >( net->getLayer(7) );
+    EXPECT_TRUE( fc->convolutionalLayer->dim.activation == 0 );
+    delete net;
+    delete cl;
+}
@@ -0,0 +1,74 @@
+// Copyright Hugh Perkins 2015 hughperkins at gmail
+//
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file, You can
+// obtain one at http://mozilla.org/MPL/2.0/.
+
+#include <iostream>
+
+#include "EasyCL.h"
+#include "net/NeuralNet.h"
+#include "net/NeuralNetMould.h"
+#include "layer/LayerMakers.h"
+#include "input/InputLayer.h"
+#include "normalize/NormalizationLayer.h"
+
+#include "gtest/gtest.h"
+#include "test/gtest_supp.h"
+
+using namespace std;
+
+// uint8 input is normalized on the device, and should give the same results as
+// passing in the same values as floats
+TEST(testNormalizationLayer, bytes_same_as_floats) {
+    const int batchSize = 3;
+    const int numPlanes = 2;
+    const int imageSize = 5;
+    const float translate = -100.0f;
+    const float scale = 0.02f;
+    EasyCL *cl = DeepCLGtestGlobals_createEasyCL();
+    NeuralNet *net = NeuralNet::maker(cl)->instance();
+    net->addLayer(InputLayerMaker::instance()->numPlanes(numPlanes)->imageSize(imageSize));
+    net->addLayer(NormalizationLayerMaker::instance()->translate(translate)->scale(scale));
+    net->addLayer(FullyConnectedMaker::instance()->numPlanes(4)->imageSize(1)->biased());
+    net->setBatchSize(batchSize);
+
+    const int numElements = batchSize * numPlanes * imageSize * imageSize;
+    unsigned char *bytes = new unsigned char[numElements];
+    float *floats = new float[numElements];
+    for(int i = 0; i < numElements; i++) {
+        bytes[i] = (unsigned char)((i * 37) % 256);
+        floats[i] = bytes[i];
+    }
+    const int outputNumElements = batchSize * 4;
+
+    net->forward(floats);
+    NormalizationLayer *normalizationLayer = dynamic_cast<NormalizationLayer *>(net->getLayer(1));
+    EXPECT_FALSE(normalizationLayer->hasOutputWrapper());
+    float *floatsOutput = new float[outputNumElements];
+    for(int i = 0; i < outputNumElements; i++) {
+        floatsOutput[i] = net->getOutput()[i];
+    }
+
+    net->forward(bytes);
+    EXPECT_TRUE(normalizationLayer->hasOutputWrapper());
+    float const*normalized = normalizationLayer->getOutput();
+    for(int i = 0; i < numElements; i++) {
+        EXPECT_FLOAT_NEAR((bytes[i] + translate) * scale, normalized[i]);
+    }
+    for(int i = 0; i < outputNumElements; i++) {
+        EXPECT_FLOAT_NEAR(floatsOutput[i], net->getOutput()[i]);
+    }
+    // input layer converts on the host, only if asked
+    float *inputLayerOutput = net->getLayer(0)->getOutput();
+    for(int i = 0; i < numElements; i++) {
+        EXPECT_EQ((float)bytes[i], inputLayerOutput[i]);
+    }
+
+    delete[] floatsOutput;
+    delete[] floats;
+    delete[] bytes;
+    delete net;
+    delete cl;
+}
+
@@ -0,0 +1,209 @@
+// Copyright Hugh Perkins 2015 hughperkins at gmail
+//
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file, You can
+// obtain one at http://mozilla.org/MPL/2.0/.
+
+#include <iostream>
+#include <fstream>
+#include <vector>
+#include <cmath>
+#include <stdexcept>
+
+#include "normalize/NormalizationStats.h"
+#include "loaders/PackedLoader.h"
+#include "loaders/GenericLoaderv2.h"
+#include "util/FileHelper.h"
+
+#include "gtest/gtest.h"
+
+using namespace std;
+
+namespace testNormalizationStats {
+
+// two-pass, in long double
+template< typename T >
+void reference(T const*data, long length, double *p_mean, double *p_stdDev) {
+    long double sum = 0;
+    for(long i = 0; i < length; i++) {
+        sum += data[i];
+    }
+    long double mean = sum / length;
+    long double m2 = 0;
+    for(long i = 0; i < length; i++) {
+        m2 += (data[i] - mean) * (data[i] - mean);
+    }
+    *p_mean = (double)mean;
+    *p_stdDev = (double)sqrtl(m2 / (length - 1));
+}
+
+// several blocks, and a tail that isnt a multiple of 16
+TEST(testNormalizationStats, uchar) {
+    long length = 3 * 65536 + 1001;
+    vector<unsigned char> data(length);
+    for(long i = 0; i < length; i++) {
+        data[i] = (unsigned char)((i * 7919 + i / 13) % 251 + 2);
+    }
+    NormalizationStats stats;
+    stats.add(&data[0], length);
+    double mean, stdDev;
+    reference(&data[0], length, &mean, &stdDev);
+    EXPECT_EQ(length, stats.count);
+    EXPECT_NEAR(mean, stats.getMean(), 1e-9);
+    EXPECT_NEAR(stdDev, stats.getStdDev(), 1e-9);
+    EXPECT_EQ(2.0f, stats.minValue);
+    EXPECT_EQ(252.0f, stats.maxValue);
+}
+
+// large offset, small spread: sum and sum of squares in float gets this badly wrong
+TEST(testNormalizationStats, floatStable) {
+    long length = 200000;
+    vector<float> data(length);
+    for(long i = 0; i < length; i++) {
+        data[i] = 10000.0f + (i % 10) * 0.01f;
+    }
+    NormalizationStats stats;
+    stats.add(&data[0], length);
+    double mean, stdDev;
+    reference(&data[0], length, &mean, &stdDev);
+    EXPECT_NEAR(mean, stats.getMean(), 1e-6);
+    EXPECT_NEAR(stdDev, stats.getStdDev(), 1e-6);
+    EXPECT_GT(stats.getStdDev(), 0.02);
+}
+
+// adding in pieces, and merging, gives the same as adding all at once
+TEST(testNormalizationStats, merge) {
+    long length = 100000;
+    vector<unsigned char> data(length);
+    for(long i = 0; i < length; i++) {
+        data[i] = (unsigned char)((i * 31) % 256);
+    }
+    NormalizationStats all;
+    all.add(&data[0], length);
+    NormalizationStats first;
+    first.add(&data[0], 12345);
+    NormalizationStats second;
+    second.add(&data[12345], 40000);
+    second.add(&data[52345], length - 52345);
+    first.merge(second);
+    EXPECT_EQ(all.count, first.count);
+    EXPECT_NEAR(all.getMean(), first.getMean(), 1e-9);
+    EXPECT_NEAR(all.getStdDev(), first.getStdDev(), 1e-9);
+    EXPECT_EQ(all.minValue, first.minValue);
+    EXPECT_EQ(all.maxValue, first.maxValue);
+}
+
+TEST(testNormalizationStats, transforms) {
+    NormalizationStats stats;
+    unsigned char data[] = { 10, 20, 30, 40 };
+    stats.add(data, 4);
+    float translate, scale;
+    stats.getMinMaxTransform(&translate, &scale);
+    EXPECT_FLOAT_EQ(-25.0f, translate);
+    EXPECT_FLOAT_EQ(1.0f / 15.0f, scale);
+    stats.getStdDevTransform(2.0f, &translate, &scale);
+    EXPECT_FLOAT_EQ(-25.0f, translate);
+    EXPECT_FLOAT_EQ((float)(1.0 / sqrt(500.0 / 3.0) / 2.0), scale);
+}
+
+// strided chunks dont overlap, stay inside the dataset, and reach its end
+TEST(testNormalizationStats, stridedChunks) {
+    int N = 1000;
+    int numExamples = 95;
+    int chunkSize = 10;
+    int numChunks = NormalizationStats::getNumChunks(numExamples, chunkSize);
+    EXPECT_EQ(10, numChunks);
+    int total = 0;
+    int previousEnd = 0;
+    for(int chunk = 0; chunk < numChunks; chunk++) {
+        int start = NormalizationStats::getChunkStart(N, numExamples, chunkSize, true, chunk);
+        int n = NormalizationStats::getChunkN(numExamples, chunkSize, chunk);
+        EXPECT_GE(start, previousEnd);
+        EXPECT_LE(start + n, N);
+        previousEnd = start + n;
+        total += n;
+    }
+    EXPECT_EQ(numExamples, total);
+    EXPECT_GT(previousEnd, N / 2);
+    // all of them: strided is the same as first
+    for(int chunk = 0; chunk < 10; chunk++) {
+        EXPECT_EQ(chunk * 10, NormalizationStats::getChunkStart(100, 100, 10, true, chunk));
+    }
+}
+
+// N records of 2 planes of 3x3; record n is all n
+static void writePacked(string filepath, int N) {
+    ofstream out(filepath.c_str(), ios::out | ios::binary | ios::trunc);
+    string header = PackedLoader::makeHeader(N, 2, 3, false, true, 0.0f, 1.0f);
+    out.write(header.c_str(), header.size());
+    for(int n = 0; n < N; n++) {
+        for(int i = 0; i < 18; i++) {
+            unsigned char value = (unsigned char)n;
+            out.write(reinterpret_cast<char *>(&value), 1);
+        }
+    }
+    for(int n = 0; n < N; n++) {
+        int label = n % 10;
+        out.write(reinterpret_cast<char *>(&label), 4);
+    }
+}
+
+// reading through a loader, with prefetching, gives the same as from memory
+TEST(testNormalizationStats, loaderSameAsMemory) {
+    writePacked("~normstats.dat", 200);
+    GenericLoaderv2 loader("~normstats.dat");
+    vector<unsigned char> images(200 * 18);
+    vector<int> labels(200);
+    loader.load(&images[0], &labels[0], 0, 200);
+    for(int strided = 0; strided <= 1; strided++) {
+        for(int prefetchDepth = 1; prefetchDepth <= 3; prefetchDepth++) {
+            NormalizationStats fromLoader = NormalizationStats::compute(&loader, 200, 45, 10, strided == 1, prefetchDepth);
+            NormalizationStats fromMemory = NormalizationStats::compute(&images[0], 200, 18, 45, 10, strided == 1);
+            EXPECT_EQ(45 * 18, fromLoader.count);
+            EXPECT_EQ(fromMemory.count, fromLoader.count);
+            EXPECT_EQ(fromMemory.mean, fromLoader.mean);
+            EXPECT_EQ(fromMemory.m2, fromLoader.m2);
+            EXPECT_EQ(fromMemory.maxValue, fromLoader.maxValue);
+        }
+    }
+    NormalizationStats first = NormalizationStats::compute(&images[0], 200, 18, 45, 10, false);
+    EXPECT_EQ(44.0f, first.maxValue);
+    NormalizationStats strided = NormalizationStats::compute(&images[0], 200, 18, 45, 10, true);
+    EXPECT_GT(strided.maxValue, 150.0f);
+    FileHelper::remove("~normstats.dat");
+}
+
+TEST(testNormalizationStats, cache) {
+    writePacked("~normstatsc.dat", 50);
+    string cacheFilepath = NormalizationStats::getCacheFilepath("~normstatsc.dat");
+    string key = NormalizationStats::getCacheKey("~normstatsc.dat", 50, 18, 20, 10, true);
+    EXPECT_EQ(key, NormalizationStats::getCacheKey("~normstatsc.dat", 50, 18, 20, 10, true));
+    EXPECT_NE(key, NormalizationStats::getCacheKey("~normstatsc.dat", 50, 18, 20, 10, false));
+    // the chunk size only changes which records are read when strided
+    EXPECT_NE(key, NormalizationStats::getCacheKey("~normstatsc.dat", 50, 18, 20, 5, true));
+    EXPECT_EQ(NormalizationStats::getCacheKey("~normstatsc.dat", 50, 18, 20, 10, false),
+        NormalizationStats::getCacheKey("~normstatsc.dat", 50, 18, 20, 5, false));
+
+    NormalizationStats stats;
+    unsigned char data[] = { 1, 2, 3, 250 };
+    stats.add(data, 4);
+    stats.writeCache(cacheFilepath, key);
+    NormalizationStats cached;
+    EXPECT_TRUE(cached.readCache(cacheFilepath, key));
+    EXPECT_EQ(stats.count, cached.count);
+    EXPECT_EQ(stats.mean, cached.mean);
+    EXPECT_EQ(stats.m2, cached.m2);
+    EXPECT_EQ(stats.minValue, cached.minValue);
+    EXPECT_EQ(stats.maxValue, cached.maxValue);
+    EXPECT_FALSE(cached.readCache(cacheFilepath, key + " other"));
+
+    // a different dataset gets a different key
+    writePacked("~normstatsc.dat", 51);
+    EXPECT_NE(key, NormalizationStats::getCacheKey("~normstatsc.dat", 50, 18, 20, 10, true));
+    FileHelper::remove(cacheFilepath);
+    FileHelper::remove("~normstatsc.dat");
+    EXPECT_FALSE(cached.readCache(cacheFilepath, key));
+}
+
+}
+
@@ -0,0 +1,177 @@
+// Copyright Hugh Perkins 2015 hughperkins at gmail
+//
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file, You can
+// obtain one at http://mozilla.org/MPL/2.0/.
+
+#include <iostream>
+#include <fstream>
+#include <vector>
+#include <stdexcept>
+
+#include "loaders/PackedLoader.h"
+#include "loaders/GenericLoaderv2.h"
+#include "batch/OnDemandBatcherv2.h"
+#include "batch/NetAction.h"
+#include "trainers/Trainer.h"
+#include "net/Trainable.h"
+#include "util/FileHelper.h"
+
+#include "gtest/gtest.h"
+
+using namespace std;
+
+// N records of planes=2, size=3; value at i in record n is n * 10 + i,
+// label of record n is 100 + n
+static void writePacked(string filepath, int N, bool isFloat, bool truncate) {
+    int cubeSize = 2 * 3 * 3;
+    ofstream out(filepath.c_str(), ios::out | ios::binary | ios::trunc);
+    string header = PackedLoader::makeHeader(N, 2, 3, isFloat, true, 0.5f, 0.25f);
+    out.write(header.c_str(), header.size());
+    for(int n = 0; n < N; n++) {
+        for(int i = 0; i < cubeSize; i++) {
+            if(isFloat) {
+                float value = n * 10 + i + 0.5f;
+                out.write(reinterpret_cast<char *>(&value), 4);
+            } else {
+                unsigned char value = (unsigned char)(n * 10 + i);
+                out.write(reinterpret_cast<char *>(&value), 1);
+            }
+        }
+    }
+    for(int n = 0; n < (truncate ? N - 1 : N); n++) {
+        int label = 100 + n;
+        out.write(reinterpret_cast<char *>(&label), 4);
+    }
+}
+
+TEST(testPackedLoader, uchar) {
+    writePacked("~packed.dat", 7, false, false);
+    EXPECT_TRUE(PackedLoader::isFormatFor("~packed.dat"));
+    PackedLoader loader("~packed.dat");
+    EXPECT_EQ(7, loader.getN());
+    EXPECT_EQ(2, loader.getPlanes());
+    EXPECT_EQ(3, loader.getImageSize());
+    EXPECT_FALSE(loader.getIsFloat());
+    EXPECT_FLOAT_EQ(0.25f, loader.getScale());
+
+    unsigned char data[3 * 18];
+    int labels[3];
+    loader.load(data, labels, 4, 3);
+    for(int n = 0; n < 3; n++) {
+        EXPECT_EQ(104 + n, labels[n]);
+        for(int i = 0; i < 18; i++) {
+            EXPECT_EQ((4 + n) * 10 + i, data[n * 18 + i]);
+        }
+    }
+    // views point straight into the file
+    EXPECT_EQ(21, loader.getRecord(2)[1]);
+    EXPECT_EQ(106, loader.getLabels()[6]);
+
+    float floats[3 * 18];
+    loader.load(floats, 0, 1, 3);
+    EXPECT_FLOAT_EQ(27.0f, floats[17]);
+    EXPECT_FLOAT_EQ(30.0f, floats[2 * 18]);
+
+    EXPECT_THROW(loader.load(data, labels, 5, 3), runtime_error);
+}
+
+TEST(testPackedLoader, float) {
+    writePacked("~packedf.dat", 5, true, false);
+    PackedLoader loader("~packedf.dat");
+    EXPECT_TRUE(loader.getIsFloat());
+    float data[2 * 18];
+    int labels[2];
+    loader.load(data, labels, 3, 2);
+    EXPECT_EQ(103, labels[0]);
+    EXPECT_FLOAT_EQ(30.5f, data[0]);
+    EXPECT_FLOAT_EQ(47.5f, data[18 + 7]);
+    EXPECT_FLOAT_EQ(12.5f, loader.getFloatRecord(1)[2]);
+
+    // float files cant be squashed into uchars
+    unsigned char ucData[18];
+    EXPECT_THROW(loader.load(ucData, 0, 0, 1), runtime_error);
+}
+
+TEST(testPackedLoader, truncated) {
+    writePacked("~packedt.dat", 5, false, true);
+    EXPECT_THROW(PackedLoader loader("~packedt.dat"), runtime_error);
+}
+
+TEST(testPackedLoader, genericloaderdetects) {
+    writePacked("~packedg.dat", 4, false, false);
+    GenericLoaderv2 loader("~packedg.dat");
+    EXPECT_EQ(4, loader.getN());
+    EXPECT_EQ(2, loader.getPlanes());
+    float data[4 * 18];
+    int labels[4];
+    loader.load(data, labels, 0, 4);
+    EXPECT_EQ(103, labels[3]);
+    EXPECT_FLOAT_EQ(35.0f, data[3 * 18 + 5]);
+}
+
+
+// just enough of a net for OnDemandBatcherv2: 2x3x3 input, no loss, nothing right
+class FakeNet : public Trainable {
+public:
+    int getOutputNumElements() const { return 0; }
+    float calcLoss(float const *expectedValues) { return 0; }
+    float calcLossFromLabels(int const *labels) { return 0; }
+    void setBatchSize(int batchSize) {}
+    void setTraining(bool training) {}
+    int calcNumRight(int const *labels) { return 0; }
+    void forward(float const*images) {}
+    void forward(unsigned char const*images) {}
+    void backwardFromLabels(int const *labels) {}
+    void backward(float const *expectedOutput) {}
+    float const *getOutput() const { return 0; }
+    LossLayerMaker *cloneLossLayerMaker() const { return 0; }
+    int getOutputPlanes() const { return 1; }
+    int getOutputSize() const { return 1; }
+    int getInputCubeSize() const { return 18; }
+    int getOutputCubeSize() const { return 1; }
+};
+
+// keeps the label, first and last value of the first example of each batch; the
+// uint8 run is left throwing, so the test fails if floats went the uint8 way
+class RecordingAction : public NetAction {
+public:
+    vector<int> labels;
+    vector<float> firstValues;
+    vector<float> lastValues;
+    BatchResult run(Trainable *net, int epoch, int batch, float const*const batchData, int const*const batchLabels) {
+        labels.push_back(batchLabels[0]);
+        firstValues.push_back(batchData[0]);
+        lastValues.push_back(batchData[17]);
+        return BatchResult();
+    }
+};
+
+// a normalized float packed file goes through the on-demand training path as floats
+TEST(testPackedLoader, onDemandFloats) {
+    writePacked("~packedod.dat", 7, true, false);
+    GenericLoaderv2 loader("~packedod.dat");
+    EXPECT_TRUE(loader.getIsFloat());
+    FakeNet net;
+    for(int queueDepth = 1; queueDepth <= 2; queueDepth++) {
+        for(int blocksPerPool = 0; blocksPerPool <= 2; blocksPerPool += 2) {
+            RecordingAction action;
+            OnDemandBatcherv2 batcher(&net, &action, &loader, 7, 2, 2);
+            batcher.setQueueDepth(queueDepth);
+            batcher.setShuffle(blocksPerPool, 1);
+            EXPECT_EQ(18 * 4, batcher.getExampleBytes());
+            batcher.run(0);
+            ASSERT_EQ(4, (int)action.labels.size());
+            for(int i = 0; i < 4; i++) {
+                int n = action.labels[i] - 100;
+                EXPECT_FLOAT_EQ(n * 10 + 0.5f, action.firstValues[i]);
+                EXPECT_FLOAT_EQ(n * 10 + 17.5f, action.lastValues[i]);
+            }
+            if(blocksPerPool == 0) {
+                EXPECT_EQ(100, action.labels[0]);
+                EXPECT_EQ(106, action.labels[3]);
+            }
+        }
+    }
+    FileHelper::remove("~packedod.dat");
+}
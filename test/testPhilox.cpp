@@ -0,0 +1,57 @@
+// Copyright Hugh Perkins 2015 hughperkins at gmail
+//
+// This Source Code Form is subject to the terms of the Mozilla Public License, 
+// v. 2.0. If a copy of the MPL was not distributed with this file, You can 
+// obtain one at http://mozilla.org/MPL/2.0/.
+
+#include <iostream>
+
+#include "util/Philox.h"
+
+#include "gtest/gtest.h"
+
+using namespace std;
+
+// known answers, from the Random123 philox4x32-10 test vectors
+TEST(testPhilox, knownanswers) {
+    unsigned int result[4];
+
+    unsigned int counter0[] = { 0, 0, 0, 0 };
+    unsigned int key0[] = { 0, 0 };
+    Philox::philox4x32_10(counter0, key0, result);
+    EXPECT_EQ(0x6627e8d5u, result[0]);
+    EXPECT_EQ(0xe169c58du, result[1]);
+    EXPECT_EQ(0xbc57ac4cu, result[2]);
+    EXPECT_EQ(0x9b00dbd8u, result[3]);
+
+    unsigned int counter1[] = { 0xffffffffu, 0xffffffffu, 0xffffffffu, 0xffffffffu };
+    unsigned int key1[] = { 0xffffffffu, 0xffffffffu };
+    Philox::philox4x32_10(counter1, key1, result);
+    EXPECT_EQ(0x408f276du, result[0]);
+    EXPECT_EQ(0x41c83b0eu, result[1]);
+    EXPECT_EQ(0xa20bc7c6u, result[2]);
+    EXPECT_EQ(0x6d5451fdu, result[3]);
+
+    unsigned int counter2[] = { 0x243f6a88u, 0x85a308d3u, 0x13198a2eu, 0x03707344u };
+    unsigned int key2[] = { 0xa4093822u, 0x299f31d0u };
+    Philox::philox4x32_10(counter2, key2, result);
+    EXPECT_EQ(0xd16cfe09u, result[0]);
+    EXPECT_EQ(0x94fdccebu, result[1]);
+    EXPECT_EQ(0x5001e420u, result[2]);
+    EXPECT_EQ(0x24126ea1u, result[3]);
+}
+
+TEST(testPhilox, uniform) {
+    int N = 10000;
+    double sum = 0;
+    for(int i = 0; i < N; i++) {
+        float value = Philox::uniform(i, 123, 456);
+        EXPECT_LE(0.0f, value);
+        EXPECT_GT(1.0f, value);
+        EXPECT_EQ(value, Philox::uniform(i, 123, 456));
+        sum += value;
+    }
+    EXPECT_NEAR(0.5, sum / N, 0.01);
+    EXPECT_NE(Philox::uniform(0, 123, 456), Philox::uniform(0, 123, 457));
+}
+
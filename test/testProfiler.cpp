@@ -0,0 +1,166 @@
+// Copyright Hugh Perkins 2015 hughperkins at gmail
+//
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file, You can
+// obtain one at http://mozilla.org/MPL/2.0/.
+
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <map>
+#include <cstdlib>
+#include <thread>
+#include <vector>
+
+#include "util/Profiler.h"
+#include "util/ProfileScope.h"
+#include "util/FileHelper.h"
+#include "util/stringhelper.h"
+
+#include "gtest/gtest.h"
+
+using namespace std;
+
+TEST(testProfiler, disabledRecordsNothing) {
+    Profiler::setEnabled(false);
+    Profiler::clear();
+    long long before = Profiler::getNumRecorded();
+    {
+        ProfileScope profile(0, Profiler::FORWARD, 0, 2);
+        EXPECT_EQ(2, Profiler::getCurrentLayer());
+        EXPECT_EQ("layer2 ", Profiler::layerPrefix());
+    }
+    EXPECT_EQ(-1, Profiler::getCurrentLayer());
+    EXPECT_EQ("", Profiler::layerPrefix());
+    EXPECT_EQ(before, Profiler::getNumRecorded());
+}
+
+class SummaryRow {
+public:
+    string name;
+    int calls;
+};
+
+// the per-layer rows of Profiler::getSummary, keyed by "layer phase"
+map<string, SummaryRow> parseSummaryRows(string summary) {
+    map<string, SummaryRow> rows;
+    istringstream lines(summary);
+    string line;
+    getline(lines, line); // span count
+    getline(lines, line); // column headings
+    while(getline(lines, line)) {
+        istringstream tokens(line);
+        vector<string> fields;
+        string field;
+        while(tokens >> field) {
+            fields.push_back(field);
+        }
+        // layer [name] phase calls hostms devicems; totals have no calls
+        if(fields.size() < 5 || fields[0] == "total") {
+            continue;
+        }
+        int numFields = (int)fields.size();
+        SummaryRow row;
+        row.name = numFields == 6 ? fields[1] : "";
+        row.calls = atoi(fields[numFields - 3].c_str());
+        rows[fields[0] + " " + fields[numFields - 4]] = row;
+    }
+    return rows;
+}
+
+TEST(testProfiler, recordsFromSeveralThreads) {
+    Profiler::setEnabled(true);
+    Profiler::clear();
+    long long before = Profiler::getNumRecorded();
+    const int numThreads = 4;
+    const int numIts = 100;
+    vector<thread> threads;
+    vector<int> wrongLayer(numThreads, 0);
+    int net = 0; // stands in for a net, only its address is used
+    for(int t = 0; t < numThreads; t++) {
+        threads.push_back(thread([t, &wrongLayer, &net]() {
+            for(int it = 0; it < numIts; it++) {
+                ProfileScope forward(0, Profiler::FORWARD, &net, t + 1);
+                {
+                    // io isnt in a layer, so the current layer stays as it is
+                    ProfileScope io(0, Profiler::IO, 0, -1);
+                    if(Profiler::getCurrentLayer() != t + 1) {
+                        wrongLayer[t]++;
+                    }
+                }
+            }
+        }));
+    }
+    for(int t = 0; t < numThreads; t++) {
+        threads[t].join();
+        EXPECT_EQ(0, wrongLayer[t]);
+    }
+    Profiler::setEnabled(false);
+    EXPECT_EQ(before + numThreads * numIts * 2, Profiler::getNumRecorded());
+
+    Profiler::setLayerName(&net, 1, "ConvolutionalLayer");
+    string summary = Profiler::getSummary(true);
+    // one forward row per thread's layer, and one io row, outside any layer
+    map<string, SummaryRow> rows = parseSummaryRows(summary);
+    EXPECT_EQ(numThreads + 1, (int)rows.size());
+    for(int t = 0; t < numThreads; t++) {
+        string key = toString(t + 1) + " forward";
+        ASSERT_EQ(1, (int)rows.count(key)) << summary;
+        EXPECT_EQ(numIts, rows[key].calls);
+        EXPECT_EQ(t == 0 ? "ConvolutionalLayer" : "", rows[key].name);
+    }
+    ASSERT_EQ(1, (int)rows.count("- io")) << summary;
+    EXPECT_EQ(numThreads * numIts, rows["- io"].calls);
+    // reset, so the next summary is empty
+    summary = Profiler::getSummary(false);
+    EXPECT_EQ(string::npos, summary.find("ConvolutionalLayer"));
+}
+
+TEST(testProfiler, writesChromeTrace) {
+    Profiler::setEnabled(true);
+    Profiler::clear();
+    {
+        ProfileScope profile(0, Profiler::UPDATE, 0, 3);
+    }
+    Profiler::setEnabled(false);
+    string filepath = "testProfiler.json";
+    Profiler::writeChromeTrace(filepath);
+    ifstream f(filepath);
+    ASSERT_TRUE(f.good());
+    stringstream contents;
+    contents << f.rdbuf();
+    string trace = contents.str();
+    EXPECT_EQ('{', trace[0]);
+    EXPECT_NE(string::npos, trace.find("\"traceEvents\""));
+    EXPECT_NE(string::npos, trace.find("\"layer3 update\""));
+    EXPECT_NE(string::npos, trace.find("\"ph\": \"X\""));
+    // spans from before the clear arent written
+    EXPECT_EQ(string::npos, trace.find("\"layer1 forward\""));
+    f.close();
+    FileHelper::remove(filepath);
+}
+
+TEST(testProfiler, layerNamesPerNet) {
+    // eg a NeuralNet, and a QuantizedNet built from it, both have a layer 1
+    int floatNet = 0;
+    int quantizedNet = 0;
+    Profiler::setLayerName(&floatNet, 1, "ConvolutionalLayer");
+    Profiler::setLayerName(&quantizedNet, 1, "int8 conv");
+    EXPECT_EQ("ConvolutionalLayer", Profiler::getLayerName(&floatNet, 1));
+    EXPECT_EQ("int8 conv", Profiler::getLayerName(&quantizedNet, 1));
+    EXPECT_EQ("", Profiler::getLayerName(&floatNet, 2));
+
+    Profiler::setEnabled(true);
+    Profiler::clear();
+    {
+        ProfileScope profile(0, Profiler::FORWARD, &floatNet, 1);
+    }
+    {
+        ProfileScope profile(0, Profiler::FORWARD, &quantizedNet, 1);
+    }
+    Profiler::setEnabled(false);
+    string summary = Profiler::getSummary(true);
+    EXPECT_NE(string::npos, summary.find("ConvolutionalLayer"));
+    EXPECT_NE(string::npos, summary.find("int8 conv"));
+}
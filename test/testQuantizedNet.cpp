@@ -0,0 +1,98 @@
+// Copyright Hugh Perkins 2015 hughperkins at gmail
+//
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file, You can
+// obtain one at http://mozilla.org/MPL/2.0/.
+
+#include <iostream>
+#include <cstdio>
+
+#include "EasyCL.h"
+#include "net/NeuralNet.h"
+#include "layer/Layer.h"
+#include "layer/LayerMakers.h"
+#include "weights/WeightsPersister.h"
+#include "quantize/ActivationCalibrator.h"
+#include "quantize/QuantizedNet.h"
+#include "quantize/QuantizationReport.h"
+
+#include "gtest/gtest.h"
+#include "test/gtest_supp.h"
+#include "test/NetTestHelper.h"
+#include "test/WeightRandomizer.h"
+
+using namespace std;
+
+namespace testQuantizedNet {
+
+NeuralNet *makeNet(EasyCL *cl) {
+    NeuralNet *net = new NeuralNet(cl, 2, 8);
+    net->addLayer(NormalizationLayerMaker::instance()->translate(-0.5f)->scale(2.0f));
+    NetTestHelper::addLayers(net, "6c3z-relu-mp2-5n");
+    return net;
+}
+
+// quantized outputs should stay close to the float ones, and survive a save
+// and load unchanged
+TEST(testQuantizedNet, matches_float_net) {
+    EasyCL *cl = DeepCLGtestGlobals_createEasyCL();
+    NeuralNet *net = makeNet(cl);
+    int numWeights = WeightsPersister::getTotalNumWeights(net);
+    float *weights = new float[numWeights];
+    WeightRandomizer::randomize(0, weights, numWeights, -0.5f, 0.5f);
+    WeightsPersister::copyArrayToNetWeights(weights, net);
+    delete[] weights;
+
+    const int batchSize = 16;
+    float *input = new float[batchSize * net->getInputCubeSize()];
+    WeightRandomizer::randomize(1, input, batchSize * net->getInputCubeSize(), 0.0f, 1.0f);
+    net->setBatchSize(batchSize);
+    net->setTraining(false);
+    net->forward(input);
+    ActivationCalibrator calibrator;
+    calibrator.observe(net, batchSize);
+    EXPECT_EQ(batchSize, calibrator.getNumExamples());
+
+    QuantizedNet *quantized = QuantizedNet::quantize(net, &calibrator);
+    EXPECT_EQ(net->getNumLayers() - 1, quantized->getNumLayers());
+    EXPECT_EQ(net->getLastLayer()->getOutputCubeSize(), quantized->getOutputCubeSize());
+    EXPECT_GT(numWeights * 4, quantized->getWeightsBytes() * 3);
+
+    const int outputCubeSize = quantized->getOutputCubeSize();
+    float const*floatOutput = net->getOutput();
+    float const*quantizedOutput = quantized->forward(batchSize, input);
+    QuantizationReport report;
+    report.add(batchSize, outputCubeSize, floatOutput, quantizedOutput, 0);
+    EXPECT_LT(report.getMaxAbsDiff(), 0.05f);
+    EXPECT_GE(report.getAgreement(), 0.8f);
+
+    quantized->save("testQuantizedNet.q8");
+    EXPECT_TRUE(QuantizedNet::isQuantizedFile("testQuantizedNet.q8"));
+    QuantizedNet *loaded = QuantizedNet::load("testQuantizedNet.q8");
+    remove("testQuantizedNet.q8");
+    float const*loadedOutput = loaded->forward(batchSize, input);
+    for(int i = 0; i < batchSize * outputCubeSize; i++) {
+        EXPECT_EQ(quantizedOutput[i], loadedOutput[i]);
+    }
+    int *labels = new int[batchSize];
+    loaded->getLabels(labels);
+    for(int n = 0; n < batchSize; n++) {
+        int best = 0;
+        for(int i = 1; i < outputCubeSize; i++) {
+            if(loadedOutput[n * outputCubeSize + i] > loadedOutput[n * outputCubeSize + best]) {
+                best = i;
+            }
+        }
+        EXPECT_EQ(best, labels[n]);
+    }
+
+    delete[] labels;
+    delete loaded;
+    delete quantized;
+    delete[] input;
+    delete net;
+    delete cl;
+}
+
+}
+
@@ -0,0 +1,95 @@
+// Copyright Hugh Perkins 2015 hughperkins at gmail
+//
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file, You can
+// obtain one at http://mozilla.org/MPL/2.0/.
+
+#include <iostream>
+
+#include "EasyCL.h"
+#include "net/NeuralNet.h"
+#include "net/NeuralNetMould.h"
+#include "layer/LayerMakers.h"
+#include "patches/RandomPatches.h"
+#include "patches/RandomTranslations.h"
+
+#include "gtest/gtest.h"
+#include "test/gtest_supp.h"
+
+using namespace std;
+
+namespace testRandomPatches {
+
+float *makeInput(int numElements) {
+    float *input = new float[numElements];
+    for(int i = 0; i < numElements; i++) {
+        input[i] = (i % 97) * 0.25f - 3.0f;
+    }
+    return input;
+}
+
+// the offsets come only from the seeds, so device and host should give identical output
+TEST(testRandomPatches, device_same_as_host) {
+    const int batchSize = 5;
+    const int numPlanes = 3;
+    const int imageSize = 11;
+    const int patchSize = 7;
+    EasyCL *cl = DeepCLGtestGlobals_createEasyCL();
+    NeuralNet *net = NeuralNet::maker(cl)->instance();
+    net->addLayer(InputLayerMaker::instance()->numPlanes(numPlanes)->imageSize(imageSize));
+    net->addLayer(RandomPatchesMaker::instance()->patchSize(patchSize));
+    net->setBatchSize(batchSize);
+    float *input = makeInput(batchSize * numPlanes * imageSize * imageSize);
+    RandomPatches *layer = dynamic_cast<RandomPatches *>(net->getLayer(1));
+    EXPECT_TRUE(layer->hasOutputWrapper());
+    const int outputNumElements = batchSize * numPlanes * patchSize * patchSize;
+    float *hostOutput = new float[outputNumElements];
+    for(int training = 0; training <= 1; training++) {
+        net->setTraining(training == 1);
+        net->forward(input);
+        layer->forward(12345u, 67890u);
+        layer->forwardHost(12345u, 67890u, input, hostOutput);
+        float const*output = layer->getOutput();
+        for(int i = 0; i < outputNumElements; i++) {
+            EXPECT_EQ(hostOutput[i], output[i]);
+        }
+    }
+    delete[] hostOutput;
+    delete[] input;
+    delete net;
+    delete cl;
+}
+
+TEST(testRandomTranslations, device_same_as_host) {
+    const int batchSize = 5;
+    const int numPlanes = 3;
+    const int imageSize = 11;
+    const int translateSize = 3;
+    EasyCL *cl = DeepCLGtestGlobals_createEasyCL();
+    NeuralNet *net = NeuralNet::maker(cl)->instance();
+    net->addLayer(InputLayerMaker::instance()->numPlanes(numPlanes)->imageSize(imageSize));
+    net->addLayer(RandomTranslationsMaker::instance()->translateSize(translateSize));
+    net->setBatchSize(batchSize);
+    const int numElements = batchSize * numPlanes * imageSize * imageSize;
+    float *input = makeInput(numElements);
+    RandomTranslations *layer = dynamic_cast<RandomTranslations *>(net->getLayer(1));
+    EXPECT_TRUE(layer->hasOutputWrapper());
+    float *hostOutput = new float[numElements];
+    for(int training = 0; training <= 1; training++) {
+        net->setTraining(training == 1);
+        net->forward(input);
+        layer->forward(12345u, 67890u);
+        layer->forwardHost(12345u, 67890u, input, hostOutput);
+        float const*output = layer->getOutput();
+        for(int i = 0; i < numElements; i++) {
+            EXPECT_EQ(hostOutput[i], output[i]);
+        }
+    }
+    delete[] hostOutput;
+    delete[] input;
+    delete net;
+    delete cl;
+}
+
+}
+
@@ -0,0 +1,122 @@
+// Copyright Hugh Perkins 2015 hughperkins at gmail
+//
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file, You can
+// obtain one at http://mozilla.org/MPL/2.0/.
+
+#include <iostream>
+#include <cmath>
+#include <algorithm>
+
+#include "EasyCL.h"
+#include "net/NeuralNet.h"
+#include "net/NeuralNetMould.h"
+#include "layer/LayerMakers.h"
+#include "loss/SoftMaxLayer.h"
+#include "util/stringhelper.h"
+
+#include "test/gtest_supp.h"
+
+using namespace std;
+
+// checks forward, loss, num-right, gradInput and getLabels against a straightforward host
+// version.  Each softmax is over count values, spaced stride apart, starting at
+// (group / inner) * count * inner + group % inner
+static void checkSoftMax(bool perPlane) {
+    const int batchSize = 5;
+    const int numPlanes = 4;
+    const int imageSize = 3;
+    const int imageSizeSquared = imageSize * imageSize;
+    EasyCL *cl = DeepCLGtestGlobals_createEasyCL();
+    NeuralNet *net = NeuralNet::maker(cl)->instance();
+    net->addLayer(InputLayerMaker::instance()->numPlanes(numPlanes)->imageSize(imageSize));
+    if(perPlane) {
+        net->addLayer(SoftMaxMaker::instance()->perPlane());
+    } else {
+        net->addLayer(SoftMaxMaker::instance()->perColumn());
+    }
+    net->setBatchSize(batchSize);
+    SoftMaxLayer *layer = dynamic_cast<SoftMaxLayer *>(net->getLayer(1));
+
+    const int count = perPlane ? imageSizeSquared : numPlanes;
+    const int inner = perPlane ? 1 : imageSizeSquared;
+    const int numGroups = batchSize * (perPlane ? numPlanes : imageSizeSquared);
+    EXPECT_EQ(numGroups / batchSize, layer->getNumLabelsPerExample());
+    const int numElements = batchSize * numPlanes * imageSizeSquared;
+    float *input = new float[numElements];
+    for(int i = 0; i < numElements; i++) {
+        input[i] = (float)((i * 37) % 23) / 5.0f - 2.0f;
+    }
+    int *labels = new int[numGroups];
+    for(int g = 0; g < numGroups; g++) {
+        labels[g] = (g * 7) % count;
+    }
+    float *expectedOutput = new float[numElements];
+    float *expectedGradInput = new float[numElements];
+    float expectedLoss = 0;
+    int expectedNumRight = 0;
+    int *expectedLabels = new int[numGroups];
+    for(int g = 0; g < numGroups; g++) {
+        int base = (g / inner) * count * inner + g % inner;
+        float maxValue = input[base];
+        for(int i = 1; i < count; i++) {
+            maxValue = std::max(maxValue, input[base + i * inner]);
+        }
+        float sum = 0;
+        for(int i = 0; i < count; i++) {
+            sum += exp(input[base + i * inner] - maxValue);
+        }
+        int iMax = 0;
+        for(int i = 0; i < count; i++) {
+            float value = exp(input[base + i * inner] - maxValue) / sum;
+            expectedOutput[base + i * inner] = value;
+            expectedGradInput[base + i * inner] = i == labels[g] ? value - 1.0f : value;
+            if(value > expectedOutput[base + iMax * inner]) {
+                iMax = i;
+            }
+        }
+        expectedLabels[g] = iMax;
+        expectedLoss += - log(expectedOutput[base + labels[g] * inner]);
+        if(iMax == labels[g]) {
+            expectedNumRight++;
+        }
+    }
+
+    net->forward(input);
+    float const*output = layer->getOutput();
+    for(int i = 0; i < numElements; i++) {
+        EXPECT_FLOAT_NEAR(expectedOutput[i], output[i]);
+    }
+    EXPECT_FLOAT_NEAR(expectedLoss, layer->calcLossFromLabels(labels));
+    EXPECT_EQ(expectedNumRight, layer->calcNumRightFromLabels(labels));
+    layer->calcGradInputFromLabels(labels);
+    float const*gradInput = layer->getGradInput();
+    for(int i = 0; i < numElements; i++) {
+        EXPECT_FLOAT_NEAR(expectedGradInput[i], gradInput[i]);
+    }
+    int *deviceLabels = new int[numGroups];
+    layer->getLabels(deviceLabels);
+    for(int g = 0; g < numGroups; g++) {
+        EXPECT_EQ(expectedLabels[g], deviceLabels[g]);
+    }
+    labels[0] = count;
+    EXPECT_THROW(layer->calcLossFromLabels(labels), runtime_error);
+
+    delete[] deviceLabels;
+    delete[] expectedLabels;
+    delete[] expectedGradInput;
+    delete[] expectedOutput;
+    delete[] labels;
+    delete[] input;
+    delete net;
+    delete cl;
+}
+
+TEST(testSoftMaxLayer, perplane) {
+    checkSoftMax(true);
+}
+
+TEST(testSoftMaxLayer, percolumn_imagesize3) {
+    checkSoftMax(false);
+}
+
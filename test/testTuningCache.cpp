@@ -0,0 +1,83 @@
+// Copyright Hugh Perkins 2015 hughperkins at gmail
+//
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file, You can
+// obtain one at http://mozilla.org/MPL/2.0/.
+
+#include <iostream>
+#include <thread>
+using namespace std;
+
+#include "util/FileHelper.h"
+#include "conv/TuningCache.h"
+#include "util/stringhelper.h"
+
+#include "gtest/gtest.h"
+
+TEST(testTuningCache, storeandreload) {
+    FileHelper::setCacheDirectory("testtuningcache");
+    TuningCache first;
+    first.clear();
+    int index = -1;
+    int milliseconds = -1;
+    EXPECT_FALSE(first.lookup("forward foo", &index, &milliseconds));
+    first.store("forward foo", 3, 12);
+    EXPECT_TRUE(first.lookup("forward foo", &index, &milliseconds));
+    EXPECT_EQ(3, index);
+    EXPECT_EQ(12, milliseconds);
+
+    // as though another process wrote an entry meanwhile
+    TuningCache second;
+    second.store("backward bar", 5, 7);
+
+    // a new process sees both
+    TuningCache third;
+    EXPECT_TRUE(third.lookup("forward foo", &index, &milliseconds));
+    EXPECT_EQ(3, index);
+    EXPECT_TRUE(third.lookup("backward bar", &index, &milliseconds));
+    EXPECT_EQ(5, index);
+    EXPECT_EQ(7, milliseconds);
+
+    // and first doesnt lose the other one, when it writes again
+    first.store("forward foo", 4, 10);
+    TuningCache fourth;
+    EXPECT_TRUE(fourth.lookup("backward bar", &index, &milliseconds));
+    EXPECT_TRUE(fourth.lookup("forward foo", &index, &milliseconds));
+    EXPECT_EQ(4, index);
+
+    fourth.setEnabled(false);
+    EXPECT_FALSE(fourth.lookup("forward foo", &index, &milliseconds));
+
+    first.clear();
+    FileHelper::setCacheDirectory("");
+}
+
+// two caches, as though in two processes, storing at the same time, dont lose each other's entries
+TEST(testTuningCache, concurrentStores) {
+    FileHelper::setCacheDirectory("testtuningcacheconcurrent");
+    TuningCache first;
+    first.clear();
+    TuningCache second;
+    thread firstThread([&first]() {
+        for(int i = 0; i < 50; i++) {
+            first.store("forward first" + toString(i), i, i);
+        }
+    });
+    thread secondThread([&second]() {
+        for(int i = 0; i < 50; i++) {
+            second.store("forward second" + toString(i), i, i);
+        }
+    });
+    firstThread.join();
+    secondThread.join();
+    TuningCache third;
+    int index = -1;
+    int milliseconds = -1;
+    for(int i = 0; i < 50; i++) {
+        EXPECT_TRUE(third.lookup("forward first" + toString(i), &index, &milliseconds));
+        EXPECT_TRUE(third.lookup("forward second" + toString(i), &index, &milliseconds));
+        EXPECT_EQ(i, index);
+    }
+    third.clear();
+    FileHelper::setCacheDirectory("");
+}
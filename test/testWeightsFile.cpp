@@ -0,0 +1,211 @@
+// Copyright Hugh Perkins 2015 hughperkins at gmail
+//
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file, You can
+// obtain one at http://mozilla.org/MPL/2.0/.
+
+#include <iostream>
+#include <vector>
+#include <cmath>
+#include <cstring>
+#include <stdexcept>
+
+#include "EasyCL.h"
+#include "net/NeuralNet.h"
+#include "layer/Layer.h"
+#include "layer/LayerMakers.h"
+#include "weights/WeightsPersister.h"
+#include "weights/WeightsFile.h"
+#include "util/FileHelper.h"
+
+#include "gtest/gtest.h"
+#include "test/gtest_supp.h"
+#include "test/NetTestHelper.h"
+
+using namespace std;
+
+namespace testWeightsFile {
+
+NeuralNet *makeNet(EasyCL *cl) {
+    return NetTestHelper::makeNet(cl, 1, 5, "2c3-3n");
+}
+
+vector<float> getWeights(NeuralNet *net) {
+    vector<float> weights(WeightsPersister::getTotalNumWeights(net));
+    WeightsPersister::copyNetWeightsToArray(net, &weights[0]);
+    return weights;
+}
+
+TEST(testWeightsFile, float32RoundTrip) {
+    EasyCL *cl = DeepCLGtestGlobals_createEasyCL();
+    NeuralNet *net = makeNet(cl);
+    vector<float> weights = getWeights(net);
+    string filepath = "testWeightsFile.dat";
+    WeightsPersister::persistWeights(filepath, "netdef=test", net, 3, 7, 0.5f, 11, 1.5f);
+
+    WeightsFile *file = new WeightsFile(filepath);
+    EXPECT_EQ(2, file->getNumEntries());
+    EXPECT_TRUE(file->getEntry(3) == 0); // softmax has no parameters
+    for(int layerIndex = 1; layerIndex <= 2; layerIndex++) {
+        WeightsFileEntry const*entry = file->getEntry(layerIndex);
+        ASSERT_TRUE(entry != 0);
+        EXPECT_EQ(WeightsFile::FLOAT32, entry->dtype);
+        EXPECT_EQ(0, entry->offset % WeightsFile::alignment);
+        EXPECT_EQ(net->getLayer(layerIndex)->getPersistSize(), entry->numElements);
+    }
+    delete file;
+
+    NeuralNet *loaded = makeNet(cl);
+    int epoch, batch, numRight;
+    float annealedLearningRate, loss;
+    EXPECT_TRUE(WeightsPersister::loadWeights(filepath, "netdef=test", loaded, &epoch, &batch, &annealedLearningRate, &numRight, &loss));
+    EXPECT_EQ(3, epoch);
+    EXPECT_EQ(7, batch);
+    EXPECT_EQ(11, numRight);
+    EXPECT_EQ(0.5f, annealedLearningRate);
+    EXPECT_EQ(1.5f, loss);
+    vector<float> loadedWeights = getWeights(loaded);
+    for(int i = 0; i < (int)weights.size(); i++) {
+        EXPECT_EQ(weights[i], loadedWeights[i]);
+    }
+    string configString;
+    EXPECT_TRUE(WeightsPersister::loadConfigString(filepath, configString));
+    EXPECT_EQ("test", configString);
+    EXPECT_FALSE(WeightsPersister::loadWeights(filepath, "netdef=other", loaded, &epoch, &batch, &annealedLearningRate, &numRight, &loss));
+    FileHelper::remove(filepath);
+
+    delete loaded;
+    delete net;
+    delete cl;
+}
+
+TEST(testWeightsFile, float16) {
+    EasyCL *cl = DeepCLGtestGlobals_createEasyCL();
+    NeuralNet *net = makeNet(cl);
+    vector<float> weights = getWeights(net);
+    string filepath = "testWeightsFile16.dat";
+    WeightsPersister::persistWeights(filepath, "netdef=test", net, 0, 0, 0, 0, 0, WeightsFile::FLOAT16);
+    EXPECT_EQ(WeightsPersister::getPersistArraySize(net, WeightsFile::FLOAT16), FileHelper::getFilesize(filepath));
+
+    NeuralNet *loaded = makeNet(cl);
+    int epoch, batch, numRight;
+    float annealedLearningRate, loss;
+    EXPECT_TRUE(WeightsPersister::loadWeights(filepath, "netdef=test", loaded, &epoch, &batch, &annealedLearningRate, &numRight, &loss));
+    vector<float> loadedWeights = getWeights(loaded);
+    for(int i = 0; i < (int)weights.size(); i++) {
+        EXPECT_NEAR(weights[i], loadedWeights[i], fabs(weights[i]) / 1024.0f + 1e-7f);
+    }
+    FileHelper::remove(filepath);
+
+    // too large for fp16
+    vector<float> big(net->getLayer(1)->getPersistSize(), 100000.0f);
+    net->getLayer(1)->unpersistFromArray(&big[0]);
+    EXPECT_THROW(WeightsPersister::persistWeights(filepath, "netdef=test", net, 0, 0, 0, 0, 0, WeightsFile::FLOAT16), runtime_error);
+    EXPECT_FALSE(FileHelper::exists(filepath));
+
+    delete loaded;
+    delete net;
+    delete cl;
+}
+
+TEST(testWeightsFile, readOneLayer) {
+    EasyCL *cl = DeepCLGtestGlobals_createEasyCL();
+    NeuralNet *net = makeNet(cl);
+    string filepath = "testWeightsFileLayer.dat";
+    WeightsPersister::persistWeights(filepath, "netdef=test", net, 0, 0, 0, 0, 0);
+
+    WeightsFile file(filepath);
+    int persistSize = net->getLayer(2)->getPersistSize();
+    vector<float> expected(persistSize);
+    net->getLayer(2)->persistToArray(&expected[0]);
+    vector<float> values(persistSize);
+    file.readLayer(2, &values[0]);
+    for(int i = 0; i < persistSize; i++) {
+        EXPECT_EQ(expected[i], values[i]);
+    }
+
+    // only layer 2 changes
+    NeuralNet *loaded = makeNet(cl);
+    vector<float> before = getWeights(loaded);
+    file.loadLayer(loaded, 2);
+    vector<float> after = getWeights(loaded);
+    int layer2Offset = WeightsPersister::getArrayOffsetForLayer(loaded, 2);
+    for(int i = 0; i < (int)after.size(); i++) {
+        if(i >= layer2Offset && i < layer2Offset + persistSize) {
+            EXPECT_EQ(expected[i - layer2Offset], after[i]);
+        } else {
+            EXPECT_EQ(before[i], after[i]);
+        }
+    }
+    EXPECT_THROW(file.readLayer(3, &values[0]), runtime_error);
+    FileHelper::remove(filepath);
+
+    delete loaded;
+    delete net;
+    delete cl;
+}
+
+TEST(testWeightsFile, corruptLayerThrows) {
+    EasyCL *cl = DeepCLGtestGlobals_createEasyCL();
+    NeuralNet *net = makeNet(cl);
+    string filepath = "testWeightsFileCorrupt.dat";
+    WeightsPersister::persistWeights(filepath, "netdef=test", net, 0, 0, 0, 0, 0);
+    long fileSize;
+    char *data = FileHelper::readBinary(filepath, &fileSize);
+    long offset;
+    {
+        WeightsFile file(filepath);
+        offset = (long)file.getEntry(2)->offset;
+    }
+    data[offset + 1] ^= 0x10;
+    FileHelper::writeBinary(filepath, data, fileSize);
+    delete[] data;
+
+    WeightsFile file(filepath);
+    EXPECT_NO_THROW(file.verifyLayer(1));
+    EXPECT_THROW(file.verifyLayer(2), runtime_error);
+    int epoch, batch, numRight;
+    float annealedLearningRate, loss;
+    EXPECT_THROW(WeightsPersister::loadWeights(filepath, "netdef=test", net, &epoch, &batch, &annealedLearningRate, &numRight, &loss), runtime_error);
+    FileHelper::remove(filepath);
+
+    delete net;
+    delete cl;
+}
+
+// version 3: the same 1024 byte header, then all the layers' floats, unaligned
+TEST(testWeightsFile, loadsVersion3) {
+    EasyCL *cl = DeepCLGtestGlobals_createEasyCL();
+    NeuralNet *net = makeNet(cl);
+    vector<float> weights = getWeights(net);
+    long fileSize = 1024 + weights.size() * sizeof(float);
+    vector<char> data(fileSize, 0);
+    memcpy(&data[0], "ClCn", 4);
+    int header[4] = { 3, 4, 5, 6 };
+    memcpy(&data[4], header, 4 * sizeof(int));
+    strcpy(&data[28], "netdef=test");
+    memcpy(&data[1024], &weights[0], weights.size() * sizeof(float));
+    string filepath = "testWeightsFilev3.dat";
+    FileHelper::writeBinary(filepath, &data[0], fileSize);
+
+    NeuralNet *loaded = makeNet(cl);
+    int epoch, batch, numRight;
+    float annealedLearningRate, loss;
+    EXPECT_FALSE(WeightsFile::isIndexed(filepath));
+    EXPECT_TRUE(WeightsPersister::loadWeights(filepath, "netdef=test", loaded, &epoch, &batch, &annealedLearningRate, &numRight, &loss));
+    EXPECT_EQ(4, epoch);
+    EXPECT_EQ(5, batch);
+    EXPECT_EQ(6, numRight);
+    vector<float> loadedWeights = getWeights(loaded);
+    for(int i = 0; i < (int)weights.size(); i++) {
+        EXPECT_EQ(weights[i], loadedWeights[i]);
+    }
+    FileHelper::remove(filepath);
+
+    delete loaded;
+    delete net;
+    delete cl;
+}
+
+}
+
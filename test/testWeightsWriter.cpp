@@ -0,0 +1,112 @@
+// Copyright Hugh Perkins 2015 hughperkins at gmail
+//
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file, You can
+// obtain one at http://mozilla.org/MPL/2.0/.
+
+#include <iostream>
+#include <vector>
+#include <stdexcept>
+
+#include "EasyCL.h"
+#include "net/NeuralNet.h"
+#include "layer/LayerMakers.h"
+#include "weights/WeightsPersister.h"
+#include "weights/WeightsWriter.h"
+#include "util/FileHelper.h"
+
+#include "gtest/gtest.h"
+#include "test/gtest_supp.h"
+#include "test/NetTestHelper.h"
+#include "test/WeightRandomizer.h"
+
+using namespace std;
+
+namespace testWeightsWriter {
+
+NeuralNet *makeNet(EasyCL *cl) {
+    return NetTestHelper::makeNet(cl, 1, 5, "2c3-3n");
+}
+
+// the snapshot is a copy: changing the weights afterwards doesnt change the file
+TEST(testWeightsWriter, writesSnapshot) {
+    EasyCL *cl = DeepCLGtestGlobals_createEasyCL();
+    NeuralNet *net = makeNet(cl);
+    int numWeights = WeightsPersister::getTotalNumWeights(net);
+    vector<float> weights(numWeights);
+    WeightsPersister::copyNetWeightsToArray(net, &weights[0]);
+
+    string filepath = "testWeightsWriter.dat";
+    WeightsWriter *writer = new WeightsWriter();
+    writer->snapshot(filepath, "netdef=test", net, 3, 7, 0.5f, 11, 1.5f);
+    vector<float> otherWeights(numWeights);
+    WeightRandomizer::randomize(&otherWeights[0], numWeights, -1.0f, 1.0f);
+    WeightsPersister::copyArrayToNetWeights(&otherWeights[0], net);
+    writer->flush();
+    EXPECT_EQ(1, writer->getNumSnapshots());
+    EXPECT_LE(0, writer->getLastStallMilliseconds());
+    EXPECT_LE(writer->getLastStallMilliseconds(), writer->getTotalStallMilliseconds());
+    string stats = writer->getStatsString();
+    EXPECT_EQ(0u, stats.find("weights snapshots: 1, ")) << stats;
+    EXPECT_NE(string::npos, stats.find("ms per snapshot")) << stats;
+    delete writer;
+
+    NeuralNet *loaded = makeNet(cl);
+    int epoch, batch, numRight;
+    float annealedLearningRate, loss;
+    EXPECT_TRUE(WeightsPersister::loadWeights(filepath, "netdef=test", loaded, &epoch, &batch, &annealedLearningRate, &numRight, &loss));
+    EXPECT_EQ(3, epoch);
+    EXPECT_EQ(7, batch);
+    EXPECT_EQ(11, numRight);
+    EXPECT_EQ(0.5f, annealedLearningRate);
+    EXPECT_EQ(1.5f, loss);
+    vector<float> loadedWeights(numWeights);
+    WeightsPersister::copyNetWeightsToArray(loaded, &loadedWeights[0]);
+    for(int i = 0; i < numWeights; i++) {
+        EXPECT_EQ(weights[i], loadedWeights[i]);
+    }
+    FileHelper::remove(filepath);
+
+    delete loaded;
+    delete net;
+    delete cl;
+}
+
+// a second snapshot waits for the first write, and the destructor finishes the last
+TEST(testWeightsWriter, lastSnapshotWins) {
+    EasyCL *cl = DeepCLGtestGlobals_createEasyCL();
+    NeuralNet *net = makeNet(cl);
+    string filepath = "testWeightsWriter2.dat";
+    WeightsWriter *writer = new WeightsWriter();
+    for(int epoch = 0; epoch < 3; epoch++) {
+        writer->snapshot(filepath, "netdef=test", net, epoch, 0, 0, 0, 0);
+    }
+    EXPECT_EQ(3, writer->getNumSnapshots());
+    delete writer;
+
+    int epoch, batch, numRight;
+    float annealedLearningRate, loss;
+    EXPECT_TRUE(WeightsPersister::loadWeights(filepath, "netdef=test", net, &epoch, &batch, &annealedLearningRate, &numRight, &loss));
+    EXPECT_EQ(2, epoch);
+    FileHelper::remove(filepath);
+
+    delete net;
+    delete cl;
+}
+
+TEST(testWeightsWriter, failedWriteThrows) {
+    EasyCL *cl = DeepCLGtestGlobals_createEasyCL();
+    NeuralNet *net = makeNet(cl);
+    WeightsWriter writer;
+    writer.snapshot("no/such/directory/weights.dat", "netdef=test", net, 0, 0, 0, 0, 0);
+    EXPECT_THROW(writer.flush(), runtime_error);
+    // and the writer still works afterwards
+    writer.snapshot("testWeightsWriter3.dat", "netdef=test", net, 0, 0, 0, 0, 0);
+    writer.flush();
+    EXPECT_TRUE(FileHelper::exists("testWeightsWriter3.dat"));
+    FileHelper::remove("testWeightsWriter3.dat");
+    delete net;
+    delete cl;
+}
+
+}
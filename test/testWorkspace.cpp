@@ -0,0 +1,81 @@
+// Copyright Hugh Perkins 2015 hughperkins at gmail
+//
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file, You can
+// obtain one at http://mozilla.org/MPL/2.0/.
+
+#include <iostream>
+
+#include "EasyCL.h"
+#include "util/Workspace.h"
+#include "util/WorkspaceScope.h"
+#include "clmath/CLMathWrapper.h"
+
+#include "gtest/gtest.h"
+#include "test/gtest_supp.h"
+
+using namespace std;
+
+TEST(testWorkspace, reuse) {
+    EasyCL *cl = DeepCLGtestGlobals_createEasyCL();
+    Workspace *workspace = Workspace::get(cl);
+    EXPECT_EQ(workspace, Workspace::get(cl));
+    CLWrapper *first = 0;
+    for(int it = 0; it < 4; it++) {
+        WorkspaceScope scope(cl);
+        CLWrapper *a = scope.acquire(1000);
+        {
+            // grows on the second pass only
+            WorkspaceScope inner(cl);
+            CLWrapper *b = inner.acquire(it == 0 ? 500 : 2000);
+            EXPECT_NE(a, b);
+            EXPECT_GE(b->size(), it == 0 ? 500 : 2000);
+        }
+        if(it == 0) {
+            first = a;
+        }
+        EXPECT_EQ(first, a);
+    }
+    EXPECT_EQ(0, workspace->getMark());
+    EXPECT_EQ(3, workspace->getNumAllocations());
+    EXPECT_EQ(1, workspace->getNumReallocations());
+    EXPECT_EQ(8, workspace->getNumAcquires());
+    EXPECT_EQ((1000 + 2000) * 4l, workspace->getPeakBytes());
+    EXPECT_EQ((1000 + 2000) * 4l, workspace->getAllocatedBytes());
+    EXPECT_EQ("workspace: 2 buffers, 11KB allocated, peak in use 11KB, 8 acquires, 3 allocations, 1 reallocations",
+        workspace->getStatsString());
+
+    Workspace::deleteFor(cl);
+    delete cl;
+}
+
+TEST(testWorkspace, mathOnPrefix) {
+    EasyCL *cl = DeepCLGtestGlobals_createEasyCL();
+    float adat[] = { 1, 3, 9, 12.5f, 2.5f };
+    CLWrapper *a_ = cl->wrap(5, adat);
+    a_->copyToDevice();
+    {
+        // grow the depth 0 buffer to 64 first, so the acquire(5) below gets it back
+        WorkspaceScope bigger(cl);
+        bigger.acquire(64);
+    }
+    {
+        WorkspaceScope workspace(cl);
+        CLWrapper *scratch_ = workspace.acquire(5);
+        EXPECT_GE(scratch_->size(), 64);
+        CLMathWrapper scratch(scratch_, 5);
+        CLMathWrapper a(a_);
+        scratch = a;
+        scratch *= 2.0f;
+        a += scratch;
+    }
+    a_->copyToHost();
+    EXPECT_FLOAT_NEAR(3.0f, adat[0]);
+    EXPECT_FLOAT_NEAR(37.5f, adat[3]);
+    EXPECT_FLOAT_NEAR(7.5f, adat[4]);
+
+    delete a_;
+    Workspace::deleteFor(cl);
+    delete cl;
+}
+
@@ -817,6 +817,36 @@ TEST(testbackward, compare_1_n_kgsgo_32c5) {
     }
 }
 
+// winograd gradInput, gpu and native, against the cpu
+TEST(testbackward, compare_0_n_winograd) {
+    int batchSize = 4;
+    LayerDimensions dim;
+    for(int filterSize = 3; filterSize <= 5; filterSize += 2) {
+        dim.setInputPlanes(8).setInputSize(13).setNumFilters(6).setFilterSize(filterSize)
+            .setPadZeros(false).setBiased(true);
+        for(int instance = 4; instance <= 5; instance++) {
+            compareSpecific(0, instance, 1, batchSize, dim);
+        }
+        dim.setPadZeros(true);
+        for(int instance = 4; instance <= 5; instance++) {
+            compareSpecific(0, instance, 1, batchSize, dim);
+        }
+    }
+}
+
+// fft gradInput, against the cpu
+TEST(testbackward, compare_0_6_fft) {
+    int batchSize = 4;
+    LayerDimensions dim;
+    for(int filterSize = 7; filterSize <= 9; filterSize += 2) {
+        dim.setInputPlanes(8).setInputSize(19).setNumFilters(6).setFilterSize(filterSize)
+            .setPadZeros(false).setBiased(true);
+        compareSpecific(0, 6, 1, batchSize, dim);
+        dim.setPadZeros(true);
+        compareSpecific(0, 6, 1, batchSize, dim);
+    }
+}
+
 TEST(SLOW_testbackward, compare_kgsgo_32c5mini) {
     int batchSize = 4;
     LayerDimensions dim;
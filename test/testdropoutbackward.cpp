@@ -179,6 +179,57 @@ TEST( testdropoutbackward, compare_args ) {
     delete cl;
 }
 
+TEST( testdropoutbackward, philox_samemasks_as_forward ) {
+    int batchSize = 4;
+    int numPlanes = 3;
+    int imageSize = 5;
+    float dropRatio = 0.6f;
+    EasyCL *cl = DeepCLGtestGlobals_createEasyCL();
+    DropoutForward *dropoutForward = DropoutForward::instanceSpecific( 1, cl, numPlanes, imageSize, dropRatio );
+    DropoutBackward *dropoutBackward0 = DropoutBackward::instanceSpecific( 0, cl, numPlanes, imageSize, dropRatio );
+    DropoutBackward *dropoutBackward1 = DropoutBackward::instanceSpecific( 1, cl, numPlanes, imageSize, dropRatio );
+
+    const int N = dropoutForward->getInputNumElements( batchSize );
+    float *gradOutput = new float[N];
+    float *forwardOutput = new float[N];
+    float *gradInput0 = new float[N];
+    float *gradInput1 = new float[N];
+    WeightRandomizer::randomize( gradOutput, N, 0.1f, 1.0f );
+    CLWrapper *gradOutputWrapper = cl->wrap( N, gradOutput );
+    CLWrapper *forwardOutputWrapper = cl->wrap( N, forwardOutput );
+    CLWrapper *gradInputWrapper0 = cl->wrap( N, gradInput0 );
+    CLWrapper *gradInputWrapper1 = cl->wrap( N, gradInput1 );
+    gradOutputWrapper->copyToDevice();
+    forwardOutputWrapper->createOnDevice();
+    gradInputWrapper0->createOnDevice();
+    gradInputWrapper1->createOnDevice();
+
+    // backward doesnt store masks, it regenerates the forward ones from the seeds
+    dropoutForward->forward( batchSize, 7u, 11u, gradOutputWrapper, forwardOutputWrapper );
+    dropoutBackward0->backward( batchSize, 7u, 11u, gradOutputWrapper, gradInputWrapper0 );
+    dropoutBackward1->backward( batchSize, 7u, 11u, gradOutputWrapper, gradInputWrapper1 );
+    forwardOutputWrapper->copyToHost();
+    gradInputWrapper0->copyToHost();
+    gradInputWrapper1->copyToHost();
+    for( int i = 0; i < N; i++ ) {
+        EXPECT_EQ( forwardOutput[i], gradInput0[i] );
+        EXPECT_EQ( forwardOutput[i], gradInput1[i] );
+    }
+
+    delete gradInputWrapper1;
+    delete gradInputWrapper0;
+    delete forwardOutputWrapper;
+    delete gradOutputWrapper;
+    delete[] gradInput1;
+    delete[] gradInput0;
+    delete[] forwardOutput;
+    delete[] gradOutput;
+    delete dropoutBackward1;
+    delete dropoutBackward0;
+    delete dropoutForward;
+    delete cl;
+}
+
 /*
 TEST( testdropoutforward, basic_2plane_batchsize2 ) {
     int batchSize = 2;
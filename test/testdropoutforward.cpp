@@ -388,3 +388,62 @@ TEST( testdropoutforward, comparespecific_0_1_dropout3_small2_tanh ) {
 
 }
 
+TEST( testdropoutforward, philox_0_1 ) {
+    int batchSize = 7;
+    int numPlanes = 3;
+    int imageSize = 5;
+    float dropRatio = 0.4f;
+    EasyCL *cl = DeepCLGtestGlobals_createEasyCL();
+    DropoutForward *dropoutForward0 = DropoutForward::instanceSpecific( 0, cl, numPlanes, imageSize, dropRatio );
+    DropoutForward *dropoutForward1 = DropoutForward::instanceSpecific( 1, cl, numPlanes, imageSize, dropRatio );
+
+    const int N = dropoutForward0->getInputNumElements( batchSize );
+    float *input = new float[N];
+    float *output0 = new float[N];
+    float *output1 = new float[N];
+    WeightRandomizer::randomize( input, N, 0.1f, 1.0f );
+    CLWrapper *inputWrapper = cl->wrap( N, input );
+    CLWrapper *outputWrapper0 = cl->wrap( N, output0 );
+    CLWrapper *outputWrapper1 = cl->wrap( N, output1 );
+    inputWrapper->copyToDevice();
+    outputWrapper0->createOnDevice();
+    outputWrapper1->createOnDevice();
+
+    // cpu and gpu make the same masks from the same seeds
+    dropoutForward0->forward( batchSize, 123u, 0x89abcdefu, inputWrapper, outputWrapper0 );
+    dropoutForward1->forward( batchSize, 123u, 0x89abcdefu, inputWrapper, outputWrapper1 );
+    outputWrapper0->copyToHost();
+    outputWrapper1->copyToHost();
+    int numKept = 0;
+    for( int i = 0; i < N; i++ ) {
+        EXPECT_EQ( output0[i], output1[i] );
+        EXPECT_TRUE( output1[i] == 0 || output1[i] == input[i] );
+        if( output1[i] != 0 ) {
+            numKept++;
+        }
+    }
+    EXPECT_LT( N / 4, numKept );
+    EXPECT_GT( N * 3 / 4, numKept );
+
+    // a different seed gives different masks
+    dropoutForward1->forward( batchSize, 124u, 0x89abcdefu, inputWrapper, outputWrapper0 );
+    outputWrapper0->copyToHost();
+    int numDifferent = 0;
+    for( int i = 0; i < N; i++ ) {
+        if( output0[i] != output1[i] ) {
+            numDifferent++;
+        }
+    }
+    EXPECT_LT( 0, numDifferent );
+
+    delete outputWrapper1;
+    delete outputWrapper0;
+    delete inputWrapper;
+    delete[] output1;
+    delete[] output0;
+    delete[] input;
+    delete dropoutForward1;
+    delete dropoutForward0;
+    delete cl;
+}
+
@@ -5,6 +5,10 @@
 // obtain one at http://mozilla.org/MPL/2.0/.
 
 #include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+#include <stdexcept>
 using namespace std;
 
 #include "util/FileHelper.h"
@@ -51,3 +55,39 @@ TEST( testfilehelper, testreadchunk ) {
     }  
 }
 
+// threads in one process writing the same file dont share a temporary file, so
+// every write goes through, and the file ends up as one of them, whole
+TEST(testfilehelper, writeBinaryAtomicThreads) {
+    string filepath = "testFileHelperAtomic.dat";
+    const int size = 100000;
+    vector<thread> threads;
+    vector<int> numFailed(4, 0);
+    for(int t = 0; t < 4; t++) {
+        threads.push_back(thread([t, size, filepath, &numFailed]() {
+            vector<char> data(size, (char)('a' + t));
+            for(int it = 0; it < 20; it++) {
+                try {
+                    FileHelper::writeBinaryAtomic(filepath, &data[0], size);
+                } catch(runtime_error &e) {
+                    numFailed[t]++;
+                }
+            }
+        }));
+    }
+    for(int t = 0; t < 4; t++) {
+        threads[t].join();
+        EXPECT_EQ(0, numFailed[t]);
+    }
+    long filesize = 0;
+    char *data = FileHelper::readBinary(filepath, &filesize);
+    ASSERT_EQ(size, filesize);
+    for(int i = 1; i < size; i++) {
+        EXPECT_EQ(data[0], data[i]);
+        if(data[0] != data[i]) {
+            break;
+        }
+    }
+    delete[] data;
+    FileHelper::remove(filepath);
+}
+
@@ -7,6 +7,7 @@
 #include "EasyCL.h"
 #include "net/NeuralNet.h"
 #include "conv/Forward.h"
+#include "conv/ForwardIm2Col.h"
 #include "activate/ActivationFunction.h"
 #include "layer/Layer.h"
 #include "layer/LayerMakers.h"
@@ -557,6 +558,92 @@ TEST( testforward, compare_0_1_biased_pad ) {
     compareSpecific( false, N, batchSize, dim, 0, 1 );
 }
 
+TEST( testforward, compare_0_8_biased_nopad ) {
+    LayerDimensions dim;
+    int batchSize = 4;
+    int N = 10;
+    dim.setInputPlanes( 8 ).setInputSize(19).setNumFilters( 7 )
+        .setFilterSize( 5 )
+        .setPadZeros( false ).setBiased( true );
+    compareSpecific( false, N, batchSize, dim, 0, 8 );
+}
+
+TEST( testforward, compare_0_8_biased_pad ) {
+    LayerDimensions dim;
+    int batchSize = 4;
+    int N = 10;
+    dim.setInputPlanes( 8 ).setInputSize(19).setNumFilters( 7 )
+        .setFilterSize( 5 )
+        .setPadZeros( true ).setBiased( true );
+    compareSpecific( false, N, batchSize, dim, 0, 8 );
+}
+
+// winograd, 3x3 and 5x5 (as four 3x3 sub filters), against the cpu
+// 19, 17 and 15 are odd, so the last row and column of 2x2 tiles are partial
+TEST( testforward, compare_0_9_winograd ) {
+    LayerDimensions dim;
+    int batchSize = 4;
+    int N = 10;
+    for( int filterSize = 3; filterSize <= 5; filterSize += 2 ) {
+        dim.setInputPlanes( 8 ).setInputSize(19).setNumFilters( 7 )
+            .setFilterSize( filterSize )
+            .setPadZeros( false ).setBiased( true );
+        compareSpecific( false, N, batchSize, dim, 0, 9 );
+        dim.setPadZeros( true ).setBiased( false );
+        compareSpecific( false, N, batchSize, dim, 0, 9 );
+    }
+}
+
+TEST( testforward, compare_0_10_winogradcpu ) {
+    LayerDimensions dim;
+    int batchSize = 4;
+    int N = 10;
+    for( int filterSize = 3; filterSize <= 5; filterSize += 2 ) {
+        dim.setInputPlanes( 8 ).setInputSize(19).setNumFilters( 7 )
+            .setFilterSize( filterSize )
+            .setPadZeros( false ).setBiased( true );
+        compareSpecific( false, N, batchSize, dim, 0, 10 );
+        dim.setPadZeros( true ).setBiased( false );
+        compareSpecific( false, N, batchSize, dim, 0, 10 );
+    }
+    // even output size
+    dim.setInputSize( 16 ).setFilterSize( 3 ).setPadZeros( true ).setBiased( true );
+    compareSpecific( false, N, batchSize, dim, 0, 10 );
+}
+
+// fft, against the cpu, for the large filters it is meant for, and an even
+// one.  19 + 2 * 4 pads to a 32 grid, 16 fits a 16 grid exactly
+TEST( testforward, compare_0_11_fft ) {
+    LayerDimensions dim;
+    int batchSize = 4;
+    int N = 10;
+    for( int filterSize = 7; filterSize <= 9; filterSize += 2 ) {
+        dim.setInputPlanes( 8 ).setInputSize(19).setNumFilters( 7 )
+            .setFilterSize( filterSize )
+            .setPadZeros( false ).setBiased( true );
+        compareSpecific( false, N, batchSize, dim, 0, 11 );
+        dim.setPadZeros( true ).setBiased( false );
+        compareSpecific( false, N, batchSize, dim, 0, 11 );
+    }
+    dim.setInputSize( 16 ).setFilterSize( 8 ).setPadZeros( false ).setBiased( true );
+    compareSpecific( false, N, batchSize, dim, 0, 11 );
+}
+
+TEST( testforward, compare_1_7_chunked ) {
+    LayerDimensions dim;
+    int batchSize = 7;
+    int N = 7;
+    dim.setInputPlanes( 4 ).setInputSize(13).setNumFilters( 6 )
+        .setFilterSize( 3 )
+        .setPadZeros( true ).setBiased( true );
+    // 3 doesnt divide 7, so last chunk is partial
+    ForwardIm2Col::setChunkSize( 3 );
+    compareSpecific( false, N, batchSize, dim, 1, 7 );
+    dim.setBiased( false ).setPadZeros( false );
+    compareSpecific( false, N, batchSize, dim, 1, 7 );
+    ForwardIm2Col::setChunkSize( 0 );
+}
+
 TEST( testforward, compare_1_n_biased_nopad ) {
     LayerDimensions dim;
     int batchSize = 4;
@@ -626,6 +713,37 @@ TEST( testforward, compare_1_4_fcscenario ) { // only need to do nopad, since fc
     compareSpecific( false, N, batchSize, dim, 1, 4 );
 }
 
+// each implementation applies a fused activation in its own epilogue, so
+// compare each with the cpu, which applies it with ActivationFunction::calc
+TEST( testforward, compare_0_n_fused_activation ) {
+    TanhActivation tanhActivation;
+    ReluActivation reluActivation;
+    LayerDimensions dim;
+    int batchSize = 4;
+    int N = 4;
+    dim.setInputPlanes( 4 ).setInputSize(13).setNumFilters( 6 )
+        .setFilterSize( 3 )
+        .setPadZeros( true ).setBiased( true ).setActivation( &tanhActivation );
+    for( int instance = 1; instance <= 10; instance++ ) {
+        if( instance == 5 ) {
+            continue; // forwardfc, cant use for inputimagesize != filtersize
+        }
+        cout << "instance: " << instance << endl;
+        compareSpecific( false, N, batchSize, dim, 0, instance );
+    }
+    // without a bias, the epilogue is just the activation
+    dim.setBiased( false ).setActivation( &reluActivation );
+    for( int instance = 1; instance <= 10; instance++ ) {
+        if( instance == 5 ) {
+            continue;
+        }
+        cout << "instance: " << instance << endl;
+        compareSpecific( false, N, batchSize, dim, 0, instance );
+    }
+    dim.setInputSize( 13 ).setFilterSize( 13 ).setPadZeros( false ).setBiased( true );
+    compareSpecific( false, N, batchSize, dim, 0, 5 );
+}
+
 /* [[[cog
     for n in [1, 4]:
         cog.outl(
@@ -5,9 +5,13 @@
 // obtain one at http://mozilla.org/MPL/2.0/.
 
 #include <iostream>
+#include <fstream>
+#include <sstream>
+#include <cstring>
 using namespace std;
 
 #include "util/JpegHelper.h"
+#include "loaders/ManifestLoaderv1.h"
 
 #include "gtest/gtest.h"
 #include "test/gtest_supp.h"
@@ -43,4 +47,52 @@ TEST( testjpeghelper, writeread ) {
     delete[] data2;
     delete[] data;
 }
+TEST( testjpeghelper, manifestloadparallel ) {
+    // each image is a single grey level, so we can see they come back in
+    // order; one file is garbage, and should come back blank, without
+    // stopping the others loading
+    int planes = 1;
+    int imageSize = 16;
+    int linearSize = planes * imageSize * imageSize;
+    int N = 12;
+    int badN = 5;
+    uchar *data = new uchar[linearSize];
+    ofstream manifest("~manifest.txt");
+    manifest << "# format=deepcl-jpeg-list-v1 planes=1 width=16 height=16 N=" << N << endl;
+    for( int n = 0; n < N; n++ ) {
+        ostringstream filename;
+        filename << "~manifest" << n << ".jpeg";
+        if( n == badN ) {
+            ofstream bad(filename.str().c_str());
+            bad << "not a jpeg";
+        } else {
+            memset(data, 10 + n * 20, linearSize);
+            JpegHelper::write(filename.str(), planes, imageSize, imageSize, data);
+        }
+        manifest << filename.str() << " " << (n % 3) << endl;
+    }
+    manifest.close();
+    delete[] data;
+
+    ManifestLoaderv1 loader("~manifest.txt");
+    EXPECT_EQ( N, loader.getN() );
+    uchar *images = new uchar[N * linearSize];
+    int *labels = new int[N];
+    loader.load(images, labels, 0, N);
+    EXPECT_EQ( 1, loader.getNumDecodeErrors() );
+    for( int n = 0; n < N; n++ ) {
+        EXPECT_EQ( n % 3, labels[n] );
+        int expected = n == badN ? 0 : 10 + n * 20;
+        for( int i = 0; i < linearSize; i++ ) {
+            int diff = images[n * linearSize + i] - expected;
+            if( diff > 4 || diff < -4 ) {
+                cout << "n=" << n << " i=" << i << " " << (int)images[n * linearSize + i] << endl;
+                EXPECT_TRUE( false );
+                break;
+            }
+        }
+    }
+    delete[] labels;
+    delete[] images;
+}
 
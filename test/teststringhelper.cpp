@@ -86,3 +86,16 @@ TEST( teststringhelper, strcpy_safe ) {
     EXPECT_EQ( 'l', dest[2] );
 }
 
+TEST( teststringhelper, toFloatLiteral ) {
+    EXPECT_EQ( "0.5f", toFloatLiteral( 0.5f ) );
+    EXPECT_EQ( "3.0f", toFloatLiteral( 3.0f ) );
+    EXPECT_EQ( "9.53674316e-07f", toFloatLiteral( 1.0f / 1024 / 1024 ) );
+    EXPECT_EQ( "1e+10f", toFloatLiteral( 1e10f ) );
+    // round trips exactly, where toString keeps only 6 digits
+    float values[] = { 0.3f, 0.123456789f, 1.0f / 3.0f, 0.99999994f };
+    for( int i = 0; i < 4; i++ ) {
+        string literal = toFloatLiteral( values[i] );
+        EXPECT_EQ( 'f', literal[literal.size() - 1] );
+        EXPECT_EQ( values[i], strtof( literal.substr( 0, literal.size() - 1 ).c_str(), 0 ) );
+    }
+}
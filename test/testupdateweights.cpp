@@ -12,6 +12,9 @@
 #include "net/NeuralNet.h"
 #include "conv/BackpropWeights.h"
 #include "conv/BackpropWeightsNaive.h"
+#include "conv/Forward.h"
+#include "conv/Backward.h"
+#include "conv/FftFilterCache.h"
 #include "layer/Layer.h"
 #include "conv/ConvolutionalLayer.h"
 #include "conv/ConvolutionalMaker.h"
@@ -824,6 +827,107 @@ void compareSpecific(bool debug, float learningRate, int its, int batchSize, Lay
     delete cl;
 }
 
+// fft gradWeights against the cpu.  The fft's error is relative to the
+// largest value in each plane, not to each weight, so compare against the
+// largest gradient
+TEST(testupdateweights, compare_0_5_fft) {
+    EasyCL *cl = DeepCLGtestGlobals_createEasyCL();
+    ClBlasInstance clblasInstance;
+    int batchSize = 5;
+    LayerDimensions dim;
+    for(int filterSize = 7; filterSize <= 9; filterSize += 2) {
+        for(int pad = 0; pad <= 1; pad++) {
+            dim.setInputPlanes(3).setInputSize(16).setNumFilters(4).setFilterSize(filterSize)
+                .setPadZeros(pad == 1).setBiased(true);
+            cout << dim << endl;
+            float *gradOutput = new float[batchSize * dim.outputCubeSize];
+            float *inputData = new float[batchSize * dim.inputCubeSize];
+            WeightRandomizer::randomize(gradOutput, batchSize * dim.outputCubeSize, -0.1f, 0.1f);
+            WeightRandomizer::randomize(inputData, batchSize * dim.inputCubeSize, -0.3f, 0.7f);
+            float *gradWeights[2];
+            float *gradBias[2];
+            int instances[] = { 0, 5 };
+            for(int i = 0; i < 2; i++) {
+                gradWeights[i] = new float[dim.filtersSize];
+                gradBias[i] = new float[dim.numFilters];
+                memset(gradWeights[i], 0, sizeof(float) * dim.filtersSize);
+                memset(gradBias[i], 0, sizeof(float) * dim.numFilters);
+                BackpropWeights *backpropWeightsImpl = BackpropWeights::instanceSpecific(instances[i], cl, dim);
+                backpropWeightsImpl->calcGradWeights(batchSize, gradOutput, inputData, gradWeights[i], gradBias[i]);
+                delete backpropWeightsImpl;
+            }
+            float maxAbs = 0;
+            for(int i = 0; i < dim.filtersSize; i++) {
+                maxAbs = max(maxAbs, abs(gradWeights[0][i]));
+            }
+            for(int i = 0; i < dim.filtersSize; i++) {
+                EXPECT_NEAR(gradWeights[0][i], gradWeights[1][i], 0.0001f * maxAbs);
+            }
+            for(int i = 0; i < dim.numFilters; i++) {
+                EXPECT_NEAR(gradBias[0][i], gradBias[1][i], 0.0001f * abs(gradBias[0][i]) + 0.00001f);
+            }
+            for(int i = 0; i < 2; i++) {
+                delete[] gradWeights[i];
+                delete[] gradBias[i];
+            }
+            delete[] inputData;
+            delete[] gradOutput;
+        }
+    }
+    delete cl;
+}
+
+// a layer's fft'd filters are shared by forward and backward, and reused
+// until the weights might have changed
+TEST(testupdateweights, fft_filter_cache) {
+    EasyCL *cl = DeepCLGtestGlobals_createEasyCL();
+    ClBlasInstance clblasInstance;
+    NeuralNet *net = new NeuralNet(cl, 2, 16);
+    net->addLayer(ConvolutionalMaker::instance()->numFilters(3)->filterSize(3)->padZeros()->biased());
+    net->addLayer(ConvolutionalMaker::instance()->numFilters(4)->filterSize(7)->biased());
+    net->addLayer(FullyConnectedMaker::instance()->numPlanes(2)->imageSize(1)->biased());
+    net->addLayer(SoftMaxMaker::instance());
+    ConvolutionalLayer *layer = dynamic_cast<ConvolutionalLayer *>(net->getLayer(2));
+    delete layer->forwardImpl;
+    layer->forwardImpl = Forward::instanceSpecific(11, cl, layer->dim);
+    layer->forwardImpl->setFilterCache(layer->filterCache);
+    delete layer->backwardImpl;
+    layer->backwardImpl = Backward::instanceSpecific(6, cl, layer->dim);
+    layer->backwardImpl->setFilterCache(layer->filterCache);
+
+    const int batchSize = 3;
+    float *input = new float[batchSize * net->getInputCubeSize()];
+    WeightRandomizer::randomize(input, batchSize * net->getInputCubeSize(), -1.0f, 1.0f);
+    int labels[] = { 0, 1, 1 };
+    net->setBatchSize(batchSize);
+    net->forward(input);
+    net->backwardFromLabels(labels);
+    EXPECT_EQ(1, layer->filterCache->getNumTransforms());
+    net->forward(input);
+    EXPECT_EQ(1, layer->filterCache->getNumTransforms());
+
+    // as a trainer would
+    layer->getWeightsWrapper();
+    net->forward(input);
+    net->backwardFromLabels(labels);
+    EXPECT_EQ(2, layer->filterCache->getNumTransforms());
+
+    float *weights = new float[layer->getWeightsSize()];
+    float *bias = new float[layer->getBiasSize()];
+    memcpy(weights, layer->weights, sizeof(float) * layer->getWeightsSize());
+    memcpy(bias, layer->bias, sizeof(float) * layer->getBiasSize());
+    layer->setWeights(weights, bias);
+    net->forward(input);
+    EXPECT_EQ(3, layer->filterCache->getNumTransforms());
+
+    delete[] bias;
+    delete[] weights;
+
+    delete[] input;
+    delete net;
+    delete cl;
+}
+
 TEST(SLOW_testupdateweights, compare_args) {
     bool debug = false;
     int instance0 = 1;